@@ -1,4 +1,5 @@
 #include "Blueprint/Bus/SGBlueprintMessageBus.h"
+#include "Async/Future.h"
 #include "Core/Interface/ISGMessagingModule.h"
 
 USGBlueprintMessageBus::USGBlueprintMessageBus()
@@ -16,27 +17,10 @@ USGBlueprintMessageBus::~USGBlueprintMessageBus()
 		return;
 	}
 
-	const TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> DefaultBusPtr = MessageBus;
-
-	MessageBus->Shutdown();
+	// the router threads are joined in the background, so world teardown doesn't wait for them
+	MessageBus->ShutdownAsync(ESGMessageBusShutdownPolicy::Discard);
 
 	MessageBus.Reset();
-
-	// wait for the bus to shut down
-	int32 SleepCount = 0;
-
-	while (DefaultBusPtr.IsValid())
-	{
-		if (SleepCount > 10)
-		{
-			check(!"Something is holding on the default message bus");
-			break;
-		}
-
-		++SleepCount;
-
-		FPlatformProcess::Sleep(0.1f);
-	}
 }
 
 TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> USGBlueprintMessageBus::GetMessageBus()
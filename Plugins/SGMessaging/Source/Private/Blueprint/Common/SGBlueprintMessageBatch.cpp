@@ -0,0 +1,103 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Blueprint/Common/SGBlueprintMessageBatch.h"
+#include "Core/Bus/SGMessageHandlerProfiler.h"
+#include "Core/Common/SGMessageHandlers.h"
+#include "Core/Message/SGMessage.h"
+#include "Engine/World.h"
+#include "Misc/ScopeLock.h"
+
+
+/* FSGBlueprintMessageBatchTickFunction interface
+ *****************************************************************************/
+
+void FSGBlueprintMessageBatchTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+                                                       const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Batch != nullptr)
+	{
+		Batch->Flush();
+	}
+}
+
+
+FString FSGBlueprintMessageBatchTickFunction::DiagnosticMessage()
+{
+	return TEXT("FSGBlueprintMessageBatchTickFunction");
+}
+
+
+/* FSGBlueprintMessageBatch structors
+ *****************************************************************************/
+
+FSGBlueprintMessageBatch::FSGBlueprintMessageBatch(UWorld* World, const FSGBlueprintMessageBatchDelegate& InDelegate, ETickingGroup TickGroup)
+	: Delegate(InDelegate)
+{
+	TickFunction.Batch = this;
+	TickFunction.TickGroup = TickGroup;
+	TickFunction.bCanEverTick = true;
+	TickFunction.bTickEvenWhenPaused = true;
+
+	if ((World != nullptr) && (World->PersistentLevel != nullptr))
+	{
+		TickFunction.RegisterTickFunction(World->PersistentLevel);
+	}
+}
+
+
+FSGBlueprintMessageBatch::~FSGBlueprintMessageBatch()
+{
+	TickFunction.UnRegisterTickFunction();
+	TickFunction.Batch = nullptr;
+}
+
+
+/* FSGBlueprintMessageBatch interface
+ *****************************************************************************/
+
+void FSGBlueprintMessageBatch::Add(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	PendingContexts.Add(Context);
+}
+
+
+void FSGBlueprintMessageBatch::Flush()
+{
+	TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Contexts;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		if (PendingContexts.Num() == 0)
+		{
+			return;
+		}
+
+		Contexts = MoveTemp(PendingContexts);
+	}
+
+	if (!Delegate.IsBound())
+	{
+		return;
+	}
+
+	TArray<FSGBlueprintMessage> Messages;
+	TArray<FSGBlueprintMessageContext> BlueprintContexts;
+
+	Messages.Reserve(Contexts.Num());
+	BlueprintContexts.Reserve(Contexts.Num());
+
+	for (const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context : Contexts)
+	{
+		// each Blueprint message holds its own reference, so Blueprints may keep them after the event
+		Messages.Add(FSGBlueprintMessage(const_cast<FSGMessage*>(SGMessageHandlers::CastMessage<FSGMessage>(*Context))));
+		BlueprintContexts.Add(FSGBlueprintMessageContext(Context));
+	}
+
+	// flushes are rare enough to name the event here, but only while profiling
+	const FName HandlerName = FSGMessageHandlerProfiler::IsEnabled() ? FName(*FString::Printf(TEXT("%s.%s"), *GetNameSafe(Delegate.GetUObject()), *Delegate.GetFunctionName().ToString())) : NAME_None;
+	FSGMessageHandlerScope HandlerScope(HandlerName, Contexts[0]->GetMessageType());
+
+	Delegate.Execute(Messages, BlueprintContexts);
+}
@@ -1,4 +1,6 @@
 #include "Blueprint/Common/SGBlueprintMessageEndpoint.h"
+#include "Core/Bus/SGMessageHandlerProfiler.h"
+#include "Engine/Engine.h"
 
 USGBlueprintMessageEndpoint::USGBlueprintMessageEndpoint()
 {
@@ -6,6 +8,9 @@ USGBlueprintMessageEndpoint::USGBlueprintMessageEndpoint()
 
 USGBlueprintMessageEndpoint::~USGBlueprintMessageEndpoint()
 {
+	Multiplexer.Reset();
+	Batches.Empty();
+
 	if (MessageEndpoint.IsValid())
 	{
 		MessageEndpoint.Reset();
@@ -17,16 +22,60 @@ void USGBlueprintMessageEndpoint::Subscribe(const int32 InTopicID, const int32 I
 {
 	if (MessageEndpoint.IsValid())
 	{
-		MessageEndpoint->Subscribe(MESSAGE_TAG_PARAM_VALUE, TSGLambdaMessageHandler<FSGMessage>::FuncType(
-			                           [this, InDelegate](ISGMessage* Message,
-			                                              const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&
-			                                              Context)
-			                           {
-				                           if (InDelegate.IsBound())
-				                           {
-					                           InDelegate.Execute(Message, Context);
-				                           }
-			                           }));
+		MessageEndpoint->Subscribe(MESSAGE_TAG_PARAM_VALUE, MakeDelegateHandler(InDelegate));
+	}
+}
+
+void USGBlueprintMessageEndpoint::SubscribeSpatial(const int32 InTopicID, const int32 InMessageID,
+                                                   const FSGBlueprintMessageDelegate& InDelegate)
+{
+	if (MessageEndpoint.IsValid())
+	{
+		MessageEndpoint->SubscribeSpatial(MESSAGE_TAG_PARAM_VALUE, MakeDelegateHandler(InDelegate));
+	}
+}
+
+void USGBlueprintMessageEndpoint::SubscribeProjected(const int32 InTopicID, const int32 InMessageID,
+                                                     const TArray<FName>& InKeys,
+                                                     const FSGBlueprintMessageDelegate& InDelegate)
+{
+	if (MessageEndpoint.IsValid())
+	{
+		const auto Projection = MakeShared<const FSGMessageProjection, ESPMode::ThreadSafe>(InKeys);
+
+		MessageEndpoint->SetProjection(MESSAGE_TAG_PARAM_VALUE, *Projection);
+		MessageEndpoint->Subscribe(MESSAGE_TAG_PARAM_VALUE,
+		                           MakeDelegateHandler(InDelegate, Projection->IsEmpty() ? nullptr : Projection.ToSharedPtr()));
+	}
+}
+
+void USGBlueprintMessageEndpoint::SubscribeBatched(const UObject* WorldContextObject, const int32 InTopicID,
+                                                   const int32 InMessageID,
+                                                   const FSGBlueprintMessageBatchDelegate& InDelegate,
+                                                   ETickingGroup TickGroup)
+{
+	UWorld* World = (GEngine != nullptr)
+		                ? GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull)
+		                : nullptr;
+
+	if (MessageEndpoint.IsValid() && World != nullptr)
+	{
+		const auto Batch = MakeShared<FSGBlueprintMessageBatch, ESPMode::ThreadSafe>(World, InDelegate, TickGroup);
+
+		Batches.Add(Batch);
+
+		TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc =
+			[WeakBatch = TWeakPtr<FSGBlueprintMessageBatch, ESPMode::ThreadSafe>(Batch)](
+			ISGMessage* Message, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+			{
+				// typed messages can't be read from Blueprints, so the handler drops them before they get here
+				if (const auto PinnedBatch = WeakBatch.Pin())
+				{
+					PinnedBatch->Add(Context);
+				}
+			};
+
+		MessageEndpoint->Subscribe(MESSAGE_TAG_PARAM_VALUE, MoveTemp(HandlerFunc));
 	}
 }
 
@@ -34,10 +83,11 @@ void USGBlueprintMessageEndpoint::Publish(const int32 InTopicID, const int32 InM
                                           const FSGBlueprintPublishParameter InParameter,
                                           const FSGBlueprintMessage InMessage)
 {
-	if (MessageEndpoint.IsValid())
+	if (MessageEndpoint.IsValid() && InMessage.Message != nullptr)
 	{
+		// the context gets its own reference, so the Blueprint may keep its copy of the message
 		MessageEndpoint->PublishWithMessage<FSGMessage>(
-			MESSAGE_TAG_PARAM_VALUE, FSGMessageParameter::FPublishParameter(MESSAGE_PARAMETER), InMessage);
+			MESSAGE_TAG_PARAM_VALUE, FSGMessageParameter::FPublishParameter(MESSAGE_PARAMETER), InMessage.Share());
 	}
 }
 
@@ -46,7 +96,7 @@ void USGBlueprintMessageEndpoint::Send(const int32 InTopicID, const int32 InMess
                                        const FSGBlueprintSendParameter InParameter,
                                        const FSGBlueprintMessage InMessage)
 {
-	if (MessageEndpoint.IsValid())
+	if (MessageEndpoint.IsValid() && InMessage.Message != nullptr)
 	{
 		TArray<FSGMessageAddress> Recipients;
 
@@ -58,7 +108,7 @@ void USGBlueprintMessageEndpoint::Send(const int32 InTopicID, const int32 InMess
 		}
 
 		MessageEndpoint->SendWithMessage<FSGMessage>(
-			MESSAGE_TAG_PARAM_VALUE, Recipients, FSGMessageParameter::FSendParameter(MESSAGE_PARAMETER), InMessage);
+			MESSAGE_TAG_PARAM_VALUE, Recipients, FSGMessageParameter::FSendParameter(MESSAGE_PARAMETER), InMessage.Share());
 	}
 }
 
@@ -90,3 +140,90 @@ FSGBlueprintMessageAddress USGBlueprintMessageEndpoint::GetAddress() const
 
 	return FSGBlueprintMessageAddress();
 }
+
+void USGBlueprintMessageEndpoint::Enable()
+{
+	if (MessageEndpoint.IsValid())
+	{
+		MessageEndpoint->Enable();
+	}
+}
+
+void USGBlueprintMessageEndpoint::Disable()
+{
+	if (MessageEndpoint.IsValid())
+	{
+		MessageEndpoint->Disable();
+	}
+}
+
+void USGBlueprintMessageEndpoint::GetHandledLatency(float& OutP50Milliseconds, float& OutP99Milliseconds) const
+{
+	OutP50Milliseconds = 0.0f;
+	OutP99Milliseconds = 0.0f;
+
+	if (MessageEndpoint.IsValid())
+	{
+		OutP50Milliseconds = (float)(MessageEndpoint->GetHandledLatency(50.0) * 1000.0);
+		OutP99Milliseconds = (float)(MessageEndpoint->GetHandledLatency(99.0) * 1000.0);
+	}
+}
+
+void USGBlueprintMessageEndpoint::Subscribe(const UObject* Subscriber, const int32 InTopicID, const int32 InMessageID,
+                                            const FSGBlueprintMessageDelegate& InDelegate)
+{
+	if (FSGMessageEndpointMultiplexer* SharedEndpoint = GetMultiplexer())
+	{
+		SharedEndpoint->Subscribe(Subscriber, MESSAGE_TAG_PARAM_VALUE, MakeDelegateHandler(InDelegate));
+	}
+}
+
+void USGBlueprintMessageEndpoint::RemoveSubscriber(const UObject* Subscriber)
+{
+	if (Multiplexer.IsValid())
+	{
+		Multiplexer->RemoveOwner(Subscriber);
+	}
+}
+
+FSGBlueprintMessageAddress USGBlueprintMessageEndpoint::GetSubscriberAddress(const UObject* Subscriber)
+{
+	if (FSGMessageEndpointMultiplexer* SharedEndpoint = GetMultiplexer())
+	{
+		return FSGBlueprintMessageAddress(SharedEndpoint->GetAddress(Subscriber));
+	}
+
+	return FSGBlueprintMessageAddress();
+}
+
+FSGMessageEndpointMultiplexer* USGBlueprintMessageEndpoint::GetMultiplexer()
+{
+	if (!Multiplexer.IsValid() && MessageEndpoint.IsValid())
+	{
+		Multiplexer = MakeShared<FSGMessageEndpointMultiplexer, ESPMode::ThreadSafe>(MessageEndpoint.ToSharedRef());
+	}
+
+	return Multiplexer.Get();
+}
+
+TSGLambdaMessageHandler<FSGMessage>::FuncType USGBlueprintMessageEndpoint::MakeDelegateHandler(
+	const FSGBlueprintMessageDelegate& InDelegate,
+	const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& InProjection)
+{
+	// the event's name is built once, so profiling doesn't format strings per message
+	const FName HandlerName(*FString::Printf(TEXT("%s.%s"), *GetNameSafe(InDelegate.GetUObject()), *InDelegate.GetFunctionName().ToString()));
+
+	return [InDelegate, InProjection, HandlerName](ISGMessage* Message, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		// typed messages can't be read from Blueprints, so the handler drops them before they get here
+		if (InDelegate.IsBound())
+		{
+			FSGBlueprintMessage BlueprintMessage(Message);
+			BlueprintMessage.Projection = InProjection;
+
+			FSGMessageHandlerScope HandlerScope(HandlerName, Context->GetMessageType());
+
+			InDelegate.Execute(BlueprintMessage, Context);
+		}
+	};
+}
@@ -1,10 +1,67 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/Bridge/SGMessageBridge.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
 #include "Core/Interface/ISGMessagingModule.h"
 #include "Core/Interface/ISGMessageBus.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessagePool.h"
 #include "Core/Interface/ISGMessageSubscription.h"
 #include "Core/Interface/ISGMessageTransport.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+namespace SGMessageBridge
+{
+	/** The type of the messages that carry the interest of a bridge. */
+	const FName InterestMessageType(TEXT("SGMessageBridge.Interest"));
+
+	/** The annotation that holds the comma separated message types of an interest message. */
+	const FName InterestAnnotation(TEXT("MessageTypes"));
+
+	/** The annotation that holds the projections of an interest message (comma separated Type=Key|Key entries, ignored by older bridges). */
+	const FName ProjectionAnnotation(TEXT("Projections"));
+
+	/** Time after which the local interest is sent again, in case an interest message was lost (in seconds). */
+	constexpr double InterestRefreshInterval = 5.0;
+}
+
+
+/**
+ * Implements the runnable of the bridge's sender thread.
+ */
+class FSGMessageBridge::FSender
+	: public FRunnable
+{
+public:
+
+	explicit FSender(FSGMessageBridge& InBridge)
+		: Bridge(InBridge)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Bridge.SendMessages();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Bridge.bStoppingSender.store(true);
+		Bridge.SenderEvent->Trigger();
+	}
+
+private:
+
+	/** Holds the bridge. */
+	FSGMessageBridge& Bridge;
+};
 
 
 /* FSGMessageBridge structors
@@ -20,7 +77,22 @@ FSGMessageBridge::FSGMessageBridge(
 	, Enabled(false)
 	, Id(FGuid::NewGuid())
 	, Transport(InTransport)
+	, NumOutboundMessages(0)
+	, FirstOutboundTime(0.0)
+	, MaxBatchSize(64)
+	, FlushInterval(0.0)
+	, bStoppingSender(false)
+	, SenderThread(nullptr)
+	, SenderEvent(FPlatformProcess::GetSynchEventFromPool())
+	, bSendInterest(false)
+	, LastInterestTime(0.0)
 {
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		MaxBatchSize = FMath::Max(SGMessagingSettings->BridgeMaxBatchSize, 1);
+		FlushInterval = FMath::Max(SGMessagingSettings->BridgeFlushIntervalMs, 0.0f) / 1000.0;
+	}
+
 	Bus->OnShutdown().AddRaw(this, &FSGMessageBridge::HandleMessageBusShutdown);
 }
 
@@ -42,6 +114,9 @@ FSGMessageBridge::~FSGMessageBridge()
 			Bus->Unregister(RemovedAddress);
 		}
 	}
+
+	FPlatformProcess::ReturnSynchEventToPool(SenderEvent);
+	SenderEvent = nullptr;
 }
 
 
@@ -61,11 +136,26 @@ void FSGMessageBridge::Disable()
 		MessageSubscription->Disable();
 	}
 
+	if (Bus.IsValid())
+	{
+		Bus->OnRemoteInterestChanged().Remove(RemoteInterestChangedHandle);
+	}
+
+	// queued messages are handed to the transport before it stops
+	StopSender();
+
 	if (Transport.IsValid())
 	{
 		Transport->StopTransport();
 	}
 
+	{
+		FWriteScopeLock Lock(NodeInterestsLock);
+
+		KnownNodes.Empty();
+		NodeInterests.Empty();
+	}
+
 	Enabled = false;
 }
 
@@ -83,6 +173,7 @@ void FSGMessageBridge::Enable()
 		return;
 	}
 
+	StartSender();
 	Bus->Register(Address, AsShared());
 
 	if (MessageSubscription.IsValid())
@@ -94,7 +185,10 @@ void FSGMessageBridge::Enable()
 		MessageSubscription = Bus->Subscribe(AsShared(), NAME_All, FSGMessageScopeRange::AtLeast(ESGMessageScope::Network));
 	}
 
+	RemoteInterestChangedHandle = Bus->OnRemoteInterestChanged().AddRaw(this, &FSGMessageBridge::HandleRemoteInterestChanged);
 	Enabled = true;
+
+	RequestInterestUpdate();
 }
 
 
@@ -140,21 +234,37 @@ void FSGMessageBridge::ReceiveMessage(const TSharedRef<ISGMessageContext, ESPMod
 		return;
 	}
 
-	// get remote nodes
-	TArray<FGuid> RemoteNodes;
-
-	if (Context->GetRecipients().Num() > 0)
+	if (SenderThread != nullptr)
 	{
-		RemoteNodes = AddressBook.GetNodesFor(Context->GetRecipients());
+		OutboundMessages.Enqueue(Context);
+
+		const int32 NumQueued = NumOutboundMessages.fetch_add(1) + 1;
 
-		if (RemoteNodes.Num() == 0)
+		// wake the sender for the first message of a batch and for a full batch, not for each message
+		if (NumQueued == 1)
 		{
-			return;
+			FirstOutboundTime.store(FSGMessageClock::Seconds());
+			SenderEvent->Trigger();
 		}
+		else if (NumQueued == MaxBatchSize)
+		{
+			SenderEvent->Trigger();
+		}
+
+		return;
+	}
+
+	// get remote nodes
+	TArray<FGuid> RemoteNodes;
+	FSGMessageProjection Projection;
+
+	if (!GetRemoteNodes(*Context, RemoteNodes, &Projection))
+	{
+		return;
 	}
 
 	// forward message to remote nodes
-	Transport->TransportMessage(Context, RemoteNodes);
+	Transport->TransportMessage(Projection.IsEmpty() ? Context : ProjectMessage(Context, Projection), RemoteNodes);
 }
 
 
@@ -178,7 +288,14 @@ void FSGMessageBridge::NotifyMessageError(const TSharedRef<ISGMessageContext, ES
 
 void FSGMessageBridge::DiscoverTransportNode(const FGuid& NodeId)
 {
-	// do nothing (address book is updated in ReceiveTransportMessage)
+	// the address book is updated in ReceiveTransportMessage
+	{
+		FWriteScopeLock Lock(NodeInterestsLock);
+
+		KnownNodes.Add(NodeId);
+	}
+
+	RequestInterestUpdate();
 }
 
 
@@ -186,6 +303,13 @@ void FSGMessageBridge::ForgetTransportNode(const FGuid& NodeId)
 {
 	TArray<FSGMessageAddress> RemovedAddresses;
 
+	{
+		FWriteScopeLock Lock(NodeInterestsLock);
+
+		KnownNodes.Remove(NodeId);
+		NodeInterests.Remove(NodeId);
+	}
+
 	// update address book
 	AddressBook.RemoveNode(NodeId, RemovedAddresses);
 
@@ -216,8 +340,16 @@ void FSGMessageBridge::ReceiveTransportMessage(const TSharedRef<ISGMessageContex
 		return;
 	}
 
+	// interest messages are meant for the bridge, not for its bus
+	if (Context->GetMessageType() == SGMessageBridge::InterestMessageType)
+	{
+		ReceiveInterest(*Context, NodeId);
+
+		return;
+	}
+
 	// discard expired messages
-	if (Context->GetExpiration() < FDateTime::UtcNow())
+	if (Context->GetExpiration() < FSGMessageClock::UtcNow())
 	{
 		UE_LOG(LogSGMessaging, Verbose, TEXT("FSGMessageBridge::ReceiveTransportMessage: Message expired. Discarding"));
 		return;
@@ -237,6 +369,358 @@ void FSGMessageBridge::ReceiveTransportMessage(const TSharedRef<ISGMessageContex
 }
 
 
+/* FSGMessageBridge implementation
+ *****************************************************************************/
+
+bool FSGMessageBridge::GetRemoteNodes(const ISGMessageContext& Context, TArray<FGuid>& OutRemoteNodes, FSGMessageProjection* OutProjection) const
+{
+	OutRemoteNodes.Reset();
+
+	if (Context.GetRecipients().Num() > 0)
+	{
+		OutRemoteNodes = AddressBook.GetNodesFor(Context.GetRecipients());
+
+		return (OutRemoteNodes.Num() > 0);
+	}
+
+	FReadScopeLock Lock(NodeInterestsLock);
+
+	if (NodeInterests.Num() == 0)
+	{
+		return true;
+	}
+
+	// typed messages are never projected, and the projection is only known for nodes that sent their interest
+	bool bProjected = (OutProjection != nullptr) && (Context.GetMessageTypeId() == INDEX_NONE);
+
+	for (const FGuid& NodeId : KnownNodes)
+	{
+		const FNodeInterest* Interest = NodeInterests.Find(NodeId);
+
+		if ((Interest == nullptr) || Interest->Matches(Context.GetMessageType()))
+		{
+			OutRemoteNodes.Add(NodeId);
+
+			if (bProjected)
+			{
+				const FSGMessageProjection* Projection = (Interest != nullptr) ? Interest->FindProjection(Context.GetMessageType()) : nullptr;
+
+				if (Projection != nullptr)
+				{
+					OutProjection->Append(*Projection);
+				}
+				else
+				{
+					bProjected = false;
+				}
+			}
+		}
+	}
+
+	if (OutRemoteNodes.Num() == 0)
+	{
+		return false;
+	}
+
+	// projected messages only go to the nodes whose projections they were made for
+	if (bProjected)
+	{
+		return true;
+	}
+
+	if (OutProjection != nullptr)
+	{
+		OutProjection->Reset();
+	}
+
+	// let the transport send to all nodes, including those it knows but didn't report yet
+	if (OutRemoteNodes.Num() == KnownNodes.Num())
+	{
+		OutRemoteNodes.Reset();
+	}
+
+	return true;
+}
+
+
+TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> FSGMessageBridge::ProjectMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageProjection& Projection) const
+{
+	const ISGMessage* Message = Context->GetTaggedMessage();
+
+	if ((Message == nullptr) || (Message->GetFName() != FSGMessage::StaticMessageName()))
+	{
+		return Context;
+	}
+
+	const FSGMessage& SourceMessage = *static_cast<const FSGMessage*>(Message);
+	FSGMessage* ProjectedMessage = FSGMessagePool::New<FSGMessage>();
+
+	// messages that only hold projected parameters are transported as they are
+	if (ProjectedMessage->CopyParams(SourceMessage, Projection) == SourceMessage.GetParams().Num())
+	{
+		ProjectedMessage->Release();
+
+		return Context;
+	}
+
+	return FSGMessageContext::Create(
+		Context->GetMessageType(), ProjectedMessage, Context->GetAnnotations(), Context->GetAttachment(), Context->GetSender(), Context->GetRecipients(),
+		Context->GetScope(), Context->GetFlags(), Context->GetTimeSent(), Context->GetExpiration(), Context->GetSenderThread());
+}
+
+
+void FSGMessageBridge::ReceiveInterest(const ISGMessageContext& Context, const FGuid& NodeId)
+{
+	const FString* MessageTypesString = Context.GetAnnotations().Find(SGMessageBridge::InterestAnnotation);
+
+	if (MessageTypesString == nullptr)
+	{
+		return;
+	}
+
+	TArray<FString> MessageTypes;
+	MessageTypesString->ParseIntoArray(MessageTypes, TEXT(","));
+
+	FNodeInterest Interest;
+
+	for (const FString& MessageTypeString : MessageTypes)
+	{
+		const FName MessageType(*MessageTypeString);
+		FSGMessageTopicRange TopicRange;
+
+		if (MessageType == NAME_All)
+		{
+			Interest.bAllMessageTypes = true;
+		}
+		else if (FSGMessageTagBuilder::TryParseTopicPattern(MessageType, TopicRange))
+		{
+			Interest.TopicRanges.Add(TopicRange);
+		}
+		else
+		{
+			Interest.MessageTypes.Add(MessageType);
+		}
+	}
+
+	if (const FString* ProjectionsString = Context.GetAnnotations().Find(SGMessageBridge::ProjectionAnnotation))
+	{
+		TArray<FString> Projections;
+		ProjectionsString->ParseIntoArray(Projections, TEXT(","));
+
+		for (const FString& ProjectionString : Projections)
+		{
+			FString MessageTypeString;
+			FString KeysString;
+
+			if (!ProjectionString.Split(TEXT("="), &MessageTypeString, &KeysString))
+			{
+				continue;
+			}
+
+			TArray<FString> Keys;
+			KeysString.ParseIntoArray(Keys, TEXT("|"));
+
+			FSGMessageProjection Projection;
+
+			for (const FString& Key : Keys)
+			{
+				Projection.Select(Key);
+			}
+
+			const FName MessageType(*MessageTypeString);
+
+			// a projection without keys would strip all parameters, so the node gets them all instead
+			if (!Projection.IsEmpty() && Interest.MessageTypes.Contains(MessageType))
+			{
+				Interest.Projections.Add(MessageType, MoveTemp(Projection));
+			}
+		}
+	}
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Node %s of %s is interested in %d message types (%d projected)"), *NodeId.ToString(), *GetDebugName().ToString(), MessageTypes.Num(), Interest.Projections.Num());
+
+	FWriteScopeLock Lock(NodeInterestsLock);
+
+	KnownNodes.Add(NodeId);
+	NodeInterests.Add(NodeId, MoveTemp(Interest));
+}
+
+
+void FSGMessageBridge::RequestInterestUpdate()
+{
+	if (SenderThread != nullptr)
+	{
+		bSendInterest.store(true);
+		SenderEvent->Trigger();
+	}
+	else if (Enabled)
+	{
+		SendInterest();
+	}
+}
+
+
+void FSGMessageBridge::SendInterest()
+{
+	TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> CurrentBus = Bus;
+
+	if (!CurrentBus.IsValid())
+	{
+		return;
+	}
+
+	TArray<FName> MessageTypes;
+	CurrentBus->GetRemoteInterest(MessageTypes);
+
+	TMap<FName, FSGMessageProjection> Projections;
+	CurrentBus->GetRemoteProjections(Projections);
+
+	TMap<FName, FString> InterestAnnotations;
+	InterestAnnotations.Add(SGMessageBridge::InterestAnnotation, FString::JoinBy(MessageTypes, TEXT(","), [](const FName& MessageType) { return MessageType.ToString(); }));
+
+	if (Projections.Num() > 0)
+	{
+		InterestAnnotations.Add(SGMessageBridge::ProjectionAnnotation, FString::JoinBy(Projections, TEXT(","), [](const TPair<FName, FSGMessageProjection>& ProjectionPair)
+		{
+			return ProjectionPair.Key.ToString() + TEXT("=") + FString::JoinBy(ProjectionPair.Value.GetKeys(), TEXT("|"), [](const FName& Key) { return Key.ToString(); });
+		}));
+	}
+
+	const FSGMessageAnnotations Annotations(InterestAnnotations);
+
+	// process scope keeps remote bridges from forwarding the message if it reaches a bus
+	TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = FSGMessageContext::Create(
+		SGMessageBridge::InterestMessageType, FSGMessagePool::New<FSGMessage>(), Annotations, nullptr, Address, TArrayView<const FSGMessageAddress>(),
+		ESGMessageScope::Process, ESGMessageFlags::None, FSGMessageClock::UtcNow(), FDateTime::MaxValue(), ENamedThreads::AnyThread);
+
+	Transport->TransportMessage(Context, TArray<FGuid>());
+}
+
+
+void FSGMessageBridge::SendMessages()
+{
+	while (!bStoppingSender.load())
+	{
+		const double Now = FSGMessageClock::Seconds();
+
+		if (bSendInterest.exchange(false) || (Now - LastInterestTime >= SGMessageBridge::InterestRefreshInterval))
+		{
+			SendInterest();
+			LastInterestTime = Now;
+		}
+
+		const int32 NumQueued = NumOutboundMessages.load();
+
+		if (NumQueued == 0)
+		{
+			SenderEvent->Wait(FTimespan::FromSeconds(LastInterestTime + SGMessageBridge::InterestRefreshInterval - Now));
+
+			continue;
+		}
+
+		const double RemainingTime = FirstOutboundTime.load() + FlushInterval - FSGMessageClock::Seconds();
+
+		if ((NumQueued < MaxBatchSize) && (RemainingTime > 0.0))
+		{
+			SenderEvent->Wait(FTimespan::FromSeconds(RemainingTime));
+
+			continue;
+		}
+
+		FlushOutboundMessages();
+	}
+
+	FlushOutboundMessages();
+}
+
+
+void FSGMessageBridge::FlushOutboundMessages()
+{
+	TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Batch;
+	TArray<FGuid> BatchNodes;
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+	Batch.Reserve(MaxBatchSize);
+
+	while (OutboundMessages.Dequeue(Context))
+	{
+		NumOutboundMessages.fetch_sub(1);
+
+		// get remote nodes
+		TArray<FGuid> RemoteNodes;
+		FSGMessageProjection Projection;
+
+		if (!GetRemoteNodes(*Context, RemoteNodes, &Projection))
+		{
+			continue;
+		}
+
+		// the copy is made here rather than on the router thread, which doesn't wait for the transport
+		if (!Projection.IsEmpty())
+		{
+			Context = ProjectMessage(Context.ToSharedRef(), Projection);
+		}
+
+		// batches hold consecutive messages for the same nodes, so each node receives its messages in order
+		if ((Batch.Num() > 0) && ((Batch.Num() >= MaxBatchSize) || (RemoteNodes != BatchNodes)))
+		{
+			Transport->TransportMessages(Batch, BatchNodes);
+			Batch.Reset();
+		}
+
+		if (Batch.Num() == 0)
+		{
+			BatchNodes = MoveTemp(RemoteNodes);
+		}
+
+		Batch.Add(Context.ToSharedRef());
+	}
+
+	if (Batch.Num() > 0)
+	{
+		Transport->TransportMessages(Batch, BatchNodes);
+	}
+}
+
+
+void FSGMessageBridge::StartSender()
+{
+	bStoppingSender.store(false);
+
+	Sender = MakeUnique<FSender>(*this);
+	SenderThread = FRunnableThread::Create(Sender.Get(), TEXT("FSGMessageBridge.Sender"), 128 * 1024, TPri_AboveNormal);
+
+	// without the thread, outbound messages are transported on the router thread
+	if (SenderThread == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't create the sender thread of %s, outbound messages are transported synchronously"), *GetDebugName().ToString());
+
+		Sender.Reset();
+	}
+}
+
+
+void FSGMessageBridge::StopSender()
+{
+	if (SenderThread != nullptr)
+	{
+		SenderThread->Kill(true);
+		delete SenderThread;
+		SenderThread = nullptr;
+	}
+
+	Sender.Reset();
+
+	// drop stragglers that were queued while the thread was stopping
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+	while (OutboundMessages.Dequeue(Context))
+	{
+		NumOutboundMessages.fetch_sub(1);
+	}
+}
+
+
 /* FSGMessageBridge callbacks
  *****************************************************************************/
 
@@ -245,3 +729,9 @@ void FSGMessageBridge::HandleMessageBusShutdown()
 	Disable();
 	Bus.Reset();
 }
+
+
+void FSGMessageBridge::HandleRemoteInterestChanged()
+{
+	RequestInterestUpdate();
+}
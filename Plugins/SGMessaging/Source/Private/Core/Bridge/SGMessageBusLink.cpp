@@ -0,0 +1,371 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bridge/SGMessageBusLink.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Interface/ISGMessageBus.h"
+#include "Core/Interface/ISGMessageReceiver.h"
+#include "Core/Interface/ISGMessageSender.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Misc/Guid.h"
+#include "Misc/ScopeRWLock.h"
+
+
+/**
+ * Implements the side of a bus link that is attached to one of its buses.
+ *
+ * The side receives the messages to forward from its bus, and is registered on its bus under the
+ * addresses of the senders on the other bus.
+ */
+class FSGMessageBusLink::FSide
+	: public TSharedFromThis<FSide, ESPMode::ThreadSafe>
+	, public ISGMessageReceiver
+	, public ISGMessageSender
+{
+public:
+
+	FSide(const FSGMessageAddress& InAddress, int32 InIndex, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus)
+		: Address(InAddress)
+		, Bus(InBus)
+		, Id(FGuid::NewGuid())
+		, Index(InIndex)
+	{ }
+
+public:
+
+	//~ ISGMessageReceiver interface
+
+	virtual FName GetDebugName() const override
+	{
+		return *FString::Printf(TEXT("FSGMessageBusLink (%s)"), Bus.IsValid() ? *Bus->GetName() : TEXT("None"));
+	}
+
+	virtual const FGuid& GetRecipientId() const override
+	{
+		return Id;
+	}
+
+	virtual ENamedThreads::Type GetRecipientThread() const override
+	{
+		return ENamedThreads::AnyThread;
+	}
+
+	virtual bool IsLocal() const override
+	{
+		// the other bus is in the same process, so the link receives messages of any scope
+		return true;
+	}
+
+	virtual void ReceiveMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
+	{
+		if (TSharedPtr<FSGMessageBusLink, ESPMode::ThreadSafe> Link = LinkPtr.Pin())
+		{
+			Link->ForwardMessage(Context, Index);
+		}
+	}
+
+public:
+
+	//~ ISGMessageSender interface
+
+	virtual FSGMessageAddress GetSenderAddress() override
+	{
+		return Address;
+	}
+
+	virtual void NotifyMessageError(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FString& Error) override
+	{
+		// deprecated
+	}
+
+public:
+
+	/** Attaches the side to its bus. */
+	void Attach(const TSharedRef<FSGMessageBusLink, ESPMode::ThreadSafe>& Link, TArrayView<const FName> MessageTypes, const FSGMessageScopeRange& ScopeRange)
+	{
+		LinkPtr = Link;
+
+		if (Bus.IsValid())
+		{
+			Bus->SubscribeMany(AsShared(), MessageTypes, ScopeRange);
+		}
+	}
+
+	/** Detaches the side from its bus, and unregisters the addresses of the other bus. */
+	void Detach(TArrayView<const FName> MessageTypes)
+	{
+		LinkPtr.Reset();
+
+		TSet<FSGMessageAddress> UnregisteredAddresses;
+		{
+			FWriteScopeLock Lock(RemoteAddressesLock);
+
+			UnregisteredAddresses = MoveTemp(RemoteAddresses);
+			RemoteAddresses.Reset();
+		}
+
+		if (!Bus.IsValid())
+		{
+			return;
+		}
+
+		Bus->UnsubscribeMany(AsShared(), MessageTypes);
+
+		for (const FSGMessageAddress& UnregisteredAddress : UnregisteredAddresses)
+		{
+			Bus->Unregister(UnregisteredAddress);
+		}
+	}
+
+	/** Forwards a message from the other bus to this side's bus. */
+	void ForwardToBus(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArrayView<const FSGMessageAddress> Recipients)
+	{
+		if (Bus.IsValid())
+		{
+			Bus->Forward(Context, Recipients, FTimespan::Zero(), AsShared());
+		}
+	}
+
+	/** Registers the address of a sender on the other bus, so that messages to it are forwarded there. */
+	void AddRemoteAddress(const FSGMessageAddress& RemoteAddress)
+	{
+		{
+			FReadScopeLock Lock(RemoteAddressesLock);
+
+			if (RemoteAddresses.Contains(RemoteAddress))
+			{
+				return;
+			}
+		}
+
+		{
+			FWriteScopeLock Lock(RemoteAddressesLock);
+
+			bool bIsAlreadyInSet = false;
+			RemoteAddresses.Add(RemoteAddress, &bIsAlreadyInSet);
+
+			if (bIsAlreadyInSet)
+			{
+				return;
+			}
+		}
+
+		if (Bus.IsValid())
+		{
+			Bus->Register(RemoteAddress, AsShared());
+		}
+	}
+
+	/** Gets the recipients of a message that live on the other bus. */
+	void GetRemoteRecipients(TArrayView<const FSGMessageAddress> Recipients, TArray<FSGMessageAddress, TInlineAllocator<1>>& OutRemoteRecipients) const
+	{
+		FReadScopeLock Lock(RemoteAddressesLock);
+
+		for (const FSGMessageAddress& Recipient : Recipients)
+		{
+			if (RemoteAddresses.Contains(Recipient))
+			{
+				OutRemoteRecipients.Add(Recipient);
+			}
+		}
+	}
+
+	/** Releases the side's bus. */
+	void ResetBus()
+	{
+		Bus.Reset();
+	}
+
+	/** Gets the side's bus. */
+	const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe>& GetBus() const
+	{
+		return Bus;
+	}
+
+private:
+
+	/** Holds the address that the link forwards messages with. */
+	FSGMessageAddress Address;
+
+	/** Holds the bus that the side is attached to. */
+	TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus;
+
+	/** Holds the side's unique identifier (for debugging purposes). */
+	const FGuid Id;
+
+	/** Holds the index of the side in its link. */
+	int32 Index;
+
+	/** Holds the link while the side is attached. */
+	TWeakPtr<FSGMessageBusLink, ESPMode::ThreadSafe> LinkPtr;
+
+	/** Holds the addresses of the other bus that are registered on this side's bus. */
+	TSet<FSGMessageAddress> RemoteAddresses;
+
+	/** Guards the remote addresses, which are added from the router threads of the other bus. */
+	mutable FRWLock RemoteAddressesLock;
+};
+
+
+/* FSGMessageBusLink structors
+ *****************************************************************************/
+
+FSGMessageBusLink::FSGMessageBusLink(
+	const FSGMessageAddress InAddress,
+	const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InFirstBus,
+	const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InSecondBus,
+	TArrayView<const FName> InMessageTypes,
+	const FSGMessageScopeRange& InScopeRange
+)
+	: Address(InAddress)
+	, MessageTypes(InMessageTypes)
+	, ScopeRange(InScopeRange)
+	, bEnabled(false)
+{
+	if (MessageTypes.Num() == 0)
+	{
+		MessageTypes.Add(NAME_All);
+	}
+
+	Sides[0] = MakeShared<FSide, ESPMode::ThreadSafe>(Address, 0, InFirstBus);
+	Sides[1] = MakeShared<FSide, ESPMode::ThreadSafe>(Address, 1, InSecondBus);
+
+	InFirstBus->OnShutdown().AddRaw(this, &FSGMessageBusLink::HandleMessageBusShutdown);
+	InSecondBus->OnShutdown().AddRaw(this, &FSGMessageBusLink::HandleMessageBusShutdown);
+}
+
+
+FSGMessageBusLink::~FSGMessageBusLink()
+{
+	Disable();
+
+	for (const TSharedPtr<FSide, ESPMode::ThreadSafe>& Side : Sides)
+	{
+		if (Side->GetBus().IsValid())
+		{
+			Side->GetBus()->OnShutdown().RemoveAll(this);
+		}
+	}
+}
+
+
+/* ISGMessageBridge interface
+ *****************************************************************************/
+
+void FSGMessageBusLink::Disable()
+{
+	if (!bEnabled.exchange(false))
+	{
+		return;
+	}
+
+	for (const TSharedPtr<FSide, ESPMode::ThreadSafe>& Side : Sides)
+	{
+		Side->Detach(MessageTypes);
+	}
+}
+
+
+void FSGMessageBusLink::Enable()
+{
+	if (bEnabled || !Sides[0]->GetBus().IsValid() || !Sides[1]->GetBus().IsValid())
+	{
+		return;
+	}
+
+	bEnabled = true;
+
+	for (const TSharedPtr<FSide, ESPMode::ThreadSafe>& Side : Sides)
+	{
+		Side->Attach(AsShared(), MessageTypes, ScopeRange);
+	}
+}
+
+
+bool FSGMessageBusLink::IsEnabled() const
+{
+	return bEnabled;
+}
+
+
+/* FSGMessageBusLink implementation
+ *****************************************************************************/
+
+void FSGMessageBusLink::ForwardMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, int32 SourceIndex)
+{
+	if (!bEnabled || WasForwardedByLink(*Context) || (Context->GetExpiration() < FSGMessageClock::UtcNow()))
+	{
+		return;
+	}
+
+	FSide& Source = *Sides[SourceIndex];
+	FSide& Target = *Sides[1 - SourceIndex];
+
+	if (!Target.GetBus().IsValid())
+	{
+		return;
+	}
+
+	TArray<FSGMessageAddress, TInlineAllocator<1>> Recipients;
+
+	// sent messages reach the side through the addresses of the other bus only
+	if (Context->GetRecipients().Num() > 0)
+	{
+		Source.GetRemoteRecipients(Context->GetRecipients(), Recipients);
+
+		if (Recipients.Num() == 0)
+		{
+			return;
+		}
+	}
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Linking %s from %s to bus %s"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString(), *Target.GetBus()->GetName());
+
+	// replies to the sender are forwarded back by the target side
+	Target.AddRemoteAddress(Context->GetSender());
+
+	// the forwarded context refers to the context that holds the message, so the payload is shared
+	Target.ForwardToBus(Context, Recipients);
+}
+
+
+bool FSGMessageBusLink::WasForwardedByLink(const ISGMessageContext& Context) const
+{
+	if (!Context.IsForwarded())
+	{
+		return false;
+	}
+
+	if (Context.GetForwarder() == Address)
+	{
+		return true;
+	}
+
+	for (TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> Hop = Context.GetForwardHistory(); Hop.IsValid(); Hop = Hop->Previous)
+	{
+		if (Hop->Forwarder == Address)
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+
+/* FSGMessageBusLink callbacks
+ *****************************************************************************/
+
+void FSGMessageBusLink::HandleMessageBusShutdown()
+{
+	Disable();
+
+	for (const TSharedPtr<FSide, ESPMode::ThreadSafe>& Side : Sides)
+	{
+		if (Side->GetBus().IsValid())
+		{
+			Side->GetBus()->OnShutdown().RemoveAll(this);
+		}
+
+		Side->ResetBus();
+	}
+}
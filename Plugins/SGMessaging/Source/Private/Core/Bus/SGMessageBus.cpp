@@ -4,14 +4,58 @@
 #include "Core/Interface/ISGMessagingModule.h"
 #include "HAL/RunnableThread.h"
 #include "Core/Bus/SGMessageRouter.h"
+#include "Core/Bus/SGMessageRouterPool.h"
+#include "Core/Bus/SGMessageClock.h"
 #include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessageDeduplication.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Bus/SGMessageSpatialIndex.h"
 #include "Core/Bus/SGMessageSubscription.h"
+#include "Core/Interface/ISGMessage.h"
+#include "Core/Message/SGMessageBatch.h"
 #include "Core/Interface/ISGMessageSender.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 #include "HAL/ThreadSingleton.h"
+#include "Misc/Paths.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "ProfilingDebugging/CsvProfiler.h"
+#include "Stats/Stats.h"
 
 
+DECLARE_DWORD_COUNTER_STAT(TEXT("Routed Messages"), STAT_SGMessageBus_RoutedMessages, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Router Commands"), STAT_SGMessageBus_Commands, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dispatch Tasks"), STAT_SGMessageBus_DispatchTasks, STATGROUP_SGMessaging);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Router Busy %"), STAT_SGMessageBus_RouterBusy, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Command Queue Depth"), STAT_SGMessageBus_CommandQueueDepth, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Delayed Messages"), STAT_SGMessageBus_DelayedMessages, STATGROUP_SGMessaging);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Endpoint Inbox Depth"), STAT_SGMessageBus_InboxDepth, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Dropped Messages"), STAT_SGMessageBus_DroppedMessages, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Expired Messages"), STAT_SGMessageBus_ExpiredMessages, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rate Limited Messages"), STAT_SGMessageBus_RateLimitedMessages, STATGROUP_SGMessaging);
 
+CSV_DEFINE_CATEGORY(SGMessaging, true);
+
+
+namespace SGMessageBus
+{
+	/** Number of low handle bits that hold the router shard index. */
+	constexpr uint64 DelayedMessageShardBits = 8;
+
+	/** Converts a configured router thread priority. */
+	EThreadPriority GetThreadPriority(ESGMessageRouterThreadPriority Priority)
+	{
+		switch (Priority)
+		{
+		case ESGMessageRouterThreadPriority::Lowest: return TPri_Lowest;
+		case ESGMessageRouterThreadPriority::BelowNormal: return TPri_BelowNormal;
+		case ESGMessageRouterThreadPriority::AboveNormal: return TPri_AboveNormal;
+		case ESGMessageRouterThreadPriority::Highest: return TPri_Highest;
+		case ESGMessageRouterThreadPriority::TimeCritical: return TPri_TimeCritical;
+		default: return TPri_Normal;
+		}
+	}
+}
 
 
 /* FSGMessageBus structors
@@ -19,29 +63,385 @@
 
 FSGMessageBus::FSGMessageBus(FString InName, const TSharedPtr<ISGAuthorizeMessageRecipients>& InRecipientAuthorizer)
 	: Name(MoveTemp(InName))
+	, bFrameMode(false)
+	, bPooled(false)
+	, bDrainOnShutdown(false)
+	, bIsShutDown(false)
+	, NextMessageId((uint64)FDateTime::UtcNow().GetTicks())
+	, FrameTimeBudget(0.0)
+	, FrameCommandBudget(0)
+	, NextFrameRouterIndex(0)
 	, RecipientAuthorizer(InRecipientAuthorizer)
+	, LastNumDroppedMessages(0)
+	, LastNumExpiredMessages(0)
+	, LastNumRateLimitedMessages(0)
+	, LastCountersCycles(FPlatformTime::Cycles64())
+	, CsvRoutedPerSecName(*FString::Printf(TEXT("%s.RoutedPerSec"), *Name))
+	, CsvCommandsPerSecName(*FString::Printf(TEXT("%s.CommandsPerSec"), *Name))
+	, CsvRouterBusyName(*FString::Printf(TEXT("%s.RouterBusyPct"), *Name))
+	, CsvCommandQueueDepthName(*FString::Printf(TEXT("%s.CommandQueueDepth"), *Name))
+	, CsvDelayedMessagesName(*FString::Printf(TEXT("%s.DelayedMessages"), *Name))
+	, CsvDispatchTasksName(*FString::Printf(TEXT("%s.DispatchTasks"), *Name))
+	, CsvInboxDepthName(*FString::Printf(TEXT("%s.InboxDepth"), *Name))
+	, CsvDroppedMessagesName(*FString::Printf(TEXT("%s.DroppedMessages"), *Name))
+	, CsvExpiredMessagesName(*FString::Printf(TEXT("%s.ExpiredMessages"), *Name))
+	, CsvRateLimitedMessagesName(*FString::Printf(TEXT("%s.RateLimitedMessages"), *Name))
 {
-	Router = new FSGMessageRouter();
-	RouterThread = FRunnableThread::Create(Router, *FString::Printf(TEXT("FSGMessageBus.%s.Router"), *Name), 128 * 1024, TPri_Normal, FPlatformAffinity::GetPoolThreadMask());
+	int32 ShardCount = 1;
+	int32 RouterThreadCore = -1;
+	EThreadPriority RouterThreadPriority = TPri_Normal;
+	uint32 RouterStackSize = 128 * 1024;
+	int32 RouterSpinWait = -1;
+	FString DurableQueueDirectory;
+
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		DurableQueueDirectory = SGMessagingSettings->DurableQueueDirectory;
+		ShardCount = FMath::Clamp(SGMessagingSettings->RouterShardCount, 1, 16);
+		RouterThreadCore = SGMessagingSettings->RouterThreadCore;
+		bFrameMode = (SGMessagingSettings->GetRouterMode(Name) == ESGMessageRouterMode::Frame);
+		bPooled = (SGMessagingSettings->GetRouterMode(Name) == ESGMessageRouterMode::Pooled);
+		FrameTimeBudget = FMath::Max(SGMessagingSettings->FrameModeTimeBudgetMs, 0.0f) / 1000.0;
+		FrameCommandBudget = FMath::Max(SGMessagingSettings->FrameModeCommandBudget, 0);
+
+		if (const FSGMessageRouterThreadSettings* ThreadSettings = SGMessagingSettings->FindRouterThreadSettings(Name))
+		{
+			RouterThreadPriority = SGMessageBus::GetThreadPriority(ThreadSettings->ThreadPriority);
+			RouterStackSize = (uint32)FMath::Max(ThreadSettings->StackSizeKb, 32) * 1024;
+			RouterSpinWait = ThreadSettings->SpinWaitMicroseconds;
+
+			if (ThreadSettings->ThreadCore >= 0)
+			{
+				RouterThreadCore = ThreadSettings->ThreadCore;
+			}
+		}
+	}
+
+	const int32 NumCores = FMath::Clamp(FPlatformMisc::NumberOfCoresIncludingHyperthreads(), 1, 64);
+
+	if (DurableQueueDirectory.IsEmpty())
+	{
+		DurableQueueDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("SGMessaging"), TEXT("Durable"));
+	}
+
+	DurableQueueDirectory = FPaths::Combine(DurableQueueDirectory, Name);
+
+	// all shards report to the same tracer, statistics and capture so the bus keeps a single trace history
+	const TSharedRef<FSGMessageTracer, ESPMode::ThreadSafe> Tracer = MakeShared<FSGMessageTracer, ESPMode::ThreadSafe>();
+	const TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> Statistics = MakeShared<FSGMessageStatistics, ESPMode::ThreadSafe>();
+	const TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> Capture = MakeShared<FSGMessageCapture, ESPMode::ThreadSafe>();
+
+	for (int32 ShardIndex = 0; ShardIndex < ShardCount; ++ShardIndex)
+	{
+		// only the primary shard notifies listeners about registrations, otherwise every registration would be reported once per shard
+		FSGMessageRouter* Router = new FSGMessageRouter(Tracer, Statistics, Capture, ShardIndex == 0);
+		const FString ThreadName = (ShardCount == 1)
+			? FString::Printf(TEXT("FSGMessageBus.%s.Router"), *Name)
+			: FString::Printf(TEXT("FSGMessageBus.%s.Router%d"), *Name, ShardIndex);
+
+		const uint64 AffinityMask = (RouterThreadCore >= 0)
+			? (1ull << ((RouterThreadCore + ShardIndex) % NumCores))
+			: FPlatformAffinity::GetPoolThreadMask();
+
+		Routers.Add(Router);
+		Router->SetDurableQueue(MakeUnique<FSGMessageDurableQueue>(DurableQueueDirectory, ShardIndex));
+
+		if (RouterSpinWait >= 0)
+		{
+			Router->SetSpinWait(RouterSpinWait);
+		}
+
+		// frame mode routers are pumped by ProcessFrame instead, pooled ones by the router pool, and
+		// threaded ones start their thread with the first command, so idle buses cost no threads
+		if (!bFrameMode && !bPooled)
+		{
+			Router->SetThreadSettings(ThreadName, RouterStackSize, RouterThreadPriority, AffinityMask);
+		}
+	}
+
+	check(Routers.Num() > 0);
+
+	if (bPooled)
+	{
+		FSGMessageRouterPool::Get().AddBus(this, Routers);
+	}
+
+	// listeners are notified by the primary shard, like they are about registrations
+	RateLimiter.SetStateChangedHandler([this](const FSGMessageBackpressureEvent& Event)
+	{
+		if (!bIsShutDown)
+		{
+			GetPrimaryRouter()->ReportBackpressure(Event);
+		}
+	});
+
+	CountersTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSGMessageBus::TickCounters));
 
-	check(Router != nullptr);
+	if (bFrameMode)
+	{
+		FrameTickerHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSGMessageBus::TickUnpumpedFrame));
+	}
 }
 
 
 FSGMessageBus::~FSGMessageBus()
 {
-	Shutdown();
+	// an asynchronous shutdown keeps the bus alive until its threads exited, so there is nothing to wait for then
+	if (!bIsShutDown)
+	{
+		Shutdown();
+	}
+
+	for (FSGMessageRouter* Router : Routers)
+	{
+		delete Router;
+	}
+
+	Routers.Empty();
+}
+
+
+/* FSGMessageBus implementation
+ *****************************************************************************/
+
+FSGDelayedMessageHandle FSGMessageBus::PublishMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FTimespan& Delay)
+{
+	if (bIsShutDown)
+	{
+		return FSGDelayedMessageHandle();
+	}
+
+	// thread and process scoped messages may skip the router thread entirely
+	if (Delay.IsZero() && (Context->GetScope() <= ESGMessageScope::Process) && GetRouter(Context->GetMessageType())->DispatchMessageDirect(Context))
+	{
+		return FSGDelayedMessageHandle();
+	}
+
+	return RouteMessage(Context, Delay);
+}
+
+
+FSGDelayedMessageHandle FSGMessageBus::RouteMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FTimespan& Delay)
+{
+	// a shut down bus doesn't accept messages anymore
+	if (bIsShutDown)
+	{
+		return FSGDelayedMessageHandle();
+	}
+
+	const int32 RouterIndex = GetRouterIndex(*Context);
+	FSGMessageRouter* Router = Routers[RouterIndex];
+
+	// without delayed messaging the router dispatches the message right away, so there is nothing to cancel
+	if ((Delay <= FTimespan::Zero()) || !Router->IsDelayedMessagingAllowed())
+	{
+		Router->RouteMessage(Context);
+
+		return FSGDelayedMessageHandle();
+	}
+
+	const uint64 DelayedMessageId = Router->AllocateDelayedMessageId();
+
+	Router->RouteMessage(Context, DelayedMessageId);
+
+	return FSGDelayedMessageHandle((DelayedMessageId << SGMessageBus::DelayedMessageShardBits) | (uint64)RouterIndex);
+}
+
+
+void FSGMessageBus::RouteBatch(
+	TArrayView<const FSGMessageBatchEntry> Messages,
+	TArrayView<const FSGMessageAddress> Recipients,
+	ESGMessageScope Scope,
+	ESGMessageFlags Flags,
+	const FSGMessageAnnotations& Annotations,
+	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	const FTimespan& Delay,
+	const FDateTime& Expiration,
+	const FSGMessageAddress& Sender
+)
+{
+	// the sender's limit applies to the batch as a whole, type limits to each message
+	if (RateLimiter.IsEnabled() && !RateLimiter.TryAcquireSender(Sender, Messages.Num()))
+	{
+		for (const FSGMessageBatchEntry& Entry : Messages)
+		{
+			DiscardRateLimitedMessage(static_cast<void*>(Entry.Message), nullptr, Entry.MessageTag);
+		}
+
+		return;
+	}
+
+	const FDateTime TimeSent = FSGMessageClock::UtcNow() + Delay;
+	const ENamedThreads::Type SenderThread = FTaskGraphInterface::Get().GetCurrentThreadIfKnown();
+
+	TArray<TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>, TInlineAllocator<4>> RouterContexts;
+	RouterContexts.SetNum(Routers.Num());
+
+	// the contexts own the messages from here on, so they are released even if the batch isn't routed
+	for (const FSGMessageBatchEntry& Entry : Messages)
+	{
+		if (RateLimiter.IsEnabled() && !RateLimiter.TryAcquireType(Entry.MessageTag, 1))
+		{
+			DiscardRateLimitedMessage(static_cast<void*>(Entry.Message), nullptr, Entry.MessageTag);
+
+			continue;
+		}
+
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = FSGMessageContext::Create(
+			Entry.MessageTag,
+			static_cast<void*>(Entry.Message),
+			WithMessageId(Annotations, Flags, Sender),
+			Attachment,
+			Sender,
+			Recipients,
+			Scope,
+			Flags,
+			TimeSent,
+			Expiration,
+			SenderThread
+		);
+
+		TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& Contexts = RouterContexts[GetRouterIndex(*Context)];
+
+		if (Contexts.Num() == 0)
+		{
+			Contexts.Reserve(Messages.Num());
+		}
+
+		Contexts.Add(Context);
+	}
+
+	if (bIsShutDown)
+	{
+		return;
+	}
+
+	// the messages of each shard keep their order, like individually routed messages do
+	for (int32 RouterIndex = 0; RouterIndex < RouterContexts.Num(); ++RouterIndex)
+	{
+		if (RouterContexts[RouterIndex].Num() > 0)
+		{
+			Routers[RouterIndex]->RouteMessages(MoveTemp(RouterContexts[RouterIndex]));
+		}
+	}
+}
+
+
+TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> FSGMessageBus::AddPendingRequest(const FName& MessageType, const FTimespan& Timeout, FSGMessageAnnotations& InOutAnnotations)
+{
+	const int32 RouterIndex = GetRouterIndex(MessageType);
+	FSGMessageRouter* Router = Routers[RouterIndex];
+
+	// the timer identifier comes from the delayed message identifiers, so it is unique in the shard's timing wheel
+	const uint64 TimerId = Router->AllocateDelayedMessageId();
+	const uint64 CorrelationId = (TimerId << SGMessageRequest::ShardBits) | (uint64)RouterIndex;
+	const uint64 TimeoutTick = (Timeout > FTimespan::Zero()) ? FSGMessageClock::Milliseconds() + (uint64)FMath::CeilToDouble(Timeout.GetTotalMilliseconds()) : 0;
+
+	TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request = MakeShared<FSGMessagePendingRequest, ESPMode::ThreadSafe>(CorrelationId, TimerId, TimeoutTick);
+
+	Router->AddPendingRequest(Request);
+	InOutAnnotations = InOutAnnotations.With(SGMessageRequest::CorrelationIdAnnotation, LexToString(CorrelationId));
+
+	return Request;
+}
+
+
+FSGMessageAnnotations FSGMessageBus::WithMessageId(const FSGMessageAnnotations& Annotations, ESGMessageFlags Flags, const FSGMessageAddress& Sender)
+{
+	if (!EnumHasAnyFlags(Flags, ESGMessageFlags::Deduplicate) || Annotations.Contains(SGMessageDeduplication::MessageIdAnnotation))
+	{
+		return Annotations;
+	}
+
+	const uint64 MessageId = NextMessageId.fetch_add(1, std::memory_order_relaxed);
+
+	return Annotations.With(SGMessageDeduplication::MessageIdAnnotation, FString::Printf(TEXT("%s-%llx"), *Sender.ToString(), MessageId));
+}
+
+
+void FSGMessageBus::DiscardRateLimitedMessage(void* Message, UScriptStruct* TypeInfo, const FName& MessageType)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping rate limited %s message"), *MessageType.ToString());
+
+	GetStatistics()->CountRateLimitedMessage(MessageType);
+	DestroyMessage(Message, TypeInfo);
+}
+
+
+void FSGMessageBus::DestroyMessage(void* Message, UScriptStruct* TypeInfo)
+{
+	// the message never got a context, so it is destroyed the way a context would destroy it
+	if (TypeInfo == nullptr)
+	{
+		static_cast<ISGMessage*>(Message)->Release();
+
+		return;
+	}
+
+	TypeInfo->DestroyStruct(Message);
+	FSGMessagePool::Free(Message);
+}
+
+
+int32 FSGMessageBus::GetRouterIndex(const ISGMessageContext& Context) const
+{
+	uint64 CorrelationId = 0;
+
+	if ((Routers.Num() > 1) && SGMessageRequest::GetInReplyTo(Context, CorrelationId))
+	{
+		const int32 RouterIndex = (int32)(CorrelationId & ((1ull << SGMessageRequest::ShardBits) - 1));
+
+		if (Routers.IsValidIndex(RouterIndex))
+		{
+			return RouterIndex;
+		}
+	}
 
-	delete Router;
+	return GetRouterIndex(Context.GetMessageType());
 }
 
 
 /* ISGMessageBus interface
  *****************************************************************************/
 
+void FSGMessageBus::CancelDelayedMessage(const FSGDelayedMessageHandle& Handle)
+{
+	if (!Handle.IsValid())
+	{
+		return;
+	}
+
+	const int32 RouterIndex = (int32)(Handle.Id & ((1ull << SGMessageBus::DelayedMessageShardBits) - 1));
+
+	if (Routers.IsValidIndex(RouterIndex))
+	{
+		Routers[RouterIndex]->CancelDelayedMessage(Handle.Id >> SGMessageBus::DelayedMessageShardBits);
+	}
+}
+
+
+void FSGMessageBus::DropRequest(const ISGMessageContext& Context)
+{
+	uint64 CorrelationId = 0;
+
+	if (!SGMessageRequest::GetCorrelationId(Context, CorrelationId))
+	{
+		return;
+	}
+
+	// the low bits of the correlation identifier hold the shard that owns the request
+	const int32 RouterIndex = (int32)(CorrelationId & ((1ull << SGMessageRequest::ShardBits) - 1));
+
+	if (Routers.IsValidIndex(RouterIndex))
+	{
+		Routers[RouterIndex]->DropPendingRequest(Context);
+	}
+}
+
+
 void FSGMessageBus::Forward(
 	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
-	const TArray<FSGMessageAddress>& Recipients,
+	TArrayView<const FSGMessageAddress> Recipients,
 	const FTimespan& Delay,
 	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Forwarder
 )
@@ -55,20 +455,43 @@ void FSGMessageBus::Forward(
 			*Context->GetSender().ToString(), *RecipientStr);
 	}
 
-	Router->RouteMessage(MakeShareable(new FSGMessageContext(
+	GetRouter(Context->GetMessageType())->RouteMessage(FSGMessageContext::Create(
 		Context,
 		Forwarder->GetSenderAddress(),
 		Recipients,
 		ESGMessageScope::Process,
-		FDateTime::UtcNow() + Delay,
+		FSGMessageClock::UtcNow() + Delay,
 		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
-	)));
+	));
+}
+
+
+void FSGMessageBus::Redeliver(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, const FTimespan& Delay)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Redelivering %s to %s in %s"), *Context->GetMessageType().ToString(), *Recipient.ToString(), *Delay.ToString());
+
+	// the router that routed the message keeps its order with the other messages of the shard
+	const uint64 DelayTicks = (uint64)FMath::CeilToDouble(FMath::Max(Delay.GetTotalMilliseconds(), 0.0));
+
+	Routers[GetRouterIndex(*Context)]->RedeliverMessage(Context, Recipient, DelayTicks);
 }
 
 
 TSharedRef<ISGMessageTracer, ESPMode::ThreadSafe> FSGMessageBus::GetTracer()
 {
-	return Router->GetTracer();
+	return GetPrimaryRouter()->GetTracer();
+}
+
+
+TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> FSGMessageBus::GetStatistics() const
+{
+	return GetPrimaryRouter()->GetStatistics();
+}
+
+
+TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> FSGMessageBus::GetCapture() const
+{
+	return GetPrimaryRouter()->GetCapture();
 }
 
 
@@ -82,7 +505,18 @@ void FSGMessageBus::Intercept(const TSharedRef<ISGMessageInterceptor, ESPMode::T
 	if (!RecipientAuthorizer.IsValid() || RecipientAuthorizer->AuthorizeInterceptor(Interceptor, MessageType))
 	{
 		UE_LOG(LogSGMessaging, Verbose, TEXT("Adding invterceptor %s"), *Interceptor->GetDebugName().ToString());
-		Router->AddInterceptor(Interceptor, MessageType);
+
+		if (MessageType == NAME_All)
+		{
+			for (FSGMessageRouter* Router : Routers)
+			{
+				Router->AddInterceptor(Interceptor, MessageType);
+			}
+		}
+		else
+		{
+			GetRouter(MessageType)->AddInterceptor(Interceptor, MessageType);
+		}
 	}			
 }
 
@@ -93,11 +527,17 @@ FOnMessageBusShutdown& FSGMessageBus::OnShutdown()
 }
 
 
-void FSGMessageBus::Publish(
+FOnMessageBusInterestChanged& FSGMessageBus::OnRemoteInterestChanged()
+{
+	return RemoteInterestChangedDelegate;
+}
+
+
+FSGDelayedMessageHandle FSGMessageBus::Publish(
 	void* Message,
 	UScriptStruct* TypeInfo,
 	ESGMessageScope Scope,
-	const TMap<FName, FString>& Annotations,
+	const FSGMessageAnnotations& Annotations,
 	const FTimespan& Delay,
 	const FDateTime& Expiration,
 	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher
@@ -105,59 +545,134 @@ void FSGMessageBus::Publish(
 {
 	UE_LOG(LogSGMessaging, Verbose, TEXT("Publishing %s from sender %s"), *TypeInfo->GetName(), *Publisher->GetSenderAddress().ToString());
 
-	Router->RouteMessage(MakeShared<FSGMessageContext, ESPMode::ThreadSafe>(
+	if (!IsWithinRateLimits(Publisher->GetSenderAddress(), TypeInfo->GetFName()))
+	{
+		DiscardRateLimitedMessage(Message, TypeInfo, TypeInfo->GetFName());
+
+		return FSGDelayedMessageHandle();
+	}
+
+	return PublishMessage(FSGMessageContext::Create(
 		Message,
 		TypeInfo,
 		Annotations,
 		nullptr,
 		Publisher->GetSenderAddress(),
-		TArray<FSGMessageAddress>(),
+		TArrayView<const FSGMessageAddress>(),
 		Scope,
 		ESGMessageFlags::None,
-		FDateTime::UtcNow() + Delay,
+		FSGMessageClock::UtcNow() + Delay,
 		Expiration,
 		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
-	));
+	), Delay);
 }
 
-void FSGMessageBus::Publish(
+FSGDelayedMessageHandle FSGMessageBus::Publish(
 	const FName& MessageTag,
 	void* Message,
 	ESGMessageScope Scope,
-	const TMap<FName, FString>& Annotations,
+	const FSGMessageAnnotations& Annotations,
 	const FTimespan& Delay,
 	const FDateTime& Expiration,
+	ESGMessageFlags Flags,
 	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher)
 {
-	Router->RouteMessage(MakeShared<FSGMessageContext, ESPMode::ThreadSafe>(
+	if (!IsWithinRateLimits(Publisher->GetSenderAddress(), MessageTag))
+	{
+		DiscardRateLimitedMessage(Message, nullptr, MessageTag);
+
+		return FSGDelayedMessageHandle();
+	}
+
+	return PublishMessage(FSGMessageContext::Create(
 		MessageTag,
 		Message,
-		Annotations,
+		WithMessageId(Annotations, Flags, Publisher->GetSenderAddress()),
 		nullptr,
 		Publisher->GetSenderAddress(),
-		TArray<FSGMessageAddress>(),
+		TArrayView<const FSGMessageAddress>(),
 		Scope,
-		ESGMessageFlags::None,
-		FDateTime::UtcNow() + Delay,
+		Flags,
+		FSGMessageClock::UtcNow() + Delay,
 		Expiration,
 		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
-	));
+	), Delay);
+}
+
+void FSGMessageBus::PublishBatch(
+	TArrayView<const FSGMessageBatchEntry> Messages,
+	ESGMessageScope Scope,
+	const FSGMessageAnnotations& Annotations,
+	const FTimespan& Delay,
+	const FDateTime& Expiration,
+	ESGMessageFlags Flags,
+	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Publishing a batch of %d messages from sender %s"), Messages.Num(), *Publisher->GetSenderAddress().ToString());
+
+	RouteBatch(Messages, TArrayView<const FSGMessageAddress>(), Scope, Flags, Annotations, nullptr, Delay, Expiration, Publisher->GetSenderAddress());
+}
+
+FSGDelayedMessageHandle FSGMessageBus::SchedulePeriodic(
+	const FName& MessageTag,
+	void* Message,
+	ESGMessageScope Scope,
+	const FSGMessageAnnotations& Annotations,
+	const FTimespan& Interval,
+	ESGMessageFlags Flags,
+	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher)
+{
+	// the context owns the message from here on, so it is released even if it isn't scheduled
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = FSGMessageContext::Create(
+		MessageTag,
+		Message,
+		Annotations,
+		nullptr,
+		Publisher->GetSenderAddress(),
+		TArrayView<const FSGMessageAddress>(),
+		Scope,
+		Flags,
+		FSGMessageClock::UtcNow(),
+		FDateTime::MaxValue(),
+		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
+	);
+
+	if (bIsShutDown || (Interval <= FTimespan::Zero()))
+	{
+		return FSGDelayedMessageHandle();
+	}
+
+	const int32 RouterIndex = GetRouterIndex(*Context);
+	FSGMessageRouter* Router = Routers[RouterIndex];
+	const uint64 DelayedMessageId = Router->AllocateDelayedMessageId();
+	const uint64 IntervalTicks = FMath::Max<uint64>((uint64)FMath::CeilToDouble(Interval.GetTotalMilliseconds()), 1);
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Scheduling %s from sender %s every %llu ms"), *MessageTag.ToString(), *Publisher->GetSenderAddress().ToString(), IntervalTicks);
+
+	Router->AddPeriodicMessage(Context, DelayedMessageId, IntervalTicks);
+
+	return FSGDelayedMessageHandle((DelayedMessageId << SGMessageBus::DelayedMessageShardBits) | (uint64)RouterIndex);
 }
 
 void FSGMessageBus::Register(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
 {
 	UE_LOG(LogSGMessaging, Verbose, TEXT("Registering %s"), *Address.ToString());
-	Router->AddRecipient(Address, Recipient);
+
+	// every shard may need to deliver directed messages to this recipient
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->AddRecipient(Address, Recipient);
+	}
 }
 
 
-void FSGMessageBus::Send(
+FSGDelayedMessageHandle FSGMessageBus::Send(
 	void* Message,
 	UScriptStruct* TypeInfo,
 	ESGMessageFlags Flags,
-	const TMap<FName, FString>& Annotations,
+	const FSGMessageAnnotations& Annotations,
 	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
-	const TArray<FSGMessageAddress>& Recipients,
+	TArrayView<const FSGMessageAddress> Recipients,
 	const FTimespan& Delay,
 	const FDateTime& Expiration,
 	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender
@@ -165,58 +680,201 @@ void FSGMessageBus::Send(
 {
 	UE_LOG(LogSGMessaging, Verbose, TEXT("Sending %s to %d recipients"), *TypeInfo->GetName(), Recipients.Num());
 
-	Router->RouteMessage(MakeShared<FSGMessageContext, ESPMode::ThreadSafe>(
+	if (!IsWithinRateLimits(Sender->GetSenderAddress(), TypeInfo->GetFName()))
+	{
+		DiscardRateLimitedMessage(Message, TypeInfo, TypeInfo->GetFName());
+
+		return FSGDelayedMessageHandle();
+	}
+
+	return RouteMessage(FSGMessageContext::Create(
 		Message,
 		TypeInfo,
-		Annotations,
+		WithMessageId(Annotations, Flags, Sender->GetSenderAddress()),
 		Attachment,
 		Sender->GetSenderAddress(),
 		Recipients,
 		ESGMessageScope::Network,
 		Flags,
-		FDateTime::UtcNow() + Delay,
+		FSGMessageClock::UtcNow() + Delay,
 		Expiration,
 		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
-	));
+	), Delay);
 }
 
-void FSGMessageBus::Send(
+FSGDelayedMessageHandle FSGMessageBus::Send(
 	const FName& MessageTag,
 	void* Message,
-	const TArray<FSGMessageAddress>& Recipients,
+	TArrayView<const FSGMessageAddress> Recipients,
 	ESGMessageFlags Flags,
-	const TMap<FName, FString>& Annotations,
+	const FSGMessageAnnotations& Annotations,
 	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
 	const FTimespan& Delay,
 	const FDateTime& Expiration,
 	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender)
 {
-	Router->RouteMessage(MakeShared<FSGMessageContext, ESPMode::ThreadSafe>(
+	if (!IsWithinRateLimits(Sender->GetSenderAddress(), MessageTag))
+	{
+		DiscardRateLimitedMessage(Message, nullptr, MessageTag);
+
+		return FSGDelayedMessageHandle();
+	}
+
+	return RouteMessage(FSGMessageContext::Create(
 		MessageTag,
 		Message,
-		Annotations,
+		WithMessageId(Annotations, Flags, Sender->GetSenderAddress()),
 		Attachment,
 		Sender->GetSenderAddress(),
 		Recipients,
 		ESGMessageScope::Network,
 		Flags,
-		FDateTime::UtcNow() + Delay,
+		FSGMessageClock::UtcNow() + Delay,
 		Expiration,
 		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
-	));
+	), Delay);
+}
+
+
+void FSGMessageBus::SendBatch(
+	TArrayView<const FSGMessageBatchEntry> Messages,
+	TArrayView<const FSGMessageAddress> Recipients,
+	ESGMessageFlags Flags,
+	const FSGMessageAnnotations& Annotations,
+	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	const FTimespan& Delay,
+	const FDateTime& Expiration,
+	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender)
+{
+	RouteBatch(Messages, Recipients, ESGMessageScope::Network, Flags, Annotations, Attachment, Delay, Expiration, Sender->GetSenderAddress());
+}
+
+
+TFuture<FSGMessageReply> FSGMessageBus::Request(
+	void* Message,
+	UScriptStruct* TypeInfo,
+	ESGMessageFlags Flags,
+	const FSGMessageAnnotations& Annotations,
+	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	const FSGMessageAddress& Recipient,
+	const FTimespan& Timeout,
+	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender
+)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Requesting %s from %s"), *TypeInfo->GetName(), *Recipient.ToString());
+
+	if (bIsShutDown)
+	{
+		DestroyMessage(Message, TypeInfo);
+
+		TPromise<FSGMessageReply> CancelledPromise;
+		CancelledPromise.SetValue(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+
+		return CancelledPromise.GetFuture();
+	}
+
+	FSGMessageAnnotations RequestAnnotations = Annotations;
+	const TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> PendingRequest = AddPendingRequest(TypeInfo->GetFName(), Timeout, RequestAnnotations);
+
+	RouteMessage(FSGMessageContext::Create(
+		Message,
+		TypeInfo,
+		RequestAnnotations,
+		Attachment,
+		Sender->GetSenderAddress(),
+		MakeArrayView(&Recipient, 1),
+		ESGMessageScope::Network,
+		Flags,
+		FSGMessageClock::UtcNow(),
+		(Timeout > FTimespan::Zero()) ? FSGMessageClock::UtcNow() + Timeout : FDateTime::MaxValue(),
+		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
+	), FTimespan::Zero());
+
+	return PendingRequest->GetFuture();
+}
+
+TFuture<FSGMessageReply> FSGMessageBus::Request(
+	const FName& MessageTag,
+	void* Message,
+	const FSGMessageAddress& Recipient,
+	ESGMessageFlags Flags,
+	const FSGMessageAnnotations& Annotations,
+	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	const FTimespan& Timeout,
+	const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender)
+{
+	if (bIsShutDown)
+	{
+		DestroyMessage(Message, nullptr);
+
+		TPromise<FSGMessageReply> CancelledPromise;
+		CancelledPromise.SetValue(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+
+		return CancelledPromise.GetFuture();
+	}
+
+	FSGMessageAnnotations RequestAnnotations = Annotations;
+	const TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> PendingRequest = AddPendingRequest(MessageTag, Timeout, RequestAnnotations);
+
+	RouteMessage(FSGMessageContext::Create(
+		MessageTag,
+		Message,
+		RequestAnnotations,
+		Attachment,
+		Sender->GetSenderAddress(),
+		MakeArrayView(&Recipient, 1),
+		ESGMessageScope::Network,
+		Flags,
+		FSGMessageClock::UtcNow(),
+		(Timeout > FTimespan::Zero()) ? FSGMessageClock::UtcNow() + Timeout : FDateTime::MaxValue(),
+		FTaskGraphInterface::Get().GetCurrentThreadIfKnown()
+	), FTimespan::Zero());
+
+	return PendingRequest->GetFuture();
 }
 
 
 void FSGMessageBus::Shutdown()
 {
-	if (RouterThread != nullptr)
+	if (BeginShutdown(ESGMessageBusShutdownPolicy::Discard))
 	{
-		ShutdownDelegate.Broadcast();
+		FinishShutdown(MoveTemp(RouterThreads));
+	}
+	else if (ShutdownTask.IsValid())
+	{
+		// an asynchronous shutdown is still joining the threads
+		ShutdownTask.Wait();
+	}
+}
 
-		RouterThread->Kill(true);
-		delete RouterThread;
-		RouterThread = nullptr;
+
+TFuture<void> FSGMessageBus::ShutdownAsync(ESGMessageBusShutdownPolicy Policy)
+{
+	if (BeginShutdown(Policy))
+	{
+		// the task holds the bus, so it may be the one that destroys it
+		ShutdownTask = UE::Tasks::Launch(TEXT("FSGMessageBus.Shutdown"), [Bus = AsShared(), Threads = MoveTemp(RouterThreads)]() mutable
+		{
+			Bus->FinishShutdown(MoveTemp(Threads));
+		});
+	}
+
+	TSharedRef<TPromise<void>, ESPMode::ThreadSafe> CompletionPromise = MakeShared<TPromise<void>, ESPMode::ThreadSafe>();
+	TFuture<void> CompletionFuture = CompletionPromise->GetFuture();
+
+	if (ShutdownTask.IsValid())
+	{
+		UE::Tasks::Launch(TEXT("FSGMessageBus.ShutdownCompletion"), [CompletionPromise]()
+		{
+			CompletionPromise->SetValue();
+		}, UE::Tasks::Prerequisites(ShutdownTask));
+	}
+	else
+	{
+		CompletionPromise->SetValue();
 	}
+
+	return CompletionFuture;
 }
 
 
@@ -225,14 +883,53 @@ TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> FSGMessageBus::Subscribe
 	const FName& MessageType,
 	const FSGMessageScopeRange& ScopeRange
 )
+{
+	return SubscribeToGroup(Subscriber, MessageType, NAME_None, ESGMessageConsumerPolicy::RoundRobin, ScopeRange);
+}
+
+
+TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> FSGMessageBus::SubscribeToGroup(
+	const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber,
+	const FName& MessageType,
+	const FName& GroupName,
+	ESGMessageConsumerPolicy Policy,
+	const FSGMessageScopeRange& ScopeRange
+)
+{
+	return SubscribeFiltered(Subscriber, MessageType, nullptr, GroupName, Policy, ScopeRange, nullptr);
+}
+
+
+TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> FSGMessageBus::SubscribeFiltered(
+	const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber,
+	const FName& MessageType,
+	const TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe>& Filter,
+	const FName& GroupName,
+	ESGMessageConsumerPolicy Policy,
+	const FSGMessageScopeRange& ScopeRange,
+	const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& Projection
+)
 {
 	if (MessageType != NAME_None)
 	{
 		if (!RecipientAuthorizer.IsValid() || RecipientAuthorizer->AuthorizeSubscription(Subscriber, MessageType))
 		{
 			UE_LOG(LogSGMessaging, Verbose, TEXT("Subscribing %s"), *Subscriber->GetDebugName().ToString());
-			TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription = MakeShareable(new FSGMessageSubscription(Subscriber, MessageType, ScopeRange));
-			Router->AddSubscription(Subscription);
+			TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription = MakeShareable(new FSGMessageSubscription(Subscriber, MessageType, ScopeRange, GroupName, Policy, Filter, Projection));
+
+			if (IsBroadcastSubscription(MessageType))
+			{
+				for (FSGMessageRouter* Router : Routers)
+				{
+					Router->AddSubscription(Subscription);
+				}
+			}
+			else
+			{
+				GetRouter(MessageType)->AddSubscription(Subscription);
+			}
+
+			AddRemoteInterest(*Subscriber, MessageType, ScopeRange, Projection);
 
 			return Subscription;
 		}
@@ -242,12 +939,115 @@ TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> FSGMessageBus::Subscribe
 }
 
 
+TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> FSGMessageBus::SubscribeMany(
+	const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber,
+	TArrayView<const FName> MessageTypes,
+	const FSGMessageScopeRange& ScopeRange
+)
+{
+	TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> Subscriptions;
+	TArray<TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>> RouterSubscriptions;
+
+	Subscriptions.Reserve(MessageTypes.Num());
+	RouterSubscriptions.SetNum(Routers.Num());
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Subscribing %s to %d message types"), *Subscriber->GetDebugName().ToString(), MessageTypes.Num());
+
+	for (const FName& MessageType : MessageTypes)
+	{
+		TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription;
+
+		if ((MessageType != NAME_None) && (!RecipientAuthorizer.IsValid() || RecipientAuthorizer->AuthorizeSubscription(Subscriber, MessageType)))
+		{
+			Subscription = MakeShareable(new FSGMessageSubscription(Subscriber, MessageType, ScopeRange));
+
+			if (IsBroadcastSubscription(MessageType))
+			{
+				for (TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& Shard : RouterSubscriptions)
+				{
+					Shard.Add(Subscription);
+				}
+			}
+			else
+			{
+				RouterSubscriptions[GetRouterIndex(MessageType)].Add(Subscription);
+			}
+
+			AddRemoteInterest(*Subscriber, MessageType, ScopeRange);
+		}
+
+		Subscriptions.Add(Subscription);
+	}
+
+	// one command per shard, however many types there are
+	for (int32 RouterIndex = 0; RouterIndex < Routers.Num(); ++RouterIndex)
+	{
+		if (RouterSubscriptions[RouterIndex].Num() > 0)
+		{
+			Routers[RouterIndex]->AddSubscriptions(MoveTemp(RouterSubscriptions[RouterIndex]));
+		}
+	}
+
+	return Subscriptions;
+}
+
+
+void FSGMessageBus::UpdateSpatialInterests(TArrayView<const FSGMessageSpatialInterest> Interests)
+{
+	TArray<TArray<FSGMessageSpatialInterest>> RouterInterests;
+	RouterInterests.SetNum(Routers.Num());
+
+	for (const FSGMessageSpatialInterest& Interest : Interests)
+	{
+		// published messages are routed by type, so topic patterns can't be indexed by the type's shard
+		if ((Interest.MessageType == NAME_None) || IsBroadcastSubscription(Interest.MessageType))
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Spatial interests in %s are not supported, subscribe to message types instead"), *Interest.MessageType.ToString());
+
+			continue;
+		}
+
+		if ((Interest.Radius >= 0.0f) && RecipientAuthorizer.IsValid())
+		{
+			auto Subscriber = Interest.Subscriber.Pin();
+
+			if (!Subscriber.IsValid() || !RecipientAuthorizer->AuthorizeSubscription(Subscriber.ToSharedRef(), Interest.MessageType))
+			{
+				continue;
+			}
+		}
+
+		RouterInterests[GetRouterIndex(Interest.MessageType)].Add(Interest);
+	}
+
+	// one command per shard, however many subscribers moved
+	for (int32 RouterIndex = 0; RouterIndex < Routers.Num(); ++RouterIndex)
+	{
+		if (RouterInterests[RouterIndex].Num() > 0)
+		{
+			Routers[RouterIndex]->UpdateSpatialInterests(MoveTemp(RouterInterests[RouterIndex]));
+		}
+	}
+}
+
+
 void FSGMessageBus::Unintercept(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
 {
 	if (MessageType != NAME_None)
 	{
 		UE_LOG(LogSGMessaging, Verbose, TEXT("Unintercepting %s"), *Interceptor->GetDebugName().ToString());
-		Router->RemoveInterceptor(Interceptor, MessageType);
+
+		if (MessageType == NAME_All)
+		{
+			for (FSGMessageRouter* Router : Routers)
+			{
+				Router->RemoveInterceptor(Interceptor, MessageType);
+			}
+		}
+		else
+		{
+			GetRouter(MessageType)->RemoveInterceptor(Interceptor, MessageType);
+		}
 	}
 }
 
@@ -258,7 +1058,66 @@ void FSGMessageBus::Unregister(const FSGMessageAddress& Address)
 	if (!RecipientAuthorizer.IsValid() || RecipientAuthorizer->AuthorizeUnregistration(Address))
 	{
 		UE_LOG(LogSGMessaging, Verbose, TEXT("Unregistered %s"), *Address.ToString());
-		Router->RemoveRecipient(Address);
+
+		for (FSGMessageRouter* Router : Routers)
+		{
+			Router->RemoveRecipient(Address);
+		}
+
+		RateLimiter.RemoveSender(Address);
+	}
+}
+
+
+FSGMessageAddress FSGMessageBus::CreateAddressGroup(const FName& GroupName)
+{
+	const FSGMessageAddress Group = FSGMessageAddress::NewAddress();
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Creating address group %s on %s"), *GroupName.ToString(), *Group.ToString());
+
+	// like recipients, groups are known to every shard
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->AddAddressGroup(Group, GroupName);
+	}
+
+	return Group;
+}
+
+
+void FSGMessageBus::AddToAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members)
+{
+	if (Members.Num() == 0)
+	{
+		return;
+	}
+
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->AddAddressGroupMembers(Group, Members);
+	}
+}
+
+
+void FSGMessageBus::RemoveFromAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members)
+{
+	if (Members.Num() == 0)
+	{
+		return;
+	}
+
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->RemoveAddressGroupMembers(Group, Members);
+	}
+}
+
+
+void FSGMessageBus::DestroyAddressGroup(const FSGMessageAddress& Group)
+{
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->RemoveAddressGroup(Group);
 	}
 }
 
@@ -270,22 +1129,475 @@ void FSGMessageBus::Unsubscribe(const TSharedRef<ISGMessageReceiver, ESPMode::Th
 		if (!RecipientAuthorizer.IsValid() || RecipientAuthorizer->AuthorizeUnsubscription(Subscriber, MessageType))
 		{
 			UE_LOG(LogSGMessaging, Verbose, TEXT("Unsubscribing %s"), *Subscriber->GetDebugName().ToString());
-			Router->RemoveSubscription(Subscriber, MessageType);
+
+			if (IsBroadcastSubscription(MessageType))
+			{
+				for (FSGMessageRouter* Router : Routers)
+				{
+					Router->RemoveSubscription(Subscriber, MessageType);
+				}
+			}
+			else
+			{
+				GetRouter(MessageType)->RemoveSubscription(Subscriber, MessageType);
+			}
+
+			RemoveRemoteInterest(*Subscriber, MessageType);
+		}
+	}
+}
+
+
+void FSGMessageBus::UnsubscribeMany(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArrayView<const FName> MessageTypes)
+{
+	TArray<TArray<FName>> RouterMessageTypes;
+
+	RouterMessageTypes.SetNum(Routers.Num());
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Unsubscribing %s from %d message types"), *Subscriber->GetDebugName().ToString(), MessageTypes.Num());
+
+	for (const FName& MessageType : MessageTypes)
+	{
+		if ((MessageType == NAME_None) || (RecipientAuthorizer.IsValid() && !RecipientAuthorizer->AuthorizeUnsubscription(Subscriber, MessageType)))
+		{
+			continue;
+		}
+
+		if (IsBroadcastSubscription(MessageType))
+		{
+			for (TArray<FName>& Shard : RouterMessageTypes)
+			{
+				Shard.Add(MessageType);
+			}
+		}
+		else
+		{
+			RouterMessageTypes[GetRouterIndex(MessageType)].Add(MessageType);
+		}
+
+		RemoveRemoteInterest(*Subscriber, MessageType);
+	}
+
+	for (int32 RouterIndex = 0; RouterIndex < Routers.Num(); ++RouterIndex)
+	{
+		if (RouterMessageTypes[RouterIndex].Num() > 0)
+		{
+			Routers[RouterIndex]->RemoveSubscriptions(Subscriber, MoveTemp(RouterMessageTypes[RouterIndex]));
 		}
 	}
 }
 
 void FSGMessageBus::AddNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener)
 {
-	Router->AddNotificationListener(Listener);
+	// every shard reports backpressure on its own command queue
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->AddNotificationListener(Listener);
+	}
 }
 
 void FSGMessageBus::RemoveNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener)
 {
-	Router->RemoveNotificationListener(Listener);
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->RemoveNotificationListener(Listener);
+	}
 }
 
 const FString& FSGMessageBus::GetName() const
 {
 	return Name;
 }
+
+void FSGMessageBus::GetRemoteInterest(TArray<FName>& OutMessageTypes) const
+{
+	FScopeLock Lock(&RemoteInterestCriticalSection);
+
+	RemoteInterest.GetKeys(OutMessageTypes);
+}
+
+void FSGMessageBus::GetRemoteProjections(TMap<FName, FSGMessageProjection>& OutProjections) const
+{
+	OutProjections.Reset();
+
+	FScopeLock Lock(&RemoteInterestCriticalSection);
+
+	if (RemoteProjectedInterest.Num() == 0)
+	{
+		return;
+	}
+
+	for (const auto& SubscriberPair : RemoteInterestSubscriptions)
+	{
+		for (const auto& SubscriptionPair : SubscriberPair.Value)
+		{
+			const int32* NumProjected = RemoteProjectedInterest.Find(SubscriptionPair.Key);
+
+			// a single subscription without projection needs all parameters of the type
+			if ((NumProjected != nullptr) && (*NumProjected == RemoteInterest.FindChecked(SubscriptionPair.Key)))
+			{
+				OutProjections.FindOrAdd(SubscriptionPair.Key).Append(*SubscriptionPair.Value);
+			}
+		}
+	}
+}
+
+void FSGMessageBus::AddRemoteInterest(const ISGMessageReceiver& Subscriber, const FName& MessageType, const FSGMessageScopeRange& ScopeRange, const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& Projection)
+{
+	// bridges subscribe to send messages, not to receive them
+	if (!Subscriber.IsLocal() || (!ScopeRange.Contains(ESGMessageScope::Network) && !ScopeRange.Contains(ESGMessageScope::All)))
+	{
+		return;
+	}
+
+	bool bChanged = false;
+	{
+		FScopeLock Lock(&RemoteInterestCriticalSection);
+		TMap<FName, TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>>& SubscribedTypes = RemoteInterestSubscriptions.FindOrAdd(Subscriber.GetRecipientId());
+
+		if (SubscribedTypes.Contains(MessageType))
+		{
+			// subscribers that subscribe again keep their first projection until they unsubscribe
+			return;
+		}
+
+		SubscribedTypes.Add(MessageType, Projection);
+		bChanged = (++RemoteInterest.FindOrAdd(MessageType) == 1);
+
+		// any subscription may change the union of a projected type, or end its projection
+		if (Projection.IsValid())
+		{
+			++RemoteProjectedInterest.FindOrAdd(MessageType);
+		}
+
+		bChanged = bChanged || RemoteProjectedInterest.Contains(MessageType);
+	}
+
+	if (bChanged)
+	{
+		RemoteInterestChangedDelegate.Broadcast();
+	}
+}
+
+void FSGMessageBus::RemoveRemoteInterest(const ISGMessageReceiver& Subscriber, const FName& MessageType)
+{
+	bool bChanged = false;
+	{
+		FScopeLock Lock(&RemoteInterestCriticalSection);
+		TMap<FName, TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>>* SubscribedTypes = RemoteInterestSubscriptions.Find(Subscriber.GetRecipientId());
+
+		if (SubscribedTypes == nullptr)
+		{
+			return;
+		}
+
+		TArray<TPair<FName, bool>> RemovedTypes;
+
+		if (MessageType == NAME_All)
+		{
+			for (const auto& SubscriptionPair : *SubscribedTypes)
+			{
+				RemovedTypes.Emplace(SubscriptionPair.Key, SubscriptionPair.Value.IsValid());
+			}
+
+			SubscribedTypes->Reset();
+		}
+		else if (const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>* RemovedProjection = SubscribedTypes->Find(MessageType))
+		{
+			RemovedTypes.Emplace(MessageType, RemovedProjection->IsValid());
+			SubscribedTypes->Remove(MessageType);
+		}
+
+		if (SubscribedTypes->Num() == 0)
+		{
+			RemoteInterestSubscriptions.Remove(Subscriber.GetRecipientId());
+		}
+
+		for (const TPair<FName, bool>& RemovedType : RemovedTypes)
+		{
+			int32& NumSubscriptions = RemoteInterest.FindChecked(RemovedType.Key);
+
+			if (--NumSubscriptions == 0)
+			{
+				RemoteInterest.Remove(RemovedType.Key);
+				bChanged = true;
+			}
+
+			if (int32* NumProjected = RemoteProjectedInterest.Find(RemovedType.Key))
+			{
+				if (RemovedType.Value && (--(*NumProjected) == 0))
+				{
+					RemoteProjectedInterest.Remove(RemovedType.Key);
+				}
+
+				bChanged = true;
+			}
+		}
+	}
+
+	if (bChanged)
+	{
+		RemoteInterestChangedDelegate.Broadcast();
+	}
+}
+
+bool FSGMessageBus::IsFrameMode() const
+{
+	return bFrameMode;
+}
+
+void FSGMessageBus::ProcessFrame()
+{
+	if (!bFrameMode || bIsShutDown)
+	{
+		return;
+	}
+
+	LastPumpedFrame = GFrameCounter;
+
+	RouteFrame();
+}
+
+void FSGMessageBus::RouteFrame()
+{
+	const uint64 BudgetEndCycles = (FrameTimeBudget > 0.0) ? FPlatformTime::Cycles64() + (uint64)(FrameTimeBudget / FPlatformTime::GetSecondsPerCycle64()) : 0;
+	int32 RemainingCommands = FrameCommandBudget;
+
+	// rotate the first shard, so that a busy shard can't use up every frame's budget
+	for (int32 Offset = 0; Offset < Routers.Num(); ++Offset)
+	{
+		FSGMessageRouter* Router = Routers[(NextFrameRouterIndex + Offset) % Routers.Num()];
+		const int32 NumProcessed = Router->ProcessFrame(BudgetEndCycles, RemainingCommands);
+
+		if (FrameCommandBudget > 0)
+		{
+			RemainingCommands -= NumProcessed;
+
+			if (RemainingCommands <= 0)
+			{
+				break;
+			}
+		}
+
+		if ((BudgetEndCycles > 0) && (FPlatformTime::Cycles64() >= BudgetEndCycles))
+		{
+			break;
+		}
+	}
+
+	NextFrameRouterIndex = (NextFrameRouterIndex + 1) % Routers.Num();
+}
+
+int32 FSGMessageBus::GetCommandQueueDepth() const
+{
+	int32 Depth = 0;
+
+	for (const FSGMessageRouter* Router : Routers)
+	{
+		Depth += Router->GetCommandQueueDepth();
+	}
+
+	return Depth;
+}
+
+int64 FSGMessageBus::GetNumDroppedMessages() const
+{
+	int64 NumDropped = 0;
+
+	for (const FSGMessageRouter* Router : Routers)
+	{
+		NumDropped += Router->GetNumDroppedMessages();
+	}
+
+	return NumDropped;
+}
+
+FSGMessageRouterCounters FSGMessageBus::GetCounters() const
+{
+	FSGMessageRouterCounters Counters;
+
+	for (const FSGMessageRouter* Router : Routers)
+	{
+		Router->AccumulateCounters(Counters);
+	}
+
+	return Counters;
+}
+
+FSGMessageMemoryReport FSGMessageBus::GetMemoryReport() const
+{
+	FSGMessageMemoryReport Report;
+
+	for (const FSGMessageRouter* Router : Routers)
+	{
+		Router->AccumulateMemoryReport(Report);
+	}
+
+	// all router shards share the tracer of the primary router
+	StaticCastSharedRef<FSGMessageTracer>(GetPrimaryRouter()->GetTracer())->AccumulateMemoryReport(Report);
+
+	return Report;
+}
+
+int32 FSGMessageBus::GetCommandQueueHighWaterMark() const
+{
+	int32 HighWaterMark = 0;
+
+	for (const FSGMessageRouter* Router : Routers)
+	{
+		HighWaterMark = FMath::Max(HighWaterMark, Router->GetCommandQueueHighWaterMark());
+	}
+
+	return HighWaterMark;
+}
+
+
+bool FSGMessageBus::BeginShutdown(ESGMessageBusShutdownPolicy Policy)
+{
+	if (bIsShutDown.exchange(true))
+	{
+		return false;
+	}
+
+	ShutdownDelegate.Broadcast();
+
+	FTSTicker::GetCoreTicker().RemoveTicker(CountersTickerHandle);
+	FTSTicker::GetCoreTicker().RemoveTicker(FrameTickerHandle);
+
+	const bool bDrain = (Policy == ESGMessageBusShutdownPolicy::Drain);
+	bDrainOnShutdown = bDrain;
+
+	// frame mode routers have no threads that could drain their queues
+	if (bFrameMode && bDrain)
+	{
+		for (FSGMessageRouter* Router : Routers)
+		{
+			Router->ProcessFrame(0, 0);
+		}
+	}
+
+	// signal all shards first so they wind down in parallel
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->StopRouting(bDrain && !bFrameMode && !bPooled);
+	}
+
+	// routers that never carried a command have no thread to join
+	for (FSGMessageRouter* Router : Routers)
+	{
+		if (FRunnableThread* RouterThread = Router->DetachThread())
+		{
+			RouterThreads.Add(RouterThread);
+		}
+	}
+
+	return true;
+}
+
+
+void FSGMessageBus::FinishShutdown(TArray<FRunnableThread*> Threads)
+{
+	for (FRunnableThread* RouterThread : Threads)
+	{
+		RouterThread->Kill(true);
+		delete RouterThread;
+	}
+
+	if (bPooled)
+	{
+		FSGMessageRouterPool::Get().RemoveBus(this);
+
+		// no pool worker touches the routers anymore, so the queues can be drained from here
+		if (bDrainOnShutdown)
+		{
+			for (FSGMessageRouter* Router : Routers)
+			{
+				Router->ProcessFrame(0, 0);
+			}
+		}
+	}
+
+	// routers without a thread never exit, and requests may have been added while the threads wound down
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->CancelPendingRequests();
+	}
+
+	// close the capture file, nothing is routed anymore
+	GetCapture()->StopCapture();
+}
+
+
+bool FSGMessageBus::TickUnpumpedFrame(float DeltaTime)
+{
+	// the core ticker may run before or after the world tick, so an owner that pumps every frame was seen in one of the two
+	if (!bIsShutDown && (LastPumpedFrame + 1 < GFrameCounter))
+	{
+		RouteFrame();
+	}
+
+	return true;
+}
+
+bool FSGMessageBus::TickCounters(float DeltaTime)
+{
+	const FSGMessageRouterCounters Counters = GetCounters();
+	const TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> Statistics = GetStatistics();
+	const int64 NumDroppedMessages = Statistics->GetTotalDroppedMessageCount();
+	const int64 NumExpiredMessages = Statistics->GetTotalExpiredMessageCount();
+	const int64 NumRateLimitedMessages = Statistics->GetTotalRateLimitedMessageCount();
+	const int64 NumInboxMessages = FSGMessageInboxStatistics::GetNumQueuedMessages();
+
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+	const uint64 ElapsedCycles = FMath::Max<uint64>(NowCycles - LastCountersCycles, 1);
+	const double ElapsedSeconds = FPlatformTime::ToSeconds64(ElapsedCycles);
+
+	const uint64 NumRouted = Counters.NumRoutedMessages - LastCounters.NumRoutedMessages;
+	const uint64 NumCommands = Counters.NumCommands - LastCounters.NumCommands;
+	const uint64 NumDispatchTasks = Counters.NumDispatchTasks - LastCounters.NumDispatchTasks;
+	const int64 NumDropped = NumDroppedMessages - LastNumDroppedMessages;
+	const int64 NumExpired = NumExpiredMessages - LastNumExpiredMessages;
+	const int64 NumRateLimited = NumRateLimitedMessages - LastNumRateLimitedMessages;
+
+	// frame mode routers run on the game thread and pooled ones on shared workers, which counts as a single router thread
+	const double BusyPercent = 100.0 * (double)(Counters.BusyCycles - LastCounters.BusyCycles) / ((double)ElapsedCycles * ((bFrameMode || bPooled) ? 1 : Routers.Num()));
+
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_RoutedMessages, NumRouted);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_Commands, NumCommands);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_DispatchTasks, NumDispatchTasks);
+	INC_FLOAT_STAT_BY(STAT_SGMessageBus_RouterBusy, BusyPercent);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_CommandQueueDepth, Counters.CommandQueueDepth);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_DelayedMessages, Counters.NumDelayedMessages);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_DroppedMessages, NumDropped);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_ExpiredMessages, NumExpired);
+	INC_DWORD_STAT_BY(STAT_SGMessageBus_RateLimitedMessages, NumRateLimited);
+
+	// inbox depths are process-wide, so every bus reports the same value
+	SET_DWORD_STAT(STAT_SGMessageBus_InboxDepth, NumInboxMessages);
+
+#if CSV_PROFILER
+	if (FCsvProfiler::Get()->IsCapturing())
+	{
+		const int32 CategoryIndex = CSV_CATEGORY_INDEX(SGMessaging);
+
+		FCsvProfiler::RecordCustomStat(CsvRoutedPerSecName, CategoryIndex, (float)(NumRouted / ElapsedSeconds), ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvCommandsPerSecName, CategoryIndex, (float)(NumCommands / ElapsedSeconds), ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvRouterBusyName, CategoryIndex, (float)BusyPercent, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvCommandQueueDepthName, CategoryIndex, Counters.CommandQueueDepth, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvDelayedMessagesName, CategoryIndex, Counters.NumDelayedMessages, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvDispatchTasksName, CategoryIndex, (int32)NumDispatchTasks, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvInboxDepthName, CategoryIndex, (int32)NumInboxMessages, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvDroppedMessagesName, CategoryIndex, (int32)NumDropped, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvExpiredMessagesName, CategoryIndex, (int32)NumExpired, ECsvCustomStatOp::Set);
+		FCsvProfiler::RecordCustomStat(CsvRateLimitedMessagesName, CategoryIndex, (int32)NumRateLimited, ECsvCustomStatOp::Set);
+	}
+#endif
+
+	LastCounters = Counters;
+	LastNumDroppedMessages = NumDroppedMessages;
+	LastNumExpiredMessages = NumExpiredMessages;
+	LastNumRateLimitedMessages = NumRateLimitedMessages;
+	LastCountersCycles = NowCycles;
+
+	return true;
+}
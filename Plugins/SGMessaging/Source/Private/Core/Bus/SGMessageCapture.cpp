@@ -0,0 +1,287 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageCapture.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/FileHelper.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageSerializer.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+/* FSGMessageCapture structors
+ *****************************************************************************/
+
+FSGMessageCapture::FSGMessageCapture()
+	: bCapturing(false)
+	, bStopping(false)
+	, NumPendingMessages(0)
+	, MaxPendingMessages(65536)
+	, NumCapturedMessages(0)
+	, NumDroppedMessages(0)
+	, StartTime(0.0)
+	, FileWriter(nullptr)
+	, WriterThread(nullptr)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool())
+{ }
+
+
+FSGMessageCapture::~FSGMessageCapture()
+{
+	StopCapture();
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+
+/* FSGMessageCapture interface
+ *****************************************************************************/
+
+bool FSGMessageCapture::StartCapture(const FString& Filename)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (WriterThread != nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't capture messages to %s, a capture is already running"), *Filename);
+
+		return false;
+	}
+
+	FileWriter = IFileManager::Get().CreateFileWriter(*Filename);
+
+	if (FileWriter == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't capture messages to %s, the file can't be created"), *Filename);
+
+		return false;
+	}
+
+	uint32 Magic = FileMagic;
+	uint8 Version = (uint8)ESGMessageCaptureVersion::Latest;
+
+	*FileWriter << Magic << Version;
+
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		MaxPendingMessages = FMath::Max(SGMessagingSettings->CaptureMaxPendingMessages, 1);
+	}
+
+	// drop stragglers that were queued while the last capture was stopping
+	FPendingMessage PendingMessage;
+
+	while (PendingMessages.Dequeue(PendingMessage))
+	{
+		NumPendingMessages.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	NumCapturedMessages.store(0, std::memory_order_relaxed);
+	NumDroppedMessages.store(0, std::memory_order_relaxed);
+	StartTime = FSGMessageClock::Seconds();
+	bStopping.store(false);
+	bCapturing.store(true);
+
+	WriterThread = FRunnableThread::Create(this, TEXT("FSGMessageCapture"), 128 * 1024, TPri_BelowNormal);
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Capturing routed messages to %s"), *Filename);
+
+	return true;
+}
+
+
+void FSGMessageCapture::StopCapture()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (WriterThread == nullptr)
+	{
+		return;
+	}
+
+	bCapturing.store(false);
+
+	WriterThread->Kill(true);
+	delete WriterThread;
+	WriterThread = nullptr;
+
+	// the writer thread is gone, so the remaining messages can be written here
+	WritePendingMessages();
+
+	FileWriter->Close();
+	delete FileWriter;
+	FileWriter = nullptr;
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Captured %lld messages (%lld dropped)"), GetNumCapturedMessages(), GetNumDroppedMessages());
+}
+
+
+bool FSGMessageCapture::LoadCapture(const FString& Filename, TArray<FSGCapturedMessage>& OutMessages)
+{
+	TArray<uint8> Bytes;
+
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't load message capture %s, the file can't be read"), *Filename);
+
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint8 Version = 0;
+
+	Reader << Magic << Version;
+
+	if (Reader.IsError() || (Magic != FileMagic) || (Version == 0) || (Version > (uint8)ESGMessageCaptureVersion::Latest))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't load message capture %s, it isn't a capture file of a known version"), *Filename);
+
+		return false;
+	}
+
+	OutMessages.Reset();
+
+	while (!Reader.AtEnd())
+	{
+		uint32 RecordSize = 0;
+
+		Reader << RecordSize;
+
+		if (Reader.IsError() || (RecordSize > (uint64)(Reader.TotalSize() - Reader.Tell())))
+		{
+			// the capture was probably cut short by a crash, keep what was written completely
+			UE_LOG(LogSGMessaging, Warning, TEXT("Message capture %s is truncated after %d messages"), *Filename, OutMessages.Num());
+
+			break;
+		}
+
+		FMemoryReaderView RecordReader(MakeArrayView(Bytes.GetData() + Reader.Tell(), (int32)RecordSize));
+
+		RecordReader << OutMessages.AddDefaulted_GetRef();
+		Reader.Seek(Reader.Tell() + RecordSize);
+
+		if (RecordReader.IsError())
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Message capture %s has a malformed message after %d messages"), *Filename, OutMessages.Num() - 1);
+
+			OutMessages.Pop(false);
+
+			break;
+		}
+	}
+
+	return true;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FSGMessageCapture::Run()
+{
+	while (!bStopping.load())
+	{
+		// the routers don't signal the writer, so it polls at a rate that keeps the queue short
+		WorkEvent->Wait(FTimespan::FromMilliseconds(10.0));
+		WritePendingMessages();
+	}
+
+	return 0;
+}
+
+
+void FSGMessageCapture::Stop()
+{
+	bStopping.store(true);
+	WorkEvent->Trigger();
+}
+
+
+/* FSGMessageCapture implementation
+ *****************************************************************************/
+
+void FSGMessageCapture::EnqueueMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	// forwarded messages re-route contexts that were captured already
+	if (Context->IsForwarded())
+	{
+		return;
+	}
+
+	if (NumPendingMessages.fetch_add(1, std::memory_order_relaxed) >= MaxPendingMessages)
+	{
+		NumPendingMessages.fetch_sub(1, std::memory_order_relaxed);
+		NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+
+		return;
+	}
+
+	PendingMessages.Enqueue({ Context, FSGMessageClock::Seconds() });
+}
+
+
+void FSGMessageCapture::MakeRecord(const ISGMessageContext& Context, double BaseTime, double TimeRouted, FSGCapturedMessage& OutRecord)
+{
+	OutRecord.TimeSent = FSGMessageClock::ToSeconds(Context.GetTimeSent()) - BaseTime;
+	OutRecord.TimeRouted = TimeRouted - BaseTime;
+	OutRecord.TimeToLive = Context.HasExpiration() ? (Context.GetExpiration() - Context.GetTimeSent()).GetTotalSeconds() : -1.0;
+	OutRecord.MessageType = Context.GetMessageType();
+	OutRecord.Sender = Context.GetSender();
+	OutRecord.Recipients = Context.GetRecipients();
+	OutRecord.Scope = Context.GetScope();
+	OutRecord.Flags = Context.GetFlags();
+	OutRecord.Annotations = Context.GetAnnotations().ToMap();
+
+	if (UScriptStruct* TypeInfo = Context.GetMessageTypeInfo().Get())
+	{
+		FMemoryWriter PayloadWriter(OutRecord.Payload);
+
+		TypeInfo->SerializeBin(PayloadWriter, const_cast<void*>(Context.GetMessage()));
+
+		OutRecord.TypeInfoPath = TypeInfo->GetPathName();
+		OutRecord.PayloadFormat = ESGCapturedPayloadFormat::Struct;
+	}
+	else
+	{
+		const ISGMessage* Message = Context.GetTaggedMessage();
+
+		if ((Message != nullptr) && (Message->GetFName() == FSGMessage::StaticMessageName()))
+		{
+			FSGMessageSerializer::Serialize(*static_cast<const FSGMessage*>(Message), OutRecord.Payload);
+
+			OutRecord.PayloadFormat = ESGCapturedPayloadFormat::Message;
+		}
+	}
+}
+
+
+void FSGMessageCapture::WritePendingMessages()
+{
+	FPendingMessage PendingMessage;
+
+	while (PendingMessages.Dequeue(PendingMessage))
+	{
+		NumPendingMessages.fetch_sub(1, std::memory_order_relaxed);
+
+		FSGCapturedMessage Record;
+		MakeRecord(*PendingMessage.Context, StartTime, PendingMessage.TimeRouted, Record);
+
+		RecordBuffer.Reset();
+
+		FMemoryWriter RecordWriter(RecordBuffer);
+		RecordWriter << Record;
+
+		uint32 RecordSize = (uint32)RecordBuffer.Num();
+
+		*FileWriter << RecordSize;
+		FileWriter->Serialize(RecordBuffer.GetData(), RecordBuffer.Num());
+
+		NumCapturedMessages.fetch_add(1, std::memory_order_relaxed);
+	}
+}
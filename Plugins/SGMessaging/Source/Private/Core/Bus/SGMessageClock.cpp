@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageClock.h"
+
+
+/* FSGMessageClock interface
+ *****************************************************************************/
+
+FDateTime FSGMessageClock::ToDateTime(uint64 InCycles)
+{
+	const FAnchor& Anchor = GetAnchor();
+	const double ElapsedSeconds = ((double)InCycles - (double)Anchor.Cycles) * FPlatformTime::GetSecondsPerCycle64();
+
+	return Anchor.UtcTime + FTimespan((int64)(ElapsedSeconds * ETimespan::TicksPerSecond));
+}
+
+
+double FSGMessageClock::ToSeconds(const FDateTime& Time)
+{
+	const FAnchor& Anchor = GetAnchor();
+
+	return ToSeconds(Anchor.Cycles) + (Time - Anchor.UtcTime).GetTotalSeconds();
+}
+
+
+/* FSGMessageClock implementation
+ *****************************************************************************/
+
+const FSGMessageClock::FAnchor& FSGMessageClock::GetAnchor()
+{
+	static const FAnchor Anchor;
+
+	return Anchor;
+}
@@ -1,6 +1,8 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Interface/ISGMessage.h"
 
 
 /* FSGMessageContext structors
@@ -10,12 +12,20 @@ FSGMessageContext::~FSGMessageContext()
 {
 	if (Message != nullptr)
 	{
+		// tagged messages have no type info, so they destroy themselves
+		if (bTaggedMessage)
+		{
+			static_cast<ISGMessage*>(Message)->Release();
+
+			return;
+		}
+
 		if (UScriptStruct* TypeInfoPtr = TypeInfo.Get())
 		{
 			TypeInfoPtr->DestroyStruct(Message);
 		}
 
-		FMemory::Free(Message);
+		FSGMessagePool::Free(Message);
 	}
 }
 
@@ -23,11 +33,11 @@ FSGMessageContext::~FSGMessageContext()
 /* ISGMessageContext interface
  *****************************************************************************/
 
-const TMap<FName, FString>& FSGMessageContext::GetAnnotations() const
+const FSGMessageAnnotations& FSGMessageContext::GetAnnotations() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetAnnotations();
+		return RootContext->GetAnnotations();
 	}
 
 	return Annotations;
@@ -36,9 +46,9 @@ const TMap<FName, FString>& FSGMessageContext::GetAnnotations() const
 
 TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe> FSGMessageContext::GetAttachment() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetAttachment();
+		return RootContext->GetAttachment();
 	}
 
 	return Attachment;
@@ -47,9 +57,9 @@ TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe> FSGMessageContext::GetAtta
 
 const FDateTime& FSGMessageContext::GetExpiration() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetExpiration();
+		return RootContext->GetExpiration();
 	}
 
 	return Expiration;
@@ -58,32 +68,73 @@ const FDateTime& FSGMessageContext::GetExpiration() const
 
 const void* FSGMessageContext::GetMessage() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetMessage();
+		return RootContext->GetMessage();
 	}
 
 	return Message;
 }
 
 
+const ISGMessage* FSGMessageContext::GetTaggedMessage() const
+{
+	if (RootContext.IsValid())
+	{
+		return RootContext->GetTaggedMessage();
+	}
+
+	return bTaggedMessage ? static_cast<const ISGMessage*>(Message) : nullptr;
+}
+
+
 const TWeakObjectPtr<UScriptStruct>& FSGMessageContext::GetMessageTypeInfo() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetMessageTypeInfo();
+		return RootContext->GetMessageTypeInfo();
 	}
 
 	return TypeInfo;
 }
 
 
+int32 FSGMessageContext::GetMessageTypeId() const
+{
+	if (RootContext.IsValid())
+	{
+		return RootContext->GetMessageTypeId();
+	}
+
+	return TypeId;
+}
+
+
 TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> FSGMessageContext::GetOriginalContext() const
 {
-	return OriginalContext;
+	if (!RootContext.IsValid() || !History.IsValid())
+	{
+		return RootContext;
+	}
+
+	LLM_SCOPE_BYTAG(SGMessaging_Contexts);
+
+	return MakeShareable(new FSGMessageContext(RootContext.ToSharedRef(), *History));
+}
+
+
+TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> FSGMessageContext::GetRootContext() const
+{
+	return RootContext;
 }
 
-const TArray<FSGMessageAddress>& FSGMessageContext::GetRecipients() const
+
+TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> FSGMessageContext::GetForwardHistory() const
+{
+	return History;
+}
+
+TArrayView<const FSGMessageAddress> FSGMessageContext::GetRecipients() const
 {
 	return Recipients;
 }
@@ -96,9 +147,9 @@ ESGMessageScope FSGMessageContext::GetScope() const
 
 ESGMessageFlags FSGMessageContext::GetFlags() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetFlags();
+		return RootContext->GetFlags();
 	}
 
 	return Flags;
@@ -106,9 +157,9 @@ ESGMessageFlags FSGMessageContext::GetFlags() const
 
 const FSGMessageAddress& FSGMessageContext::GetSender() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetSender();
+		return RootContext->GetSender();
 	}
 
 	return Sender;
@@ -140,10 +191,85 @@ const FDateTime& FSGMessageContext::GetTimeSent() const
 
 FName FSGMessageContext::GetMessageType() const
 {
-	if (OriginalContext.IsValid())
+	if (RootContext.IsValid())
 	{
-		return OriginalContext->GetMessageType();
+		return RootContext->GetMessageType();
 	}
 
 	return MessageTag;
 }
+
+
+bool FSGMessageContext::IsForwarded() const
+{
+	return RootContext.IsValid();
+}
+
+
+bool FSGMessageContext::IsTraced() const
+{
+	return bTraced;
+}
+
+
+void FSGMessageContext::SetTraced(bool bInTraced)
+{
+	bTraced = bInTraced;
+}
+
+
+uint64 FSGMessageContext::GetTraceId() const
+{
+	return TraceId;
+}
+
+
+void FSGMessageContext::SetTraceId(uint64 InTraceId)
+{
+	TraceId = InTraceId;
+}
+
+
+bool FSGMessageContext::GetTopicID(int32& OutTopicID) const
+{
+	if (!bHasTopicID)
+	{
+		return ISGMessageContext::GetTopicID(OutTopicID);
+	}
+
+	OutTopicID = TopicID.Get(0);
+
+	return TopicID.IsSet();
+}
+
+
+bool FSGMessageContext::HasTopicID() const
+{
+	return bHasTopicID;
+}
+
+
+void FSGMessageContext::SetTopicID(const TOptional<int32>& InTopicID)
+{
+	TopicID = InTopicID;
+	bHasTopicID = true;
+}
+
+
+/* FSGMessageContext implementation
+ *****************************************************************************/
+
+TSharedRef<const FSGMessageForwardHop, ESPMode::ThreadSafe> FSGMessageContext::MakeForwardHop(const ISGMessageContext& Context)
+{
+	const TSharedRef<FSGMessageForwardHop, ESPMode::ThreadSafe> Hop = MakeShared<FSGMessageForwardHop, ESPMode::ThreadSafe>();
+	{
+		Hop->Forwarder = Context.GetForwarder();
+		Hop->Recipients.Append(Context.GetRecipients().GetData(), Context.GetRecipients().Num());
+		Hop->Scope = Context.GetScope();
+		Hop->ForwarderThread = Context.GetSenderThread();
+		Hop->TimeForwarded = Context.GetTimeForwarded();
+		Hop->Previous = Context.GetForwardHistory();
+	}
+
+	return Hop;
+}
@@ -0,0 +1,77 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageDeduplication.h"
+
+
+/* FSGMessageDeduplicationWindow structors
+ *****************************************************************************/
+
+FSGMessageDeduplicationWindow::FSGMessageDeduplicationWindow()
+	: Head(0)
+	, Count(0)
+	, WindowTicks(10000)
+	, MaxEntries(65536)
+{
+	if (const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		WindowTicks = (uint64)FMath::Max(SGMessagingSettings->DeduplicationWindowMs, 1);
+		MaxEntries = FMath::Max(SGMessagingSettings->DeduplicationMaxEntries, 16);
+	}
+}
+
+
+/* FSGMessageDeduplicationWindow interface
+ *****************************************************************************/
+
+bool FSGMessageDeduplicationWindow::Add(uint64 Key, uint64 NowTick)
+{
+	Trim(NowTick);
+
+	bool bIsAlreadyInSet = false;
+	Keys.Add(Key, &bIsAlreadyInSet);
+
+	if (bIsAlreadyInSet)
+	{
+		return false;
+	}
+
+	// the ring grows with the traffic up to its limit, so idle buses don't pay for it
+	if (Count == Entries.Num())
+	{
+		TArray<FEntry> Grown;
+		Grown.SetNumUninitialized(FMath::Min(FMath::Max(Entries.Num() * 2, 64), MaxEntries));
+
+		for (int32 Index = 0; Index < Count; ++Index)
+		{
+			Grown[Index] = Entries[(Head + Index) % Entries.Num()];
+		}
+
+		Entries = MoveTemp(Grown);
+		Head = 0;
+	}
+
+	FEntry& Entry = Entries[(Head + Count) % Entries.Num()];
+	{
+		Entry.Key = Key;
+		Entry.ExpirationTick = NowTick + WindowTicks;
+	}
+
+	++Count;
+
+	return true;
+}
+
+
+/* FSGMessageDeduplicationWindow implementation
+ *****************************************************************************/
+
+void FSGMessageDeduplicationWindow::Trim(uint64 NowTick)
+{
+	// keys were added in tick order, so they expire from the head
+	while ((Count > 0) && ((Entries[Head].ExpirationTick <= NowTick) || (Count >= MaxEntries)))
+	{
+		Keys.Remove(Entries[Head].Key);
+		Head = (Head + 1) % Entries.Num();
+		--Count;
+	}
+}
@@ -0,0 +1,34 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageDeliveryScope.h"
+
+
+namespace SGMessageDeliveryScope
+{
+	/** Holds the number of delivery scopes on the current thread. */
+	thread_local int32 Depth = 0;
+}
+
+
+/* FSGMessageDeliveryScope structors
+ *****************************************************************************/
+
+FSGMessageDeliveryScope::FSGMessageDeliveryScope()
+{
+	++SGMessageDeliveryScope::Depth;
+}
+
+
+FSGMessageDeliveryScope::~FSGMessageDeliveryScope()
+{
+	--SGMessageDeliveryScope::Depth;
+}
+
+
+/* FSGMessageDeliveryScope interface
+ *****************************************************************************/
+
+bool FSGMessageDeliveryScope::IsActive()
+{
+	return SGMessageDeliveryScope::Depth > 0;
+}
@@ -1,73 +1,129 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/Bus/SGMessageDispatchTask.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageDeliveryScope.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 
 
-/* FSGMessageDispatchTask structors
- *****************************************************************************/
+namespace SGMessageDispatchTask
+{
+	void DeliverMessage(
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient,
+		const TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe>& TracerPtr,
+		const TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe>& StatisticsPtr)
+	{
+		FSGMessageDeliveryScope DeliveryScope;
 
-FSGMessageDispatchTask::FSGMessageDispatchTask(
-	ENamedThreads::Type InThread,
-	TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> InContext,
-	TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> InRecipient,
-	TSharedPtr<FSGMessageTracer, ESPMode::ThreadSafe> InTracer
-)
-	: Context(InContext)
-	, RecipientPtr(InRecipient)
-	, Thread(InThread)
-	, TracerPtr(InTracer)
-{ }
+		// the message may have expired while the task was queued
+		if (Context->IsExpired(FSGMessageClock::UtcNow()))
+		{
+			if (auto Statistics = StatisticsPtr.Pin())
+			{
+				Statistics->CountExpiredMessage(Context->GetMessageType());
+			}
 
+			return;
+		}
 
-/* FSGMessageDispatchTask interface
- *****************************************************************************/
+		auto Tracer = TracerPtr.Pin();
 
-void FSGMessageDispatchTask::DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
-{
-	TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Recipient = RecipientPtr.Pin();
+		if (Tracer.IsValid())
+		{
+			Tracer->TraceDispatchedMessage(Context, Recipient, true);
+		}
 
-	if (!Recipient.IsValid())
-	{
-		return;
-	}
+		Recipient->ReceiveMessage(Context);
 
-	auto Tracer = TracerPtr.Pin();
+		if (Tracer.IsValid())
+		{
+			Tracer->TraceHandledMessage(Context, Recipient);
+		}
+	}
 
-	if (Tracer.IsValid())
+	void DeliverMessages(
+		const TArray<FSGMessageDelivery>& Deliveries,
+		const TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe>& TracerPtr,
+		const TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe>& StatisticsPtr)
 	{
-		Tracer->TraceDispatchedMessage(Context, Recipient.ToSharedRef(), true);
+		FSGMessageDeliveryScope DeliveryScope;
+		TArray<TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>, TInlineAllocator<16>> Recipients;
+
+		for (const FSGMessageDelivery& Delivery : Deliveries)
+		{
+			const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Recipient = Delivery.RecipientPtr.Pin();
+
+			if (!Recipient.IsValid())
+			{
+				continue;
+			}
+
+			// conflated deliveries pick up the latest message when they run
+			const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context = Delivery.ConflationSlot.IsValid() ? Delivery.ConflationSlot->Take() : Delivery.Context;
+
+			if (Context.IsValid())
+			{
+				DeliverMessage(Context.ToSharedRef(), Recipient.ToSharedRef(), TracerPtr, StatisticsPtr);
+			}
+
+			// consecutive deliveries usually go to the same recipient
+			if ((Recipients.Num() == 0) || (&Recipients.Last().Get() != Recipient.Get()))
+			{
+				Recipients.AddUnique(Recipient.ToSharedRef());
+			}
+		}
+
+		// let recipients handle what they collected from this batch
+		for (const auto& Recipient : Recipients)
+		{
+			Recipient->FlushReceivedMessages();
+		}
 	}
 
-	Recipient->ReceiveMessage(Context);
-
-	if (TracerPtr.IsValid())
+	UE::Tasks::ETaskPriority GetTaskPriority(ESGMessagePriority Priority)
 	{
-		Tracer->TraceHandledMessage(Context, Recipient.ToSharedRef());
+		switch (Priority)
+		{
+		case ESGMessagePriority::High:
+			return UE::Tasks::ETaskPriority::High;
+
+		case ESGMessagePriority::Low:
+			return UE::Tasks::ETaskPriority::BackgroundNormal;
+
+		default:
+			return UE::Tasks::ETaskPriority::Normal;
+		}
 	}
-}
 
-TStatId FSGMessageDispatchTask::GetStatId() const
-{
-	RETURN_QUICK_DECLARE_CYCLE_STAT(FSGMessageDispatchTask, STATGROUP_TaskGraphTasks);
-}
+	UE::Tasks::EExtendedTaskPriority GetNamedThreadTaskPriority(ENamedThreads::Type Thread, ESGMessagePriority Priority)
+	{
+		using namespace UE::Tasks;
 
-/* FSGBusNotificationDispatchTask interface
- *****************************************************************************/
+		// local queues are only processed explicitly, which tasks don't support
+		if (ENamedThreads::GetQueueIndex(Thread) != ENamedThreads::MainQueue)
+		{
+			return EExtendedTaskPriority::None;
+		}
 
-void FSGBusNotificationDispatchTask::DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
-{
-	TSharedPtr<ISGBusListener, ESPMode::ThreadSafe> Listener = ListenerPtr.Pin();
+		const bool bHighPriority = (Priority == ESGMessagePriority::High);
+		const ENamedThreads::Type ThreadIndex = ENamedThreads::GetThreadIndex(Thread);
 
-	if (!Listener.IsValid())
-	{
-		return;
-	}
+		if (ThreadIndex == ENamedThreads::GameThread)
+		{
+			return bHighPriority ? EExtendedTaskPriority::GameThreadHiPri : EExtendedTaskPriority::GameThreadNormalPri;
+		}
 
-	Listener->NotifyRegistration(Address, Notification);
-}
+		if (ThreadIndex == ENamedThreads::GetThreadIndex(ENamedThreads::GetRenderThread()))
+		{
+			return bHighPriority ? EExtendedTaskPriority::RenderThreadHiPri : EExtendedTaskPriority::RenderThreadNormalPri;
+		}
 
-TStatId FSGBusNotificationDispatchTask::GetStatId() const
-{
-	RETURN_QUICK_DECLARE_CYCLE_STAT(FSGBusNotificationDispatchTask, STATGROUP_TaskGraphTasks);
+		if (ThreadIndex == ENamedThreads::RHIThread)
+		{
+			return bHighPriority ? EExtendedTaskPriority::RHIThreadHiPri : EExtendedTaskPriority::RHIThreadNormalPri;
+		}
+
+		return EExtendedTaskPriority::None;
+	}
 }
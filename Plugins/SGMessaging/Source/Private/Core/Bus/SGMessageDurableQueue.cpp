@@ -0,0 +1,649 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageDurableQueue.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/Class.h"
+#include "Core/Bus/SGMessageCapture.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageSerializer.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+/* FSGMessageDurableQueue structors
+ *****************************************************************************/
+
+FSGMessageDurableQueue::FSGMessageDurableQueue(const FString& InDirectory, int32 InShardIndex)
+	: Directory(InDirectory)
+	, ShardIndex(InShardIndex)
+	, MaxSegmentSize(1024 * 1024)
+	, Pipe(TEXT("FSGMessageDurableQueue"))
+	, NumDroppedMessages(0)
+{
+	ReplayingRecipient.Invalidate();
+
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		MaxSegmentSize = (int64)FMath::Max(SGMessagingSettings->DurableQueueMaxSizeKb, 1) * 1024;
+		MessageTypes.Append(SGMessagingSettings->DurableMessageTypes);
+	}
+}
+
+
+FSGMessageDurableQueue::~FSGMessageDurableQueue()
+{
+	Flush();
+	Pipe.WaitUntilEmpty();
+
+	// the pipe is idle, so the messages of unfinished replays are put back in front of their segments
+	for (const auto& ReplayPair : Replays)
+	{
+		const FReplay& Replay = *ReplayPair.Value;
+		TArray<uint8> Bytes(Replay.Records.GetData() + Replay.NextRecord, (int32)(Replay.Records.Num() - Replay.NextRecord));
+
+		for (int32 Index = Replay.NextHeldBack; Index < Replay.HeldBack.Num(); ++Index)
+		{
+			SerializeRecord(ReplayPair.Key, *Replay.HeldBack[Index], Bytes);
+		}
+
+		if (Bytes.Num() > 0)
+		{
+			CloseSegment(ReplayPair.Key);
+
+			const FString Filename = GetSegmentFilename(ReplayPair.Key);
+
+			VisitRecords(Filename, [&Bytes](const FRecordHeader& Header, TArrayView<const uint8> RecordBytes)
+			{
+				WriteRecord(Header, RecordBytes, Bytes);
+			});
+
+			if (!WriteSegment(Filename, Bytes))
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Can't write back the unreplayed messages of %s"), *ReplayPair.Key.ToString());
+			}
+		}
+	}
+
+	// closing the handles flushes the segments
+	Segments.Empty();
+}
+
+
+/* FSGMessageDurableQueue interface
+ *****************************************************************************/
+
+bool FSGMessageDurableQueue::Append(const FSGMessageAddress& Recipient, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	if ((MessageTypes.Num() > 0) && !MessageTypes.Contains(Context->GetMessageType()))
+	{
+		return false;
+	}
+
+	// messages sent after the queued ones go after them, whether the recipient is registered or not
+	if (HoldBack(Recipient, Context))
+	{
+		return true;
+	}
+
+	return SerializeRecord(Recipient, *Context, PendingRecords.FindOrAdd(Recipient));
+}
+
+
+void FSGMessageDurableQueue::Flush()
+{
+	if (PendingRecords.Num() == 0)
+	{
+		return;
+	}
+
+	Pipe.Launch(TEXT("FSGMessageDurableQueue.Write"), [this, Batch = MoveTemp(PendingRecords)]()
+	{
+		WriteRecords(Batch);
+	},
+	LowLevelTasks::ETaskPriority::BackgroundNormal);
+
+	PendingRecords.Reset();
+}
+
+
+bool FSGMessageDurableQueue::HoldBack(const FSGMessageAddress& Recipient, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	if ((Replays.Num() == 0) || (Recipient == ReplayingRecipient))
+	{
+		return false;
+	}
+
+	const TSharedRef<FReplay, ESPMode::ThreadSafe>* Replay = Replays.Find(Recipient);
+
+	if (Replay == nullptr)
+	{
+		return false;
+	}
+
+	// the message is delivered to the other recipients now, so the replay only gets it for this one
+	if (Context->GetRecipients().Num() != 1)
+	{
+		(*Replay)->HeldBack.Add(FSGMessageContext::Create(Context, Context->GetSender(), MakeArrayView(&Recipient, 1), Context->GetScope(), Context->GetTimeSent(), Context->GetSenderThread()));
+	}
+	else
+	{
+		(*Replay)->HeldBack.Add(Context);
+	}
+
+	return true;
+}
+
+
+void FSGMessageDurableQueue::BeginReplay(const FSGMessageAddress& Recipient)
+{
+	if (const TSharedRef<FReplay, ESPMode::ThreadSafe>* Replay = Replays.Find(Recipient))
+	{
+		// the recipient went away and came back during its replay, so the records it missed meanwhile follow
+		(*Replay)->bReload = true;
+
+		return;
+	}
+
+	const TSharedRef<FReplay, ESPMode::ThreadSafe> Replay = MakeShared<FReplay, ESPMode::ThreadSafe>();
+
+	Replays.Add(Recipient, Replay);
+	LoadSegment(Recipient, Replay);
+}
+
+
+int32 FSGMessageDurableQueue::ProcessReplays(int32 MaxMessages, TFunctionRef<void(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&)> Callback)
+{
+	int32 NumReplayed = 0;
+
+	for (auto It = Replays.CreateIterator(); It && (NumReplayed < MaxMessages); ++It)
+	{
+		const FSGMessageAddress Recipient = It.Key();
+		const TSharedRef<FReplay, ESPMode::ThreadSafe> Replay = It.Value();
+
+		if (!Replay->bLoaded.load(std::memory_order_acquire))
+		{
+			continue;
+		}
+
+		// the recipient's own messages go to the segment or to the recipient while they are replayed
+		ReplayingRecipient = Recipient;
+
+		while ((Replay->NextRecord + RecordHeaderSize <= Replay->Records.Num()) && (NumReplayed < MaxMessages))
+		{
+			const FRecordHeader Header = ReadRecordHeader(Replay->Records.GetData() + Replay->NextRecord);
+			const TArrayView<const uint8> RecordBytes(Replay->Records.GetData() + Replay->NextRecord + RecordHeaderSize, (int32)Header.RecordSize);
+			const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context = MakeContext(Header, RecordBytes, Recipient);
+
+			Replay->NextRecord += RecordHeaderSize + Header.RecordSize;
+
+			if (Context.IsValid())
+			{
+				Callback(Context.ToSharedRef());
+				++Replay->NumReplayed;
+				++NumReplayed;
+			}
+			else
+			{
+				NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		while ((Replay->NextHeldBack < Replay->HeldBack.Num()) && (NumReplayed < MaxMessages))
+		{
+			const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = Replay->HeldBack[Replay->NextHeldBack++];
+
+			Callback(Context);
+			++NumReplayed;
+		}
+
+		ReplayingRecipient.Invalidate();
+
+		if ((Replay->NextRecord + RecordHeaderSize <= Replay->Records.Num()) || (Replay->NextHeldBack < Replay->HeldBack.Num()))
+		{
+			continue;
+		}
+
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Replayed %d queued messages to %s (%d expired)"), Replay->NumReplayed, *Recipient.ToString(), Replay->NumExpired);
+
+		if (Replay->bReload)
+		{
+			const TSharedRef<FReplay, ESPMode::ThreadSafe> NextReplay = MakeShared<FReplay, ESPMode::ThreadSafe>();
+
+			It.Value() = NextReplay;
+			LoadSegment(Recipient, NextReplay);
+		}
+		else
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	return NumReplayed;
+}
+
+
+void FSGMessageDurableQueue::GetQueuedRecipients(TArray<FSGMessageAddress>& OutRecipients) const
+{
+	TArray<FString> Filenames;
+	IFileManager::Get().FindFiles(Filenames, *FPaths::Combine(Directory, FString::Printf(TEXT("*.%d.sgq"), ShardIndex)), true, false);
+
+	for (const FString& Filename : Filenames)
+	{
+		FSGMessageAddress Recipient;
+
+		if (FSGMessageAddress::Parse(FPaths::GetBaseFilename(FPaths::GetBaseFilename(Filename)), Recipient))
+		{
+			OutRecipients.Add(Recipient);
+		}
+	}
+}
+
+
+/* FSGMessageDurableQueue implementation
+ *****************************************************************************/
+
+void FSGMessageDurableQueue::LoadSegment(const FSGMessageAddress& Recipient, const TSharedRef<FReplay, ESPMode::ThreadSafe>& Replay)
+{
+	// the recipient's records of this pass go to the segment before it is loaded
+	Flush();
+
+	Pipe.Launch(TEXT("FSGMessageDurableQueue.Load"), [this, Recipient, Replay]()
+	{
+		CloseSegment(Recipient);
+
+		IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+		const FString Filename = GetSegmentFilename(Recipient);
+
+		if (PlatformFile.FileExists(*Filename))
+		{
+			const int64 NowTicks = FSGMessageClock::UtcNow().GetTicks();
+
+			const bool bIsSegment = VisitRecords(Filename, [&](const FRecordHeader& Header, TArrayView<const uint8> RecordBytes)
+			{
+				if (Header.ExpirationTicks < NowTicks)
+				{
+					++Replay->NumExpired;
+				}
+				else
+				{
+					WriteRecord(Header, RecordBytes, Replay->Records);
+				}
+			});
+
+			if (!bIsSegment)
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Discarding %s, it isn't a durable queue segment of a known version"), *Filename);
+			}
+
+			PlatformFile.DeleteFile(*Filename);
+		}
+
+		Replay->bLoaded.store(true, std::memory_order_release);
+	},
+	LowLevelTasks::ETaskPriority::BackgroundNormal);
+}
+
+
+void FSGMessageDurableQueue::WriteRecords(const TMap<FSGMessageAddress, TArray<uint8>>& Batch)
+{
+	for (const auto& RecordsPair : Batch)
+	{
+		const FSGMessageAddress& Recipient = RecordsPair.Key;
+		const TArray<uint8>& Bytes = RecordsPair.Value;
+		FSegment* Segment = nullptr;
+
+		for (int64 Offset = 0; Offset + RecordHeaderSize <= Bytes.Num(); )
+		{
+			const int64 NumBytes = RecordHeaderSize + ReadRecordHeader(Bytes.GetData() + Offset).RecordSize;
+
+			if (Segment == nullptr)
+			{
+				Segment = OpenSegment(Recipient);
+			}
+
+			if ((Segment != nullptr) && (Segment->Size + NumBytes > MaxSegmentSize))
+			{
+				CompactSegment(Recipient, NumBytes);
+				Segment = OpenSegment(Recipient);
+			}
+
+			if (Segment == nullptr)
+			{
+				NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+			}
+			else if (Segment->Writer->Write(Bytes.GetData() + Offset, NumBytes))
+			{
+				Segment->Size += NumBytes;
+			}
+			else
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Can't queue message for %s, the segment can't be written"), *Recipient.ToString());
+				NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+				CloseSegment(Recipient);
+				Segment = nullptr;
+			}
+
+			Offset += NumBytes;
+		}
+
+		// the recipient may come back after a crash, so don't leave the batch in a buffer
+		if (Segment != nullptr)
+		{
+			Segment->Writer->Flush();
+		}
+	}
+}
+
+
+FSGMessageDurableQueue::FSegment* FSGMessageDurableQueue::OpenSegment(const FSGMessageAddress& Recipient)
+{
+	if (FSegment* Segment = Segments.Find(Recipient))
+	{
+		return Segment;
+	}
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Filename = GetSegmentFilename(Recipient);
+
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	TUniquePtr<IFileHandle> Writer(PlatformFile.OpenWrite(*Filename, true, false));
+
+	if (!Writer.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't queue messages for %s, segment %s can't be opened"), *Recipient.ToString(), *Filename);
+
+		return nullptr;
+	}
+
+	FSegment& Segment = Segments.Add(Recipient);
+	Segment.Size = Writer->Size();
+	Segment.Writer = MoveTemp(Writer);
+
+	if (Segment.Size == 0)
+	{
+		uint8 FileHeader[HeaderSize];
+		{
+			FMemory::Memcpy(FileHeader, &FileMagic, sizeof(uint32));
+			FileHeader[sizeof(uint32)] = FileVersion;
+		}
+
+		Segment.Writer->Write(FileHeader, HeaderSize);
+		Segment.Size = HeaderSize;
+	}
+
+	return &Segment;
+}
+
+
+void FSGMessageDurableQueue::CloseSegment(const FSGMessageAddress& Recipient)
+{
+	Segments.Remove(Recipient);
+}
+
+
+void FSGMessageDurableQueue::CompactSegment(const FSGMessageAddress& Recipient, int64 NumBytesNeeded)
+{
+	CloseSegment(Recipient);
+
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	const FString Filename = GetSegmentFilename(Recipient);
+	const int64 NowTicks = FSGMessageClock::UtcNow().GetTicks();
+
+	// copy the records that didn't expire, and remember where each one starts
+	TArray<uint8> KeptBytes;
+	TArray<int32> RecordOffsets;
+	int32 NumExpired = 0;
+
+	VisitRecords(Filename, [&](const FRecordHeader& Header, TArrayView<const uint8> RecordBytes)
+	{
+		if (Header.ExpirationTicks < NowTicks)
+		{
+			++NumExpired;
+
+			return;
+		}
+
+		RecordOffsets.Add(KeptBytes.Num());
+		WriteRecord(Header, RecordBytes, KeptBytes);
+	});
+
+	// then drop the oldest records until half of the budget is free
+	const int64 Budget = FMath::Max<int64>(MaxSegmentSize / 2 - NumBytesNeeded - HeaderSize, 0);
+	int32 FirstKept = 0;
+
+	while ((FirstKept < RecordOffsets.Num()) && (KeptBytes.Num() - RecordOffsets[FirstKept] > Budget))
+	{
+		++FirstKept;
+	}
+
+	const int32 KeptOffset = (FirstKept < RecordOffsets.Num()) ? RecordOffsets[FirstKept] : KeptBytes.Num();
+
+	NumDroppedMessages.fetch_add(NumExpired + FirstKept, std::memory_order_relaxed);
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Compacted durable queue of %s, dropped %d expired and %d old messages"), *Recipient.ToString(), NumExpired, FirstKept);
+
+	if (!WriteSegment(Filename, TArrayView<const uint8>(KeptBytes.GetData() + KeptOffset, KeptBytes.Num() - KeptOffset)))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't compact durable queue segment %s, discarding it"), *Filename);
+		PlatformFile.DeleteFile(*Filename);
+	}
+}
+
+
+bool FSGMessageDurableQueue::WriteSegment(const FString& Filename, TArrayView<const uint8> RecordBytes)
+{
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+
+	// write the segment next to the old one, so a crash leaves one of them intact
+	const FString NewFilename = Filename + TEXT(".compact");
+
+	PlatformFile.CreateDirectoryTree(*Directory);
+
+	TUniquePtr<IFileHandle> Writer(PlatformFile.OpenWrite(*NewFilename, false, false));
+
+	if (!Writer.IsValid())
+	{
+		return false;
+	}
+
+	uint8 FileHeader[HeaderSize];
+	{
+		FMemory::Memcpy(FileHeader, &FileMagic, sizeof(uint32));
+		FileHeader[sizeof(uint32)] = FileVersion;
+	}
+
+	Writer->Write(FileHeader, HeaderSize);
+	Writer->Write(RecordBytes.GetData(), RecordBytes.Num());
+	Writer.Reset();
+
+	PlatformFile.DeleteFile(*Filename);
+
+	return PlatformFile.MoveFile(*Filename, *NewFilename);
+}
+
+
+bool FSGMessageDurableQueue::SerializeRecord(const FSGMessageAddress& Recipient, const ISGMessageContext& Context, TArray<uint8>& OutBytes)
+{
+	FSGCapturedMessage Record;
+	FSGMessageCapture::MakeRecord(Context, 0.0, FSGMessageClock::Seconds(), Record);
+
+	if (Record.PayloadFormat == ESGCapturedPayloadFormat::None)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Can't queue %s message for %s, its payload can't be stored"), *Context.GetMessageType().ToString(), *Recipient.ToString());
+		NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+
+		return false;
+	}
+
+	TArray<uint8> RecordBytes;
+	{
+		FMemoryWriter RecordWriter(RecordBytes);
+		RecordWriter << Record;
+	}
+
+	if (HeaderSize + RecordHeaderSize + RecordBytes.Num() > MaxSegmentSize)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Can't queue %s message for %s, it is larger than a segment"), *Context.GetMessageType().ToString(), *Recipient.ToString());
+		NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+
+		return false;
+	}
+
+	FRecordHeader Header;
+	{
+		Header.RecordSize = (uint32)RecordBytes.Num();
+		Header.TimeSentTicks = Context.GetTimeSent().GetTicks();
+		Header.ExpirationTicks = Context.HasExpiration() ? Context.GetExpiration().GetTicks() : FDateTime::MaxValue().GetTicks();
+	}
+
+	WriteRecord(Header, RecordBytes, OutBytes);
+
+	return true;
+}
+
+
+FString FSGMessageDurableQueue::GetSegmentFilename(const FSGMessageAddress& Recipient) const
+{
+	return FPaths::Combine(Directory, FString::Printf(TEXT("%s.%d.sgq"), *Recipient.ToString(), ShardIndex));
+}
+
+
+void FSGMessageDurableQueue::WriteRecord(const FRecordHeader& Header, TArrayView<const uint8> RecordBytes, TArray<uint8>& OutBytes)
+{
+	const int32 Offset = OutBytes.AddUninitialized(RecordHeaderSize + RecordBytes.Num());
+	uint8* Data = OutBytes.GetData() + Offset;
+
+	FMemory::Memcpy(Data, &Header.RecordSize, sizeof(uint32));
+	FMemory::Memcpy(Data + sizeof(uint32), &Header.TimeSentTicks, sizeof(int64));
+	FMemory::Memcpy(Data + sizeof(uint32) + sizeof(int64), &Header.ExpirationTicks, sizeof(int64));
+	FMemory::Memcpy(Data + RecordHeaderSize, RecordBytes.GetData(), RecordBytes.Num());
+}
+
+
+FSGMessageDurableQueue::FRecordHeader FSGMessageDurableQueue::ReadRecordHeader(const uint8* Data)
+{
+	FRecordHeader Header;
+	{
+		FMemory::Memcpy(&Header.RecordSize, Data, sizeof(uint32));
+		FMemory::Memcpy(&Header.TimeSentTicks, Data + sizeof(uint32), sizeof(int64));
+		FMemory::Memcpy(&Header.ExpirationTicks, Data + sizeof(uint32) + sizeof(int64), sizeof(int64));
+	}
+
+	return Header;
+}
+
+
+bool FSGMessageDurableQueue::VisitRecords(const FString& Filename, TFunctionRef<void(const FRecordHeader&, TArrayView<const uint8>)> Visitor)
+{
+	TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+
+	if (!MappedFile.IsValid() || (MappedFile->GetFileSize() < HeaderSize))
+	{
+		return false;
+	}
+
+	const int64 FileSize = MappedFile->GetFileSize();
+	TUniquePtr<IMappedFileRegion> MappedRegion(MappedFile->MapRegion(0, FileSize));
+
+	if (!MappedRegion.IsValid())
+	{
+		return false;
+	}
+
+	const uint8* Data = MappedRegion->GetMappedPtr();
+	uint32 Magic = 0;
+
+	FMemory::Memcpy(&Magic, Data, sizeof(uint32));
+
+	if ((Magic != FileMagic) || (Data[sizeof(uint32)] != FileVersion))
+	{
+		return false;
+	}
+
+	int64 Offset = HeaderSize;
+
+	while (Offset + RecordHeaderSize <= FileSize)
+	{
+		const FRecordHeader Header = ReadRecordHeader(Data + Offset);
+
+		// a crash may have cut the last record short, keep the ones that were written completely
+		if (Offset + RecordHeaderSize + Header.RecordSize > FileSize)
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Durable queue segment %s is truncated"), *Filename);
+
+			break;
+		}
+
+		Visitor(Header, TArrayView<const uint8>(Data + Offset + RecordHeaderSize, (int32)Header.RecordSize));
+		Offset += RecordHeaderSize + Header.RecordSize;
+	}
+
+	return true;
+}
+
+
+TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> FSGMessageDurableQueue::MakeContext(const FRecordHeader& Header, TArrayView<const uint8> RecordBytes, const FSGMessageAddress& Recipient)
+{
+	FSGCapturedMessage Record;
+	FMemoryReaderView RecordReader(RecordBytes);
+
+	RecordReader << Record;
+
+	if (RecordReader.IsError())
+	{
+		return nullptr;
+	}
+
+	const FSGMessageAnnotations Annotations(Record.Annotations);
+	const FDateTime TimeSent(Header.TimeSentTicks);
+	const FDateTime Expiration(Header.ExpirationTicks);
+	const ENamedThreads::Type SenderThread = FTaskGraphInterface::Get().GetCurrentThreadIfKnown();
+
+	switch (Record.PayloadFormat)
+	{
+	case ESGCapturedPayloadFormat::Struct:
+		{
+			UScriptStruct* TypeInfo = FindObject<UScriptStruct>(nullptr, *Record.TypeInfoPath);
+
+			if (TypeInfo == nullptr)
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Can't replay queued %s message, its structure %s doesn't exist"), *Record.MessageType.ToString(), *Record.TypeInfoPath);
+
+				return nullptr;
+			}
+
+			void* Data = FSGMessagePool::Malloc(TypeInfo->GetStructureSize(), TypeInfo->GetMinAlignment());
+			TypeInfo->InitializeStruct(Data);
+
+			FMemoryReader PayloadReader(Record.Payload);
+			TypeInfo->SerializeBin(PayloadReader, Data);
+
+			return FSGMessageContext::Create(Data, TypeInfo, Annotations, nullptr, Record.Sender, MakeArrayView(&Recipient, 1), Record.Scope, Record.Flags, TimeSent, Expiration, SenderThread);
+		}
+
+	case ESGCapturedPayloadFormat::Message:
+		{
+			FSGMessage* DynamicMessage = FSGMessagePool::New<FSGMessage>();
+			const int32 NumSkipped = FSGMessageReader(Record.Payload).ReadMessage(*DynamicMessage);
+
+			if (NumSkipped > 0)
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Replaying queued %s message without %d parameters that can't be decoded"), *Record.MessageType.ToString(), NumSkipped);
+			}
+
+			return FSGMessageContext::Create(Record.MessageType, DynamicMessage, Annotations, nullptr, Record.Sender, MakeArrayView(&Recipient, 1), Record.Scope, Record.Flags, TimeSent, Expiration, SenderThread);
+		}
+
+	default:
+		return nullptr;
+	}
+}
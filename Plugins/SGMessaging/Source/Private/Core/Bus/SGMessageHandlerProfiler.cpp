@@ -0,0 +1,193 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageHandlerProfiler.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "Misc/ScopeLock.h"
+
+
+/* FSGMessageHandlerProfiler static initialization
+ *****************************************************************************/
+
+std::atomic<bool> FSGMessageHandlerProfiler::bEnabled(false);
+std::atomic<uint64> FSGMessageHandlerProfiler::SlowHandlerCycles(0);
+TArray<TSharedRef<FSGMessageHandlerProfiler::FThreadTimings, ESPMode::ThreadSafe>> FSGMessageHandlerProfiler::AllThreadTimings;
+FCriticalSection FSGMessageHandlerProfiler::ThreadTimingsCS;
+FOnSGSlowMessageHandler FSGMessageHandlerProfiler::SlowHandlerDelegate;
+
+
+/* FSGMessageHandlerProfiler interface
+ *****************************************************************************/
+
+void FSGMessageHandlerProfiler::SetEnabled(bool bInEnabled)
+{
+	if (bInEnabled)
+	{
+		const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+		const double ThresholdSeconds = (SGMessagingSettings != nullptr) ? FMath::Max(SGMessagingSettings->SlowHandlerThresholdMs, 0.0f) / 1000.0 : 0.0;
+
+		SlowHandlerCycles.store((uint64)(ThresholdSeconds / FPlatformTime::GetSecondsPerCycle64()), std::memory_order_relaxed);
+	}
+
+	bEnabled.store(bInEnabled, std::memory_order_relaxed);
+}
+
+
+void FSGMessageHandlerProfiler::Record(const FName& HandlerName, const FName& MessageType, uint32 HandlerId, uint64 Cycles)
+{
+	const int64 Second = GetCurrentSecond();
+	const uint64 ThresholdCycles = SlowHandlerCycles.load(std::memory_order_relaxed);
+	FThreadTimings& ThreadTimings = GetThreadTimings();
+	bool bSlow = false;
+	{
+		FScopeLock Lock(&ThreadTimings.CriticalSection);
+
+		FEntry& Entry = ThreadTimings.Entries.FindOrAdd(FEntryKey(HandlerName, MessageType, HandlerId));
+		FBucket& Bucket = Entry.Buckets[Second % MaxWindowSeconds];
+
+		// buckets are reused once their second left the window
+		if (Bucket.Second != Second)
+		{
+			Bucket = FBucket();
+			Bucket.Second = Second;
+		}
+
+		++Bucket.NumCalls;
+		Bucket.TotalCycles += Cycles;
+		Bucket.MaxCycles = FMath::Max(Bucket.MaxCycles, Cycles);
+
+		if ((ThresholdCycles > 0) && (Cycles > ThresholdCycles) && (Entry.LastSlowSecond != Second))
+		{
+			Entry.LastSlowSecond = Second;
+			bSlow = true;
+		}
+	}
+
+	// the handler may run long, so it isn't called under the lock
+	if (bSlow)
+	{
+		const double Milliseconds = FPlatformTime::ToMilliseconds64(Cycles);
+
+		UE_LOG(LogSGMessaging, Warning, TEXT("Handling %s in %s (handler %u) took %.2fms"), *MessageType.ToString(), *HandlerName.ToString(), HandlerId, Milliseconds);
+
+		if (SlowHandlerDelegate.IsBound())
+		{
+			FSGMessageSlowHandlerEvent Event;
+			{
+				Event.HandlerName = HandlerName;
+				Event.MessageType = MessageType;
+				Event.HandlerId = HandlerId;
+				Event.Milliseconds = Milliseconds;
+			}
+
+			SlowHandlerDelegate.Broadcast(Event);
+		}
+	}
+}
+
+
+void FSGMessageHandlerProfiler::GetTopHandlers(int32 MaxHandlers, TArray<FSGMessageHandlerTiming>& OutTimings)
+{
+	const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+	const int64 WindowSeconds = FMath::Clamp((SGMessagingSettings != nullptr) ? SGMessagingSettings->HandlerProfilingWindowSeconds : 5, 1, MaxWindowSeconds);
+	const int64 FirstSecond = GetCurrentSecond() - WindowSeconds + 1;
+
+	// merge the timings of all threads, a handler that runs on several threads has entries on each
+	TMap<FEntryKey, FBucket> Merged;
+	{
+		FScopeLock ListLock(&ThreadTimingsCS);
+
+		for (int32 Index = AllThreadTimings.Num() - 1; Index >= 0; --Index)
+		{
+			FThreadTimings& ThreadTimings = *AllThreadTimings[Index];
+			bool bHasRecent = false;
+			{
+				FScopeLock Lock(&ThreadTimings.CriticalSection);
+
+				for (const auto& EntryPair : ThreadTimings.Entries)
+				{
+					for (const FBucket& Bucket : EntryPair.Value.Buckets)
+					{
+						if (Bucket.Second >= FirstSecond)
+						{
+							FBucket& Sum = Merged.FindOrAdd(EntryPair.Key);
+
+							Sum.NumCalls += Bucket.NumCalls;
+							Sum.TotalCycles += Bucket.TotalCycles;
+							Sum.MaxCycles = FMath::Max(Sum.MaxCycles, Bucket.MaxCycles);
+							bHasRecent = true;
+						}
+					}
+				}
+			}
+
+			// the timings of threads that exited are dropped once they left the window
+			if (!bHasRecent && AllThreadTimings[Index].IsUnique())
+			{
+				AllThreadTimings.RemoveAtSwap(Index);
+			}
+		}
+	}
+
+	OutTimings.Reset(Merged.Num());
+
+	for (const auto& MergedPair : Merged)
+	{
+		FSGMessageHandlerTiming& Timing = OutTimings.AddDefaulted_GetRef();
+		{
+			Timing.HandlerName = MergedPair.Key.Get<0>();
+			Timing.MessageType = MergedPair.Key.Get<1>();
+			Timing.HandlerId = MergedPair.Key.Get<2>();
+			Timing.NumCalls = MergedPair.Value.NumCalls;
+			Timing.TotalMs = FPlatformTime::ToMilliseconds64(MergedPair.Value.TotalCycles);
+			Timing.MaxMs = FPlatformTime::ToMilliseconds64(MergedPair.Value.MaxCycles);
+		}
+	}
+
+	OutTimings.Sort([](const FSGMessageHandlerTiming& A, const FSGMessageHandlerTiming& B) { return A.TotalMs > B.TotalMs; });
+
+	if (OutTimings.Num() > MaxHandlers)
+	{
+		OutTimings.SetNum(FMath::Max(MaxHandlers, 0));
+	}
+}
+
+
+void FSGMessageHandlerProfiler::Reset()
+{
+	FScopeLock ListLock(&ThreadTimingsCS);
+
+	for (const TSharedRef<FThreadTimings, ESPMode::ThreadSafe>& ThreadTimings : AllThreadTimings)
+	{
+		FScopeLock Lock(&ThreadTimings->CriticalSection);
+
+		ThreadTimings->Entries.Empty();
+	}
+}
+
+
+/* FSGMessageHandlerProfiler implementation
+ *****************************************************************************/
+
+FSGMessageHandlerProfiler::FThreadTimings& FSGMessageHandlerProfiler::GetThreadTimings()
+{
+	// the list keeps the timings of a thread that exited until reports drop them
+	thread_local TSharedPtr<FThreadTimings, ESPMode::ThreadSafe> ThreadTimings;
+
+	if (!ThreadTimings.IsValid())
+	{
+		ThreadTimings = MakeShared<FThreadTimings, ESPMode::ThreadSafe>();
+
+		FScopeLock ListLock(&ThreadTimingsCS);
+
+		AllThreadTimings.Add(ThreadTimings.ToSharedRef());
+	}
+
+	return *ThreadTimings;
+}
+
+
+int64 FSGMessageHandlerProfiler::GetCurrentSecond()
+{
+	return (int64)FPlatformTime::Seconds();
+}
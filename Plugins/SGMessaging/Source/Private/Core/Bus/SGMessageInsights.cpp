@@ -0,0 +1,113 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageInsights.h"
+
+#if SGMESSAGING_INSIGHTS_ENABLED
+
+#include "HAL/PlatformTime.h"
+#include "Core/Interface/ISGMessageContext.h"
+
+UE_TRACE_CHANNEL_DEFINE(SGMessagingChannel)
+
+UE_TRACE_EVENT_BEGIN(SGMessaging, MessageSent)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, MessageId)
+	UE_TRACE_EVENT_FIELD(uint64, RootMessageId)
+	UE_TRACE_EVENT_FIELD(uint32, SenderId)
+	UE_TRACE_EVENT_FIELD(uint32, NumRecipients)
+	UE_TRACE_EVENT_FIELD(uint8, Scope)
+	UE_TRACE_EVENT_FIELD(UE::Trace::WideString, MessageType)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(SGMessaging, MessageRouted)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, MessageId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(SGMessaging, MessageIntercepted)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, MessageId)
+	UE_TRACE_EVENT_FIELD(uint32, InterceptorId)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(SGMessaging, MessageDispatched)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, MessageId)
+	UE_TRACE_EVENT_FIELD(uint32, RecipientId)
+	UE_TRACE_EVENT_FIELD(uint32, RecipientThread)
+	UE_TRACE_EVENT_FIELD(bool, Async)
+UE_TRACE_EVENT_END()
+
+UE_TRACE_EVENT_BEGIN(SGMessaging, MessageHandled)
+	UE_TRACE_EVENT_FIELD(uint64, Cycle)
+	UE_TRACE_EVENT_FIELD(uint64, MessageId)
+	UE_TRACE_EVENT_FIELD(uint32, RecipientId)
+UE_TRACE_EVENT_END()
+
+
+namespace SGMessageInsights
+{
+	/** Gets the identity of a message context. */
+	uint64 GetMessageId(const ISGMessageContext& Context)
+	{
+		return (uint64)(UPTRINT)&Context;
+	}
+}
+
+
+/* FSGMessageInsights interface
+ *****************************************************************************/
+
+void FSGMessageInsights::OutputSentMessage(const ISGMessageContext& Context)
+{
+	const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> RootContext = Context.GetRootContext();
+	const FNameBuilder MessageType(Context.GetMessageType());
+
+	UE_TRACE_LOG(SGMessaging, MessageSent, SGMessagingChannel)
+		<< MessageSent.Cycle(FPlatformTime::Cycles64())
+		<< MessageSent.MessageId(SGMessageInsights::GetMessageId(Context))
+		<< MessageSent.RootMessageId(RootContext.IsValid() ? SGMessageInsights::GetMessageId(*RootContext) : 0)
+		<< MessageSent.SenderId(GetTypeHash(Context.GetSender()))
+		<< MessageSent.NumRecipients((uint32)Context.GetRecipients().Num())
+		<< MessageSent.Scope((uint8)Context.GetScope())
+		<< MessageSent.MessageType(MessageType.ToString(), MessageType.Len());
+}
+
+
+void FSGMessageInsights::OutputRoutedMessage(const ISGMessageContext& Context)
+{
+	UE_TRACE_LOG(SGMessaging, MessageRouted, SGMessagingChannel)
+		<< MessageRouted.Cycle(FPlatformTime::Cycles64())
+		<< MessageRouted.MessageId(SGMessageInsights::GetMessageId(Context));
+}
+
+
+void FSGMessageInsights::OutputInterceptedMessage(const ISGMessageContext& Context, const FGuid& InterceptorId)
+{
+	UE_TRACE_LOG(SGMessaging, MessageIntercepted, SGMessagingChannel)
+		<< MessageIntercepted.Cycle(FPlatformTime::Cycles64())
+		<< MessageIntercepted.MessageId(SGMessageInsights::GetMessageId(Context))
+		<< MessageIntercepted.InterceptorId(GetTypeHash(InterceptorId));
+}
+
+
+void FSGMessageInsights::OutputDispatchedMessage(const ISGMessageContext& Context, const FGuid& RecipientId, ENamedThreads::Type RecipientThread, bool bAsync)
+{
+	UE_TRACE_LOG(SGMessaging, MessageDispatched, SGMessagingChannel)
+		<< MessageDispatched.Cycle(FPlatformTime::Cycles64())
+		<< MessageDispatched.MessageId(SGMessageInsights::GetMessageId(Context))
+		<< MessageDispatched.RecipientId(GetTypeHash(RecipientId))
+		<< MessageDispatched.RecipientThread((uint32)RecipientThread)
+		<< MessageDispatched.Async(bAsync);
+}
+
+
+void FSGMessageInsights::OutputHandledMessage(const ISGMessageContext& Context, const FGuid& RecipientId)
+{
+	UE_TRACE_LOG(SGMessaging, MessageHandled, SGMessagingChannel)
+		<< MessageHandled.Cycle(FPlatformTime::Cycles64())
+		<< MessageHandled.MessageId(SGMessageInsights::GetMessageId(Context))
+		<< MessageHandled.RecipientId(GetTypeHash(RecipientId));
+}
+
+#endif
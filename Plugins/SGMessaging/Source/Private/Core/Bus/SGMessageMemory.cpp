@@ -0,0 +1,15 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageMemory.h"
+
+
+/* LLM tags
+ *****************************************************************************/
+
+LLM_DEFINE_TAG(SGMessaging);
+LLM_DEFINE_TAG(SGMessaging_Contexts);
+LLM_DEFINE_TAG(SGMessaging_Payloads);
+LLM_DEFINE_TAG(SGMessaging_MessagePool);
+LLM_DEFINE_TAG(SGMessaging_RouterTables);
+LLM_DEFINE_TAG(SGMessaging_Tracer);
+LLM_DEFINE_TAG(SGMessaging_Inboxes);
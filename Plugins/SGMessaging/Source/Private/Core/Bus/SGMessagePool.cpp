@@ -0,0 +1,392 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "Stats/Stats.h"
+#include <atomic>
+
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pooled Message Allocations"), STAT_SGMessagePool_PooledAllocations, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Unpooled Message Allocations"), STAT_SGMessagePool_UnpooledAllocations, STATGROUP_SGMessaging);
+DECLARE_MEMORY_STAT(TEXT("Message Pool Chunks"), STAT_SGMessagePool_ChunkBytes, STATGROUP_SGMessaging);
+
+
+namespace SGMessagePool
+{
+	/** Size and alignment of the chunks that blocks are carved from. */
+	constexpr SIZE_T ChunkSize = 64 * 1024;
+
+	/** Size of the chunk header; blocks start behind it. */
+	constexpr SIZE_T ChunkHeaderSize = 64;
+
+	/** Size of the smallest block. */
+	constexpr SIZE_T MinBlockSize = 32;
+
+	/** Number of size classes (32 to 1024 bytes). */
+	constexpr int32 NumSizeClasses = 6;
+
+	/** Alignment of all blocks. */
+	constexpr uint32 BlockAlignment = 16;
+
+	/** Number of blocks that are moved between a thread's cache and the shared free list at once. */
+	constexpr int32 BundleSize = 64;
+
+	/** Maximum number of blocks a thread caches per size class before it returns a bundle. */
+	constexpr int32 MaxCachedBlocks = 4 * BundleSize;
+
+	/** Maximum number of chunks (64 MB per size class), allocations fall back to FMemory beyond. */
+	constexpr int32 MaxChunks = 6 * 1024;
+
+	/** Number of slots in the chunk table (a power of two, at least twice the maximum number of chunks). */
+	constexpr int32 ChunkTableSize = 16 * 1024;
+
+	/** Structure for the header at the beginning of each chunk. */
+	struct FChunkHeader
+	{
+		int32 SizeClass;
+	};
+
+	/** Structure for a block in a free list. */
+	struct FFreeBlock
+	{
+		FFreeBlock* Next;
+	};
+
+	/** Structure for a singly linked list of free blocks. */
+	struct FFreeList
+	{
+		FFreeBlock* Head = nullptr;
+		int32 Num = 0;
+
+		void Push(FFreeBlock* Block)
+		{
+			Block->Next = Head;
+			Head = Block;
+			++Num;
+		}
+
+		FFreeBlock* Pop()
+		{
+			FFreeBlock* Block = Head;
+
+			Head = Block->Next;
+			--Num;
+
+			return Block;
+		}
+
+		/** Moves up to the given number of blocks to another list. */
+		void MoveTo(FFreeList& Other, int32 Count)
+		{
+			while ((Count-- > 0) && (Head != nullptr))
+			{
+				Other.Push(Pop());
+			}
+		}
+	};
+
+	/** Gets the size of the blocks in the given size class. */
+	constexpr SIZE_T GetBlockSize(int32 SizeClass)
+	{
+		return MinBlockSize << SizeClass;
+	}
+
+	/** Gets the size class for the given allocation size (or INDEX_NONE if it is too large). */
+	int32 GetSizeClass(SIZE_T Size)
+	{
+		for (int32 SizeClass = 0; SizeClass < NumSizeClasses; ++SizeClass)
+		{
+			if (Size <= GetBlockSize(SizeClass))
+			{
+				return SizeClass;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+	/** Implements the free lists and chunks shared by all threads. */
+	class FSharedPool
+	{
+	public:
+
+		FSharedPool()
+		{
+			for (int32 Index = 0; Index < ChunkTableSize; ++Index)
+			{
+				ChunkTable[Index].store(0, std::memory_order_relaxed);
+			}
+		}
+
+		/** Gets the shared pool, which is never destroyed so that late frees stay safe. */
+		static FSharedPool& Get()
+		{
+			static FSharedPool* SharedPool = new FSharedPool();
+
+			return *SharedPool;
+		}
+
+		/** Fills a thread's free list with a bundle of blocks. */
+		bool Refill(int32 SizeClass, FFreeList& OutList)
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			if ((FreeLists[SizeClass].Num == 0) && !AddChunk(SizeClass))
+			{
+				return false;
+			}
+
+			FreeLists[SizeClass].MoveTo(OutList, BundleSize);
+
+			return true;
+		}
+
+		/** Takes back a bundle of blocks from a thread's free list. */
+		void Return(int32 SizeClass, FFreeList& List, int32 Count)
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			List.MoveTo(FreeLists[SizeClass], Count);
+		}
+
+		/** Checks whether the given memory belongs to a chunk of the pool. */
+		bool Owns(const void* Pointer) const
+		{
+			const UPTRINT ChunkBase = (UPTRINT)Pointer & ~(UPTRINT)(ChunkSize - 1);
+
+			for (uint32 Slot = HashChunk(ChunkBase); ; Slot = (Slot + 1) & (ChunkTableSize - 1))
+			{
+				const UPTRINT Entry = ChunkTable[Slot].load(std::memory_order_acquire);
+
+				if (Entry == ChunkBase)
+				{
+					return true;
+				}
+
+				if (Entry == 0)
+				{
+					return false;
+				}
+			}
+		}
+
+		/** Flushes a thread's allocation counts into the totals. */
+		void AddCounts(int64 PooledAllocations, int64 UnpooledAllocations)
+		{
+			NumPooledAllocations.fetch_add(PooledAllocations, std::memory_order_relaxed);
+			NumUnpooledAllocations.fetch_add(UnpooledAllocations, std::memory_order_relaxed);
+		}
+
+		FSGMessagePoolStatistics GetStatistics() const
+		{
+			FSGMessagePoolStatistics Statistics;
+			{
+				Statistics.NumPooledAllocations = NumPooledAllocations.load(std::memory_order_relaxed);
+				Statistics.NumUnpooledAllocations = NumUnpooledAllocations.load(std::memory_order_relaxed);
+				Statistics.NumChunks = NumChunks.load(std::memory_order_relaxed);
+				Statistics.ChunkBytes = (int64)Statistics.NumChunks * ChunkSize;
+			}
+
+			return Statistics;
+		}
+
+	private:
+
+		/** Carves a new chunk into blocks of the given size class (called with the lock held). */
+		bool AddChunk(int32 SizeClass)
+		{
+			const int32 ChunkIndex = NumChunks.load(std::memory_order_relaxed);
+
+			if (ChunkIndex >= MaxChunks)
+			{
+				return false;
+			}
+
+			uint8* Chunk = nullptr;
+			{
+				LLM_SCOPE_BYTAG(SGMessaging_MessagePool);
+				Chunk = (uint8*)FMemory::Malloc(ChunkSize, ChunkSize);
+			}
+
+			((FChunkHeader*)Chunk)->SizeClass = SizeClass;
+
+			const SIZE_T BlockSize = GetBlockSize(SizeClass);
+
+			for (SIZE_T Offset = ChunkHeaderSize; Offset + BlockSize <= ChunkSize; Offset += BlockSize)
+			{
+				FreeLists[SizeClass].Push((FFreeBlock*)(Chunk + Offset));
+			}
+
+			// chunks are only ever added, so readers can probe the table without locking
+			uint32 Slot = HashChunk((UPTRINT)Chunk);
+
+			while (ChunkTable[Slot].load(std::memory_order_relaxed) != 0)
+			{
+				Slot = (Slot + 1) & (ChunkTableSize - 1);
+			}
+
+			ChunkTable[Slot].store((UPTRINT)Chunk, std::memory_order_release);
+			NumChunks.store(ChunkIndex + 1, std::memory_order_relaxed);
+
+			INC_MEMORY_STAT_BY(STAT_SGMessagePool_ChunkBytes, ChunkSize);
+
+			return true;
+		}
+
+		static uint32 HashChunk(UPTRINT ChunkBase)
+		{
+			return (uint32)(((uint64)(ChunkBase / ChunkSize) * 0x9E3779B97F4A7C15ull) >> 32) & (ChunkTableSize - 1);
+		}
+
+	private:
+
+		/** Guards the shared free lists and chunk creation. */
+		FCriticalSection CriticalSection;
+
+		/** Holds the shared free lists per size class. */
+		FFreeList FreeLists[NumSizeClasses];
+
+		/** Holds the base addresses of all chunks (open addressing, 0 = empty). */
+		std::atomic<UPTRINT> ChunkTable[ChunkTableSize];
+
+		/** Holds the number of chunks. */
+		std::atomic<int32> NumChunks{0};
+
+		/** Holds the total number of pooled allocations. */
+		std::atomic<int64> NumPooledAllocations{0};
+
+		/** Holds the total number of allocations that bypassed the pool. */
+		std::atomic<int64> NumUnpooledAllocations{0};
+	};
+
+	/** Implements a thread's cache of free blocks. */
+	struct FThreadCache
+	{
+		FFreeList FreeLists[NumSizeClasses];
+
+		int64 NumPooledAllocations = 0;
+		int64 NumUnpooledAllocations = 0;
+
+		~FThreadCache()
+		{
+			FSharedPool& SharedPool = FSharedPool::Get();
+
+			for (int32 SizeClass = 0; SizeClass < NumSizeClasses; ++SizeClass)
+			{
+				SharedPool.Return(SizeClass, FreeLists[SizeClass], FreeLists[SizeClass].Num);
+			}
+
+			FlushCounts();
+			bThreadCacheAlive = false;
+		}
+
+		void FlushCounts()
+		{
+			FSharedPool::Get().AddCounts(NumPooledAllocations, NumUnpooledAllocations);
+
+			NumPooledAllocations = 0;
+			NumUnpooledAllocations = 0;
+		}
+
+		/** Set when the thread's cache is destroyed, so that frees during thread exit go to the shared pool. */
+		static thread_local bool bThreadCacheAlive;
+	};
+
+	thread_local bool FThreadCache::bThreadCacheAlive = true;
+
+	thread_local FThreadCache ThreadCache;
+}
+
+
+/* FSGMessagePool interface
+ *****************************************************************************/
+
+void* FSGMessagePool::Malloc(SIZE_T Size, uint32 Alignment)
+{
+	using namespace SGMessagePool;
+
+	const int32 SizeClass = (Alignment <= BlockAlignment) ? GetSizeClass(Size) : INDEX_NONE;
+
+	if ((SizeClass != INDEX_NONE) && FThreadCache::bThreadCacheAlive)
+	{
+		FFreeList& FreeList = ThreadCache.FreeLists[SizeClass];
+
+		if ((FreeList.Num > 0) || FSharedPool::Get().Refill(SizeClass, FreeList))
+		{
+			INC_DWORD_STAT(STAT_SGMessagePool_PooledAllocations);
+
+			if (++ThreadCache.NumPooledAllocations >= BundleSize)
+			{
+				ThreadCache.FlushCounts();
+			}
+
+			return FreeList.Pop();
+		}
+	}
+
+	INC_DWORD_STAT(STAT_SGMessagePool_UnpooledAllocations);
+
+	if (FThreadCache::bThreadCacheAlive)
+	{
+		++ThreadCache.NumUnpooledAllocations;
+	}
+
+	LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+
+	return FMemory::Malloc(Size, Alignment);
+}
+
+
+void FSGMessagePool::Free(void* Pointer)
+{
+	using namespace SGMessagePool;
+
+	if (Pointer == nullptr)
+	{
+		return;
+	}
+
+	FSharedPool& SharedPool = FSharedPool::Get();
+
+	if (!SharedPool.Owns(Pointer))
+	{
+		FMemory::Free(Pointer);
+
+		return;
+	}
+
+	const FChunkHeader* ChunkHeader = (const FChunkHeader*)((UPTRINT)Pointer & ~(UPTRINT)(ChunkSize - 1));
+	const int32 SizeClass = ChunkHeader->SizeClass;
+
+	if (!FThreadCache::bThreadCacheAlive)
+	{
+		FFreeList FreeList;
+		FreeList.Push((FFreeBlock*)Pointer);
+		SharedPool.Return(SizeClass, FreeList, 1);
+
+		return;
+	}
+
+	FFreeList& FreeList = ThreadCache.FreeLists[SizeClass];
+
+	FreeList.Push((FFreeBlock*)Pointer);
+
+	if (FreeList.Num > MaxCachedBlocks)
+	{
+		SharedPool.Return(SizeClass, FreeList, BundleSize);
+	}
+}
+
+
+bool FSGMessagePool::Owns(const void* Pointer)
+{
+	return (Pointer != nullptr) && SGMessagePool::FSharedPool::Get().Owns(Pointer);
+}
+
+
+FSGMessagePoolStatistics FSGMessagePool::GetStatistics()
+{
+	return SGMessagePool::FSharedPool::Get().GetStatistics();
+}
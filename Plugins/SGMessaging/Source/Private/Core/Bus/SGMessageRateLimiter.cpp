@@ -0,0 +1,200 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageRateLimiter.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "Misc/ScopeRWLock.h"
+
+
+/* FSGMessageTokenBucket structors
+ *****************************************************************************/
+
+FSGMessageTokenBucket::FSGMessageTokenBucket(double MessagesPerSecond, int32 InBurst)
+	: FullCycles(0)
+	, NumRejected(0)
+	, Burst((InBurst > 0) ? InBurst : FMath::Max(FMath::CeilToInt32(MessagesPerSecond), 1))
+	, bLimited(false)
+{
+	IntervalCycles = FMath::Max<uint64>((uint64)(1.0 / (FMath::Max(MessagesPerSecond, UE_DOUBLE_SMALL_NUMBER) * FPlatformTime::GetSecondsPerCycle64())), 1);
+	ToleranceCycles = IntervalCycles * (uint64)Burst;
+}
+
+
+/* FSGMessageTokenBucket interface
+ *****************************************************************************/
+
+bool FSGMessageTokenBucket::TryAcquire(int32 Count, uint64 NowCycles)
+{
+	const uint64 CostCycles = IntervalCycles * (uint64)Count;
+	uint64 OldFullCycles = FullCycles.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		// an idle bucket is full, and each message moves the time at which it is full again by one interval
+		const uint64 NewFullCycles = FMath::Max(OldFullCycles, NowCycles) + CostCycles;
+
+		if (NewFullCycles - NowCycles > ToleranceCycles)
+		{
+			NumRejected.fetch_add(Count, std::memory_order_relaxed);
+
+			return false;
+		}
+
+		if (FullCycles.compare_exchange_weak(OldFullCycles, NewFullCycles, std::memory_order_relaxed))
+		{
+			return true;
+		}
+	}
+}
+
+
+/* FSGMessageRateLimiter structors
+ *****************************************************************************/
+
+FSGMessageRateLimiter::FSGMessageRateLimiter()
+	: SenderMessagesPerSecond(0.0)
+	, SenderBurst(0)
+	, bHasSenderLimit(false)
+{
+	if (const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		SenderMessagesPerSecond = SGMessagingSettings->SenderRateLimit.MessagesPerSecond;
+		SenderBurst = SGMessagingSettings->SenderRateLimit.Burst;
+		bHasSenderLimit = (SenderMessagesPerSecond > 0.0);
+
+		for (const auto& RateLimitPair : SGMessagingSettings->MessageTypeRateLimits)
+		{
+			if (RateLimitPair.Value.MessagesPerSecond > 0.0f)
+			{
+				TypeBuckets.Add(RateLimitPair.Key, MakeUnique<FSGMessageTokenBucket>(RateLimitPair.Value.MessagesPerSecond, RateLimitPair.Value.Burst));
+			}
+		}
+	}
+}
+
+
+/* FSGMessageRateLimiter interface
+ *****************************************************************************/
+
+bool FSGMessageRateLimiter::TryAcquire(const FSGMessageAddress& Sender, const FName& MessageType, int32 Count)
+{
+	return TryAcquireSender(Sender, Count) && TryAcquireType(MessageType, Count);
+}
+
+
+bool FSGMessageRateLimiter::TryAcquireSender(const FSGMessageAddress& Sender, int32 Count)
+{
+	if (!bHasSenderLimit)
+	{
+		return true;
+	}
+
+	FSGMessageTokenBucket* Bucket = nullptr;
+	{
+		FReadScopeLock Lock(SenderBucketsLock);
+
+		if (const TUniquePtr<FSGMessageTokenBucket>* FoundBucket = SenderBuckets.Find(Sender))
+		{
+			Bucket = FoundBucket->Get();
+		}
+	}
+
+	if (Bucket == nullptr)
+	{
+		FWriteScopeLock Lock(SenderBucketsLock);
+
+		TUniquePtr<FSGMessageTokenBucket>& NewBucket = SenderBuckets.FindOrAdd(Sender);
+
+		if (!NewBucket.IsValid())
+		{
+			NewBucket = MakeUnique<FSGMessageTokenBucket>(SenderMessagesPerSecond, SenderBurst);
+		}
+
+		Bucket = NewBucket.Get();
+	}
+
+	// buckets are only removed when their sender unregisters, which doesn't race with its own sends
+	const bool bAcquired = Bucket->TryAcquire(Count, FPlatformTime::Cycles64());
+
+	UpdateState(*Bucket, !bAcquired, Sender, NAME_None);
+
+	return bAcquired;
+}
+
+
+bool FSGMessageRateLimiter::TryAcquireType(const FName& MessageType, int32 Count)
+{
+	if (TypeBuckets.Num() == 0)
+	{
+		return true;
+	}
+
+	const TUniquePtr<FSGMessageTokenBucket>* Bucket = TypeBuckets.Find(MessageType);
+
+	if (Bucket == nullptr)
+	{
+		return true;
+	}
+
+	const bool bAcquired = (*Bucket)->TryAcquire(Count, FPlatformTime::Cycles64());
+
+	// the bucket is shared, so its state changes aren't attributed to the sender that happens to cross them
+	FSGMessageAddress NoSender;
+	NoSender.Invalidate();
+
+	UpdateState(**Bucket, !bAcquired, NoSender, MessageType);
+
+	return bAcquired;
+}
+
+
+void FSGMessageRateLimiter::RemoveSender(const FSGMessageAddress& Sender)
+{
+	if (!bHasSenderLimit)
+	{
+		return;
+	}
+
+	FWriteScopeLock Lock(SenderBucketsLock);
+
+	SenderBuckets.Remove(Sender);
+}
+
+
+/* FSGMessageRateLimiter implementation
+ *****************************************************************************/
+
+void FSGMessageRateLimiter::UpdateState(FSGMessageTokenBucket& Bucket, bool bLimited, const FSGMessageAddress& Sender, const FName& MessageType)
+{
+	if (!Bucket.SetLimited(bLimited))
+	{
+		return;
+	}
+
+	if (bLimited)
+	{
+		if (MessageType.IsNone())
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("%s exceeded its sender rate limit, dropping its messages"), *Sender.ToString());
+		}
+		else
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("%s messages exceeded their rate limit, dropping them"), *MessageType.ToString());
+		}
+	}
+
+	if (StateChangedHandler)
+	{
+		FSGMessageBackpressureEvent Event;
+		{
+			Event.Source = ESGMessageBackpressureSource::RateLimit;
+			Event.State = bLimited ? ESGMessageBackpressureState::Congested : ESGMessageBackpressureState::Relieved;
+			Event.Address = Sender;
+			Event.MessageType = MessageType;
+			Event.Capacity = Bucket.GetBurst();
+			Event.NumDroppedMessages = Bucket.GetNumRejected();
+		}
+
+		StateChangedHandler(Event);
+	}
+}
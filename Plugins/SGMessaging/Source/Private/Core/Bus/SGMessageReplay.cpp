@@ -0,0 +1,302 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageReplay.h"
+#include "HAL/RunnableThread.h"
+#include "Serialization/MemoryReader.h"
+#include "UObject/Class.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Interface/ISGMessageBus.h"
+#include "Core/Interface/ISGMessageSender.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageSerializer.h"
+
+
+/**
+ * Implements the sender of replayed messages, which impersonates a captured sender.
+ */
+class FSGMessageReplay::FSender
+	: public ISGMessageSender
+{
+public:
+
+	explicit FSender(const FSGMessageAddress& InAddress)
+		: Address(InAddress)
+	{ }
+
+	//~ ISGMessageSender interface
+
+	virtual FSGMessageAddress GetSenderAddress() override
+	{
+		return Address;
+	}
+
+	virtual void NotifyMessageError(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FString& Error) override
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Replayed %s message failed: %s"), *Context->GetMessageType().ToString(), *Error);
+	}
+
+private:
+
+	/** Holds the captured sender's address. */
+	FSGMessageAddress Address;
+};
+
+
+/* FSGMessageReplay structors
+ *****************************************************************************/
+
+FSGMessageReplay::FSGMessageReplay(const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus)
+	: Bus(InBus)
+	, ThreadSpeed(ESGMessageReplaySpeed::Original)
+	, Thread(nullptr)
+	, bReplaying(false)
+	, bCanceled(false)
+	, NumReplayedMessages(0)
+{ }
+
+
+FSGMessageReplay::~FSGMessageReplay()
+{
+	if (Thread != nullptr)
+	{
+		Thread->Kill(true);
+		delete Thread;
+		Thread = nullptr;
+	}
+}
+
+
+/* FSGMessageReplay interface
+ *****************************************************************************/
+
+bool FSGMessageReplay::Load(const FString& Filename)
+{
+	if (IsReplaying())
+	{
+		return false;
+	}
+
+	if (!FSGMessageCapture::LoadCapture(Filename, Messages))
+	{
+		return false;
+	}
+
+	// messages are captured when they are routed, which can be out of order across router shards
+	Messages.StableSort([](const FSGCapturedMessage& A, const FSGCapturedMessage& B)
+	{
+		return A.TimeSent < B.TimeSent;
+	});
+
+	// resolve the structures here, since the replay may run on another thread
+	TypeInfos.Reset();
+
+	for (const FSGCapturedMessage& Message : Messages)
+	{
+		if ((Message.PayloadFormat == ESGCapturedPayloadFormat::Struct) && !TypeInfos.Contains(Message.TypeInfoPath))
+		{
+			UScriptStruct* TypeInfo = FindObject<UScriptStruct>(nullptr, *Message.TypeInfoPath);
+
+			if (TypeInfo == nullptr)
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Can't replay %s messages, the structure %s doesn't exist"), *Message.MessageType.ToString(), *Message.TypeInfoPath);
+			}
+
+			TypeInfos.Add(Message.TypeInfoPath, TypeInfo);
+		}
+	}
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Loaded %d captured messages from %s"), Messages.Num(), *Filename);
+
+	return true;
+}
+
+
+int32 FSGMessageReplay::Replay(ESGMessageReplaySpeed Speed)
+{
+	bool bWasReplaying = false;
+
+	if (!bReplaying.compare_exchange_strong(bWasReplaying, true))
+	{
+		return 0;
+	}
+
+	return ReplayMessages(Speed);
+}
+
+
+bool FSGMessageReplay::Start(ESGMessageReplaySpeed Speed)
+{
+	bool bWasReplaying = false;
+
+	if (!bReplaying.compare_exchange_strong(bWasReplaying, true))
+	{
+		return false;
+	}
+
+	if (Thread != nullptr)
+	{
+		Thread->WaitForCompletion();
+		delete Thread;
+	}
+
+	ThreadSpeed = Speed;
+	Thread = FRunnableThread::Create(this, TEXT("FSGMessageReplay"), 128 * 1024, TPri_Normal);
+
+	if (Thread == nullptr)
+	{
+		bReplaying.store(false);
+
+		return false;
+	}
+
+	return true;
+}
+
+
+/* FRunnable interface
+ *****************************************************************************/
+
+uint32 FSGMessageReplay::Run()
+{
+	ReplayMessages(ThreadSpeed);
+
+	return 0;
+}
+
+
+void FSGMessageReplay::Stop()
+{
+	bCanceled.store(true);
+}
+
+
+/* FSGMessageReplay implementation
+ *****************************************************************************/
+
+int32 FSGMessageReplay::ReplayMessages(ESGMessageReplaySpeed Speed)
+{
+	bCanceled.store(false);
+	NumReplayedMessages.store(0);
+
+	const double StartTime = FSGMessageClock::Seconds();
+	const double FirstTimeSent = (Messages.Num() > 0) ? Messages[0].TimeSent : 0.0;
+
+	for (const FSGCapturedMessage& Message : Messages)
+	{
+		if (Speed == ESGMessageReplaySpeed::Original)
+		{
+			const double SendTime = StartTime + (Message.TimeSent - FirstTimeSent);
+
+			for (double Remaining = SendTime - FSGMessageClock::Seconds(); (Remaining > 0.0) && !bCanceled.load(std::memory_order_relaxed); Remaining = SendTime - FSGMessageClock::Seconds())
+			{
+				// sleep through long gaps and spin through short ones, sleeping isn't precise enough for them
+				if (Remaining > 0.002)
+				{
+					FPlatformProcess::SleepNoStats((float)(Remaining - 0.001));
+				}
+				else
+				{
+					FPlatformProcess::YieldThread();
+				}
+			}
+		}
+
+		if (bCanceled.load(std::memory_order_relaxed))
+		{
+			break;
+		}
+
+		if (ReplayMessage(Message))
+		{
+			NumReplayedMessages.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	const int32 NumReplayed = GetNumReplayedMessages();
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Replayed %d of %d captured messages in %.3f seconds"), NumReplayed, Messages.Num(), FSGMessageClock::Seconds() - StartTime);
+
+	bReplaying.store(false);
+
+	return NumReplayed;
+}
+
+
+bool FSGMessageReplay::ReplayMessage(const FSGCapturedMessage& Message)
+{
+	const FSGMessageAddress& SenderAddress = MapAddress(Message.Sender);
+	TSharedRef<FSender, ESPMode::ThreadSafe>* Sender = Senders.Find(SenderAddress);
+
+	if (Sender == nullptr)
+	{
+		Sender = &Senders.Add(SenderAddress, MakeShared<FSender, ESPMode::ThreadSafe>(SenderAddress));
+	}
+
+	TArray<FSGMessageAddress, TInlineAllocator<8>> Recipients;
+
+	for (const FSGMessageAddress& Recipient : Message.Recipients)
+	{
+		Recipients.Add(MapAddress(Recipient));
+	}
+
+	const FSGMessageAnnotations Annotations(Message.Annotations);
+	const FDateTime Expiration = (Message.TimeToLive >= 0.0)
+		? FSGMessageClock::UtcNow() + FTimespan::FromSeconds(Message.TimeToLive)
+		: FDateTime::MaxValue();
+
+	switch (Message.PayloadFormat)
+	{
+	case ESGCapturedPayloadFormat::Struct:
+		{
+			UScriptStruct* TypeInfo = TypeInfos.FindRef(Message.TypeInfoPath);
+
+			if (TypeInfo == nullptr)
+			{
+				return false;
+			}
+
+			void* Data = FSGMessagePool::Malloc(TypeInfo->GetStructureSize(), TypeInfo->GetMinAlignment());
+			TypeInfo->InitializeStruct(Data);
+
+			FMemoryReader PayloadReader(Message.Payload);
+			TypeInfo->SerializeBin(PayloadReader, Data);
+
+			// the bus takes over the message's memory
+			if (Recipients.Num() == 0)
+			{
+				Bus->Publish(Data, TypeInfo, Message.Scope, Annotations, FTimespan::Zero(), Expiration, *Sender);
+			}
+			else
+			{
+				Bus->Send(Data, TypeInfo, Message.Flags, Annotations, nullptr, Recipients, FTimespan::Zero(), Expiration, *Sender);
+			}
+		}
+		return true;
+
+	case ESGCapturedPayloadFormat::Message:
+		{
+			FSGMessage* DynamicMessage = FSGMessagePool::New<FSGMessage>();
+			const int32 NumSkipped = FSGMessageReader(Message.Payload).ReadMessage(*DynamicMessage);
+
+			if (NumSkipped > 0)
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Replaying %s message without %d parameters that can't be decoded"), *Message.MessageType.ToString(), NumSkipped);
+			}
+
+			if (Recipients.Num() == 0)
+			{
+				Bus->Publish(Message.MessageType, DynamicMessage, Message.Scope, Annotations, FTimespan::Zero(), Expiration, Message.Flags, *Sender);
+			}
+			else
+			{
+				Bus->Send(Message.MessageType, DynamicMessage, Recipients, Message.Flags, Annotations, nullptr, FTimespan::Zero(), Expiration, *Sender);
+			}
+		}
+		return true;
+
+	default:
+		return false;
+	}
+}
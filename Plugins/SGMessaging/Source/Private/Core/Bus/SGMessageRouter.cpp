@@ -3,7 +3,15 @@
 #include "Core/Bus/SGMessageRouter.h"
 #include "Core/Interface/ISGMessagingModule.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Async/ParallelFor.h"
 #include "Core/Bus/SGMessageDispatchTask.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessageDeliveryScope.h"
+#include "Core/Message/SGMessageTypeRegistry.h"
 #include "Core/Interface/ISGMessageSubscription.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 #include "Core/Interface/ISGMessageInterceptor.h"
@@ -12,32 +20,304 @@
 #include "Core/Settings/SGMessagingSettings.h"
 
 
+namespace SGMessageRouter
+{
+	/** Gets the configured capacity of the router command ring. */
+	uint32 GetCommandRingCapacity()
+	{
+		const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+
+		return (SGMessagingSettings != nullptr) ? (uint32)FMath::Max(SGMessagingSettings->RouterCommandRingCapacity, 64) : 8192;
+	}
+}
+
+
 /* FSGMessageRouter structors
  *****************************************************************************/
 
 FSGMessageRouter::FSGMessageRouter()
-	: DelayedMessagesSequence(0)
+	: FSGMessageRouter(MakeShared<FSGMessageTracer, ESPMode::ThreadSafe>(), MakeShared<FSGMessageStatistics, ESPMode::ThreadSafe>(), MakeShared<FSGMessageCapture, ESPMode::ThreadSafe>())
+{ }
+
+
+FSGMessageRouter::FSGMessageRouter(const TSharedRef<FSGMessageTracer, ESPMode::ThreadSafe>& InTracer, const TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe>& InStatistics, const TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe>& InCapture, bool bInNotifyRegistrations)
+	: CommandQueueDepth(0)
+	, CommandQueueHighWaterMark(0)
+	, CommandQueueLimit(0)
+	, BackpressurePolicy(ESGMessageBackpressurePolicy::DropOldest)
+	, BackpressureBlockTimeout(0.01)
+	, NumDroppedMessages(0)
+	, LastNumDroppedMessages(0)
+	, NumRoutedMessages(0)
+	, NumProcessedCommands(0)
+	, NumDispatchTasks(0)
+	, BusyCycles(0)
+	, NumDelayedMessages(0)
+	, LastMemoryReportCycles(0)
+	, bBackpressureCongested(false)
+	, RouterThreadId(0)
+	, Thread(nullptr)
+	, bThreadPending(false)
+	, ThreadStackSize(128 * 1024)
+	, ThreadPriority(TPri_Normal)
+	, ThreadAffinityMask(0)
+	, bDispatchConflated(false)
+	, ParallelFanOutThreshold(0)
+	, ParallelFanOutChunkSize(128)
+	, bDeterministicFanOut(false)
+	, NumOrderingPartitions(16)
+	, NextDelayedMessageId(0)
 	, Stopping(false)
-	, Tracer(MakeShared<FSGMessageTracer, ESPMode::ThreadSafe>())
+	, bDrainOnStop(false)
+	, Tracer(InTracer)
+	, Statistics(InStatistics)
+	, Capture(InCapture)
+	, bRouterParked(false)
+	, Pool(nullptr)
+	, MaxSpinCycles(0)
+	, SpinCycles(0)
 	, bAllowDelayedMessaging(false)
+	, bAllowDirectDispatch(false)
+	, bDispatchAnyThreadOnWorkers(false)
+	, bNotifyRegistrations(bInNotifyRegistrations)
+	, SpatialCellSize(5000.0f)
+	, SubscriptionSnapshotDirty(true)
+	, TypeSubscriptionsDirty(true)
 {
+	LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
+
 	ActiveSubscriptions.FindOrAdd(NAME_All);
 	WorkEvent = FPlatformProcess::GetSynchEventFromPool();
 
+	const uint32 CommandRingCapacity = SGMessageRouter::GetCommandRingCapacity();
+
+	for (int32 LaneIndex = 0; LaneIndex < NumCommandLanes; ++LaneIndex)
+	{
+		CommandLanes[LaneIndex] = MakeUnique<FSGCommandLane>(CommandRingCapacity);
+		CommandLaneWeights[LaneIndex] = 1;
+	}
+
 	if (const auto SGMessagingSettings = GetMutableDefault<USGMessagingSettings>())
 	{
 		bAllowDelayedMessaging = SGMessagingSettings->bAllowDelayedMessaging;
+		bAllowDirectDispatch = SGMessagingSettings->bAllowDirectDispatch;
+		bDispatchAnyThreadOnWorkers = SGMessagingSettings->bDispatchAnyThreadOnWorkers;
+		ParallelFanOutThreshold = FMath::Max(SGMessagingSettings->ParallelFanOutThreshold, 0);
+		ParallelFanOutChunkSize = FMath::Max(SGMessagingSettings->ParallelFanOutChunkSize, 16);
+		bDeterministicFanOut = SGMessagingSettings->bDeterministicFanOut;
+		NumOrderingPartitions = (uint32)FMath::Max(SGMessagingSettings->RouterOrderingPartitions, 1);
+		CommandLaneWeights[(int32)ESGMessagePriority::High] = FMath::Max(SGMessagingSettings->RouterHighPriorityLaneWeight, 1);
+		CommandLaneWeights[(int32)ESGMessagePriority::Normal] = FMath::Max(SGMessagingSettings->RouterNormalPriorityLaneWeight, 1);
+		CommandQueueLimit = FMath::Max(SGMessagingSettings->RouterCommandQueueLimit, 0);
+		BackpressurePolicy = SGMessagingSettings->RouterBackpressurePolicy;
+		BackpressureBlockTimeout = FMath::Max(SGMessagingSettings->BackpressureBlockTimeoutMs, 0) / 1000.0;
+		SpatialCellSize = FMath::Max(SGMessagingSettings->SpatialCellSize, 100.0f);
+		SetSpinWait(SGMessagingSettings->RouterSpinWaitMicroseconds);
 	}
 }
 
 
 FSGMessageRouter::~FSGMessageRouter()
 {
+	CancelPendingRequests();
+
+	// pipes must be empty when they are destroyed, but the destroying thread (or a delivery of one of the pipes)
+	// doesn't wait for handlers, so busy pipes are destroyed by a task that runs after their last delivery
+	for (auto& PipePair : WorkerDeliveryPipes)
+	{
+		FSGWorkerPipe& WorkerPipe = PipePair.Value;
+
+		if (WorkerPipe.Pipe->HasWork())
+		{
+			UE::Tasks::Launch(TEXT("FSGMessageRouter.RetireWorkerPipe"),
+				[Pipe = MoveTemp(WorkerPipe.Pipe)]()
+				{
+					// the last delivery finished, the pipe only needs to leave its execution context
+					Pipe->WaitUntilEmpty();
+				},
+				UE::Tasks::Prerequisites(WorkerPipe.LastTask),
+				LowLevelTasks::ETaskPriority::BackgroundLow);
+		}
+	}
+
 	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
 	WorkEvent = nullptr;
 }
 
 
+/* FSGMessageRouter interface
+ *****************************************************************************/
+
+void FSGMessageRouter::AddPendingRequest(const TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe>& Request)
+{
+	bool bIsCancelled = false;
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
+		FScopeLock Lock(&PendingRequestsCriticalSection);
+
+		bIsCancelled = bPendingRequestsCancelled;
+
+		if (!bIsCancelled)
+		{
+			PendingRequests.Add(Request->GetCorrelationId(), Request);
+		}
+	}
+
+	// a request that raced with the shutdown would never be completed otherwise
+	if (bIsCancelled)
+	{
+		Request->Complete(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+
+		return;
+	}
+
+	if (Request->GetTimeoutTick() > 0)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::AddRequestTimeout);
+		Command.Request = Request;
+		EnqueueCommand(MoveTemp(Command));
+	}
+}
+
+
+void FSGMessageRouter::DropPendingRequest(const ISGMessageContext& Context)
+{
+	uint64 CorrelationId = 0;
+
+	if (Context.IsForwarded() || !SGMessageRequest::GetCorrelationId(Context, CorrelationId))
+	{
+		return;
+	}
+
+	// the timeout, if there is one, is skipped when it expires, because the request is no longer pending
+	const TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request = TakePendingRequest(CorrelationId);
+
+	if (Request.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Completing %s request from %s, the request message was dropped"), *Context.GetMessageType().ToString(), *Context.GetSender().ToString());
+
+		Request->Complete(FSGMessageReply(ESGMessageRequestResult::Dropped));
+	}
+}
+
+
+bool FSGMessageRouter::DispatchMessageDirect(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	uint32 OrderingKeyHash = 0;
+
+	// keyed messages go through the router, which orders them per key, retained ones, which it keeps, and deduplicated ones, which it remembers
+	if (!bAllowDirectDispatch || !Context->IsValid() || SGMessageOrdering::GetOrderingKeyHash(*Context, OrderingKeyHash) ||
+		EnumHasAnyFlags(Context->GetFlags(), ESGMessageFlags::Retain | ESGMessageFlags::RetainPerSender) || SGMessageDeduplication::IsDeduplicated(*Context))
+	{
+		return false;
+	}
+
+	if (Context->IsExpired(FSGMessageClock::UtcNow()))
+	{
+		Statistics->CountExpiredMessage(Context->GetMessageType());
+
+		return true;
+	}
+
+	TSharedPtr<const FSGSubscriptionSnapshot, ESPMode::ThreadSafe> Snapshot;
+	{
+		FReadScopeLock ReadLock(SubscriptionSnapshotLock);
+		Snapshot = SubscriptionSnapshot;
+	}
+
+	const FName MessageType = Context->GetMessageType();
+
+	if (!Snapshot.IsValid() || Snapshot->bHasTopicSubscriptions || Snapshot->InterceptedTypes.Contains(MessageType) || Snapshot->InterceptedTypes.Contains(NAME_All) || Snapshot->SpatialTypes.Contains(MessageType))
+	{
+		return false;
+	}
+
+	Tracer->TraceSentMessage(Context);
+	Tracer->TraceRoutedMessage(Context);
+	Capture->CaptureMessage(Context);
+	NumRoutedMessages.fetch_add(1, std::memory_order_relaxed);
+
+	const ENamedThreads::Type SenderThread = Context->GetSenderThread();
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>, TInlineAllocator<16>> Recipients;
+
+	auto GatherRecipients = [&](const FSGMessageSubscriptionTable* Subscriptions)
+	{
+		if (Subscriptions == nullptr)
+		{
+			return;
+		}
+
+		Subscriptions->ForEachMatchingSubscriber(*Context, [&Recipients](const ISGMessageReceiver* /*Handle*/, const TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& SubscriberPtr) {
+			auto Subscriber = SubscriberPtr.Pin();
+
+			if (Subscriber.IsValid())
+			{
+				Recipients.AddUnique(Subscriber);
+			}
+		});
+	};
+
+	const int32 TypeId = Context->GetMessageTypeId();
+
+	// types registered after the snapshot was built, and tagged messages, are looked up by name
+	GatherRecipients(Snapshot->TypeSubscriptions.IsValidIndex(TypeId) ? Snapshot->TypeSubscriptions[TypeId] : Snapshot->Subscriptions.Find(MessageType));
+	GatherRecipients(Snapshot->Subscriptions.Find(NAME_All));
+
+	// the publisher delivers, so recipients must not block it
+	FSGMessageDeliveryScope DeliveryScope;
+
+	for (auto& Recipient : Recipients)
+	{
+		ENamedThreads::Type RecipientThread = Recipient->GetRecipientThread();
+
+		if ((RecipientThread == ENamedThreads::AnyThread) || (RecipientThread == SenderThread))
+		{
+			Tracer->TraceDispatchedMessage(Context, Recipient.ToSharedRef(), false);
+			Recipient->ReceiveMessage(Context);
+			Recipient->FlushReceivedMessages();
+			Tracer->TraceHandledMessage(Context, Recipient.ToSharedRef());
+		}
+		else
+		{
+			SGMessageDispatchTask::LaunchOnNamedThread(TEXT("FSGMessageRouter.Dispatch"), RecipientThread, Context->GetPriority(),
+				[Context, RecipientPtr = TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>(Recipient), TracerPtr = TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe>(Tracer), StatisticsPtr = TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe>(Statistics)]()
+				{
+					if (const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> PinnedRecipient = RecipientPtr.Pin())
+					{
+						SGMessageDispatchTask::DeliverMessage(Context, PinnedRecipient.ToSharedRef(), TracerPtr, StatisticsPtr);
+						PinnedRecipient->FlushReceivedMessages();
+					}
+				});
+			NumDispatchTasks.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	return true;
+}
+
+
+int32 FSGMessageRouter::ProcessFrame(uint64 BudgetEndCycles, int32 MaxCommands)
+{
+	// whatever the pass allocates belongs to the router, not to the frame or pool worker that runs it
+	LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
+
+	RouterThreadId.store(FPlatformTLS::GetCurrentThreadId(), std::memory_order_relaxed);
+	CurrentTime = FSGMessageClock::UtcNow();
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	ProcessDelayedMessages();
+	const int32 NumProcessed = ProcessCommands(BudgetEndCycles, MaxCommands);
+	ProcessDurableQueue();
+	FlushDeliveries();
+	FlushRegistrationNotifications();
+
+	UpdateCounters(StartCycles);
+
+	return NumProcessed;
+}
+
+
 /* FSGRunnable interface
  *****************************************************************************/
 
@@ -55,14 +335,35 @@ bool FSGMessageRouter::Init()
 
 uint32 FSGMessageRouter::Run()
 {
+	LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
+
+	RouterThreadId.store(FPlatformTLS::GetCurrentThreadId(), std::memory_order_relaxed);
+
 	while (!Stopping)
 	{
-		CurrentTime = FDateTime::UtcNow();
+		CurrentTime = FSGMessageClock::UtcNow();
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
 
 		ProcessCommands();
 		ProcessDelayedMessages();
+		ProcessDurableQueue();
+		FlushDeliveries();
+		FlushRegistrationNotifications();
+
+		UpdateCounters(StartCycles);
+		WaitForWork(CalculateWaitTime());
+	}
+
+	// commands that producers queued before the bus stopped accepting messages
+	if (bDrainOnStop.load(std::memory_order_acquire))
+	{
+		CurrentTime = FSGMessageClock::UtcNow();
 
-		WorkEvent->Wait(CalculateWaitTime());
+		ProcessCommands();
+		ProcessDurableQueue();
+		FlushDeliveries();
+		FlushRegistrationNotifications();
 	}
 
 	return 0;
@@ -77,52 +378,164 @@ void FSGMessageRouter::Stop()
 }
 
 
-void FSGMessageRouter::Exit()
+void FSGMessageRouter::SetThreadSettings(const FString& InThreadName, uint32 InStackSize, EThreadPriority InThreadPriority, uint64 InAffinityMask)
 {
-	TArray<TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> Recipients;
+	FScopeLock Lock(&ThreadCriticalSection);
 
-	// gather all subscribed and registered recipients
-	for (const auto& RecipientPair : ActiveRecipients)
-	{
-		Recipients.AddUnique(RecipientPair.Value);
-	}
+	ThreadName = InThreadName;
+	ThreadStackSize = InStackSize;
+	ThreadPriority = InThreadPriority;
+	ThreadAffinityMask = InAffinityMask;
+	bThreadPending.store(true, std::memory_order_release);
+}
 
-	for (const auto& SubscriptionsPair : ActiveSubscriptions)
+
+FRunnableThread* FSGMessageRouter::DetachThread()
+{
+	FScopeLock Lock(&ThreadCriticalSection);
+
+	FRunnableThread* DetachedThread = Thread;
+
+	Thread = nullptr;
+	bThreadPending.store(false, std::memory_order_release);
+
+	return DetachedThread;
+}
+
+
+void FSGMessageRouter::SetDurableQueue(TUniquePtr<FSGMessageDurableQueue>&& InDurableQueue)
+{
+	DurableQueue = MoveTemp(InDurableQueue);
+	DurableAddresses.Reset();
+
+	if (DurableQueue.IsValid())
 	{
-		for (const auto& Subscription : SubscriptionsPair.Value)
-		{
-			Recipients.AddUnique(Subscription->GetSubscriber());
-		}
+		TArray<FSGMessageAddress> QueuedRecipients;
+		DurableQueue->GetQueuedRecipients(QueuedRecipients);
+		DurableAddresses.Append(QueuedRecipients);
 	}
 }
 
 
+void FSGMessageRouter::StopRouting(bool bDrain)
+{
+	bDrainOnStop.store(bDrain, std::memory_order_release);
+	Stop();
+}
+
+
+void FSGMessageRouter::Exit()
+{
+	// the router doesn't route anymore, so its tables are released in bulk (endpoints were already told by the bus' shutdown delegate)
+	ActiveRecipients.Empty();
+	ActiveSubscriptions.Empty();
+	TypeSubscriptions.Empty();
+	TypeSubscriptionsDirty = true;
+	ActiveTopicSubscriptions.Empty();
+	SubscriptionsBySubscriber.Empty();
+	ActiveInterceptors.Empty();
+	Redeliveries.Empty();
+
+	CancelPendingRequests();
+}
+
+
 /* FSGMessageRouter implementation
  *****************************************************************************/
 
+void FSGMessageRouter::StartThread()
+{
+	FScopeLock Lock(&ThreadCriticalSection);
+
+	if (bThreadPending.load(std::memory_order_relaxed))
+	{
+		Thread = FRunnableThread::Create(this, *ThreadName, ThreadStackSize, ThreadPriority, ThreadAffinityMask);
+		bThreadPending.store(false, std::memory_order_release);
+	}
+}
+
+
 FTimespan FSGMessageRouter::CalculateWaitTime()
 {
-	FTimespan WaitTime = FTimespan::FromMilliseconds(100);
+	// replays are loaded on the durable queue's pipe and delivered in batches, so check on them soon
+	FTimespan WaitTime = FTimespan::FromMilliseconds((DurableQueue.IsValid() && DurableQueue->IsReplaying()) ? 1 : 100);
 
 	if (DelayedMessages.Num() > 0)
 	{
-		FTimespan DelayedTime = DelayedMessages.HeapTop().Context->GetTimeSent() - CurrentTime;
+		const uint64 NowTick = FSGMessageClock::Milliseconds();
+		const uint64 WheelTick = DelayedMessages.GetCurrentTick();
+		const uint64 Elapsed = (NowTick > WheelTick) ? (NowTick - WheelTick) : 0;
+		const uint64 Ticks = DelayedMessages.GetTicksUntilNextAdvance((uint64)WaitTime.GetTotalMilliseconds());
+
+		return FTimespan::FromMilliseconds((Ticks > Elapsed) ? (double)(Ticks - Elapsed) : 0.0);
+	}
+
+	return WaitTime;
+}
+
+
+void FSGMessageRouter::WaitForWork(const FTimespan& WaitTime)
+{
+	if (MaxSpinCycles > 0)
+	{
+		const uint64 WaitCycles = (uint64)(WaitTime.GetTotalSeconds() / FPlatformTime::GetSecondsPerCycle64());
+		const uint64 SpinEndCycles = FPlatformTime::Cycles64() + FMath::Min(SpinCycles, WaitCycles);
 
-		if (DelayedTime < WaitTime)
+		while (FPlatformTime::Cycles64() < SpinEndCycles)
 		{
-			return DelayedTime;
+			if ((CommandQueueDepth.load(std::memory_order_relaxed) > 0) || Stopping)
+			{
+				// work arrived while spinning, so spinning a little longer next time may avoid another park
+				SpinCycles = FMath::Min(SpinCycles * 2, MaxSpinCycles);
+
+				return;
+			}
+
+			FPlatformProcess::Yield();
 		}
+
+		SpinCycles = FMath::Max(SpinCycles / 2, MaxSpinCycles / 16);
 	}
 
-	return WaitTime;
+	// publish the parked flag before checking for work again; producers add work before checking the flag,
+	// so either they see the flag and trigger the event, or the router sees their work and doesn't park
+	bRouterParked.store(true, std::memory_order_seq_cst);
+
+	if ((CommandQueueDepth.load(std::memory_order_seq_cst) == 0) && !Stopping)
+	{
+		WorkEvent->Wait(WaitTime);
+	}
+
+	bRouterParked.store(false, std::memory_order_relaxed);
 }
 
 
 void FSGMessageRouter::DispatchMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
 {
+	// replies complete their request instead of going through the requester's subscriptions and handlers
+	if (CompleteRequest(Context))
+	{
+		return;
+	}
+
 	if (Context->IsValid())
 	{
-		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> Recipients;
+		// the scratch containers keep their allocations across dispatches
+		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& Recipients = DispatchRecipients;
+
+		Recipients.Reset();
+		CollectedRecipients.Reset();
+
+		bDispatchConflated = SGMessageConflation::GetConflationKey(*Context, DispatchConflationKey);
+
+		// resolve the topic once from the router's cache, so handlers with topic subscriptions don't parse the tag
+		if (!Context->HasTopicID())
+		{
+			int32 TopicID = 0;
+			const bool bIsTopicTag = GetMessageTopicID(Context->GetMessageType(), TopicID);
+
+			Context->SetTopicID(bIsTopicTag ? TOptional<int32>(TopicID) : TOptional<int32>());
+		}
 
 		int32 RecipientCount = Context->GetRecipients().Num();
 
@@ -135,18 +548,36 @@ void FSGMessageRouter::DispatchMessage(const TSharedRef<ISGMessageContext, ESPMo
 				UE_LOG(LogSGMessaging, Verbose, TEXT("Dispatching %s from %s to %s"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString(), *RecipientStr);
 			}
 
-			FilterRecipients(Context, Recipients);
+			const bool bIsQueuedDurably = FilterRecipients(Context, Recipients);
 
 			if (Recipients.Num() < RecipientCount)
 			{
 				UE_LOG(LogSGMessaging, Verbose, TEXT("%d recipients were filtered out"), RecipientCount - Recipients.Num());
 			}
+
+			// nobody can reply to a request that reaches nobody
+			if ((Recipients.Num() == 0) && !bIsQueuedDurably)
+			{
+				DropPendingRequest(*Context);
+			}
 		}
 		// ... or from subscriptions
 		else
 		{
-			FilterSubscriptions(ActiveSubscriptions.FindOrAdd(Context->GetMessageType()), Context, Recipients);
+			if (EnumHasAnyFlags(Context->GetFlags(), ESGMessageFlags::Retain | ESGMessageFlags::RetainPerSender))
+			{
+				RetainMessage(Context);
+			}
+
+			// don't add an empty table for every message type that is routed
+			if (FSGMessageSubscriptionTable* Subscriptions = FindMessageSubscriptionTable(*Context))
+			{
+				FilterSubscriptions(*Subscriptions, Context, Recipients);
+			}
+
 			FilterSubscriptions(ActiveSubscriptions.FindOrAdd(NAME_All), Context, Recipients);
+			FilterTopicSubscriptions(Context, Recipients);
+			FilterSpatialSubscriptions(Context, Recipients);
 
 			if (UE_GET_LOG_VERBOSITY(LogSGMessaging) >= ELogVerbosity::Verbose)
 			{
@@ -156,167 +587,1524 @@ void FSGMessageRouter::DispatchMessage(const TSharedRef<ISGMessageContext, ESPMo
 		}
 
 		// dispatch the message
-		for (auto& Recipient : Recipients)
+		if ((ParallelFanOutThreshold > 0) && (Recipients.Num() >= ParallelFanOutThreshold))
 		{
-			ENamedThreads::Type RecipientThread = Recipient->GetRecipientThread();
-
-			if (RecipientThread == ENamedThreads::AnyThread)
-			{
-				Tracer->TraceDispatchedMessage(Context, Recipient.ToSharedRef(), false);
-				Recipient->ReceiveMessage(Context);
-				Tracer->TraceHandledMessage(Context, Recipient.ToSharedRef());
-			}
-			else
+			DispatchMessageParallel(Context, Recipients);
+		}
+		else
+		{
+			for (auto& Recipient : Recipients)
 			{
-				TGraphTask<FSGMessageDispatchTask>::CreateTask().ConstructAndDispatchWhenReady(RecipientThread, Context, Recipient, Tracer);
+				DispatchToRecipient(Context, Recipient, Recipient->GetRecipientThread());
 			}
 		}
+
+		// don't keep recipients alive until the next dispatch
+		Recipients.Reset();
+		CollectedRecipients.Reset();
 	}
 }
 
 
-void FSGMessageRouter::FilterSubscriptions(
-	TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& Subscriptions,
-	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
-	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients
-)
+void FSGMessageRouter::DispatchToRecipient(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient, ENamedThreads::Type RecipientThread)
 {
-	ESGMessageScope MessageScope = Context->GetScope();
+	uint32 OrderingKeyHash = 0;
 
-	for (int32 SubscriptionIndex = 0; SubscriptionIndex < Subscriptions.Num(); ++SubscriptionIndex)
+	// keyed messages to AnyThread recipients are always handled on workers, one pipe per partition
+	const bool bIsPartitioned = (RecipientThread == ENamedThreads::AnyThread) && SGMessageOrdering::GetOrderingKeyHash(*Context, OrderingKeyHash);
+	const uint32 Partition = bIsPartitioned ? 1 + (OrderingKeyHash % NumOrderingPartitions) : 0;
+	const bool bIsQueued = (RecipientThread != ENamedThreads::AnyThread) || bDispatchAnyThreadOnWorkers || bIsPartitioned;
+
+	if (bIsQueued && bDispatchConflated)
 	{
-		const auto Subscription = Subscriptions[SubscriptionIndex];
+		const TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe> ConflationSlot = GetConflationSlot(Recipient.Get());
 
-		if (!Subscription->IsEnabled() || !Subscription->GetScopeRange().Contains(MessageScope))
+		// a delivery is already pending, and it will pick up this message instead of the older one
+		if (!ConflationSlot->Store(Context))
 		{
-			continue;
-		}
+			Statistics->CountConflatedMessage();
 
-		auto Subscriber = Subscription->GetSubscriber().Pin();
+			return;
+		}
 
-		if (Subscriber.IsValid())
+		if (RecipientThread != ENamedThreads::AnyThread)
 		{
-			if (MessageScope == ESGMessageScope::Thread)
-			{
-				ENamedThreads::Type RecipientThread = Subscriber->GetRecipientThread();
-				ENamedThreads::Type SenderThread = Context->GetSenderThread();
-
-				if (RecipientThread != SenderThread)
-				{
-					continue;
-				}
-			}
-
-			OutRecipients.AddUnique(Subscriber);
+			QueueDelivery(RecipientThread, Context->GetPriority(), FSGMessageDelivery(ConflationSlot, Recipient));
 		}
 		else
 		{
-			Subscriptions.RemoveAtSwap(SubscriptionIndex);
-			--SubscriptionIndex;
+			QueueWorkerDelivery(Recipient.Get(), Partition, Context->GetPriority(), FSGMessageDelivery(ConflationSlot, Recipient));
 		}
 	}
+	else if (RecipientThread != ENamedThreads::AnyThread)
+	{
+		QueueDelivery(RecipientThread, Context->GetPriority(), FSGMessageDelivery(Context, Recipient));
+	}
+	else if (bIsQueued)
+	{
+		QueueWorkerDelivery(Recipient.Get(), Partition, Context->GetPriority(), FSGMessageDelivery(Context, Recipient));
+	}
+	else
+	{
+		Tracer->TraceDispatchedMessage(Context, Recipient.ToSharedRef(), false);
+		Recipient->ReceiveMessage(Context);
+		Recipient->FlushReceivedMessages();
+		Tracer->TraceHandledMessage(Context, Recipient.ToSharedRef());
+	}
 }
 
 
-void FSGMessageRouter::FilterRecipients(
-	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
-	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+void FSGMessageRouter::DispatchMessageParallel(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& Recipients)
 {
-	FSGMessageScopeRange IncludeNetwork = FSGMessageScopeRange::AtLeast(ESGMessageScope::Network);
-	const TArray<FSGMessageAddress>& RecipientList = Context->GetRecipients();
-	for (const auto& RecipientAddress : RecipientList)
+	// conflated deliveries share the router's conflation slots, which the chunks can't look up concurrently
+	if (bDispatchConflated)
 	{
-		auto Recipient = ActiveRecipients.FindRef(RecipientAddress).Pin();
+		for (const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient : Recipients)
+		{
+			DispatchToRecipient(Context, Recipient, Recipient->GetRecipientThread());
+		}
 
-		if (Recipient.IsValid())
+		return;
+	}
+
+	const int32 NumRecipients = Recipients.Num();
+	const int32 NumChunks = FMath::DivideAndRoundUp(NumRecipients, ParallelFanOutChunkSize);
+	const ESGMessagePriority Priority = Context->GetPriority();
+	uint32 OrderingKeyHash = 0;
+
+	// keyed messages are queued to their partitions, so they can't overtake earlier messages of the same key
+	const bool bIsKeyed = SGMessageOrdering::GetOrderingKeyHash(*Context, OrderingKeyHash);
+	const uint32 Partition = bIsKeyed ? 1 + (OrderingKeyHash % NumOrderingPartitions) : 0;
+	const bool bQueueAnyThread = bDispatchAnyThreadOnWorkers || bIsKeyed;
+
+	// the remaining AnyThread recipients are handled in the chunks, unless they must receive the message in subscription order
+	const bool bHandleAnyThreadInChunks = !bQueueAnyThread && !bDeterministicFanOut;
+
+	// the scratch arrays keep their allocations across dispatches
+	FanOutRecipientThreads.Reset(NumRecipients);
+	FanOutRecipientThreads.AddUninitialized(NumRecipients);
+	FanOutHandled.Reset(NumRecipients);
+	FanOutHandled.AddUninitialized(NumRecipients);
+	FanOutDeliveries.Reset(NumRecipients);
+	FanOutDeliveries.AddDefaulted(NumRecipients);
+
+	// the tracer accepts traces from any thread, so its hooks may fire from the chunks
+	ParallelFor(NumChunks, [&](int32 ChunkIndex)
+	{
+		FSGMessageDeliveryScope DeliveryScope;
+		const int32 FirstIndex = ChunkIndex * ParallelFanOutChunkSize;
+		const int32 LastIndex = FMath::Min(FirstIndex + ParallelFanOutChunkSize, NumRecipients);
+
+		for (int32 RecipientIndex = FirstIndex; RecipientIndex < LastIndex; ++RecipientIndex)
 		{
-			// if the recipient is not local and the scope does not include network, filter it out of the recipient list
-			if (Recipient->IsLocal() || IncludeNetwork.Contains(Context->GetScope()))
+			const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient = Recipients[RecipientIndex];
+			const ENamedThreads::Type RecipientThread = Recipient->GetRecipientThread();
+
+			FanOutRecipientThreads[RecipientIndex] = RecipientThread;
+			FanOutHandled[RecipientIndex] = false;
+
+			if ((RecipientThread != ENamedThreads::AnyThread) || bQueueAnyThread)
+			{
+				// the router thread only moves queued deliveries into their batches
+				FanOutDeliveries[RecipientIndex] = FSGMessageDelivery(Context, Recipient);
+			}
+			else if (bHandleAnyThreadInChunks)
 			{
-				OutRecipients.AddUnique(Recipient);
+				Tracer->TraceDispatchedMessage(Context, Recipient.ToSharedRef(), false);
+				Recipient->ReceiveMessage(Context);
+				Recipient->FlushReceivedMessages();
+				Tracer->TraceHandledMessage(Context, Recipient.ToSharedRef());
+
+				FanOutHandled[RecipientIndex] = true;
 			}
 		}
+	});
+
+	// queue the deliveries in recipient order, so batches don't depend on chunk scheduling
+	for (int32 RecipientIndex = 0; RecipientIndex < NumRecipients; ++RecipientIndex)
+	{
+		if (FanOutHandled[RecipientIndex])
+		{
+			continue;
+		}
+
+		const ENamedThreads::Type RecipientThread = FanOutRecipientThreads[RecipientIndex];
+
+		if (RecipientThread != ENamedThreads::AnyThread)
+		{
+			QueueDelivery(RecipientThread, Priority, MoveTemp(FanOutDeliveries[RecipientIndex]));
+		}
+		else if (bQueueAnyThread)
+		{
+			QueueWorkerDelivery(Recipients[RecipientIndex].Get(), Partition, Priority, MoveTemp(FanOutDeliveries[RecipientIndex]));
+		}
 		else
 		{
-			ActiveRecipients.Remove(RecipientAddress);
+			// deterministic fan-outs handle AnyThread recipients here, in subscription order
+			DispatchToRecipient(Context, Recipients[RecipientIndex], RecipientThread);
 		}
 	}
+
+	// don't keep the context alive until the next fan-out
+	FanOutDeliveries.Reset();
 }
 
 
-void FSGMessageRouter::ProcessCommands()
+void FSGMessageRouter::QueueDelivery(ENamedThreads::Type RecipientThread, ESGMessagePriority Priority, FSGMessageDelivery&& Delivery)
 {
-	CommandDelegate Command;
+	// high priority messages get their own batch, because named threads run them ahead of the others
+	const ESGMessagePriority BatchPriority = (Priority == ESGMessagePriority::High) ? ESGMessagePriority::High : ESGMessagePriority::Normal;
+
+	// there are only ever a handful of named threads, so a linear search is fine
+	FSGDeliveryBatch* Batch = PendingDeliveries.FindByPredicate([RecipientThread, BatchPriority](const FSGDeliveryBatch& Candidate) {
+		return (Candidate.Thread == RecipientThread) && (Candidate.Priority == BatchPriority);
+	});
 
-	while (Commands.Dequeue(Command))
+	if (Batch == nullptr)
 	{
-		Command.Execute();
+		Batch = &PendingDeliveries.AddDefaulted_GetRef();
+		Batch->Thread = RecipientThread;
+		Batch->Priority = BatchPriority;
 	}
+
+	Batch->Deliveries.Add(MoveTemp(Delivery));
 }
 
 
-void FSGMessageRouter::ProcessDelayedMessages()
+void FSGMessageRouter::QueueWorkerDelivery(const ISGMessageReceiver* Recipient, uint32 Partition, ESGMessagePriority Priority, FSGMessageDelivery&& Delivery)
 {
-	FSGDelayedMessage DelayedMessage;
+	const FSGWorkerQueueKey QueueKey{ Recipient, Partition };
 
-	while ((DelayedMessages.Num() > 0) && (DelayedMessages.HeapTop().Context->GetTimeSent() <= CurrentTime))
+	FSGDeliveryBatch* Batch = PendingWorkerDeliveries.Find(QueueKey);
+
+	if (Batch == nullptr)
+	{
+		Batch = &PendingWorkerDeliveries.Add(QueueKey);
+		Batch->Priority = Priority;
+	}
+	else if (Priority < Batch->Priority)
+	{
+		// the batch runs with the priority of its most urgent message
+		Batch->Priority = Priority;
+	}
+
+	Batch->Deliveries.Add(MoveTemp(Delivery));
+}
+
+
+TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe> FSGMessageRouter::GetConflationSlot(const ISGMessageReceiver* Recipient)
+{
+	const FSGConflationSlotKey SlotKey{ Recipient, DispatchConflationKey };
+
+	if (const TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe>* ConflationSlot = ConflationSlots.Find(SlotKey))
+	{
+		return *ConflationSlot;
+	}
+
+	// senders and recipients come and go, so forget the slots that have nothing pending
+	if (ConflationSlots.Num() >= 4096)
+	{
+		for (auto It = ConflationSlots.CreateIterator(); It; ++It)
+		{
+			if (It.Value()->IsEmpty())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	return ConflationSlots.Add(SlotKey, MakeShared<FSGMessageConflationSlot, ESPMode::ThreadSafe>());
+}
+
+
+bool FSGMessageRouter::CompleteRequest(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	uint64 CorrelationId = 0;
+
+	if (!SGMessageRequest::GetInReplyTo(*Context, CorrelationId))
+	{
+		return false;
+	}
+
+	TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request = TakePendingRequest(CorrelationId);
+
+	if (!Request.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping %s reply from %s, the request is no longer pending"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString());
+
+		return true;
+	}
+
+	// the timeout may still be on its way to the router, in which case it is skipped when it arrives
+	if (RequestTimeouts.Remove(Request->GetTimerId()) > 0)
+	{
+		DelayedMessages.Remove(Request->GetTimerId());
+	}
+
+	Request->Complete(FSGMessageReply(ESGMessageRequestResult::Replied, Context));
+
+	return true;
+}
+
+
+TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> FSGMessageRouter::TakePendingRequest(uint64 CorrelationId)
+{
+	FScopeLock Lock(&PendingRequestsCriticalSection);
+
+	TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request;
+	PendingRequests.RemoveAndCopyValue(CorrelationId, Request);
+
+	return Request;
+}
+
+
+void FSGMessageRouter::CancelPendingRequests()
+{
+	TMap<uint64, TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe>> CancelledRequests;
+	{
+		FScopeLock Lock(&PendingRequestsCriticalSection);
+		CancelledRequests = MoveTemp(PendingRequests);
+		PendingRequests.Reset();
+		bPendingRequestsCancelled = true;
+	}
+
+	// complete outside the lock, continuations may issue new requests
+	for (auto& RequestPair : CancelledRequests)
+	{
+		RequestPair.Value->Complete(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+	}
+
+	RequestTimeouts.Reset();
+}
+
+
+void FSGMessageRouter::FlushDeliveries()
+{
+	const TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe> TracerPtr = Tracer;
+	const TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe> StatisticsPtr = Statistics;
+
+	for (FSGDeliveryBatch& Batch : PendingDeliveries)
+	{
+		if (Batch.Deliveries.Num() > 0)
+		{
+			SGMessageDispatchTask::LaunchOnNamedThread(TEXT("FSGMessageRouter.BatchDelivery"), Batch.Thread, Batch.Priority,
+				[Deliveries = MoveTemp(Batch.Deliveries), TracerPtr, StatisticsPtr]()
+				{
+					SGMessageDispatchTask::DeliverMessages(Deliveries, TracerPtr, StatisticsPtr);
+				});
+			NumDispatchTasks.fetch_add(1, std::memory_order_relaxed);
+			Batch.Deliveries.Reset();
+		}
+	}
+
+	if (PendingWorkerDeliveries.Num() == 0)
+	{
+		return;
+	}
+
+	// forget idle pipes now and then, so that entries of idle or destroyed recipients don't pile up
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	if (NowCycles >= NextWorkerPipePruneCycles)
+	{
+		NextWorkerPipePruneCycles = NowCycles + (uint64)(WorkerPipePruneIntervalSeconds / FPlatformTime::GetSecondsPerCycle64());
+
+		for (auto It = WorkerDeliveryPipes.CreateIterator(); It; ++It)
+		{
+			if (!It.Value().Pipe->HasWork() && !PendingWorkerDeliveries.Contains(It.Key()))
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	for (auto& DeliveriesPair : PendingWorkerDeliveries)
+	{
+		FSGWorkerPipe& WorkerPipe = WorkerDeliveryPipes.FindOrAdd(DeliveriesPair.Key);
+
+		if (!WorkerPipe.Pipe.IsValid())
+		{
+			WorkerPipe.Pipe = MakeUnique<UE::Tasks::FPipe>(TEXT("FSGMessageRouter.WorkerPipe"));
+		}
+
+		// the partition's pipe runs its batches in order and never concurrently, while other partitions' and recipients' pipes run in parallel
+		WorkerPipe.LastTask = WorkerPipe.Pipe->Launch(TEXT("FSGMessageRouter.WorkerDelivery"),
+			[Deliveries = MoveTemp(DeliveriesPair.Value.Deliveries), TracerPtr, StatisticsPtr]()
+			{
+				SGMessageDispatchTask::DeliverMessages(Deliveries, TracerPtr, StatisticsPtr);
+			},
+			SGMessageDispatchTask::GetTaskPriority(DeliveriesPair.Value.Priority));
+	}
+
+	NumDispatchTasks.fetch_add(PendingWorkerDeliveries.Num(), std::memory_order_relaxed);
+
+	PendingWorkerDeliveries.Reset();
+}
+
+
+void FSGMessageRouter::FilterSubscriptions(
+	FSGMessageSubscriptionTable& Subscriptions,
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients
+)
+{
+	const bool bFoundStale = Subscriptions.ForEachMatchingSubscriber(*Context,
+		[this, &OutRecipients](const ISGMessageReceiver* SubscriberHandle, const TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& SubscriberPtr)
+		{
+			// deduplicate before pinning, so every subscriber is pinned at most once
+			bool bIsAlreadyCollected = false;
+			CollectedRecipients.Add(SubscriberHandle, &bIsAlreadyCollected);
+
+			if (!bIsAlreadyCollected)
+			{
+				auto Subscriber = SubscriberPtr.Pin();
+
+				if (Subscriber.IsValid())
+				{
+					OutRecipients.Add(Subscriber);
+				}
+			}
+		});
+
+	if (bFoundStale && (Subscriptions.RemoveStaleSubscriptions() > 0))
+	{
+		SubscriptionSnapshotDirty = true;
+	}
+}
+
+
+void FSGMessageRouter::FilterTopicSubscriptions(
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+{
+	if ((ActiveTopicSubscriptions.Num() == 0) && (ActiveTopicRangeSubscriptions.Num() == 0))
+	{
+		return;
+	}
+
+	int32 TopicID = 0;
+
+	if (!Context->GetTopicID(TopicID))
+	{
+		return;
+	}
+
+	if (FSGMessageSubscriptionTable* TopicSubscriptions = ActiveTopicSubscriptions.Find(TopicID))
+	{
+		FilterSubscriptions(*TopicSubscriptions, Context, OutRecipients);
+	}
+
+	for (FSGTopicRangeSubscriptions& RangeSubscriptions : ActiveTopicRangeSubscriptions)
+	{
+		if (RangeSubscriptions.TopicRange.Contains(TopicID))
+		{
+			FilterSubscriptions(RangeSubscriptions.Subscriptions, Context, OutRecipients);
+		}
+	}
+}
+
+
+void FSGMessageRouter::FilterSpatialSubscriptions(
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+{
+	FSGMessageSpatialIndex* SpatialIndex = SpatialIndices.Find(Context->GetMessageType());
+
+	if (SpatialIndex == nullptr)
+	{
+		return;
+	}
+
+	auto CollectSubscriber = [this, &OutRecipients](const ISGMessageReceiver* SubscriberHandle, const TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& SubscriberPtr)
+	{
+		bool bIsAlreadyCollected = false;
+		CollectedRecipients.Add(SubscriberHandle, &bIsAlreadyCollected);
+
+		if (!bIsAlreadyCollected)
+		{
+			auto Subscriber = SubscriberPtr.Pin();
+
+			if (Subscriber.IsValid())
+			{
+				OutRecipients.Add(Subscriber);
+			}
+		}
+	};
+
+	FVector Origin;
+
+	// messages without an origin concern everybody, e.g. global announcements
+	const bool bFoundStale = SGMessageSpatial::GetOrigin(*Context, Origin)
+		? SpatialIndex->ForEachInterestedSubscriber(Origin, CollectSubscriber)
+		: SpatialIndex->ForEachSubscriber(CollectSubscriber);
+
+	if (bFoundStale && (SpatialIndex->RemoveStaleSubscribers() > 0) && (SpatialIndex->Num() == 0))
+	{
+		SpatialIndices.Remove(Context->GetMessageType());
+		SubscriptionSnapshotDirty = true;
+	}
+}
+
+
+bool FSGMessageRouter::GetMessageTopicID(const FName& MessageType, int32& OutTopicID)
+{
+	if (const TOptional<int32>* CachedTopicID = MessageTopicIDs.Find(MessageType))
+	{
+		OutTopicID = CachedTopicID->Get(0);
+
+		return CachedTopicID->IsSet();
+	}
+
+	// dynamic tags may be created at any rate, so don't let the cache grow without bounds
+	if (MessageTopicIDs.Num() >= 4096)
+	{
+		MessageTopicIDs.Reset();
+	}
+
+	int32 TopicID = 0;
+	const bool bIsTopicTag = FSGMessageTagBuilder::TryParseTopicID(MessageType, TopicID);
+
+	MessageTopicIDs.Add(MessageType, bIsTopicTag ? TOptional<int32>(TopicID) : TOptional<int32>());
+	OutTopicID = TopicID;
+
+	return bIsTopicTag;
+}
+
+
+bool FSGMessageRouter::FilterRecipients(
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+{
+	FSGMessageScopeRange IncludeNetwork = FSGMessageScopeRange::AtLeast(ESGMessageScope::Network);
+	bool bIsQueuedDurably = false;
+	const TArrayView<const FSGMessageAddress> RecipientList = Context->GetRecipients();
+	for (const auto& RecipientAddress : RecipientList)
+	{
+		if (AddressGroups.Num() > 0)
+		{
+			if (FSGAddressGroup* Group = AddressGroups.Find(RecipientAddress))
+			{
+				FilterGroupRecipients(*Group, Context, OutRecipients);
+
+				continue;
+			}
+		}
+
+		const uint32 Handle = ActiveRecipients.FindHandle(RecipientAddress);
+		auto Recipient = ActiveRecipients.Pin(Handle);
+
+		if (Recipient.IsValid())
+		{
+			// if the recipient is not local and the scope does not include network, filter it out of the recipient list
+			if (ActiveRecipients.IsLocal(Handle) || IncludeNetwork.Contains(Context->GetScope()))
+			{
+				// durable recipients that are replaying their queue get the message after the queued ones
+				if (DurableQueue.IsValid() && DurableQueue->HoldBack(RecipientAddress, Context))
+				{
+					bIsQueuedDurably = true;
+				}
+				else
+				{
+					CollectRecipient(Recipient, OutRecipients);
+				}
+			}
+		}
+		else
+		{
+			if (Handle != FSGMessageRecipientTable::InvalidHandle)
+			{
+				// handles of removed recipients stop resolving, so address groups don't need to be resolved again
+				ActiveRecipients.Remove(RecipientAddress);
+			}
+
+			// durable recipients get the messages when they come back
+			if (DurableQueue.IsValid() && DurableAddresses.Contains(RecipientAddress))
+			{
+				DurableQueue->Append(RecipientAddress, Context);
+				bIsQueuedDurably = true;
+			}
+		}
+	}
+
+	return bIsQueuedDurably;
+}
+
+
+void FSGMessageRouter::FilterGroupRecipients(
+	FSGAddressGroup& Group,
+	const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+{
+	if (Group.ResolvedGeneration != RecipientsGeneration)
+	{
+		Group.ResolvedHandles.Reset(Group.Members.Num());
+
+		for (const FSGMessageAddress& Member : Group.Members)
+		{
+			const uint32 Handle = ActiveRecipients.FindHandle(Member);
+
+			if (Handle != FSGMessageRecipientTable::InvalidHandle)
+			{
+				Group.ResolvedHandles.Add(Handle);
+			}
+		}
+
+		Group.ResolvedGeneration = RecipientsGeneration;
+	}
+
+	const bool bIncludeNetwork = FSGMessageScopeRange::AtLeast(ESGMessageScope::Network).Contains(Context->GetScope());
+
+	for (const uint32 Handle : Group.ResolvedHandles)
+	{
+		auto Recipient = ActiveRecipients.Pin(Handle);
+
+		// handles of unregistered or destroyed recipients don't resolve
+		if (Recipient.IsValid() && (bIncludeNetwork || ActiveRecipients.IsLocal(Handle)))
+		{
+			CollectRecipient(Recipient, OutRecipients);
+		}
+	}
+}
+
+
+bool FSGMessageRouter::ApplyBackpressure(const FSGRouterCommand& Command)
+{
+	if ((BackpressurePolicy == ESGMessageBackpressurePolicy::DropOldest) || (BackpressurePolicy == ESGMessageBackpressurePolicy::Coalesce))
+	{
+		// only the router thread may dequeue, so it makes room when it processes the queue
+		return true;
+	}
+
+	// the router can't make room while its own thread waits, so messages it routes to itself are dropped right away
+	if ((BackpressurePolicy == ESGMessageBackpressurePolicy::Block) && (FPlatformTLS::GetCurrentThreadId() != RouterThreadId.load(std::memory_order_relaxed)))
+	{
+		const double BlockEndTime = FPlatformTime::Seconds() + BackpressureBlockTimeout;
+
+		while (CommandQueueDepth.load(std::memory_order_relaxed) >= CommandQueueLimit)
+		{
+			if (FPlatformTime::Seconds() >= BlockEndTime)
+			{
+				DropCommand(Command);
+
+				return false;
+			}
+
+			NotifyWork();
+			FPlatformProcess::Yield();
+		}
+
+		return true;
+	}
+
+	DropCommand(Command);
+
+	return false;
+}
+
+
+void FSGMessageRouter::DropCommand(const FSGRouterCommand& Command)
+{
+	if (Command.Type == ESGRouterCommand::RouteMessages)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping a batch of %d messages, the router command queue is full"), Command.Contexts.Num());
+
+		NumDroppedMessages.fetch_add(Command.Contexts.Num(), std::memory_order_relaxed);
+
+		for (const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& Context : Command.Contexts)
+		{
+			Statistics->CountDroppedMessage(Context->GetMessageType());
+			DropPendingRequest(*Context);
+		}
+
+		return;
+	}
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping %s message, the router command queue is full"), *Command.Context->GetMessageType().ToString());
+
+	NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+	Statistics->CountDroppedMessage(Command.Context->GetMessageType());
+	DropPendingRequest(*Command.Context);
+}
+
+
+void FSGMessageRouter::TrimCommands(int32 NumExcessCommands)
+{
+	FSGRouterCommand Command;
+
+	for (int32 LaneIndex = NumCommandLanes - 1; (LaneIndex >= 0) && (NumExcessCommands > 0); --LaneIndex)
+	{
+		FSGCarriedCommands& Carried = CarriedCommands[LaneIndex];
+
+		// commands that were carried over are the oldest of their lane
+		for (int32 Index = Carried.Head; (Index < Carried.Commands.Num()) && (NumExcessCommands > 0);)
+		{
+			if (IsRouteCommand(Carried.Commands[Index]))
+			{
+				CommandQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+				DropCommand(Carried.Commands[Index]);
+				Carried.Commands.RemoveAt(Index);
+				--NumExcessCommands;
+			}
+			else
+			{
+				++Index;
+			}
+		}
+
+		// other commands keep their place in the lane, so they still run after the commands queued before them
+		while ((NumExcessCommands > 0) && CommandLanes[LaneIndex]->Dequeue(Command))
+		{
+			if (IsRouteCommand(Command))
+			{
+				CommandQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+				DropCommand(Command);
+				--NumExcessCommands;
+			}
+			else
+			{
+				Carried.Add(MoveTemp(Command));
+			}
+
+			Command = FSGRouterCommand();
+		}
+	}
+}
+
+
+bool FSGMessageRouter::DequeueCommand(int32 LaneIndex, FSGRouterCommand& OutCommand)
+{
+	return CarriedCommands[LaneIndex].Dequeue(OutCommand) || CommandLanes[LaneIndex]->Dequeue(OutCommand);
+}
+
+
+void FSGMessageRouter::ExecuteFence(uint64 Sequence)
+{
+	FSGRouterCommand Command;
+
+	// fences are queued in the high priority lane, which is processed in order already
+	for (int32 LaneIndex = (int32)ESGMessagePriority::High + 1; LaneIndex < NumCommandLanes; ++LaneIndex)
+	{
+		while (DequeueCommand(LaneIndex, Command))
+		{
+			if (Command.Sequence > Sequence)
+			{
+				CarriedCommands[LaneIndex].AddFront(MoveTemp(Command));
+				Command = FSGRouterCommand();
+
+				break;
+			}
+
+			CommandQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+			Statistics->RecordCommandLatency((ESGMessagePriority)LaneIndex, FPlatformTime::Cycles64() - Command.EnqueueCycles);
+
+			ExecuteCommand(Command);
+
+			Command = FSGRouterCommand();
+		}
+	}
+}
+
+
+void FSGMessageRouter::UpdateBackpressureState(int32 PassQueueDepth)
+{
+	if (CommandQueueLimit <= 0)
+	{
+		return;
+	}
+
+	const int64 NumDropped = NumDroppedMessages.load(std::memory_order_relaxed);
+	const bool bDroppedMessages = (NumDropped != LastNumDroppedMessages);
+
+	// congestion starts at the limit but only ends below half of it, so listeners don't get flooded at the edge
+	const bool bIsCongested = bDroppedMessages || (PassQueueDepth >= (bBackpressureCongested ? CommandQueueLimit / 2 : CommandQueueLimit));
+
+	LastNumDroppedMessages = NumDropped;
+
+	if (bIsCongested == bBackpressureCongested)
+	{
+		return;
+	}
+
+	bBackpressureCongested = bIsCongested;
+
+	FSGMessageBackpressureEvent Event;
+	{
+		Event.Source = ESGMessageBackpressureSource::Router;
+		Event.State = bIsCongested ? ESGMessageBackpressureState::Congested : ESGMessageBackpressureState::Relieved;
+		Event.QueueDepth = PassQueueDepth;
+		Event.Capacity = CommandQueueLimit;
+		Event.NumDroppedMessages = NumDropped;
+	}
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Router command queue is %s (%d of %d commands queued)"), bIsCongested ? TEXT("congested") : TEXT("relieved"), PassQueueDepth, CommandQueueLimit);
+
+	NotifyBackpressure(Event);
+}
+
+
+void FSGMessageRouter::ExecuteCommand(FSGRouterCommand& Command)
+{
+	if (IsFenceCommand(Command))
+	{
+		ExecuteFence(Command.Sequence);
+	}
+
+	switch (Command.Type)
+	{
+	case ESGRouterCommand::AddInterceptor:
+		HandleAddInterceptor(Command.Interceptor.ToSharedRef(), Command.MessageType);
+		break;
+
+	case ESGRouterCommand::AddListener:
+		HandleAddListener(Command.Listener);
+		break;
+
+	case ESGRouterCommand::AddRecipient:
+		HandleAddRecipient(Command.Address, Command.Receiver);
+		break;
+
+	case ESGRouterCommand::AddSubscription:
+		HandleAddSubscriber(Command.Subscription.ToSharedRef());
+		break;
+
+	case ESGRouterCommand::CancelDelayedMessage:
+		HandleCancelDelayedMessage(Command.DelayedMessageId);
+		break;
+
+	case ESGRouterCommand::AddPeriodicMessage:
+		HandleAddPeriodicMessage(Command.Context.ToSharedRef(), Command.DelayedMessageId, Command.IntervalTicks);
+		break;
+
+	case ESGRouterCommand::NotifyBackpressure:
+		NotifyBackpressure(Command.BackpressureEvent);
+		break;
+
+	case ESGRouterCommand::RedeliverMessage:
+		HandleRedeliverMessage(Command.Context.ToSharedRef(), Command.Address, Command.IntervalTicks);
+		break;
+
+	case ESGRouterCommand::UpdateSpatialInterests:
+		HandleUpdateSpatialInterests(Command.SpatialInterests);
+		break;
+
+	case ESGRouterCommand::RemoveInterceptor:
+		HandleRemoveInterceptor(Command.Interceptor.ToSharedRef(), Command.MessageType);
+		break;
+
+	case ESGRouterCommand::RemoveListener:
+		HandleRemoveListener(Command.Listener);
+		break;
+
+	case ESGRouterCommand::RemoveRecipient:
+		HandleRemoveRecipient(Command.Address);
+		break;
+
+	case ESGRouterCommand::RemoveSubscription:
+		HandleRemoveSubscriber(Command.Receiver, MakeArrayView(&Command.MessageType, 1));
+		break;
+
+	case ESGRouterCommand::AddSubscriptions:
+		for (const TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription : Command.Subscriptions)
+		{
+			HandleAddSubscriber(Subscription.ToSharedRef());
+		}
+		break;
+
+	case ESGRouterCommand::RemoveSubscriptions:
+		HandleRemoveSubscriber(Command.Receiver, Command.MessageTypes);
+		break;
+
+	case ESGRouterCommand::RouteMessage:
+		HandleRouteMessage(Command.Context.ToSharedRef(), Command.DelayedMessageId);
+		break;
+
+	case ESGRouterCommand::RouteMessages:
+		for (const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& Context : Command.Contexts)
+		{
+			HandleRouteMessage(Context.ToSharedRef(), 0);
+		}
+		break;
+
+	case ESGRouterCommand::AddRequestTimeout:
+		HandleAddRequestTimeout(Command.Request.ToSharedRef());
+		break;
+
+	case ESGRouterCommand::AddAddressGroup:
+		HandleAddAddressGroup(Command.Address, Command.MessageType);
+		break;
+
+	case ESGRouterCommand::AddAddressGroupMembers:
+		HandleAddAddressGroupMembers(Command.Address, Command.Addresses);
+		break;
+
+	case ESGRouterCommand::RemoveAddressGroup:
+		HandleRemoveAddressGroup(Command.Address);
+		break;
+
+	case ESGRouterCommand::RemoveAddressGroupMembers:
+		HandleRemoveAddressGroupMembers(Command.Address, Command.Addresses);
+		break;
+
+	default:
+		checkNoEntry();
+	}
+}
+
+
+int32 FSGMessageRouter::ProcessCommands(uint64 BudgetEndCycles, int32 MaxCommands)
+{
+	FSGMessageDeliveryScope DeliveryScope;
+
+	const int32 PassQueueDepth = CommandQueueDepth.load(std::memory_order_relaxed);
+
+	if ((CommandQueueLimit > 0) && (PassQueueDepth > CommandQueueLimit) && ((BackpressurePolicy == ESGMessageBackpressurePolicy::DropOldest) || (BackpressurePolicy == ESGMessageBackpressurePolicy::Coalesce)))
+	{
+		TrimCommands(PassQueueDepth - CommandQueueLimit);
+	}
+
+	FSGRouterCommand Command;
+	bool bProcessedAny;
+	bool bBudgetExhausted = false;
+	int32 NumProcessed = 0;
+
+	// weighted round robin: each round serves up to a lane's weight worth of commands, highest
+	// priority first, so critical traffic is preferred but lower lanes are never starved
+	do
+	{
+		bProcessedAny = false;
+
+		for (int32 LaneIndex = 0; (LaneIndex < NumCommandLanes) && !bBudgetExhausted; ++LaneIndex)
+		{
+			for (int32 Budget = CommandLaneWeights[LaneIndex]; (Budget > 0) && !bBudgetExhausted && DequeueCommand(LaneIndex, Command); --Budget)
+			{
+				CommandQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+				Statistics->RecordCommandLatency((ESGMessagePriority)LaneIndex, FPlatformTime::Cycles64() - Command.EnqueueCycles);
+
+				ExecuteCommand(Command);
+
+				// release references held by the command as soon as it was executed
+				Command = FSGRouterCommand();
+				bProcessedAny = true;
+
+				// the rest is carried over, in order, to the next pass
+				++NumProcessed;
+				bBudgetExhausted = ((MaxCommands > 0) && (NumProcessed >= MaxCommands)) || ((BudgetEndCycles > 0) && (FPlatformTime::Cycles64() >= BudgetEndCycles));
+			}
+		}
+	}
+	while (bProcessedAny && !bBudgetExhausted);
+
+	NumProcessedCommands.fetch_add(NumProcessed, std::memory_order_relaxed);
+
+	UpdateBackpressureState(PassQueueDepth);
+	UpdateSubscriptionSnapshot();
+
+	return NumProcessed;
+}
+
+
+void FSGMessageRouter::ProcessDurableQueue()
+{
+	if (!DurableQueue.IsValid())
+	{
+		return;
+	}
+
+	if (DurableQueue->IsReplaying())
+	{
+		FSGMessageDeliveryScope DeliveryScope;
+
+		DurableQueue->ProcessReplays(MaxReplayedMessagesPerPass, [this](const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+		{
+			DispatchMessage(Context);
+		});
+	}
+
+	// messages queued for offline recipients during the pass are written in one batch
+	DurableQueue->Flush();
+}
+
+
+void FSGMessageRouter::ProcessDelayedMessages()
+{
+	DelayedMessages.Advance(FSGMessageClock::Milliseconds(), ExpiredDelayedMessages, ExpiredRequestTimeouts);
+
+	for (const uint64 TimerId : ExpiredRequestTimeouts)
+	{
+		if (FSGPeriodicMessage* PeriodicMessage = PeriodicMessages.Find(TimerId))
+		{
+			const uint64 NowTick = DelayedMessages.GetCurrentTick();
+
+			// schedule from the due tick so periods don't drift, and skip the periods that were missed altogether
+			PeriodicMessage->DueTick += PeriodicMessage->IntervalTicks;
+
+			if (PeriodicMessage->DueTick <= NowTick)
+			{
+				PeriodicMessage->DueTick += ((NowTick - PeriodicMessage->DueTick) / PeriodicMessage->IntervalTicks + 1) * PeriodicMessage->IntervalTicks;
+			}
+
+			DelayedMessages.AddTimeout(TimerId, PeriodicMessage->DueTick);
+
+			// each period gets a light context of its own, so its send time is current
+			const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = PeriodicMessage->Context.ToSharedRef();
+			const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> PeriodContext = FSGMessageContext::Create(Context, Context->GetSender(), Context->GetRecipients(), Context->GetScope(), CurrentTime, Context->GetSenderThread());
+
+			Tracer->TraceSentMessage(PeriodContext);
+			HandleRouteMessage(PeriodContext, 0);
+
+			continue;
+		}
+
+		FSGRedelivery Redelivery;
+
+		if (Redeliveries.RemoveAndCopyValue(TimerId, Redelivery))
+		{
+			RedeliverToRecipient(Redelivery.Context.ToSharedRef(), Redelivery.Recipient);
+
+			continue;
+		}
+
+		TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request;
+
+		if (RequestTimeouts.RemoveAndCopyValue(TimerId, Request) && TakePendingRequest(Request->GetCorrelationId()).IsValid())
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Request %llu timed out"), Request->GetCorrelationId());
+
+			Request->Complete(FSGMessageReply(ESGMessageRequestResult::TimedOut));
+		}
+	}
+
+	ExpiredRequestTimeouts.Reset();
+
+	for (const auto& DelayedMessage : ExpiredDelayedMessages)
+	{
+		// the message may have expired while it was waiting
+		if (DelayedMessage->IsExpired(CurrentTime))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping expired delayed %s message"), *DelayedMessage->GetMessageType().ToString());
+			Statistics->CountExpiredMessage(DelayedMessage->GetMessageType());
+
+			continue;
+		}
+
+		DispatchMessage(DelayedMessage.ToSharedRef());
+	}
+
+	ExpiredDelayedMessages.Reset();
+}
+
+
+void FSGMessageRouter::PurgeDelayedMessages(const FSGMessageAddress& Address)
+{
+	if (DelayedMessages.Num() == 0)
+	{
+		return;
+	}
+
+	// redeliveries go to the recipient only, so they can't go anywhere else
+	for (auto It = Redeliveries.CreateIterator(); It; ++It)
+	{
+		if (It.Value().Recipient == Address)
+		{
+			DelayedMessages.Remove(It.Key());
+			It.RemoveCurrent();
+		}
+	}
+
+	// durable recipients get their messages when they are due, whether they are registered or not
+	if (DurableAddresses.Contains(Address))
+	{
+		return;
+	}
+
+	// keep messages that still have a recipient to go to
+	const int32 NumPurged = DelayedMessages.RemoveByRecipient(Address, [this](const ISGMessageContext& Context)
+	{
+		for (const FSGMessageAddress& Recipient : Context.GetRecipients())
+		{
+			if (AddressGroups.Contains(Recipient) || ActiveRecipients.Pin(ActiveRecipients.FindHandle(Recipient)).IsValid())
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}, PurgedDelayedMessages);
+
+	if (NumPurged > 0)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Purged %i delayed messages to %s, which is no longer registered"), NumPurged, *Address.ToString());
+	}
+
+	// don't keep the messages alive until the next purge
+	PurgedDelayedMessages.Reset();
+}
+
+
+void FSGMessageRouter::RedeliverToRecipient(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& RecipientAddress)
+{
+	if (Context->IsExpired(CurrentTime))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping expired redelivered %s message"), *Context->GetMessageType().ToString());
+		Statistics->CountExpiredMessage(Context->GetMessageType());
+
+		return;
+	}
+
+	const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Recipient = ActiveRecipients.Pin(ActiveRecipients.FindHandle(RecipientAddress));
+
+	if (!Recipient.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping redelivered %s message, %s is no longer registered"), *Context->GetMessageType().ToString(), *RecipientAddress.ToString());
+
+		return;
+	}
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Redelivering %s from %s to %s"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString(), *RecipientAddress.ToString());
+
+	bDispatchConflated = SGMessageConflation::GetConflationKey(*Context, DispatchConflationKey);
+
+	DispatchToRecipient(Context, Recipient, Recipient->GetRecipientThread());
+}
+
+
+void FSGMessageRouter::RetainMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	FSGMessageAddress RetainKey;
+
+	if (EnumHasAnyFlags(Context->GetFlags(), ESGMessageFlags::RetainPerSender))
+	{
+		RetainKey = Context->GetSender();
+	}
+
+	RetainedMessages.FindOrAdd(Context->GetMessageType()).Add(RetainKey, Context);
+}
+
+
+void FSGMessageRouter::DeliverRetainedMessages(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription)
+{
+	if (RetainedMessages.Num() == 0)
+	{
+		return;
+	}
+
+	// consumer group members share the stream, so the group already received the current state
+	if (!Subscription->IsEnabled() || !Subscription->GetConsumerGroup().IsNone())
+	{
+		return;
+	}
+
+	const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber = Subscription->GetSubscriber().Pin();
+
+	if (!Subscriber.IsValid())
+	{
+		return;
+	}
+
+	const FName SubscribedType = Subscription->GetMessageType();
+	const FSGMessageContentFilter* ContentFilter = Subscription->GetContentFilter();
+	const TRange<ESGMessageScope>& ScopeRange = Subscription->GetScopeRange();
+	const ENamedThreads::Type RecipientThread = Subscriber->GetRecipientThread();
+
+	auto DeliverMessagesOfType = [&](TMap<FSGMessageAddress, TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& Messages)
+	{
+		for (auto It = Messages.CreateIterator(); It; ++It)
+		{
+			const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context = It.Value().ToSharedRef();
+
+			if (Context->IsExpired(CurrentTime))
+			{
+				It.RemoveCurrent();
+
+				continue;
+			}
+
+			// apply the same filters as FSGMessageSubscriptionTable::ForEachMatchingSubscriber
+			if (!ScopeRange.Contains(Context->GetScope()) || ((Context->GetScope() == ESGMessageScope::Thread) && (RecipientThread != Context->GetSenderThread())))
+			{
+				continue;
+			}
+
+			if ((ContentFilter != nullptr) && !ContentFilter->Matches(*Context))
+			{
+				continue;
+			}
+
+			bDispatchConflated = SGMessageConflation::GetConflationKey(*Context, DispatchConflationKey);
+			DispatchToRecipient(Context, Subscriber, RecipientThread);
+		}
+	};
+
+	FSGMessageTopicRange TopicRange;
+
+	if (SubscribedType == NAME_All)
+	{
+		for (auto& RetainedPair : RetainedMessages)
+		{
+			DeliverMessagesOfType(RetainedPair.Value);
+		}
+	}
+	else if (FSGMessageTagBuilder::TryParseTopicPattern(SubscribedType, TopicRange))
+	{
+		for (auto& RetainedPair : RetainedMessages)
+		{
+			int32 TopicID = 0;
+
+			if (GetMessageTopicID(RetainedPair.Key, TopicID) && TopicRange.Contains(TopicID))
+			{
+				DeliverMessagesOfType(RetainedPair.Value);
+			}
+		}
+	}
+	else if (auto* Messages = RetainedMessages.Find(SubscribedType))
+	{
+		DeliverMessagesOfType(*Messages);
+	}
+}
+
+
+void FSGMessageRouter::UpdateCounters(uint64 StartCycles)
+{
+	BusyCycles.fetch_add(FPlatformTime::Cycles64() - StartCycles, std::memory_order_relaxed);
+	NumDelayedMessages.store(DelayedMessages.Num(), std::memory_order_relaxed);
+
+	static const uint64 MemoryReportIntervalCycles = (uint64)(1.0 / FPlatformTime::GetSecondsPerCycle64());
+
+	const uint64 NowCycles = FPlatformTime::Cycles64();
+
+	if (NowCycles - LastMemoryReportCycles >= MemoryReportIntervalCycles)
+	{
+		LastMemoryReportCycles = NowCycles;
+		UpdateMemoryReport();
+	}
+}
+
+
+void FSGMessageRouter::UpdateMemoryReport()
+{
+	FSGMessageMemoryReport Report;
+
+	Report.NumRecipients = ActiveRecipients.Num();
+	Report.TableBytes = ActiveRecipients.GetAllocatedSize() + ActiveInterceptors.GetAllocatedSize() + AddressGroups.GetAllocatedSize() + ActiveSubscriptions.GetAllocatedSize() + TypeSubscriptions.GetAllocatedSize()
+		+ ActiveTopicSubscriptions.GetAllocatedSize() + ActiveTopicRangeSubscriptions.GetAllocatedSize() + SubscriptionsBySubscriber.GetAllocatedSize()
+		+ MessageTopicIDs.GetAllocatedSize() + ActiveRegistrationListeners.GetAllocatedSize() + RequestTimeouts.GetAllocatedSize() + DurableAddresses.GetAllocatedSize()
+		+ ConflationSlots.GetAllocatedSize();
+
+	for (const auto& InterceptorsPair : ActiveInterceptors)
+	{
+		Report.NumInterceptors += InterceptorsPair.Value.Num();
+		Report.TableBytes += InterceptorsPair.Value.GetAllocatedSize();
+	}
+
+	for (const auto& GroupPair : AddressGroups)
+	{
+		Report.TableBytes += GroupPair.Value.Members.GetAllocatedSize() + GroupPair.Value.ResolvedHandles.GetAllocatedSize();
+	}
+
+	for (const auto& SubscriptionsPair : ActiveSubscriptions)
+	{
+		Report.NumSubscriptions += SubscriptionsPair.Value.Num();
+		Report.TableBytes += SubscriptionsPair.Value.GetAllocatedSize();
+	}
+
+	for (const auto& TopicSubscriptionsPair : ActiveTopicSubscriptions)
+	{
+		Report.NumSubscriptions += TopicSubscriptionsPair.Value.Num();
+		Report.TableBytes += TopicSubscriptionsPair.Value.GetAllocatedSize();
+	}
+
+	for (const FSGTopicRangeSubscriptions& RangeSubscriptions : ActiveTopicRangeSubscriptions)
+	{
+		Report.NumSubscriptions += RangeSubscriptions.Subscriptions.Num();
+		Report.TableBytes += RangeSubscriptions.Subscriptions.GetAllocatedSize();
+	}
+
+	for (const auto& SubscriberPair : SubscriptionsBySubscriber)
+	{
+		Report.TableBytes += SubscriberPair.Value.GetAllocatedSize();
+	}
+
+	{
+		FScopeLock Lock(&PendingRequestsCriticalSection);
+
+		Report.NumPendingRequests = PendingRequests.Num();
+		Report.TableBytes += PendingRequests.GetAllocatedSize();
+	}
+
+	Report.NumDeduplicationKeys = DeduplicationWindow.Num();
+	Report.IndexBytes = RetainedMessages.GetAllocatedSize() + SpatialIndices.GetAllocatedSize() + DeduplicationWindow.GetAllocatedSize();
+
+	for (const auto& RetainedPair : RetainedMessages)
+	{
+		Report.NumRetainedMessages += RetainedPair.Value.Num();
+		Report.IndexBytes += RetainedPair.Value.GetAllocatedSize();
+	}
+
+	for (const auto& SpatialIndexPair : SpatialIndices)
+	{
+		Report.NumSpatialSubscribers += SpatialIndexPair.Value.Num();
+		Report.IndexBytes += SpatialIndexPair.Value.GetAllocatedSize();
+	}
+
+	Report.NumQueuedCommands = CommandQueueDepth.load(std::memory_order_relaxed);
+	Report.QueueBytes = PendingDeliveries.GetAllocatedSize() + PendingWorkerDeliveries.GetAllocatedSize() + WorkerDeliveryPipes.GetAllocatedSize() + PendingRegistrations.GetAllocatedSize()
+		+ DispatchRecipients.GetAllocatedSize() + CollectedRecipients.GetAllocatedSize() + FanOutRecipientThreads.GetAllocatedSize() + FanOutHandled.GetAllocatedSize();
+
+	for (const TUniquePtr<FSGCommandLane>& CommandLane : CommandLanes)
+	{
+		Report.QueueBytes += CommandLane->GetAllocatedSize();
+	}
+
+	for (const FSGDeliveryBatch& Batch : PendingDeliveries)
+	{
+		Report.QueueBytes += Batch.Deliveries.GetAllocatedSize();
+	}
+
+	for (const auto& WorkerDeliveryPair : PendingWorkerDeliveries)
+	{
+		Report.QueueBytes += WorkerDeliveryPair.Value.Deliveries.GetAllocatedSize();
+	}
+
+	Report.NumDelayedMessages = DelayedMessages.Num() + PeriodicMessages.Num();
+	Report.DelayedBytes = DelayedMessages.GetAllocatedSize() + PeriodicMessages.GetAllocatedSize() + Redeliveries.GetAllocatedSize() + ExpiredDelayedMessages.GetAllocatedSize()
+		+ PurgedDelayedMessages.GetAllocatedSize() + ExpiredRequestTimeouts.GetAllocatedSize();
+
+	FScopeLock Lock(&MemoryReportCriticalSection);
+
+	MemoryReport = Report;
+}
+
+
+void FSGMessageRouter::UpdateSubscriptionSnapshot()
+{
+	if (!bAllowDirectDispatch || !SubscriptionSnapshotDirty)
+	{
+		return;
+	}
+
+	// the snapshot is rebuilt at most once per command batch, and published readers keep their old copy alive
+	TSharedRef<FSGSubscriptionSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FSGSubscriptionSnapshot, ESPMode::ThreadSafe>();
+
+	for (const auto& InterceptorsPair : ActiveInterceptors)
+	{
+		if (InterceptorsPair.Value.Num() > 0)
+		{
+			Snapshot->InterceptedTypes.Add(InterceptorsPair.Key);
+		}
+	}
+
+	for (const auto& SubscriptionsPair : ActiveSubscriptions)
+	{
+		if (SubscriptionsPair.Value.Num() > 0)
+		{
+			Snapshot->Subscriptions.Add(SubscriptionsPair.Key, SubscriptionsPair.Value);
+		}
+	}
+
+	for (const auto& SpatialIndexPair : SpatialIndices)
+	{
+		Snapshot->SpatialTypes.Add(SpatialIndexPair.Key);
+	}
+
+	// the snapshot's tables don't move after this, so they can be indexed by type identifier
+	if (Snapshot->Subscriptions.Num() > 0)
+	{
+		TArray<FName> TypeNames;
+		FSGMessageTypeRegistry::Get().GetTypeNames(TypeNames);
+
+		Snapshot->TypeSubscriptions.Reserve(TypeNames.Num());
+
+		for (const FName& TypeName : TypeNames)
+		{
+			Snapshot->TypeSubscriptions.Add(Snapshot->Subscriptions.Find(TypeName));
+		}
+	}
+
+	Snapshot->bHasTopicSubscriptions = (ActiveTopicSubscriptions.Num() > 0) || (ActiveTopicRangeSubscriptions.Num() > 0);
+
+	{
+		FWriteScopeLock WriteLock(SubscriptionSnapshotLock);
+		SubscriptionSnapshot = Snapshot;
+	}
+
+	SubscriptionSnapshotDirty = false;
+}
+
+
+/* FSingleThreadRunnable interface
+ *****************************************************************************/
+
+void FSGMessageRouter::Tick()
+{
+	ProcessFrame(0, 0);
+}
+
+
+/* FSGMessageRouter callbacks
+ *****************************************************************************/
+
+void FSGMessageRouter::HandleAddInterceptor(TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor, FName MessageType)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s as intereceptor for %s messages"), *Interceptor->GetDebugName().ToString(), *MessageType.ToString());
+
+	ActiveInterceptors.FindOrAdd(MessageType).AddUnique(Interceptor);
+	Tracer->TraceAddedInterceptor(Interceptor, MessageType);
+	SubscriptionSnapshotDirty = true;
+}
+
+
+void FSGMessageRouter::HandleAddRecipient(FSGMessageAddress Address, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> RecipientPtr)
+{
+	auto Recipient = RecipientPtr.Pin();
+
+	if (Recipient.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s on %s as recipient"), *Recipient->GetDebugName().ToString(), *Address.ToString());
+
+		ActiveRecipients.Add(Address, Recipient.ToSharedRef());
+		++RecipientsGeneration;
+		Tracer->TraceAddedRecipient(Address, Recipient.ToSharedRef());
+		NotifyRegistration(Address, ESGMessageBusNotification::Registered);
+
+		if (Recipient->IsDurable())
+		{
+			DurableAddresses.Add(Address);
+
+			if (DurableQueue.IsValid())
+			{
+				DurableQueue->BeginReplay(Address);
+			}
+		}
+	}
+}
+
+
+void FSGMessageRouter::HandleAddSubscriber(TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription)
+{
+	auto Subscriber = Subscription->GetSubscriber().Pin();
+
+	if (Subscriber.IsValid())
 	{
-		DelayedMessages.HeapPop(DelayedMessage);
-		DispatchMessage(DelayedMessage.Context.ToSharedRef());
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s as a subscriber for %s messages"), *Subscriber->GetDebugName().ToString(), *Subscription->GetMessageType().ToString());
 	}
-}
 
+	if (FindOrAddSubscriptionTable(Subscription->GetMessageType()).Add(Subscription) && Subscriber.IsValid())
+	{
+		TArray<TWeakPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& SubscriberSubscriptions = SubscriptionsBySubscriber.FindOrAdd(Subscriber.Get());
 
-/* FSingleThreadRunnable interface
- *****************************************************************************/
+		// a subscriber at the address of one that died without unsubscribing inherits nothing
+		if (SubscriberSubscriptions.Num() > 0)
+		{
+			const auto FirstSubscription = SubscriberSubscriptions[0].Pin();
 
-void FSGMessageRouter::Tick()
-{
-	CurrentTime = FDateTime::UtcNow();
+			if (!FirstSubscription.IsValid() || !FirstSubscription->GetSubscriber().HasSameObject(Subscriber.Get()))
+			{
+				SubscriberSubscriptions.Reset();
+			}
+		}
 
-	ProcessDelayedMessages();
-	ProcessCommands();
+		SubscriberSubscriptions.Add(Subscription);
+	}
+
+	Tracer->TraceAddedSubscription(Subscription);
+	SubscriptionSnapshotDirty = true;
+	DeliverRetainedMessages(Subscription);
 }
 
 
-/* FSGMessageRouter callbacks
- *****************************************************************************/
+FSGMessageSubscriptionTable* FSGMessageRouter::FindSubscriptionTable(FName MessageType)
+{
+	FSGMessageTopicRange TopicRange;
 
-void FSGMessageRouter::HandleAddInterceptor(TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor, FName MessageType)
+	if (!FSGMessageTagBuilder::TryParseTopicPattern(MessageType, TopicRange))
+	{
+		return ActiveSubscriptions.Find(MessageType);
+	}
+
+	if (TopicRange.IsSingleTopic())
+	{
+		return ActiveTopicSubscriptions.Find(TopicRange.First);
+	}
+
+	FSGTopicRangeSubscriptions* RangeSubscriptions = ActiveTopicRangeSubscriptions.FindByPredicate([&TopicRange](const FSGTopicRangeSubscriptions& Candidate) {
+		return Candidate.TopicRange == TopicRange;
+	});
+
+	return (RangeSubscriptions != nullptr) ? &RangeSubscriptions->Subscriptions : nullptr;
+}
+
+
+FSGMessageSubscriptionTable& FSGMessageRouter::FindOrAddSubscriptionTable(FName MessageType)
 {
-	UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s as intereceptor for %s messages"), *Interceptor->GetDebugName().ToString(), *MessageType.ToString());
+	FSGMessageTopicRange TopicRange;
 
-	ActiveInterceptors.FindOrAdd(MessageType).AddUnique(Interceptor);
-	Tracer->TraceAddedInterceptor(Interceptor, MessageType);
+	if (!FSGMessageTagBuilder::TryParseTopicPattern(MessageType, TopicRange))
+	{
+		const int32 NumTables = ActiveSubscriptions.Num();
+		FSGMessageSubscriptionTable& Subscriptions = ActiveSubscriptions.FindOrAdd(MessageType);
+
+		// adding a table may have moved the others
+		TypeSubscriptionsDirty |= (ActiveSubscriptions.Num() != NumTables);
+
+		return Subscriptions;
+	}
+
+	if (TopicRange.IsSingleTopic())
+	{
+		return ActiveTopicSubscriptions.FindOrAdd(TopicRange.First);
+	}
+
+	FSGTopicRangeSubscriptions* RangeSubscriptions = ActiveTopicRangeSubscriptions.FindByPredicate([&TopicRange](const FSGTopicRangeSubscriptions& Candidate) {
+		return Candidate.TopicRange == TopicRange;
+	});
+
+	if (RangeSubscriptions == nullptr)
+	{
+		RangeSubscriptions = &ActiveTopicRangeSubscriptions.AddDefaulted_GetRef();
+		RangeSubscriptions->TopicRange = TopicRange;
+	}
+
+	return RangeSubscriptions->Subscriptions;
 }
 
 
-void FSGMessageRouter::HandleAddRecipient(FSGMessageAddress Address, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> RecipientPtr)
+FSGMessageSubscriptionTable* FSGMessageRouter::FindMessageSubscriptionTable(const ISGMessageContext& Context)
 {
-	auto Recipient = RecipientPtr.Pin();
+	const int32 TypeId = Context.GetMessageTypeId();
 
-	if (Recipient.IsValid())
+	if (TypeId == INDEX_NONE)
 	{
-		UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s on %s as recipient"), *Recipient->GetDebugName().ToString(), *Address.ToString());
+		return ActiveSubscriptions.Find(Context.GetMessageType());
+	}
 
-		ActiveRecipients.FindOrAdd(Address) = Recipient;
-		Tracer->TraceAddedRecipient(Address, Recipient.ToSharedRef());
-		NotifyRegistration(Address, ESGMessageBusNotification::Registered);
+	// types registered since the last rebuild have identifiers past the end of the table
+	if (TypeSubscriptionsDirty || (TypeId >= TypeSubscriptions.Num()))
+	{
+		UpdateTypeSubscriptions();
 	}
+
+	return TypeSubscriptions.IsValidIndex(TypeId) ? TypeSubscriptions[TypeId] : nullptr;
 }
 
 
-void FSGMessageRouter::HandleAddSubscriber(TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription)
+void FSGMessageRouter::UpdateTypeSubscriptions()
 {
-	auto Subscriber = Subscription->GetSubscriber().Pin();
+	LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
 
-	if (Subscriber.IsValid())
+	// the table of all types is looked up after the type's table when routing, so it must not move them
+	ActiveSubscriptions.FindOrAdd(NAME_All);
+
+	TArray<FName> TypeNames;
+	FSGMessageTypeRegistry::Get().GetTypeNames(TypeNames);
+
+	TypeSubscriptions.Reset(TypeNames.Num());
+
+	for (const FName& TypeName : TypeNames)
 	{
-		UE_LOG(LogSGMessaging, Verbose, TEXT("Adding %s as a subscriber for %s messages"), *Subscriber->GetDebugName().ToString(), *Subscription->GetMessageType().ToString());
+		TypeSubscriptions.Add(ActiveSubscriptions.Find(TypeName));
 	}
 
-	ActiveSubscriptions.FindOrAdd(Subscription->GetMessageType()).AddUnique(Subscription);
-	Tracer->TraceAddedSubscription(Subscription);
+	TypeSubscriptionsDirty = false;
 }
 
 
@@ -326,36 +2114,69 @@ void FSGMessageRouter::HandleRemoveInterceptor(TSharedRef<ISGMessageInterceptor,
 
 	if (MessageType == NAME_All)
 	{
-		for (auto& InterceptorsPair : ActiveInterceptors)
+		for (auto It = ActiveInterceptors.CreateIterator(); It; ++It)
 		{
-			InterceptorsPair.Value.Remove(Interceptor);
+			It.Value().Remove(Interceptor);
+
+			if (It.Value().Num() == 0)
+			{
+				It.RemoveCurrent();
+			}
 		}
 	}
-	else
+	else if (auto Interceptors = ActiveInterceptors.Find(MessageType))
 	{
-		auto& Interceptors = ActiveInterceptors.FindOrAdd(MessageType);
-		Interceptors.Remove(Interceptor);
+		Interceptors->Remove(Interceptor);
+
+		// keep the registry empty when nobody intercepts, so routing can skip the lookup
+		if (Interceptors->Num() == 0)
+		{
+			ActiveInterceptors.Remove(MessageType);
+		}
 	}
 
 	Tracer->TraceRemovedInterceptor(Interceptor, MessageType);
+	SubscriptionSnapshotDirty = true;
 }
 
 void FSGMessageRouter::HandleRemoveRecipient(FSGMessageAddress Address)
 {
-	auto Recipient = ActiveRecipients.FindRef(Address).Pin();
+	const uint32 Handle = ActiveRecipients.FindHandle(Address);
+
+	if (Handle == FSGMessageRecipientTable::InvalidHandle)
+	{
+		return;
+	}
+
+	// endpoints unregister from their destructor, so by now their weak pointer has expired
+	const auto Recipient = ActiveRecipients.Pin(Handle);
+
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Removing %s on %s as recipient"), Recipient.IsValid() ? *Recipient->GetDebugName().ToString() : TEXT("destroyed recipient"), *Address.ToString());
+
+	ActiveRecipients.Remove(Address);
+	Tracer->TraceRemovedRecipient(Address);
+	NotifyRegistration(Address, ESGMessageBusNotification::Unregistered);
 
+	// a recipient that is still alive may register again, so its delayed messages stay until they are due
 	if (Recipient.IsValid())
 	{
-		UE_LOG(LogSGMessaging, Verbose, TEXT("Removing %s on %s as recipient"), *Recipient->GetDebugName().ToString(), *Address.ToString());
+		return;
+	}
 
-		ActiveRecipients.Remove(Address);
-		Tracer->TraceRemovedRecipient(Address);
-		NotifyRegistration(Address, ESGMessageBusNotification::Unregistered);
+	PurgeDelayedMessages(Address);
+
+	// the state of a sender that went away is stale
+	for (auto It = RetainedMessages.CreateIterator(); It; ++It)
+	{
+		if ((It.Value().Remove(Address) > 0) && (It.Value().Num() == 0))
+		{
+			It.RemoveCurrent();
+		}
 	}
 }
 
 
-void FSGMessageRouter::HandleRemoveSubscriber(TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> SubscriberPtr, FName MessageType)
+void FSGMessageRouter::HandleRemoveSubscriber(TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> SubscriberPtr, TArrayView<const FName> MessageTypes)
 {
 	auto Subscriber = SubscriberPtr.Pin();
 
@@ -364,60 +2185,128 @@ void FSGMessageRouter::HandleRemoveSubscriber(TWeakPtr<ISGMessageReceiver, ESPMo
 		return;
 	}
 
-	for (auto& SubscriptionsPair : ActiveSubscriptions)
+	TArray<TWeakPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>* SubscriberSubscriptions = SubscriptionsBySubscriber.Find(Subscriber.Get());
+
+	if (SubscriberSubscriptions == nullptr)
 	{
-		if ((MessageType != NAME_All) && (MessageType != SubscriptionsPair.Key))
-		{
-			continue;
-		}
+		return;
+	}
+
+	const bool bRemoveAll = MessageTypes.Contains(NAME_All);
+	bool bEmptiedTable = false;
 
-		TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& Subscriptions = SubscriptionsPair.Value;
+	// only the subscriber's own subscriptions are visited, so churn doesn't scale with the number of tables
+	for (int32 Index = SubscriberSubscriptions->Num() - 1; Index >= 0; --Index)
+	{
+		const auto Subscription = (*SubscriberSubscriptions)[Index].Pin();
 
-		for (int32 SubscriptionIndex = 0; SubscriptionIndex < Subscriptions.Num(); ++SubscriptionIndex)
+		if (Subscription.IsValid() && Subscription->GetSubscriber().HasSameObject(Subscriber.Get()))
 		{
-			const auto Subscription = Subscriptions[SubscriptionIndex];
+			const FName MessageType = Subscription->GetMessageType();
 
-			if (Subscription->GetSubscriber().Pin() == Subscriber)
+			if (!bRemoveAll && !MessageTypes.Contains(MessageType))
 			{
-				UE_LOG(LogSGMessaging, Verbose, TEXT("Removing %s as a subscriber for %s messages"), *Subscriber->GetDebugName().ToString(), *Subscription->GetMessageType().ToString());
+				continue;
+			}
 
-				Subscriptions.RemoveAtSwap(SubscriptionIndex);
-				Tracer->TraceRemovedSubscription(Subscription.ToSharedRef(), MessageType);
+			if (FSGMessageSubscriptionTable* Subscriptions = FindSubscriptionTable(MessageType))
+			{
+				if (Subscriptions->Remove(Subscription.Get()))
+				{
+					UE_LOG(LogSGMessaging, Verbose, TEXT("Removing %s as a subscriber for %s messages"), *Subscriber->GetDebugName().ToString(), *MessageType.ToString());
 
-				break;
+					Tracer->TraceRemovedSubscription(Subscription.ToSharedRef(), bRemoveAll ? NAME_All : MessageType);
+					SubscriptionSnapshotDirty = true;
+					bEmptiedTable |= (Subscriptions->Num() == 0);
+				}
 			}
 		}
+
+		// entries that are removed here, expired, or left behind by a dead subscriber at the same address
+		SubscriberSubscriptions->RemoveAtSwap(Index);
+	}
+
+	if (SubscriberSubscriptions->Num() == 0)
+	{
+		SubscriptionsBySubscriber.Remove(Subscriber.Get());
+	}
+
+	// routing scans all topic ranges, so empty ones are dropped
+	if (bEmptiedTable && (ActiveTopicRangeSubscriptions.Num() > 0))
+	{
+		ActiveTopicRangeSubscriptions.RemoveAll([](const FSGTopicRangeSubscriptions& RangeSubscriptions) {
+			return RangeSubscriptions.Subscriptions.Num() == 0;
+		});
 	}
 }
 
 
-void FSGMessageRouter::HandleRouteMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context)
+void FSGMessageRouter::HandleRouteMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, uint64 DelayedMessageId)
 {
 	UE_LOG(LogSGMessaging, Verbose, TEXT("Routing %s message from %s"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString());
 
 	Tracer->TraceRoutedMessage(Context);
+	Capture->CaptureMessage(Context);
+	NumRoutedMessages.fetch_add(1, std::memory_order_relaxed);
 
-	// intercept routing
-	auto& Interceptors = ActiveInterceptors.FindOrAdd(Context->GetMessageType());
+	// drop stale messages before anybody spends time on them
+	if (Context->IsExpired(CurrentTime))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping expired %s message"), *Context->GetMessageType().ToString());
+		Statistics->CountExpiredMessage(Context->GetMessageType());
+
+		return;
+	}
 
-	for (auto& Interceptor : Interceptors)
+	// retries and resent messages cost one lookup instead of a fan-out
+	uint64 DeduplicationKey = 0;
+
+	if (SGMessageDeduplication::GetDeduplicationKey(*Context, DeduplicationKey) && !DeduplicationWindow.Add(DeduplicationKey, FSGMessageClock::Milliseconds()))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping duplicate %s message from %s"), *Context->GetMessageType().ToString(), *Context->GetSender().ToString());
+		Statistics->CountDuplicateMessage();
+
+		return;
+	}
+
+	// intercept routing
+	if (ActiveInterceptors.Num() > 0)
 	{
-		if (Interceptor->InterceptMessage(Context))
+		if (const auto Interceptors = ActiveInterceptors.Find(Context->GetMessageType()))
 		{
-			UE_LOG(LogSGMessaging, Verbose, TEXT("Message was intercepted by %s"), *Interceptor->GetDebugName().ToString());
+			for (auto& Interceptor : *Interceptors)
+			{
+				if (Interceptor->InterceptMessage(Context))
+				{
+					UE_LOG(LogSGMessaging, Verbose, TEXT("Message was intercepted by %s"), *Interceptor->GetDebugName().ToString());
 
-			Tracer->TraceInterceptedMessage(Context, Interceptor.ToSharedRef());
+					Tracer->TraceInterceptedMessage(Context, Interceptor.ToSharedRef());
 
-			return;
+					return;
+				}
+			}
 		}
 	}
 
 	// dispatch the message
 	if (bAllowDelayedMessaging && (Context->GetTimeSent() > CurrentTime))
 	{
+		// a message that expires before it is due could only ever be dropped, so don't keep it around
+		if (Context->IsExpired(Context->GetTimeSent()))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping delayed %s message, it expires before it is due"), *Context->GetMessageType().ToString());
+			Statistics->CountExpiredMessage(Context->GetMessageType());
+
+			return;
+		}
+
 		UE_LOG(LogSGMessaging, Verbose, TEXT("Queued message for dispatch"));
 
-		DelayedMessages.HeapPush(FSGDelayedMessage(Context, ++DelayedMessagesSequence));
+		// convert the wall clock send time into a monotonic tick, rounding up so messages are never early
+		const double DelayMilliseconds = (Context->GetTimeSent() - CurrentTime).GetTotalMilliseconds();
+		const uint64 ExpirationTick = FSGMessageClock::Milliseconds() + (uint64)FMath::CeilToDouble(DelayMilliseconds);
+
+		DelayedMessages.Add((DelayedMessageId != 0) ? DelayedMessageId : AllocateDelayedMessageId(), ExpirationTick, Context);
 	}
 	else
 	{
@@ -425,6 +2314,145 @@ void FSGMessageRouter::HandleRouteMessage(TSharedRef<ISGMessageContext, ESPMode:
 	}
 }
 
+void FSGMessageRouter::HandleCancelDelayedMessage(uint64 DelayedMessageId)
+{
+	if (PeriodicMessages.Remove(DelayedMessageId) > 0)
+	{
+		DelayedMessages.Remove(DelayedMessageId);
+
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Cancelled periodic message %llu"), DelayedMessageId);
+	}
+	else if (DelayedMessages.Remove(DelayedMessageId))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Cancelled delayed message %llu"), DelayedMessageId);
+	}
+}
+
+void FSGMessageRouter::HandleAddPeriodicMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, uint64 DelayedMessageId, uint64 IntervalTicks)
+{
+	FSGPeriodicMessage PeriodicMessage;
+	{
+		PeriodicMessage.Context = Context;
+		PeriodicMessage.IntervalTicks = IntervalTicks;
+		PeriodicMessage.DueTick = FSGMessageClock::Milliseconds() + IntervalTicks;
+	}
+
+	DelayedMessages.AddTimeout(DelayedMessageId, PeriodicMessage.DueTick);
+	PeriodicMessages.Add(DelayedMessageId, MoveTemp(PeriodicMessage));
+}
+
+void FSGMessageRouter::HandleRedeliverMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, FSGMessageAddress Recipient, uint64 DelayTicks)
+{
+	if (!bAllowDelayedMessaging || (DelayTicks == 0))
+	{
+		RedeliverToRecipient(Context, Recipient);
+
+		return;
+	}
+
+	FSGRedelivery Redelivery;
+	{
+		Redelivery.Context = Context;
+		Redelivery.Recipient = Recipient;
+	}
+
+	const uint64 TimerId = AllocateDelayedMessageId();
+
+	DelayedMessages.AddTimeout(TimerId, FSGMessageClock::Milliseconds() + DelayTicks);
+	Redeliveries.Add(TimerId, MoveTemp(Redelivery));
+}
+
+void FSGMessageRouter::HandleUpdateSpatialInterests(TArray<FSGMessageSpatialInterest>& SpatialInterests)
+{
+	for (const FSGMessageSpatialInterest& Interest : SpatialInterests)
+	{
+		auto Subscriber = Interest.Subscriber.Pin();
+
+		// stale subscribers are removed when a message finds them
+		if (!Subscriber.IsValid())
+		{
+			continue;
+		}
+
+		if (Interest.Radius < 0.0f)
+		{
+			FSGMessageSpatialIndex* SpatialIndex = SpatialIndices.Find(Interest.MessageType);
+
+			if ((SpatialIndex != nullptr) && SpatialIndex->Remove(Subscriber.Get()) && (SpatialIndex->Num() == 0))
+			{
+				SpatialIndices.Remove(Interest.MessageType);
+				SubscriptionSnapshotDirty = true;
+			}
+
+			continue;
+		}
+
+		FSGMessageSpatialIndex* SpatialIndex = SpatialIndices.Find(Interest.MessageType);
+
+		if (SpatialIndex == nullptr)
+		{
+			SpatialIndex = &SpatialIndices.Add(Interest.MessageType, FSGMessageSpatialIndex(SpatialCellSize));
+			SubscriptionSnapshotDirty = true;
+		}
+
+		SpatialIndex->Update(Subscriber.ToSharedRef(), Interest.Location, Interest.Radius);
+	}
+}
+
+void FSGMessageRouter::HandleAddRequestTimeout(TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request)
+{
+	// the reply may have overtaken the timeout
+	if (!Request->IsCompleted())
+	{
+		DelayedMessages.AddTimeout(Request->GetTimerId(), Request->GetTimeoutTick());
+		RequestTimeouts.Add(Request->GetTimerId(), Request);
+	}
+}
+
+void FSGMessageRouter::HandleAddAddressGroup(FSGMessageAddress Group, FName GroupName)
+{
+	UE_LOG(LogSGMessaging, Verbose, TEXT("Adding address group %s on %s"), *GroupName.ToString(), *Group.ToString());
+
+	AddressGroups.FindOrAdd(Group).Name = GroupName;
+}
+
+void FSGMessageRouter::HandleAddAddressGroupMembers(FSGMessageAddress Group, const TArray<FSGMessageAddress>& Members)
+{
+	FSGAddressGroup* AddressGroup = AddressGroups.Find(Group);
+
+	if (AddressGroup == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Ignoring members for unknown address group %s"), *Group.ToString());
+
+		return;
+	}
+
+	for (const FSGMessageAddress& Member : Members)
+	{
+		AddressGroup->Members.AddUnique(Member);
+	}
+
+	AddressGroup->ResolvedGeneration = 0;
+}
+
+void FSGMessageRouter::HandleRemoveAddressGroup(FSGMessageAddress Group)
+{
+	AddressGroups.Remove(Group);
+}
+
+void FSGMessageRouter::HandleRemoveAddressGroupMembers(FSGMessageAddress Group, const TArray<FSGMessageAddress>& Members)
+{
+	if (FSGAddressGroup* AddressGroup = AddressGroups.Find(Group))
+	{
+		for (const FSGMessageAddress& Member : Members)
+		{
+			AddressGroup->Members.RemoveSingle(Member);
+		}
+
+		AddressGroup->ResolvedGeneration = 0;
+	}
+}
+
 void FSGMessageRouter::HandleAddListener(TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> ListenerPtr)
 {
 	ActiveRegistrationListeners.AddUnique(ListenerPtr);
@@ -436,6 +2464,75 @@ void FSGMessageRouter::HandleRemoveListener(TWeakPtr<ISGBusListener, ESPMode::Th
 }
 
 void FSGMessageRouter::NotifyRegistration(const FSGMessageAddress& Address, ESGMessageBusNotification Notification)
+{
+	if (!bNotifyRegistrations || (ActiveRegistrationListeners.Num() == 0))
+	{
+		return;
+	}
+
+	if (const ESGMessageBusNotification* PendingNotification = PendingRegistrations.Find(Address))
+	{
+		// an address that comes and goes within a pass doesn't concern the listeners
+		if (*PendingNotification != Notification)
+		{
+			PendingRegistrations.Remove(Address);
+		}
+
+		return;
+	}
+
+	PendingRegistrations.Add(Address, Notification);
+}
+
+void FSGMessageRouter::FlushRegistrationNotifications()
+{
+	if (PendingRegistrations.Num() == 0)
+	{
+		return;
+	}
+
+	// all listeners share the batch
+	const TSharedRef<TArray<FSGMessageBusNotification>, ESPMode::ThreadSafe> Notifications = MakeShared<TArray<FSGMessageBusNotification>, ESPMode::ThreadSafe>();
+	Notifications->Reserve(PendingRegistrations.Num());
+
+	for (const auto& RegistrationPair : PendingRegistrations)
+	{
+		Notifications->Add(FSGMessageBusNotification{ RegistrationPair.Value, RegistrationPair.Key });
+	}
+
+	PendingRegistrations.Reset();
+
+	for (auto It = ActiveRegistrationListeners.CreateIterator(); It; ++It)
+	{
+		auto Listener = It->Pin();
+		if (Listener.IsValid())
+		{
+			ENamedThreads::Type ListenerThread = Listener->GetListenerThread();
+
+			if (ListenerThread == ENamedThreads::AnyThread)
+			{
+				Listener->NotifyRegistrations(*Notifications);
+			}
+			else
+			{
+				SGMessageDispatchTask::LaunchOnNamedThread(TEXT("FSGMessageRouter.RegistrationNotification"), ListenerThread, ESGMessagePriority::Normal,
+					[ListenerPtr = TWeakPtr<ISGBusListener, ESPMode::ThreadSafe>(Listener), Notifications]()
+					{
+						if (const TSharedPtr<ISGBusListener, ESPMode::ThreadSafe> PinnedListener = ListenerPtr.Pin())
+						{
+							PinnedListener->NotifyRegistrations(*Notifications);
+						}
+					});
+			}
+		}
+		else
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+void FSGMessageRouter::NotifyBackpressure(const FSGMessageBackpressureEvent& Event)
 {
 	for (auto It = ActiveRegistrationListeners.CreateIterator(); It; ++It)
 	{
@@ -446,11 +2543,18 @@ void FSGMessageRouter::NotifyRegistration(const FSGMessageAddress& Address, ESGM
 
 			if (ListenerThread == ENamedThreads::AnyThread)
 			{
-				Listener->NotifyRegistration(Address, Notification);
+				Listener->NotifyBackpressure(Event);
 			}
 			else
 			{
-				TGraphTask<FSGBusNotificationDispatchTask>::CreateTask().ConstructAndDispatchWhenReady(ListenerThread, Listener, Address, Notification);
+				SGMessageDispatchTask::LaunchOnNamedThread(TEXT("FSGMessageRouter.BackpressureNotification"), ListenerThread, ESGMessagePriority::High,
+					[ListenerPtr = TWeakPtr<ISGBusListener, ESPMode::ThreadSafe>(Listener), Event]()
+					{
+						if (const TSharedPtr<ISGBusListener, ESPMode::ThreadSafe> PinnedListener = ListenerPtr.Pin())
+						{
+							PinnedListener->NotifyBackpressure(Event);
+						}
+					});
 			}
 		}
 		else
@@ -458,4 +2562,4 @@ void FSGMessageRouter::NotifyRegistration(const FSGMessageAddress& Address, ESGM
 			It.RemoveCurrent();
 		}
 	}
-}
\ No newline at end of file
+}
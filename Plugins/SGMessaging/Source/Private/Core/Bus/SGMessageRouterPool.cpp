@@ -0,0 +1,331 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageRouterPool.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageRouter.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+namespace SGMessageRouterPool
+{
+	/** Longest time a worker spends on one router before moving on (in seconds). */
+	constexpr double TimeSlice = 0.001;
+
+	/** Longest time a parked worker sleeps (in milliseconds). */
+	constexpr uint64 MaxWaitTicks = 100;
+}
+
+
+/**
+ * Implements the runnable of a pool worker.
+ */
+class FSGMessageRouterPool::FWorker
+	: public FRunnable
+{
+public:
+
+	explicit FWorker(FSGMessageRouterPool& InPool)
+		: Pool(InPool)
+		, bStopping(false)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Pool.RunWorker(bStopping);
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		bStopping.store(true);
+		Pool.WorkEvent->Trigger();
+	}
+
+private:
+
+	/** Holds the pool. */
+	FSGMessageRouterPool& Pool;
+
+	/** Holds a flag indicating that the worker is stopping (each worker has its own, so that the pool can restart). */
+	std::atomic<bool> bStopping;
+};
+
+
+/* FSGMessageRouterPool structors
+ *****************************************************************************/
+
+FSGMessageRouterPool& FSGMessageRouterPool::Get()
+{
+	static FSGMessageRouterPool Pool;
+
+	return Pool;
+}
+
+
+FSGMessageRouterPool::FSGMessageRouterPool()
+	: NextBusIndex(0)
+	, WorkEvent(FPlatformProcess::GetSynchEventFromPool(true))
+	, NumParkedWorkers(0)
+	, Quantum(256)
+{
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		Quantum = FMath::Max(SGMessagingSettings->RouterPoolQuantum, 1);
+	}
+}
+
+
+FSGMessageRouterPool::~FSGMessageRouterPool()
+{
+	TArray<FRunnableThread*> Threads;
+	TArray<TUniquePtr<FWorker>> Runnables;
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Threads = MoveTemp(WorkerThreads);
+		Runnables = MoveTemp(Workers);
+	}
+
+	StopWorkers(Threads, Runnables);
+
+	FPlatformProcess::ReturnSynchEventToPool(WorkEvent);
+	WorkEvent = nullptr;
+}
+
+
+/* FSGMessageRouterPool interface
+ *****************************************************************************/
+
+void FSGMessageRouterPool::AddBus(const void* Owner, TArrayView<FSGMessageRouter* const> Routers)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	FPooledBus& Bus = Buses.AddDefaulted_GetRef();
+	Bus.Owner = Owner;
+
+	for (FSGMessageRouter* Router : Routers)
+	{
+		Router->SetPool(this);
+		Bus.Routers.AddDefaulted_GetRef().Router = Router;
+	}
+
+	if (WorkerThreads.Num() == 0)
+	{
+		int32 PoolSize = 2;
+
+		if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+		{
+			PoolSize = FMath::Clamp(SGMessagingSettings->RouterPoolSize, 1, 16);
+		}
+
+		for (int32 WorkerIndex = 0; WorkerIndex < PoolSize; ++WorkerIndex)
+		{
+			TUniquePtr<FWorker>& Worker = Workers.Add_GetRef(MakeUnique<FWorker>(*this));
+			const FString ThreadName = FString::Printf(TEXT("FSGMessageRouterPool.Worker%d"), WorkerIndex);
+
+			if (FRunnableThread* WorkerThread = FRunnableThread::Create(Worker.Get(), *ThreadName, 128 * 1024, TPri_Normal, FPlatformAffinity::GetPoolThreadMask()))
+			{
+				WorkerThreads.Add(WorkerThread);
+			}
+		}
+
+		UE_LOG(LogSGMessaging, Log, TEXT("Started %d message router pool workers"), WorkerThreads.Num());
+	}
+
+	WorkEvent->Trigger();
+}
+
+
+void FSGMessageRouterPool::RemoveBus(const void* Owner)
+{
+	TArray<FRunnableThread*> Threads;
+	TArray<TUniquePtr<FWorker>> Runnables;
+
+	for (;;)
+	{
+		{
+			FScopeLock Lock(&CriticalSection);
+
+			const int32 BusIndex = Buses.IndexOfByPredicate([Owner](const FPooledBus& Bus) { return Bus.Owner == Owner; });
+
+			if (BusIndex == INDEX_NONE)
+			{
+				return;
+			}
+
+			const bool bClaimed = Buses[BusIndex].Routers.ContainsByPredicate([](const FPooledRouter& PooledRouter) { return PooledRouter.bClaimed; });
+
+			if (!bClaimed)
+			{
+				for (FPooledRouter& PooledRouter : Buses[BusIndex].Routers)
+				{
+					PooledRouter.Router->SetPool(nullptr);
+				}
+
+				Buses.RemoveAt(BusIndex);
+
+				// idle workers aren't kept around without buses
+				if (Buses.Num() == 0)
+				{
+					Threads = MoveTemp(WorkerThreads);
+					Runnables = MoveTemp(Workers);
+				}
+
+				break;
+			}
+		}
+
+		// a worker is processing one of the routers, which takes at most a time slice
+		FPlatformProcess::Yield();
+	}
+
+	StopWorkers(Threads, Runnables);
+}
+
+
+/* FSGMessageRouterPool implementation
+ *****************************************************************************/
+
+FSGMessageRouter* FSGMessageRouterPool::ClaimRouter(uint64 NowTick, uint64& OutWaitTicks)
+{
+	for (int32 BusOffset = 0; BusOffset < Buses.Num(); ++BusOffset)
+	{
+		const int32 BusIndex = (NextBusIndex + BusOffset) % Buses.Num();
+		FPooledBus& Bus = Buses[BusIndex];
+
+		for (int32 RouterOffset = 0; RouterOffset < Bus.Routers.Num(); ++RouterOffset)
+		{
+			const int32 RouterIndex = (Bus.NextRouterIndex + RouterOffset) % Bus.Routers.Num();
+			FPooledRouter& PooledRouter = Bus.Routers[RouterIndex];
+
+			if (PooledRouter.bClaimed)
+			{
+				continue;
+			}
+
+			if ((PooledRouter.Router->GetCommandQueueDepth() > 0) || (NowTick >= PooledRouter.DueTick))
+			{
+				PooledRouter.bClaimed = true;
+				Bus.NextRouterIndex = (RouterIndex + 1) % Bus.Routers.Num();
+				NextBusIndex = (BusIndex + 1) % Buses.Num();
+
+				return PooledRouter.Router;
+			}
+
+			OutWaitTicks = FMath::Min(OutWaitTicks, PooledRouter.DueTick - NowTick);
+		}
+	}
+
+	return nullptr;
+}
+
+
+void FSGMessageRouterPool::ReleaseRouter(FSGMessageRouter* Router, uint64 DueTick)
+{
+	for (FPooledBus& Bus : Buses)
+	{
+		for (FPooledRouter& PooledRouter : Bus.Routers)
+		{
+			if (PooledRouter.Router == Router)
+			{
+				PooledRouter.bClaimed = false;
+				PooledRouter.DueTick = DueTick;
+
+				return;
+			}
+		}
+	}
+}
+
+
+bool FSGMessageRouterPool::HasQueuedCommands() const
+{
+	for (const FPooledBus& Bus : Buses)
+	{
+		for (const FPooledRouter& PooledRouter : Bus.Routers)
+		{
+			if (!PooledRouter.bClaimed && (PooledRouter.Router->GetCommandQueueDepth() > 0))
+			{
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+
+void FSGMessageRouterPool::RunWorker(const std::atomic<bool>& bStopping)
+{
+	const uint64 TimeSliceCycles = (uint64)(SGMessageRouterPool::TimeSlice / FPlatformTime::GetSecondsPerCycle64());
+
+	while (!bStopping.load())
+	{
+		FSGMessageRouter* Router = nullptr;
+		uint64 WaitTicks = SGMessageRouterPool::MaxWaitTicks;
+		{
+			FScopeLock Lock(&CriticalSection);
+			Router = ClaimRouter(FSGMessageClock::Milliseconds(), WaitTicks);
+		}
+
+		if (Router != nullptr)
+		{
+			// the claim makes this worker the router's only thread until it is released
+			Router->ProcessFrame(FPlatformTime::Cycles64() + TimeSliceCycles, Quantum);
+
+			const uint64 DueTick = FSGMessageClock::Milliseconds() + (uint64)Router->GetIdleWaitTime().GetTotalMilliseconds();
+
+			FScopeLock Lock(&CriticalSection);
+			ReleaseRouter(Router, DueTick);
+
+			continue;
+		}
+
+		// publish the parked worker before checking for work again; routers add work before checking
+		// the count, so either they see it and trigger the event, or the worker sees their work
+		WorkEvent->Reset();
+		NumParkedWorkers.fetch_add(1, std::memory_order_seq_cst);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+
+		bool bHasWork = false;
+		{
+			FScopeLock Lock(&CriticalSection);
+			bHasWork = HasQueuedCommands();
+		}
+
+		if (!bHasWork && !bStopping.load())
+		{
+			WorkEvent->Wait(FTimespan::FromMilliseconds((double)WaitTicks));
+		}
+
+		NumParkedWorkers.fetch_sub(1, std::memory_order_relaxed);
+	}
+}
+
+
+void FSGMessageRouterPool::StopWorkers(TArray<FRunnableThread*>& Threads, TArray<TUniquePtr<FWorker>>& Runnables)
+{
+	// tell all workers first, so that they wind down in parallel
+	for (const TUniquePtr<FWorker>& Runnable : Runnables)
+	{
+		Runnable->Stop();
+	}
+
+	for (FRunnableThread* Thread : Threads)
+	{
+		Thread->Kill(true);
+		delete Thread;
+	}
+
+	Threads.Empty();
+	Runnables.Empty();
+}
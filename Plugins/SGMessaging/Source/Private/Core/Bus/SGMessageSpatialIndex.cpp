@@ -0,0 +1,153 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageSpatialIndex.h"
+
+
+/* FSGMessageSpatialIndex structors
+ *****************************************************************************/
+
+FSGMessageSpatialIndex::FSGMessageSpatialIndex(float InCellSize)
+	: InvCellSize(1.0 / FMath::Max((double)InCellSize, 1.0))
+{ }
+
+
+/* FSGMessageSpatialIndex interface
+ *****************************************************************************/
+
+void FSGMessageSpatialIndex::Update(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FVector& Location, float Radius)
+{
+	const ISGMessageReceiver* Handle = &Subscriber.Get();
+	const double ClampedRadius = FMath::Max((double)Radius, 0.0);
+	const FIntPoint MinCell = GetCell(Location - FVector(ClampedRadius));
+	const FIntPoint MaxCell = GetCell(Location + FVector(ClampedRadius));
+	const bool bIsLarge = ((int64)(MaxCell.X - MinCell.X + 1) * (int64)(MaxCell.Y - MinCell.Y + 1)) > MaxCellsPerEntry;
+
+	FEntry* Entry = Entries.Find(Handle);
+
+	if (Entry != nullptr)
+	{
+		// subscribers mostly move within the cells they are linked into already
+		if ((Entry->MinCell != MinCell) || (Entry->MaxCell != MaxCell) || (Entry->bIsLarge != bIsLarge))
+		{
+			UnlinkEntry(Handle, *Entry);
+			Entry = nullptr;
+		}
+		else
+		{
+			Entry->Subscriber = Subscriber;
+		}
+	}
+
+	if (Entry == nullptr)
+	{
+		Entry = &Entries.FindOrAdd(Handle);
+		Entry->Subscriber = Subscriber;
+		Entry->MinCell = MinCell;
+		Entry->MaxCell = MaxCell;
+		Entry->bIsLarge = bIsLarge;
+
+		LinkEntry(Handle, *Entry);
+	}
+
+	Entry->Location = Location;
+	Entry->RadiusSquared = FMath::Square(ClampedRadius);
+}
+
+
+bool FSGMessageSpatialIndex::Remove(const ISGMessageReceiver* Handle)
+{
+	const FEntry* Entry = Entries.Find(Handle);
+
+	if (Entry == nullptr)
+	{
+		return false;
+	}
+
+	UnlinkEntry(Handle, *Entry);
+	Entries.Remove(Handle);
+
+	return true;
+}
+
+
+int32 FSGMessageSpatialIndex::RemoveStaleSubscribers()
+{
+	int32 NumRemoved = 0;
+
+	for (auto It = Entries.CreateIterator(); It; ++It)
+	{
+		if (!It.Value().Subscriber.IsValid())
+		{
+			UnlinkEntry(It.Key(), It.Value());
+			It.RemoveCurrent();
+			++NumRemoved;
+		}
+	}
+
+	return NumRemoved;
+}
+
+
+SIZE_T FSGMessageSpatialIndex::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize() + Cells.GetAllocatedSize() + LargeEntries.GetAllocatedSize();
+
+	for (const auto& CellPair : Cells)
+	{
+		Size += CellPair.Value.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+
+/* FSGMessageSpatialIndex implementation
+ *****************************************************************************/
+
+void FSGMessageSpatialIndex::LinkEntry(const ISGMessageReceiver* Handle, const FEntry& Entry)
+{
+	if (Entry.bIsLarge)
+	{
+		LargeEntries.Add(Handle);
+
+		return;
+	}
+
+	for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; ++Y)
+	{
+		for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; ++X)
+		{
+			Cells.FindOrAdd(FIntPoint(X, Y)).Add(Handle);
+		}
+	}
+}
+
+
+void FSGMessageSpatialIndex::UnlinkEntry(const ISGMessageReceiver* Handle, const FEntry& Entry)
+{
+	if (Entry.bIsLarge)
+	{
+		LargeEntries.RemoveSwap(Handle);
+
+		return;
+	}
+
+	for (int32 Y = Entry.MinCell.Y; Y <= Entry.MaxCell.Y; ++Y)
+	{
+		for (int32 X = Entry.MinCell.X; X <= Entry.MaxCell.X; ++X)
+		{
+			const FIntPoint Cell(X, Y);
+
+			if (TArray<const ISGMessageReceiver*>* Handles = Cells.Find(Cell))
+			{
+				Handles->RemoveSwap(Handle);
+
+				// don't keep the cells of areas that everybody left
+				if (Handles->Num() == 0)
+				{
+					Cells.Remove(Cell);
+				}
+			}
+		}
+	}
+}
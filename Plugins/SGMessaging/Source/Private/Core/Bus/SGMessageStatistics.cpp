@@ -0,0 +1,17 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageStatistics.h"
+
+
+/* FSGMessageInboxStatistics static initialization
+ *****************************************************************************/
+
+std::atomic<int64> FSGMessageInboxStatistics::NumQueuedMessages(0);
+std::atomic<int64> FSGMessageInboxStatistics::NumDroppedMessages(0);
+
+
+/* FSGMessageCompressionCounters static initialization
+ *****************************************************************************/
+
+FCriticalSection FSGMessageCompressionCounters::CriticalSection;
+TMap<FName, FSGMessageCompressionStatistics> FSGMessageCompressionCounters::Statistics;
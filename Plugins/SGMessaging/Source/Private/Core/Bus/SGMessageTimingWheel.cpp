@@ -0,0 +1,324 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Bus/SGMessageTimingWheel.h"
+
+
+/* FSGMessageTimingWheel structors
+ *****************************************************************************/
+
+FSGMessageTimingWheel::FSGMessageTimingWheel()
+	: CurrentTick(FSGMessageClock::Milliseconds())
+{ }
+
+
+/* FSGMessageTimingWheel interface
+ *****************************************************************************/
+
+void FSGMessageTimingWheel::Add(uint64 Id, uint64 ExpirationTick, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	AddEntry(Id, ExpirationTick, Context);
+}
+
+
+void FSGMessageTimingWheel::AddTimeout(uint64 Id, uint64 ExpirationTick)
+{
+	AddEntry(Id, ExpirationTick, nullptr);
+}
+
+
+void FSGMessageTimingWheel::Advance(uint64 NowTick, TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutExpired, TArray<uint64>& OutExpiredTimeouts)
+{
+	while (CurrentTick < NowTick)
+	{
+		// nothing pending, so just catch up
+		if (Entries.Num() == 0)
+		{
+			CurrentTick = NowTick;
+
+			break;
+		}
+
+		++CurrentTick;
+
+		// cascade from the highest wrapping level down, so that entries moving down can cascade again
+		int32 WrappedLevels = 0;
+
+		while ((WrappedLevels + 1 < NumLevels) && ((CurrentTick & ((1ull << (SlotBits * (WrappedLevels + 1))) - 1)) == 0))
+		{
+			++WrappedLevels;
+		}
+
+		for (int32 Level = WrappedLevels; Level > 0; --Level)
+		{
+			Cascade(Level);
+		}
+
+		// expire the current lowest level bucket
+		FBucket& Bucket = Buckets[CurrentTick & SlotMask];
+
+		if (Bucket.Head == INDEX_NONE)
+		{
+			continue;
+		}
+
+		ExpiringEntries.Reset();
+
+		for (int32 EntryIndex = Bucket.Head; EntryIndex != INDEX_NONE; EntryIndex = Entries[EntryIndex].Next)
+		{
+			ExpiringEntries.Add(EntryIndex);
+		}
+
+		Bucket.Head = INDEX_NONE;
+		Bucket.Tail = INDEX_NONE;
+
+		// cascaded entries may be out of order, so restore insertion order
+		ExpiringEntries.Sort([this](int32 A, int32 B) { return Entries[A].Id < Entries[B].Id; });
+
+		for (int32 EntryIndex : ExpiringEntries)
+		{
+			FEntry& Entry = Entries[EntryIndex];
+
+			if (Entry.Context.IsValid())
+			{
+				UnindexRecipients(EntryIndex);
+				OutExpired.Add(MoveTemp(Entry.Context));
+			}
+			else
+			{
+				OutExpiredTimeouts.Add(Entry.Id);
+			}
+
+			IdToEntry.Remove(Entry.Id);
+			Entries.RemoveAt(EntryIndex);
+		}
+	}
+}
+
+
+uint64 FSGMessageTimingWheel::GetTicksUntilNextAdvance(uint64 MaxTicks) const
+{
+	if (Entries.Num() == 0)
+	{
+		return MaxTicks;
+	}
+
+	// scan the rest of the current lowest level rotation
+	for (uint64 Tick = CurrentTick + 1; Tick <= CurrentTick + MaxTicks; ++Tick)
+	{
+		if ((Buckets[Tick & SlotMask].Head != INDEX_NONE) || ((Tick & SlotMask) == 0))
+		{
+			return Tick - CurrentTick;
+		}
+	}
+
+	return MaxTicks;
+}
+
+
+SIZE_T FSGMessageTimingWheel::GetAllocatedSize() const
+{
+	SIZE_T Size = Entries.GetAllocatedSize() + IdToEntry.GetAllocatedSize() + RecipientIndex.GetAllocatedSize() + ExpiringEntries.GetAllocatedSize();
+
+	for (const auto& RecipientPair : RecipientIndex)
+	{
+		Size += RecipientPair.Value.GetAllocatedSize();
+	}
+
+	return Size;
+}
+
+
+bool FSGMessageTimingWheel::Remove(uint64 Id)
+{
+	int32 EntryIndex = INDEX_NONE;
+
+	if (!IdToEntry.RemoveAndCopyValue(Id, EntryIndex))
+	{
+		return false;
+	}
+
+	Unlink(EntryIndex);
+	UnindexRecipients(EntryIndex);
+	Entries.RemoveAt(EntryIndex);
+
+	return true;
+}
+
+
+int32 FSGMessageTimingWheel::RemoveByRecipient(const FSGMessageAddress& Recipient, TFunctionRef<bool(const ISGMessageContext&)> ShouldRemove, TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutRemoved)
+{
+	const TArray<uint64>* Ids = RecipientIndex.Find(Recipient);
+
+	if (Ids == nullptr)
+	{
+		return 0;
+	}
+
+	// removing entries changes the index, so work on a copy
+	const TArray<uint64> RecipientIds = *Ids;
+	int32 NumRemoved = 0;
+
+	for (const uint64 Id : RecipientIds)
+	{
+		const int32* EntryIndex = IdToEntry.Find(Id);
+
+		if ((EntryIndex == nullptr) || !ShouldRemove(*Entries[*EntryIndex].Context))
+		{
+			continue;
+		}
+
+		OutRemoved.Add(Entries[*EntryIndex].Context);
+		Remove(Id);
+		++NumRemoved;
+	}
+
+	return NumRemoved;
+}
+
+
+/* FSGMessageTimingWheel implementation
+ *****************************************************************************/
+
+void FSGMessageTimingWheel::AddEntry(uint64 Id, uint64 ExpirationTick, const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	FEntry Entry;
+	{
+		Entry.Context = Context;
+		Entry.Id = Id;
+		Entry.ExpirationTick = FMath::Max(ExpirationTick, CurrentTick + 1);
+		Entry.Prev = INDEX_NONE;
+		Entry.Next = INDEX_NONE;
+		Entry.Bucket = INDEX_NONE;
+	}
+
+	const int32 EntryIndex = Entries.Add(MoveTemp(Entry));
+
+	IdToEntry.Add(Id, EntryIndex);
+	Link(EntryIndex);
+	IndexRecipients(EntryIndex);
+}
+
+
+void FSGMessageTimingWheel::Link(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+
+	const uint64 MaxDelta = (1ull << (SlotBits * NumLevels)) - 1;
+	const uint64 Delta = FMath::Min(Entry.ExpirationTick - FMath::Min(Entry.ExpirationTick, CurrentTick), MaxDelta);
+
+	// timers beyond the wheel's range are parked at the farthest top level slot
+	const uint64 PlacementTick = CurrentTick + Delta;
+
+	int32 Level = 0;
+
+	while ((Level + 1 < NumLevels) && (Delta >= (1ull << (SlotBits * (Level + 1)))))
+	{
+		++Level;
+	}
+
+	Entry.Bucket = Level * NumSlots + (int32)((PlacementTick >> (SlotBits * Level)) & SlotMask);
+
+	FBucket& Bucket = Buckets[Entry.Bucket];
+
+	Entry.Prev = Bucket.Tail;
+	Entry.Next = INDEX_NONE;
+
+	if (Bucket.Tail != INDEX_NONE)
+	{
+		Entries[Bucket.Tail].Next = EntryIndex;
+	}
+	else
+	{
+		Bucket.Head = EntryIndex;
+	}
+
+	Bucket.Tail = EntryIndex;
+}
+
+
+void FSGMessageTimingWheel::Unlink(int32 EntryIndex)
+{
+	FEntry& Entry = Entries[EntryIndex];
+	FBucket& Bucket = Buckets[Entry.Bucket];
+
+	if (Entry.Prev != INDEX_NONE)
+	{
+		Entries[Entry.Prev].Next = Entry.Next;
+	}
+	else
+	{
+		Bucket.Head = Entry.Next;
+	}
+
+	if (Entry.Next != INDEX_NONE)
+	{
+		Entries[Entry.Next].Prev = Entry.Prev;
+	}
+	else
+	{
+		Bucket.Tail = Entry.Prev;
+	}
+
+	Entry.Prev = INDEX_NONE;
+	Entry.Next = INDEX_NONE;
+	Entry.Bucket = INDEX_NONE;
+}
+
+
+void FSGMessageTimingWheel::Cascade(int32 Level)
+{
+	FBucket& Bucket = Buckets[Level * NumSlots + (int32)((CurrentTick >> (SlotBits * Level)) & SlotMask)];
+	int32 EntryIndex = Bucket.Head;
+
+	Bucket.Head = INDEX_NONE;
+	Bucket.Tail = INDEX_NONE;
+
+	while (EntryIndex != INDEX_NONE)
+	{
+		const int32 NextIndex = Entries[EntryIndex].Next;
+
+		Link(EntryIndex);
+		EntryIndex = NextIndex;
+	}
+}
+
+
+void FSGMessageTimingWheel::IndexRecipients(int32 EntryIndex)
+{
+	const FEntry& Entry = Entries[EntryIndex];
+
+	if (!Entry.Context.IsValid())
+	{
+		return;
+	}
+
+	// published messages have no recipients and are never indexed
+	for (const FSGMessageAddress& Recipient : Entry.Context->GetRecipients())
+	{
+		RecipientIndex.FindOrAdd(Recipient).AddUnique(Entry.Id);
+	}
+}
+
+
+void FSGMessageTimingWheel::UnindexRecipients(int32 EntryIndex)
+{
+	const FEntry& Entry = Entries[EntryIndex];
+
+	if (!Entry.Context.IsValid())
+	{
+		return;
+	}
+
+	for (const FSGMessageAddress& Recipient : Entry.Context->GetRecipients())
+	{
+		if (TArray<uint64>* Ids = RecipientIndex.Find(Recipient))
+		{
+			Ids->RemoveSwap(Entry.Id);
+
+			if (Ids->Num() == 0)
+			{
+				RecipientIndex.Remove(Recipient);
+			}
+		}
+	}
+}
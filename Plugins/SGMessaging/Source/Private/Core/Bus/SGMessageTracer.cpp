@@ -1,274 +1,418 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "Core/Bus/SGMessageTracer.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageInsights.h"
+#include "Core/Bus/SGMessageStatistics.h"
 #include "Containers/Ticker.h"
 #include "HAL/PlatformProcess.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
 #include "Core/Interface/ISGMessageInterceptor.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 #include "Core/Interface/ISGMessageTracerBreakpoint.h"
+#include "Core/Message/SGMessageTagRegistry.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Settings/SGMessagingSettings.h"
 
-/* FSGMessageTracer structors
- *****************************************************************************/
 
-FSGMessageTracer::FSGMessageTracer()
-	: Breaking(false)
-	, ResetPending(false)
-	, Running(false)
+namespace SGMessageTracer
 {
-	ContinueEvent = FPlatformProcess::GetSynchEventFromPool();
-	TickDelegateHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSGMessageTracer::Tick), 0.0f);
-}
+	/** Longest time the records of a message that isn't known yet are retried (in seconds). */
+	constexpr double MaxDeferralSeconds = 1.0;
 
+	/** Largest number of records that wait for their message to become known. */
+	constexpr int32 MaxDeferredRecords = 65536;
 
-FSGMessageTracer::~FSGMessageTracer()
-{
-	FTSTicker::GetCoreTicker().RemoveTicker(TickDelegateHandle);
-	FPlatformProcess::ReturnSynchEventToPool(ContinueEvent);
-	ContinueEvent = nullptr;
+	/** Time the consumer thread waits between merges (in milliseconds). */
+	constexpr uint32 ConsumerIntervalMs = 5;
 }
 
 
-/* FSGMessageTracer interface
- *****************************************************************************/
-
-void FSGMessageTracer::TraceAddedInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
+/**
+ * Implements a thread's trace buffer, a bounded single-producer single-consumer ring of trace records.
+ */
+class FSGMessageTracer::FTraceBuffer
 {
-	double Timestamp = FPlatformTime::Seconds();
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InCapacity The minimum number of records the buffer can hold (rounded up to a power of two).
+	 */
+	explicit FTraceBuffer(uint32 InCapacity)
+		: bAbandoned(false)
+		, bOrphaned(false)
+		, Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		, Mask(Capacity - 1)
+	{
+		Records.SetNum(Capacity);
+		WritePos.store(0, std::memory_order_relaxed);
+		ReadPos.store(0, std::memory_order_relaxed);
+	}
 
-	Traces.Enqueue([=]() {
-		// create interceptor information
-		auto& InterceptorInfo = Interceptors.FindOrAdd(Interceptor->GetInterceptorId());
+public:
+
+	/**
+	 * Attempts to write a record.
+	 *
+	 * This method must only be called on the thread that owns the buffer.
+	 *
+	 * @param Record The record to write (will be moved from on success).
+	 * @return true if the record was written, false if the buffer is full.
+	 */
+	bool TryWrite(FTraceRecord&& Record)
+	{
+		const uint32 Pos = WritePos.load(std::memory_order_relaxed);
 
-		if (!InterceptorInfo.IsValid())
+		if (Pos - ReadPos.load(std::memory_order_acquire) >= Capacity)
 		{
-			InterceptorInfo = MakeShareable(new FSGMessageTracerInterceptorInfo());
+			return false;
 		}
 
-		// initialize interceptor information
-		InterceptorInfo->Name = Interceptor->GetDebugName();
-		InterceptorInfo->TimeRegistered = Timestamp;
-		InterceptorInfo->TimeUnregistered = 0;
-	});
-}
-
+		Records[Pos & Mask] = MoveTemp(Record);
+		WritePos.store(Pos + 1, std::memory_order_release);
 
-void FSGMessageTracer::TraceAddedRecipient(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
-{
-	double Timestamp = FPlatformTime::Seconds();
+		return true;
+	}
 
-	Traces.Enqueue([=]() {
-		// create endpoint information
-		TSharedPtr<FSGMessageTracerEndpointInfo>& EndpointInfo = RecipientsToEndpointInfos.FindOrAdd(Recipient->GetRecipientId());
+	/**
+	 * Reads all written records.
+	 *
+	 * This method must only be called on the consumer thread.
+	 *
+	 * @param Functor The function to call with each record (may move from the record).
+	 */
+	template<typename FunctorType>
+	void Drain(FunctorType&& Functor)
+	{
+		uint32 Pos = ReadPos.load(std::memory_order_relaxed);
+		const uint32 EndPos = WritePos.load(std::memory_order_acquire);
 
-		if (!EndpointInfo.IsValid())
+		for (; Pos != EndPos; ++Pos)
 		{
-			EndpointInfo = MakeShareable(new FSGMessageTracerEndpointInfo());
-		}
+			FTraceRecord& Record = Records[Pos & Mask];
 
-		// initialize endpoint information
-		TSharedRef<FSGMessageTracerAddressInfo> AddressInfo = MakeShareable(new FSGMessageTracerAddressInfo());
-		{
-			AddressInfo->Address = Address;
-			AddressInfo->TimeRegistered = Timestamp;
-			AddressInfo->TimeUnregistered = 0;
+			Functor(Record);
+			Record.Context.Reset();
 		}
 
-		EndpointInfo->AddressInfos.Add(Address, AddressInfo);
-		EndpointInfo->Name = Recipient->GetDebugName();
-		EndpointInfo->Remote = Recipient->IsRemote();
-
-		// add to address table
-		AddressesToEndpointInfos.Add(Address, EndpointInfo);
-	});
-}
+		ReadPos.store(Pos, std::memory_order_release);
+	}
 
+	/** Checks whether the buffer holds no records. */
+	bool IsEmpty() const
+	{
+		return ReadPos.load(std::memory_order_acquire) == WritePos.load(std::memory_order_acquire);
+	}
 
-void FSGMessageTracer::TraceAddedSubscription(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription)
-{
-	if (!Running)
+	/** Gets the size of the memory allocated by the buffer. */
+	SIZE_T GetAllocatedSize() const
 	{
-		return;
+		return Records.GetAllocatedSize();
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
+public:
 
-	Traces.Enqueue([=]() {
-		// @todo gmp: trace added subscriptions
-	});
-}
+	/** Set when the owning thread exited, so that the buffer is removed once it is drained. */
+	std::atomic<bool> bAbandoned;
 
+	/** Set when the tracer was destroyed, so that the owning thread releases the buffer. */
+	std::atomic<bool> bOrphaned;
 
-void FSGMessageTracer::TraceDispatchedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient, bool Async)
+private:
+
+	/** Holds the records. */
+	TArray<FTraceRecord> Records;
+
+	/** Holds the number of records the buffer can hold. */
+	uint32 Capacity;
+
+	/** Holds the mask that maps positions to records. */
+	uint32 Mask;
+
+	/** Holds the position of the next record to write. */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> WritePos;
+
+	/** Holds the position of the next record to read. */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> ReadPos;
+};
+
+
+/**
+ * Implements the runnable of the tracer's consumer thread.
+ */
+class FSGMessageTracer::FConsumer
+	: public FRunnable
 {
-	if (!Running)
-	{
-		return;
-	}
+public:
 
-	double Timestamp = FPlatformTime::Seconds();
+	explicit FConsumer(FSGMessageTracer& InTracer)
+		: Tracer(InTracer)
+	{ }
 
-	Traces.Enqueue([=]() {
-		// look up message & endpoint info
-		TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Context);
+public:
 
-		if (!MessageInfo.IsValid())
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		while (!Tracer.ConsumerStopping.load(std::memory_order_relaxed))
 		{
-			return;
+			Tracer.ProcessRecords();
+			Tracer.ConsumerEvent->Wait(SGMessageTracer::ConsumerIntervalMs);
 		}
 
-		TSharedPtr<FSGMessageTracerEndpointInfo>& EndpointInfo = RecipientsToEndpointInfos.FindOrAdd(Recipient->GetRecipientId());
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Tracer.ConsumerStopping.store(true, std::memory_order_relaxed);
+		Tracer.ConsumerEvent->Trigger();
+	}
+
+private:
+
+	/** Holds the tracer whose records are merged. */
+	FSGMessageTracer& Tracer;
+};
 
-		if (!EndpointInfo.IsValid())
-		{
-			return;
-		}
 
-		// update message information
-		TSharedRef<FSGMessageTracerDispatchState> DispatchState = MakeShareable(new FSGMessageTracerDispatchState());
+/* FSGMessageTracer structors
+ *****************************************************************************/
+
+FSGMessageTracer::FSGMessageTracer()
+	: Breaking(false)
+	, bHasBreakpoints(false)
+	, CapturedMessagesHead(0)
+	, HistoryHead(0)
+	, HistoryNum(0)
+	, HistoryBytes(0)
+	, NumTracedMessages(0)
+	, NumEvictedMessages(0)
+	, NextTraceId(1)
+	, ResetPending(false)
+	, Running(false)
+	, TickRegistered(false)
+	, ThreadBufferCapacity(4096)
+	, NumDroppedTraces(0)
+	, Consumer(nullptr)
+	, ConsumerThread(nullptr)
+	, ConsumerStopping(false)
+{
+	static std::atomic<uint32> NextTracerId(1);
+	TracerId = NextTracerId.fetch_add(1, std::memory_order_relaxed);
+
+	TSharedRef<FSamplingConfig, ESPMode::ThreadSafe> NewSamplingConfig = MakeShared<FSamplingConfig, ESPMode::ThreadSafe>();
+	int32 DefaultSampleRate = 1;
+
+	if (const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		Retention.MaxMessages = SGMessagingSettings->TracerMaxMessages;
+		Retention.MaxAge = SGMessagingSettings->TracerMaxMessageAge;
+		Retention.MaxBytes = (int64)SGMessagingSettings->TracerMaxMessageMegabytes * 1024 * 1024;
+
+		DefaultSampleRate = FMath::Max(1, SGMessagingSettings->TracerSampleRate);
+		ThreadBufferCapacity = (uint32)FMath::Max(64, SGMessagingSettings->TracerThreadBufferCapacity);
+
+		for (const auto& TypeSampleRate : SGMessagingSettings->TracerMessageTypeSampleRates)
 		{
-			DispatchState->DispatchLatency = Timestamp - MessageInfo->TimeSent;
-			DispatchState->DispatchType = Async ? ESGMessageTracerDispatchTypes::TaskGraph : ESGMessageTracerDispatchTypes::Direct;
-			DispatchState->EndpointInfo = EndpointInfo;
-			DispatchState->RecipientThread = Recipient->GetRecipientThread();
-			DispatchState->TimeDispatched = Timestamp;
-			DispatchState->TimeHandled = 0.0;
+			NewSamplingConfig->TypeSamplers.Add(TypeSampleRate.Key, MakeShared<FSampler, ESPMode::ThreadSafe>(FMath::Max(1, TypeSampleRate.Value)));
 		}
+	}
 
-		MessageInfo->DispatchStates.Add(EndpointInfo, DispatchState);
+	NewSamplingConfig->DefaultSampler = MakeShared<FSampler, ESPMode::ThreadSafe>(DefaultSampleRate);
+	NewSamplingConfig->bSampleAll = (DefaultSampleRate == 1) && (NewSamplingConfig->TypeSamplers.Num() == 0);
+	SamplingConfig = NewSamplingConfig;
 
-		// update database
-		EndpointInfo->ReceivedMessages.Add(MessageInfo);
-	});
+	ContinueEvent = FPlatformProcess::GetSynchEventFromPool();
+	ConsumerEvent = FPlatformProcess::GetSynchEventFromPool();
 }
 
 
-void FSGMessageTracer::TraceHandledMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
+FSGMessageTracer::~FSGMessageTracer()
 {
-	if (!Running)
+	if (TickRegistered)
 	{
-		return;
+		FTSTicker::GetCoreTicker().RemoveTicker(TickDelegateHandle);
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
+	if (ConsumerThread != nullptr)
+	{
+		ConsumerThread->Kill(true);
+		delete ConsumerThread;
+		ConsumerThread = nullptr;
+	}
 
-	Traces.Enqueue([=]() {
-		// look up message & endpoint info
-		TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Context);
+	delete Consumer;
+	Consumer = nullptr;
+
+	// threads release their buffers of this tracer the next time they trace
+	{
+		FScopeLock Lock(&ThreadBuffersCriticalSection);
 
-		if (!MessageInfo.IsValid())
+		for (const TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>& ThreadBuffer : ThreadBuffers)
 		{
-			return;
+			ThreadBuffer->bOrphaned.store(true, std::memory_order_relaxed);
 		}
+	}
 
-		TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = RecipientsToEndpointInfos.FindRef(Recipient->GetRecipientId());
+	FPlatformProcess::ReturnSynchEventToPool(ConsumerEvent);
+	ConsumerEvent = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(ContinueEvent);
+	ContinueEvent = nullptr;
+}
 
-		if (!EndpointInfo.IsValid())
-		{
-			return;
-		}
 
-		// update message information
-		TSharedPtr<FSGMessageTracerDispatchState> DispatchState = MessageInfo->DispatchStates.FindRef(EndpointInfo);
+/* FSGMessageTracer interface
+ *****************************************************************************/
 
-		if (DispatchState.IsValid())
-		{
-			DispatchState->TimeHandled = Timestamp;
-		}
-	});
+void FSGMessageTracer::TraceAddedInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
+{
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::AddedInterceptor;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.Id = Interceptor->GetInterceptorId();
+		Record.Name = Interceptor->GetDebugName();
+	}
+
+	WriteRegistrationRecord(MoveTemp(Record));
 }
 
 
-void FSGMessageTracer::TraceInterceptedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor)
+void FSGMessageTracer::TraceAddedRecipient(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
 {
-	if (!Running)
+	FTraceRecord Record;
 	{
-		return;
+		Record.Type = ETraceRecordType::AddedRecipient;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.Id = Recipient->GetRecipientId();
+		Record.Address = Address;
+		Record.Name = Recipient->GetDebugName();
+		Record.bFlag = Recipient->IsRemote();
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
+	WriteRegistrationRecord(MoveTemp(Record));
+}
 
-	Traces.Enqueue([=]() {
-		// look up message & interceptor info
-		auto MessageInfo = MessageInfos.FindRef(Context);
 
-		if (!MessageInfo.IsValid())
-		{
-			return;
-		}
+void FSGMessageTracer::TraceAddedSubscription(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription)
+{
+	// @todo gmp: trace added subscriptions
+}
 
-		MessageInfo->Intercepted = true;
 
-		auto InterceptorInfo = Interceptors.FindRef(Interceptor->GetInterceptorId());
+void FSGMessageTracer::TraceDispatchedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient, bool Async)
+{
+	SGMESSAGING_TRACE(DispatchedMessage, *Context, Recipient->GetRecipientId(), Recipient->GetRecipientThread(), Async);
 
-		if (!InterceptorInfo.IsValid())
-		{
-			return;
-		}
+	const uint64 TraceId = Context->GetTraceId();
+
+	if (!Running || (TraceId == 0) || !Context->IsTraced())
+	{
+		return;
+	}
+
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::DispatchedMessage;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.TraceId = TraceId;
+		Record.Id = Recipient->GetRecipientId();
+		Record.RecipientThread = Recipient->GetRecipientThread();
+		Record.bFlag = Async;
+	}
 
-		// update interceptor information
-		InterceptorInfo->InterceptedMessages.Add(MessageInfo);
-	});		
+	WriteRecord(MoveTemp(Record));
 }
 
 
-void FSGMessageTracer::TraceRemovedInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
+void FSGMessageTracer::TraceHandledMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
 {
-	double Timestamp = FPlatformTime::Seconds();
+	SGMESSAGING_TRACE(HandledMessage, *Context, Recipient->GetRecipientId());
 
-	Traces.Enqueue([=]() {
-		auto InterceptorInfo = Interceptors.FindRef(Interceptor->GetInterceptorId());
+	const uint64 TraceId = Context->GetTraceId();
 
-		if (!InterceptorInfo.IsValid())
-		{
-			return;
-		}
+	if (!Running || (TraceId == 0) || !Context->IsTraced())
+	{
+		return;
+	}
 
-		// update interceptor information
-		InterceptorInfo->TimeUnregistered = Timestamp;
-	});
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::HandledMessage;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.TraceId = TraceId;
+		Record.Id = Recipient->GetRecipientId();
+	}
+
+	WriteRecord(MoveTemp(Record));
 }
 
 
-void FSGMessageTracer::TraceRemovedRecipient(const FSGMessageAddress& Address)
+void FSGMessageTracer::TraceInterceptedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor)
 {
-	double Timestamp = FPlatformTime::Seconds();
+	SGMESSAGING_TRACE(InterceptedMessage, *Context, Interceptor->GetInterceptorId());
 
-	Traces.Enqueue([=]() {
-		TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = AddressesToEndpointInfos.FindRef(Address);
+	const uint64 TraceId = Context->GetTraceId();
 
-		if (!EndpointInfo.IsValid())
-		{
-			return;
-		}
+	if (!Running || (TraceId == 0) || !Context->IsTraced())
+	{
+		return;
+	}
 
-		// update endpoint information
-		TSharedPtr<FSGMessageTracerAddressInfo> AddressInfo = EndpointInfo->AddressInfos.FindRef(Address);
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::InterceptedMessage;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.TraceId = TraceId;
+		Record.Id = Interceptor->GetInterceptorId();
+	}
 
-		if (AddressInfo.IsValid())
-		{
-			AddressInfo->TimeUnregistered = Timestamp;
-		}
-	});
+	WriteRecord(MoveTemp(Record));
 }
 
 
-void FSGMessageTracer::TraceRemovedSubscription(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription, const FName& MessageType)
+void FSGMessageTracer::TraceRemovedInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
 {
-	if (!Running)
+	FTraceRecord Record;
 	{
-		return;
+		Record.Type = ETraceRecordType::RemovedInterceptor;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.Id = Interceptor->GetInterceptorId();
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
+	WriteRegistrationRecord(MoveTemp(Record));
+}
 
-	Traces.Enqueue([=]() {
-		// @todo gmp: trace removed message subscriptions
-	});
+
+void FSGMessageTracer::TraceRemovedRecipient(const FSGMessageAddress& Address)
+{
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::RemovedRecipient;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.Address = Address;
+	}
+
+	WriteRegistrationRecord(MoveTemp(Record));
+}
+
+
+void FSGMessageTracer::TraceRemovedSubscription(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription, const FName& MessageType)
+{
+	// @todo gmp: trace removed message subscriptions
 }
 
 
 void FSGMessageTracer::TraceRoutedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
 {
+	SGMESSAGING_TRACE(RoutedMessage, *Context);
+
 	if (!Running)
 	{
 		return;
@@ -280,68 +424,60 @@ void FSGMessageTracer::TraceRoutedMessage(const TSharedRef<ISGMessageContext, ES
 		ContinueEvent->Wait();
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
+	const uint64 TraceId = Context->GetTraceId();
 
-	Traces.Enqueue([=]() {
-		// update message information
-		TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Context);
+	if ((TraceId == 0) || !Context->IsTraced())
+	{
+		return;
+	}
 
-		if (MessageInfo.IsValid())
-		{
-			MessageInfo->TimeRouted = Timestamp;
-		}
-	});
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::RoutedMessage;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.TraceId = TraceId;
+	}
+
+	WriteRecord(MoveTemp(Record));
 }
 
 
 void FSGMessageTracer::TraceSentMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
 {
+	SGMESSAGING_TRACE(SentMessage, *Context);
+
 	if (!Running)
 	{
 		return;
 	}
 
-	double Timestamp = FPlatformTime::Seconds();
-
-	Traces.Enqueue([=]() {
-		// look up endpoint info
-		TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = AddressesToEndpointInfos.FindRef(Context->GetSender());
-
-		if (!EndpointInfo.IsValid())
-		{
-			return;
-		}
-
-		// create message info
-		TSharedRef<FSGMessageTracerMessageInfo> MessageInfo = MakeShareable(new FSGMessageTracerMessageInfo());
-		{
-			MessageInfo->Context = Context;
-			MessageInfo->Intercepted = false;
-			MessageInfo->SenderInfo = EndpointInfo;
-			MessageInfo->TimeRouted = 0.0;
-			MessageInfo->TimeSent = Timestamp;
-			MessageInfos.Add(Context, MessageInfo);
-		}
+	// decide once whether the message is traced, the other trace points only check the flag
+	const bool bTraced = ShouldSample(*Context);
+	Context->SetTraced(bTraced);
 
-		// add message type
-		TSharedPtr<FSGMessageTracerTypeInfo>& TypeInfo = MessageTypes.FindOrAdd(Context->GetMessageType());
-
-		if (!TypeInfo.IsValid())
-		{
-			TypeInfo = MakeShareable(new FSGMessageTracerTypeInfo());
-			TypeInfo->TypeName = Context->GetMessageType();
+	if (!bTraced)
+	{
+		return;
+	}
 
-			TypeAddedDelegate.Broadcast(TypeInfo.ToSharedRef());
-		}
+	// the records are keyed by a fresh identifier, a context's address may be reused after it was released
+	const uint64 TraceId = NextTraceId.fetch_add(1, std::memory_order_relaxed);
+	Context->SetTraceId(TraceId);
 
-		TypeInfo->Messages.Add(MessageInfo);
+	if (Context->GetTraceId() != TraceId)
+	{
+		return;
+	}
 
-		// update database
-		EndpointInfo->SentMessages.Add(MessageInfo);
-		MessageInfo->TypeInfo = TypeInfo;
+	FTraceRecord Record;
+	{
+		Record.Type = ETraceRecordType::SentMessage;
+		Record.Timestamp = FSGMessageClock::Seconds();
+		Record.TraceId = TraceId;
+		Record.Context = Context;
+	}
 
-		MessagesAddedDelegate.Broadcast(MessageInfo);
-	});
+	WriteRecord(MoveTemp(Record));
 }
 
 
@@ -358,6 +494,15 @@ void FSGMessageTracer::Continue()
 {
 	if (!Running)
 	{
+		EnsureTicking();
+
+		// merge trace records off the game thread from now on
+		if ((ConsumerThread == nullptr) && FPlatformProcess::SupportsMultithreading())
+		{
+			Consumer = new FConsumer(*this);
+			ConsumerThread = FRunnableThread::Create(Consumer, TEXT("FSGMessageTracer"), 128 * 1024, TPri_BelowNormal);
+		}
+
 		Running = true;
 	}
 	else if (Breaking)
@@ -370,6 +515,8 @@ void FSGMessageTracer::Continue()
 
 int32 FSGMessageTracer::GetEndpoints(TArray<TSharedPtr<FSGMessageTracerEndpointInfo>>& OutEndpoints) const
 {
+	FScopeLock Lock(&InfoCriticalSection);
+
 	RecipientsToEndpointInfos.GenerateValueArray(OutEndpoints);
 
 	return OutEndpoints.Num();
@@ -378,7 +525,14 @@ int32 FSGMessageTracer::GetEndpoints(TArray<TSharedPtr<FSGMessageTracerEndpointI
 
 int32 FSGMessageTracer::GetMessages(TArray<TSharedPtr<FSGMessageTracerMessageInfo>>& OutMessages) const
 {
-	MessageInfos.GenerateValueArray(OutMessages);
+	FScopeLock Lock(&InfoCriticalSection);
+
+	OutMessages.Reset(HistoryNum);
+
+	for (int32 Index = 0; Index < HistoryNum; ++Index)
+	{
+		OutMessages.Add(History[(HistoryHead + Index) % History.Num()]);
+	}
 
 	return OutMessages.Num();
 }
@@ -386,85 +540,276 @@ int32 FSGMessageTracer::GetMessages(TArray<TSharedPtr<FSGMessageTracerMessageInf
 
 int32 FSGMessageTracer::GetMessageTypes(TArray<TSharedPtr<FSGMessageTracerTypeInfo>>& OutTypes) const
 {
+	FScopeLock Lock(&InfoCriticalSection);
+
 	MessageTypes.GenerateValueArray(OutTypes);
 
 	return OutTypes.Num();
 }
 
 
+TSharedPtr<FSGMessageTracerTypeInfo> FSGMessageTracer::FindMessageType(const FName& MessageType) const
+{
+	FScopeLock Lock(&InfoCriticalSection);
+
+	return MessageTypes.FindRef(MessageType);
+}
+
+
+void FSGMessageTracer::ResetLatencies()
+{
+	FScopeLock Lock(&InfoCriticalSection);
+
+	for (auto& TypeInfoPair : MessageTypes)
+	{
+		TypeInfoPair.Value->Latencies.Reset();
+	}
+
+	for (auto& EndpointInfoPair : RecipientsToEndpointInfos)
+	{
+		EndpointInfoPair.Value->Latencies.Reset();
+	}
+}
+
+
 bool FSGMessageTracer::HasMessages() const
 {
-	return (MessageInfos.Num() > 0);
+	FScopeLock Lock(&InfoCriticalSection);
+
+	return (HistoryNum > 0);
 }
 
 
-bool FSGMessageTracer::IsBreaking() const
+int64 FSGMessageTracer::GetNumTracedMessages() const
 {
-	return Breaking;
+	FScopeLock Lock(&InfoCriticalSection);
+
+	return NumTracedMessages;
 }
 
 
-bool FSGMessageTracer::IsRunning() const
+int64 FSGMessageTracer::GetNumEvictedMessages() const
 {
-	return Running;
+	FScopeLock Lock(&InfoCriticalSection);
+
+	return NumEvictedMessages;
 }
 
 
-void FSGMessageTracer::Reset()
+FSGMessageTracerRetention FSGMessageTracer::GetRetention() const
 {
-	ResetPending = true;
+	FScopeLock Lock(&InfoCriticalSection);
+
+	return Retention;
 }
 
 
-void FSGMessageTracer::Step()
+void FSGMessageTracer::SetRetention(const FSGMessageTracerRetention& InRetention)
 {
-	if (!Breaking)
-	{
-		return;
-	}
+	FScopeLock Lock(&InfoCriticalSection);
 
-	ContinueEvent->Trigger();
+	Retention = InRetention;
 }
 
 
-void FSGMessageTracer::Stop()
+int32 FSGMessageTracer::GetSampleRate(const FName& MessageType) const
 {
-	if (!Running)
+	TSharedPtr<const FSamplingConfig, ESPMode::ThreadSafe> CurrentConfig;
 	{
-		return;
+		FReadScopeLock ReadLock(SamplingConfigLock);
+		CurrentConfig = SamplingConfig;
 	}
 
-	Running = false;
+	const TSharedPtr<FSampler, ESPMode::ThreadSafe> TypeSampler = CurrentConfig->TypeSamplers.FindRef(MessageType);
 
-	if (Breaking)
-	{
-		Breaking = false;
-		ContinueEvent->Trigger();
-	}
+	return TypeSampler.IsValid() ? TypeSampler->SampleRate : CurrentConfig->DefaultSampler->SampleRate;
 }
 
 
-bool FSGMessageTracer::Tick(float DeltaTime)
+void FSGMessageTracer::SetSampleRate(int32 SampleRate, const FName& MessageType)
 {
-    QUICK_SCOPE_CYCLE_COUNTER(STAT_FSGMessageTracer_Tick);
+	FWriteScopeLock WriteLock(SamplingConfigLock);
 
-	if (ResetPending)
+	// samplers that don't change keep their counts, so that sampling stays deterministic
+	TSharedRef<FSamplingConfig, ESPMode::ThreadSafe> NewSamplingConfig = MakeShared<FSamplingConfig, ESPMode::ThreadSafe>(*SamplingConfig);
+
+	if (MessageType.IsNone())
 	{
-		ResetMessages();
-		ResetPending = false;
+		NewSamplingConfig->DefaultSampler = MakeShared<FSampler, ESPMode::ThreadSafe>(FMath::Max(1, SampleRate));
 	}
+	else if (SampleRate <= 0)
+	{
+		NewSamplingConfig->TypeSamplers.Remove(MessageType);
+	}
+	else
+	{
+		NewSamplingConfig->TypeSamplers.Add(MessageType, MakeShared<FSampler, ESPMode::ThreadSafe>(SampleRate));
+	}
+
+	NewSamplingConfig->bSampleAll = (NewSamplingConfig->DefaultSampler->SampleRate == 1) && (NewSamplingConfig->TypeSamplers.Num() == 0);
+	SamplingConfig = NewSamplingConfig;
+}
+
+
+int64 FSGMessageTracer::GetNumDroppedTraces() const
+{
+	return NumDroppedTraces.load(std::memory_order_relaxed);
+}
+
+
+void FSGMessageTracer::GetCompressionStatistics(TMap<FName, FSGMessageCompressionStatistics>& OutStatistics) const
+{
+	FSGMessageCompressionCounters::GetStatistics(OutStatistics);
+}
+
+
+FCriticalSection& FSGMessageTracer::GetInfoLock() const
+{
+	return InfoCriticalSection;
+}
+
+
+void FSGMessageTracer::AccumulateMemoryReport(FSGMessageMemoryReport& InOutReport) const
+{
+	FSGMessageMemoryReport Report;
 
-	// process new traces
-	if (!Traces.IsEmpty())
 	{
-		TFunction<void()> Trace;
+		FScopeLock Lock(&InfoCriticalSection);
+
+		Report.NumTracedMessages = HistoryNum;
+		Report.TracerBytes = HistoryBytes + History.GetAllocatedSize() + MessageInfos.GetAllocatedSize() + MessageTypes.GetAllocatedSize() + Interceptors.GetAllocatedSize()
+			+ AddressesToEndpointInfos.GetAllocatedSize() + RecipientsToEndpointInfos.GetAllocatedSize() + DeferredRecords.GetAllocatedSize();
+	}
 
-		while (Traces.Dequeue(Trace))
+	{
+		FScopeLock Lock(&ThreadBuffersCriticalSection);
+
+		for (const TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>& ThreadBuffer : ThreadBuffers)
 		{
-			Trace();
+			Report.TracerBytes += ThreadBuffer->GetAllocatedSize();
 		}
 	}
 
+	{
+		FScopeLock Lock(&CapturedMessagesCriticalSection);
+
+		Report.TracerBytes += CapturedMessages.GetAllocatedSize();
+	}
+
+	InOutReport.Accumulate(Report);
+}
+
+
+void FSGMessageTracer::AddBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint, TArrayView<const FName> MessageTypes)
+{
+	FScopeLock Lock(&BreakpointsCriticalSection);
+
+	FBreakpoint& NewBreakpoint = Breakpoints.AddDefaulted_GetRef();
+	NewBreakpoint.Breakpoint = Breakpoint;
+	NewBreakpoint.MessageTypes = MessageTypes;
+
+	CompileBreakpoints();
+}
+
+
+void FSGMessageTracer::RemoveBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint)
+{
+	FScopeLock Lock(&BreakpointsCriticalSection);
+
+	const int32 NumRemoved = Breakpoints.RemoveAll([&Breakpoint](const FBreakpoint& Candidate)
+	{
+		return Candidate.Breakpoint == Breakpoint;
+	});
+
+	if (NumRemoved > 0)
+	{
+		CompileBreakpoints();
+	}
+}
+
+
+int32 FSGMessageTracer::GetCapturedMessages(TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutContexts) const
+{
+	FScopeLock Lock(&CapturedMessagesCriticalSection);
+
+	OutContexts.Reset(CapturedMessages.Num());
+
+	for (int32 Offset = 0; Offset < CapturedMessages.Num(); ++Offset)
+	{
+		OutContexts.Add(CapturedMessages[(CapturedMessagesHead + Offset) % CapturedMessages.Num()]);
+	}
+
+	return OutContexts.Num();
+}
+
+
+void FSGMessageTracer::ClearCapturedMessages()
+{
+	FScopeLock Lock(&CapturedMessagesCriticalSection);
+
+	CapturedMessages.Empty();
+	CapturedMessagesHead = 0;
+}
+
+
+bool FSGMessageTracer::IsBreaking() const
+{
+	return Breaking;
+}
+
+
+bool FSGMessageTracer::IsRunning() const
+{
+	return Running;
+}
+
+
+void FSGMessageTracer::Reset()
+{
+	ResetPending = true;
+}
+
+
+void FSGMessageTracer::Step()
+{
+	if (!Breaking)
+	{
+		return;
+	}
+
+	ContinueEvent->Trigger();
+}
+
+
+void FSGMessageTracer::Stop()
+{
+	if (!Running)
+	{
+		return;
+	}
+
+	Running = false;
+
+	if (Breaking)
+	{
+		Breaking = false;
+		ContinueEvent->Trigger();
+	}
+}
+
+
+bool FSGMessageTracer::Tick(float DeltaTime)
+{
+    QUICK_SCOPE_CYCLE_COUNTER(STAT_FSGMessageTracer_Tick);
+
+	// without a consumer thread, registrations (and all traces on platforms without threads) are merged here
+	if (ConsumerThread == nullptr)
+	{
+		ProcessRecords();
+	}
+
+	BroadcastNotifications();
+
 	return true;
 }
 
@@ -472,10 +817,490 @@ bool FSGMessageTracer::Tick(float DeltaTime)
 /* FSGMessageTracer implementation
  *****************************************************************************/
 
+void FSGMessageTracer::WriteRecord(FTraceRecord&& Record)
+{
+	if (!GetThreadBuffer().TryWrite(MoveTemp(Record)))
+	{
+		NumDroppedTraces.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+void FSGMessageTracer::WriteRegistrationRecord(FTraceRecord&& Record)
+{
+	LLM_SCOPE_BYTAG(SGMessaging_Tracer);
+	RegistrationRecords.Enqueue(MoveTemp(Record));
+	EnsureTicking();
+}
+
+
+void FSGMessageTracer::EnsureTicking()
+{
+	if (TickRegistered.load(std::memory_order_acquire))
+	{
+		return;
+	}
+
+	FScopeLock Lock(&TickCriticalSection);
+
+	if (!TickRegistered.load(std::memory_order_relaxed))
+	{
+		TickDelegateHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FSGMessageTracer::Tick), 0.0f);
+		TickRegistered.store(true, std::memory_order_release);
+	}
+}
+
+
+FSGMessageTracer::FTraceBuffer& FSGMessageTracer::GetThreadBuffer()
+{
+	/** Structure for the trace buffers of a thread, one per tracer. */
+	struct FThreadBuffers
+	{
+		TArray<TPair<uint32, TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>>, TInlineAllocator<4>> Buffers;
+
+		~FThreadBuffers()
+		{
+			for (const auto& Buffer : Buffers)
+			{
+				Buffer.Value->bAbandoned.store(true, std::memory_order_release);
+			}
+		}
+	};
+
+	static thread_local FThreadBuffers ThreadLocalBuffers;
+
+	for (const auto& Buffer : ThreadLocalBuffers.Buffers)
+	{
+		if (Buffer.Key == TracerId)
+		{
+			return *Buffer.Value;
+		}
+	}
+
+	// release the buffers of destroyed tracers
+	ThreadLocalBuffers.Buffers.RemoveAll([](const TPair<uint32, TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>>& Buffer) {
+		return Buffer.Value->bOrphaned.load(std::memory_order_relaxed);
+	});
+
+	LLM_SCOPE_BYTAG(SGMessaging_Tracer);
+	TSharedRef<FTraceBuffer, ESPMode::ThreadSafe> NewBuffer = MakeShared<FTraceBuffer, ESPMode::ThreadSafe>(ThreadBufferCapacity);
+	{
+		FScopeLock Lock(&ThreadBuffersCriticalSection);
+		ThreadBuffers.Add(NewBuffer);
+	}
+
+	ThreadLocalBuffers.Buffers.Emplace(TracerId, NewBuffer);
+
+	return *NewBuffer;
+}
+
+
+void FSGMessageTracer::ProcessRecords()
+{
+	LLM_SCOPE_BYTAG(SGMessaging_Tracer);
+	FScopeLock Lock(&InfoCriticalSection);
+
+	if (ResetPending.exchange(false))
+	{
+		ResetMessages();
+	}
+
+	// registrations first, so that the messages of new endpoints are known
+	{
+		FTraceRecord Record;
+
+		while (RegistrationRecords.Dequeue(Record))
+		{
+			ApplyRecord(Record);
+		}
+	}
+
+	TArray<FTraceRecord> RetriedRecords = MoveTemp(DeferredRecords);
+	DeferredRecords.Reset();
+
+	auto ApplyOrDefer = [this](FTraceRecord& Record)
+	{
+		if (ApplyRecord(Record))
+		{
+			return;
+		}
+
+		// the record may have overtaken the record that makes its message known, i.e. on another thread
+		if ((DeferredRecords.Num() < SGMessageTracer::MaxDeferredRecords) && (FSGMessageClock::Seconds() - Record.Timestamp < SGMessageTracer::MaxDeferralSeconds))
+		{
+			DeferredRecords.Add(MoveTemp(Record));
+		}
+	};
+
+	// merge the threads' records
+	TArray<TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>> Buffers;
+	{
+		FScopeLock BuffersLock(&ThreadBuffersCriticalSection);
+		Buffers = ThreadBuffers;
+	}
+
+	for (const TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>& Buffer : Buffers)
+	{
+		Buffer->Drain(ApplyOrDefer);
+	}
+
+	for (FTraceRecord& Record : RetriedRecords)
+	{
+		ApplyOrDefer(Record);
+	}
+
+	// remove the buffers of threads that exited
+	{
+		FScopeLock BuffersLock(&ThreadBuffersCriticalSection);
+
+		ThreadBuffers.RemoveAll([](const TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>& Buffer) {
+			return Buffer->bAbandoned.load(std::memory_order_acquire) && Buffer->IsEmpty();
+		});
+	}
+
+	EnforceRetention();
+}
+
+
+bool FSGMessageTracer::ApplyRecord(FTraceRecord& Record)
+{
+	switch (Record.Type)
+	{
+	case ETraceRecordType::AddedInterceptor:
+		{
+			// create interceptor information
+			auto& InterceptorInfo = Interceptors.FindOrAdd(Record.Id);
+
+			if (!InterceptorInfo.IsValid())
+			{
+				InterceptorInfo = MakeShareable(new FSGMessageTracerInterceptorInfo());
+			}
+
+			// initialize interceptor information
+			InterceptorInfo->Name = Record.Name;
+			InterceptorInfo->TimeRegistered = Record.Timestamp;
+			InterceptorInfo->TimeUnregistered = 0;
+		}
+		break;
+
+	case ETraceRecordType::AddedRecipient:
+		{
+			// create endpoint information
+			TSharedPtr<FSGMessageTracerEndpointInfo>& EndpointInfo = RecipientsToEndpointInfos.FindOrAdd(Record.Id);
+
+			if (!EndpointInfo.IsValid())
+			{
+				EndpointInfo = MakeShareable(new FSGMessageTracerEndpointInfo());
+			}
+
+			// initialize endpoint information
+			TSharedRef<FSGMessageTracerAddressInfo> AddressInfo = MakeShareable(new FSGMessageTracerAddressInfo());
+			{
+				AddressInfo->Address = Record.Address;
+				AddressInfo->TimeRegistered = Record.Timestamp;
+				AddressInfo->TimeUnregistered = 0;
+			}
+
+			EndpointInfo->AddressInfos.Add(Record.Address, AddressInfo);
+			EndpointInfo->Name = Record.Name;
+			EndpointInfo->Remote = Record.bFlag;
+
+			// add to address table
+			AddressesToEndpointInfos.Add(Record.Address, EndpointInfo);
+		}
+		break;
+
+	case ETraceRecordType::DispatchedMessage:
+		{
+			// look up message & endpoint info
+			TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Record.TraceId);
+
+			if (!MessageInfo.IsValid())
+			{
+				return false;
+			}
+
+			TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = RecipientsToEndpointInfos.FindRef(Record.Id);
+
+			if (!EndpointInfo.IsValid())
+			{
+				break;
+			}
+
+			// update latency histograms
+			const double RouteToDispatch = Record.Timestamp - ((MessageInfo->TimeRouted > 0.0) ? MessageInfo->TimeRouted : MessageInfo->TimeSent);
+
+			EndpointInfo->Latencies.RouteToDispatch.Record(RouteToDispatch);
+
+			if (MessageInfo->TypeInfo.IsValid())
+			{
+				MessageInfo->TypeInfo->Latencies.RouteToDispatch.Record(RouteToDispatch);
+			}
+
+			// update message information
+			TSharedRef<FSGMessageTracerDispatchState> DispatchState = MakeShareable(new FSGMessageTracerDispatchState());
+			{
+				DispatchState->DispatchLatency = Record.Timestamp - MessageInfo->TimeSent;
+				DispatchState->DispatchType = Record.bFlag ? ESGMessageTracerDispatchTypes::TaskGraph : ESGMessageTracerDispatchTypes::Direct;
+				DispatchState->EndpointInfo = EndpointInfo;
+				DispatchState->RecipientThread = Record.RecipientThread;
+				DispatchState->TimeDispatched = Record.Timestamp;
+				DispatchState->TimeHandled = 0.0;
+			}
+
+			// a redelivery to the same endpoint replaces its dispatch state, which is accounted for once
+			if (!MessageInfo->DispatchStates.Contains(EndpointInfo))
+			{
+				HistoryBytes += sizeof(FSGMessageTracerDispatchState);
+			}
+
+			MessageInfo->DispatchStates.Add(EndpointInfo, DispatchState);
+
+			// update database
+			EndpointInfo->ReceivedMessages.Add(MessageInfo);
+			++EndpointInfo->NumReceivedMessages;
+		}
+		break;
+
+	case ETraceRecordType::HandledMessage:
+		{
+			// look up message & endpoint info
+			TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Record.TraceId);
+
+			if (!MessageInfo.IsValid())
+			{
+				return false;
+			}
+
+			TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = RecipientsToEndpointInfos.FindRef(Record.Id);
+
+			if (!EndpointInfo.IsValid())
+			{
+				break;
+			}
+
+			// update message information
+			TSharedPtr<FSGMessageTracerDispatchState> DispatchState = MessageInfo->DispatchStates.FindRef(EndpointInfo);
+
+			if (!DispatchState.IsValid())
+			{
+				return false;
+			}
+
+			DispatchState->TimeHandled = Record.Timestamp;
+
+			// update latency histograms
+			const double DispatchToHandled = Record.Timestamp - DispatchState->TimeDispatched;
+
+			EndpointInfo->Latencies.DispatchToHandled.Record(DispatchToHandled);
+
+			if (MessageInfo->TypeInfo.IsValid())
+			{
+				MessageInfo->TypeInfo->Latencies.DispatchToHandled.Record(DispatchToHandled);
+			}
+		}
+		break;
+
+	case ETraceRecordType::InterceptedMessage:
+		{
+			// look up message & interceptor info
+			auto MessageInfo = MessageInfos.FindRef(Record.TraceId);
+
+			if (!MessageInfo.IsValid())
+			{
+				return false;
+			}
+
+			MessageInfo->Intercepted = true;
+
+			auto InterceptorInfo = Interceptors.FindRef(Record.Id);
+
+			if (!InterceptorInfo.IsValid())
+			{
+				break;
+			}
+
+			// update interceptor information
+			InterceptorInfo->InterceptedMessages.Add(MessageInfo);
+			++InterceptorInfo->NumInterceptedMessages;
+		}
+		break;
+
+	case ETraceRecordType::RemovedInterceptor:
+		{
+			auto InterceptorInfo = Interceptors.FindRef(Record.Id);
+
+			if (InterceptorInfo.IsValid())
+			{
+				// update interceptor information
+				InterceptorInfo->TimeUnregistered = Record.Timestamp;
+			}
+		}
+		break;
+
+	case ETraceRecordType::RemovedRecipient:
+		{
+			TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = AddressesToEndpointInfos.FindRef(Record.Address);
+
+			if (!EndpointInfo.IsValid())
+			{
+				break;
+			}
+
+			// update endpoint information
+			TSharedPtr<FSGMessageTracerAddressInfo> AddressInfo = EndpointInfo->AddressInfos.FindRef(Record.Address);
+
+			if (AddressInfo.IsValid())
+			{
+				AddressInfo->TimeUnregistered = Record.Timestamp;
+			}
+		}
+		break;
+
+	case ETraceRecordType::RoutedMessage:
+		{
+			// update message information
+			TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo = MessageInfos.FindRef(Record.TraceId);
+
+			if (!MessageInfo.IsValid())
+			{
+				return false;
+			}
+
+			MessageInfo->TimeRouted = Record.Timestamp;
+
+			// update latency histograms
+			const double SendToRoute = Record.Timestamp - MessageInfo->TimeSent;
+
+			if (MessageInfo->SenderInfo.IsValid())
+			{
+				MessageInfo->SenderInfo->Latencies.SendToRoute.Record(SendToRoute);
+			}
+
+			if (MessageInfo->TypeInfo.IsValid())
+			{
+				MessageInfo->TypeInfo->Latencies.SendToRoute.Record(SendToRoute);
+			}
+		}
+		break;
+
+	case ETraceRecordType::SentMessage:
+		{
+			// look up endpoint info
+			TSharedPtr<FSGMessageTracerEndpointInfo> EndpointInfo = AddressesToEndpointInfos.FindRef(Record.Context->GetSender());
+
+			if (!EndpointInfo.IsValid())
+			{
+				// the sender's registration may still be on its way
+				return false;
+			}
+
+			const FName MessageType = Record.Context->GetMessageType();
+
+			// create message info
+			TSharedRef<FSGMessageTracerMessageInfo> MessageInfo = MakeShareable(new FSGMessageTracerMessageInfo());
+			{
+				MessageInfo->Context = MoveTemp(Record.Context);
+				MessageInfo->Intercepted = false;
+				MessageInfo->SenderInfo = EndpointInfo;
+				MessageInfo->TimeRouted = 0.0;
+				MessageInfo->TimeSent = Record.Timestamp;
+				MessageInfos.Add(Record.TraceId, MessageInfo);
+			}
+
+			// add message type
+			TSharedPtr<FSGMessageTracerTypeInfo>& TypeInfo = MessageTypes.FindOrAdd(MessageType);
+
+			if (!TypeInfo.IsValid())
+			{
+				TypeInfo = MakeShareable(new FSGMessageTracerTypeInfo());
+				TypeInfo->TypeName = MessageType;
+
+				FSGRegisteredMessageTag RegisteredTag;
+
+				if (FSGMessageTagRegistry::Get().Find(TypeInfo->TypeName, RegisteredTag))
+				{
+					TypeInfo->DebugName = RegisteredTag.DebugName;
+				}
+
+				FNotification& Notification = PendingNotifications.AddDefaulted_GetRef();
+				Notification.Type = ENotification::TypeAdded;
+				Notification.TypeInfo = TypeInfo;
+			}
+
+			TypeInfo->Messages.Add(MessageInfo);
+			++TypeInfo->NumMessages;
+
+			// update database
+			EndpointInfo->SentMessages.Add(MessageInfo);
+			++EndpointInfo->NumSentMessages;
+			MessageInfo->TypeInfo = TypeInfo;
+
+			AddToHistory(MessageInfo);
+
+			FNotification& Notification = PendingNotifications.AddDefaulted_GetRef();
+			Notification.Type = ENotification::MessageAdded;
+			Notification.MessageInfo = MessageInfo;
+		}
+		break;
+	}
+
+	return true;
+}
+
+
+void FSGMessageTracer::BroadcastNotifications()
+{
+	TArray<FNotification> Notifications;
+	{
+		FScopeLock Lock(&InfoCriticalSection);
+
+		if (PendingNotifications.Num() == 0)
+		{
+			return;
+		}
+
+		Notifications = MoveTemp(PendingNotifications);
+		PendingNotifications.Reset();
+	}
+
+	// delegates are executed without the lock, so that listeners may call back into the tracer
+
+	for (const FNotification& Notification : Notifications)
+	{
+		switch (Notification.Type)
+		{
+		case ENotification::MessageAdded:
+			MessagesAddedDelegate.Broadcast(Notification.MessageInfo.ToSharedRef());
+			break;
+
+		case ENotification::MessagesEvicted:
+			MessagesEvictedDelegate.Broadcast(Notification.NumEvicted);
+			break;
+
+		case ENotification::MessagesReset:
+			MessagesResetDelegate.Broadcast();
+			break;
+
+		case ENotification::TypeAdded:
+			TypeAddedDelegate.Broadcast(Notification.TypeInfo.ToSharedRef());
+			break;
+		}
+	}
+}
+
+
 void FSGMessageTracer::ResetMessages()
 {
 	MessageInfos.Reset();
 	MessageTypes.Reset();
+	History.Reset();
+	DeferredRecords.Reset();
+	HistoryHead = 0;
+	HistoryNum = 0;
+	HistoryBytes = 0;
+	NumTracedMessages = 0;
+	NumEvictedMessages = 0;
 
 	for (auto& EndpointInfoPair : AddressesToEndpointInfos)
 	{
@@ -483,30 +1308,268 @@ void FSGMessageTracer::ResetMessages()
 		{
 			EndpointInfo->ReceivedMessages.Reset();
 			EndpointInfo->SentMessages.Reset();
+			EndpointInfo->NumReceivedMessages = 0;
+			EndpointInfo->NumSentMessages = 0;
+			EndpointInfo->Latencies.Reset();
 		}
 	}
 
-	MessagesResetDelegate.Broadcast();
+	for (auto& InterceptorInfoPair : Interceptors)
+	{
+		InterceptorInfoPair.Value->InterceptedMessages.Reset();
+		InterceptorInfoPair.Value->NumInterceptedMessages = 0;
+	}
+
+	PendingNotifications.AddDefaulted_GetRef().Type = ENotification::MessagesReset;
 }
 
 
-bool FSGMessageTracer::ShouldBreak(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) const
+void FSGMessageTracer::AddToHistory(const TSharedRef<FSGMessageTracerMessageInfo>& MessageInfo)
 {
-	if (FPlatformProcess::SupportsMultithreading())
+	// grow the ring buffer, unwrapping it so that the oldest message comes first
+	if (HistoryNum == History.Num())
 	{
-		if (Breaking)
+		TArray<TSharedPtr<FSGMessageTracerMessageInfo>> NewHistory;
+		NewHistory.Reserve(FMath::Max(16, History.Num() * 2));
+
+		for (int32 Index = 0; Index < HistoryNum; ++Index)
+		{
+			NewHistory.Add(MoveTemp(History[(HistoryHead + Index) % History.Num()]));
+		}
+
+		NewHistory.SetNum(NewHistory.Max());
+		History = MoveTemp(NewHistory);
+		HistoryHead = 0;
+	}
+
+	History[(HistoryHead + HistoryNum) % History.Num()] = MessageInfo;
+	++HistoryNum;
+
+	HistoryBytes += EstimateMessageBytes(*MessageInfo);
+	++NumTracedMessages;
+}
+
+
+void FSGMessageTracer::EnforceRetention()
+{
+	const double OldestTimeSent = (Retention.MaxAge > 0.0) ? FSGMessageClock::Seconds() - Retention.MaxAge : 0.0;
+	int32 NumEvicted = 0;
+
+	while (HistoryNum > 0)
+	{
+		TSharedPtr<FSGMessageTracerMessageInfo>& Oldest = History[HistoryHead];
+
+		const bool bExceedsCount = (Retention.MaxMessages > 0) && (HistoryNum > Retention.MaxMessages);
+		const bool bExceedsAge = (Retention.MaxAge > 0.0) && (Oldest->TimeSent < OldestTimeSent);
+		const bool bExceedsBytes = (Retention.MaxBytes > 0) && (HistoryBytes > Retention.MaxBytes);
+
+		if (!bExceedsCount && !bExceedsAge && !bExceedsBytes)
+		{
+			break;
+		}
+
+		// release the message context, the message is removed from the per-endpoint & per-type lists below
+		HistoryBytes -= EstimateMessageBytes(*Oldest);
+		MessageInfos.Remove(Oldest->Context->GetTraceId());
+		Oldest->Context.Reset();
+		Oldest.Reset();
+
+		HistoryHead = (HistoryHead + 1) % History.Num();
+		--HistoryNum;
+		++NumEvicted;
+	}
+
+	if (NumEvicted == 0)
+	{
+		return;
+	}
+
+	NumEvictedMessages += NumEvicted;
+
+	// evicted messages have no context anymore
+	auto RemoveEvicted = [](TArray<TSharedPtr<FSGMessageTracerMessageInfo>>& Messages)
+	{
+		Messages.RemoveAll([](const TSharedPtr<FSGMessageTracerMessageInfo>& MessageInfo) {
+			return !MessageInfo->Context.IsValid();
+		});
+	};
+
+	for (auto& TypeInfoPair : MessageTypes)
+	{
+		RemoveEvicted(TypeInfoPair.Value->Messages);
+	}
+
+	for (auto& EndpointInfoPair : RecipientsToEndpointInfos)
+	{
+		RemoveEvicted(EndpointInfoPair.Value->ReceivedMessages);
+		RemoveEvicted(EndpointInfoPair.Value->SentMessages);
+	}
+
+	for (auto& InterceptorInfoPair : Interceptors)
+	{
+		RemoveEvicted(InterceptorInfoPair.Value->InterceptedMessages);
+	}
+
+	FNotification& Notification = PendingNotifications.AddDefaulted_GetRef();
+	Notification.Type = ENotification::MessagesEvicted;
+	Notification.NumEvicted = NumEvicted;
+}
+
+
+int64 FSGMessageTracer::EstimateMessageBytes(const FSGMessageTracerMessageInfo& MessageInfo)
+{
+	int64 Bytes = sizeof(FSGMessageTracerMessageInfo) + MessageInfo.DispatchStates.Num() * sizeof(FSGMessageTracerDispatchState);
+
+	if (MessageInfo.Context.IsValid())
+	{
+		Bytes += sizeof(FSGMessageContext) + MessageInfo.Context->GetRecipients().Num() * sizeof(FSGMessageAddress);
+
+		if (UScriptStruct* TypeInfo = MessageInfo.Context->GetMessageTypeInfo().Get())
+		{
+			Bytes += TypeInfo->GetStructureSize();
+		}
+	}
+
+	return Bytes;
+}
+
+
+bool FSGMessageTracer::ShouldSample(const ISGMessageContext& Context) const
+{
+	TSharedPtr<const FSamplingConfig, ESPMode::ThreadSafe> CurrentConfig;
+	{
+		FReadScopeLock ReadLock(SamplingConfigLock);
+		CurrentConfig = SamplingConfig;
+	}
+
+	if (CurrentConfig->bSampleAll)
+	{
+		return true;
+	}
+
+	const TSharedPtr<FSampler, ESPMode::ThreadSafe>* TypeSampler = CurrentConfig->TypeSamplers.Find(Context.GetMessageType());
+	const FSampler& Sampler = (TypeSampler != nullptr) ? **TypeSampler : *CurrentConfig->DefaultSampler;
+
+	if (Sampler.SampleRate <= 1)
+	{
+		return true;
+	}
+
+	return (Sampler.NumMessages.fetch_add(1, std::memory_order_relaxed) % Sampler.SampleRate) == 0;
+}
+
+
+bool FSGMessageTracer::ShouldBreak(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	// blocking the router requires another thread to continue it
+	const bool bCanBreak = FPlatformProcess::SupportsMultithreading();
+
+	if (bCanBreak && Breaking)
+	{
+		return true;
+	}
+
+	if (!bHasBreakpoints.load(std::memory_order_relaxed))
+	{
+		return false;
+	}
+
+	TSharedPtr<const FBreakpointTable, ESPMode::ThreadSafe> CurrentTable;
+	{
+		FReadScopeLock ReadLock(BreakpointTableLock);
+		CurrentTable = BreakpointTable;
+	}
+
+	if (!CurrentTable.IsValid())
+	{
+		return false;
+	}
+
+	const auto* TypeBreakpoints = CurrentTable->TypeBreakpoints.Find(Context->GetMessageType());
+	const auto& CandidateBreakpoints = (TypeBreakpoints != nullptr) ? *TypeBreakpoints : CurrentTable->AllTypeBreakpoints;
+	bool bShouldBreak = false;
+	bool bCaptured = false;
+
+	for (const auto& Breakpoint : CandidateBreakpoints)
+	{
+		if (!Breakpoint->IsEnabled() || !Breakpoint->ShouldBreak(Context))
+		{
+			continue;
+		}
+
+		if (Breakpoint->GetAction() == ESGMessageTracerBreakpointAction::Capture)
+		{
+			// a message is captured once, even if it hits several capture breakpoints
+			if (bCaptured)
+			{
+				continue;
+			}
+
+			FScopeLock Lock(&CapturedMessagesCriticalSection);
+
+			if (CapturedMessages.Num() < MaxCapturedMessages)
+			{
+				CapturedMessages.Add(Context);
+			}
+			else
+			{
+				CapturedMessages[CapturedMessagesHead] = Context;
+				CapturedMessagesHead = (CapturedMessagesHead + 1) % MaxCapturedMessages;
+			}
+
+			bCaptured = true;
+		}
+		else if (bCanBreak)
 		{
-			return true;
+			bShouldBreak = true;
 		}
+	}
+
+	return bShouldBreak;
+}
+
 
-		for (const auto& Breakpoint : Breakpoints)
+void FSGMessageTracer::CompileBreakpoints()
+{
+	TSharedPtr<FBreakpointTable, ESPMode::ThreadSafe> NewTable;
+
+	if (Breakpoints.Num() > 0)
+	{
+		NewTable = MakeShared<FBreakpointTable, ESPMode::ThreadSafe>();
+
+		for (const FBreakpoint& Breakpoint : Breakpoints)
+		{
+			if (Breakpoint.MessageTypes.Num() == 0)
+			{
+				NewTable->AllTypeBreakpoints.Add(Breakpoint.Breakpoint);
+			}
+		}
+
+		// message types with their own breakpoints also get the breakpoints of all types, in the order they were added
+		for (const FBreakpoint& Breakpoint : Breakpoints)
+		{
+			for (const FName& MessageType : Breakpoint.MessageTypes)
+			{
+				NewTable->TypeBreakpoints.FindOrAdd(MessageType);
+			}
+		}
+
+		for (auto& TypeBreakpointsPair : NewTable->TypeBreakpoints)
 		{
-			if (Breakpoint->IsEnabled() && Breakpoint->ShouldBreak(Context))
+			for (const FBreakpoint& Breakpoint : Breakpoints)
 			{
-				return true;
+				if ((Breakpoint.MessageTypes.Num() == 0) || Breakpoint.MessageTypes.Contains(TypeBreakpointsPair.Key))
+				{
+					TypeBreakpointsPair.Value.AddUnique(Breakpoint.Breakpoint);
+				}
 			}
 		}
 	}
 
-	return false;
+	{
+		FWriteScopeLock WriteLock(BreakpointTableLock);
+		BreakpointTable = NewTable;
+	}
+
+	bHasBreakpoints.store(NewTable.IsValid());
 }
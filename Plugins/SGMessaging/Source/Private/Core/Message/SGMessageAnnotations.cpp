@@ -0,0 +1,196 @@
+#include "Core/Message/SGMessageAnnotations.h"
+#include "Misc/ScopeLock.h"
+
+
+/** Structure for the interned annotation blocks. */
+struct FSGMessageAnnotations::FInternTable
+{
+	/** Maximum number of interned blocks, so that annotations built from dynamic values don't grow the table without bounds. */
+	static constexpr int32 MaxBlocks = 1024;
+
+	/** Guards the table, annotations may be interned on any thread. */
+	FCriticalSection CriticalSection;
+
+	/** Holds the interned blocks by hash. */
+	TMultiMap<uint32, TSharedPtr<const FBlock, ESPMode::ThreadSafe>> Blocks;
+};
+
+
+/* FSGMessageAnnotations structors
+ *****************************************************************************/
+
+FSGMessageAnnotations::FSGMessageAnnotations(const TMap<FName, FString>& InAnnotations)
+{
+	if (InAnnotations.Num() == 0)
+	{
+		return;
+	}
+
+	TSharedRef<FBlock, ESPMode::ThreadSafe> NewBlock = MakeShared<FBlock, ESPMode::ThreadSafe>();
+	NewBlock->Entries.Reserve(InAnnotations.Num());
+
+	for (const auto& Annotation : InAnnotations)
+	{
+		NewBlock->Entries.Emplace(Annotation.Key, Annotation.Value);
+	}
+
+	FinishBlock(*NewBlock);
+	Block = NewBlock;
+}
+
+
+FSGMessageAnnotations::FSGMessageAnnotations(std::initializer_list<TPairInitializer<const FName&, const FString&>> InAnnotations)
+{
+	if (InAnnotations.size() == 0)
+	{
+		return;
+	}
+
+	TSharedRef<FBlock, ESPMode::ThreadSafe> NewBlock = MakeShared<FBlock, ESPMode::ThreadSafe>();
+	NewBlock->Entries.Reserve((int32)InAnnotations.size());
+
+	for (const auto& Annotation : InAnnotations)
+	{
+		NewBlock->Entries.Emplace(Annotation.Key, Annotation.Value);
+	}
+
+	FinishBlock(*NewBlock);
+	Block = NewBlock;
+}
+
+
+/* FSGMessageAnnotations interface
+ *****************************************************************************/
+
+FSGMessageAnnotations FSGMessageAnnotations::Intern(const FSGMessageAnnotations& Annotations)
+{
+	if (!Annotations.Block.IsValid())
+	{
+		return Annotations;
+	}
+
+	FInternTable& Table = GetInternTable();
+	FScopeLock Lock(&Table.CriticalSection);
+
+	TArray<TSharedPtr<const FBlock, ESPMode::ThreadSafe>, TInlineAllocator<4>> Candidates;
+	Table.Blocks.MultiFind(Annotations.Block->Hash, Candidates);
+
+	for (const auto& Candidate : Candidates)
+	{
+		if ((Candidate == Annotations.Block) || (Candidate->Entries == Annotations.Block->Entries))
+		{
+			FSGMessageAnnotations Interned;
+			Interned.Block = Candidate;
+
+			return Interned;
+		}
+	}
+
+	if (Table.Blocks.Num() < FInternTable::MaxBlocks)
+	{
+		Table.Blocks.Add(Annotations.Block->Hash, Annotations.Block);
+	}
+
+	return Annotations;
+}
+
+
+const FSGMessageAnnotations& FSGMessageAnnotations::GetEmpty()
+{
+	static const FSGMessageAnnotations Empty;
+
+	return Empty;
+}
+
+
+FSGMessageAnnotations FSGMessageAnnotations::With(const FName& Key, const FString& Value) const
+{
+	TSharedRef<FBlock, ESPMode::ThreadSafe> NewBlock = MakeShared<FBlock, ESPMode::ThreadSafe>();
+
+	if (Block.IsValid())
+	{
+		NewBlock->Entries = Block->Entries;
+	}
+
+	// the new annotation comes last, so it wins over an existing value
+	NewBlock->Entries.Emplace(Key, Value);
+
+	FinishBlock(*NewBlock);
+
+	FSGMessageAnnotations Result;
+	Result.Block = NewBlock;
+
+	return Result;
+}
+
+
+TMap<FName, FString> FSGMessageAnnotations::ToMap() const
+{
+	TMap<FName, FString> Map;
+
+	if (Block.IsValid())
+	{
+		Map.Reserve(Block->Entries.Num());
+
+		for (const FEntry& Entry : Block->Entries)
+		{
+			Map.Add(Entry.Key, Entry.Value);
+		}
+	}
+
+	return Map;
+}
+
+
+bool FSGMessageAnnotations::operator==(const FSGMessageAnnotations& Other) const
+{
+	if (Block == Other.Block)
+	{
+		return true;
+	}
+
+	if (!Block.IsValid() || !Other.Block.IsValid() || (Block->Hash != Other.Block->Hash))
+	{
+		return false;
+	}
+
+	return Block->Entries == Other.Block->Entries;
+}
+
+
+/* FSGMessageAnnotations implementation
+ *****************************************************************************/
+
+void FSGMessageAnnotations::FinishBlock(FBlock& NewBlock)
+{
+	NewBlock.Entries.StableSort([](const FEntry& A, const FEntry& B)
+	{
+		return A.Key.LexicalLess(B.Key);
+	});
+
+	// keep the last of repeated keys
+	for (int32 Index = NewBlock.Entries.Num() - 1; Index > 0; --Index)
+	{
+		if (NewBlock.Entries[Index - 1].Key == NewBlock.Entries[Index].Key)
+		{
+			NewBlock.Entries.RemoveAt(Index - 1, 1, false);
+		}
+	}
+
+	uint32 Hash = 0;
+
+	for (const FEntry& Entry : NewBlock.Entries)
+	{
+		Hash = HashCombine(Hash, HashCombine(GetTypeHash(Entry.Key), GetTypeHash(Entry.Value)));
+	}
+
+	NewBlock.Hash = Hash;
+}
+
+
+FSGMessageAnnotations::FInternTable& FSGMessageAnnotations::GetInternTable()
+{
+	static FInternTable Table;
+
+	return Table;
+}
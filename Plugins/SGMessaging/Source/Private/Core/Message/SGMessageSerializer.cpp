@@ -0,0 +1,202 @@
+#include "Core/Message/SGMessageSerializer.h"
+#include "Core/Interface/ISGMessagingModule.h"
+
+
+namespace SGMessageSerializer
+{
+	/** Keys are written as (Index << 1) | 1 if they are interned, or as (Length << 1) followed by the string otherwise. */
+	void WriteKey(FSGWireWriter& Writer, FName Key, const FSGMessageKeyTable* KeyTable)
+	{
+		const int32 Index = (KeyTable != nullptr) ? KeyTable->Find(Key) : INDEX_NONE;
+
+		if (Index != INDEX_NONE)
+		{
+			Writer.WriteVarint(((uint64)Index << 1) | 1);
+
+			return;
+		}
+
+		const FString KeyString = Key.ToString();
+		const FTCHARToUTF8 Utf8(*KeyString, KeyString.Len());
+
+		Writer.WriteVarint((uint64)Utf8.Length() << 1);
+		Writer.WriteBytes(Utf8.Get(), Utf8.Length());
+	}
+
+	bool ReadKey(FSGWireReader& Reader, FName& OutKey, FSGMessageKeyTable* KeyTable)
+	{
+		uint64 Tag;
+
+		if (!Reader.ReadVarint(Tag))
+		{
+			return false;
+		}
+
+		if ((Tag & 1) != 0)
+		{
+			return (KeyTable != nullptr) && (Tag >> 1 <= MAX_int32) && KeyTable->Get((int32)(Tag >> 1), OutKey);
+		}
+
+		const uint64 Length = Tag >> 1;
+		const uint8* Data = Reader.ReadBytes(Length <= MAX_int32 ? (int64)Length : -1);
+
+		if (Data == nullptr)
+		{
+			return false;
+		}
+
+		const FUTF8ToTCHAR Converted((const ANSICHAR*)Data, (int32)Length);
+
+		OutKey = FName(Converted.Length(), Converted.Get());
+
+		if (KeyTable != nullptr)
+		{
+			KeyTable->Add(OutKey);
+		}
+
+		return true;
+	}
+
+	/** Decodes a parameter of the given type and adds it to a message. */
+	template <typename T>
+	bool ReadParam(FName Key, TArrayView<const uint8> Bytes, FSGMessage& OutMessage)
+	{
+		FSGWireReader Reader(Bytes);
+		T Value;
+
+		if (!TSGWireTraits<T>::Read(Reader, Value) || !Reader.IsAtEnd())
+		{
+			return false;
+		}
+
+		OutMessage.Set(Key, MoveTemp(Value));
+
+		return true;
+	}
+}
+
+
+/* FSGMessageSerializer interface
+ *****************************************************************************/
+
+bool FSGMessageSerializer::Serialize(const FSGMessage& Message, TArray<uint8>& OutBytes, FSGMessageKeyTable* KeyTable)
+{
+	FSGWireWriter Writer(OutBytes);
+	bool bComplete = true;
+
+	Writer.WriteByte((uint8)ESGMessageWireVersion::Latest);
+
+	Message.GetParams().ForEach([&Writer, &bComplete, KeyTable](FName Key, const FSGAny& Value)
+	{
+		TArray<uint8>& Bytes = Writer.GetBytes();
+		const int32 FieldOffset = Bytes.Num();
+
+		SGMessageSerializer::WriteKey(Writer, Key, KeyTable);
+
+		if (!Value.Write(Writer))
+		{
+			Bytes.SetNum(FieldOffset, false);
+			bComplete = false;
+
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Skipped message parameter '%s', its type can't be serialized"), *Key.ToString());
+		}
+		else if (KeyTable != nullptr)
+		{
+			// intern only keys that were written, so that the reader's table gets the same indices
+			KeyTable->Add(Key);
+		}
+	});
+
+	return bComplete;
+}
+
+
+/* FSGMessageReader structors
+ *****************************************************************************/
+
+FSGMessageReader::FSGMessageReader(TArrayView<const uint8> InBytes, FSGMessageKeyTable* KeyTable)
+	: bValid(false)
+{
+	FSGWireReader Reader(InBytes);
+	uint8 Version;
+
+	if (!Reader.ReadByte(Version) || (Version == 0) || (Version > (uint8)ESGMessageWireVersion::Latest))
+	{
+		return;
+	}
+
+	while (!Reader.IsAtEnd())
+	{
+		FField Field;
+		uint8 Type;
+
+		if (!SGMessageSerializer::ReadKey(Reader, Field.Key, KeyTable) || !Reader.ReadByte(Type) || !Reader.ReadSized(Field.Value))
+		{
+			Fields.Empty();
+
+			return;
+		}
+
+		Field.Type = (ESGAnyTypes)Type;
+		Fields.Add(Field);
+	}
+
+	bValid = true;
+}
+
+
+/* FSGMessageReader interface
+ *****************************************************************************/
+
+int32 FSGMessageReader::ReadMessage(FSGMessage& OutMessage) const
+{
+	int32 NumSkipped = 0;
+
+	for (const FField& Field : Fields)
+	{
+		bool bRead = false;
+
+		switch (Field.Type)
+		{
+		case ESGAnyTypes::Int8: bRead = SGMessageSerializer::ReadParam<int8>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::UInt8: bRead = SGMessageSerializer::ReadParam<uint8>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Int16: bRead = SGMessageSerializer::ReadParam<int16>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::UInt16: bRead = SGMessageSerializer::ReadParam<uint16>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Int32: bRead = SGMessageSerializer::ReadParam<int32>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::UInt32: bRead = SGMessageSerializer::ReadParam<uint32>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Int64: bRead = SGMessageSerializer::ReadParam<int64>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::UInt64: bRead = SGMessageSerializer::ReadParam<uint64>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Float: bRead = SGMessageSerializer::ReadParam<float>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Double: bRead = SGMessageSerializer::ReadParam<double>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::Bool: bRead = SGMessageSerializer::ReadParam<bool>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::FName: bRead = SGMessageSerializer::ReadParam<FName>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::FString: bRead = SGMessageSerializer::ReadParam<FString>(Field.Key, Field.Value, OutMessage); break;
+		case ESGAnyTypes::FText: bRead = SGMessageSerializer::ReadParam<FText>(Field.Key, Field.Value, OutMessage); break;
+		default: break;
+		}
+
+		if (!bRead)
+		{
+			++NumSkipped;
+		}
+	}
+
+	return NumSkipped;
+}
+
+
+/* FSGMessageReader implementation
+ *****************************************************************************/
+
+const FSGMessageReader::FField* FSGMessageReader::FindField(FName Key) const
+{
+	for (const FField& Field : Fields)
+	{
+		if (Field.Key == Key)
+		{
+			return &Field;
+		}
+	}
+
+	return nullptr;
+}
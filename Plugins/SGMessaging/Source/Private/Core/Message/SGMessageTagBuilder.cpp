@@ -0,0 +1,80 @@
+#include "Core/Message/SGMessageTagBuilder.h"
+
+
+namespace SGMessageTagBuilder
+{
+	/** Maximum number of tags a thread caches, since dynamic tags may be created at any rate. */
+	constexpr int32 MaxCachedTags = 4096;
+
+	/** Structure for a thread's cache of message tags. */
+	struct FThreadCache
+	{
+		/** Holds the names of packed tags. */
+		TMap<uint64, FName> Names;
+
+		/** Holds the topic identifiers of names (unset for names that aren't tags). */
+		TMap<FName, TOptional<int32>> TopicIDs;
+	};
+
+	thread_local FThreadCache ThreadCache;
+}
+
+
+/* FSGMessageTagBuilder interface
+ *****************************************************************************/
+
+#if MESSAGE_TAG_WITH_TOPIC
+FName FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_SIGNATURE)
+{
+	using namespace SGMessageTagBuilder;
+
+	const uint64 PackedTag = Pack(MESSAGE_TAG_PARAM_VALUE);
+
+	if (const FName* Name = ThreadCache.Names.Find(PackedTag))
+	{
+		return *Name;
+	}
+
+	if (ThreadCache.Names.Num() >= MaxCachedTags)
+	{
+		ThreadCache.Names.Reset();
+	}
+
+	const FName Name(*FString::Printf(TEXT("%d:%d"), TOPIC_ID, MESSAGE_ID));
+
+	ThreadCache.Names.Add(PackedTag, Name);
+
+	if (ThreadCache.TopicIDs.Num() < MaxCachedTags)
+	{
+		ThreadCache.TopicIDs.Add(Name, TOptional<int32>(TOPIC_ID));
+	}
+
+	return Name;
+}
+#endif
+
+
+bool FSGMessageTagBuilder::TryParseTopicID(const FName& MessageTag, int32& OutTopicID)
+{
+	using namespace SGMessageTagBuilder;
+
+	if (const TOptional<int32>* TopicID = ThreadCache.TopicIDs.Find(MessageTag))
+	{
+		OutTopicID = TopicID->Get(0);
+
+		return TopicID->IsSet();
+	}
+
+	if (ThreadCache.TopicIDs.Num() >= MaxCachedTags)
+	{
+		ThreadCache.TopicIDs.Reset();
+	}
+
+	int32 TopicID = 0;
+	const bool bIsTopicTag = ParseTopicID(MessageTag, TopicID);
+
+	ThreadCache.TopicIDs.Add(MessageTag, bIsTopicTag ? TOptional<int32>(TopicID) : TOptional<int32>());
+	OutTopicID = TopicID;
+
+	return bIsTopicTag;
+}
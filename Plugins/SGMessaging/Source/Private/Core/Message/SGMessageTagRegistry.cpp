@@ -0,0 +1,117 @@
+#include "Core/Message/SGMessageTagRegistry.h"
+#include "Core/Interface/ISGMessagingModule.h"
+
+
+/* FSGMessageTagRegistry interface
+ *****************************************************************************/
+
+FSGMessageTagRegistry& FSGMessageTagRegistry::Get()
+{
+	static FSGMessageTagRegistry Registry;
+
+	return Registry;
+}
+
+
+int32 FSGMessageTagRegistry::Register(int32 TopicID, int32 MessageID, const TCHAR* DebugName, const TCHAR* PayloadTypeName)
+{
+	FScopeLock Lock(&CriticalSection);
+
+	const uint64 PackedTag = FSGMessageTagBuilder::Pack(TopicID, MessageID);
+
+	if (const int32* ExistingIndex = Indices.Find(PackedTag))
+	{
+		const FSGRegisteredMessageTag& Existing = Tags[*ExistingIndex];
+
+		// the same declaration may be registered by several modules that include it
+		if (FCString::Strcmp(Existing.DebugName, DebugName) != 0)
+		{
+			if (bInitialized)
+			{
+				ReportCollision(Existing, DebugName);
+			}
+			else
+			{
+				PendingCollisions.Emplace(*ExistingIndex, DebugName);
+			}
+		}
+
+		return *ExistingIndex;
+	}
+
+	FSGRegisteredMessageTag& Tag = Tags.AddDefaulted_GetRef();
+	{
+		Tag.TopicID = TopicID;
+		Tag.MessageID = MessageID;
+		Tag.Index = Tags.Num() - 1;
+		Tag.DebugName = DebugName;
+		Tag.PayloadTypeName = PayloadTypeName;
+	}
+
+	Indices.Add(PackedTag, Tag.Index);
+
+	return Tag.Index;
+}
+
+
+bool FSGMessageTagRegistry::Find(int32 TopicID, int32 MessageID, FSGRegisteredMessageTag& OutTag) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	if (const int32* Index = Indices.Find(FSGMessageTagBuilder::Pack(TopicID, MessageID)))
+	{
+		OutTag = Tags[*Index];
+
+		return true;
+	}
+
+	return false;
+}
+
+
+bool FSGMessageTagRegistry::Find(const FName& MessageTag, FSGRegisteredMessageTag& OutTag) const
+{
+	FString TopicString;
+	FString MessageString;
+
+	if (!MessageTag.ToString().Split(TEXT(":"), &TopicString, &MessageString, ESearchCase::CaseSensitive) ||
+		!FCString::IsNumeric(*TopicString) || !FCString::IsNumeric(*MessageString))
+	{
+		return false;
+	}
+
+	return Find(FCString::Atoi(*TopicString), FCString::Atoi(*MessageString), OutTag);
+}
+
+
+TArray<FSGRegisteredMessageTag> FSGMessageTagRegistry::GetTags() const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	return Tags;
+}
+
+
+void FSGMessageTagRegistry::Initialize()
+{
+	FScopeLock Lock(&CriticalSection);
+
+	for (const auto& Collision : PendingCollisions)
+	{
+		ReportCollision(Tags[Collision.Key], Collision.Value);
+	}
+
+	PendingCollisions.Empty();
+	bInitialized = true;
+}
+
+
+/* FSGMessageTagRegistry implementation
+ *****************************************************************************/
+
+void FSGMessageTagRegistry::ReportCollision(const FSGRegisteredMessageTag& Existing, const TCHAR* DebugName)
+{
+	UE_LOG(LogSGMessaging, Error, TEXT("Message tag %s (%d:%d) collides with message tag %s"), DebugName, Existing.TopicID, Existing.MessageID, Existing.DebugName);
+
+	ensureMsgf(false, TEXT("Message tag %s (%d:%d) collides with message tag %s"), DebugName, Existing.TopicID, Existing.MessageID, Existing.DebugName);
+}
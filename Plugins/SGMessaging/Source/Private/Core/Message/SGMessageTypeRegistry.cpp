@@ -0,0 +1,107 @@
+#include "Core/Message/SGMessageTypeRegistry.h"
+#include "Core/Interface/ISGMessage.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessagingModule.h"
+
+
+/* FSGMessageTypeRegistry interface
+ *****************************************************************************/
+
+FSGMessageTypeRegistry& FSGMessageTypeRegistry::Get()
+{
+	static FSGMessageTypeRegistry Registry;
+
+	return Registry;
+}
+
+
+FSGRegisteredMessageType FSGMessageTypeRegistry::Register(UScriptStruct* Struct)
+{
+	check(Struct != nullptr);
+
+	FScopeLock Lock(&CriticalSection);
+
+	if (const int32* ExistingId = StructIds.Find(Struct))
+	{
+		return Types[*ExistingId];
+	}
+
+	FSGRegisteredMessageType& Type = Types.AddDefaulted_GetRef();
+	{
+		Type.Struct = Struct;
+		Type.Name = Struct->GetFName();
+		Type.Id = Types.Num() - 1;
+	}
+
+	StructIds.Add(Struct, Type.Id);
+	NumTypes.store(Types.Num(), std::memory_order_release);
+
+	return Type;
+}
+
+
+int32 FSGMessageTypeRegistry::GetTypeId(UScriptStruct* Struct)
+{
+	if (Struct == nullptr)
+	{
+		return INDEX_NONE;
+	}
+
+	// the last structure is checked first, since threads tend to send bursts of the same type
+	static thread_local const UScriptStruct* LastStruct = nullptr;
+	static thread_local int32 LastId = INDEX_NONE;
+	static thread_local TMap<const UScriptStruct*, int32> ThreadIds;
+
+	if (Struct == LastStruct)
+	{
+		return LastId;
+	}
+
+	int32* CachedId = ThreadIds.Find(Struct);
+
+	if (CachedId == nullptr)
+	{
+		CachedId = &ThreadIds.Add(Struct, Register(Struct).Id);
+	}
+
+	LastStruct = Struct;
+	LastId = *CachedId;
+
+	return LastId;
+}
+
+
+void FSGMessageTypeRegistry::GetTypeNames(TArray<FName>& OutNames) const
+{
+	FScopeLock Lock(&CriticalSection);
+
+	OutNames.Reset(Types.Num());
+
+	for (const FSGRegisteredMessageType& Type : Types)
+	{
+		OutNames.Add(Type.Name);
+	}
+}
+
+
+void FSGMessageTypeRegistry::ReportMismatchedMessage(const ISGMessageContext& Context, const FName& ExpectedType)
+{
+	const FName MessageTag = Context.GetMessageType();
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		bool bAlreadyReported = false;
+		ReportedMismatches.Add(TPair<FName, FName>(MessageTag, ExpectedType), &bAlreadyReported);
+
+		if (bAlreadyReported)
+		{
+			return;
+		}
+	}
+
+	const ISGMessage* TaggedMessage = Context.GetTaggedMessage();
+	const UScriptStruct* TypeInfo = Context.GetMessageTypeInfo().Get();
+	const FName ActualType = (TaggedMessage != nullptr) ? TaggedMessage->GetFName() : ((TypeInfo != nullptr) ? TypeInfo->GetFName() : NAME_None);
+
+	UE_LOG(LogSGMessaging, Warning, TEXT("Dropping %s messages of type %s for a handler of %s"), *MessageTag.ToString(), *ActualType.ToString(), *ExpectedType.ToString());
+}
@@ -0,0 +1,50 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGNetworkEndpoint.h"
+
+
+/* FSGNetworkEndpoint interface
+ *****************************************************************************/
+
+bool FSGNetworkEndpoint::Parse(const FString& String, FSGNetworkEndpoint& OutEndpoint)
+{
+	FString AddressString;
+	FString PortString;
+
+	if (!String.TrimStartAndEnd().Split(TEXT(":"), &AddressString, &PortString))
+	{
+		return false;
+	}
+
+	TArray<FString> Components;
+
+	if ((AddressString.ParseIntoArray(Components, TEXT("."), false) != 4) || !PortString.IsNumeric())
+	{
+		return false;
+	}
+
+	uint32 Address = 0;
+
+	for (const FString& Component : Components)
+	{
+		const int32 Value = Component.IsNumeric() ? FCString::Atoi(*Component) : -1;
+
+		if ((Value < 0) || (Value > 255))
+		{
+			return false;
+		}
+
+		Address = (Address << 8) | (uint32)Value;
+	}
+
+	const int32 Port = FCString::Atoi(*PortString);
+
+	if ((Port < 0) || (Port > 65535))
+	{
+		return false;
+	}
+
+	OutEndpoint = FSGNetworkEndpoint(Address, (uint16)Port);
+
+	return true;
+}
@@ -0,0 +1,895 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGSharedMemoryMessageTransport.h"
+#include "HAL/PlatformTime.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageTransportHandler.h"
+#include "Core/Interface/ISGMessagingModule.h"
+
+
+namespace SGSharedMemoryMessageTransport
+{
+	/** Version of the shared memory layout. */
+	constexpr uint32 LayoutVersion = 3;
+
+	/** Largest number of transports on a channel. */
+	constexpr int32 MaxNodes = 16;
+
+	/** Size of each ring's buffer (must be a power of two). */
+	constexpr uint32 RingCapacity = 512 * 1024;
+
+	/** Largest size of an encoded message. */
+	constexpr int32 MaxMessageSize = RingCapacity / 4;
+
+	/** Size of a record's length prefix. */
+	constexpr uint32 RecordHeaderSize = sizeof(uint32);
+
+	/** Alignment of the records in a ring. */
+	constexpr uint32 RecordAlignment = 8;
+
+	/** Length prefix of the record that skips the rest of the ring's buffer. */
+	constexpr uint32 PaddingRecord = MAX_uint32;
+
+	/** Time between heartbeats (in seconds). */
+	constexpr double HeartbeatInterval = 0.25;
+
+	/** Time after which peers without heartbeats are forgotten (in seconds). */
+	constexpr double NodeTimeout = 2.0;
+
+	/** Access mode of all mapped regions. */
+	constexpr uint32 AccessMode = FPlatformMemory::ESharedMemoryAccess::Read | FPlatformMemory::ESharedMemoryAccess::Write;
+
+	/** Enumerates the states of directory slots and rings (zero-filled memory is free). */
+	enum EState : uint32
+	{
+		Free = 0,
+		Claiming,
+		Live,
+		Closed
+	};
+
+	// atomics in shared memory must not depend on process-local locks
+	static_assert(std::atomic<uint32>::is_always_lock_free && std::atomic<uint64>::is_always_lock_free, "Shared memory atomics must be lock-free");
+
+	/** Structure for a transport's entry in the directory. */
+	struct FDirectorySlot
+	{
+		std::atomic<uint32> State;
+		uint32 ProcessId;
+		FGuid NodeId;
+		std::atomic<uint64> Heartbeat;
+	};
+
+	/** Structure for the directory of a channel. */
+	struct FDirectory
+	{
+		std::atomic<uint64> Id;
+		std::atomic<uint32> Version;
+		FDirectorySlot Slots[MaxNodes];
+	};
+
+	/** Structure for the header of an inbox. */
+	struct alignas(64) FInboxHeader
+	{
+		std::atomic<uint32> Version;
+		alignas(64) std::atomic<uint32> bSleeping;
+	};
+
+	/** Structure for the header of a ring, followed by its buffer. */
+	struct alignas(64) FRing
+	{
+		std::atomic<uint32> State;
+		FGuid WriterId;
+		alignas(64) std::atomic<uint64> Head;
+		alignas(64) std::atomic<uint64> Tail;
+	};
+
+	/** Size of a ring including its buffer. */
+	constexpr SIZE_T RingStride = sizeof(FRing) + RingCapacity;
+
+	/** Size of an inbox. */
+	constexpr SIZE_T InboxSize = sizeof(FInboxHeader) + MaxNodes * RingStride;
+
+	/** Gets the header of a mapped inbox. */
+	FInboxHeader& GetInboxHeader(FPlatformMemory::FSharedMemoryRegion* Inbox)
+	{
+		return *reinterpret_cast<FInboxHeader*>(Inbox->GetAddress());
+	}
+
+	/** Gets a ring of a mapped inbox. */
+	FRing& GetRing(FPlatformMemory::FSharedMemoryRegion* Inbox, int32 RingIndex)
+	{
+		return *reinterpret_cast<FRing*>(static_cast<uint8*>(Inbox->GetAddress()) + sizeof(FInboxHeader) + RingIndex * RingStride);
+	}
+
+	/** Gets the buffer of a ring. */
+	uint8* GetRingData(FRing& Ring)
+	{
+		return reinterpret_cast<uint8*>(&Ring + 1);
+	}
+
+	/** Gets the mapped directory. */
+	FDirectory& GetDirectory(FPlatformMemory::FSharedMemoryRegion* Region)
+	{
+		return *reinterpret_cast<FDirectory*>(Region->GetAddress());
+	}
+}
+
+
+/**
+ * Structure for the mapped inbox of a peer.
+ */
+struct FSGSharedMemoryMessageTransport::FPeer
+{
+	/** Holds the peer's node identifier. */
+	FGuid NodeId;
+
+	/** Holds the peer's mapped inbox (nullptr once closed). */
+	FPlatformMemory::FSharedMemoryRegion* Inbox = nullptr;
+
+	/** Holds the peer's semaphore. */
+	FPlatformProcess::FSemaphore* WakeSemaphore = nullptr;
+
+	/** Holds the index of the ring that this transport writes to. */
+	int32 RingIndex = INDEX_NONE;
+
+	/** Holds a flag indicating that the peer released the ring. */
+	std::atomic<bool> bRingLost { false };
+
+	/** Serializes the writers of the ring. */
+	FCriticalSection WriteCriticalSection;
+};
+
+
+/**
+ * Implements the runnable of the receiver thread.
+ */
+class FSGSharedMemoryMessageTransport::FReceiver
+	: public FRunnable
+{
+public:
+
+	explicit FReceiver(FSGSharedMemoryMessageTransport& InTransport)
+		: Transport(InTransport)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Transport.ReceiveMessages();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Transport.bStopping.store(true);
+		Transport.WakeSemaphore->Unlock();
+	}
+
+private:
+
+	/** Holds the transport. */
+	FSGSharedMemoryMessageTransport& Transport;
+};
+
+
+/* FSGSharedMemoryMessageTransport structors
+ *****************************************************************************/
+
+FSGSharedMemoryMessageTransport::FSGSharedMemoryMessageTransport(const FString& InChannelName)
+	: ChannelName(InChannelName)
+	, NodeId(FGuid::NewGuid())
+	, Handler(nullptr)
+	, bStopping(false)
+	, ReceiverThread(nullptr)
+	, DirectoryRegion(nullptr)
+	, DirectoryId(0)
+	, DirectorySlotIndex(INDEX_NONE)
+	, InboxRegion(nullptr)
+	, WakeSemaphore(nullptr)
+	, NumSentMessages(0)
+	, NumDroppedMessages(0)
+	, NumReceivedMessages(0)
+{ }
+
+
+FSGSharedMemoryMessageTransport::~FSGSharedMemoryMessageTransport()
+{
+	StopTransport();
+}
+
+
+/* ISGMessageTransport interface
+ *****************************************************************************/
+
+FName FSGSharedMemoryMessageTransport::GetDebugName() const
+{
+	return TEXT("SGSharedMemoryMessageTransport");
+}
+
+
+bool FSGSharedMemoryMessageTransport::StartTransport(ISGMessageTransportHandler& InHandler)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	if (Handler != nullptr)
+	{
+		return true;
+	}
+
+	// the inbox must exist before peers can find this transport in the directory
+	InboxRegion = FPlatformMemory::MapNamedSharedMemoryRegion(GetInboxName(NodeId), true, AccessMode, InboxSize);
+	WakeSemaphore = (InboxRegion != nullptr) ? FPlatformProcess::NewInterprocessSynchObject(GetWakeName(NodeId), true) : nullptr;
+
+	if (WakeSemaphore == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't start shared memory message transport on channel %s, its inbox can't be created"), *ChannelName);
+
+		CloseRegions();
+
+		return false;
+	}
+
+	GetInboxHeader(InboxRegion).Version.store(LayoutVersion, std::memory_order_release);
+
+	if (!OpenDirectory())
+	{
+		CloseRegions();
+
+		return false;
+	}
+
+	Handler = &InHandler;
+	bStopping.store(false);
+
+	Receiver = MakeUnique<FReceiver>(*this);
+	ReceiverThread = FRunnableThread::Create(Receiver.Get(), TEXT("FSGSharedMemoryMessageTransport.Receiver"), 128 * 1024, TPri_AboveNormal);
+
+	if (ReceiverThread == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't start shared memory message transport on channel %s, its receiver thread can't be created"), *ChannelName);
+
+		StopTransport();
+
+		return false;
+	}
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Started shared memory message transport on channel %s (node %s)"), *ChannelName, *NodeId.ToString());
+
+	return true;
+}
+
+
+void FSGSharedMemoryMessageTransport::StopTransport()
+{
+	if (Handler == nullptr)
+	{
+		return;
+	}
+
+	if (ReceiverThread != nullptr)
+	{
+		ReceiverThread->Kill(true);
+		delete ReceiverThread;
+		ReceiverThread = nullptr;
+	}
+
+	Receiver.Reset();
+
+	{
+		FScopeLock Lock(&PeersCriticalSection);
+
+		for (const auto& PeerPair : Peers)
+		{
+			ClosePeer(*PeerPair.Value);
+		}
+
+		Peers.Empty();
+	}
+
+	ObservedNodes.Empty();
+	CloseRegions();
+	Handler = nullptr;
+}
+
+
+bool FSGSharedMemoryMessageTransport::TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients)
+{
+	if (Handler == nullptr)
+	{
+		return false;
+	}
+
+	TArray<uint8> Message;
+
+	if (!Codec.EncodeMessage(*Context, Message))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Can't transport %s message, its payload can't be encoded"), *Context->GetMessageType().ToString());
+
+		return false;
+	}
+
+	if (Message.Num() > SGSharedMemoryMessageTransport::MaxMessageSize)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't transport %s message, it is larger than %d bytes"), *Context->GetMessageType().ToString(), SGSharedMemoryMessageTransport::MaxMessageSize);
+
+		return false;
+	}
+
+	TArray<TSharedRef<FPeer, ESPMode::ThreadSafe>, TInlineAllocator<SGSharedMemoryMessageTransport::MaxNodes>> RecipientPeers;
+	{
+		FScopeLock Lock(&PeersCriticalSection);
+
+		if (Recipients.Num() == 0)
+		{
+			Peers.GenerateValueArray(RecipientPeers);
+		}
+		else
+		{
+			for (const FGuid& Recipient : Recipients)
+			{
+				if (const TSharedRef<FPeer, ESPMode::ThreadSafe>* Peer = Peers.Find(Recipient))
+				{
+					RecipientPeers.Add(*Peer);
+				}
+			}
+		}
+	}
+
+	for (const TSharedRef<FPeer, ESPMode::ThreadSafe>& Peer : RecipientPeers)
+	{
+		if (WriteMessage(*Peer, Message))
+		{
+			NumSentMessages.fetch_add(1, std::memory_order_relaxed);
+		}
+		else
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping %s message for shared memory transport node %s, its ring is full"), *Context->GetMessageType().ToString(), *Peer->NodeId.ToString());
+
+			NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	return true;
+}
+
+
+/* FSGSharedMemoryMessageTransport implementation
+ *****************************************************************************/
+
+void FSGSharedMemoryMessageTransport::ReceiveMessages()
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	FInboxHeader& InboxHeader = GetInboxHeader(InboxRegion);
+	double NextHeartbeatTime = 0.0;
+
+	while (!bStopping.load())
+	{
+		const double Now = FSGMessageClock::Seconds();
+
+		if (Now >= NextHeartbeatTime)
+		{
+			UpdateDirectory(Now);
+			NextHeartbeatTime = Now + HeartbeatInterval;
+		}
+
+		if (ReadRings())
+		{
+			continue;
+		}
+
+		// senders signal the semaphore if they see the flag, so rings are checked again after setting it
+		InboxHeader.bSleeping.store(1);
+
+		if (!ReadRings())
+		{
+			const double WaitTime = FMath::Max(NextHeartbeatTime - FSGMessageClock::Seconds(), 0.0);
+
+			WakeSemaphore->TryLock((uint64)(WaitTime * 1.0e9));
+		}
+
+		InboxHeader.bSleeping.store(0);
+	}
+}
+
+
+bool FSGSharedMemoryMessageTransport::ReadRings()
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	bool bRead = false;
+
+	for (int32 RingIndex = 0; RingIndex < MaxNodes; ++RingIndex)
+	{
+		FRing& Ring = GetRing(InboxRegion, RingIndex);
+		const uint32 State = Ring.State.load(std::memory_order_acquire);
+
+		if ((State != Live) && (State != Closed))
+		{
+			continue;
+		}
+
+		// writers claim rings before they are discovered, their messages wait until then
+		const FGuid WriterId = Ring.WriterId;
+
+		if (ObservedNodes.Contains(WriterId))
+		{
+			uint8* Data = GetRingData(Ring);
+			uint64 Tail = Ring.Tail.load(std::memory_order_relaxed);
+			const uint64 Head = Ring.Head.load(std::memory_order_acquire);
+
+			while (Tail < Head)
+			{
+				const uint32 Position = (uint32)(Tail & (RingCapacity - 1));
+				const uint32 RecordSize = *reinterpret_cast<const uint32*>(Data + Position);
+
+				if (RecordSize == PaddingRecord)
+				{
+					Tail += RingCapacity - Position;
+
+					continue;
+				}
+
+				if (RecordSize > RingCapacity - Position - RecordHeaderSize)
+				{
+					UE_LOG(LogSGMessaging, Warning, TEXT("Discarding corrupted ring of shared memory transport node %s"), *WriterId.ToString());
+
+					Tail = Head;
+
+					break;
+				}
+
+				// the message is decoded in place, then its space is returned to the writer
+				TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context = Codec.DecodeMessage(MakeArrayView(Data + Position + RecordHeaderSize, (int32)RecordSize));
+
+				Tail += Align(RecordHeaderSize + RecordSize, RecordAlignment);
+				Ring.Tail.store(Tail, std::memory_order_release);
+
+				if (Context.IsValid())
+				{
+					NumReceivedMessages.fetch_add(1, std::memory_order_relaxed);
+					Handler->ReceiveTransportMessage(Context.ToSharedRef(), WriterId);
+				}
+				else
+				{
+					UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding message from shared memory transport node %s"), *WriterId.ToString());
+				}
+
+				bRead = true;
+			}
+
+			Ring.Tail.store(Tail, std::memory_order_release);
+		}
+
+		// the writer closed the ring, and all of its messages were read
+		if (State == Closed)
+		{
+			Ring.State.store(Free, std::memory_order_release);
+		}
+	}
+
+	return bRead;
+}
+
+
+void FSGSharedMemoryMessageTransport::UpdateDirectory(double Now)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	// the process that created the directory unlinks it when it exits, and the others recreate it
+	FPlatformMemory::FSharedMemoryRegion* CurrentRegion = FPlatformMemory::MapNamedSharedMemoryRegion(ChannelName + TEXT(".Directory"), false, AccessMode, sizeof(FDirectory));
+	const bool bDirectoryReplaced = (CurrentRegion == nullptr) || (GetDirectory(CurrentRegion).Id.load() != DirectoryId);
+
+	if (CurrentRegion != nullptr)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(CurrentRegion);
+	}
+
+	if (bDirectoryReplaced || (DirectoryRegion == nullptr))
+	{
+		CloseDirectory();
+
+		if (!OpenDirectory())
+		{
+			return;
+		}
+	}
+
+	FDirectory& Directory = GetDirectory(DirectoryRegion);
+
+	// a peer may have taken over the slot while this process was stalled
+	if ((DirectorySlotIndex == INDEX_NONE) || (Directory.Slots[DirectorySlotIndex].State.load(std::memory_order_acquire) != Live) || (Directory.Slots[DirectorySlotIndex].NodeId != NodeId))
+	{
+		if (!ClaimDirectorySlot())
+		{
+			return;
+		}
+	}
+
+	Directory.Slots[DirectorySlotIndex].Heartbeat.fetch_add(1);
+
+	TSet<FGuid> LiveNodes;
+
+	for (int32 SlotIndex = 0; SlotIndex < MaxNodes; ++SlotIndex)
+	{
+		FDirectorySlot& Slot = Directory.Slots[SlotIndex];
+
+		if ((SlotIndex == DirectorySlotIndex) || (Slot.State.load(std::memory_order_acquire) != Live))
+		{
+			continue;
+		}
+
+		const FGuid SlotNodeId = Slot.NodeId;
+		const uint64 Heartbeat = Slot.Heartbeat.load();
+		FObservedNode* ObservedNode = ObservedNodes.Find(SlotNodeId);
+
+		if (ObservedNode == nullptr)
+		{
+			TSharedPtr<FPeer, ESPMode::ThreadSafe> Peer = OpenPeer(SlotNodeId);
+
+			// retried with the next heartbeat, e.g. if the peer's inbox has no free ring
+			if (!Peer.IsValid())
+			{
+				continue;
+			}
+
+			ObservedNode = &ObservedNodes.Add(SlotNodeId);
+			ObservedNode->Peer = Peer;
+			ObservedNode->Heartbeat = Heartbeat;
+			ObservedNode->LastChangeTime = Now;
+
+			UE_LOG(LogSGMessaging, Log, TEXT("Discovered shared memory transport node %s"), *SlotNodeId.ToString());
+
+			Handler->DiscoverTransportNode(SlotNodeId);
+		}
+		else if (ObservedNode->Heartbeat != Heartbeat)
+		{
+			ObservedNode->Heartbeat = Heartbeat;
+			ObservedNode->LastChangeTime = Now;
+		}
+		else if (Now - ObservedNode->LastChangeTime >= NodeTimeout)
+		{
+			// the peer crashed or stalled, free its slot so that it re-registers if it ever resumes
+			uint32 ExpectedState = Live;
+			Slot.State.compare_exchange_strong(ExpectedState, Free);
+
+			continue;
+		}
+
+		if (!ObservedNode->Peer->bRingLost.load())
+		{
+			LiveNodes.Add(SlotNodeId);
+		}
+	}
+
+	TArray<FGuid> LostNodes;
+
+	for (const auto& ObservedNodePair : ObservedNodes)
+	{
+		if (!LiveNodes.Contains(ObservedNodePair.Key))
+		{
+			LostNodes.Add(ObservedNodePair.Key);
+		}
+	}
+
+	for (const FGuid& LostNode : LostNodes)
+	{
+		ForgetNode(LostNode);
+	}
+}
+
+
+void FSGSharedMemoryMessageTransport::ForgetNode(const FGuid& PeerId)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	FObservedNode ObservedNode;
+
+	if (!ObservedNodes.RemoveAndCopyValue(PeerId, ObservedNode))
+	{
+		return;
+	}
+
+	{
+		FScopeLock Lock(&PeersCriticalSection);
+		Peers.Remove(PeerId);
+	}
+
+	ClosePeer(*ObservedNode.Peer);
+
+	// the peer won't close the ring it wrote to
+	for (int32 RingIndex = 0; RingIndex < MaxNodes; ++RingIndex)
+	{
+		FRing& Ring = GetRing(InboxRegion, RingIndex);
+
+		if ((Ring.State.load(std::memory_order_acquire) != Free) && (Ring.WriterId == PeerId))
+		{
+			Ring.State.store(Free, std::memory_order_release);
+		}
+	}
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Forgot shared memory transport node %s"), *PeerId.ToString());
+
+	Handler->ForgetTransportNode(PeerId);
+}
+
+
+bool FSGSharedMemoryMessageTransport::OpenDirectory()
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	const FString DirectoryName = ChannelName + TEXT(".Directory");
+
+	DirectoryRegion = FPlatformMemory::MapNamedSharedMemoryRegion(DirectoryName, false, AccessMode, sizeof(FDirectory));
+
+	if (DirectoryRegion == nullptr)
+	{
+		DirectoryRegion = FPlatformMemory::MapNamedSharedMemoryRegion(DirectoryName, true, AccessMode, sizeof(FDirectory));
+	}
+
+	if (DirectoryRegion == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't map the shared memory directory of channel %s"), *ChannelName);
+
+		return false;
+	}
+
+	FDirectory& Directory = GetDirectory(DirectoryRegion);
+
+	// new regions are zero-filled, so the first transport to see the directory initializes it
+	uint64 ExpectedId = 0;
+	uint32 ExpectedVersion = 0;
+
+	Directory.Id.compare_exchange_strong(ExpectedId, (FPlatformTime::Cycles64() ^ ((uint64)GetTypeHash(NodeId) << 32)) | 1);
+	Directory.Version.compare_exchange_strong(ExpectedVersion, LayoutVersion);
+
+	if (Directory.Version.load() != LayoutVersion)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't use the shared memory directory of channel %s, it has layout version %u"), *ChannelName, Directory.Version.load());
+
+		CloseDirectory();
+
+		return false;
+	}
+
+	DirectoryId = Directory.Id.load();
+
+	if (!ClaimDirectorySlot())
+	{
+		CloseDirectory();
+
+		return false;
+	}
+
+	return true;
+}
+
+
+void FSGSharedMemoryMessageTransport::CloseDirectory()
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	if (DirectoryRegion == nullptr)
+	{
+		return;
+	}
+
+	if (DirectorySlotIndex != INDEX_NONE)
+	{
+		FDirectorySlot& Slot = GetDirectory(DirectoryRegion).Slots[DirectorySlotIndex];
+
+		if (Slot.NodeId == NodeId)
+		{
+			Slot.State.store(Free, std::memory_order_release);
+		}
+	}
+
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(DirectoryRegion);
+	DirectoryRegion = nullptr;
+	DirectoryId = 0;
+	DirectorySlotIndex = INDEX_NONE;
+}
+
+
+bool FSGSharedMemoryMessageTransport::ClaimDirectorySlot()
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	FDirectory& Directory = GetDirectory(DirectoryRegion);
+
+	for (int32 SlotIndex = 0; SlotIndex < MaxNodes; ++SlotIndex)
+	{
+		FDirectorySlot& Slot = Directory.Slots[SlotIndex];
+		uint32 ExpectedState = Free;
+
+		if (Slot.State.compare_exchange_strong(ExpectedState, Claiming))
+		{
+			Slot.ProcessId = FPlatformProcess::GetCurrentProcessId();
+			Slot.NodeId = NodeId;
+			Slot.Heartbeat.fetch_add(1);
+			Slot.State.store(Live, std::memory_order_release);
+
+			DirectorySlotIndex = SlotIndex;
+
+			return true;
+		}
+	}
+
+	UE_LOG(LogSGMessaging, Warning, TEXT("Can't register in the shared memory directory of channel %s, it has no free slots"), *ChannelName);
+
+	DirectorySlotIndex = INDEX_NONE;
+
+	return false;
+}
+
+
+TSharedPtr<FSGSharedMemoryMessageTransport::FPeer, ESPMode::ThreadSafe> FSGSharedMemoryMessageTransport::OpenPeer(const FGuid& PeerId)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	TSharedRef<FPeer, ESPMode::ThreadSafe> Peer = MakeShared<FPeer, ESPMode::ThreadSafe>();
+	{
+		Peer->NodeId = PeerId;
+		Peer->Inbox = FPlatformMemory::MapNamedSharedMemoryRegion(GetInboxName(PeerId), false, AccessMode, InboxSize);
+	}
+
+	if ((Peer->Inbox == nullptr) || (GetInboxHeader(Peer->Inbox).Version.load(std::memory_order_acquire) != LayoutVersion))
+	{
+		ClosePeer(*Peer);
+
+		return nullptr;
+	}
+
+	Peer->WakeSemaphore = FPlatformProcess::NewInterprocessSynchObject(GetWakeName(PeerId), false);
+
+	for (int32 RingIndex = 0; (RingIndex < MaxNodes) && (Peer->WakeSemaphore != nullptr); ++RingIndex)
+	{
+		FRing& Ring = GetRing(Peer->Inbox, RingIndex);
+		uint32 ExpectedState = Free;
+
+		if (Ring.State.compare_exchange_strong(ExpectedState, Claiming))
+		{
+			Ring.WriterId = NodeId;
+			Ring.Head.store(0, std::memory_order_relaxed);
+			Ring.Tail.store(0, std::memory_order_relaxed);
+			Ring.State.store(Live, std::memory_order_release);
+
+			Peer->RingIndex = RingIndex;
+
+			FScopeLock Lock(&PeersCriticalSection);
+			Peers.Add(PeerId, Peer);
+
+			return Peer;
+		}
+	}
+
+	ClosePeer(*Peer);
+
+	return nullptr;
+}
+
+
+void FSGSharedMemoryMessageTransport::ClosePeer(FPeer& Peer)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	FScopeLock Lock(&Peer.WriteCriticalSection);
+
+	if (Peer.Inbox == nullptr)
+	{
+		return;
+	}
+
+	if (Peer.RingIndex != INDEX_NONE)
+	{
+		FRing& Ring = GetRing(Peer.Inbox, Peer.RingIndex);
+		uint32 ExpectedState = Live;
+
+		// the peer frees the ring once it read the remaining messages
+		if (Ring.WriterId == NodeId)
+		{
+			Ring.State.compare_exchange_strong(ExpectedState, Closed);
+		}
+	}
+
+	if (Peer.WakeSemaphore != nullptr)
+	{
+		FPlatformProcess::DeleteInterprocessSynchObject(Peer.WakeSemaphore);
+		Peer.WakeSemaphore = nullptr;
+	}
+
+	FPlatformMemory::UnmapNamedSharedMemoryRegion(Peer.Inbox);
+	Peer.Inbox = nullptr;
+}
+
+
+bool FSGSharedMemoryMessageTransport::WriteMessage(FPeer& Peer, TArrayView<const uint8> Message)
+{
+	using namespace SGSharedMemoryMessageTransport;
+
+	FScopeLock Lock(&Peer.WriteCriticalSection);
+
+	if (Peer.Inbox == nullptr)
+	{
+		return false;
+	}
+
+	FRing& Ring = GetRing(Peer.Inbox, Peer.RingIndex);
+
+	// the peer forgot this transport and released the ring, the receiver thread reconnects
+	if ((Ring.State.load(std::memory_order_acquire) != Live) || (Ring.WriterId != NodeId))
+	{
+		Peer.bRingLost.store(true);
+
+		return false;
+	}
+
+	uint8* Data = GetRingData(Ring);
+	uint64 Head = Ring.Head.load(std::memory_order_relaxed);
+	const uint64 Tail = Ring.Tail.load(std::memory_order_acquire);
+	const uint32 RecordSize = Align(RecordHeaderSize + (uint32)Message.Num(), RecordAlignment);
+	uint32 Position = (uint32)(Head & (RingCapacity - 1));
+
+	// records are contiguous so that they can be decoded in place
+	const uint32 PaddingSize = (RingCapacity - Position < RecordSize) ? RingCapacity - Position : 0;
+
+	if (Head + PaddingSize + RecordSize - Tail > RingCapacity)
+	{
+		return false;
+	}
+
+	if (PaddingSize > 0)
+	{
+		*reinterpret_cast<uint32*>(Data + Position) = PaddingRecord;
+		Head += PaddingSize;
+		Position = 0;
+	}
+
+	*reinterpret_cast<uint32*>(Data + Position) = (uint32)Message.Num();
+	FMemory::Memcpy(Data + Position + RecordHeaderSize, Message.GetData(), Message.Num());
+	Ring.Head.store(Head + RecordSize, std::memory_order_release);
+
+	if (GetInboxHeader(Peer.Inbox).bSleeping.exchange(0) != 0)
+	{
+		Peer.WakeSemaphore->Unlock();
+	}
+
+	return true;
+}
+
+
+void FSGSharedMemoryMessageTransport::CloseRegions()
+{
+	CloseDirectory();
+
+	if (WakeSemaphore != nullptr)
+	{
+		FPlatformProcess::DeleteInterprocessSynchObject(WakeSemaphore);
+		WakeSemaphore = nullptr;
+	}
+
+	if (InboxRegion != nullptr)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(InboxRegion);
+		InboxRegion = nullptr;
+	}
+}
+
+
+FString FSGSharedMemoryMessageTransport::GetInboxName(const FGuid& Id) const
+{
+	return FString::Printf(TEXT("%s.%s"), *ChannelName, *Id.ToString());
+}
+
+
+FString FSGSharedMemoryMessageTransport::GetWakeName(const FGuid& Id) const
+{
+	return FString::Printf(TEXT("%s.%s.Wake"), *ChannelName, *Id.ToString());
+}
@@ -0,0 +1,1058 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGTcpMessageTransport.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "IPAddress.h"
+#include "Misc/ScopeLock.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageTransportHandler.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Transport/SGTransportCodec.h"
+
+
+namespace SGTcpMessageTransport
+{
+	/** Size of the frame length prefix. */
+	constexpr int32 FrameHeaderSize = sizeof(uint32);
+
+	/** Largest size of a frame without its length prefix. */
+	constexpr uint32 MaxFrameSize = 64 * 1024 * 1024;
+
+	/** Size of the chunks of the write queues. */
+	constexpr int32 ChunkSize = 64 * 1024;
+
+	/** Largest number of chunks kept for reuse. */
+	constexpr int32 MaxFreeChunks = 64;
+
+	/** Largest number of bytes waiting to be sent on a connection before frames are dropped. */
+	constexpr int64 MaxUnsentBytes = 64 * 1024 * 1024;
+
+	/** Size of the receive buffer of a connection (grows to the largest received frame). */
+	constexpr int32 ReceiveBufferSize = 64 * 1024;
+
+	/** Time between connection attempts to an endpoint (in seconds). */
+	constexpr double ConnectRetryInterval = 2.0;
+
+	/** Time after which pending connection attempts fail (in seconds). */
+	constexpr double ConnectTimeout = 5.0;
+
+	/** Longest time that the sender thread waits before it checks for new connections (in seconds). */
+	constexpr double PollInterval = 0.05;
+
+	/** Time after which the sender thread retries writes on full sockets (in seconds). */
+	constexpr double WriteRetryInterval = 0.001;
+
+	/** Largest number of pending connections of the listener socket. */
+	constexpr int32 ListenBacklog = 16;
+
+	/** Checks whether the last failed socket call would have blocked. */
+	bool WouldBlock()
+	{
+		return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->GetLastErrorCode() == SE_EWOULDBLOCK;
+	}
+}
+
+
+/**
+ * Implements a connection to a remote transport node.
+ */
+class FSGTcpMessageTransport::FConnection
+	: public TSharedFromThis<FConnection, ESPMode::ThreadSafe>
+{
+public:
+
+	FConnection(FSocket* InSocket, const FSGNetworkEndpoint& InEndpoint, bool bInOutbound, double InConnectStartTime)
+		: Socket(InSocket)
+		, Endpoint(InEndpoint)
+		, bOutbound(bInOutbound)
+		, ConnectStartTime(InConnectStartTime)
+		, bEstablished(false)
+		, bClosed(false)
+		, ReceiverThread(nullptr)
+		, NumQueuedBytes(0)
+		, FirstQueuedTime(0.0)
+		, SendingOffset(0)
+		, NumUnsentBytes(0)
+	{ }
+
+public:
+
+	/** Holds the connection's socket. */
+	FSocket* Socket;
+
+	/** Holds the remote endpoint. */
+	FSGNetworkEndpoint Endpoint;
+
+	/** Holds a flag indicating whether this transport initiated the connection. */
+	bool bOutbound;
+
+	/** Holds the time at which the connection attempt started (in seconds). */
+	double ConnectStartTime;
+
+	/** Holds a flag indicating whether the connection is established (sender thread only). */
+	bool bEstablished;
+
+	/** Holds a flag indicating that the connection is closed or must close. */
+	std::atomic<bool> bClosed;
+
+	/** Holds the identifier of the remote node once it said hello (guarded by NodesCriticalSection). */
+	FGuid RemoteId;
+
+	/** Holds the receiver thread. */
+	FRunnableThread* ReceiverThread;
+
+	/** Holds the runnable of the receiver thread. */
+	TUniquePtr<FReceiver> Receiver;
+
+	/** Holds the codec of received messages (receiver thread only). */
+	FSGTransportCodec Codec;
+
+	/** Holds the chunks of queued frames. */
+	TArray<TArray<uint8>> QueuedChunks;
+
+	/** Holds the number of queued bytes. */
+	int32 NumQueuedBytes;
+
+	/** Holds the time at which the oldest queued frame was queued (in seconds). */
+	double FirstQueuedTime;
+
+	/** Guards the queued chunks. */
+	FCriticalSection QueueCriticalSection;
+
+	/** Holds the flushed chunks that are being written (sender thread only). */
+	TArray<TArray<uint8>> SendingChunks;
+
+	/** Holds the number of written bytes of the first flushed chunk (sender thread only). */
+	int32 SendingOffset;
+
+	/** Holds the number of queued and flushed bytes that weren't written yet. */
+	std::atomic<int64> NumUnsentBytes;
+};
+
+
+/**
+ * Implements the runnable of a connection's receiver thread.
+ */
+class FSGTcpMessageTransport::FReceiver
+	: public FRunnable
+{
+public:
+
+	FReceiver(FSGTcpMessageTransport& InTransport, FConnection& InConnection)
+		: Transport(InTransport)
+		, Connection(InConnection)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Transport.ReceiveFrames(Connection);
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Connection.bClosed.store(true);
+	}
+
+private:
+
+	/** Holds the transport. */
+	FSGTcpMessageTransport& Transport;
+
+	/** Holds the connection. */
+	FConnection& Connection;
+};
+
+
+/**
+ * Implements the runnable of the sender thread.
+ */
+class FSGTcpMessageTransport::FSender
+	: public FRunnable
+{
+public:
+
+	explicit FSender(FSGTcpMessageTransport& InTransport)
+		: Transport(InTransport)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Transport.SendFrames();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Transport.bStopping.store(true);
+		Transport.SendEvent->Trigger();
+	}
+
+private:
+
+	/** Holds the transport. */
+	FSGTcpMessageTransport& Transport;
+};
+
+
+/* FSGTcpMessageTransport structors
+ *****************************************************************************/
+
+FSGTcpMessageTransport::FSGTcpMessageTransport(const FSGNetworkEndpoint& InListenEndpoint, const TArray<FSGNetworkEndpoint>& InConnectEndpoints, double InFlushInterval, int32 InFlushThreshold)
+	: ListenEndpoint(InListenEndpoint)
+	, FlushInterval(FMath::Max(InFlushInterval, 0.0))
+	, FlushThreshold(FMath::Max(InFlushThreshold, 1))
+	, NodeId(FGuid::NewGuid())
+	, ListenerSocket(nullptr)
+	, Handler(nullptr)
+	, bStopping(false)
+	, SenderThread(nullptr)
+	, SendEvent(FPlatformProcess::GetSynchEventFromPool())
+	, NumSentFrames(0)
+	, NumSocketWrites(0)
+	, NumReceivedFrames(0)
+{
+	for (const FSGNetworkEndpoint& Endpoint : InConnectEndpoints)
+	{
+		AddConnectEndpoint(Endpoint);
+	}
+}
+
+
+FSGTcpMessageTransport::~FSGTcpMessageTransport()
+{
+	StopTransport();
+
+	FPlatformProcess::ReturnSynchEventToPool(SendEvent);
+	SendEvent = nullptr;
+}
+
+
+/* FSGTcpMessageTransport interface
+ *****************************************************************************/
+
+void FSGTcpMessageTransport::AddConnectEndpoint(const FSGNetworkEndpoint& Endpoint)
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	if (!ConnectEndpoints.ContainsByPredicate([&Endpoint](const FConnectEndpoint& ConnectEndpoint) { return ConnectEndpoint.Endpoint == Endpoint; }))
+	{
+		FConnectEndpoint& ConnectEndpoint = ConnectEndpoints.AddDefaulted_GetRef();
+		ConnectEndpoint.Endpoint = Endpoint;
+	}
+}
+
+
+void FSGTcpMessageTransport::RemoveConnectEndpoint(const FSGNetworkEndpoint& Endpoint)
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	ConnectEndpoints.RemoveAll([&Endpoint](const FConnectEndpoint& ConnectEndpoint) { return ConnectEndpoint.Endpoint == Endpoint; });
+}
+
+
+/* ISGMessageTransport interface
+ *****************************************************************************/
+
+FName FSGTcpMessageTransport::GetDebugName() const
+{
+	return TEXT("SGTcpMessageTransport");
+}
+
+
+bool FSGTcpMessageTransport::StartTransport(ISGMessageTransportHandler& InHandler)
+{
+	if (Handler != nullptr)
+	{
+		return true;
+	}
+
+	if (ListenEndpoint.Port != 0)
+	{
+		ListenerSocket = CreateSocket(TEXT("FSGTcpMessageTransport.Listener"));
+
+		if (ListenerSocket == nullptr)
+		{
+			return false;
+		}
+
+		TSharedRef<FInternetAddr> BindAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+		{
+			BindAddress->SetIp(ListenEndpoint.Address);
+			BindAddress->SetPort(ListenEndpoint.Port);
+		}
+
+		ListenerSocket->SetNonBlocking(true);
+		ListenerSocket->SetReuseAddr(true);
+
+		if (!ListenerSocket->Bind(*BindAddress) || !ListenerSocket->Listen(SGTcpMessageTransport::ListenBacklog))
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Can't start TCP message transport, it can't listen on %s"), *ListenEndpoint.ToString());
+
+			DestroySocket(ListenerSocket);
+
+			return false;
+		}
+	}
+
+	Handler = &InHandler;
+	bStopping.store(false);
+
+	Sender = MakeUnique<FSender>(*this);
+	SenderThread = FRunnableThread::Create(Sender.Get(), TEXT("FSGTcpMessageTransport.Sender"), 128 * 1024, TPri_AboveNormal);
+
+	if (SenderThread == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't start TCP message transport, its sender thread can't be created"));
+
+		StopTransport();
+
+		return false;
+	}
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Started TCP message transport on %s (node %s)"), *ListenEndpoint.ToString(), *NodeId.ToString());
+
+	return true;
+}
+
+
+void FSGTcpMessageTransport::StopTransport()
+{
+	if (Handler == nullptr)
+	{
+		return;
+	}
+
+	// the sender flushes all write queues before it exits
+	if (SenderThread != nullptr)
+	{
+		SenderThread->Kill(true);
+		delete SenderThread;
+		SenderThread = nullptr;
+	}
+
+	Sender.Reset();
+
+	for (const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection : Connections)
+	{
+		Connection->bClosed.store(true);
+	}
+
+	for (const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection : Connections)
+	{
+		if (Connection->ReceiverThread != nullptr)
+		{
+			Connection->ReceiverThread->Kill(true);
+			delete Connection->ReceiverThread;
+			Connection->ReceiverThread = nullptr;
+		}
+
+		Connection->Receiver.Reset();
+		DestroySocket(Connection->Socket);
+	}
+
+	Connections.Empty();
+
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		Nodes.Empty();
+
+		for (FConnectEndpoint& ConnectEndpoint : ConnectEndpoints)
+		{
+			ConnectEndpoint.Connection.Reset();
+			ConnectEndpoint.NextAttemptTime = 0.0;
+		}
+	}
+
+	DestroySocket(ListenerSocket);
+	Handler = nullptr;
+}
+
+
+bool FSGTcpMessageTransport::TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients)
+{
+	if (Handler == nullptr)
+	{
+		return false;
+	}
+
+	TArray<uint8> Message;
+
+	if (!Codec.EncodeMessage(*Context, Message))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Can't transport %s message, its payload can't be encoded"), *Context->GetMessageType().ToString());
+
+		return false;
+	}
+
+	if ((uint32)Message.Num() >= SGTcpMessageTransport::MaxFrameSize)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't transport %s message, it is larger than %u bytes"), *Context->GetMessageType().ToString(), SGTcpMessageTransport::MaxFrameSize - 1);
+
+		return false;
+	}
+
+	TArray<TSharedRef<FConnection, ESPMode::ThreadSafe>, TInlineAllocator<8>> RecipientConnections;
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		if (Recipients.Num() == 0)
+		{
+			Nodes.GenerateValueArray(RecipientConnections);
+		}
+		else
+		{
+			for (const FGuid& Recipient : Recipients)
+			{
+				if (const TSharedRef<FConnection, ESPMode::ThreadSafe>* Connection = Nodes.Find(Recipient))
+				{
+					RecipientConnections.Add(*Connection);
+				}
+			}
+		}
+	}
+
+	for (const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection : RecipientConnections)
+	{
+		QueueFrame(*Connection, EFrame::Message, Message);
+	}
+
+	return true;
+}
+
+
+/* FSGTcpMessageTransport implementation
+ *****************************************************************************/
+
+void FSGTcpMessageTransport::SendFrames()
+{
+	while (!bStopping.load())
+	{
+		const double Now = FSGMessageClock::Seconds();
+
+		AcceptConnections();
+		UpdateConnectEndpoints(Now);
+
+		const double NextFlushTime = FlushConnections(Now, false);
+
+		ReapConnections();
+
+		const double WaitTime = FMath::Min(NextFlushTime - FSGMessageClock::Seconds(), SGTcpMessageTransport::PollInterval);
+
+		SendEvent->Wait(FTimespan::FromSeconds(FMath::Max(WaitTime, 0.0)));
+	}
+
+	FlushConnections(FSGMessageClock::Seconds(), true);
+}
+
+
+void FSGTcpMessageTransport::ReceiveFrames(FConnection& Connection)
+{
+	TArray<uint8> Buffer;
+	Buffer.SetNumUninitialized(SGTcpMessageTransport::ReceiveBufferSize);
+
+	int32 NumBuffered = 0;
+
+	while (!Connection.bClosed.load())
+	{
+		if (!Connection.Socket->Wait(ESocketWaitConditions::WaitForRead, FTimespan::FromMilliseconds(100.0)))
+		{
+			continue;
+		}
+
+		int32 BytesRead = 0;
+
+		if (!Connection.Socket->Recv(Buffer.GetData() + NumBuffered, Buffer.Num() - NumBuffered, BytesRead))
+		{
+			if (SGTcpMessageTransport::WouldBlock())
+			{
+				continue;
+			}
+
+			break;
+		}
+
+		// the remote node closed the connection
+		if (BytesRead == 0)
+		{
+			break;
+		}
+
+		NumBuffered += BytesRead;
+
+		int32 Offset = 0;
+		uint32 FrameSize = 0;
+		bool bFailed = false;
+
+		while (NumBuffered - Offset >= SGTcpMessageTransport::FrameHeaderSize)
+		{
+			const uint8* Header = Buffer.GetData() + Offset;
+
+			FrameSize = (uint32)Header[0] | ((uint32)Header[1] << 8) | ((uint32)Header[2] << 16) | ((uint32)Header[3] << 24);
+
+			if ((FrameSize == 0) || (FrameSize > SGTcpMessageTransport::MaxFrameSize))
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Closing TCP connection to %s, it sent a frame of %u bytes"), *Connection.Endpoint.ToString(), FrameSize);
+
+				bFailed = true;
+
+				break;
+			}
+
+			if ((uint32)(NumBuffered - Offset - SGTcpMessageTransport::FrameHeaderSize) < FrameSize)
+			{
+				break;
+			}
+
+			NumReceivedFrames.fetch_add(1, std::memory_order_relaxed);
+
+			if (!ProcessFrame(Connection, MakeArrayView(Header + SGTcpMessageTransport::FrameHeaderSize, (int32)FrameSize)))
+			{
+				bFailed = true;
+
+				break;
+			}
+
+			Offset += SGTcpMessageTransport::FrameHeaderSize + (int32)FrameSize;
+			FrameSize = 0;
+		}
+
+		if (bFailed)
+		{
+			break;
+		}
+
+		// move the incomplete frame to the front, and make room for all of it
+		if (Offset > 0)
+		{
+			NumBuffered -= Offset;
+			FMemory::Memmove(Buffer.GetData(), Buffer.GetData() + Offset, NumBuffered);
+		}
+
+		const int32 RequiredSize = SGTcpMessageTransport::FrameHeaderSize + (int32)FrameSize;
+
+		if (RequiredSize > Buffer.Num())
+		{
+			Buffer.SetNumUninitialized(RequiredSize);
+		}
+	}
+
+	// the sender thread reaps the connection
+	Connection.bClosed.store(true);
+	SendEvent->Trigger();
+}
+
+
+bool FSGTcpMessageTransport::ProcessFrame(FConnection& Connection, TArrayView<const uint8> Frame)
+{
+	const TArrayView<const uint8> Body = Frame.Slice(1, Frame.Num() - 1);
+
+	switch ((EFrame)Frame[0])
+	{
+	case EFrame::Hello:
+		{
+			if (Connection.RemoteId.IsValid() || (Body.Num() < 1 + (int32)sizeof(FGuid)))
+			{
+				return false;
+			}
+
+			const uint8 Version = Body[0];
+
+			// the messages of older versions can't be decoded
+			if ((Version < (uint8)ESGTcpTransportVersion::DeltaPayloads) || (Version > (uint8)ESGTcpTransportVersion::Latest))
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Closing TCP connection to %s, it uses protocol version %d"), *Connection.Endpoint.ToString(), Version);
+
+				return false;
+			}
+
+			FGuid RemoteId;
+			FMemory::Memcpy(&RemoteId, Body.GetData() + 1, sizeof(FGuid));
+
+			return RegisterNode(Connection, RemoteId);
+		}
+
+	case EFrame::Message:
+		{
+			// messages must follow the hello (RemoteId is only written by this thread)
+			if (!Connection.RemoteId.IsValid())
+			{
+				return false;
+			}
+
+			TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context = Connection.Codec.DecodeMessage(Body);
+
+			if (!Context.IsValid())
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding message from TCP transport node %s"), *Connection.RemoteId.ToString());
+
+				return true;
+			}
+
+			Handler->ReceiveTransportMessage(Context.ToSharedRef(), Connection.RemoteId);
+		}
+		return true;
+
+	default:
+		// newer frame types are skipped
+		return true;
+	}
+}
+
+
+bool FSGTcpMessageTransport::RegisterNode(FConnection& Connection, const FGuid& RemoteId)
+{
+	bool bDiscovered = false;
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		Connection.RemoteId = RemoteId;
+
+		// connect endpoints may include this transport
+		if (RemoteId == NodeId)
+		{
+			return false;
+		}
+
+		TSharedRef<FConnection, ESPMode::ThreadSafe>* RegisteredConnection = Nodes.Find(RemoteId);
+
+		if (RegisteredConnection == nullptr)
+		{
+			Nodes.Add(RemoteId, Connection.AsShared());
+			bDiscovered = true;
+		}
+		else if (!(*RegisteredConnection)->bClosed.load())
+		{
+			// both nodes connected to each other, and both keep the connection initiated by the lower identifier
+			const FGuid& Initiator = Connection.bOutbound ? NodeId : RemoteId;
+			const FGuid& LowerId = (NodeId < RemoteId) ? NodeId : RemoteId;
+
+			if (Initiator != LowerId)
+			{
+				return false;
+			}
+
+			(*RegisteredConnection)->bClosed.store(true);
+			*RegisteredConnection = Connection.AsShared();
+		}
+		else
+		{
+			// the node reconnected before its old connection was reaped
+			*RegisteredConnection = Connection.AsShared();
+		}
+	}
+
+	if (bDiscovered)
+	{
+		UE_LOG(LogSGMessaging, Log, TEXT("Discovered TCP transport node %s at %s"), *RemoteId.ToString(), *Connection.Endpoint.ToString());
+
+		Handler->DiscoverTransportNode(RemoteId);
+	}
+
+	return true;
+}
+
+
+void FSGTcpMessageTransport::AcceptConnections()
+{
+	if (ListenerSocket == nullptr)
+	{
+		return;
+	}
+
+	bool bHasPendingConnection = false;
+
+	while (ListenerSocket->HasPendingConnection(bHasPendingConnection) && bHasPendingConnection)
+	{
+		FSocket* Socket = ListenerSocket->Accept(TEXT("FSGTcpMessageTransport.Connection"));
+
+		if (Socket == nullptr)
+		{
+			break;
+		}
+
+		TSharedRef<FInternetAddr> PeerAddress = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+		uint32 PeerIp = 0;
+
+		Socket->GetPeerAddress(*PeerAddress);
+		PeerAddress->GetIp(PeerIp);
+
+		TSharedRef<FConnection, ESPMode::ThreadSafe> Connection = MakeShared<FConnection, ESPMode::ThreadSafe>(Socket, FSGNetworkEndpoint(PeerIp, (uint16)PeerAddress->GetPort()), false, FSGMessageClock::Seconds());
+
+		Connections.Add(Connection);
+
+		if (!OpenConnection(Connection))
+		{
+			Connection->bClosed.store(true);
+		}
+	}
+}
+
+
+void FSGTcpMessageTransport::UpdateConnectEndpoints(double Now)
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	for (FConnectEndpoint& ConnectEndpoint : ConnectEndpoints)
+	{
+		if (ConnectEndpoint.Connection.IsValid())
+		{
+			FConnection& Connection = *ConnectEndpoint.Connection;
+
+			if (Connection.bClosed.load())
+			{
+				ConnectEndpoint.NodeId = Connection.RemoteId.IsValid() ? Connection.RemoteId : ConnectEndpoint.NodeId;
+				ConnectEndpoint.NextAttemptTime = Connection.ConnectStartTime + SGTcpMessageTransport::ConnectRetryInterval;
+				ConnectEndpoint.Connection.Reset();
+			}
+			else if (!Connection.bEstablished)
+			{
+				const ESocketConnectionState State = Connection.Socket->GetConnectionState();
+
+				if (State == SCS_Connected)
+				{
+					if (!OpenConnection(ConnectEndpoint.Connection.ToSharedRef()))
+					{
+						Connection.bClosed.store(true);
+					}
+				}
+				else if ((State == SCS_ConnectionError) || (Now - Connection.ConnectStartTime >= SGTcpMessageTransport::ConnectTimeout))
+				{
+					UE_LOG(LogSGMessaging, Verbose, TEXT("Can't connect to TCP transport at %s"), *ConnectEndpoint.Endpoint.ToString());
+
+					Connection.bClosed.store(true);
+				}
+			}
+
+			continue;
+		}
+
+		// the node at the endpoint is this transport, or it is connected through the connection it initiated
+		if ((ConnectEndpoint.NodeId == NodeId) || (ConnectEndpoint.NodeId.IsValid() && Nodes.Contains(ConnectEndpoint.NodeId)) || (Now < ConnectEndpoint.NextAttemptTime))
+		{
+			continue;
+		}
+
+		ConnectEndpoint.NextAttemptTime = Now + SGTcpMessageTransport::ConnectRetryInterval;
+
+		FSocket* Socket = CreateSocket(TEXT("FSGTcpMessageTransport.Connection"));
+
+		if (Socket == nullptr)
+		{
+			continue;
+		}
+
+		TSharedRef<FInternetAddr> Address = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+		{
+			Address->SetIp(ConnectEndpoint.Endpoint.Address);
+			Address->SetPort(ConnectEndpoint.Endpoint.Port);
+		}
+
+		Socket->SetNonBlocking(true);
+
+		// non-blocking connects complete later, see GetConnectionState
+		if (!Socket->Connect(*Address))
+		{
+			DestroySocket(Socket);
+
+			continue;
+		}
+
+		TSharedRef<FConnection, ESPMode::ThreadSafe> Connection = MakeShared<FConnection, ESPMode::ThreadSafe>(Socket, ConnectEndpoint.Endpoint, true, Now);
+
+		Connections.Add(Connection);
+		ConnectEndpoint.Connection = Connection;
+	}
+}
+
+
+bool FSGTcpMessageTransport::OpenConnection(const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection)
+{
+	Connection->Socket->SetNonBlocking(true);
+	Connection->Socket->SetNoDelay(true);
+	Connection->bEstablished = true;
+
+	uint8 Hello[1 + sizeof(FGuid)];
+	{
+		Hello[0] = (uint8)ESGTcpTransportVersion::Latest;
+		FMemory::Memcpy(Hello + 1, &NodeId, sizeof(FGuid));
+	}
+
+	// the hello is queued before the receiver starts, so it precedes all messages
+	QueueFrame(*Connection, EFrame::Hello, MakeArrayView(Hello, UE_ARRAY_COUNT(Hello)));
+
+	Connection->Receiver = MakeUnique<FReceiver>(*this, *Connection);
+	Connection->ReceiverThread = FRunnableThread::Create(Connection->Receiver.Get(), TEXT("FSGTcpMessageTransport.Receiver"), 128 * 1024, TPri_AboveNormal);
+
+	return (Connection->ReceiverThread != nullptr);
+}
+
+
+double FSGTcpMessageTransport::FlushConnections(double Now, bool bForce)
+{
+	double NextFlushTime = Now + SGTcpMessageTransport::PollInterval;
+
+	for (const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection : Connections)
+	{
+		if (!Connection->bEstablished || Connection->bClosed.load())
+		{
+			continue;
+		}
+
+		{
+			FScopeLock Lock(&Connection->QueueCriticalSection);
+
+			if (Connection->NumQueuedBytes > 0)
+			{
+				const double DueTime = Connection->FirstQueuedTime + FlushInterval;
+
+				if (bForce || (Connection->NumQueuedBytes >= FlushThreshold) || (Now >= DueTime))
+				{
+					Connection->SendingChunks.Append(MoveTemp(Connection->QueuedChunks));
+					Connection->QueuedChunks.Reset();
+					Connection->NumQueuedBytes = 0;
+				}
+				else
+				{
+					NextFlushTime = FMath::Min(NextFlushTime, DueTime);
+				}
+			}
+		}
+
+		if (Connection->SendingChunks.Num() == 0)
+		{
+			continue;
+		}
+
+		if (!FlushConnection(*Connection))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Closing TCP connection to %s, it can't be written to"), *Connection->Endpoint.ToString());
+
+			Connection->bClosed.store(true);
+		}
+		else if (Connection->SendingChunks.Num() > 0)
+		{
+			NextFlushTime = FMath::Min(NextFlushTime, Now + SGTcpMessageTransport::WriteRetryInterval);
+		}
+	}
+
+	return NextFlushTime;
+}
+
+
+bool FSGTcpMessageTransport::FlushConnection(FConnection& Connection)
+{
+	while (Connection.SendingChunks.Num() > 0)
+	{
+		TArray<uint8>& Chunk = Connection.SendingChunks[0];
+		int32 BytesSent = 0;
+
+		if (!Connection.Socket->Send(Chunk.GetData() + Connection.SendingOffset, Chunk.Num() - Connection.SendingOffset, BytesSent))
+		{
+			return SGTcpMessageTransport::WouldBlock();
+		}
+
+		NumSocketWrites.fetch_add(1, std::memory_order_relaxed);
+		Connection.SendingOffset += BytesSent;
+
+		// the socket's system buffer is full, the rest is written later
+		if (Connection.SendingOffset < Chunk.Num())
+		{
+			return true;
+		}
+
+		Connection.NumUnsentBytes.fetch_sub(Chunk.Num(), std::memory_order_relaxed);
+		Connection.SendingOffset = 0;
+		ReleaseChunk(MoveTemp(Chunk));
+		Connection.SendingChunks.RemoveAt(0);
+	}
+
+	return true;
+}
+
+
+void FSGTcpMessageTransport::ReapConnections()
+{
+	for (int32 ConnectionIndex = Connections.Num() - 1; ConnectionIndex >= 0; --ConnectionIndex)
+	{
+		TSharedRef<FConnection, ESPMode::ThreadSafe> Connection = Connections[ConnectionIndex];
+
+		if (!Connection->bClosed.load())
+		{
+			continue;
+		}
+
+		if (Connection->ReceiverThread != nullptr)
+		{
+			Connection->ReceiverThread->Kill(true);
+			delete Connection->ReceiverThread;
+			Connection->ReceiverThread = nullptr;
+		}
+
+		Connection->Receiver.Reset();
+		DestroySocket(Connection->Socket);
+		Connections.RemoveAtSwap(ConnectionIndex);
+
+		bool bForget = false;
+		{
+			FScopeLock Lock(&NodesCriticalSection);
+
+			const TSharedRef<FConnection, ESPMode::ThreadSafe>* RegisteredConnection = Nodes.Find(Connection->RemoteId);
+
+			// duplicate and replaced connections don't forget their node
+			if ((RegisteredConnection != nullptr) && (&RegisteredConnection->Get() == &Connection.Get()))
+			{
+				Nodes.Remove(Connection->RemoteId);
+				bForget = true;
+			}
+		}
+
+		if (bForget)
+		{
+			UE_LOG(LogSGMessaging, Log, TEXT("Lost TCP connection to transport node %s at %s"), *Connection->RemoteId.ToString(), *Connection->Endpoint.ToString());
+
+			Handler->ForgetTransportNode(Connection->RemoteId);
+		}
+	}
+}
+
+
+void FSGTcpMessageTransport::QueueFrame(FConnection& Connection, EFrame Frame, TArrayView<const uint8> Body)
+{
+	const uint32 FrameSize = 1 + (uint32)Body.Num();
+	const int32 NumFrameBytes = SGTcpMessageTransport::FrameHeaderSize + (int32)FrameSize;
+
+	if (Connection.bClosed.load())
+	{
+		return;
+	}
+
+	if (Connection.NumUnsentBytes.load(std::memory_order_relaxed) + NumFrameBytes > SGTcpMessageTransport::MaxUnsentBytes)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Dropping frame for TCP connection to %s, its write queue is full"), *Connection.Endpoint.ToString());
+
+		return;
+	}
+
+	const uint8 Header[SGTcpMessageTransport::FrameHeaderSize + 1] =
+	{
+		(uint8)FrameSize, (uint8)(FrameSize >> 8), (uint8)(FrameSize >> 16), (uint8)(FrameSize >> 24), (uint8)Frame
+	};
+
+	bool bWakeSender = false;
+	{
+		FScopeLock Lock(&Connection.QueueCriticalSection);
+
+		// frames may span chunks, the stream doesn't care
+		auto Append = [this, &Connection](const uint8* Data, int32 Size)
+		{
+			while (Size > 0)
+			{
+				if ((Connection.QueuedChunks.Num() == 0) || (Connection.QueuedChunks.Last().Num() == SGTcpMessageTransport::ChunkSize))
+				{
+					Connection.QueuedChunks.Add(AllocateChunk());
+				}
+
+				TArray<uint8>& Chunk = Connection.QueuedChunks.Last();
+				const int32 NumCopied = FMath::Min(Size, SGTcpMessageTransport::ChunkSize - Chunk.Num());
+
+				Chunk.Append(Data, NumCopied);
+				Data += NumCopied;
+				Size -= NumCopied;
+			}
+		};
+
+		Append(Header, UE_ARRAY_COUNT(Header));
+		Append(Body.GetData(), Body.Num());
+
+		if (Connection.NumQueuedBytes == 0)
+		{
+			Connection.FirstQueuedTime = FSGMessageClock::Seconds();
+			bWakeSender = true;
+		}
+
+		// wake the sender when the queue reaches the threshold, not for each later frame
+		bWakeSender |= (Connection.NumQueuedBytes < FlushThreshold) && (Connection.NumQueuedBytes + NumFrameBytes >= FlushThreshold);
+		Connection.NumQueuedBytes += NumFrameBytes;
+	}
+
+	Connection.NumUnsentBytes.fetch_add(NumFrameBytes, std::memory_order_relaxed);
+	NumSentFrames.fetch_add(1, std::memory_order_relaxed);
+
+	if (bWakeSender)
+	{
+		SendEvent->Trigger();
+	}
+}
+
+
+TArray<uint8> FSGTcpMessageTransport::AllocateChunk()
+{
+	{
+		FScopeLock Lock(&FreeChunksCriticalSection);
+
+		if (FreeChunks.Num() > 0)
+		{
+			return FreeChunks.Pop(false);
+		}
+	}
+
+	TArray<uint8> Chunk;
+	Chunk.Reserve(SGTcpMessageTransport::ChunkSize);
+
+	return Chunk;
+}
+
+
+void FSGTcpMessageTransport::ReleaseChunk(TArray<uint8>&& Chunk)
+{
+	FScopeLock Lock(&FreeChunksCriticalSection);
+
+	if (FreeChunks.Num() < SGTcpMessageTransport::MaxFreeChunks)
+	{
+		Chunk.Reset();
+		FreeChunks.Add(MoveTemp(Chunk));
+	}
+}
+
+
+FSocket* FSGTcpMessageTransport::CreateSocket(const TCHAR* Description) const
+{
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	if (SocketSubsystem == nullptr)
+	{
+		return nullptr;
+	}
+
+	FSocket* Socket = SocketSubsystem->CreateSocket(NAME_Stream, Description, FNetworkProtocolTypes::IPv4);
+
+	if (Socket == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't create TCP socket %s"), Description);
+	}
+
+	return Socket;
+}
+
+
+void FSGTcpMessageTransport::DestroySocket(FSocket*& Socket)
+{
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+}
@@ -0,0 +1,643 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGTransportCodec.h"
+#include "Misc/Compression.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "UObject/Class.h"
+#include "Core/Bus/SGMessageCapture.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Bus/SGMessageStatistics.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageSerializer.h"
+#include "Core/Message/SGMessageWire.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+namespace SGTransportCodec
+{
+	/** Largest decompressed size of a message, which guards against malformed sizes. */
+	constexpr uint64 MaxUncompressedSize = 64 * 1024 * 1024;
+
+	/** Largest number of delta streams per codec and direction. */
+	constexpr int32 MaxDeltaStreams = 1024;
+
+	/** Smallest run of unchanged bytes that a delta copies from its base instead of repeating. */
+	constexpr int32 MinDeltaCopySize = 4;
+
+	/**
+	 * Encodes the changes of a payload to its base.
+	 *
+	 * The delta holds the payload's size, followed by operations that each copy a number of bytes from
+	 * the same offset in the base and then append a number of literal bytes.
+	 */
+	void EncodeDelta(TArrayView<const uint8> Base, TArrayView<const uint8> Payload, TArray<uint8>& OutDelta)
+	{
+		FSGWireWriter Writer(OutDelta);
+		Writer.WriteVarint(Payload.Num());
+
+		auto IsUnchanged = [&Base, &Payload](int32 Index)
+		{
+			return (Index < Base.Num()) && (Payload[Index] == Base[Index]);
+		};
+
+		int32 Index = 0;
+
+		while (Index < Payload.Num())
+		{
+			const int32 CopyStart = Index;
+
+			while ((Index < Payload.Num()) && IsUnchanged(Index))
+			{
+				++Index;
+			}
+
+			const int32 LiteralStart = Index;
+			int32 NumUnchanged = 0;
+
+			// short runs of unchanged bytes are cheaper as literals than as another operation
+			while ((Index < Payload.Num()) && (NumUnchanged < MinDeltaCopySize))
+			{
+				NumUnchanged = IsUnchanged(Index) ? NumUnchanged + 1 : 0;
+				++Index;
+			}
+
+			Index -= NumUnchanged;
+
+			Writer.WriteVarint(LiteralStart - CopyStart);
+			Writer.WriteVarint(Index - LiteralStart);
+			Writer.WriteBytes(Payload.GetData() + LiteralStart, Index - LiteralStart);
+		}
+	}
+
+	/** Applies a delta to its base. */
+	bool DecodeDelta(TArrayView<const uint8> Base, TArrayView<const uint8> Delta, TArray<uint8>& OutPayload)
+	{
+		FSGWireReader Reader(Delta);
+		uint64 PayloadSize = 0;
+
+		if (!Reader.ReadVarint(PayloadSize) || (PayloadSize > MaxUncompressedSize))
+		{
+			return false;
+		}
+
+		OutPayload.Reset((int32)PayloadSize);
+
+		while (OutPayload.Num() < (int32)PayloadSize)
+		{
+			uint64 NumCopied = 0;
+			uint64 NumLiterals = 0;
+
+			if (!Reader.ReadVarint(NumCopied) || !Reader.ReadVarint(NumLiterals) || (NumCopied + NumLiterals == 0) || (OutPayload.Num() + NumCopied > (uint64)Base.Num()) || (OutPayload.Num() + NumCopied + NumLiterals > PayloadSize))
+			{
+				return false;
+			}
+
+			OutPayload.Append(Base.GetData() + OutPayload.Num(), (int32)NumCopied);
+
+			const uint8* Literals = Reader.ReadBytes((int64)NumLiterals);
+
+			if (Literals == nullptr)
+			{
+				return false;
+			}
+
+			OutPayload.Append(Literals, (int32)NumLiterals);
+		}
+
+		return Reader.IsAtEnd();
+	}
+
+	/**
+	 * Peeks at the count in front of a string or an array.
+	 *
+	 * @return true if the count is within the limit and its items fit into the remaining bytes.
+	 */
+	bool CheckCount(FArchive& Reader, int64 MinBytesPerItem, int64 MaxCount)
+	{
+		const int64 Offset = Reader.Tell();
+		int32 Count = 0;
+
+		Reader << Count;
+		Reader.Seek(Offset);
+
+		// strings of wide characters have negative counts
+		const int64 NumItems = FMath::Abs((int64)Count);
+
+		return !Reader.IsError() && (NumItems <= MaxCount) && (NumItems * MinBytesPerItem <= Reader.TotalSize() - Offset - (int64)sizeof(int32));
+	}
+
+	/**
+	 * Reads the record of a received message like FSGCapturedMessage's serialization does.
+	 *
+	 * The counts of the record's strings and arrays are checked before anything is allocated, also
+	 * the ones inside the annotations, so that a malformed message can't allocate more than it holds.
+	 *
+	 * @return true if the record was read, false if it is malformed or exceeds the limit.
+	 */
+	bool ReadRecord(FArchive& Reader, FSGCapturedMessage& OutRecord, int32 MaxCount)
+	{
+		const int64 MaxBytes = Reader.TotalSize();
+		uint8 Scope = 0;
+		uint32 Flags = 0;
+		uint8 PayloadFormat = 0;
+
+		Reader << OutRecord.TimeSent << OutRecord.TimeRouted << OutRecord.TimeToLive;
+
+		// names are serialized as strings
+		if (!CheckCount(Reader, 1, MaxBytes))
+		{
+			return false;
+		}
+
+		Reader << OutRecord.MessageType;
+
+		if (!CheckCount(Reader, 1, MaxBytes))
+		{
+			return false;
+		}
+
+		Reader << OutRecord.TypeInfoPath << OutRecord.Sender;
+
+		if (!CheckCount(Reader, sizeof(FSGMessageAddress), MaxCount))
+		{
+			return false;
+		}
+
+		Reader << OutRecord.Recipients << Scope << Flags;
+
+		// each annotation holds at least the counts of its name and its value
+		if (!CheckCount(Reader, 2 * sizeof(int32), MaxCount))
+		{
+			return false;
+		}
+
+		int32 NumAnnotations = 0;
+		Reader << NumAnnotations;
+
+		for (int32 Index = 0; Index < NumAnnotations; ++Index)
+		{
+			FName Name;
+			FString Value;
+
+			if (!CheckCount(Reader, 1, MaxBytes))
+			{
+				return false;
+			}
+
+			Reader << Name;
+
+			if (!CheckCount(Reader, 1, MaxBytes))
+			{
+				return false;
+			}
+
+			Reader << Value;
+			OutRecord.Annotations.Add(Name, MoveTemp(Value));
+		}
+
+		Reader << PayloadFormat;
+
+		if (!CheckCount(Reader, 1, MaxBytes))
+		{
+			return false;
+		}
+
+		Reader << OutRecord.Payload;
+
+		OutRecord.Scope = (ESGMessageScope)Scope;
+		OutRecord.Flags = (ESGMessageFlags)Flags;
+		OutRecord.PayloadFormat = (ESGCapturedPayloadFormat)PayloadFormat;
+
+		return !Reader.IsError();
+	}
+
+	/** Gets the compression format with the given wire identifier (NAME_None if unknown). */
+	FName GetCompressionFormat(uint8 FormatId)
+	{
+		switch (FormatId)
+		{
+		case 1: return NAME_Zlib;
+		case 2: return NAME_Gzip;
+		case 3: return NAME_LZ4;
+		case 4: return NAME_Oodle;
+		default: return NAME_None;
+		}
+	}
+
+	/** Gets the wire identifier of a compression format (0 if it can't be transported). */
+	uint8 GetCompressionFormatId(const FName& Format)
+	{
+		for (uint8 FormatId = 1; GetCompressionFormat(FormatId) != NAME_None; ++FormatId)
+		{
+			if (GetCompressionFormat(FormatId) == Format)
+			{
+				return FormatId;
+			}
+		}
+
+		return 0;
+	}
+}
+
+
+/* FSGTransportCodec structors
+ *****************************************************************************/
+
+FSGTransportCodec::FSGTransportCodec()
+	: CompressionFormat(NAME_None)
+	, CompressionFormatId(0)
+	, CompressionThreshold(1024)
+	, DeltaKeyframeInterval(30)
+	, MaxReceivedCount(1024)
+{
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		CompressionThreshold = SGMessagingSettings->TransportCompressionThreshold;
+		CompressedMessageTypes.Append(SGMessagingSettings->TransportCompressedMessageTypes);
+		DeltaMessageTypes.Append(SGMessagingSettings->TransportDeltaMessageTypes);
+		DeltaKeyframeInterval = SGMessagingSettings->TransportDeltaKeyframeInterval;
+		MaxReceivedCount = SGMessagingSettings->TransportMaxReceivedCount;
+
+		if (SGMessagingSettings->TransportCompressionFormat != NAME_None)
+		{
+			CompressionFormatId = SGTransportCodec::GetCompressionFormatId(SGMessagingSettings->TransportCompressionFormat);
+
+			if ((CompressionFormatId == 0) || !FCompression::IsFormatValid(SGMessagingSettings->TransportCompressionFormat))
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Transported messages aren't compressed, the compression format %s isn't supported"), *SGMessagingSettings->TransportCompressionFormat.ToString());
+
+				CompressionFormatId = 0;
+			}
+			else
+			{
+				CompressionFormat = SGMessagingSettings->TransportCompressionFormat;
+			}
+		}
+	}
+}
+
+
+/* FSGTransportCodec interface
+ *****************************************************************************/
+
+bool FSGTransportCodec::EncodeMessage(const ISGMessageContext& Context, TArray<uint8>& OutMessage) const
+{
+	FSGCapturedMessage Record;
+	FSGMessageCapture::MakeRecord(Context, 0.0, 0.0, Record);
+
+	if (Record.PayloadFormat == ESGCapturedPayloadFormat::None)
+	{
+		return false;
+	}
+
+	OutMessage.Reset();
+	{
+		FSGWireWriter HeaderWriter(OutMessage);
+
+		HeaderWriter.WriteByte((uint8)EEncoding::Plain);
+		EncodePayload(Record, HeaderWriter);
+	}
+
+	FMemoryWriter Writer(OutMessage, false, true);
+
+	Writer << Record;
+
+	if ((CompressionFormat != NAME_None) && (OutMessage.Num() - 1 >= CompressionThreshold) && ((CompressedMessageTypes.Num() == 0) || CompressedMessageTypes.Contains(Record.MessageType)))
+	{
+		CompressMessage(Record.MessageType, OutMessage);
+	}
+
+	return true;
+}
+
+
+TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> FSGTransportCodec::DecodeMessage(TArrayView<const uint8> Message)
+{
+	FSGWireReader EncodingReader(Message);
+	uint8 Encoding = 0;
+	TArrayView<const uint8> RecordBytes;
+	uint64 DecompressCycles = 0;
+
+	if (!EncodingReader.ReadByte(Encoding))
+	{
+		return nullptr;
+	}
+
+	if (Encoding == (uint8)EEncoding::Plain)
+	{
+		RecordBytes = Message.RightChop(EncodingReader.Tell());
+	}
+	else if (Encoding == (uint8)EEncoding::Compressed)
+	{
+		uint8 FormatId = 0;
+		uint64 UncompressedSize = 0;
+
+		if (!EncodingReader.ReadByte(FormatId) || !EncodingReader.ReadVarint(UncompressedSize) || (UncompressedSize > SGTransportCodec::MaxUncompressedSize))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding malformed transported message"));
+
+			return nullptr;
+		}
+
+		const FName Format = SGTransportCodec::GetCompressionFormat(FormatId);
+
+		if ((Format == NAME_None) || !FCompression::IsFormatValid(Format))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported message, its compression format %d isn't supported"), FormatId);
+
+			return nullptr;
+		}
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+		const TArrayView<const uint8> CompressedBytes = Message.RightChop(EncodingReader.Tell());
+
+		DecompressionBuffer.SetNumUninitialized((int32)UncompressedSize, false);
+
+		if (!FCompression::UncompressMemory(Format, DecompressionBuffer.GetData(), (int32)UncompressedSize, CompressedBytes.GetData(), CompressedBytes.Num()))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported message, it can't be decompressed"));
+
+			return nullptr;
+		}
+
+		DecompressCycles = FPlatformTime::Cycles64() - StartCycles;
+		RecordBytes = DecompressionBuffer;
+	}
+	else
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported message with unknown encoding %d"), Encoding);
+
+		return nullptr;
+	}
+
+	FSGWireReader PayloadEncodingReader(RecordBytes);
+	uint8 PayloadEncoding = 0;
+	uint64 Sequence = 0;
+	uint64 BaseSequence = 0;
+
+	if (!PayloadEncodingReader.ReadByte(PayloadEncoding) || (PayloadEncoding > (uint8)EPayloadEncoding::Delta) ||
+		((PayloadEncoding != (uint8)EPayloadEncoding::Full) && !PayloadEncodingReader.ReadVarint(Sequence)) ||
+		((PayloadEncoding == (uint8)EPayloadEncoding::Delta) && !PayloadEncodingReader.ReadVarint(BaseSequence)))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding malformed transported message"));
+
+		return nullptr;
+	}
+
+	FSGCapturedMessage Record;
+	FMemoryReaderView Reader(RecordBytes.RightChop(PayloadEncodingReader.Tell()));
+
+	if (!SGTransportCodec::ReadRecord(Reader, Record, MaxReceivedCount))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding malformed or oversized transported message"));
+
+		return nullptr;
+	}
+
+	if (!DecodePayload((EPayloadEncoding)PayloadEncoding, Sequence, BaseSequence, Record))
+	{
+		return nullptr;
+	}
+
+	if (Encoding == (uint8)EEncoding::Compressed)
+	{
+		FSGMessageCompressionCounters::CountDecompression(Record.MessageType, DecompressCycles);
+	}
+
+	void* Payload = nullptr;
+	UScriptStruct* TypeInfo = nullptr;
+
+	switch (Record.PayloadFormat)
+	{
+	case ESGCapturedPayloadFormat::Struct:
+		{
+			TypeInfo = FindTypeInfo(Record);
+
+			if (TypeInfo == nullptr)
+			{
+				return nullptr;
+			}
+
+			Payload = FSGMessagePool::Malloc(TypeInfo->GetStructureSize(), TypeInfo->GetMinAlignment());
+			TypeInfo->InitializeStruct(Payload);
+
+			FMemoryReader PayloadReader(Record.Payload);
+			TypeInfo->SerializeBin(PayloadReader, Payload);
+
+			if (PayloadReader.IsError())
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported %s message, its payload is malformed"), *Record.MessageType.ToString());
+
+				TypeInfo->DestroyStruct(Payload);
+				FSGMessagePool::Free(Payload);
+
+				return nullptr;
+			}
+		}
+		break;
+
+	case ESGCapturedPayloadFormat::Message:
+		{
+			FSGMessage* DynamicMessage = FSGMessagePool::New<FSGMessage>();
+			const int32 NumSkipped = FSGMessageReader(Record.Payload).ReadMessage(*DynamicMessage);
+
+			if (NumSkipped > 0)
+			{
+				UE_LOG(LogSGMessaging, Verbose, TEXT("Received %s message without %d parameters that can't be decoded"), *Record.MessageType.ToString(), NumSkipped);
+			}
+
+			Payload = DynamicMessage;
+		}
+		break;
+
+	default:
+		return nullptr;
+	}
+
+	const FDateTime Now = FSGMessageClock::UtcNow();
+	const FDateTime Expiration = (Record.TimeToLive >= 0.0) ? Now + FTimespan::FromSeconds(Record.TimeToLive) : FDateTime::MaxValue();
+	const FSGMessageAnnotations Annotations(Record.Annotations);
+
+	// the context takes over the payload's memory
+	if (TypeInfo != nullptr)
+	{
+		return FSGMessageContext::Create(Payload, TypeInfo, Annotations, nullptr, Record.Sender, Record.Recipients, Record.Scope, Record.Flags, Now, Expiration, ENamedThreads::AnyThread);
+	}
+
+	return FSGMessageContext::Create(Record.MessageType, Payload, Annotations, nullptr, Record.Sender, Record.Recipients, Record.Scope, Record.Flags, Now, Expiration, ENamedThreads::AnyThread);
+}
+
+
+/* FSGTransportCodec implementation
+ *****************************************************************************/
+
+void FSGTransportCodec::EncodePayload(FSGCapturedMessage& Record, FSGWireWriter& Writer) const
+{
+	if (!DeltaMessageTypes.Contains(Record.MessageType))
+	{
+		Writer.WriteByte((uint8)EPayloadEncoding::Full);
+
+		return;
+	}
+
+	const FDeltaStreamKey StreamKey(Record.MessageType, Record.Sender);
+
+	FScopeLock Lock(&EncodedStreamsCriticalSection);
+	FDeltaStream* Stream = EncodedStreams.Find(StreamKey);
+
+	if (Stream == nullptr)
+	{
+		if (EncodedStreams.Num() >= SGTransportCodec::MaxDeltaStreams)
+		{
+			Writer.WriteByte((uint8)EPayloadEncoding::Full);
+
+			return;
+		}
+
+		// the first message of a stream is always a keyframe
+		Stream = &EncodedStreams.Add(StreamKey);
+		Stream->NumDeltas = DeltaKeyframeInterval;
+	}
+
+	const uint32 BaseSequence = Stream->Sequence++;
+
+	if (Stream->NumDeltas < DeltaKeyframeInterval)
+	{
+		TArray<uint8> Delta;
+		SGTransportCodec::EncodeDelta(Stream->Payload, Record.Payload, Delta);
+
+		if (Delta.Num() < Record.Payload.Num())
+		{
+			Writer.WriteByte((uint8)EPayloadEncoding::Delta);
+			Writer.WriteVarint(Stream->Sequence);
+			Writer.WriteVarint(BaseSequence);
+
+			Stream->Payload = MoveTemp(Record.Payload);
+			Record.Payload = MoveTemp(Delta);
+			++Stream->NumDeltas;
+
+			return;
+		}
+	}
+
+	Writer.WriteByte((uint8)EPayloadEncoding::Keyframe);
+	Writer.WriteVarint(Stream->Sequence);
+
+	Stream->Payload = Record.Payload;
+	Stream->NumDeltas = 0;
+}
+
+
+bool FSGTransportCodec::DecodePayload(EPayloadEncoding PayloadEncoding, uint64 Sequence, uint64 BaseSequence, FSGCapturedMessage& Record)
+{
+	if (PayloadEncoding == EPayloadEncoding::Full)
+	{
+		return true;
+	}
+
+	const FDeltaStreamKey StreamKey(Record.MessageType, Record.Sender);
+
+	if (PayloadEncoding == EPayloadEncoding::Keyframe)
+	{
+		// streams of senders that went away are only dropped when there are too many
+		if ((DecodedStreams.Num() >= SGTransportCodec::MaxDeltaStreams) && !DecodedStreams.Contains(StreamKey))
+		{
+			DecodedStreams.Reset();
+		}
+
+		FDeltaStream& Stream = DecodedStreams.FindOrAdd(StreamKey);
+		{
+			Stream.Payload = Record.Payload;
+			Stream.Sequence = (uint32)Sequence;
+		}
+
+		return true;
+	}
+
+	FDeltaStream* Stream = DecodedStreams.Find(StreamKey);
+
+	if ((Stream == nullptr) || (Stream->Sequence != (uint32)BaseSequence))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported %s delta, its base message wasn't received"), *Record.MessageType.ToString());
+
+		return false;
+	}
+
+	TArray<uint8> Payload;
+
+	if (!SGTransportCodec::DecodeDelta(Stream->Payload, Record.Payload, Payload))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported %s delta, it is malformed"), *Record.MessageType.ToString());
+
+		return false;
+	}
+
+	Stream->Payload = Payload;
+	Stream->Sequence = (uint32)Sequence;
+	Record.Payload = MoveTemp(Payload);
+
+	return true;
+}
+
+
+void FSGTransportCodec::CompressMessage(const FName& MessageType, TArray<uint8>& Message) const
+{
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+	const int32 UncompressedSize = Message.Num() - 1;
+
+	TArray<uint8> CompressedMessage;
+	{
+		FSGWireWriter HeaderWriter(CompressedMessage);
+
+		HeaderWriter.WriteByte((uint8)EEncoding::Compressed);
+		HeaderWriter.WriteByte(CompressionFormatId);
+		HeaderWriter.WriteVarint(UncompressedSize);
+	}
+
+	const int32 HeaderSize = CompressedMessage.Num();
+	int32 CompressedSize = FCompression::CompressMemoryBound(CompressionFormat, UncompressedSize);
+
+	CompressedMessage.SetNumUninitialized(HeaderSize + CompressedSize, false);
+
+	// incompressible messages are sent as they are
+	if (!FCompression::CompressMemory(CompressionFormat, CompressedMessage.GetData() + HeaderSize, CompressedSize, Message.GetData() + 1, UncompressedSize) || (HeaderSize + CompressedSize >= Message.Num()))
+	{
+		return;
+	}
+
+	CompressedMessage.SetNum(HeaderSize + CompressedSize, false);
+	Message = MoveTemp(CompressedMessage);
+
+	FSGMessageCompressionCounters::CountCompression(MessageType, UncompressedSize, CompressedSize, FPlatformTime::Cycles64() - StartCycles);
+}
+
+
+UScriptStruct* FSGTransportCodec::FindTypeInfo(const FSGCapturedMessage& Message)
+{
+	if (const TWeakObjectPtr<UScriptStruct>* CachedTypeInfo = TypeInfos.Find(Message.TypeInfoPath))
+	{
+		if (UScriptStruct* TypeInfo = CachedTypeInfo->Get())
+		{
+			return TypeInfo;
+		}
+	}
+
+	// returns nullptr while objects are garbage collected, the lookup is retried with the next message
+	UScriptStruct* TypeInfo = FindObjectSafe<UScriptStruct>(nullptr, *Message.TypeInfoPath);
+
+	if (TypeInfo == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding transported %s message, the structure %s doesn't exist"), *Message.MessageType.ToString(), *Message.TypeInfoPath);
+
+		return nullptr;
+	}
+
+	TypeInfos.Add(Message.TypeInfoPath, TypeInfo);
+
+	return TypeInfo;
+}
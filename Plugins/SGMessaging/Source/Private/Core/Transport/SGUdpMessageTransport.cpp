@@ -0,0 +1,1229 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGUdpMessageTransport.h"
+#include "HAL/Runnable.h"
+#include "HAL/RunnableThread.h"
+#include "Misc/ScopeLock.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageTransportHandler.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessageWire.h"
+
+
+namespace SGUdpMessageTransport
+{
+	/** Size of the datagram header: magic, protocol version and node identifier. */
+	constexpr int32 HeaderSize = sizeof(uint32) + 1 + sizeof(FGuid);
+
+	/** Largest size of a fragment segment without its payload: type, size, sequence number, message identifier, index and count. */
+	constexpr int32 FragmentOverhead = 1 + 3 + 5 + 5 + 3 + 3;
+
+	/** Largest number of fragments of a message. */
+	constexpr uint64 MaxFragments = 4096;
+
+	/** Time between hellos (in seconds). */
+	constexpr double HelloInterval = 1.0;
+
+	/** Time after which silent nodes and incomplete messages are forgotten (in seconds). */
+	constexpr double NodeTimeout = 5.0;
+
+	/** Size of the socket's system buffers (in bytes). */
+	constexpr int32 SocketBufferSize = 2 * 1024 * 1024;
+
+	/** Largest number of datagram buffers kept for reuse. */
+	constexpr int32 MaxFreeDatagramBuffers = 2 * FSGUdpSocket::MaxBatchSize;
+
+	/** Largest number of unacknowledged reliable messages per node, which is also the receivers' reorder window. */
+	constexpr int32 ReliableWindowSize = 256;
+
+	/** Largest number of reliable messages per node that wait for the window to open. */
+	constexpr int32 MaxReliableBacklog = 4096;
+
+	/** Number of sequence numbers after the next expected one that an acknowledgement covers. */
+	constexpr int32 AckMaskBits = 64;
+
+	/** Shortest retransmit timeout (in seconds). */
+	constexpr double MinRetransmitTimeout = 0.02;
+
+	/** Longest retransmit timeout (in seconds). */
+	constexpr double MaxRetransmitTimeout = 1.0;
+
+	/** Gets the number of bytes of a variable-length quantity. */
+	int32 GetVarintSize(uint64 Value)
+	{
+		int32 Size = 1;
+
+		while (Value >= 0x80)
+		{
+			Value >>= 7;
+			++Size;
+		}
+
+		return Size;
+	}
+
+	/** Gets the signed distance between two sequence numbers, which may have wrapped around. */
+	int32 GetSequenceDistance(uint32 From, uint32 To)
+	{
+		return (int32)(To - From);
+	}
+}
+
+
+/**
+ * Implements the runnable of the receiver thread.
+ */
+class FSGUdpMessageTransport::FReceiver
+	: public FRunnable
+{
+public:
+
+	explicit FReceiver(FSGUdpMessageTransport& InTransport)
+		: Transport(InTransport)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Transport.ReceiveDatagrams();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Transport.bStopping.store(true);
+	}
+
+private:
+
+	/** Holds the transport. */
+	FSGUdpMessageTransport& Transport;
+};
+
+
+/**
+ * Implements the runnable of the sender thread.
+ */
+class FSGUdpMessageTransport::FSender
+	: public FRunnable
+{
+public:
+
+	explicit FSender(FSGUdpMessageTransport& InTransport)
+		: Transport(InTransport)
+	{ }
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override
+	{
+		Transport.SendDatagrams();
+
+		return 0;
+	}
+
+	virtual void Stop() override
+	{
+		Transport.bStopping.store(true);
+		Transport.SendEvent->Trigger();
+	}
+
+private:
+
+	/** Holds the transport. */
+	FSGUdpMessageTransport& Transport;
+};
+
+
+/* FSGUdpMessageTransport structors
+ *****************************************************************************/
+
+FSGUdpMessageTransport::FSGUdpMessageTransport(const FSGNetworkEndpoint& InUnicastEndpoint, const TArray<FSGNetworkEndpoint>& InStaticEndpoints, int32 InMaxDatagramSize)
+	: UnicastEndpoint(InUnicastEndpoint)
+	, MaxDatagramSize(FMath::Clamp(InMaxDatagramSize, 512, 65507))
+	, NodeId(FGuid::NewGuid())
+	, Handler(nullptr)
+	, bStopping(false)
+	, ReceiverThread(nullptr)
+	, SenderThread(nullptr)
+	, SendEvent(FPlatformProcess::GetSynchEventFromPool())
+	, StaticEndpoints(InStaticEndpoints)
+	, NextMessageId(0)
+	, NumSentDatagrams(0)
+	, NumReceivedDatagrams(0)
+	, LastTimerId(0)
+	, NumRetransmittedMessages(0)
+{ }
+
+
+FSGUdpMessageTransport::~FSGUdpMessageTransport()
+{
+	StopTransport();
+
+	FPlatformProcess::ReturnSynchEventToPool(SendEvent);
+	SendEvent = nullptr;
+}
+
+
+/* FSGUdpMessageTransport interface
+ *****************************************************************************/
+
+void FSGUdpMessageTransport::AddStaticEndpoint(const FSGNetworkEndpoint& Endpoint)
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	StaticEndpoints.AddUnique(Endpoint);
+}
+
+
+void FSGUdpMessageTransport::RemoveStaticEndpoint(const FSGNetworkEndpoint& Endpoint)
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	StaticEndpoints.Remove(Endpoint);
+}
+
+
+/* ISGMessageTransport interface
+ *****************************************************************************/
+
+FName FSGUdpMessageTransport::GetDebugName() const
+{
+	return TEXT("SGUdpMessageTransport");
+}
+
+
+bool FSGUdpMessageTransport::StartTransport(ISGMessageTransportHandler& InHandler)
+{
+	if (Handler != nullptr)
+	{
+		return true;
+	}
+
+	if (!Socket.Open(UnicastEndpoint, SGUdpMessageTransport::SocketBufferSize))
+	{
+		return false;
+	}
+
+	Handler = &InHandler;
+	bStopping.store(false);
+
+	Receiver = MakeUnique<FReceiver>(*this);
+	Sender = MakeUnique<FSender>(*this);
+	ReceiverThread = FRunnableThread::Create(Receiver.Get(), TEXT("FSGUdpMessageTransport.Receiver"), 128 * 1024, TPri_AboveNormal);
+	SenderThread = FRunnableThread::Create(Sender.Get(), TEXT("FSGUdpMessageTransport.Sender"), 128 * 1024, TPri_AboveNormal);
+
+	if ((ReceiverThread == nullptr) || (SenderThread == nullptr))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't start UDP message transport on %s, its threads can't be created"), *UnicastEndpoint.ToString());
+
+		StopTransport();
+
+		return false;
+	}
+
+	UE_LOG(LogSGMessaging, Log, TEXT("Started UDP message transport on %s (node %s)"), *UnicastEndpoint.ToString(), *NodeId.ToString());
+
+	return true;
+}
+
+
+void FSGUdpMessageTransport::StopTransport()
+{
+	if (Handler == nullptr)
+	{
+		return;
+	}
+
+	// the sender says bye to all nodes before it exits
+	if (SenderThread != nullptr)
+	{
+		SenderThread->Kill(true);
+		delete SenderThread;
+		SenderThread = nullptr;
+	}
+
+	if (ReceiverThread != nullptr)
+	{
+		ReceiverThread->Kill(true);
+		delete ReceiverThread;
+		ReceiverThread = nullptr;
+	}
+
+	Receiver.Reset();
+	Sender.Reset();
+	Socket.Close();
+
+	FOutboundMessage OutboundMessage;
+	FAck Ack;
+	FGuid NodeIdToForget;
+
+	while (OutboundMessages.Dequeue(OutboundMessage));
+	while (ReceivedAcks.Dequeue(Ack));
+	while (OutgoingAcks.Dequeue(Ack));
+	while (ForgottenNodes.Dequeue(NodeIdToForget));
+
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+		Nodes.Empty();
+	}
+
+	Reassemblies.Empty();
+	ReliableReceivers.Empty();
+	ReliableSenders.Empty();
+	RetransmitTargets.Empty();
+	RetransmitTimers = FSGMessageTimingWheel();
+	PackedDatagrams.Empty();
+	FinishedDatagrams.Empty();
+	Handler = nullptr;
+}
+
+
+bool FSGUdpMessageTransport::TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients)
+{
+	if ((Handler == nullptr) || !EnqueueMessage(Context, Recipients))
+	{
+		return false;
+	}
+
+	SendEvent->Trigger();
+
+	return true;
+}
+
+
+int32 FSGUdpMessageTransport::TransportMessages(TArrayView<const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Contexts, const TArray<FGuid>& Recipients)
+{
+	if (Handler == nullptr)
+	{
+		return 0;
+	}
+
+	int32 NumTransported = 0;
+
+	for (const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context : Contexts)
+	{
+		if (EnqueueMessage(Context, Recipients))
+		{
+			++NumTransported;
+		}
+	}
+
+	// the sender thread packs the whole batch after a single wake-up
+	if (NumTransported > 0)
+	{
+		SendEvent->Trigger();
+	}
+
+	return NumTransported;
+}
+
+
+/* FSGUdpMessageTransport implementation
+ *****************************************************************************/
+
+bool FSGUdpMessageTransport::EnqueueMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients)
+{
+	FOutboundMessage OutboundMessage;
+
+	if (!Codec.EncodeMessage(*Context, OutboundMessage.Message))
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Can't transport %s message, its payload can't be encoded"), *Context->GetMessageType().ToString());
+
+		return false;
+	}
+
+	const int32 MaxMessageSize = (int32)SGUdpMessageTransport::MaxFragments * (MaxDatagramSize - SGUdpMessageTransport::HeaderSize - SGUdpMessageTransport::FragmentOverhead);
+
+	if (OutboundMessage.Message.Num() > MaxMessageSize)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't transport %s message, it is larger than %d bytes"), *Context->GetMessageType().ToString(), MaxMessageSize);
+
+		return false;
+	}
+
+	OutboundMessage.Recipients = Recipients;
+	OutboundMessage.bReliable = EnumHasAnyFlags(Context->GetFlags(), ESGMessageFlags::Reliable);
+	OutboundMessages.Enqueue(MoveTemp(OutboundMessage));
+
+	return true;
+}
+
+
+void FSGUdpMessageTransport::ReceiveDatagrams()
+{
+	TArray<FSGUdpInboundDatagram> Datagrams;
+	Datagrams.SetNum(FSGUdpSocket::MaxBatchSize);
+
+	for (FSGUdpInboundDatagram& Datagram : Datagrams)
+	{
+		Datagram.Data.SetNumUninitialized(MaxDatagramSize);
+	}
+
+	double NextCleanupTime = 0.0;
+
+	while (!bStopping.load())
+	{
+		const int32 NumReceived = Socket.ReceiveBatch(Datagrams, FTimespan::FromMilliseconds(100.0));
+		const double Now = FSGMessageClock::Seconds();
+
+		for (int32 Index = 0; Index < NumReceived; ++Index)
+		{
+			ProcessDatagram(Datagrams[Index], Now);
+		}
+
+		QueueAcks();
+		NumReceivedDatagrams.fetch_add(NumReceived, std::memory_order_relaxed);
+
+		if (Now >= NextCleanupTime)
+		{
+			ForgetStaleNodes(Now);
+			NextCleanupTime = Now + SGUdpMessageTransport::HelloInterval;
+		}
+	}
+}
+
+
+void FSGUdpMessageTransport::SendDatagrams()
+{
+	double NextHelloTime = 0.0;
+
+	while (!bStopping.load())
+	{
+		SendPendingMessages();
+
+		const double Now = FSGMessageClock::Seconds();
+
+		if (Now >= NextHelloTime)
+		{
+			TArray<FSGNetworkEndpoint> Endpoints;
+			{
+				FScopeLock Lock(&NodesCriticalSection);
+
+				Endpoints = StaticEndpoints;
+
+				for (const auto& NodePair : Nodes)
+				{
+					Endpoints.AddUnique(NodePair.Value.Endpoint);
+				}
+			}
+
+			SendControlSegment(ESegment::Hello, Endpoints);
+			NextHelloTime = Now + SGUdpMessageTransport::HelloInterval;
+		}
+
+		double WaitTime = FMath::Max(NextHelloTime - FSGMessageClock::Seconds(), 0.0);
+
+		// wake up for the next retransmit timer
+		if (RetransmitTimers.Num() > 0)
+		{
+			const uint64 MaxWaitTicks = (uint64)(WaitTime * 1000.0) + 1;
+			WaitTime = FMath::Min(WaitTime, RetransmitTimers.GetTicksUntilNextAdvance(MaxWaitTicks) / 1000.0);
+		}
+
+		SendEvent->Wait(FTimespan::FromSeconds(WaitTime));
+	}
+
+	SendPendingMessages();
+
+	TArray<FSGNetworkEndpoint> Endpoints;
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		for (const auto& NodePair : Nodes)
+		{
+			Endpoints.AddUnique(NodePair.Value.Endpoint);
+		}
+	}
+
+	SendControlSegment(ESegment::Bye, Endpoints);
+}
+
+
+void FSGUdpMessageTransport::ProcessDatagram(const FSGUdpInboundDatagram& Datagram, double Now)
+{
+	FSGWireReader Reader(MakeArrayView(Datagram.Data.GetData(), Datagram.Size));
+	const uint8* Magic = Reader.ReadBytes(sizeof(uint32));
+	uint8 Version = 0;
+
+	if ((Magic == nullptr) || (FMemory::Memcmp(Magic, &DatagramMagic, sizeof(uint32)) != 0) || !Reader.ReadByte(Version) || (Version < (uint8)ESGUdpTransportVersion::ReliableDelivery) || (Version > (uint8)ESGUdpTransportVersion::Latest))
+	{
+		return;
+	}
+
+	const uint8* SenderIdBytes = Reader.ReadBytes(sizeof(FGuid));
+	FGuid SenderId;
+
+	if (SenderIdBytes == nullptr)
+	{
+		return;
+	}
+
+	FMemory::Memcpy(&SenderId, SenderIdBytes, sizeof(FGuid));
+
+	// static endpoints may include this transport
+	if (SenderId == NodeId)
+	{
+		return;
+	}
+
+	bool bDiscovered = false;
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		FNode* Node = Nodes.Find(SenderId);
+
+		if (Node == nullptr)
+		{
+			Node = &Nodes.Add(SenderId);
+			bDiscovered = true;
+		}
+
+		Node->Endpoint = Datagram.Sender;
+		Node->LastSeen = Now;
+	}
+
+	if (bDiscovered)
+	{
+		UE_LOG(LogSGMessaging, Log, TEXT("Discovered UDP transport node %s at %s"), *SenderId.ToString(), *Datagram.Sender.ToString());
+
+		Handler->DiscoverTransportNode(SenderId);
+	}
+
+	while (!Reader.IsAtEnd())
+	{
+		uint8 Segment = 0;
+		TArrayView<const uint8> Body;
+
+		if (!Reader.ReadByte(Segment) || !Reader.ReadSized(Body))
+		{
+			UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding malformed datagram from %s"), *Datagram.Sender.ToString());
+
+			return;
+		}
+
+		switch ((ESegment)Segment)
+		{
+		case ESegment::Bye:
+			{
+				{
+					FScopeLock Lock(&NodesCriticalSection);
+					Nodes.Remove(SenderId);
+				}
+
+				ReliableReceivers.Remove(SenderId);
+				ForgottenNodes.Enqueue(SenderId);
+
+				UE_LOG(LogSGMessaging, Log, TEXT("UDP transport node %s said bye"), *SenderId.ToString());
+
+				Handler->ForgetTransportNode(SenderId);
+			}
+			return;
+
+		case ESegment::Message:
+			ReceiveMessage(Body, SenderId);
+			break;
+
+		case ESegment::Fragment:
+			ReceiveFragment(Body, SenderId, false, Now);
+			break;
+
+		case ESegment::ReliableMessage:
+			{
+				FSGWireReader MessageReader(Body);
+				uint64 Sequence = 0;
+
+				if (MessageReader.ReadVarint(Sequence))
+				{
+					ReceiveReliableMessage(Body.RightChop(MessageReader.Tell()), SenderId, (uint32)Sequence);
+				}
+			}
+			break;
+
+		case ESegment::ReliableFragment:
+			ReceiveFragment(Body, SenderId, true, Now);
+			break;
+
+		case ESegment::Ack:
+			{
+				FSGWireReader AckReader(Body);
+				uint64 NextSequence = 0;
+				FAck Ack;
+
+				if (AckReader.ReadVarint(NextSequence) && AckReader.ReadVarint(Ack.ReceivedMask))
+				{
+					Ack.NodeId = SenderId;
+					Ack.NextSequence = (uint32)NextSequence;
+					ReceivedAcks.Enqueue(Ack);
+					SendEvent->Trigger();
+				}
+			}
+			break;
+
+		default:
+			// hellos only keep the node alive, and newer segment types are skipped
+			break;
+		}
+	}
+}
+
+
+void FSGUdpMessageTransport::ReceiveMessage(TArrayView<const uint8> Message, const FGuid& SenderId)
+{
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context = Codec.DecodeMessage(Message);
+
+	if (!Context.IsValid())
+	{
+		UE_LOG(LogSGMessaging, Verbose, TEXT("Discarding message from UDP transport node %s"), *SenderId.ToString());
+
+		return;
+	}
+
+	Handler->ReceiveTransportMessage(Context.ToSharedRef(), SenderId);
+}
+
+
+void FSGUdpMessageTransport::ReceiveFragment(TArrayView<const uint8> Body, const FGuid& SenderId, bool bReliable, double Now)
+{
+	FSGWireReader FragmentReader(Body);
+	uint64 Sequence = 0;
+	uint64 MessageId = 0;
+	uint64 FragmentIndex = 0;
+	uint64 NumFragments = 0;
+
+	if ((bReliable && !FragmentReader.ReadVarint(Sequence)) || !FragmentReader.ReadVarint(MessageId) || !FragmentReader.ReadVarint(FragmentIndex) || !FragmentReader.ReadVarint(NumFragments)
+		|| (NumFragments == 0) || (NumFragments > SGUdpMessageTransport::MaxFragments) || (FragmentIndex >= NumFragments))
+	{
+		return;
+	}
+
+	const TPair<FGuid, uint32> ReassemblyKey(SenderId, (uint32)MessageId);
+	FReassembly& Reassembly = Reassemblies.FindOrAdd(ReassemblyKey);
+
+	if (Reassembly.Fragments.Num() == 0)
+	{
+		Reassembly.Fragments.SetNum((int32)NumFragments);
+
+		if (bReliable)
+		{
+			Reassembly.Sequence = (uint32)Sequence;
+		}
+	}
+
+	if ((Reassembly.Fragments.Num() != (int32)NumFragments) || (Reassembly.Sequence.IsSet() != bReliable) || FragmentReader.IsAtEnd())
+	{
+		return;
+	}
+
+	TArray<uint8>& Fragment = Reassembly.Fragments[(int32)FragmentIndex];
+
+	// fragments are never empty, so a filled slot means a duplicate
+	if (Fragment.Num() > 0)
+	{
+		return;
+	}
+
+	Fragment.Append(Body.GetData() + FragmentReader.Tell(), Body.Num() - FragmentReader.Tell());
+	Reassembly.LastReceived = Now;
+
+	if (++Reassembly.NumReceived == Reassembly.Fragments.Num())
+	{
+		TArray<uint8> Message;
+
+		for (const TArray<uint8>& ReceivedFragment : Reassembly.Fragments)
+		{
+			Message.Append(ReceivedFragment);
+		}
+
+		const TOptional<uint32> ReliableSequence = Reassembly.Sequence;
+
+		Reassemblies.Remove(ReassemblyKey);
+
+		if (ReliableSequence.IsSet())
+		{
+			ReceiveReliableMessage(Message, SenderId, ReliableSequence.GetValue());
+		}
+		else
+		{
+			ReceiveMessage(Message, SenderId);
+		}
+	}
+}
+
+
+void FSGUdpMessageTransport::ReceiveReliableMessage(TArrayView<const uint8> Message, const FGuid& SenderId, uint32 Sequence)
+{
+	FReliableReceiver& ReliableReceiver = ReliableReceivers.FindOrAdd(SenderId);
+	const int32 Distance = SGUdpMessageTransport::GetSequenceDistance(ReliableReceiver.NextSequence, Sequence);
+
+	// duplicates are acknowledged again, in case the previous acknowledgement was lost
+	ReliableReceiver.bAckPending = true;
+
+	if ((Distance < 0) || (Distance >= SGUdpMessageTransport::ReliableWindowSize) || ReliableReceiver.OutOfOrder.Contains(Sequence))
+	{
+		return;
+	}
+
+	if (Distance > 0)
+	{
+		ReliableReceiver.OutOfOrder.Add(Sequence, TArray<uint8>(Message.GetData(), Message.Num()));
+
+		return;
+	}
+
+	ReceiveMessage(Message, SenderId);
+	++ReliableReceiver.NextSequence;
+
+	// the message may have been the gap in front of buffered ones
+	TArray<uint8> BufferedMessage;
+
+	while (ReliableReceiver.OutOfOrder.RemoveAndCopyValue(ReliableReceiver.NextSequence, BufferedMessage))
+	{
+		ReceiveMessage(BufferedMessage, SenderId);
+		++ReliableReceiver.NextSequence;
+	}
+}
+
+
+void FSGUdpMessageTransport::QueueAcks()
+{
+	bool bQueued = false;
+
+	for (auto& ReceiverPair : ReliableReceivers)
+	{
+		FReliableReceiver& ReliableReceiver = ReceiverPair.Value;
+
+		if (!ReliableReceiver.bAckPending)
+		{
+			continue;
+		}
+
+		FAck Ack;
+		{
+			Ack.NodeId = ReceiverPair.Key;
+			Ack.NextSequence = ReliableReceiver.NextSequence;
+		}
+
+		for (const auto& BufferedPair : ReliableReceiver.OutOfOrder)
+		{
+			const int32 Bit = SGUdpMessageTransport::GetSequenceDistance(ReliableReceiver.NextSequence, BufferedPair.Key) - 1;
+
+			if (Bit < SGUdpMessageTransport::AckMaskBits)
+			{
+				Ack.ReceivedMask |= 1ull << Bit;
+			}
+		}
+
+		OutgoingAcks.Enqueue(Ack);
+		ReliableReceiver.bAckPending = false;
+		bQueued = true;
+	}
+
+	if (bQueued)
+	{
+		SendEvent->Trigger();
+	}
+}
+
+
+void FSGUdpMessageTransport::ForgetStaleNodes(double Now)
+{
+	TArray<FGuid, TInlineAllocator<4>> StaleNodes;
+	{
+		FScopeLock Lock(&NodesCriticalSection);
+
+		for (auto It = Nodes.CreateIterator(); It; ++It)
+		{
+			if (Now - It.Value().LastSeen > SGUdpMessageTransport::NodeTimeout)
+			{
+				StaleNodes.Add(It.Key());
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	for (const FGuid& StaleNode : StaleNodes)
+	{
+		UE_LOG(LogSGMessaging, Log, TEXT("Lost UDP transport node %s"), *StaleNode.ToString());
+
+		ReliableReceivers.Remove(StaleNode);
+		ForgottenNodes.Enqueue(StaleNode);
+		Handler->ForgetTransportNode(StaleNode);
+	}
+
+	for (auto It = Reassemblies.CreateIterator(); It; ++It)
+	{
+		if (Now - It.Value().LastReceived > SGUdpMessageTransport::NodeTimeout)
+		{
+			It.RemoveCurrent();
+		}
+	}
+}
+
+
+void FSGUdpMessageTransport::SendPendingMessages()
+{
+	FGuid ForgottenNode;
+
+	// forgotten nodes start their sequences over when they are discovered again
+	while (ForgottenNodes.Dequeue(ForgottenNode))
+	{
+		ReliableSenders.Remove(ForgottenNode);
+	}
+
+	ProcessReceivedAcks();
+	PackOutgoingAcks();
+	RetransmitMessages();
+
+	FOutboundMessage OutboundMessage;
+	TArray<TPair<FGuid, FSGNetworkEndpoint>, TInlineAllocator<8>> Recipients;
+
+	while (OutboundMessages.Dequeue(OutboundMessage))
+	{
+		Recipients.Reset();
+		{
+			FScopeLock Lock(&NodesCriticalSection);
+
+			if (OutboundMessage.Recipients.Num() == 0)
+			{
+				for (const auto& NodePair : Nodes)
+				{
+					Recipients.Emplace(NodePair.Key, NodePair.Value.Endpoint);
+				}
+			}
+			else
+			{
+				for (const FGuid& Recipient : OutboundMessage.Recipients)
+				{
+					if (const FNode* Node = Nodes.Find(Recipient))
+					{
+						Recipients.Emplace(Recipient, Node->Endpoint);
+					}
+				}
+			}
+		}
+
+		const uint32 MessageId = NextMessageId++;
+
+		if (!OutboundMessage.bReliable)
+		{
+			for (const auto& Recipient : Recipients)
+			{
+				PackMessage(Recipient.Value, OutboundMessage.Message, MessageId);
+			}
+
+			continue;
+		}
+
+		// reliable messages are kept until every recipient acknowledged them
+		const TSharedPtr<const TArray<uint8>> Message = MakeShared<TArray<uint8>>(MoveTemp(OutboundMessage.Message));
+
+		for (const auto& Recipient : Recipients)
+		{
+			FUnackedMessage Unacked;
+			{
+				Unacked.Message = Message;
+				Unacked.MessageId = MessageId;
+			}
+
+			SendReliableMessage(Recipient.Key, Recipient.Value, MoveTemp(Unacked));
+		}
+	}
+
+	// send what was packed, latency matters more than filling every datagram
+	for (auto& DatagramPair : PackedDatagrams)
+	{
+		if (DatagramPair.Value.Data.Num() > 0)
+		{
+			FinishDatagram(DatagramPair.Value);
+		}
+	}
+
+	FlushDatagrams();
+}
+
+
+void FSGUdpMessageTransport::ProcessReceivedAcks()
+{
+	const double Now = FSGMessageClock::Seconds();
+	FAck Ack;
+
+	while (ReceivedAcks.Dequeue(Ack))
+	{
+		FReliableSender* ReliableSender = ReliableSenders.Find(Ack.NodeId);
+
+		// acknowledgements of messages that weren't sent yet are bogus
+		if ((ReliableSender == nullptr) || (SGUdpMessageTransport::GetSequenceDistance(Ack.NextSequence, ReliableSender->NextSequence) < 0))
+		{
+			continue;
+		}
+
+		while (SGUdpMessageTransport::GetSequenceDistance(ReliableSender->AckedSequence, Ack.NextSequence) > 0)
+		{
+			AcknowledgeMessage(*ReliableSender, ReliableSender->AckedSequence++, Now);
+		}
+
+		for (int32 Bit = 0; Bit < SGUdpMessageTransport::AckMaskBits; ++Bit)
+		{
+			if ((Ack.ReceivedMask & (1ull << Bit)) != 0)
+			{
+				AcknowledgeMessage(*ReliableSender, Ack.NextSequence + 1 + Bit, Now);
+			}
+		}
+
+		if (ReliableSender->Backlog.Num() == 0)
+		{
+			continue;
+		}
+
+		FSGNetworkEndpoint Endpoint;
+
+		if (!FindNodeEndpoint(Ack.NodeId, Endpoint))
+		{
+			ReliableSenders.Remove(Ack.NodeId);
+
+			continue;
+		}
+
+		// the acknowledgement may have opened the window for backlogged messages
+		int32 NumAdmitted = 0;
+
+		while ((NumAdmitted < ReliableSender->Backlog.Num()) && (SGUdpMessageTransport::GetSequenceDistance(ReliableSender->AckedSequence, ReliableSender->NextSequence) < SGUdpMessageTransport::ReliableWindowSize))
+		{
+			TransmitReliableMessage(Ack.NodeId, Endpoint, *ReliableSender, MoveTemp(ReliableSender->Backlog[NumAdmitted++]));
+		}
+
+		ReliableSender->Backlog.RemoveAt(0, NumAdmitted, false);
+	}
+}
+
+
+void FSGUdpMessageTransport::PackOutgoingAcks()
+{
+	FAck Ack;
+
+	while (OutgoingAcks.Dequeue(Ack))
+	{
+		FSGNetworkEndpoint Endpoint;
+
+		if (!FindNodeEndpoint(Ack.NodeId, Endpoint))
+		{
+			continue;
+		}
+
+		const int32 BodySize = SGUdpMessageTransport::GetVarintSize(Ack.NextSequence) + SGUdpMessageTransport::GetVarintSize(Ack.ReceivedMask);
+		FSGWireWriter Writer(GetPackedDatagram(Endpoint, 1 + SGUdpMessageTransport::GetVarintSize(BodySize) + BodySize));
+
+		// acknowledgements travel with the messages that are packed for the node next
+		Writer.WriteByte((uint8)ESegment::Ack);
+		Writer.WriteVarint(BodySize);
+		Writer.WriteVarint(Ack.NextSequence);
+		Writer.WriteVarint(Ack.ReceivedMask);
+	}
+}
+
+
+void FSGUdpMessageTransport::RetransmitMessages()
+{
+	TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> ExpiredContexts;
+	TArray<uint64> ExpiredTimers;
+
+	RetransmitTimers.Advance(FSGMessageTimingWheel::GetMonotonicTick(), ExpiredContexts, ExpiredTimers);
+
+	for (const uint64 TimerId : ExpiredTimers)
+	{
+		TPair<FGuid, uint32> Target;
+
+		if (!RetransmitTargets.RemoveAndCopyValue(TimerId, Target))
+		{
+			continue;
+		}
+
+		FReliableSender* ReliableSender = ReliableSenders.Find(Target.Key);
+		FUnackedMessage* Unacked = (ReliableSender != nullptr) ? ReliableSender->Unacked.Find(Target.Value) : nullptr;
+
+		if (Unacked == nullptr)
+		{
+			continue;
+		}
+
+		FSGNetworkEndpoint Endpoint;
+
+		if (!FindNodeEndpoint(Target.Key, Endpoint))
+		{
+			ReliableSenders.Remove(Target.Key);
+
+			continue;
+		}
+
+		ReliableSender->RetransmitTimeout = FMath::Min(ReliableSender->RetransmitTimeout * 2.0, SGUdpMessageTransport::MaxRetransmitTimeout);
+
+		Unacked->bRetransmitted = true;
+		Unacked->TimerId = ++LastTimerId;
+
+		PackMessage(Endpoint, *Unacked->Message, Unacked->MessageId, Target.Value);
+		RetransmitTimers.AddTimeout(Unacked->TimerId, FSGMessageTimingWheel::GetMonotonicTick() + (uint64)(ReliableSender->RetransmitTimeout * 1000.0));
+		RetransmitTargets.Add(Unacked->TimerId, Target);
+		NumRetransmittedMessages.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+
+void FSGUdpMessageTransport::SendReliableMessage(const FGuid& RecipientId, const FSGNetworkEndpoint& Endpoint, FUnackedMessage&& Unacked)
+{
+	FReliableSender& ReliableSender = ReliableSenders.FindOrAdd(RecipientId);
+
+	if ((ReliableSender.Backlog.Num() == 0) && (SGUdpMessageTransport::GetSequenceDistance(ReliableSender.AckedSequence, ReliableSender.NextSequence) < SGUdpMessageTransport::ReliableWindowSize))
+	{
+		TransmitReliableMessage(RecipientId, Endpoint, ReliableSender, MoveTemp(Unacked));
+	}
+	else if (ReliableSender.Backlog.Num() < SGUdpMessageTransport::MaxReliableBacklog)
+	{
+		ReliableSender.Backlog.Add(MoveTemp(Unacked));
+	}
+	else
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Dropping reliable message to UDP transport node %s, its backlog is full"), *RecipientId.ToString());
+	}
+}
+
+
+void FSGUdpMessageTransport::TransmitReliableMessage(const FGuid& RecipientId, const FSGNetworkEndpoint& Endpoint, FReliableSender& ReliableSender, FUnackedMessage&& Unacked)
+{
+	const uint32 Sequence = ReliableSender.NextSequence++;
+
+	Unacked.SentTime = FSGMessageClock::Seconds();
+	Unacked.TimerId = ++LastTimerId;
+
+	PackMessage(Endpoint, *Unacked.Message, Unacked.MessageId, Sequence);
+	RetransmitTimers.AddTimeout(Unacked.TimerId, FSGMessageTimingWheel::GetMonotonicTick() + (uint64)(ReliableSender.RetransmitTimeout * 1000.0));
+	RetransmitTargets.Add(Unacked.TimerId, TPair<FGuid, uint32>(RecipientId, Sequence));
+	ReliableSender.Unacked.Add(Sequence, MoveTemp(Unacked));
+}
+
+
+void FSGUdpMessageTransport::AcknowledgeMessage(FReliableSender& ReliableSender, uint32 Sequence, double Now)
+{
+	FUnackedMessage Unacked;
+
+	if (!ReliableSender.Unacked.RemoveAndCopyValue(Sequence, Unacked))
+	{
+		return;
+	}
+
+	RetransmitTimers.Remove(Unacked.TimerId);
+	RetransmitTargets.Remove(Unacked.TimerId);
+
+	// round trips of retransmitted messages are ambiguous (Karn's algorithm)
+	if (Unacked.bRetransmitted)
+	{
+		return;
+	}
+
+	const double RoundTripTime = Now - Unacked.SentTime;
+
+	if (ReliableSender.SmoothedRtt == 0.0)
+	{
+		ReliableSender.SmoothedRtt = RoundTripTime;
+		ReliableSender.RttVariation = 0.5 * RoundTripTime;
+	}
+	else
+	{
+		ReliableSender.RttVariation = 0.75 * ReliableSender.RttVariation + 0.25 * FMath::Abs(ReliableSender.SmoothedRtt - RoundTripTime);
+		ReliableSender.SmoothedRtt = 0.875 * ReliableSender.SmoothedRtt + 0.125 * RoundTripTime;
+	}
+
+	ReliableSender.RetransmitTimeout = FMath::Clamp(ReliableSender.SmoothedRtt + 4.0 * ReliableSender.RttVariation, SGUdpMessageTransport::MinRetransmitTimeout, SGUdpMessageTransport::MaxRetransmitTimeout);
+}
+
+
+bool FSGUdpMessageTransport::FindNodeEndpoint(const FGuid& RemoteNodeId, FSGNetworkEndpoint& OutEndpoint) const
+{
+	FScopeLock Lock(&NodesCriticalSection);
+
+	const FNode* Node = Nodes.Find(RemoteNodeId);
+
+	if (Node == nullptr)
+	{
+		return false;
+	}
+
+	OutEndpoint = Node->Endpoint;
+
+	return true;
+}
+
+
+void FSGUdpMessageTransport::SendControlSegment(ESegment Segment, TArrayView<const FSGNetworkEndpoint> Endpoints)
+{
+	for (const FSGNetworkEndpoint& Endpoint : Endpoints)
+	{
+		FPackedDatagram Datagram;
+		{
+			Datagram.Recipient = Endpoint;
+			Datagram.Data = AllocateDatagramBuffer();
+		}
+
+		BeginDatagram(Datagram.Data);
+
+		FSGWireWriter Writer(Datagram.Data);
+		Writer.WriteByte((uint8)Segment);
+		Writer.WriteVarint(0);
+
+		FinishDatagram(Datagram);
+	}
+
+	FlushDatagrams();
+}
+
+
+void FSGUdpMessageTransport::PackMessage(const FSGNetworkEndpoint& Endpoint, TArrayView<const uint8> Message, uint32 MessageId, TOptional<uint32> Sequence)
+{
+	const int32 BodySize = (Sequence.IsSet() ? SGUdpMessageTransport::GetVarintSize(Sequence.GetValue()) : 0) + Message.Num();
+	const int32 SegmentSize = 1 + SGUdpMessageTransport::GetVarintSize(BodySize) + BodySize;
+
+	if (SGUdpMessageTransport::HeaderSize + SegmentSize <= MaxDatagramSize)
+	{
+		FSGWireWriter Writer(GetPackedDatagram(Endpoint, SegmentSize));
+
+		if (Sequence.IsSet())
+		{
+			Writer.WriteByte((uint8)ESegment::ReliableMessage);
+			Writer.WriteVarint(BodySize);
+			Writer.WriteVarint(Sequence.GetValue());
+		}
+		else
+		{
+			Writer.WriteByte((uint8)ESegment::Message);
+			Writer.WriteVarint(BodySize);
+		}
+
+		Writer.WriteBytes(Message.GetData(), Message.Num());
+
+		return;
+	}
+
+	// large messages are split into fragments that fill a datagram each
+	const int32 FragmentSize = MaxDatagramSize - SGUdpMessageTransport::HeaderSize - SGUdpMessageTransport::FragmentOverhead;
+	const int32 NumFragments = FMath::DivideAndRoundUp(Message.Num(), FragmentSize);
+
+	for (int32 FragmentIndex = 0; FragmentIndex < NumFragments; ++FragmentIndex)
+	{
+		const int32 FragmentOffset = FragmentIndex * FragmentSize;
+		const TArrayView<const uint8> Fragment = Message.Slice(FragmentOffset, FMath::Min(FragmentSize, Message.Num() - FragmentOffset));
+
+		FPackedDatagram Datagram;
+		{
+			Datagram.Recipient = Endpoint;
+			Datagram.Data = AllocateDatagramBuffer();
+		}
+
+		BeginDatagram(Datagram.Data);
+
+		FSGWireWriter Writer(Datagram.Data);
+		Writer.WriteByte((uint8)(Sequence.IsSet() ? ESegment::ReliableFragment : ESegment::Fragment));
+		Writer.WriteSized([&Writer, &Fragment, &Sequence, MessageId, FragmentIndex, NumFragments]()
+		{
+			if (Sequence.IsSet())
+			{
+				Writer.WriteVarint(Sequence.GetValue());
+			}
+
+			Writer.WriteVarint(MessageId);
+			Writer.WriteVarint(FragmentIndex);
+			Writer.WriteVarint(NumFragments);
+			Writer.WriteBytes(Fragment.GetData(), Fragment.Num());
+		});
+
+		FinishDatagram(Datagram);
+	}
+}
+
+
+TArray<uint8>& FSGUdpMessageTransport::GetPackedDatagram(const FSGNetworkEndpoint& Endpoint, int32 SegmentSize)
+{
+	FPackedDatagram& Datagram = PackedDatagrams.FindOrAdd(Endpoint);
+
+	if (Datagram.Data.Num() + SegmentSize > MaxDatagramSize)
+	{
+		FinishDatagram(Datagram);
+	}
+
+	if (Datagram.Data.Num() == 0)
+	{
+		Datagram.Recipient = Endpoint;
+		Datagram.Data = AllocateDatagramBuffer();
+		BeginDatagram(Datagram.Data);
+	}
+
+	return Datagram.Data;
+}
+
+
+void FSGUdpMessageTransport::FinishDatagram(FPackedDatagram& Datagram)
+{
+	// moving the bytes leaves the datagram empty, so the next message starts a new one
+	FinishedDatagrams.Add(MoveTemp(Datagram));
+
+	if (FinishedDatagrams.Num() >= FSGUdpSocket::MaxBatchSize)
+	{
+		FlushDatagrams();
+	}
+}
+
+
+void FSGUdpMessageTransport::FlushDatagrams()
+{
+	if (FinishedDatagrams.Num() == 0)
+	{
+		return;
+	}
+
+	TArray<FSGUdpOutboundDatagram, TInlineAllocator<FSGUdpSocket::MaxBatchSize>> Batch;
+
+	for (const FPackedDatagram& Datagram : FinishedDatagrams)
+	{
+		Batch.Add({ Datagram.Recipient, Datagram.Data });
+	}
+
+	NumSentDatagrams.fetch_add(Socket.SendBatch(Batch), std::memory_order_relaxed);
+
+	for (FPackedDatagram& Datagram : FinishedDatagrams)
+	{
+		if (FreeDatagramBuffers.Num() < SGUdpMessageTransport::MaxFreeDatagramBuffers)
+		{
+			Datagram.Data.Reset();
+			FreeDatagramBuffers.Add(MoveTemp(Datagram.Data));
+		}
+	}
+
+	FinishedDatagrams.Reset();
+}
+
+
+void FSGUdpMessageTransport::BeginDatagram(TArray<uint8>& OutData) const
+{
+	const uint8 Version = (uint8)ESGUdpTransportVersion::Latest;
+	FSGWireWriter Writer(OutData);
+
+	Writer.WriteBytes(&DatagramMagic, sizeof(uint32));
+	Writer.WriteByte(Version);
+	Writer.WriteBytes(&NodeId, sizeof(FGuid));
+}
+
+
+TArray<uint8> FSGUdpMessageTransport::AllocateDatagramBuffer()
+{
+	if (FreeDatagramBuffers.Num() > 0)
+	{
+		return FreeDatagramBuffers.Pop(false);
+	}
+
+	TArray<uint8> Buffer;
+	Buffer.Reserve(MaxDatagramSize);
+
+	return Buffer;
+}
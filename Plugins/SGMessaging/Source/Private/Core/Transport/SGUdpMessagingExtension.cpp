@@ -0,0 +1,228 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGUdpMessagingExtension.h"
+#include "SocketSubsystem.h"
+#include "Core/Interface/ISGMessageBridge.h"
+#include "Core/Interface/ISGMessageBus.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "Core/Transport/SGUdpMessageTransport.h"
+
+
+/* FSGUdpMessagingExtension structors
+ *****************************************************************************/
+
+FSGUdpMessagingExtension::FSGUdpMessagingExtension(ISGMessagingModule& InMessagingModule)
+	: MessagingModule(InMessagingModule)
+	, bRunning(false)
+{
+	MessageBusStartupHandle = MessagingModule.OnMessageBusStartup().AddRaw(this, &FSGUdpMessagingExtension::HandleMessageBusStartup);
+	MessageBusShutdownHandle = MessagingModule.OnMessageBusShutdown().AddRaw(this, &FSGUdpMessagingExtension::HandleMessageBusShutdown);
+}
+
+
+FSGUdpMessagingExtension::~FSGUdpMessagingExtension()
+{
+	MessagingModule.OnMessageBusStartup().Remove(MessageBusStartupHandle);
+	MessagingModule.OnMessageBusShutdown().Remove(MessageBusShutdownHandle);
+
+	DestroyBridges();
+}
+
+
+/* ISGNetworkMessagingExtension interface
+ *****************************************************************************/
+
+FName FSGUdpMessagingExtension::GetName() const
+{
+	return TEXT("SGUdpMessaging");
+}
+
+
+bool FSGUdpMessagingExtension::IsSupportEnabled() const
+{
+	return ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM) != nullptr;
+}
+
+
+void FSGUdpMessagingExtension::RestartServices()
+{
+	DestroyBridges();
+
+	if (!IsSupportEnabled())
+	{
+		return;
+	}
+
+	bRunning = true;
+
+	for (const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus : MessagingModule.GetAllBuses())
+	{
+		BridgeBus(Bus);
+	}
+}
+
+
+void FSGUdpMessagingExtension::ShutdownServices()
+{
+	DestroyBridges();
+
+	bRunning = false;
+	AddedEndpoints.Empty();
+	RemovedEndpoints.Empty();
+}
+
+
+void FSGUdpMessagingExtension::AddEndpoint(const FString& InEndpoint)
+{
+	FSGNetworkEndpoint Endpoint;
+
+	if (!FSGNetworkEndpoint::Parse(InEndpoint, Endpoint))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't add UDP endpoint '%s', it isn't in the form <ipv4:port>"), *InEndpoint);
+
+		return;
+	}
+
+	RemovedEndpoints.Remove(Endpoint);
+	AddedEndpoints.AddUnique(Endpoint);
+
+	for (const auto& BridgedBusPair : BridgedBuses)
+	{
+		BridgedBusPair.Value.Transport->AddStaticEndpoint(Endpoint);
+	}
+}
+
+
+void FSGUdpMessagingExtension::RemoveEndpoint(const FString& InEndpoint)
+{
+	FSGNetworkEndpoint Endpoint;
+
+	if (!FSGNetworkEndpoint::Parse(InEndpoint, Endpoint))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't remove UDP endpoint '%s', it isn't in the form <ipv4:port>"), *InEndpoint);
+
+		return;
+	}
+
+	AddedEndpoints.Remove(Endpoint);
+	RemovedEndpoints.AddUnique(Endpoint);
+
+	for (const auto& BridgedBusPair : BridgedBuses)
+	{
+		BridgedBusPair.Value.Transport->RemoveStaticEndpoint(Endpoint);
+	}
+}
+
+
+/* FSGUdpMessagingExtension implementation
+ *****************************************************************************/
+
+void FSGUdpMessagingExtension::BridgeBus(const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus)
+{
+	const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+	const FString* UnicastEndpointString = (SGMessagingSettings != nullptr) ? SGMessagingSettings->UdpTransportBuses.Find(Bus->GetName()) : nullptr;
+
+	if ((UnicastEndpointString == nullptr) || BridgedBuses.Contains(Bus->GetName()))
+	{
+		return;
+	}
+
+	FSGNetworkEndpoint UnicastEndpoint;
+
+	if (!FSGNetworkEndpoint::Parse(*UnicastEndpointString, UnicastEndpoint))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't bridge message bus %s, its UDP endpoint '%s' isn't in the form <ipv4:port>"), *Bus->GetName(), **UnicastEndpointString);
+
+		return;
+	}
+
+	FBridgedBus BridgedBus;
+	{
+		BridgedBus.Transport = MakeShared<FSGUdpMessageTransport, ESPMode::ThreadSafe>(UnicastEndpoint, GetStaticEndpoints(), SGMessagingSettings->UdpMaxDatagramSize);
+		BridgedBus.Bridge = MessagingModule.CreateBridge(FSGMessageAddress::NewAddress(), Bus, BridgedBus.Transport.ToSharedRef());
+	}
+
+	if (!BridgedBus.Bridge.IsValid())
+	{
+		return;
+	}
+
+	BridgedBus.Bridge->Enable();
+
+	// the transport didn't start, e.g. because the port is in use
+	if (!BridgedBus.Bridge->IsEnabled())
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't bridge message bus %s, its UDP transport can't be started on %s"), *Bus->GetName(), *UnicastEndpoint.ToString());
+
+		return;
+	}
+
+	BridgedBuses.Add(Bus->GetName(), MoveTemp(BridgedBus));
+}
+
+
+void FSGUdpMessagingExtension::DestroyBridges()
+{
+	for (auto& BridgedBusPair : BridgedBuses)
+	{
+		BridgedBusPair.Value.Bridge->Disable();
+	}
+
+	BridgedBuses.Empty();
+}
+
+
+TArray<FSGNetworkEndpoint> FSGUdpMessagingExtension::GetStaticEndpoints() const
+{
+	TArray<FSGNetworkEndpoint> Endpoints;
+
+	if (const auto SGMessagingSettings = GetDefault<USGMessagingSettings>())
+	{
+		for (const FString& EndpointString : SGMessagingSettings->UdpStaticEndpoints)
+		{
+			FSGNetworkEndpoint Endpoint;
+
+			if (!FSGNetworkEndpoint::Parse(EndpointString, Endpoint))
+			{
+				UE_LOG(LogSGMessaging, Warning, TEXT("Ignoring UDP static endpoint '%s', it isn't in the form <ipv4:port>"), *EndpointString);
+			}
+			else if (!RemovedEndpoints.Contains(Endpoint))
+			{
+				Endpoints.AddUnique(Endpoint);
+			}
+		}
+	}
+
+	for (const FSGNetworkEndpoint& Endpoint : AddedEndpoints)
+	{
+		Endpoints.AddUnique(Endpoint);
+	}
+
+	return Endpoints;
+}
+
+
+/* FSGUdpMessagingExtension callbacks
+ *****************************************************************************/
+
+void FSGUdpMessagingExtension::HandleMessageBusStartup(TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> WeakBus)
+{
+	TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = WeakBus.Pin();
+
+	if (bRunning && Bus.IsValid())
+	{
+		BridgeBus(Bus.ToSharedRef());
+	}
+}
+
+
+void FSGUdpMessagingExtension::HandleMessageBusShutdown(TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> WeakBus)
+{
+	// the bridge disables itself when its bus shuts down
+	if (TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = WeakBus.Pin())
+	{
+		BridgedBuses.Remove(Bus->GetName());
+	}
+}
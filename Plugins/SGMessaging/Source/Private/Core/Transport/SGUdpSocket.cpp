@@ -0,0 +1,311 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#include "Core/Transport/SGUdpSocket.h"
+#include "IPAddress.h"
+#include "Sockets.h"
+#include "SocketSubsystem.h"
+#include "Core/Interface/ISGMessagingModule.h"
+
+#if PLATFORM_LINUX
+THIRD_PARTY_INCLUDES_START
+	#include <errno.h>
+	#include <netinet/in.h>
+	#include <poll.h>
+	#include <sys/socket.h>
+	#include <unistd.h>
+THIRD_PARTY_INCLUDES_END
+#endif
+
+// sendmmsg and recvmmsg are GNU extensions
+#if PLATFORM_LINUX && defined(__USE_GNU)
+	#define SGUDPSOCKET_BATCHED_SYSCALLS 1
+#else
+	#define SGUDPSOCKET_BATCHED_SYSCALLS 0
+#endif
+
+
+/* FSGUdpSocket structors
+ *****************************************************************************/
+
+FSGUdpSocket::FSGUdpSocket()
+	: NativeSocket(-1)
+	, Socket(nullptr)
+{ }
+
+
+FSGUdpSocket::~FSGUdpSocket()
+{
+	Close();
+}
+
+
+/* FSGUdpSocket interface
+ *****************************************************************************/
+
+bool FSGUdpSocket::Open(const FSGNetworkEndpoint& Endpoint, int32 BufferSize)
+{
+	Close();
+
+#if SGUDPSOCKET_BATCHED_SYSCALLS
+	NativeSocket = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+	if (NativeSocket < 0)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't create UDP socket for %s (errno %d)"), *Endpoint.ToString(), errno);
+
+		return false;
+	}
+
+	const int ReuseAddress = 1;
+
+	setsockopt(NativeSocket, SOL_SOCKET, SO_REUSEADDR, &ReuseAddress, sizeof(ReuseAddress));
+	setsockopt(NativeSocket, SOL_SOCKET, SO_RCVBUF, &BufferSize, sizeof(BufferSize));
+	setsockopt(NativeSocket, SOL_SOCKET, SO_SNDBUF, &BufferSize, sizeof(BufferSize));
+
+	sockaddr_in BindAddress = {};
+	{
+		BindAddress.sin_family = AF_INET;
+		BindAddress.sin_addr.s_addr = htonl(Endpoint.Address);
+		BindAddress.sin_port = htons(Endpoint.Port);
+	}
+
+	if (bind(NativeSocket, (const sockaddr*)&BindAddress, sizeof(BindAddress)) != 0)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't bind UDP socket to %s (errno %d)"), *Endpoint.ToString(), errno);
+
+		Close();
+
+		return false;
+	}
+#else
+	ISocketSubsystem* SocketSubsystem = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM);
+
+	if (SocketSubsystem == nullptr)
+	{
+		return false;
+	}
+
+	Socket = SocketSubsystem->CreateSocket(NAME_DGram, TEXT("FSGUdpSocket"), FNetworkProtocolTypes::IPv4);
+
+	if (Socket == nullptr)
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't create UDP socket for %s"), *Endpoint.ToString());
+
+		return false;
+	}
+
+	TSharedRef<FInternetAddr> BindAddress = SocketSubsystem->CreateInternetAddr();
+	{
+		BindAddress->SetIp(Endpoint.Address);
+		BindAddress->SetPort(Endpoint.Port);
+	}
+
+	int32 ActualBufferSize = 0;
+
+	Socket->SetNonBlocking(true);
+	Socket->SetReuseAddr(true);
+	Socket->SetReceiveBufferSize(BufferSize, ActualBufferSize);
+	Socket->SetSendBufferSize(BufferSize, ActualBufferSize);
+
+	if (!Socket->Bind(*BindAddress))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("Can't bind UDP socket to %s"), *Endpoint.ToString());
+
+		Close();
+
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+
+void FSGUdpSocket::Close()
+{
+#if SGUDPSOCKET_BATCHED_SYSCALLS
+	if (NativeSocket >= 0)
+	{
+		close(NativeSocket);
+		NativeSocket = -1;
+	}
+#else
+	if (Socket != nullptr)
+	{
+		Socket->Close();
+		ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->DestroySocket(Socket);
+		Socket = nullptr;
+	}
+#endif
+}
+
+
+bool FSGUdpSocket::IsOpen() const
+{
+	return (NativeSocket >= 0) || (Socket != nullptr);
+}
+
+
+int32 FSGUdpSocket::SendBatch(TArrayView<const FSGUdpOutboundDatagram> Datagrams)
+{
+	int32 NumSent = 0;
+
+#if SGUDPSOCKET_BATCHED_SYSCALLS
+	if (NativeSocket < 0)
+	{
+		return 0;
+	}
+
+	mmsghdr Messages[MaxBatchSize];
+	iovec Buffers[MaxBatchSize];
+	sockaddr_in Addresses[MaxBatchSize];
+
+	for (int32 BatchStart = 0; BatchStart < Datagrams.Num(); BatchStart += MaxBatchSize)
+	{
+		const int32 BatchSize = FMath::Min(Datagrams.Num() - BatchStart, MaxBatchSize);
+
+		for (int32 Index = 0; Index < BatchSize; ++Index)
+		{
+			const FSGUdpOutboundDatagram& Datagram = Datagrams[BatchStart + Index];
+
+			Addresses[Index] = {};
+			Addresses[Index].sin_family = AF_INET;
+			Addresses[Index].sin_addr.s_addr = htonl(Datagram.Recipient.Address);
+			Addresses[Index].sin_port = htons(Datagram.Recipient.Port);
+
+			Buffers[Index].iov_base = const_cast<uint8*>(Datagram.Data.GetData());
+			Buffers[Index].iov_len = Datagram.Data.Num();
+
+			Messages[Index] = {};
+			Messages[Index].msg_hdr.msg_name = &Addresses[Index];
+			Messages[Index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			Messages[Index].msg_hdr.msg_iov = &Buffers[Index];
+			Messages[Index].msg_hdr.msg_iovlen = 1;
+		}
+
+		for (int32 Offset = 0; Offset < BatchSize; )
+		{
+			const int Result = sendmmsg(NativeSocket, Messages + Offset, BatchSize - Offset, 0);
+
+			if (Result > 0)
+			{
+				Offset += Result;
+				NumSent += Result;
+			}
+			else if ((Result < 0) && (errno == EINTR))
+			{
+				continue;
+			}
+			else
+			{
+				// the first datagram wasn't accepted (full buffer or unreachable recipient), drop it
+				++Offset;
+			}
+		}
+	}
+#else
+	if (Socket == nullptr)
+	{
+		return 0;
+	}
+
+	TSharedRef<FInternetAddr> Address = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+	for (const FSGUdpOutboundDatagram& Datagram : Datagrams)
+	{
+		int32 BytesSent = 0;
+
+		Address->SetIp(Datagram.Recipient.Address);
+		Address->SetPort(Datagram.Recipient.Port);
+
+		if (Socket->SendTo(Datagram.Data.GetData(), Datagram.Data.Num(), BytesSent, *Address))
+		{
+			++NumSent;
+		}
+	}
+#endif
+
+	return NumSent;
+}
+
+
+int32 FSGUdpSocket::ReceiveBatch(TArrayView<FSGUdpInboundDatagram> Datagrams, const FTimespan& WaitTime)
+{
+	const int32 BatchSize = FMath::Min(Datagrams.Num(), MaxBatchSize);
+	int32 NumReceived = 0;
+
+#if SGUDPSOCKET_BATCHED_SYSCALLS
+	if (NativeSocket < 0)
+	{
+		return 0;
+	}
+
+	pollfd PollFd = {};
+	{
+		PollFd.fd = NativeSocket;
+		PollFd.events = POLLIN;
+	}
+
+	if (poll(&PollFd, 1, (int)WaitTime.GetTotalMilliseconds()) <= 0)
+	{
+		return 0;
+	}
+
+	mmsghdr Messages[MaxBatchSize];
+	iovec Buffers[MaxBatchSize];
+	sockaddr_in Addresses[MaxBatchSize];
+
+	for (int32 Index = 0; Index < BatchSize; ++Index)
+	{
+		Buffers[Index].iov_base = Datagrams[Index].Data.GetData();
+		Buffers[Index].iov_len = Datagrams[Index].Data.Num();
+
+		Messages[Index] = {};
+		Messages[Index].msg_hdr.msg_name = &Addresses[Index];
+		Messages[Index].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		Messages[Index].msg_hdr.msg_iov = &Buffers[Index];
+		Messages[Index].msg_hdr.msg_iovlen = 1;
+	}
+
+	const int Result = recvmmsg(NativeSocket, Messages, BatchSize, MSG_DONTWAIT, nullptr);
+
+	for (int32 Index = 0; Index < Result; ++Index)
+	{
+		FSGUdpInboundDatagram& Datagram = Datagrams[Index];
+
+		// truncated datagrams can't be decoded
+		Datagram.Size = ((Messages[Index].msg_hdr.msg_flags & MSG_TRUNC) != 0) ? 0 : (int32)Messages[Index].msg_len;
+		Datagram.Sender = FSGNetworkEndpoint(ntohl(Addresses[Index].sin_addr.s_addr), ntohs(Addresses[Index].sin_port));
+	}
+
+	NumReceived = FMath::Max(Result, 0);
+#else
+	if ((Socket == nullptr) || !Socket->Wait(ESocketWaitConditions::WaitForRead, WaitTime))
+	{
+		return 0;
+	}
+
+	TSharedRef<FInternetAddr> Address = ISocketSubsystem::Get(PLATFORM_SOCKETSUBSYSTEM)->CreateInternetAddr();
+
+	while (NumReceived < BatchSize)
+	{
+		FSGUdpInboundDatagram& Datagram = Datagrams[NumReceived];
+		int32 BytesRead = 0;
+
+		if (!Socket->RecvFrom(Datagram.Data.GetData(), Datagram.Data.Num(), BytesRead, *Address))
+		{
+			break;
+		}
+
+		uint32 SenderAddress = 0;
+		Address->GetIp(SenderAddress);
+
+		Datagram.Size = BytesRead;
+		Datagram.Sender = FSGNetworkEndpoint(SenderAddress, (uint16)Address->GetPort());
+
+		++NumReceived;
+	}
+#endif
+
+	return NumReceived;
+}
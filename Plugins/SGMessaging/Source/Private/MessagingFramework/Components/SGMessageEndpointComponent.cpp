@@ -3,7 +3,9 @@
 
 #include "MessagingFramework/Components/SGMessageEndpointComponent.h"
 #include "Blueprint/Common/SGBlueprintMessageEndpointBuilder.h"
+#include "Core/Interface/ISGMessagingModule.h"
 #include "MessagingFramework/Kismet/SGMessageFunctionLibrary.h"
+#include "MessagingFramework/Subsystems/SGMessageWorldSubsystem.h"
 
 // Sets default values for this component's properties
 USGMessageEndpointComponent::USGMessageEndpointComponent()
@@ -19,8 +21,57 @@ void USGMessageEndpointComponent::BeginPlay()
 {
 	Super::BeginPlay();
 
-	MessageEndpoint = USGBlueprintMessageEndpoint::Builder(this, GetFName(),
-	                                                       *USGMessageFunctionLibrary::GetDefaultBus(this));
+	USGMessageWorldSubsystem* MessageWorldSubsystem = (EndpointSharing != ESGMessageEndpointSharing::None)
+		                                                  ? GetWorld()->GetSubsystem<USGMessageWorldSubsystem>()
+		                                                  : nullptr;
+
+	if (MessageWorldSubsystem != nullptr)
+	{
+		MessageEndpoint = MessageWorldSubsystem->GetSharedMessageEndpoint(
+			(EndpointSharing == ESGMessageEndpointSharing::Class) ? GetOwner()->GetClass() : nullptr);
+		bSharesEndpoint = true;
+	}
+	else
+	{
+		auto EndpointBuilder = USGBlueprintMessageEndpoint::Builder(this, GetFName(),
+		                                                            *USGMessageFunctionLibrary::GetDefaultBus(this));
+
+		if (bActivateEndpointOnFirstUse)
+		{
+			EndpointBuilder.ThatActivatesOnFirstUse();
+		}
+
+		MessageEndpoint = EndpointBuilder;
+	}
+}
+
+
+// Called when the game ends or the component is destroyed
+void USGMessageEndpointComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (bHasSpatialInterests)
+	{
+		if (USGMessageWorldSubsystem* MessageWorldSubsystem = GetWorld()->GetSubsystem<USGMessageWorldSubsystem>())
+		{
+			MessageWorldSubsystem->UnregisterSpatialInterests(this);
+		}
+
+		bHasSpatialInterests = false;
+	}
+
+	if (bSharesEndpoint)
+	{
+		// the shared endpoint outlives the component
+		if (MessageEndpoint != nullptr)
+		{
+			MessageEndpoint->RemoveSubscriber(this);
+		}
+
+		MessageEndpoint = nullptr;
+		bSharesEndpoint = false;
+	}
+
+	Super::EndPlay(EndPlayReason);
 }
 
 
@@ -36,12 +87,47 @@ void USGMessageEndpointComponent::TickComponent(float DeltaTime, ELevelTick Tick
 void USGMessageEndpointComponent::Subscribe(const int32 InTopicID, const int32 InMessageID,
                                             const FSGBlueprintMessageDelegate& InDelegate)
 {
-	if (MessageEndpoint != nullptr)
+	if (MessageEndpoint == nullptr)
+	{
+		return;
+	}
+
+	if (bSharesEndpoint)
+	{
+		MessageEndpoint->Subscribe(this, InTopicID, InMessageID, InDelegate);
+	}
+	else
 	{
 		MessageEndpoint->Subscribe(InTopicID, InMessageID, InDelegate);
 	}
 }
 
+void USGMessageEndpointComponent::SubscribeNearby(const int32 InTopicID, const int32 InMessageID,
+                                                  const FSGBlueprintMessageDelegate& InDelegate, float Radius)
+{
+	if (MessageEndpoint == nullptr)
+	{
+		return;
+	}
+
+	USGMessageWorldSubsystem* MessageWorldSubsystem = GetWorld()->GetSubsystem<USGMessageWorldSubsystem>();
+
+	// the shared endpoint has no location of its own
+	if (bSharesEndpoint || (MessageWorldSubsystem == nullptr))
+	{
+		UE_LOG(LogSGMessaging, Warning, TEXT("%s can't subscribe nearby without an endpoint of its own, subscribing to all messages"),
+		       *GetPathName());
+
+		Subscribe(InTopicID, InMessageID, InDelegate);
+
+		return;
+	}
+
+	MessageEndpoint->SubscribeSpatial(InTopicID, InMessageID, InDelegate);
+	MessageWorldSubsystem->RegisterSpatialInterest(this, FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Radius);
+	bHasSpatialInterests = true;
+}
+
 void USGMessageEndpointComponent::Publish(const int32 InTopicID, const int32 InMessageID,
                                           const FSGBlueprintPublishParameter InParameter,
                                           const FSGBlueprintMessage InMessage)
@@ -52,6 +138,19 @@ void USGMessageEndpointComponent::Publish(const int32 InTopicID, const int32 InM
 	}
 }
 
+void USGMessageEndpointComponent::PublishAt(const int32 InTopicID, const int32 InMessageID,
+                                            const FSGBlueprintPublishParameter InParameter,
+                                            const FSGBlueprintMessage InMessage, const FVector Origin)
+{
+	if (MessageEndpoint != nullptr)
+	{
+		FSGBlueprintPublishParameter Parameter = InParameter;
+		Parameter.Annotations.Add(SGMessageSpatial::OriginAnnotation, SGMessageSpatial::FormatOrigin(Origin));
+
+		MessageEndpoint->Publish(InTopicID, InMessageID, Parameter, InMessage);
+	}
+}
+
 void USGMessageEndpointComponent::Send(const int32 InTopicID, const int32 InMessageID,
                                        const TArray<FSGBlueprintMessageAddress>& InRecipients,
                                        const FSGBlueprintSendParameter InParameter,
@@ -73,11 +172,28 @@ void USGMessageEndpointComponent::Forward(const FSGBlueprintMessageContext& InCo
 	}
 }
 
+void USGMessageEndpointComponent::SetEndpointEnabled(bool bEnabled)
+{
+	if ((MessageEndpoint == nullptr) || bSharesEndpoint)
+	{
+		return;
+	}
+
+	if (bEnabled)
+	{
+		MessageEndpoint->Enable();
+	}
+	else
+	{
+		MessageEndpoint->Disable();
+	}
+}
+
 FSGBlueprintMessageAddress USGMessageEndpointComponent::GetAddress() const
 {
 	if (MessageEndpoint != nullptr)
 	{
-		return MessageEndpoint->GetAddress();
+		return bSharesEndpoint ? MessageEndpoint->GetSubscriberAddress(this) : MessageEndpoint->GetAddress();
 	}
 
 	return FSGBlueprintMessageAddress();
@@ -6,56 +6,249 @@
 #include "MessagingFramework/Subsystems/SGMessageWorldSubsystem.h"
 #include "Subsystems/SubsystemBlueprintLibrary.h"
 
-#define COMPLETE_SET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType ) \
-	if(const auto PropertyName = CastField<PropertyType>(InProperty)) \
-	{ \
-		ValueType Value; \
-		PropertyName->CopySingleValue(&Value,PropertyAddress); \
-		Message.Message->Set(UKismetStringLibrary::Conv_NameToString(Key),Value); \
-	}
+namespace SGMessageFunctionLibrary
+{
+	/** Function that copies a Blueprint value into a message parameter. */
+	using FSetFunction = void (*)(FSGMessage& Message, FName Key, const FProperty* Property, const void* PropertyAddress);
 
-#define ELSE_COMPLETE_SET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType ) \
-	else COMPLETE_SET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType )
+	/** Function that copies a message parameter into a Blueprint value. */
+	using FGetFunction = void (*)(const FSGMessage& Message, FName Key, const FProperty* Property, void* PropertyAddress);
 
-#define SET_MESSAGE_FIELD( PropertyName, ValueType ) \
-	COMPLETE_SET_MESSAGE_FIELD( PropertyName, F##PropertyName, ValueType )
+	/** Structure for the accessors of a property class. */
+	struct FPropertyAccessor
+	{
+		FSetFunction Set;
 
-#define ELSE_SET_MESSAGE_FIELD( PropertyName, ValueType ) \
-	else SET_MESSAGE_FIELD( PropertyName, ValueType )
+		FGetFunction Get;
+	};
 
-#define CUSTOMIZE_SET_MESSAGE_FIELD( PropertyName ) \
-	if (const auto PropertyName = CastField<F##PropertyName>(InProperty)) \
-	{ \
-		Message.Message->Set(UKismetStringLibrary::Conv_NameToString(Key), PropertyName, PropertyAddress); \
+	template <typename PropertyType, typename ValueType>
+	void SetValue(FSGMessage& Message, FName Key, const FProperty* Property, const void* PropertyAddress)
+	{
+		ValueType Value;
+		static_cast<const PropertyType*>(Property)->CopySingleValue(&Value, PropertyAddress);
+		Message.Set(Key, Value);
 	}
 
-#define ELSE_CUSTOMIZE_SET_MESSAGE_FIELD( PropertyName ) \
-	else CUSTOMIZE_SET_MESSAGE_FIELD( PropertyName )
-
-#define COMPLETE_GET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType ) \
-	if(const auto PropertyName = CastField<PropertyType>(InProperty)) \
-	{ \
-		const auto Value = Message.Message->Get<ValueType>(UKismetStringLibrary::Conv_NameToString(Key)); \
-		PropertyName->CopySingleValue(PropertyAddress,&Value); \
+	template <typename PropertyType, typename ValueType>
+	void GetValue(const FSGMessage& Message, FName Key, const FProperty* Property, void* PropertyAddress)
+	{
+		const auto Value = Message.Get<ValueType>(Key);
+		static_cast<const PropertyType*>(Property)->CopySingleValue(PropertyAddress, &Value);
 	}
 
-#define ELSE_COMPLETE_GET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType ) \
-	else COMPLETE_GET_MESSAGE_FIELD( PropertyName, PropertyType, ValueType )
+	template <typename PropertyType>
+	void SetCustom(FSGMessage& Message, FName Key, const FProperty* Property, const void* PropertyAddress)
+	{
+		Message.Set(Key, static_cast<const PropertyType*>(Property), PropertyAddress);
+	}
 
-#define GET_MESSAGE_FIELD( PropertyName, ValueType ) \
-	COMPLETE_GET_MESSAGE_FIELD( PropertyName, F##PropertyName, ValueType )
+	template <typename PropertyType>
+	void GetCustom(const FSGMessage& Message, FName Key, const FProperty* Property, void* PropertyAddress)
+	{
+		Message.Get(Key, static_cast<const PropertyType*>(Property), PropertyAddress);
+	}
 
-#define ELSE_GET_MESSAGE_FIELD( PropertyName, ValueType ) \
-	else GET_MESSAGE_FIELD( PropertyName, ValueType )
+	template <typename PropertyType, typename ValueType>
+	FPropertyAccessor MakeValueAccessor()
+	{
+		return {&SetValue<PropertyType, ValueType>, &GetValue<PropertyType, ValueType>};
+	}
 
-#define CUSTOMIZE_GET_MESSAGE_FIELD( PropertyName ) \
-	if (const auto PropertyName = CastField<F##PropertyName>(InProperty)) \
-	{ \
-		Message.Message->Get(UKismetStringLibrary::Conv_NameToString(Key), PropertyName, PropertyAddress); \
+	template <typename PropertyType>
+	FPropertyAccessor MakeCustomAccessor()
+	{
+		return {&SetCustom<PropertyType>, &GetCustom<PropertyType>};
 	}
 
-#define ELSE_CUSTOMIZE_GET_MESSAGE_FIELD( PropertyName ) \
-	else CUSTOMIZE_GET_MESSAGE_FIELD( PropertyName )
+	/**
+	 * Implements the table of accessors per property class.
+	 *
+	 * Lookups are by exact property class. Classes derived from a supported class (e.g. object pointer
+	 * properties) share the accessor of their nearest supported base class; they are resolved when the
+	 * table is built, so that the table never changes afterwards and needs no locking.
+	 */
+	class FPropertyAccessorTable
+	{
+	public:
+		FPropertyAccessorTable()
+		{
+			Add<FByteProperty>(MakeValueAccessor<FByteProperty, uint8>());
+			Add<FInt8Property>(MakeValueAccessor<FInt8Property, int8>());
+			Add<FInt16Property>(MakeValueAccessor<FInt16Property, int16>());
+			Add<FIntProperty>(MakeValueAccessor<FIntProperty, int32>());
+			Add<FInt64Property>(MakeValueAccessor<FInt64Property, int64>());
+			Add<FUInt16Property>(MakeValueAccessor<FUInt16Property, uint16>());
+			Add<FUInt32Property>(MakeValueAccessor<FUInt32Property, uint32>());
+			Add<FUInt64Property>(MakeValueAccessor<FUInt64Property, uint64>());
+			Add<FFloatProperty>(MakeValueAccessor<FFloatProperty, float>());
+			Add<FDoubleProperty>(MakeValueAccessor<FDoubleProperty, double>());
+			Add<FEnumProperty>({&SetCustom<FEnumProperty>, &GetValue<FEnumProperty, int64>});
+			Add<FBoolProperty>(MakeValueAccessor<FBoolProperty, bool>());
+			Add<FClassProperty>(MakeValueAccessor<FClassProperty, UClass*>());
+			Add<FObjectProperty>(MakeValueAccessor<FObjectProperty, UObject*>());
+			Add<FSoftClassProperty>(MakeValueAccessor<FSoftClassProperty, TSoftClassPtr<UObject>>());
+			Add<FSoftObjectProperty>(MakeValueAccessor<FSoftObjectProperty, TSoftObjectPtr<UObject>>());
+			Add<FInterfaceProperty>(MakeValueAccessor<FInterfaceProperty, TScriptInterface<IInterface>>());
+			Add<FNameProperty>(MakeValueAccessor<FNameProperty, FName>());
+			Add<FStrProperty>(MakeValueAccessor<FStrProperty, FString>());
+			Add<FTextProperty>(MakeValueAccessor<FTextProperty, FText>());
+			Add<FArrayProperty>(MakeCustomAccessor<FArrayProperty>());
+			Add<FMapProperty>(MakeCustomAccessor<FMapProperty>());
+			Add<FSetProperty>(MakeCustomAccessor<FSetProperty>());
+			Add<FStructProperty>(MakeCustomAccessor<FStructProperty>());
+			Add<FMulticastInlineDelegateProperty>({&SetCustom<FMulticastInlineDelegateProperty>, &GetValue<FMulticastInlineDelegateProperty, FMulticastScriptDelegate*>});
+			Add<FMulticastSparseDelegateProperty>({&SetCustom<FMulticastSparseDelegateProperty>, &GetValue<FMulticastSparseDelegateProperty, FSparseDelegate*>});
+
+			for (FFieldClass* FieldClass : FFieldClass::GetAllFieldClasses())
+			{
+				if (!Accessors.Contains(FieldClass))
+				{
+					if (const FPropertyAccessor* Accessor = FindInSuperClasses(FieldClass))
+					{
+						Accessors.Add(FieldClass, *Accessor);
+					}
+				}
+			}
+		}
+
+		/** Gets the table, which is built on first use. */
+		static const FPropertyAccessorTable& Get()
+		{
+			static const FPropertyAccessorTable Table;
+
+			return Table;
+		}
+
+		/**
+		 * Finds the accessor for a property.
+		 *
+		 * @param Property The property.
+		 * @return The accessor, or nullptr if the property's class isn't supported.
+		 */
+		const FPropertyAccessor* Find(const FProperty* Property) const
+		{
+			FFieldClass* PropertyClass = Property->GetClass();
+
+			if (const FPropertyAccessor* Accessor = Accessors.Find(PropertyClass))
+			{
+				return Accessor;
+			}
+
+			// property classes that were registered after the table was built
+			return FindInSuperClasses(PropertyClass);
+		}
+
+	private:
+		template <typename PropertyType>
+		void Add(const FPropertyAccessor& Accessor)
+		{
+			Accessors.Add(PropertyType::StaticClass(), Accessor);
+		}
+
+		const FPropertyAccessor* FindInSuperClasses(const FFieldClass* FieldClass) const
+		{
+			for (FFieldClass* SuperClass = FieldClass->GetSuperClass(); SuperClass != nullptr; SuperClass = SuperClass->GetSuperClass())
+			{
+				if (const FPropertyAccessor* Accessor = Accessors.Find(SuperClass))
+				{
+					return Accessor;
+				}
+			}
+
+			return nullptr;
+		}
+
+	private:
+		/** Maps property classes to their accessor. */
+		TMap<FFieldClass*, FPropertyAccessor> Accessors;
+	};
+
+	/** Structure for a property in the layout of a structure. */
+	struct FStructField
+	{
+		/** The message parameter key (the property's authored name). */
+		FName Key;
+
+		const FProperty* Property;
+
+		/** The offset of the property's value inside the structure. */
+		int32 Offset;
+
+		const FPropertyAccessor* Accessor;
+	};
+
+	/** Structure for the precomputed layout of a structure. */
+	struct FStructLayout
+	{
+		/** The structure's first property when the layout was built, which changes when a Blueprint structure is recompiled. */
+		const FField* FirstProperty = nullptr;
+
+		/** The properties that can be copied to and from messages. */
+		TArray<FStructField> Fields;
+	};
+
+	/**
+	 * Implements the cache of structure layouts for bulk copies.
+	 */
+	class FStructLayoutCache
+	{
+	public:
+		static FStructLayoutCache& Get()
+		{
+			static FStructLayoutCache Cache;
+
+			return Cache;
+		}
+
+		/**
+		 * Gets the layout of a structure, building it on first use.
+		 *
+		 * @param Struct The structure.
+		 * @return The layout.
+		 */
+		TSharedRef<const FStructLayout, ESPMode::ThreadSafe> Find(const UScriptStruct* Struct)
+		{
+			{
+				FReadScopeLock ReadLock(Lock);
+
+				if (const auto* Layout = Layouts.Find(Struct))
+				{
+					if ((*Layout)->FirstProperty == Struct->ChildProperties)
+					{
+						return *Layout;
+					}
+				}
+			}
+
+			const TSharedRef<FStructLayout, ESPMode::ThreadSafe> Layout = MakeShared<FStructLayout, ESPMode::ThreadSafe>();
+			const FPropertyAccessorTable& AccessorTable = FPropertyAccessorTable::Get();
+
+			Layout->FirstProperty = Struct->ChildProperties;
+
+			for (TFieldIterator<FProperty> It(Struct); It; ++It)
+			{
+				if (const FPropertyAccessor* Accessor = AccessorTable.Find(*It))
+				{
+					Layout->Fields.Add({FName(*It->GetAuthoredName()), *It, It->GetOffset_ForInternal(), Accessor});
+				}
+			}
+
+			FWriteScopeLock WriteLock(Lock);
+
+			Layouts.Add(Struct, Layout);
+
+			return Layout;
+		}
+
+	private:
+		/** Holds the layouts by structure. */
+		TMap<const UScriptStruct*, TSharedRef<const FStructLayout, ESPMode::ThreadSafe>> Layouts;
+
+		/** Guards the layouts, which may be requested from Blueprints running outside the game thread. */
+		FRWLock Lock;
+	};
+}
 
 USGBlueprintMessageBus* USGMessageFunctionLibrary::GetDefaultBus(UObject* WorldContextObject)
 {
@@ -94,32 +287,10 @@ FSGBlueprintMessage USGMessageFunctionLibrary::ExecSet(const FSGBlueprintMessage
 {
 	if (Message.Message != nullptr && InProperty != nullptr)
 	{
-		SET_MESSAGE_FIELD(ByteProperty, uint8)
-		ELSE_SET_MESSAGE_FIELD(Int8Property, int8)
-		ELSE_SET_MESSAGE_FIELD(Int16Property, int16)
-		ELSE_SET_MESSAGE_FIELD(IntProperty, int32)
-		ELSE_SET_MESSAGE_FIELD(Int64Property, int64)
-		ELSE_COMPLETE_SET_MESSAGE_FIELD(UInt16PropertyPointer, FUInt16Property, uint16)
-		ELSE_SET_MESSAGE_FIELD(UInt32Property, uint32)
-		ELSE_COMPLETE_SET_MESSAGE_FIELD(UInt64PropertyPointer, FUInt64Property, uint64)
-		ELSE_SET_MESSAGE_FIELD(FloatProperty, float)
-		ELSE_SET_MESSAGE_FIELD(DoubleProperty, double)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(EnumProperty)
-		ELSE_SET_MESSAGE_FIELD(BoolProperty, bool)
-		ELSE_SET_MESSAGE_FIELD(ClassProperty, UClass*)
-		ELSE_SET_MESSAGE_FIELD(ObjectProperty, UObject*)
-		ELSE_SET_MESSAGE_FIELD(SoftClassProperty, TSoftClassPtr<UObject>)
-		ELSE_SET_MESSAGE_FIELD(SoftObjectProperty, TSoftObjectPtr<UObject>)
-		ELSE_SET_MESSAGE_FIELD(InterfaceProperty, TScriptInterface<IInterface>)
-		ELSE_SET_MESSAGE_FIELD(NameProperty, FName)
-		ELSE_SET_MESSAGE_FIELD(StrProperty, FString)
-		ELSE_SET_MESSAGE_FIELD(TextProperty, FText)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(ArrayProperty)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(MapProperty)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(SetProperty)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(StructProperty)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(MulticastInlineDelegateProperty)
-		ELSE_CUSTOMIZE_SET_MESSAGE_FIELD(MulticastSparseDelegateProperty)
+		if (const auto Accessor = SGMessageFunctionLibrary::FPropertyAccessorTable::Get().Find(InProperty))
+		{
+			Accessor->Set(*Message.Message, Key, InProperty, PropertyAddress);
+		}
 	}
 
 	return Message;
@@ -131,33 +302,82 @@ FSGBlueprintMessage USGMessageFunctionLibrary::ExecGet(const FSGBlueprintMessage
 {
 	if (Message.Message != nullptr && InProperty != nullptr)
 	{
-		GET_MESSAGE_FIELD(ByteProperty, uint8)
-		ELSE_GET_MESSAGE_FIELD(Int8Property, int8)
-		ELSE_GET_MESSAGE_FIELD(Int16Property, int16)
-		ELSE_GET_MESSAGE_FIELD(IntProperty, int32)
-		ELSE_GET_MESSAGE_FIELD(Int64Property, int64)
-		ELSE_COMPLETE_GET_MESSAGE_FIELD(UInt16PropertyPointer, FUInt16Property, uint16)
-		ELSE_GET_MESSAGE_FIELD(UInt32Property, uint32)
-		ELSE_COMPLETE_GET_MESSAGE_FIELD(UInt64PropertyPointer, FUInt64Property, uint64)
-		ELSE_GET_MESSAGE_FIELD(FloatProperty, float)
-		ELSE_GET_MESSAGE_FIELD(DoubleProperty, double)
-		ELSE_GET_MESSAGE_FIELD(EnumProperty, int64)
-		ELSE_GET_MESSAGE_FIELD(BoolProperty, bool)
-		ELSE_GET_MESSAGE_FIELD(ClassProperty, UClass*)
-		ELSE_GET_MESSAGE_FIELD(ObjectProperty, UObject*)
-		ELSE_GET_MESSAGE_FIELD(SoftClassProperty, TSoftClassPtr<UObject>)
-		ELSE_GET_MESSAGE_FIELD(SoftObjectProperty, TSoftObjectPtr<UObject>)
-		ELSE_GET_MESSAGE_FIELD(InterfaceProperty, TScriptInterface<IInterface>)
-		ELSE_GET_MESSAGE_FIELD(NameProperty, FName)
-		ELSE_GET_MESSAGE_FIELD(StrProperty, FString)
-		ELSE_GET_MESSAGE_FIELD(TextProperty, FText)
-		ELSE_CUSTOMIZE_GET_MESSAGE_FIELD(ArrayProperty)
-		ELSE_CUSTOMIZE_GET_MESSAGE_FIELD(MapProperty)
-		ELSE_CUSTOMIZE_GET_MESSAGE_FIELD(SetProperty)
-		ELSE_CUSTOMIZE_GET_MESSAGE_FIELD(StructProperty)
-		ELSE_GET_MESSAGE_FIELD(MulticastInlineDelegateProperty, FMulticastScriptDelegate*)
-		ELSE_GET_MESSAGE_FIELD(MulticastSparseDelegateProperty, FSparseDelegate*)
+		if (const auto Accessor = SGMessageFunctionLibrary::FPropertyAccessorTable::Get().Find(InProperty))
+		{
+			Accessor->Get(*Message.Message, Key, InProperty, PropertyAddress);
+		}
+	}
+
+	return Message;
+}
+
+FSGBlueprintMessage USGMessageFunctionLibrary::ExecSetStruct(const FSGBlueprintMessage& Message,
+                                                             const FStructProperty* StructProperty,
+                                                             const void* StructAddress)
+{
+	if (Message.Message != nullptr && StructProperty != nullptr && StructAddress != nullptr)
+	{
+		const auto Layout = SGMessageFunctionLibrary::FStructLayoutCache::Get().Find(StructProperty->Struct);
+
+		for (const auto& Field : Layout->Fields)
+		{
+			Field.Accessor->Set(*Message.Message, Field.Key, Field.Property,
+			                    static_cast<const uint8*>(StructAddress) + Field.Offset);
+		}
+	}
+
+	return Message;
+}
+
+FSGBlueprintMessage USGMessageFunctionLibrary::ExecGetStruct(const FSGBlueprintMessage& Message,
+                                                             const FStructProperty* StructProperty,
+                                                             void* StructAddress)
+{
+	if (Message.Message != nullptr && StructProperty != nullptr && StructAddress != nullptr)
+	{
+		const auto Layout = SGMessageFunctionLibrary::FStructLayoutCache::Get().Find(StructProperty->Struct);
+
+		const auto& Params = Message.Message->GetParams();
+		const FSGMessageProjection* Projection = Message.Projection.Get();
+
+		for (const auto& Field : Layout->Fields)
+		{
+			// properties without a parameter keep their values, and so do those that the subscription doesn't read
+			if (((Projection == nullptr) || Projection->Contains(Field.Key)) && Params.Contains(Field.Key))
+			{
+				Field.Accessor->Get(*Message.Message, Field.Key, Field.Property,
+				                    static_cast<uint8*>(StructAddress) + Field.Offset);
+			}
+		}
 	}
 
 	return Message;
 }
+
+FSGBlueprintMessage USGMessageFunctionLibrary::ExecMakeSchemaMessage(const FStructProperty* StructProperty,
+                                                                     const void* StructAddress)
+{
+	FSGBlueprintMessage Message(nullptr);
+
+	if (StructProperty != nullptr && StructAddress != nullptr)
+	{
+		Message.Message->SetSchema(StructProperty->Struct, StructAddress);
+	}
+
+	return Message;
+}
+
+bool USGMessageFunctionLibrary::ExecBreakSchemaMessage(const FSGBlueprintMessage& Message,
+                                                       const FStructProperty* StructProperty,
+                                                       void* StructAddress)
+{
+	if (Message.Message != nullptr && StructProperty != nullptr && StructAddress != nullptr)
+	{
+		if (const FSGMessageSchemaPayload* Schema = Message.Message->GetSchema())
+		{
+			return Schema->CopyTo(StructProperty->Struct, StructAddress);
+		}
+	}
+
+	return false;
+}
@@ -3,6 +3,16 @@
 
 #include "MessagingFramework/Subsystems/SGMessageWorldSubsystem.h"
 #include "Blueprint/Common/SGBlueprintMessageEndpointBuilder.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "GameFramework/Actor.h"
+#include "MessagingFramework/Components/SGMessageEndpointComponent.h"
+#include "Stats/Stats.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Queued Inbox Messages"), STAT_SGMessageWorldSubsystem_QueuedInboxMessages, STATGROUP_SGMessaging);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Processed Inbox Messages"), STAT_SGMessageWorldSubsystem_ProcessedInboxMessages, STATGROUP_SGMessaging);
+DECLARE_CYCLE_STAT(TEXT("Process Inboxes"), STAT_SGMessageWorldSubsystem_ProcessInboxes, STATGROUP_SGMessaging);
+DECLARE_CYCLE_STAT(TEXT("Update Spatial Interests"), STAT_SGMessageWorldSubsystem_UpdateSpatialInterests, STATGROUP_SGMessaging);
 
 void USGMessageWorldSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
@@ -20,9 +30,49 @@ void USGMessageWorldSubsystem::Deinitialize()
 
 	DefaultMessageEndpoint->MarkAsGarbage();
 
+	if (SharedMessageEndpoint != nullptr)
+	{
+		SharedMessageEndpoint->MarkAsGarbage();
+	}
+
+	for (const auto& ClassMessageEndpoint : ClassMessageEndpoints)
+	{
+		ClassMessageEndpoint.Value->MarkAsGarbage();
+	}
+
+	ClassMessageEndpoints.Empty();
+
 	Super::Deinitialize();
 }
 
+void USGMessageWorldSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	if (DefaultBus == nullptr)
+	{
+		return;
+	}
+
+	// threaded buses route on their own, frame mode buses only route here
+	const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> MessageBus = DefaultBus->GetMessageBus();
+
+	// the interests go first, so that a frame mode bus routes this frame's messages with them
+	UpdateSpatialInterests();
+
+	if (MessageBus.IsValid() && MessageBus->IsFrameMode())
+	{
+		MessageBus->ProcessFrame();
+	}
+
+	ProcessInboxes();
+}
+
+TStatId USGMessageWorldSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(USGMessageWorldSubsystem, STATGROUP_Tickables);
+}
+
 USGBlueprintMessageBus* USGMessageWorldSubsystem::GetDefaultBus() const
 {
 	return DefaultBus;
@@ -32,3 +82,258 @@ USGBlueprintMessageEndpoint* USGMessageWorldSubsystem::GetDefaultMessageEndpoint
 {
 	return DefaultMessageEndpoint;
 }
+
+USGBlueprintMessageEndpoint* USGMessageWorldSubsystem::GetSharedMessageEndpoint(UClass* Class)
+{
+	USGBlueprintMessageEndpoint*& Endpoint = (Class != nullptr) ? ClassMessageEndpoints.FindOrAdd(Class) : SharedMessageEndpoint;
+
+	if (Endpoint == nullptr)
+	{
+		FString Name = GetWorld()->GetName() + TEXT("_Shared");
+
+		if (Class != nullptr)
+		{
+			Name += TEXT("_") + Class->GetName();
+		}
+
+		Endpoint = USGBlueprintMessageEndpoint::Builder(this, *Name, DefaultBus->GetMessageBus().ToSharedRef());
+	}
+
+	return Endpoint;
+}
+
+void USGMessageWorldSubsystem::RegisterInbox(const TSharedRef<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint,
+                                             int32 Priority, int32 MaxMessagesPerFrame, float MaxTimePerFrameMs)
+{
+	UnregisterInbox(Endpoint);
+
+	FTickedInbox TickedInbox;
+	{
+		TickedInbox.Endpoint = Endpoint;
+		TickedInbox.Priority = Priority;
+		TickedInbox.MaxMessagesPerFrame = FMath::Max(MaxMessagesPerFrame, 0);
+		TickedInbox.MaxTimePerFrame = FMath::Max(MaxTimePerFrameMs, 0.0f) / 1000.0;
+	}
+
+	// keep inboxes of equal priority in registration order
+	const int32 Index = TickedInboxes.IndexOfByPredicate([Priority](const FTickedInbox& Other)
+	{
+		return Other.Priority < Priority;
+	});
+
+	TickedInboxes.Insert(MoveTemp(TickedInbox), Index != INDEX_NONE ? Index : TickedInboxes.Num());
+}
+
+void USGMessageWorldSubsystem::UnregisterInbox(const TSharedRef<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint)
+{
+	TickedInboxes.RemoveAll([&Endpoint](const FTickedInbox& TickedInbox)
+	{
+		return TickedInbox.Endpoint == Endpoint;
+	});
+}
+
+void USGMessageWorldSubsystem::SetInboxFrameBudget(float MaxTimeMs)
+{
+	InboxFrameBudget = FMath::Max(MaxTimeMs, 0.0f) / 1000.0;
+}
+
+int32 USGMessageWorldSubsystem::GetNumQueuedInboxMessages() const
+{
+	int32 NumQueuedMessages = 0;
+
+	for (const FTickedInbox& TickedInbox : TickedInboxes)
+	{
+		if (const auto Endpoint = TickedInbox.Endpoint.Pin())
+		{
+			NumQueuedMessages += Endpoint->GetNumInboxMessages();
+		}
+	}
+
+	return NumQueuedMessages;
+}
+
+void USGMessageWorldSubsystem::ProcessInboxes()
+{
+	if (TickedInboxes.Num() == 0)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SGMessageWorldSubsystem_ProcessInboxes);
+
+	TickedInboxes.RemoveAll([](const FTickedInbox& TickedInbox)
+	{
+		return !TickedInbox.Endpoint.IsValid();
+	});
+
+	const double EndTime = (InboxFrameBudget > 0.0) ? FPlatformTime::Seconds() + InboxFrameBudget : 0.0;
+
+	// inboxes that were skipped in earlier frames go first, then by priority (the array's order)
+	TArray<int32, TInlineAllocator<16>> Order;
+
+	for (int32 Index = 0; Index < TickedInboxes.Num(); ++Index)
+	{
+		Order.Add(Index);
+	}
+
+	Order.StableSort([this](int32 A, int32 B)
+	{
+		return TickedInboxes[A].LastProcessedFrame < TickedInboxes[B].LastProcessedFrame;
+	});
+
+	int32 NumProcessed = 0;
+
+	for (const int32 Index : Order)
+	{
+		double MaxTime = TickedInboxes[Index].MaxTimePerFrame;
+
+		if (EndTime > 0.0)
+		{
+			const double RemainingTime = EndTime - FPlatformTime::Seconds();
+
+			if (RemainingTime <= 0.0)
+			{
+				break;
+			}
+
+			MaxTime = (MaxTime > 0.0) ? FMath::Min(MaxTime, RemainingTime) : RemainingTime;
+		}
+
+		if (const auto Endpoint = TickedInboxes[Index].Endpoint.Pin())
+		{
+			NumProcessed += Endpoint->ProcessInbox(TickedInboxes[Index].MaxMessagesPerFrame, MaxTime);
+		}
+
+		TickedInboxes[Index].LastProcessedFrame = GFrameCounter;
+	}
+
+	INC_DWORD_STAT_BY(STAT_SGMessageWorldSubsystem_ProcessedInboxMessages, NumProcessed);
+	SET_DWORD_STAT(STAT_SGMessageWorldSubsystem_QueuedInboxMessages, GetNumQueuedInboxMessages());
+}
+
+void USGMessageWorldSubsystem::RegisterSpatialInterest(USGMessageEndpointComponent* Component, const FName& MessageType,
+                                                       float Radius)
+{
+	if ((Component == nullptr) || (Component->GetMessageEndpoint() == nullptr))
+	{
+		return;
+	}
+
+	const TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint = Component->GetMessageEndpoint()->GetMessageEndpoint();
+
+	if (!Endpoint.IsValid())
+	{
+		return;
+	}
+
+	FSpatialSubscriber* SpatialSubscriber = SpatialSubscribers.FindByPredicate([Component](const FSpatialSubscriber& Other)
+	{
+		return Other.Component.Get() == Component;
+	});
+
+	if (SpatialSubscriber == nullptr)
+	{
+		SpatialSubscriber = &SpatialSubscribers.AddDefaulted_GetRef();
+		SpatialSubscriber->Component = Component;
+		SpatialSubscriber->Endpoint = Endpoint;
+	}
+
+	TPair<FName, float>* Interest = SpatialSubscriber->Interests.FindByPredicate([&MessageType](const TPair<FName, float>& Other)
+	{
+		return Other.Key == MessageType;
+	});
+
+	if (Interest != nullptr)
+	{
+		Interest->Value = FMath::Max(Radius, 0.0f);
+	}
+	else
+	{
+		SpatialSubscriber->Interests.Emplace(MessageType, FMath::Max(Radius, 0.0f));
+	}
+
+	SpatialSubscriber->bDirty = true;
+}
+
+void USGMessageWorldSubsystem::UnregisterSpatialInterests(const USGMessageEndpointComponent* Component)
+{
+	for (int32 Index = SpatialSubscribers.Num() - 1; Index >= 0; --Index)
+	{
+		FSpatialSubscriber& SpatialSubscriber = SpatialSubscribers[Index];
+
+		if (SpatialSubscriber.Component.Get() != Component)
+		{
+			continue;
+		}
+
+		// the endpoint may outlive the component, so its interests are removed explicitly
+		if (const auto Endpoint = SpatialSubscriber.Endpoint.Pin())
+		{
+			for (const TPair<FName, float>& Interest : SpatialSubscriber.Interests)
+			{
+				PendingSpatialInterests.Add(Endpoint->MakeSpatialInterest(Interest.Key, FVector::ZeroVector, -1.0f));
+			}
+		}
+
+		SpatialSubscribers.RemoveAtSwap(Index);
+	}
+}
+
+void USGMessageWorldSubsystem::UpdateSpatialInterests()
+{
+	if ((SpatialSubscribers.Num() == 0) && (PendingSpatialInterests.Num() == 0))
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_SGMessageWorldSubsystem_UpdateSpatialInterests);
+
+	const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+	const double UpdateDistanceSquared = FMath::Square((SGMessagingSettings != nullptr) ? SGMessagingSettings->SpatialUpdateDistance : 100.0f);
+
+	for (int32 Index = SpatialSubscribers.Num() - 1; Index >= 0; --Index)
+	{
+		FSpatialSubscriber& SpatialSubscriber = SpatialSubscribers[Index];
+		const USGMessageEndpointComponent* Component = SpatialSubscriber.Component.Get();
+		const auto Endpoint = SpatialSubscriber.Endpoint.Pin();
+
+		// the routers drop the interests of endpoints that went away
+		if ((Component == nullptr) || !Endpoint.IsValid())
+		{
+			SpatialSubscribers.RemoveAtSwap(Index);
+
+			continue;
+		}
+
+		const AActor* Owner = Component->GetOwner();
+
+		if (Owner == nullptr)
+		{
+			continue;
+		}
+
+		const FVector Location = Owner->GetActorLocation();
+
+		if (!SpatialSubscriber.bDirty && (FVector::DistSquared(Location, SpatialSubscriber.LastLocation) < UpdateDistanceSquared))
+		{
+			continue;
+		}
+
+		for (const TPair<FName, float>& Interest : SpatialSubscriber.Interests)
+		{
+			PendingSpatialInterests.Add(Endpoint->MakeSpatialInterest(Interest.Key, Location, Interest.Value));
+		}
+
+		SpatialSubscriber.LastLocation = Location;
+		SpatialSubscriber.bDirty = false;
+	}
+
+	const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> MessageBus = (DefaultBus != nullptr) ? DefaultBus->GetMessageBus() : nullptr;
+
+	if (MessageBus.IsValid() && (PendingSpatialInterests.Num() > 0))
+	{
+		MessageBus->UpdateSpatialInterests(PendingSpatialInterests);
+	}
+
+	PendingSpatialInterests.Reset();
+}
@@ -1,18 +1,31 @@
 // Copyright Epic Games, Inc. All Rights Reserved.
 
 #include "CoreMinimal.h"
+#include "Features/IModularFeatures.h"
+#include "HAL/IConsoleManager.h"
 #include "HAL/PlatformProcess.h"
 #include "Misc/CoreMisc.h"
 #include "Misc/CoreDelegates.h"
+#include "Misc/ScopeLock.h"
 #include "Modules/ModuleManager.h"
 #include "Settings/Public/ISettingsModule.h"
 #include "Core/Bus/SGMessageDispatchTask.h"
 #include "Core/Interface/ISGMessageBus.h"
+#include "Core/Interface/ISGMessageTracer.h"
 #include "Core/Bus/SGMessageBus.h"
+#include "Core/Bus/SGMessageCapture.h"
+#include "Core/Bus/SGMessageHandlerProfiler.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessagePool.h"
+#include "Core/Bus/SGMessageReplay.h"
+#include "Core/Bus/SGMessageStatistics.h"
 #include "Core/Bridge/SGMessageBridge.h"
+#include "Core/Bridge/SGMessageBusLink.h"
 #include "Core/Interface/ISGMessagingModule.h"
 #include "Core/Interface/ISGNetworkMessagingExtension.h"
+#include "Core/Message/SGMessageTagRegistry.h"
 #include "Core/Settings/SGMessagingSettings.h"
+#include "Core/Transport/SGUdpMessagingExtension.h"
 
 
 #ifndef PLATFORM_SUPPORTS_SGMESSAGEBUS
@@ -49,6 +62,16 @@ public:
 		return MakeShared<FSGMessageBridge, ESPMode::ThreadSafe>(Address, Bus, Transport);
 	}
 
+	virtual TSharedPtr<ISGMessageBridge, ESPMode::ThreadSafe> CreateBusLink(const FSGMessageAddress& Address, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& FirstBus, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& SecondBus, TArrayView<const FName> MessageTypes, const FSGMessageScopeRange& ScopeRange) override
+	{
+		if (FirstBus == SecondBus)
+		{
+			return nullptr;
+		}
+
+		return MakeShared<FSGMessageBusLink, ESPMode::ThreadSafe>(Address, FirstBus, SecondBus, MessageTypes, ScopeRange);
+	}
+
 	virtual TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> CreateBus(const TSharedPtr<ISGAuthorizeMessageRecipients>& RecipientAuthorizer) override
 	{
 		return CreateBus(FGuid::NewGuid().ToString(), RecipientAuthorizer);
@@ -88,6 +111,8 @@ public:
 
 	virtual void StartupModule() override
 	{
+		FSGMessageTagRegistry::Get().Initialize();
+
 #if PLATFORM_SUPPORTS_SGMESSAGEBUS
 		FCoreDelegates::OnPreExit.AddRaw(this, &FSGMessagingModule::HandleCorePreExit);
 #endif	//PLATFORM_SUPPORTS_MESSAGEBUS
@@ -103,10 +128,93 @@ public:
 			                                 GetMutableDefault<USGMessagingSettings>()
 			);
 		}
+
+		LatencyReportCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("SGMessaging.LatencyReport"),
+			TEXT("Prints the p50/p90/p99/max delivery latencies traced by all message buses. Optional arguments: a message type filter, -endpoints to include endpoints, -reset to reset the histograms and compression statistics afterwards. Also prints the compression statistics of network transports. The tracer of a bus must be running."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FSGMessagingModule::HandleLatencyReportCommand),
+			ECVF_Default
+		);
+
+		CaptureCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("SGMessaging.Capture"),
+			TEXT("Captures the messages routed by a message bus to a file. Arguments: the bus name and the file name, or the bus name and -stop to close the file."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FSGMessagingModule::HandleCaptureCommand),
+			ECVF_Default
+		);
+
+		ReplayCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("SGMessaging.Replay"),
+			TEXT("Replays a message capture into a message bus on a separate thread. Arguments: the bus name and the file name, optionally -max to replay as fast as possible, or -stop to cancel all replays."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FSGMessagingModule::HandleReplayCommand),
+			ECVF_Default
+		);
+
+		MemReportCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("SGMessaging.MemReport"),
+			TEXT("Prints the memory footprint of all message buses (tables, indices, queues, delayed messages and tracer) with counts, and of the endpoint inboxes and the message pool. Optional argument: a bus name filter. The footprint of a bus is refreshed by its routers about once per second."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FSGMessagingModule::HandleMemReportCommand),
+			ECVF_Default
+		);
+
+		HandlerReportCommand = IConsoleManager::Get().RegisterConsoleCommand(
+			TEXT("SGMessaging.HandlerReport"),
+			TEXT("Prints the most expensive message handlers over the profiling window with calls, total, average and max times. Optional arguments: the number of handlers to print (default 10), -start or -stop to start or stop profiling, -reset to remove the timings afterwards."),
+			FConsoleCommandWithArgsDelegate::CreateRaw(this, &FSGMessagingModule::HandleHandlerReportCommand),
+			ECVF_Default
+		);
+
+		FSGMessageHandlerProfiler::SetEnabled(GetDefault<USGMessagingSettings>()->bEnableHandlerProfiling);
+
+		UdpMessagingExtension = MakeUnique<FSGUdpMessagingExtension>(*this);
+		IModularFeatures::Get().RegisterModularFeature(ISGNetworkMessagingExtension::ModularFeatureName, UdpMessagingExtension.Get());
+		UdpMessagingExtension->RestartServices();
 	}
 
 	virtual void ShutdownModule() override
 	{
+		if (LatencyReportCommand != nullptr)
+		{
+			IConsoleManager::Get().UnregisterConsoleObject(LatencyReportCommand);
+			LatencyReportCommand = nullptr;
+		}
+
+		if (CaptureCommand != nullptr)
+		{
+			IConsoleManager::Get().UnregisterConsoleObject(CaptureCommand);
+			CaptureCommand = nullptr;
+		}
+
+		if (ReplayCommand != nullptr)
+		{
+			IConsoleManager::Get().UnregisterConsoleObject(ReplayCommand);
+			ReplayCommand = nullptr;
+		}
+
+		if (MemReportCommand != nullptr)
+		{
+			IConsoleManager::Get().UnregisterConsoleObject(MemReportCommand);
+			MemReportCommand = nullptr;
+		}
+
+		if (HandlerReportCommand != nullptr)
+		{
+			IConsoleManager::Get().UnregisterConsoleObject(HandlerReportCommand);
+			HandlerReportCommand = nullptr;
+		}
+
+		FSGMessageHandlerProfiler::SetEnabled(false);
+
+		// cancels and joins running replays
+		Replays.Empty();
+
+		if (UdpMessagingExtension.IsValid())
+		{
+			IModularFeatures::Get().UnregisterModularFeature(ISGNetworkMessagingExtension::ModularFeatureName, UdpMessagingExtension.Get());
+			UdpMessagingExtension->ShutdownServices();
+			UdpMessagingExtension.Reset();
+		}
+
 		ShutdownDefaultBus();
 
 #if PLATFORM_SUPPORTS_SGMESSAGEBUS
@@ -147,6 +255,259 @@ private:
 		ShutdownDefaultBus();
 	}
 
+	/** Callback for the SGMessaging.LatencyReport console command. */
+	void HandleLatencyReportCommand(const TArray<FString>& Args)
+	{
+		FString TypeFilter;
+		bool bIncludeEndpoints = false;
+		bool bReset = false;
+
+		for (const FString& Arg : Args)
+		{
+			if (Arg == TEXT("-endpoints"))
+			{
+				bIncludeEndpoints = true;
+			}
+			else if (Arg == TEXT("-reset"))
+			{
+				bReset = true;
+			}
+			else
+			{
+				TypeFilter = Arg;
+			}
+		}
+
+		for (const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus : GetAllBuses())
+		{
+			TSharedRef<ISGMessageTracer, ESPMode::ThreadSafe> Tracer = Bus->GetTracer();
+			FScopeLock Lock(&Tracer->GetInfoLock());
+
+			UE_LOG(LogSGMessaging, Display, TEXT("Message bus %s (tracer %s, %lld dropped trace events):"), *Bus->GetName(), Tracer->IsRunning() ? TEXT("running") : TEXT("stopped"), Tracer->GetNumDroppedTraces());
+
+			TArray<TSharedPtr<FSGMessageTracerTypeInfo>> TypeInfos;
+			Tracer->GetMessageTypes(TypeInfos);
+
+			for (const TSharedPtr<FSGMessageTracerTypeInfo>& TypeInfo : TypeInfos)
+			{
+				const FString TypeName = TypeInfo->DebugName.IsEmpty() ? TypeInfo->TypeName.ToString() : TypeInfo->DebugName;
+
+				if (TypeFilter.IsEmpty() || TypeName.Contains(TypeFilter))
+				{
+					LogLatencies(TypeName, TypeInfo->Latencies);
+				}
+			}
+
+			if (bIncludeEndpoints)
+			{
+				TArray<TSharedPtr<FSGMessageTracerEndpointInfo>> EndpointInfos;
+				Tracer->GetEndpoints(EndpointInfos);
+
+				for (const TSharedPtr<FSGMessageTracerEndpointInfo>& EndpointInfo : EndpointInfos)
+				{
+					LogLatencies(FString::Printf(TEXT("endpoint %s"), *EndpointInfo->Name.ToString()), EndpointInfo->Latencies);
+				}
+			}
+
+			if (bReset)
+			{
+				Tracer->ResetLatencies();
+			}
+		}
+
+		TMap<FName, FSGMessageCompressionStatistics> CompressionStatistics;
+		FSGMessageCompressionCounters::GetStatistics(CompressionStatistics);
+
+		if (CompressionStatistics.Num() > 0)
+		{
+			const double MicrosecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+
+			UE_LOG(LogSGMessaging, Display, TEXT("Transport compression:"));
+
+			for (const auto& StatisticsPair : CompressionStatistics)
+			{
+				const FSGMessageCompressionStatistics& TypeStatistics = StatisticsPair.Value;
+
+				if (TypeFilter.IsEmpty() || StatisticsPair.Key.ToString().Contains(TypeFilter))
+				{
+					UE_LOG(LogSGMessaging, Display, TEXT("  %s: compressed=%lld ratio=%.3f compress=%.1fus/msg decompressed=%lld decompress=%.1fus/msg"),
+						*StatisticsPair.Key.ToString(), TypeStatistics.NumCompressed, TypeStatistics.GetRatio(),
+						(TypeStatistics.NumCompressed > 0) ? (double)TypeStatistics.CompressCycles * MicrosecondsPerCycle / (double)TypeStatistics.NumCompressed : 0.0,
+						TypeStatistics.NumDecompressed,
+						(TypeStatistics.NumDecompressed > 0) ? (double)TypeStatistics.DecompressCycles * MicrosecondsPerCycle / (double)TypeStatistics.NumDecompressed : 0.0);
+				}
+			}
+
+			if (bReset)
+			{
+				FSGMessageCompressionCounters::Reset();
+			}
+		}
+	}
+
+	/** Callback for the SGMessaging.Capture console command. */
+	void HandleCaptureCommand(const TArray<FString>& Args)
+	{
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = (Args.Num() == 2) ? WeakBuses.FindRef(FName(Args[0])).Pin() : nullptr;
+
+		if (!Bus.IsValid())
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Usage: SGMessaging.Capture <BusName> <Filename>|-stop"));
+
+			return;
+		}
+
+		// all buses are created by this module
+		TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> Capture = StaticCastSharedPtr<FSGMessageBus>(Bus)->GetCapture();
+
+		if (Args[1] == TEXT("-stop"))
+		{
+			Capture->StopCapture();
+		}
+		else
+		{
+			Capture->StartCapture(Args[1]);
+		}
+	}
+
+	/** Callback for the SGMessaging.Replay console command. */
+	void HandleReplayCommand(const TArray<FString>& Args)
+	{
+		Replays.RemoveAll([](const TUniquePtr<FSGMessageReplay>& Replay)
+		{
+			return !Replay->IsReplaying();
+		});
+
+		if ((Args.Num() == 1) && (Args[0] == TEXT("-stop")))
+		{
+			Replays.Empty();
+
+			return;
+		}
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = (Args.Num() >= 2) ? WeakBuses.FindRef(FName(Args[0])).Pin() : nullptr;
+
+		if (!Bus.IsValid())
+		{
+			UE_LOG(LogSGMessaging, Warning, TEXT("Usage: SGMessaging.Replay <BusName> <Filename> [-max] or SGMessaging.Replay -stop"));
+
+			return;
+		}
+
+		const ESGMessageReplaySpeed Speed = Args.Contains(TEXT("-max")) ? ESGMessageReplaySpeed::Max : ESGMessageReplaySpeed::Original;
+		TUniquePtr<FSGMessageReplay> Replay = MakeUnique<FSGMessageReplay>(Bus.ToSharedRef());
+
+		if (Replay->Load(Args[1]) && Replay->Start(Speed))
+		{
+			Replays.Add(MoveTemp(Replay));
+		}
+	}
+
+	/** Callback for the SGMessaging.MemReport console command. */
+	void HandleMemReportCommand(const TArray<FString>& Args)
+	{
+		const FString BusFilter = (Args.Num() > 0) ? Args[0] : FString();
+		int64 TotalBytes = 0;
+
+		for (const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus : GetAllBuses())
+		{
+			if (!BusFilter.IsEmpty() && !Bus->GetName().Contains(BusFilter))
+			{
+				continue;
+			}
+
+			// all buses are created by this module
+			const FSGMessageMemoryReport Report = StaticCastSharedRef<FSGMessageBus>(Bus)->GetMemoryReport();
+
+			UE_LOG(LogSGMessaging, Display, TEXT("Message bus %s: %.1f KB"), *Bus->GetName(), Report.GetTotalBytes() / 1024.0);
+			UE_LOG(LogSGMessaging, Display, TEXT("  tables: recipients=%d subscriptions=%d interceptors=%d requests=%d %.1f KB"),
+				Report.NumRecipients, Report.NumSubscriptions, Report.NumInterceptors, Report.NumPendingRequests, Report.TableBytes / 1024.0);
+			UE_LOG(LogSGMessaging, Display, TEXT("  indices: retained=%d spatial=%d deduplication=%d %.1f KB"),
+				Report.NumRetainedMessages, Report.NumSpatialSubscribers, Report.NumDeduplicationKeys, Report.IndexBytes / 1024.0);
+			UE_LOG(LogSGMessaging, Display, TEXT("  queues: commands=%d %.1f KB"), Report.NumQueuedCommands, Report.QueueBytes / 1024.0);
+			UE_LOG(LogSGMessaging, Display, TEXT("  delayed: messages=%d %.1f KB"), Report.NumDelayedMessages, Report.DelayedBytes / 1024.0);
+			UE_LOG(LogSGMessaging, Display, TEXT("  tracer: messages=%d %.1f KB"), Report.NumTracedMessages, Report.TracerBytes / 1024.0);
+
+			TotalBytes += Report.GetTotalBytes();
+		}
+
+		// inboxes and the pool are shared by all buses
+		const FSGMessagePoolStatistics PoolStatistics = FSGMessagePool::GetStatistics();
+
+		UE_LOG(LogSGMessaging, Display, TEXT("Endpoint inboxes: messages=%lld dropped=%lld"), FSGMessageInboxStatistics::GetNumQueuedMessages(), FSGMessageInboxStatistics::GetNumDroppedMessages());
+		UE_LOG(LogSGMessaging, Display, TEXT("Message pool: chunks=%d %.1f KB, pooled=%lld unpooled=%lld allocations"), PoolStatistics.NumChunks, PoolStatistics.ChunkBytes / 1024.0, PoolStatistics.NumPooledAllocations, PoolStatistics.NumUnpooledAllocations);
+		UE_LOG(LogSGMessaging, Display, TEXT("Total: %.1f KB (contexts and payloads are tracked by the SGMessaging LLM tags)"), (TotalBytes + PoolStatistics.ChunkBytes) / 1024.0);
+	}
+
+	/** Callback for the SGMessaging.HandlerReport console command. */
+	void HandleHandlerReportCommand(const TArray<FString>& Args)
+	{
+		int32 MaxHandlers = 10;
+		bool bReset = false;
+
+		for (const FString& Arg : Args)
+		{
+			if (Arg == TEXT("-start"))
+			{
+				FSGMessageHandlerProfiler::SetEnabled(true);
+			}
+			else if (Arg == TEXT("-stop"))
+			{
+				FSGMessageHandlerProfiler::SetEnabled(false);
+			}
+			else if (Arg == TEXT("-reset"))
+			{
+				bReset = true;
+			}
+			else if (Arg.IsNumeric())
+			{
+				MaxHandlers = FMath::Max(FCString::Atoi(*Arg), 1);
+			}
+		}
+
+		TArray<FSGMessageHandlerTiming> Timings;
+		FSGMessageHandlerProfiler::GetTopHandlers(MaxHandlers, Timings);
+
+		UE_LOG(LogSGMessaging, Display, TEXT("Message handler profiling is %s, %d handlers:"), FSGMessageHandlerProfiler::IsEnabled() ? TEXT("running") : TEXT("stopped"), Timings.Num());
+
+		for (const FSGMessageHandlerTiming& Timing : Timings)
+		{
+			// endpoints number their handlers, so several handlers of one endpoint show up separately
+			const FString HandlerStr = (Timing.HandlerId != 0) ? FString::Printf(TEXT("%s#%u"), *Timing.HandlerName.ToString(), Timing.HandlerId) : Timing.HandlerName.ToString();
+
+			UE_LOG(LogSGMessaging, Display, TEXT("  %s %s: calls=%lld total=%.3fms avg=%.3fms max=%.3fms"),
+				*HandlerStr, *Timing.MessageType.ToString(), Timing.NumCalls, Timing.TotalMs, Timing.GetAverageMs(), Timing.MaxMs);
+		}
+
+		if (bReset)
+		{
+			FSGMessageHandlerProfiler::Reset();
+		}
+	}
+
+	/** Prints the latency histograms of a message type or endpoint. */
+	static void LogLatencies(const FString& Name, const FSGMessageLatencyHistograms& Latencies)
+	{
+		auto LogHistogram = [&Name](const TCHAR* Stage, const FSGMessageLatencyHistogram& Histogram)
+		{
+			if (Histogram.GetCount() == 0)
+			{
+				return;
+			}
+
+			UE_LOG(LogSGMessaging, Display, TEXT("  %s %s: count=%llu p50=%.3fms p90=%.3fms p99=%.3fms max=%.3fms"),
+				*Name, Stage, Histogram.GetCount(),
+				Histogram.GetPercentile(0.5) * 1000.0,
+				Histogram.GetPercentile(0.9) * 1000.0,
+				Histogram.GetPercentile(0.99) * 1000.0,
+				Histogram.GetMax() * 1000.0);
+		};
+
+		LogHistogram(TEXT("send->route"), Latencies.SendToRoute);
+		LogHistogram(TEXT("route->dispatch"), Latencies.RouteToDispatch);
+		LogHistogram(TEXT("dispatch->handled"), Latencies.DispatchToHandled);
+	}
+
 private:
 	/** All buses that were created through this module including the default one. */
 	TMap<FName, TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe>> WeakBuses;
@@ -156,6 +517,27 @@ private:
 
 	/** The delegate fired when a message bus instance is shutdown. */
 	FOnMessageBusStartupOrShutdown OnMessageBusShutdownDelegate;
+
+	/** The SGMessaging.LatencyReport console command. */
+	IConsoleObject* LatencyReportCommand = nullptr;
+
+	/** The SGMessaging.Capture console command. */
+	IConsoleObject* CaptureCommand = nullptr;
+
+	/** The SGMessaging.Replay console command. */
+	IConsoleObject* ReplayCommand = nullptr;
+
+	/** The SGMessaging.MemReport console command. */
+	IConsoleObject* MemReportCommand = nullptr;
+
+	/** The SGMessaging.HandlerReport console command. */
+	IConsoleObject* HandlerReportCommand = nullptr;
+
+	/** The replays started with the SGMessaging.Replay console command. */
+	TArray<TUniquePtr<FSGMessageReplay>> Replays;
+
+	/** The network messaging extension of the UDP transport. */
+	TUniquePtr<FSGUdpMessagingExtension> UdpMessagingExtension;
 };
 
 FName ISGNetworkMessagingExtension::ModularFeatureName("SGNetworkMessaging");
@@ -36,6 +36,30 @@ enum class ESGBlueprintMessageFlags:uint8
 	/** Guarantee that this message is delivered */
 	Reliable = 1 << 0,
 	/** ESGMessageFlags::Reliable */
+
+	/** Route this message in the router's high priority lane */
+	HighPriority = 1 << 1,
+	/** ESGMessageFlags::HighPriority */
+
+	/** Route this message in the router's low priority lane */
+	LowPriority = 1 << 2,
+	/** ESGMessageFlags::LowPriority */
+
+	/** Replace older undelivered messages with the same conflation key (latest value wins) */
+	Conflate = 1 << 3,
+	/** ESGMessageFlags::Conflate */
+
+	/** Keep the latest published message of this type and deliver it to later subscribers */
+	Retain = 1 << 4,
+	/** ESGMessageFlags::Retain */
+
+	/** Keep the latest published message of each sender and deliver it to later subscribers */
+	RetainPerSender = 1 << 5,
+	/** ESGMessageFlags::RetainPerSender */
+
+	/** Drop copies of this message that arrive again within the deduplication window */
+	Deduplicate = 1 << 6,
+	/** ESGMessageFlags::Deduplicate */
 };
 
 UENUM(BlueprintType)
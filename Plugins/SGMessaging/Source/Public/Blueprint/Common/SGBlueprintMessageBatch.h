@@ -0,0 +1,97 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/EngineBaseTypes.h"
+#include "Blueprint/Bus/SGBlueprintMessageContext.h"
+#include "Blueprint/Message/SGBlueprintMessage.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "SGBlueprintMessageBatch.generated.h"
+
+class UWorld;
+
+DECLARE_DYNAMIC_DELEGATE_TwoParams(FSGBlueprintMessageBatchDelegate, const TArray<FSGBlueprintMessage>&, Messages,
+                                   const TArray<FSGBlueprintMessageContext>&, Contexts);
+
+
+/**
+ * Implements the tick function that hands a frame's messages to a Blueprint batch subscriber.
+ */
+USTRUCT()
+struct FSGBlueprintMessageBatchTickFunction : public FTickFunction
+{
+	GENERATED_BODY()
+
+	/** Holds the batch that is handed over (owned by the batch). */
+	class FSGBlueprintMessageBatch* Batch = nullptr;
+
+	//~ FTickFunction interface
+
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+	                         const FGraphEventRef& MyCompletionGraphEvent) override;
+	virtual FString DiagnosticMessage() override;
+};
+
+template <>
+struct TStructOpsTypeTraits<FSGBlueprintMessageBatchTickFunction> : public TStructOpsTypeTraitsBase2<FSGBlueprintMessageBatchTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
+
+/**
+ * Implements the messages a Blueprint batch subscriber receives during a frame.
+ *
+ * Messages are collected as they are delivered and handed to the subscriber's event once per frame,
+ * in the chosen tick group, so a high-rate message type enters the Blueprint VM once per frame
+ * instead of once per message. Frames without messages don't call the event.
+ *
+ * @see USGBlueprintMessageEndpoint::SubscribeBatched
+ */
+class FSGBlueprintMessageBatch
+{
+public:
+	/**
+	 * Creates and initializes a new batch.
+	 *
+	 * @param World The world whose tick hands the messages over.
+	 * @param InDelegate The event that receives the messages.
+	 * @param TickGroup The tick group in which the messages are handed over.
+	 */
+	FSGBlueprintMessageBatch(UWorld* World, const FSGBlueprintMessageBatchDelegate& InDelegate, ETickingGroup TickGroup);
+
+	FSGBlueprintMessageBatch(const FSGBlueprintMessageBatch&) = delete;
+	FSGBlueprintMessageBatch& operator=(const FSGBlueprintMessageBatch&) = delete;
+
+	~FSGBlueprintMessageBatch();
+
+public:
+	/**
+	 * Adds a delivered message.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Context The context of the message.
+	 */
+	void Add(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/** Hands the collected messages to the event (called by the tick function). */
+	void Flush();
+
+private:
+	/** Holds the event that receives the messages. */
+	FSGBlueprintMessageBatchDelegate Delegate;
+
+	/** Holds the messages delivered since the last flush. */
+	TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> PendingContexts;
+
+	/** Holds a critical section that protects the pending messages. */
+	FCriticalSection CriticalSection;
+
+	/** Holds the tick function. */
+	FSGBlueprintMessageBatchTickFunction TickFunction;
+};
@@ -5,9 +5,11 @@
 #include "CoreMinimal.h"
 #include "Blueprint/Message/SGBlueprintMessageParameter.h"
 #include "Core/Common/SGMessageEndpoint.h"
+#include "Core/Common/SGMessageEndpointMultiplexer.h"
 #include "UObject/NoExportTypes.h"
 #include "Blueprint/Message/SGBlueprintMessage.h"
 #include "Blueprint/Bus/SGBlueprintMessageContext.h"
+#include "Blueprint/Common/SGBlueprintMessageBatch.h"
 #include "SGBlueprintMessageEndpoint.generated.h"
 
 DECLARE_DYNAMIC_DELEGATE_TwoParams(FSGBlueprintMessageDelegate, const FSGBlueprintMessage&, Message,
@@ -42,6 +44,42 @@ public:
 		}
 	}
 
+	/**
+	 * Subscribes an event that only reads some parameters of the messages.
+	 *
+	 * The keys become the endpoint's projection of the message type, so message bridges only transport
+	 * these parameters to this process, and Get Struct only copies them out of delivered messages.
+	 * The projection applies to all events of the message type on this endpoint.
+	 *
+	 * @param InKeys The keys of the parameters that the event reads.
+	 * @see FSGMessageEndpoint::SetProjection
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SubscribeProjected(const int32 InTopicID, const int32 InMessageID, const TArray<FName>& InKeys,
+	                        const FSGBlueprintMessageDelegate& InDelegate);
+
+	/**
+	 * Subscribes an event that receives the messages of a frame together.
+	 *
+	 * The messages are collected as they are delivered and handed to the event once per frame in the
+	 * given tick group, which saves a Blueprint VM call per message for high-rate message types.
+	 *
+	 * @param WorldContextObject An object in the world whose tick hands the messages over.
+	 * @param TickGroup The tick group in which the messages are handed over.
+	 */
+	/**
+	 * Subscribes an event for the published messages near the endpoint.
+	 *
+	 * The event only receives messages once the endpoint has a spatial interest in the message type.
+	 *
+	 * @see FSGMessageEndpoint::SubscribeSpatial, FSGMessageEndpoint::SetSpatialInterest
+	 */
+	void SubscribeSpatial(const int32 InTopicID, const int32 InMessageID, const FSGBlueprintMessageDelegate& InDelegate);
+
+	UFUNCTION(BlueprintCallable, meta = (WorldContext = "WorldContextObject"))
+	void SubscribeBatched(const UObject* WorldContextObject, const int32 InTopicID, const int32 InMessageID,
+	                      const FSGBlueprintMessageBatchDelegate& InDelegate, ETickingGroup TickGroup = TG_PrePhysics);
+
 	UFUNCTION(BlueprintCallable)
 	void Publish(const int32 InTopicID, const int32 InMessageID, const FSGBlueprintPublishParameter InParameter,
 	             const FSGBlueprintMessage InMessage);
@@ -97,8 +135,96 @@ public:
 	UFUNCTION(BlueprintCallable)
 	FSGBlueprintMessageAddress GetAddress() const;
 
+	/**
+	 * Enables the endpoint, registering it and its subscriptions with the bus if it is dormant.
+	 *
+	 * @see Disable
+	 */
+	UFUNCTION(BlueprintCallable)
+	void Enable();
+
+	/**
+	 * Disables the endpoint and removes it from the bus until it is enabled again.
+	 *
+	 * @see Enable
+	 */
+	UFUNCTION(BlueprintCallable)
+	void Disable();
+
+	/**
+	 * Gets the median and the 99th percentile of the latest latencies from sending a message until the endpoint handled it.
+	 *
+	 * Both are zero if the endpoint handled no messages yet or latency probes are disabled in the messaging settings.
+	 *
+	 * @param OutP50Milliseconds The median latency (in milliseconds).
+	 * @param OutP99Milliseconds The 99th percentile latency (in milliseconds).
+	 * @see FSGMessageEndpoint::GetHandledLatency
+	 */
+	UFUNCTION(BlueprintCallable)
+	void GetHandledLatency(float& OutP50Milliseconds, float& OutP99Milliseconds) const;
+
+	/** Gets the underlying message endpoint. */
+	const TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>& GetMessageEndpoint() const
+	{
+		return MessageEndpoint;
+	}
+
+public:
+	/**
+	 * Subscribes a lightweight subscriber that shares this endpoint.
+	 *
+	 * The subscriber gets no endpoint of its own, its handlers are dispatched to by this endpoint.
+	 *
+	 * @param Subscriber The object that owns the handler.
+	 * @see RemoveSubscriber, GetSubscriberAddress
+	 */
+	void Subscribe(const UObject* Subscriber, const int32 InTopicID, const int32 InMessageID,
+	               const FSGBlueprintMessageDelegate& InDelegate);
+
+	template <typename HandlerType>
+	void Subscribe(const UObject* Subscriber, MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
+	               typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		if (FSGMessageEndpointMultiplexer* SharedEndpoint = GetMultiplexer())
+		{
+			SharedEndpoint->Subscribe(Subscriber, MESSAGE_TAG_PARAM_VALUE, Handler, HandlerFunc);
+		}
+	}
+
+	/**
+	 * Removes the handlers of a lightweight subscriber and releases its address.
+	 *
+	 * @param Subscriber The object that owns the handlers.
+	 */
+	void RemoveSubscriber(const UObject* Subscriber);
+
+	/**
+	 * Gets the address of a lightweight subscriber, which is allocated the first time.
+	 *
+	 * Messages sent to the address are only dispatched to the subscriber's handlers.
+	 *
+	 * @param Subscriber The object that owns the handlers.
+	 * @return The address.
+	 */
+	FSGBlueprintMessageAddress GetSubscriberAddress(const UObject* Subscriber);
+
+private:
+	/** Gets the lightweight subscribers of this endpoint, creating them the first time. */
+	FSGMessageEndpointMultiplexer* GetMultiplexer();
+
+	/** Creates a handler function that executes a Blueprint delegate, optionally with the projection of its subscription. */
+	static TSGLambdaMessageHandler<FSGMessage>::FuncType MakeDelegateHandler(
+		const FSGBlueprintMessageDelegate& InDelegate,
+		const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& InProjection = nullptr);
+
 private:
 	TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> MessageEndpoint;
 
+	/** Holds the lightweight subscribers that share this endpoint. */
+	TSharedPtr<FSGMessageEndpointMultiplexer, ESPMode::ThreadSafe> Multiplexer;
+
+	/** Holds the messages collected for batch subscribers. */
+	TArray<TSharedPtr<FSGBlueprintMessageBatch, ESPMode::ThreadSafe>> Batches;
+
 	friend struct FSGBlueprintMessageEndpointBuilder;
 };
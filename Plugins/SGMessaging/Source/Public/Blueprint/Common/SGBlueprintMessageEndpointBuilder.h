@@ -27,6 +27,7 @@ public:
 		: Outer(nullptr)
 		  , BusPtr(nullptr)
 		  , Disabled(false)
+		  , ActivateOnFirstUse(false)
 		  , InboxEnabled(false)
 		  , Name(InName)
 		  , RecipientThread(FTaskGraphInterface::Get().GetCurrentThreadIfKnown())
@@ -44,6 +45,7 @@ public:
 		: Outer(InOuter)
 		  , BusPtr(InBus)
 		  , Disabled(false)
+		  , ActivateOnFirstUse(false)
 		  , InboxEnabled(false)
 		  , Name(InName)
 		  , RecipientThread(FTaskGraphInterface::Get().GetCurrentThreadIfKnown())
@@ -110,6 +112,22 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Defers registering the endpoint and its subscriptions with the bus.
+	 *
+	 * The endpoint is activated when it is enabled or sends its first message, which keeps dormant
+	 * endpoints (e.g. of pooled actors) out of the router's tables.
+	 *
+	 * @return This instance (for method chaining).
+	 * @see FSGMessageEndpoint::Activate
+	 */
+	FSGBlueprintMessageEndpointBuilder& ThatActivatesOnFirstUse()
+	{
+		ActivateOnFirstUse = true;
+
+		return *this;
+	}
+
 	/**
 	 * Enables the endpoint's message inbox.
 	 *
@@ -149,8 +167,6 @@ public:
 
 			ScriptMessageEndpoint->MessageEndpoint = Endpoint;
 
-			Bus->Register(Endpoint->GetAddress(), Endpoint.ToSharedRef());
-
 			if (OnNotification.IsBound())
 			{
 				Bus->AddNotificationListener(Endpoint.ToSharedRef());
@@ -170,6 +186,12 @@ public:
 			{
 				Endpoint->SetRecipientThread(RecipientThread);
 			}
+
+			// the recipient thread must be set before messages can arrive
+			if (!Disabled && !ActivateOnFirstUse)
+			{
+				Endpoint->Activate();
+			}
 		}
 
 		return ScriptMessageEndpoint;
@@ -194,6 +216,9 @@ private:
 	/** Holds a flag indicating whether the endpoint should be disabled. */
 	bool Disabled;
 
+	/** Holds a flag indicating whether the endpoint should be activated on first use. */
+	bool ActivateOnFirstUse;
+
 	/** Holds a delegate to invoke on disconnection event. */
 	FOnBusNotification OnNotification;
 
@@ -1,9 +1,20 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Core/Bus/SGMessagePool.h"
 #include "Core/Message/SGMessage.h"
 #include "SGBlueprintMessage.generated.h"
 
+/**
+ * Holds a reference to a dynamic message for Blueprints.
+ *
+ * Copies of the structure share the message, which is returned to the message pool when the last
+ * Blueprint copy and the last message context that refer to it are gone. A message must not be
+ * changed anymore once it was published or sent, because recipients read it concurrently.
+ *
+ * Messages delivered to a projected subscription carry its projection, so that Get Struct only copies
+ * the parameters that the subscription declared (see USGBlueprintMessageEndpoint::SubscribeProjected).
+ */
 USTRUCT(BlueprintType)
 struct FSGBlueprintMessage
 {
@@ -11,22 +22,75 @@ struct FSGBlueprintMessage
 
 	FSGBlueprintMessage() = default;
 
+	/**
+	 * Creates a reference to a message.
+	 *
+	 * @param InMessage The message to refer to (nullptr = a new message from the pool).
+	 */
 	FSGBlueprintMessage(ISGMessage* InMessage)
 	{
 		if (InMessage == nullptr)
 		{
-			Message = new FSGMessage();
+			Message = FSGMessagePool::New<FSGMessage>();
 		}
 		else
 		{
 			Message = static_cast<FSGMessage*>(InMessage);
+			Message->AddRef();
 		}
 	}
 
-	operator FSGMessage*() const
+	FSGBlueprintMessage(const FSGBlueprintMessage& Other)
+		: Message(Other.Message)
+		, Projection(Other.Projection)
 	{
+		if (Message != nullptr)
+		{
+			Message->AddRef();
+		}
+	}
+
+	FSGBlueprintMessage(FSGBlueprintMessage&& Other)
+		: Message(Other.Message)
+		, Projection(MoveTemp(Other.Projection))
+	{
+		Other.Message = nullptr;
+	}
+
+	~FSGBlueprintMessage()
+	{
+		if (Message != nullptr)
+		{
+			Message->Release();
+		}
+	}
+
+	FSGBlueprintMessage& operator=(FSGBlueprintMessage Other)
+	{
+		Swap(Message, Other.Message);
+		Swap(Projection, Other.Projection);
+
+		return *this;
+	}
+
+	/**
+	 * Gets the message with a new reference, which the caller hands to a message context.
+	 *
+	 * @return The message (nullptr if there is none).
+	 */
+	FSGMessage* Share() const
+	{
+		if (Message != nullptr)
+		{
+			Message->AddRef();
+		}
+
 		return Message;
 	}
 
-	FSGMessage* Message;
+	/** Holds the message (one reference). */
+	FSGMessage* Message = nullptr;
+
+	/** Holds the parameters that the receiving subscription reads (nullptr = all parameters). */
+	TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe> Projection;
 };
@@ -47,6 +47,9 @@ struct FSGBlueprintPublishParameter
 	UPROPERTY(BlueprintReadWrite)
 	ESGBlueprintMessageScope Scope;
 
+	UPROPERTY(BlueprintReadWrite)
+	ESGBlueprintMessageFlags Flags;
+
 	UPROPERTY(BlueprintReadWrite)
 	TMap<FName, FString> Annotations;
 
@@ -62,6 +65,7 @@ struct FSGBlueprintPublishParameter
 			static_cast<ESGMessageScope>(Scope),
 			Annotations,
 			Delay,
-			Expiration);
+			Expiration,
+			static_cast<ESGMessageFlags>(Flags));
 	}
 };
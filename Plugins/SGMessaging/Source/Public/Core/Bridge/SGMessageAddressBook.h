@@ -6,9 +6,16 @@
 #include "Misc/Guid.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
+#include <atomic>
 
 /**
  * Implements an address book that maps message addresses to remote nodes.
+ *
+ * The book is read far more often than it is written: every outbound message resolves its
+ * recipients, while addresses are only added when new remote senders appear. Readers share a
+ * read-write lock, and the nodes of recently resolved recipient lists are cached until the book
+ * changes. Each node's addresses are indexed, so removing a node only touches its own addresses.
  */
 class FSGMessageAddressBook
 {
@@ -16,15 +23,8 @@ public:
 
 	/** Default constructor. */
 	FSGMessageAddressBook()
-	{
-		CriticalSection = new FCriticalSection();
-	}
-
-	/** Destructor. */
-	~FSGMessageAddressBook()
-	{
-		delete CriticalSection;
-	}
+		: Generation(1)
+	{ }
 
 public:
 
@@ -36,17 +36,34 @@ public:
 	 */
 	void Add(const FSGMessageAddress& Address, const FGuid& NodeId)
 	{
-		FScopeLock Lock(CriticalSection);
+		FWriteScopeLock WriteLock(EntriesLock);
+
+		FGuid& EntryNodeId = Entries.FindOrAdd(Address);
 
-		Entries.FindOrAdd(Address) = NodeId;
+		if (EntryNodeId == NodeId)
+		{
+			return;
+		}
+
+		// the address moved to another node
+		if (EntryNodeId.IsValid())
+		{
+			RemoveFromNode(EntryNodeId, Address);
+		}
+
+		EntryNodeId = NodeId;
+		NodeAddresses.FindOrAdd(NodeId).Add(Address);
+		Generation.fetch_add(1, std::memory_order_release);
 	}
 
 	/** Clears the address book. */
 	void Clear()
 	{
-		FScopeLock Lock(CriticalSection);
+		FWriteScopeLock WriteLock(EntriesLock);
 
 		Entries.Reset();
+		NodeAddresses.Reset();
+		Generation.fetch_add(1, std::memory_order_release);
 	}
 
 	/**
@@ -57,7 +74,7 @@ public:
 	 */
 	bool Contains(const FSGMessageAddress& Address)
 	{
-		FScopeLock Lock(CriticalSection);
+		FReadScopeLock ReadLock(EntriesLock);
 
 		return Entries.Contains(Address);
 	}
@@ -68,22 +85,54 @@ public:
 	 * @param Addresses The address list to retrieve the node identifiers for.
 	 * @return The list of node identifiers.
 	 */
-	TArray<FGuid> GetNodesFor(const TArray<FSGMessageAddress>& Addresses)
+	TArray<FGuid> GetNodesFor(TArrayView<const FSGMessageAddress> Addresses)
 	{
-		TArray<FGuid> FoundNodes;
-
-		FScopeLock Lock(CriticalSection);
+		uint32 AddressesHash = 0;
 
 		for (const auto& Address : Addresses)
 		{
-			FGuid* NodeId = Entries.Find(Address);
+			AddressesHash = HashCombine(AddressesHash, GetTypeHash(Address));
+		}
+
+		FCachedResolution& CachedResolution = CachedResolutions[AddressesHash % NumCachedResolutions];
+		const uint64 CurrentGeneration = Generation.load(std::memory_order_acquire);
+		{
+			FScopeLock Lock(&CacheCriticalSection);
 
-			if (NodeId != nullptr)
+			if ((CachedResolution.Generation == CurrentGeneration) && (CachedResolution.Addresses.Num() == Addresses.Num()) && CompareItems(CachedResolution.Addresses.GetData(), Addresses.GetData(), Addresses.Num()))
 			{
-				FoundNodes.AddUnique(*NodeId);
+				return CachedResolution.Nodes;
 			}
 		}
 
+		TArray<FGuid> FoundNodes;
+		uint64 ResolvedGeneration = 0;
+		{
+			FReadScopeLock ReadLock(EntriesLock);
+
+			for (const auto& Address : Addresses)
+			{
+				const FGuid* NodeId = Entries.Find(Address);
+
+				if (NodeId != nullptr)
+				{
+					FoundNodes.AddUnique(*NodeId);
+				}
+			}
+
+			// writers bump the generation while holding the write lock
+			ResolvedGeneration = Generation.load(std::memory_order_acquire);
+		}
+
+		{
+			FScopeLock Lock(&CacheCriticalSection);
+
+			CachedResolution.Generation = ResolvedGeneration;
+			CachedResolution.Addresses.Reset();
+			CachedResolution.Addresses.Append(Addresses.GetData(), Addresses.Num());
+			CachedResolution.Nodes = FoundNodes;
+		}
+
 		return FoundNodes;
 	}
 
@@ -100,10 +149,12 @@ public:
 	{
 		OutRemovedAddresses.Reset();
 
-		FScopeLock Lock(CriticalSection);
+		FWriteScopeLock WriteLock(EntriesLock);
 
 		Entries.GenerateKeyArray(OutRemovedAddresses);
 		Entries.Reset();
+		NodeAddresses.Reset();
+		Generation.fetch_add(1, std::memory_order_release);
 	}
 
 	/**
@@ -117,27 +168,70 @@ public:
 	{
 		OutRemovedAddresses.Reset();
 
-		FScopeLock Lock(CriticalSection);
+		FWriteScopeLock WriteLock(EntriesLock);
 
-		for (const auto& EntryPair : Entries)
+		if (!NodeAddresses.RemoveAndCopyValue(NodeId, OutRemovedAddresses))
 		{
-			if (EntryPair.Value == NodeId)
-			{
-				OutRemovedAddresses.Add(EntryPair.Key);
-			}
+			return;
 		}
 
 		for (const auto& Address : OutRemovedAddresses)
 		{
 			Entries.Remove(Address);
 		}
+
+		Generation.fetch_add(1, std::memory_order_release);
+	}
+
+private:
+
+	/** Removes an address from the index of a node's addresses (the write lock must be held). */
+	void RemoveFromNode(const FGuid& NodeId, const FSGMessageAddress& Address)
+	{
+		if (TArray<FSGMessageAddress>* Addresses = NodeAddresses.Find(NodeId))
+		{
+			Addresses->RemoveSwap(Address);
+
+			if (Addresses->Num() == 0)
+			{
+				NodeAddresses.Remove(NodeId);
+			}
+		}
 	}
 
 private:
 
-	/** Holds a critical section to serialize access to the address book entries. */
-	FCriticalSection* CriticalSection;
+	/** Structure for the nodes of a resolved recipient list. */
+	struct FCachedResolution
+	{
+		/** Holds the generation of the book at the time of resolution (0 = unused). */
+		uint64 Generation = 0;
+
+		/** Holds the resolved recipient list. */
+		TArray<FSGMessageAddress> Addresses;
+
+		/** Holds the nodes of the recipients. */
+		TArray<FGuid> Nodes;
+	};
+
+	/** Number of cached resolutions. */
+	static constexpr uint32 NumCachedResolutions = 64;
+
+	/** Holds a read-write lock that guards the address book entries. */
+	FRWLock EntriesLock;
 
 	/** Holds the collection of known addresses and their remote node identifiers. */
 	TMap<FSGMessageAddress, FGuid> Entries;
+
+	/** Holds the addresses of each remote node. */
+	TMap<FGuid, TArray<FSGMessageAddress>> NodeAddresses;
+
+	/** Holds the generation of the entries, which changes whenever they change. */
+	std::atomic<uint64> Generation;
+
+	/** Holds the recently resolved recipient lists, by hash. */
+	FCachedResolution CachedResolutions[NumCachedResolutions];
+
+	/** Holds a critical section that guards the cached resolutions. */
+	FCriticalSection CacheCriticalSection;
 };
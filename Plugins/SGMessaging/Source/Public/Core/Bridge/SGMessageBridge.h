@@ -2,15 +2,21 @@
 
 #pragma once
 
+#include "Containers/Queue.h"
 #include "Core/Interface/ISGMessageBridge.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 #include "Core/Interface/ISGMessageSender.h"
 #include "Core/Interface/ISGMessageTransportHandler.h"
 #include "Misc/Guid.h"
+#include "Misc/ScopeRWLock.h"
 #include "Templates/SharedPointer.h"
 #include "Core/Bridge/SGMessageAddressBook.h"
+#include "Core/Message/SGMessageProjection.h"
+#include "Core/Message/SGMessageTagBuilder.h"
+#include <atomic>
 
+class FRunnableThread;
 class ISGMessageBus;
 class ISGMessageSubscription;
 class ISGMessageTransport;
@@ -28,6 +34,20 @@ class ISGMessageTransport;
  * sockets or shared memory to communicate with remote bridges. The bridge acts as a map
  * from message addresses to remote nodes and vice versa.
  *
+ * Outbound messages are queued for the bridge's sender thread, so that transport work doesn't
+ * occupy the router thread. The sender thread resolves the remote nodes of the queued messages
+ * and hands runs of messages for the same nodes to the transport in batches.
+ *
+ * Bridges tell each other which message types their local subscribers receive from other processes
+ * (see ISGMessageBus::GetRemoteInterest) when nodes are discovered, when the interest changes and
+ * periodically. Published messages are only transported to the nodes that are interested in them;
+ * nodes that haven't sent their interest yet receive all published messages.
+ *
+ * The interest also carries the projections of the message types whose subscribers only read some
+ * parameters (see ISGMessageBus::GetRemoteProjections). When every node that a dynamic message is
+ * transported to projects its type, the sender thread transports a copy that only holds the union
+ * of the projected parameters.
+ *
  * @see ISGMessageBus, ISGMessageTransport
  */
 class FSGMessageBridge
@@ -90,11 +110,109 @@ protected:
 
 private:
 
+	/**
+	 * Gets the remote nodes that an outbound message is transported to.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutRemoteNodes Will hold the remote nodes (empty = all nodes).
+	 * @param OutProjection Will hold the parameters that the nodes read, if all of them project the message's type (optional).
+	 * @return true if the message should be transported, false if no node should receive it.
+	 */
+	bool GetRemoteNodes(const ISGMessageContext& Context, TArray<FGuid>& OutRemoteNodes, FSGMessageProjection* OutProjection = nullptr) const;
+
+	/**
+	 * Gets the context of an outbound message whose parameters are projected.
+	 *
+	 * @param Context The context of the message.
+	 * @param Projection The parameters that the remote nodes read.
+	 * @return A context with a copy of the message that only holds the projected parameters, or the context itself if there's nothing to leave out.
+	 */
+	TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> ProjectMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageProjection& Projection) const;
+
+	/** Updates the interest of a remote node from its interest message. */
+	void ReceiveInterest(const ISGMessageContext& Context, const FGuid& NodeId);
+
+	/** Sends the local interest to the remote nodes on the sender thread, or right away if there is none. */
+	void RequestInterestUpdate();
+
+	/** Sends the local interest to all remote nodes. */
+	void SendInterest();
+
+	/** Runs the sender thread. */
+	void SendMessages();
+
+	/** Hands the queued outbound messages to the transport. */
+	void FlushOutboundMessages();
+
+	/** Starts the sender thread. */
+	void StartSender();
+
+	/** Stops the sender thread after it flushed the queued messages. */
+	void StopSender();
+
 	/** Callback for message bus shutdowns. */
 	void HandleMessageBusShutdown();
 
+	/** Callback for changes of the bus's remote interest. */
+	void HandleRemoteInterestChanged();
+
 private:
 
+	class FSender;
+
+	/** Structure for the message types that a remote node is interested in. */
+	struct FNodeInterest
+	{
+		/** Holds the subscribed message types. */
+		TSet<FName> MessageTypes;
+
+		/** Holds the subscribed topic ranges. */
+		TArray<FSGMessageTopicRange> TopicRanges;
+
+		/** Holds the parameters that the node's subscribers read, by message type (types whose subscribers all have a projection only). */
+		TMap<FName, FSGMessageProjection> Projections;
+
+		/** Holds a flag indicating whether the node subscribed to all message types. */
+		bool bAllMessageTypes = false;
+
+		/** Gets the projection of a message type, or nullptr if the node reads all of its parameters. */
+		const FSGMessageProjection* FindProjection(const FName& MessageType) const
+		{
+			// subscriptions to all types and topic patterns never have a projection for each type they match
+			if (bAllMessageTypes || (Projections.Num() == 0))
+			{
+				return nullptr;
+			}
+
+			int32 TopicID = 0;
+
+			if ((TopicRanges.Num() > 0) && FSGMessageTagBuilder::TryParseTopicID(MessageType, TopicID) && TopicRanges.ContainsByPredicate([TopicID](const FSGMessageTopicRange& TopicRange) { return TopicRange.Contains(TopicID); }))
+			{
+				return nullptr;
+			}
+
+			return Projections.Find(MessageType);
+		}
+
+		/** Checks whether the node is interested in messages of the given type. */
+		bool Matches(const FName& MessageType) const
+		{
+			if (bAllMessageTypes || MessageTypes.Contains(MessageType))
+			{
+				return true;
+			}
+
+			int32 TopicID = 0;
+
+			if ((TopicRanges.Num() == 0) || !FSGMessageTagBuilder::TryParseTopicID(MessageType, TopicID))
+			{
+				return false;
+			}
+
+			return TopicRanges.ContainsByPredicate([TopicID](const FSGMessageTopicRange& TopicRange) { return TopicRange.Contains(TopicID); });
+		}
+	};
+
 	/** Holds the bridge's address. */
 	FSGMessageAddress Address;
 
@@ -115,4 +233,49 @@ private:
 
 	/** Holds the message transport object. */
 	TSharedPtr<ISGMessageTransport, ESPMode::ThreadSafe> Transport;
+
+	/** Holds the outbound messages waiting for the sender thread. */
+	TQueue<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>, EQueueMode::Mpsc> OutboundMessages;
+
+	/** Holds the number of queued outbound messages. */
+	std::atomic<int32> NumOutboundMessages;
+
+	/** Holds the time at which the oldest queued outbound message was queued (in seconds). */
+	std::atomic<double> FirstOutboundTime;
+
+	/** Holds the largest number of messages handed to the transport in one batch. */
+	int32 MaxBatchSize;
+
+	/** Holds the longest time that a partial batch waits for more messages (in seconds). */
+	double FlushInterval;
+
+	/** Holds a flag indicating that the sender thread is stopping. */
+	std::atomic<bool> bStoppingSender;
+
+	/** Holds the sender thread. */
+	FRunnableThread* SenderThread;
+
+	/** Holds the runnable of the sender thread. */
+	TUniquePtr<FSender> Sender;
+
+	/** Holds an event that wakes up the sender thread. */
+	FEvent* SenderEvent;
+
+	/** Holds the remote nodes that the transport discovered. */
+	TSet<FGuid> KnownNodes;
+
+	/** Holds the interests of the remote nodes that sent them, by node identifier. */
+	TMap<FGuid, FNodeInterest> NodeInterests;
+
+	/** Guards the known nodes and their interests. */
+	mutable FRWLock NodeInterestsLock;
+
+	/** Holds a flag indicating that the sender thread should send the local interest. */
+	std::atomic<bool> bSendInterest;
+
+	/** Holds the time at which the local interest was last sent (sender thread only, in seconds). */
+	double LastInterestTime;
+
+	/** Holds the handle of the remote interest callback. */
+	FDelegateHandle RemoteInterestChangedHandle;
 };
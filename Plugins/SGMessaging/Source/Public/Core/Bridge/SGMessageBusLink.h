@@ -0,0 +1,98 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessageBridge.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Templates/SharedPointer.h"
+#include <atomic>
+
+class ISGMessageBus;
+
+
+/**
+ * Implements an in-process link between two message buses.
+ *
+ * A bus link is a message bridge without a transport. It subscribes to the selected message types
+ * on both buses and forwards the published messages to the other bus, so that subscribers on either
+ * bus receive them. Forwarded messages share the context and the payload of the original message, so
+ * nothing is serialized or copied, which makes links suitable for buses in the same process, such as
+ * the buses of PIE client and server worlds.
+ *
+ * The senders of forwarded messages are registered on the other bus, so that replies and sent messages
+ * find their way back through the link. Messages that the link forwarded before are never forwarded
+ * again, so links don't bounce messages back and forth between their buses. Chains of links are fine,
+ * but links forming a cycle deliver the messages of the cycle twice on the bus where they were sent.
+ *
+ * @see FSGMessageBridge, ISGMessagingModule::CreateBusLink
+ */
+class FSGMessageBusLink
+	: public TSharedFromThis<FSGMessageBusLink, ESPMode::ThreadSafe>
+	, public ISGMessageBridge
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InAddress The address that the link forwards messages with.
+	 * @param InFirstBus The first message bus to link.
+	 * @param InSecondBus The second message bus to link.
+	 * @param InMessageTypes The message types and topic patterns to forward (empty = all types).
+	 * @param InScopeRange The scopes of the published messages to forward.
+	 */
+	FSGMessageBusLink(
+		const FSGMessageAddress InAddress,
+		const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InFirstBus,
+		const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InSecondBus,
+		TArrayView<const FName> InMessageTypes,
+		const FSGMessageScopeRange& InScopeRange
+	);
+
+	/** Virtual destructor. */
+	virtual ~FSGMessageBusLink();
+
+public:
+
+	//~ ISGMessageBridge interface
+
+	virtual void Disable() override;
+	virtual void Enable() override;
+	virtual bool IsEnabled() const override;
+
+private:
+
+	class FSide;
+
+	/**
+	 * Forwards a message that one side of the link received to the bus of the other side.
+	 *
+	 * @param Context The context of the message.
+	 * @param SourceIndex The index of the side that received the message.
+	 */
+	void ForwardMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, int32 SourceIndex);
+
+	/** Checks whether the link forwarded a message before (in any of its hops). */
+	bool WasForwardedByLink(const ISGMessageContext& Context) const;
+
+	/** Callback for shutdowns of either message bus. */
+	void HandleMessageBusShutdown();
+
+private:
+
+	/** Holds the address that the link forwards messages with. */
+	FSGMessageAddress Address;
+
+	/** Holds the message types and topic patterns to forward. */
+	TArray<FName> MessageTypes;
+
+	/** Holds the scopes of the published messages to forward. */
+	FSGMessageScopeRange ScopeRange;
+
+	/** Holds the sides of the link, one per bus. */
+	TSharedPtr<FSide, ESPMode::ThreadSafe> Sides[2];
+
+	/** Holds a flag indicating whether the link is enabled. */
+	std::atomic<bool> bEnabled;
+};
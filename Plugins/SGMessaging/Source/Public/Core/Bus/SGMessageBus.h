@@ -3,6 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Containers/Ticker.h"
+#include "Tasks/Task.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageSubscription.h"
 #include "Core/Interface/ISGMessageAttachment.h"
@@ -10,8 +12,16 @@
 #include "Core/Interface/ISGAuthorizeMessageRecipients.h"
 #include "Core/Interface/ISGMessageTracer.h"
 #include "Core/Interface/ISGMessageBus.h"
+#include "Core/Message/SGMessageTagBuilder.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessageRateLimiter.h"
+#include "Core/Bus/SGMessageRequest.h"
+#include "Core/Bus/SGMessageStatistics.h"
+#include <atomic>
 
 class FSGMessageRouter;
+class FSGMessageCapture;
+class FSGMessageStatistics;
 class ISGMessageReceiver;
 class ISGMessageSender;
 
@@ -39,48 +49,433 @@ public:
 
 	//~ ISGMessageBus interface
 
-	virtual void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Forwarder) override;
+	virtual void CancelDelayedMessage(const FSGDelayedMessageHandle& Handle) override;
+	virtual void DropRequest(const ISGMessageContext& Context) override;
+	virtual void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Forwarder) override;
+	virtual void Redeliver(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, const FTimespan& Delay) override;
 	virtual TSharedRef<ISGMessageTracer, ESPMode::ThreadSafe> GetTracer() override;
 	virtual void Intercept(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType) override;
 	virtual FOnMessageBusShutdown& OnShutdown() override;
-	virtual void Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const TMap<FName, FString>& Annotations, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
-	virtual void Publish(const FName& MessageTag, void* Message, ESGMessageScope Scope,
-	                     const TMap<FName, FString>& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
-	                     const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
+	virtual FOnMessageBusInterestChanged& OnRemoteInterestChanged() override;
+	virtual FSGDelayedMessageHandle Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
+	virtual FSGDelayedMessageHandle Publish(const FName& MessageTag, void* Message, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
+	virtual void PublishBatch(TArrayView<const FSGMessageBatchEntry> Messages, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
+	virtual FSGDelayedMessageHandle SchedulePeriodic(const FName& MessageTag, void* Message, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Interval,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) override;
 	virtual void Register(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient) override;
-	virtual void Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const TMap<FName, FString>& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
-	virtual void Send(const FName& MessageTag,
+	virtual FSGDelayedMessageHandle Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
+	virtual FSGDelayedMessageHandle Send(const FName& MessageTag,
 	                  void* Message,
-	                  const TArray<FSGMessageAddress>& Recipients,
+	                  TArrayView<const FSGMessageAddress> Recipients,
 	                  ESGMessageFlags Flags,
-	                  const TMap<FName, FString>& Annotations,
+	                  const FSGMessageAnnotations& Annotations,
 	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
 	                  const FTimespan& Delay,
 	                  const FDateTime& Expiration,
 	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
+	virtual void SendBatch(TArrayView<const FSGMessageBatchEntry> Messages,
+	                  TArrayView<const FSGMessageAddress> Recipients,
+	                  ESGMessageFlags Flags,
+	                  const FSGMessageAnnotations& Annotations,
+	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	                  const FTimespan& Delay,
+	                  const FDateTime& Expiration,
+	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
+	virtual TFuture<FSGMessageReply> Request(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FTimespan& Timeout, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
+	virtual TFuture<FSGMessageReply> Request(const FName& MessageTag,
+	                  void* Message,
+	                  const FSGMessageAddress& Recipient,
+	                  ESGMessageFlags Flags,
+	                  const FSGMessageAnnotations& Annotations,
+	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	                  const FTimespan& Timeout,
+	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) override;
 	virtual void Shutdown() override;
+	virtual TFuture<void> ShutdownAsync(ESGMessageBusShutdownPolicy Policy) override;
 	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> Subscribe(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const FSGMessageScopeRange& ScopeRange) override;
+	virtual TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> SubscribeMany(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArrayView<const FName> MessageTypes, const FSGMessageScopeRange& ScopeRange) override;
+	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> SubscribeToGroup(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const FName& GroupName, ESGMessageConsumerPolicy Policy, const FSGMessageScopeRange& ScopeRange) override;
+	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> SubscribeFiltered(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe>& Filter, const FName& GroupName, ESGMessageConsumerPolicy Policy, const FSGMessageScopeRange& ScopeRange, const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& Projection) override;
+	virtual void UpdateSpatialInterests(TArrayView<const FSGMessageSpatialInterest> Interests) override;
 	virtual void Unintercept(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType) override;
 	virtual void Unregister(const FSGMessageAddress& Address) override;
+	virtual FSGMessageAddress CreateAddressGroup(const FName& GroupName) override;
+	virtual void AddToAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members) override;
+	virtual void RemoveFromAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members) override;
+	virtual void DestroyAddressGroup(const FSGMessageAddress& Group) override;
 	virtual void Unsubscribe(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType) override;
+	virtual void UnsubscribeMany(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArrayView<const FName> MessageTypes) override;
 
 	virtual void AddNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener) override;
 	virtual void RemoveNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener) override;
 	virtual const FString& GetName() const override;
+	virtual void GetRemoteInterest(TArray<FName>& OutMessageTypes) const override;
+	virtual void GetRemoteProjections(TMap<FName, FSGMessageProjection>& OutProjections) const override;
+	virtual bool IsFrameMode() const override;
+	virtual void ProcessFrame() override;
+
+public:
+
+	/**
+	 * Gets the number of router commands currently waiting to be processed across all router shards.
+	 *
+	 * @return Total command queue depth.
+	 */
+	int32 GetCommandQueueDepth() const;
+
+	/**
+	 * Gets the largest command queue depth any router shard has seen.
+	 *
+	 * @return Command queue high-water mark.
+	 */
+	int32 GetCommandQueueHighWaterMark() const;
+
+	/**
+	 * Gets the number of routed messages all router shards dropped because their command queues were full.
+	 *
+	 * @return Number of dropped messages.
+	 * @see USGMessagingSettings::RouterCommandQueueLimit
+	 */
+	int64 GetNumDroppedMessages() const;
+
+	/**
+	 * Gets a snapshot of the activity counters of all router shards.
+	 *
+	 * @return The summed router counters.
+	 */
+	FSGMessageRouterCounters GetCounters() const;
+
+	/**
+	 * Gets the memory footprint of all router shards and the tracer.
+	 *
+	 * @return The summed memory report.
+	 * @see SGMessaging.MemReport
+	 */
+	FSGMessageMemoryReport GetMemoryReport() const;
+
+	/**
+	 * Gets the message statistics shared by all router shards.
+	 *
+	 * @return The message statistics.
+	 */
+	TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> GetStatistics() const;
+
+	/**
+	 * Gets the capture of the messages routed by all router shards.
+	 *
+	 * @return The message capture.
+	 * @see FSGMessageReplay
+	 */
+	TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> GetCapture() const;
+
+protected:
+
+	/**
+	 * Publishes a message context, either directly on the calling thread or through its router shard.
+	 *
+	 * @param Context The context of the message to publish.
+	 * @param Delay The delay after which the message is sent.
+	 * @return Handle to the delayed message (invalid if the message is not delayed or delayed messaging is disabled).
+	 */
+	FSGDelayedMessageHandle PublishMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FTimespan& Delay);
+
+	/**
+	 * Routes a message context through its router shard.
+	 *
+	 * @param Context The context of the message to route.
+	 * @param Delay The delay after which the message is sent.
+	 * @return Handle to the delayed message (invalid if the message is not delayed or delayed messaging is disabled).
+	 */
+	FSGDelayedMessageHandle RouteMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FTimespan& Delay);
+
+	/**
+	 * Creates the contexts of a batch of tagged messages and routes them with one command per router shard.
+	 *
+	 * @see PublishBatch, SendBatch
+	 */
+	void RouteBatch(TArrayView<const FSGMessageBatchEntry> Messages, TArrayView<const FSGMessageAddress> Recipients, ESGMessageScope Scope, ESGMessageFlags Flags,
+		const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FTimespan& Delay, const FDateTime& Expiration, const FSGMessageAddress& Sender);
+
+	/**
+	 * Checks whether a message of a sender is within the rate limits.
+	 *
+	 * @param Sender The address of the sender.
+	 * @param MessageType The type (or tag) of the message.
+	 * @return true if the message may be routed, false if it must be dropped.
+	 * @see DiscardRateLimitedMessage
+	 */
+	FORCEINLINE bool IsWithinRateLimits(const FSGMessageAddress& Sender, const FName& MessageType)
+	{
+		return !RateLimiter.IsEnabled() || RateLimiter.TryAcquire(Sender, MessageType);
+	}
+
+	/**
+	 * Destroys a message that exceeded a rate limit before it got a context.
+	 *
+	 * @param Message The message to destroy.
+	 * @param TypeInfo The type information of a struct message (nullptr = tagged message).
+	 * @param MessageType The type (or tag) of the message.
+	 * @see IsWithinRateLimits
+	 */
+	void DiscardRateLimitedMessage(void* Message, UScriptStruct* TypeInfo, const FName& MessageType);
+
+	/**
+	 * Destroys a message that the bus took over but rejected before it got a context.
+	 *
+	 * @param Message The message to destroy.
+	 * @param TypeInfo The type information of a struct message (nullptr = tagged message).
+	 * @see DiscardRateLimitedMessage
+	 */
+	static void DestroyMessage(void* Message, UScriptStruct* TypeInfo);
+
+	/**
+	 * Adds a pending request and the correlation identifier annotation of its message.
+	 *
+	 * The request is owned by the router shard of the request message, and the shard index is part of the
+	 * correlation identifier, so that the reply is routed to the same shard whatever its type is.
+	 *
+	 * @param MessageType The type of the request message.
+	 * @param Timeout The time after which the request times out (zero = never).
+	 * @param InOutAnnotations The annotations of the request message.
+	 * @return The pending request.
+	 * @see Request
+	 */
+	TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> AddPendingRequest(const FName& MessageType, const FTimespan& Timeout, FSGMessageAnnotations& InOutAnnotations);
+
+	/**
+	 * Gets the index of the router shard that routes the given message.
+	 *
+	 * Replies are routed to the shard that owns their request, all other messages to the shard of their type.
+	 *
+	 * @param Context The context of the message.
+	 * @return The router shard index.
+	 */
+	int32 GetRouterIndex(const ISGMessageContext& Context) const;
+
+	/**
+	 * Adds a message identifier to the annotations of a message whose duplicates are dropped.
+	 *
+	 * The identifier travels with the message, so copies that are resent by bridges or retried by tools are
+	 * recognized by the routers. Messages that have an identifier already keep it.
+	 *
+	 * @param Annotations The annotations of the message.
+	 * @param Flags The flags of the message.
+	 * @param Sender The address of the sender.
+	 * @return The annotations, with the identifier if the message has ESGMessageFlags::Deduplicate.
+	 * @see SGMessageDeduplication
+	 */
+	FSGMessageAnnotations WithMessageId(const FSGMessageAnnotations& Annotations, ESGMessageFlags Flags, const FSGMessageAddress& Sender);
+
+	/**
+	 * Gets the router shard responsible for the given message type.
+	 *
+	 * @param MessageType The type of message to get the router for.
+	 * @return The router shard.
+	 */
+	FORCEINLINE FSGMessageRouter* GetRouter(const FName& MessageType) const
+	{
+		return Routers[GetRouterIndex(MessageType)];
+	}
+
+	/**
+	 * Gets the index of the router shard responsible for the given message type.
+	 *
+	 * @param MessageType The type of message to get the router index for.
+	 * @return The router shard index.
+	 */
+	FORCEINLINE int32 GetRouterIndex(const FName& MessageType) const
+	{
+		return (Routers.Num() == 1) ? 0 : (int32)(GetTypeHash(MessageType) % (uint32)Routers.Num());
+	}
+
+	/**
+	 * Gets the router shard that owns bus-wide state such as registration listeners.
+	 *
+	 * @return The primary router shard.
+	 */
+	FORCEINLINE FSGMessageRouter* GetPrimaryRouter() const
+	{
+		return Routers[0];
+	}
+
+	/**
+	 * Checks whether subscriptions to the given message type must be added to all router shards.
+	 *
+	 * This is the case for NAME_All and for topic patterns, which match messages of many types.
+	 *
+	 * @param MessageType The subscribed message type or topic pattern.
+	 * @return true if the subscription spans multiple message types, false otherwise.
+	 */
+	bool IsBroadcastSubscription(const FName& MessageType) const
+	{
+		if (MessageType == NAME_All)
+		{
+			return true;
+		}
+
+		FSGMessageTopicRange TopicRange;
+
+		return (Routers.Num() > 1) && FSGMessageTagBuilder::TryParseTopicPattern(MessageType, TopicRange);
+	}
+
+	/**
+	 * Counts a subscription of a local subscriber that receives messages from other processes.
+	 *
+	 * @param Subscriber The subscriber.
+	 * @param MessageType The subscribed message type or topic pattern.
+	 * @param ScopeRange The scope range of the subscription.
+	 * @param Projection The parameters that the subscriber reads (nullptr = all parameters).
+	 * @see RemoveRemoteInterest
+	 */
+	void AddRemoteInterest(const ISGMessageReceiver& Subscriber, const FName& MessageType, const FSGMessageScopeRange& ScopeRange, const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& Projection = nullptr);
+
+	/**
+	 * Removes the subscriptions of a subscriber from the remote interest.
+	 *
+	 * @param Subscriber The subscriber.
+	 * @param MessageType The unsubscribed message type (NAME_All = all types).
+	 * @see AddRemoteInterest
+	 */
+	void RemoveRemoteInterest(const ISGMessageReceiver& Subscriber, const FName& MessageType);
+
+	/**
+	 * Stops accepting messages and tells the routers to stop.
+	 *
+	 * @param Policy What to do with the messages that are queued.
+	 * @return true if the shutdown began, false if the bus was already shut down.
+	 * @see FinishShutdown
+	 */
+	bool BeginShutdown(ESGMessageBusShutdownPolicy Policy);
+
+	/**
+	 * Waits for the router threads to exit and closes the capture file.
+	 *
+	 * @param Threads The router threads to join.
+	 * @see BeginShutdown
+	 */
+	void FinishShutdown(TArray<FRunnableThread*> Threads);
+
+	/**
+	 * Publishes the live bus counters to the stat system and the CSV profiler.
+	 *
+	 * @param DeltaTime The time since the last tick (in seconds).
+	 * @return Always true, so the ticker keeps calling it.
+	 */
+	bool TickCounters(float DeltaTime);
+
+	/**
+	 * Pumps a frame mode bus that its owner didn't pump in this or the previous frame.
+	 *
+	 * Only world subsystems pump their buses, so other frame mode buses, i.e. the ones created with
+	 * ISGMessagingModule::CreateBus, are pumped from the core ticker instead.
+	 *
+	 * @param DeltaTime The time since the last tick (in seconds).
+	 * @return Always true, so the ticker keeps calling it.
+	 */
+	bool TickUnpumpedFrame(float DeltaTime);
+
+	/** Routes queued messages within the frame budget (frame mode only). */
+	void RouteFrame();
 
 private:
 	/** The message bus debugging name. */
 	const FString Name;
 
-	/** Holds the message router. */
-	FSGMessageRouter* Router;
+	/** Holds the message router shards. */
+	TArray<FSGMessageRouter*> Routers;
+
+	/** Holds the started message router threads once the bus shuts down (routers own them until then). */
+	TArray<FRunnableThread*> RouterThreads;
+
+	/** Holds a flag indicating whether the routers are pumped per frame. */
+	bool bFrameMode;
+
+	/** Holds a flag indicating whether the routers run on the shared router pool. */
+	bool bPooled;
+
+	/** Holds a flag indicating whether the shutdown routes the queued commands. */
+	bool bDrainOnShutdown;
+
+	/** Holds a flag indicating whether the bus has been shut down. */
+	std::atomic<bool> bIsShutDown;
+
+	/** Holds the next message identifier (starts at the creation time, so that restarted processes don't reuse identifiers). */
+	std::atomic<uint64> NextMessageId;
 
-	/** Holds the message router thread. */
-	FRunnableThread* RouterThread;
+	/** Holds the task that joins the router threads after an asynchronous shutdown. */
+	UE::Tasks::FTask ShutdownTask;
+
+	/** Holds the frame mode time budget (in seconds, 0 = unlimited). */
+	double FrameTimeBudget;
+
+	/** Holds the frame mode command budget (0 = unlimited). */
+	int32 FrameCommandBudget;
+
+	/** Holds the index of the router shard that is pumped first in the next frame. */
+	int32 NextFrameRouterIndex;
+
+	/** Holds the frame in which the owner of the bus last called ProcessFrame (game thread only). */
+	uint64 LastPumpedFrame = 0;
+
+	/** Holds the rate limits of the senders and message types. */
+	FSGMessageRateLimiter RateLimiter;
 
 	/** Holds the recipient authorizer. */
 	TSharedPtr<ISGAuthorizeMessageRecipients> RecipientAuthorizer;
 
 	/** Holds bus shutdown delegate. */
 	FOnMessageBusShutdown ShutdownDelegate;
+
+	/** Holds the delegate that is executed when the remote interest changes. */
+	FOnMessageBusInterestChanged RemoteInterestChangedDelegate;
+
+	/** Holds the number of local subscriptions that receive messages from other processes, by message type. */
+	TMap<FName, int32> RemoteInterest;
+
+	/** Holds the number of counted subscriptions with a projection, by message type. */
+	TMap<FName, int32> RemoteProjectedInterest;
+
+	/** Holds the counted message types of each local subscriber and their projections, by recipient identifier. */
+	TMap<FGuid, TMap<FName, TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>>> RemoteInterestSubscriptions;
+
+	/** Guards the remote interest. */
+	mutable FCriticalSection RemoteInterestCriticalSection;
+
+	/** Holds the handle of the ticker that publishes the live counters. */
+	FTSTicker::FDelegateHandle CountersTickerHandle;
+
+	/** Holds the handle of the ticker that pumps the bus if its owner doesn't (frame mode only). */
+	FTSTicker::FDelegateHandle FrameTickerHandle;
+
+	/** Holds the router counters at the previous counters tick. */
+	FSGMessageRouterCounters LastCounters;
+
+	/** Holds the number of dropped messages at the previous counters tick. */
+	int64 LastNumDroppedMessages;
+
+	/** Holds the number of expired messages at the previous counters tick. */
+	int64 LastNumExpiredMessages;
+
+	/** Holds the number of rate limited messages at the previous counters tick. */
+	int64 LastNumRateLimitedMessages;
+
+	/** Holds the time of the previous counters tick (in CPU cycles). */
+	uint64 LastCountersCycles;
+
+	/** Holds the names of the CSV profiler stats of this bus. */
+	FName CsvRoutedPerSecName;
+	FName CsvCommandsPerSecName;
+	FName CsvRouterBusyName;
+	FName CsvCommandQueueDepthName;
+	FName CsvDelayedMessagesName;
+	FName CsvDispatchTasksName;
+	FName CsvInboxDepthName;
+	FName CsvDroppedMessagesName;
+	FName CsvExpiredMessagesName;
+	FName CsvRateLimitedMessagesName;
 };
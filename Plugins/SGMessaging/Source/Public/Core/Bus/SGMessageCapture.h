@@ -0,0 +1,279 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/Runnable.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include <atomic>
+
+class FArchive;
+class FRunnableThread;
+
+
+/**
+ * Enumerates the versions of the message capture format.
+ */
+enum class ESGMessageCaptureVersion : uint8
+{
+	Initial = 1,
+
+	// -----<new versions can be added above this line>-----
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1
+};
+
+
+/**
+ * Enumerates the formats of captured message payloads.
+ */
+enum class ESGCapturedPayloadFormat : uint8
+{
+	/** The payload couldn't be captured (e.g. typed messages), the message is not replayed. */
+	None,
+
+	/** The payload is a structure written with the binary struct serializer. */
+	Struct,
+
+	/** The payload is a dynamic message in the binary message encoding (see FSGMessageSerializer). */
+	Message
+};
+
+
+/**
+ * Structure for a message in a capture file.
+ *
+ * Times are in seconds since the capture was started.
+ */
+struct FSGCapturedMessage
+{
+	/** Holds the time at which the message was sent. */
+	double TimeSent = 0.0;
+
+	/** Holds the time at which the message was routed. */
+	double TimeRouted = 0.0;
+
+	/** Holds the time to live of the message (negative if the message doesn't expire). */
+	double TimeToLive = -1.0;
+
+	/** Holds the message type (the tag of tagged messages). */
+	FName MessageType;
+
+	/** Holds the path name of the message's structure (empty for tagged messages). */
+	FString TypeInfoPath;
+
+	/** Holds the sender's address. */
+	FSGMessageAddress Sender;
+
+	/** Holds the recipients' addresses (empty for published messages). */
+	TArray<FSGMessageAddress> Recipients;
+
+	/** Holds the message scope. */
+	ESGMessageScope Scope = ESGMessageScope::All;
+
+	/** Holds the message flags. */
+	ESGMessageFlags Flags = ESGMessageFlags::None;
+
+	/** Holds the message annotations. */
+	TMap<FName, FString> Annotations;
+
+	/** Holds the format of the payload. */
+	ESGCapturedPayloadFormat PayloadFormat = ESGCapturedPayloadFormat::None;
+
+	/** Holds the serialized payload. */
+	TArray<uint8> Payload;
+
+public:
+
+	friend FArchive& operator<<(FArchive& Ar, FSGCapturedMessage& Message)
+	{
+		uint8 Scope = (uint8)Message.Scope;
+		uint32 Flags = (uint32)Message.Flags;
+		uint8 PayloadFormat = (uint8)Message.PayloadFormat;
+
+		Ar << Message.TimeSent << Message.TimeRouted << Message.TimeToLive << Message.MessageType << Message.TypeInfoPath
+			<< Message.Sender << Message.Recipients << Scope << Flags << Message.Annotations << PayloadFormat << Message.Payload;
+
+		if (Ar.IsLoading())
+		{
+			Message.Scope = (ESGMessageScope)Scope;
+			Message.Flags = (ESGMessageFlags)Flags;
+			Message.PayloadFormat = (ESGCapturedPayloadFormat)PayloadFormat;
+		}
+
+		return Ar;
+	}
+};
+
+
+/**
+ * Implements a capture of the messages that a message bus routes.
+ *
+ * While capturing, the router shards only queue the contexts of routed messages. A writer thread
+ * serializes them and streams them to the capture file, so the router threads don't pay for the
+ * serialization or the file access. If the writer falls behind by more than
+ * USGMessagingSettings::CaptureMaxPendingMessages, further messages are dropped from the capture.
+ *
+ * Structure messages are captured with the binary struct serializer (object references are not
+ * captured) and dynamic messages with the binary message encoding. Forwarded messages, attachments
+ * and the payloads of typed messages are not captured. Captures are replayed with FSGMessageReplay.
+ *
+ * All router shards of a bus share the same capture.
+ *
+ * @see FSGMessageReplay
+ */
+class SGMESSAGING_API FSGMessageCapture
+	: public FRunnable
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageCapture();
+
+	/** Destructor. */
+	virtual ~FSGMessageCapture();
+
+public:
+
+	/**
+	 * Starts capturing routed messages to a file.
+	 *
+	 * @param Filename The name of the capture file (it is overwritten).
+	 * @return true if the capture was started, false if a capture is running or the file can't be created.
+	 * @see StopCapture
+	 */
+	bool StartCapture(const FString& Filename);
+
+	/**
+	 * Stops capturing, writes the pending messages and closes the capture file.
+	 *
+	 * @see StartCapture
+	 */
+	void StopCapture();
+
+	/**
+	 * Checks whether messages are being captured.
+	 *
+	 * @return true if capturing, false otherwise.
+	 */
+	bool IsCapturing() const
+	{
+		return bCapturing.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Captures a routed message if a capture is running.
+	 *
+	 * Called by the router shards.
+	 *
+	 * @param Context The context of the routed message.
+	 */
+	FORCEINLINE void CaptureMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		if (bCapturing.load(std::memory_order_relaxed))
+		{
+			EnqueueMessage(Context);
+		}
+	}
+
+	/** Gets the number of messages written to the current or last capture file. */
+	int64 GetNumCapturedMessages() const
+	{
+		return NumCapturedMessages.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of messages that the current or last capture dropped because the writer fell behind. */
+	int64 GetNumDroppedMessages() const
+	{
+		return NumDroppedMessages.load(std::memory_order_relaxed);
+	}
+
+public:
+
+	/**
+	 * Loads the messages of a capture file.
+	 *
+	 * @param Filename The name of the capture file.
+	 * @param OutMessages Will hold the captured messages (in the order they were routed).
+	 * @return true if the file was loaded, false if it can't be read or isn't a capture file.
+	 */
+	static bool LoadCapture(const FString& Filename, TArray<FSGCapturedMessage>& OutMessages);
+
+	/**
+	 * Converts a message to its capture record.
+	 *
+	 * @param Context The context of the message.
+	 * @param BaseTime The time that the record's times are relative to (in seconds, see FSGMessageClock).
+	 * @param TimeRouted The time at which the message was routed (in seconds, see FSGMessageClock).
+	 * @param OutRecord Will hold the record.
+	 */
+	static void MakeRecord(const ISGMessageContext& Context, double BaseTime, double TimeRouted, FSGCapturedMessage& OutRecord);
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	/** Structure for a routed message that wasn't written yet. */
+	struct FPendingMessage
+	{
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+		double TimeRouted;
+	};
+
+	/** Queues a routed message for the writer thread. */
+	void EnqueueMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/** Writes the queued messages to the capture file. */
+	void WritePendingMessages();
+
+private:
+
+	/** Identifies capture files. */
+	static constexpr uint32 FileMagic = 0x434D4753;
+
+	/** Holds a flag indicating that routed messages are captured. */
+	std::atomic<bool> bCapturing;
+
+	/** Holds a flag indicating that the writer thread is stopping. */
+	std::atomic<bool> bStopping;
+
+	/** Holds the routed messages that weren't written yet. */
+	TQueue<FPendingMessage, EQueueMode::Mpsc> PendingMessages;
+
+	/** Holds the number of queued messages. */
+	std::atomic<int32> NumPendingMessages;
+
+	/** Holds the maximum number of queued messages. */
+	int32 MaxPendingMessages;
+
+	/** Holds the number of written messages. */
+	std::atomic<int64> NumCapturedMessages;
+
+	/** Holds the number of dropped messages. */
+	std::atomic<int64> NumDroppedMessages;
+
+	/** Holds the time at which the capture was started. */
+	double StartTime;
+
+	/** Holds the capture file (only used by the writer thread while it runs). */
+	FArchive* FileWriter;
+
+	/** Holds a buffer for serializing records. */
+	TArray<uint8> RecordBuffer;
+
+	/** Holds the writer thread. */
+	FRunnableThread* WriterThread;
+
+	/** Holds an event that wakes up the writer thread when it stops. */
+	FEvent* WorkEvent;
+
+	/** Guards starting and stopping captures. */
+	FCriticalSection CriticalSection;
+};
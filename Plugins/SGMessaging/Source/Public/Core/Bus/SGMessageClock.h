@@ -0,0 +1,89 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformTime.h"
+
+/**
+ * Implements the monotonic clock of the messaging system.
+ *
+ * Send, routing, delay and trace timestamps are all taken from the CPU cycle counter, which is
+ * cheaper than reading the wall clock and doesn't jump when the system time changes. UTC times
+ * that the API exposes (i.e. ISGMessageContext.GetTimeSent) are derived from the cycle counter and
+ * the UTC time at which the clock started, so they can be compared with each other but may drift
+ * from FDateTime::UtcNow() by however much the system time was changed since then.
+ */
+class SGMESSAGING_API FSGMessageClock
+{
+public:
+	/** Gets the current cycle count. */
+	static uint64 Cycles()
+	{
+		return FPlatformTime::Cycles64();
+	}
+
+	/** Gets the current time in seconds. */
+	static double Seconds()
+	{
+		return ToSeconds(Cycles());
+	}
+
+	/** Gets the current time in milliseconds (i.e. for the timing wheel). */
+	static uint64 Milliseconds()
+	{
+		return (uint64)(ToSeconds(Cycles()) * 1000.0);
+	}
+
+	/**
+	 * Converts a cycle count to seconds.
+	 *
+	 * @param InCycles The cycle count.
+	 * @return The time in seconds.
+	 */
+	static double ToSeconds(uint64 InCycles)
+	{
+		return InCycles * FPlatformTime::GetSecondsPerCycle64();
+	}
+
+	/** Gets the current UTC time without reading the wall clock. */
+	static FDateTime UtcNow()
+	{
+		return ToDateTime(Cycles());
+	}
+
+	/**
+	 * Converts a cycle count to UTC time.
+	 *
+	 * @param InCycles The cycle count.
+	 * @return The UTC time.
+	 */
+	static FDateTime ToDateTime(uint64 InCycles);
+
+	/**
+	 * Converts a UTC time to the clock's seconds, so that it can be compared with trace timestamps.
+	 *
+	 * @param Time The UTC time.
+	 * @return The time in seconds.
+	 */
+	static double ToSeconds(const FDateTime& Time);
+
+private:
+	/** Structure for the UTC time at which the clock started. */
+	struct FAnchor
+	{
+		/** The cycle count when the clock started. */
+		uint64 Cycles;
+
+		/** The UTC time when the clock started. */
+		FDateTime UtcTime;
+
+		FAnchor()
+			: Cycles(FPlatformTime::Cycles64())
+			, UtcTime(FDateTime::UtcNow())
+		{ }
+	};
+
+	/** Gets the anchor, which is taken the first time the clock is used. */
+	static const FAnchor& GetAnchor();
+};
@@ -0,0 +1,165 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+/**
+ * Implements a bounded, lock-free multiple-producer single-consumer ring buffer.
+ *
+ * Every slot carries a sequence number that tells producers and the consumer whether
+ * the slot is free or holds a published element, so neither side needs a lock and
+ * no memory is allocated after construction. The producer and consumer cursors live
+ * on separate cache lines to avoid false sharing between the publishing threads and
+ * the thread that drains the ring.
+ *
+ * @param ElementType The type of elements held in the ring (must be default constructible and movable).
+ */
+template<typename ElementType>
+class TSGMessageCommandRing
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InCapacity The minimum number of elements the ring can hold (rounded up to a power of two).
+	 */
+	explicit TSGMessageCommandRing(uint32 InCapacity)
+		: Capacity(FMath::RoundUpToPowerOfTwo(FMath::Max<uint32>(InCapacity, 2)))
+		, Mask(Capacity - 1)
+		, DequeuePos(0)
+	{
+		Slots = new FSlot[Capacity];
+
+		for (uint32 SlotIndex = 0; SlotIndex < Capacity; ++SlotIndex)
+		{
+			Slots[SlotIndex].Sequence.store(SlotIndex, std::memory_order_relaxed);
+		}
+
+		EnqueuePos.store(0, std::memory_order_relaxed);
+	}
+
+	/** Destructor. */
+	~TSGMessageCommandRing()
+	{
+		delete[] Slots;
+	}
+
+	TSGMessageCommandRing(const TSGMessageCommandRing&) = delete;
+	TSGMessageCommandRing& operator=(const TSGMessageCommandRing&) = delete;
+
+public:
+
+	/**
+	 * Attempts to add an element to the ring.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Element The element to add (will be moved from on success).
+	 * @return true if the element was added, false if the ring is full.
+	 */
+	bool TryEnqueue(ElementType&& Element)
+	{
+		uint32 Pos = EnqueuePos.load(std::memory_order_relaxed);
+
+		for (;;)
+		{
+			FSlot& Slot = Slots[Pos & Mask];
+			const uint32 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+			const int32 Difference = (int32)(Sequence - Pos);
+
+			if (Difference == 0)
+			{
+				if (EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+				{
+					Slot.Element = MoveTemp(Element);
+					Slot.Sequence.store(Pos + 1, std::memory_order_release);
+
+					return true;
+				}
+			}
+			else if (Difference < 0)
+			{
+				return false;
+			}
+			else
+			{
+				Pos = EnqueuePos.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	/**
+	 * Attempts to remove the oldest element from the ring.
+	 *
+	 * This method must only be called from the consuming thread.
+	 *
+	 * @param OutElement Will hold the removed element.
+	 * @return true if an element was removed, false if the ring is empty.
+	 */
+	bool TryDequeue(ElementType& OutElement)
+	{
+		FSlot& Slot = Slots[DequeuePos & Mask];
+		const uint32 Sequence = Slot.Sequence.load(std::memory_order_acquire);
+
+		if ((int32)(Sequence - (DequeuePos + 1)) < 0)
+		{
+			return false;
+		}
+
+		OutElement = MoveTemp(Slot.Element);
+		Slot.Sequence.store(DequeuePos + Capacity, std::memory_order_release);
+		++DequeuePos;
+
+		return true;
+	}
+
+	/**
+	 * Gets the number of elements the ring can hold.
+	 *
+	 * @return Ring capacity.
+	 */
+	uint32 GetCapacity() const
+	{
+		return Capacity;
+	}
+
+	/**
+	 * Gets the size of the memory allocated by the ring.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return (SIZE_T)Capacity * sizeof(FSlot);
+	}
+
+private:
+
+	/** A single ring slot. */
+	struct FSlot
+	{
+		/** Holds the slot's sequence number. */
+		std::atomic<uint32> Sequence;
+
+		/** Holds the element stored in this slot. */
+		ElementType Element;
+	};
+
+	/** Holds the ring capacity (always a power of two). */
+	const uint32 Capacity;
+
+	/** Holds the mask used to map positions to slots. */
+	const uint32 Mask;
+
+	/** Holds the ring slots. */
+	FSlot* Slots;
+
+	/** Holds the producer cursor. */
+	alignas(PLATFORM_CACHE_LINE_SIZE) std::atomic<uint32> EnqueuePos;
+
+	/** Holds the consumer cursor (only accessed by the consuming thread). */
+	alignas(PLATFORM_CACHE_LINE_SIZE) uint32 DequeuePos;
+};
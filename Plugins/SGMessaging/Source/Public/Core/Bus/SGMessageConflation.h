@@ -0,0 +1,148 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+/**
+ * Structure for the keys that conflated messages replace each other by.
+ *
+ * A newer undelivered message replaces an older one if both have the same key. The key is made of the
+ * message type and either the user key from the message annotations or, if there is none, the sender.
+ */
+struct FSGMessageConflationKey
+{
+	/** Holds the message type. */
+	FName MessageType;
+
+	/** Holds the sender of the message (only if there is no user key). */
+	FSGMessageAddress Sender;
+
+	/** Holds the user key from the message annotations. */
+	FString UserKey;
+
+	/** Compares two conflation keys for equality. */
+	friend bool operator==(const FSGMessageConflationKey& X, const FSGMessageConflationKey& Y)
+	{
+		return (X.MessageType == Y.MessageType) && (X.Sender == Y.Sender) && (X.UserKey == Y.UserKey);
+	}
+
+	/** Gets the hash for the specified conflation key. */
+	friend uint32 GetTypeHash(const FSGMessageConflationKey& Key)
+	{
+		return HashCombine(GetTypeHash(Key.MessageType), Key.UserKey.IsEmpty() ? GetTypeHash(Key.Sender) : GetTypeHash(Key.UserKey));
+	}
+};
+
+
+namespace SGMessageConflation
+{
+	/** Name of the message annotation that holds a user conflation key. */
+	static const FName ConflationKeyAnnotation(TEXT("SGConflationKey"));
+
+	/**
+	 * Gets the conflation key of a message.
+	 *
+	 * Messages are conflated if they were sent with ESGMessageFlags::Conflate, or if their type is
+	 * listed in USGMessagingSettings::ConflatedMessageTypes.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutKey Will hold the conflation key.
+	 * @return true if the message is conflated, false otherwise.
+	 */
+	inline bool GetConflationKey(const ISGMessageContext& Context, FSGMessageConflationKey& OutKey)
+	{
+		if (!EnumHasAnyFlags(Context.GetFlags(), ESGMessageFlags::Conflate))
+		{
+			const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+
+			if ((SGMessagingSettings == nullptr) || (SGMessagingSettings->ConflatedMessageTypes.Num() == 0) || !SGMessagingSettings->ConflatedMessageTypes.Contains(Context.GetMessageType()))
+			{
+				return false;
+			}
+		}
+
+		OutKey.MessageType = Context.GetMessageType();
+
+		if (const FString* UserKey = Context.GetAnnotations().Find(ConflationKeyAnnotation))
+		{
+			OutKey.Sender.Invalidate();
+			OutKey.UserKey = *UserKey;
+		}
+		else
+		{
+			OutKey.Sender = Context.GetSender();
+			OutKey.UserKey.Reset();
+		}
+
+		return true;
+	}
+}
+
+
+/**
+ * Implements a slot that holds the latest undelivered message of a conflation key.
+ *
+ * The router stores messages into the slot, and only schedules a delivery when the slot was empty.
+ * The delivery takes whatever message is in the slot when it runs, so the number of pending deliveries
+ * is bounded by the number of distinct keys rather than the number of messages.
+ *
+ * This class is thread-safe.
+ */
+class FSGMessageConflationSlot
+{
+public:
+
+	/**
+	 * Stores a message, replacing the undelivered message, if any.
+	 *
+	 * @param Context The context of the message to store.
+	 * @return true if the slot was empty and a delivery must be scheduled, false if a message was replaced.
+	 */
+	bool Store(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		const bool bWasEmpty = !LatestContext.IsValid();
+		LatestContext = Context;
+
+		return bWasEmpty;
+	}
+
+	/**
+	 * Takes the latest message out of the slot.
+	 *
+	 * @return The message context, or nullptr if the slot is empty.
+	 */
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Take()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		return MoveTemp(LatestContext);
+	}
+
+	/**
+	 * Checks whether the slot is empty.
+	 *
+	 * @return true if there is no undelivered message, false otherwise.
+	 */
+	bool IsEmpty() const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		return !LatestContext.IsValid();
+	}
+
+private:
+
+	/** Guards the message context. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Holds the latest undelivered message. */
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> LatestContext;
+};
@@ -0,0 +1,199 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageTypeRegistry.h"
+
+
+/**
+ * Implements a content filter that the router applies to the published messages of a subscription.
+ *
+ * Messages that don't match the filter are skipped on the router thread together with the scope and
+ * thread filters, so they are never queued to the subscriber. A filter is a conjunction of conditions:
+ *
+ *		FSGMessageContentFilter Filter;
+ *		Filter.WhereAnnotation(TEXT("Team"), TEXT("Red")).WhereAnnotation(TEXT("Team"), TEXT("Blue"));	// Team is Red or Blue
+ *		Filter.WhereParam<int32>(TEXT("TeamId"), 3);														// and the TeamId parameter is 3
+ *
+ *		Endpoint->SetContentFilter(MessageTag, Filter);
+ *
+ * Conditions run on the router thread for every matching message, so they should be cheap and must be
+ * thread-safe. Filters are immutable once they are attached to a subscription.
+ *
+ * @see FSGMessageEndpoint::SetContentFilter, ISGMessageBus::SubscribeFiltered
+ */
+class FSGMessageContentFilter
+{
+public:
+
+	/**
+	 * Adds an allowed value for an annotation.
+	 *
+	 * The values of the same annotation are alternatives, the message must carry one of them.
+	 *
+	 * @param Key The annotation key.
+	 * @param Value The allowed value.
+	 * @return This instance (for method chaining).
+	 */
+	FSGMessageContentFilter& WhereAnnotation(const FName& Key, const FString& Value)
+	{
+		FAnnotationCondition* Condition = AnnotationConditions.FindByPredicate([&Key](const FAnnotationCondition& Candidate) { return Candidate.Key == Key; });
+
+		if (Condition == nullptr)
+		{
+			Condition = &AnnotationConditions.AddDefaulted_GetRef();
+			Condition->Key = Key;
+		}
+
+		Condition->Values.AddUnique(Value);
+
+		return *this;
+	}
+
+	/**
+	 * Adds a condition on a parameter of dynamic messages (see FSGMessage).
+	 *
+	 * Messages without the parameter, with a parameter of another type, and messages that aren't
+	 * dynamic messages don't match.
+	 *
+	 * @param Key The parameter key.
+	 * @param Value The value that the parameter must be equal to.
+	 * @return This instance (for method chaining).
+	 */
+	template<typename T>
+	FSGMessageContentFilter& WhereParam(const FSGMessageKey& Key, const T& Value)
+	{
+		MessageConditions.Add([Key, Value](const FSGMessage& Message)
+		{
+			const T* Param = Message.Find<T>(Key);
+
+			return (Param != nullptr) && (*Param == Value);
+		});
+
+		return *this;
+	}
+
+	/**
+	 * Adds a condition on the payload of typed messages of the given structure.
+	 *
+	 * Messages of other types don't match.
+	 *
+	 * @param Predicate The function that checks the payload.
+	 * @return This instance (for method chaining).
+	 */
+	template<typename StructType>
+	FSGMessageContentFilter& WhereStruct(TFunction<bool(const StructType&)>&& Predicate)
+	{
+		ContextConditions.Add([Predicate = MoveTemp(Predicate)](const ISGMessageContext& Context)
+		{
+			return (Context.GetMessageTypeId() == TSGMessageType<StructType>::GetId()) && Predicate(*static_cast<const StructType*>(Context.GetMessage()));
+		});
+
+		return *this;
+	}
+
+public:
+
+	/**
+	 * Checks whether a message matches the filter.
+	 *
+	 * @param Context The context of the message.
+	 * @return true if the message matches all conditions, false otherwise.
+	 */
+	bool Matches(const ISGMessageContext& Context) const
+	{
+		// annotations don't need the payload, so check them first
+		if (AnnotationConditions.Num() > 0)
+		{
+			const FSGMessageAnnotations& Annotations = Context.GetAnnotations();
+
+			for (const FAnnotationCondition& Condition : AnnotationConditions)
+			{
+				const FString* Value = Annotations.Find(Condition.Key);
+
+				if ((Value == nullptr) || !Condition.Values.Contains(*Value))
+				{
+					return false;
+				}
+			}
+		}
+
+		if (MessageConditions.Num() > 0)
+		{
+			const FSGMessage* Message = GetDynamicMessage(Context);
+
+			if (Message == nullptr)
+			{
+				return false;
+			}
+
+			for (const TFunction<bool(const FSGMessage&)>& Condition : MessageConditions)
+			{
+				if (!Condition(*Message))
+				{
+					return false;
+				}
+			}
+		}
+
+		for (const TFunction<bool(const ISGMessageContext&)>& Condition : ContextConditions)
+		{
+			if (!Condition(Context))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	/**
+	 * Checks whether the filter has no conditions.
+	 *
+	 * @return true if every message matches, false otherwise.
+	 */
+	bool IsEmpty() const
+	{
+		return (AnnotationConditions.Num() == 0) && (MessageConditions.Num() == 0) && (ContextConditions.Num() == 0);
+	}
+
+private:
+
+	/** Gets the dynamic message of a context, or nullptr if it holds a typed message. */
+	static const FSGMessage* GetDynamicMessage(const ISGMessageContext& Context)
+	{
+		const ISGMessage* Message = Context.GetTaggedMessage();
+
+		if ((Message == nullptr) || (Message->GetFName() != FSGMessage::StaticMessageName()))
+		{
+			return nullptr;
+		}
+
+		return static_cast<const FSGMessage*>(Message);
+	}
+
+private:
+
+	/** Structure for the allowed values of an annotation. */
+	struct FAnnotationCondition
+	{
+		/** Holds the annotation key. */
+		FName Key;
+
+		/** Holds the allowed values. */
+		TArray<FString, TInlineAllocator<2>> Values;
+	};
+
+	/** Holds the annotation conditions. */
+	TArray<FAnnotationCondition> AnnotationConditions;
+
+	/** Holds the conditions on dynamic message parameters. */
+	TArray<TFunction<bool(const FSGMessage&)>> MessageConditions;
+
+	/** Holds the conditions on typed message payloads. */
+	TArray<TFunction<bool(const ISGMessageContext&)>> ContextConditions;
+};
@@ -5,6 +5,8 @@
 #include "CoreMinimal.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageAttachment.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Message/SGMessageTypeRegistry.h"
 
 /**
  * Implements a message context for messages sent through the message bus.
@@ -22,6 +24,8 @@ public:
 	FSGMessageContext()
 		: Message(nullptr)
 		, TypeInfo(nullptr)
+		, TypeId(INDEX_NONE)
+		, bTaggedMessage(false)
 	{ }
 
 	/**
@@ -44,10 +48,10 @@ public:
 	FSGMessageContext(
 		void* InMessage,
 		UScriptStruct* InTypeInfo,
-		const TMap<FName, FString>& InAnnotations,
+		const FSGMessageAnnotations& InAnnotations,
 		const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& InAttachment,
 		const FSGMessageAddress& InSender,
-		const TArray<FSGMessageAddress>& InRecipients,
+		TArrayView<const FSGMessageAddress> InRecipients,
 		ESGMessageScope InScope,
 		ESGMessageFlags InFlags,
 		const FDateTime& InTimeSent,
@@ -57,6 +61,7 @@ public:
 		: Annotations(InAnnotations)
 		, Attachment(InAttachment)
 		, Expiration(InExpiration)
+		, MessageTag((InTypeInfo != nullptr) ? InTypeInfo->GetFName() : NAME_None)
 		, Message(InMessage)
 		, Recipients(InRecipients)
 		, Scope(InScope)
@@ -65,15 +70,17 @@ public:
 		, SenderThread(InSenderThread)
 		, TimeSent(InTimeSent)
 		, TypeInfo(InTypeInfo)
+		, TypeId(FSGMessageTypeRegistry::Get().GetTypeId(InTypeInfo))
+		, bTaggedMessage(false)
 	{ }
 
 	FSGMessageContext(
 	const FName& InMessageTag,
 	void* InMessage,
-	const TMap<FName, FString>& InAnnotations,
+	const FSGMessageAnnotations& InAnnotations,
 	const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& InAttachment,
 	const FSGMessageAddress& InSender,
-	const TArray<FSGMessageAddress>& InRecipients,
+	TArrayView<const FSGMessageAddress> InRecipients,
 	ESGMessageScope InScope,
 	ESGMessageFlags InFlags,
 	const FDateTime& InTimeSent,
@@ -91,12 +98,16 @@ public:
 	, Sender(InSender)
 	, SenderThread(InSenderThread)
 	, TimeSent(InTimeSent)
+	, TypeId(INDEX_NONE)
+	, bTaggedMessage(true)
 	{ }
 
 	/**
 	 * Creates and initializes a new message context from an existing context.
 	 *
-	 * This constructor overload is used for forwarded messages.
+	 * This constructor overload is used for forwarded messages. The new context refers to the
+	 * context that holds the message instead of to the existing context, which is only recorded
+	 * in the forward history, so that getters don't walk a chain of contexts.
 	 *
 	 * @param InContext The existing context.
 	 * @param InForwarder The forwarder's address.
@@ -108,35 +119,64 @@ public:
 	FSGMessageContext(
 		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& InContext,
 		const FSGMessageAddress& InForwarder,
-		const TArray<FSGMessageAddress>& NewRecipients,
+		TArrayView<const FSGMessageAddress> NewRecipients,
 		ESGMessageScope NewScope,
 		const FDateTime& InTimeForwarded,
 		ENamedThreads::Type InForwarderThread
 	)
 		: Message(nullptr)
-		, OriginalContext(InContext)
+		, RootContext(InContext->GetRootContext())
 		, Recipients(NewRecipients)
 		, Scope(NewScope)
 		, Flags(ESGMessageFlags::None)
 		, Sender(InForwarder)
 		, SenderThread(InForwarderThread)
 		, TimeSent(InTimeForwarded)
-	{ }
+		, TypeId(INDEX_NONE)
+		, bTaggedMessage(false)
+	{
+		if (RootContext.IsValid())
+		{
+			History = MakeForwardHop(*InContext);
+		}
+		else
+		{
+			RootContext = InContext;
+		}
+	}
 
 	/** Destructor. */
 	virtual ~FSGMessageContext() override;
 
+	/**
+	 * Creates a shared message context, which is accounted to the SGMessaging/Contexts LLM tag.
+	 *
+	 * @param Args The constructor arguments.
+	 * @return The new context.
+	 */
+	template<typename... ArgTypes>
+	static TSharedRef<FSGMessageContext, ESPMode::ThreadSafe> Create(ArgTypes&&... Args)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Contexts);
+
+		return MakeShared<FSGMessageContext, ESPMode::ThreadSafe>(Forward<ArgTypes>(Args)...);
+	}
+
 public:
 
 	//~ ISGMessageContext interface
 
-	virtual const TMap<FName, FString>& GetAnnotations() const override;
+	virtual const FSGMessageAnnotations& GetAnnotations() const override;
 	virtual TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe> GetAttachment() const override;
 	virtual const FDateTime& GetExpiration() const override;
 	virtual const void* GetMessage() const override;
+	virtual const ISGMessage* GetTaggedMessage() const override;
 	virtual const TWeakObjectPtr<UScriptStruct>& GetMessageTypeInfo() const override;
+	virtual int32 GetMessageTypeId() const override;
 	virtual TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> GetOriginalContext() const override;
-	virtual const TArray<FSGMessageAddress>& GetRecipients() const override;
+	virtual TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> GetRootContext() const override;
+	virtual TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> GetForwardHistory() const override;
+	virtual TArrayView<const FSGMessageAddress> GetRecipients() const override;
 	virtual ESGMessageScope GetScope() const override;
 	virtual ESGMessageFlags GetFlags() const override;
 	virtual const FSGMessageAddress& GetSender() const override;
@@ -145,11 +185,39 @@ public:
 	virtual const FDateTime& GetTimeForwarded() const override;
 	virtual const FDateTime& GetTimeSent() const override;
 	virtual FName GetMessageType() const override;
+	virtual bool IsForwarded() const override;
+	virtual bool IsTraced() const override;
+	virtual void SetTraced(bool bInTraced) override;
+	virtual uint64 GetTraceId() const override;
+	virtual void SetTraceId(uint64 InTraceId) override;
+	virtual bool GetTopicID(int32& OutTopicID) const override;
+	virtual bool HasTopicID() const override;
+	virtual void SetTopicID(const TOptional<int32>& InTopicID) override;
+
+private:
+
+	/** Creates the context of a previous hop of a forwarded message (for GetOriginalContext). */
+	FSGMessageContext(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& InRootContext, const FSGMessageForwardHop& Hop)
+		: Message(nullptr)
+		, RootContext(InRootContext)
+		, History(Hop.Previous)
+		, Recipients(Hop.Recipients)
+		, Scope(Hop.Scope)
+		, Flags(ESGMessageFlags::None)
+		, Sender(Hop.Forwarder)
+		, SenderThread(Hop.ForwarderThread)
+		, TimeSent(Hop.TimeForwarded)
+		, TypeId(INDEX_NONE)
+		, bTaggedMessage(false)
+	{ }
+
+	/** Records the hop of a forwarded context. */
+	static TSharedRef<const FSGMessageForwardHop, ESPMode::ThreadSafe> MakeForwardHop(const ISGMessageContext& Context);
 
 private:
 
 	/** Holds the optional message annotations. */
-	TMap<FName, FString> Annotations;
+	FSGMessageAnnotations Annotations;
 
 	/** Holds a pointer to attached binary data. */
 	TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe> Attachment;
@@ -162,11 +230,14 @@ private:
 	/** Holds the message. */
 	void* Message;
 
-	/** Holds the original message context. */
-	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> OriginalContext;
+	/** Holds the context that holds the message of a forwarded message. */
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> RootContext;
 
-	/** Holds the message recipients. */
-	TArray<FSGMessageAddress> Recipients;
+	/** Holds the hops of a forwarded message before the current one. */
+	TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> History;
+
+	/** Holds the message recipients (most messages have at most one, which is stored inline). */
+	TArray<FSGMessageAddress, TInlineAllocator<1>> Recipients;
 
 	/** Holds the message's scope. */
 	ESGMessageScope Scope;
@@ -185,4 +256,22 @@ private:
 
 	/** Holds the message's type information. */
 	TWeakObjectPtr<UScriptStruct> TypeInfo;
+
+	/** Holds the dense identifier of the message's type (INDEX_NONE for tagged messages). */
+	int32 TypeId;
+
+	/** Whether the message is a tagged ISGMessage that is destroyed via ISGMessage::Release. */
+	bool bTaggedMessage;
+
+	/** Whether the message tracer samples the message (decided when the message is sent). */
+	bool bTraced = false;
+
+	/** Holds the identifier that the message tracer assigned to the message (zero if it isn't traced). */
+	uint64 TraceId = 0;
+
+	/** Whether the router stored the topic identifier of the message's tag. */
+	bool bHasTopicID = false;
+
+	/** Holds the topic identifier of the message's tag (unset if it isn't a topic tag). */
+	TOptional<int32> TopicID;
 };
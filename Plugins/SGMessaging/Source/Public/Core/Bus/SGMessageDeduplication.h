@@ -0,0 +1,149 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Hash/CityHash.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Settings/SGMessagingSettings.h"
+
+
+namespace SGMessageDeduplication
+{
+	/** Name of the message annotation that holds the identifier of a message. */
+	static const FName MessageIdAnnotation(TEXT("SGMessageId"));
+
+	/**
+	 * Checks whether duplicates of a message are suppressed.
+	 *
+	 * Duplicates are suppressed for messages sent with ESGMessageFlags::Deduplicate, and for messages
+	 * whose type is listed in USGMessagingSettings::DeduplicatedMessageTypes.
+	 *
+	 * @param Context The context of the message.
+	 * @return true if duplicates are suppressed, false otherwise.
+	 */
+	inline bool IsDeduplicated(const ISGMessageContext& Context)
+	{
+		if (EnumHasAnyFlags(Context.GetFlags(), ESGMessageFlags::Deduplicate))
+		{
+			return true;
+		}
+
+		const USGMessagingSettings* SGMessagingSettings = GetDefault<USGMessagingSettings>();
+
+		return (SGMessagingSettings != nullptr) && (SGMessagingSettings->DeduplicatedMessageTypes.Num() > 0) && SGMessagingSettings->DeduplicatedMessageTypes.Contains(Context.GetMessageType());
+	}
+
+	/**
+	 * Gets the deduplication key of a message.
+	 *
+	 * The key is made of the message type and the message identifier, so that identifiers only need to
+	 * be unique per type. Messages without an identifier are never duplicates.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutKey Will hold the key.
+	 * @return true if duplicates of the message are suppressed, false otherwise.
+	 */
+	inline bool GetDeduplicationKey(const ISGMessageContext& Context, uint64& OutKey)
+	{
+		const FString* MessageId = Context.GetAnnotations().Find(MessageIdAnnotation);
+
+		if ((MessageId == nullptr) || MessageId->IsEmpty() || !IsDeduplicated(Context))
+		{
+			return false;
+		}
+
+		const uint64 IdHash = CityHash64((const char*)**MessageId, MessageId->Len() * sizeof(TCHAR));
+
+		OutKey = IdHash ^ ((uint64)GetTypeHash(Context.GetMessageType()) * 0x9E3779B97F4A7C15ull);
+
+		return true;
+	}
+}
+
+
+/**
+ * Implements the window of recently routed message identifiers of a message router shard.
+ *
+ * Each key stays in the window for USGMessagingSettings::DeduplicationWindowMs after it was first seen,
+ * and the window holds at most USGMessagingSettings::DeduplicationMaxEntries keys. When the window is
+ * full the oldest keys are dropped first, so a duplicate that arrives much later may get through, but
+ * memory stays bounded whatever the message rate is.
+ *
+ * Keys are kept in a hash set for the lookups, and in a ring buffer in the order they arrived, which
+ * is also the order in which they expire.
+ *
+ * This class is not thread-safe and is owned by the message router thread.
+ */
+class SGMESSAGING_API FSGMessageDeduplicationWindow
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageDeduplicationWindow();
+
+public:
+
+	/**
+	 * Adds a key to the window unless it is in the window already.
+	 *
+	 * @param Key The deduplication key of a message.
+	 * @param NowTick The current tick of the message clock (in milliseconds).
+	 * @return true if the key was added, false if the message is a duplicate.
+	 * @see SGMessageDeduplication::GetDeduplicationKey
+	 */
+	bool Add(uint64 Key, uint64 NowTick);
+
+	/**
+	 * Gets the number of keys in the window.
+	 *
+	 * @return Number of keys.
+	 */
+	int32 Num() const
+	{
+		return Keys.Num();
+	}
+
+	/**
+	 * Gets the size of the memory allocated by the window.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Keys.GetAllocatedSize() + Entries.GetAllocatedSize();
+	}
+
+private:
+
+	/** Removes the keys that expired, and the oldest key if the window is full. */
+	void Trim(uint64 NowTick);
+
+	/** Structure for a key in the ring buffer. */
+	struct FEntry
+	{
+		/** Holds the deduplication key. */
+		uint64 Key;
+
+		/** Holds the tick at which the key leaves the window. */
+		uint64 ExpirationTick;
+	};
+
+	/** Holds the keys in the window. */
+	TSet<uint64> Keys;
+
+	/** Holds the keys in the order they were added (ring buffer). */
+	TArray<FEntry> Entries;
+
+	/** Holds the index of the oldest entry. */
+	int32 Head;
+
+	/** Holds the number of entries in the ring buffer. */
+	int32 Count;
+
+	/** Holds the time that keys stay in the window (in milliseconds). */
+	uint64 WindowTicks;
+
+	/** Holds the largest number of keys in the window. */
+	int32 MaxEntries;
+};
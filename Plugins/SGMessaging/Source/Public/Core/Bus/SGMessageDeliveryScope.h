@@ -0,0 +1,37 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Marks the current thread as delivering messages while the scope exists.
+ *
+ * Router threads, router pool workers, delivery tasks and publishers that dispatch directly may
+ * not wait for a recipient, because the recipient, or every other recipient of the router, waits
+ * for them in turn. Recipients check IsActive before they block, i.e. on a full inbox.
+ *
+ * Scopes may be nested.
+ */
+class SGMESSAGING_API FSGMessageDeliveryScope
+{
+public:
+
+	/** Marks the current thread as delivering messages. */
+	FSGMessageDeliveryScope();
+
+	/** Restores the previous state of the current thread. */
+	~FSGMessageDeliveryScope();
+
+	/**
+	 * Checks whether the current thread delivers messages.
+	 *
+	 * @return true if a delivery scope exists on the current thread, false otherwise.
+	 */
+	static bool IsActive();
+
+private:
+
+	FSGMessageDeliveryScope(const FSGMessageDeliveryScope&) = delete;
+	FSGMessageDeliveryScope& operator=(const FSGMessageDeliveryScope&) = delete;
+};
@@ -3,150 +3,118 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
 #include "Stats/Stats.h"
+#include "Tasks/Task.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageBusListener.h"
 #include "Core/Bus/SGMessageTracer.h"
+#include "Core/Bus/SGMessageStatistics.h"
+#include "Core/Bus/SGMessageConflation.h"
 
 class ISGMessageReceiver;
 
 /**
- * Implements an asynchronous task for dispatching a message to a recipient.
+ * Structure for a single message delivery in a dispatch batch.
  */
-class FSGMessageDispatchTask
+struct FSGMessageDelivery
 {
-public:
-
-	/**
-	 * Creates and initializes a new instance.
-	 *
-	 * @param InThread The name of the thread to dispatch the message on.
-	 * @param InContext The context of the message to dispatch.
-	 * @param InRecipient The message recipient.
-	 * @param InTracer The message tracer to notify.
-	 */
-	FSGMessageDispatchTask(
-		ENamedThreads::Type InThread,
-		TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> InContext,
-		TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> InRecipient,
-		TSharedPtr<FSGMessageTracer, ESPMode::ThreadSafe> InTracer);
-
-public:
-
-	/**
-	 * Performs the actual task.
-	 *
-	 * @param CurrentThread The thread that this task is executing on.
-	 * @param MyCompletionGraphEvent The completion event.
-	 */
-	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent);
-	
-	/**
-	 * Returns the name of the thread that this task should run on.
-	 *
-	 * @return Thread name.
-	 */
-	ENamedThreads::Type GetDesiredThread()
-	{
-		return Thread;
-	}
-
-	/**
-	 * Gets the task's stats tracking identifier.
-	 *
-	 * @return Stats identifier.
-	 */
-	TStatId GetStatId() const;
-
-	/**
-	 * Gets the mode for tracking subsequent tasks.
-	 *
-	 * @return Always track subsequent tasks.
-	 */
-	static ESubsequentsMode::Type GetSubsequentsMode() 
-	{ 
-		return ESubsequentsMode::TrackSubsequents; 
-	}
-
-private:
-
 	/** Holds the message context. */
-	TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context;
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
 
 	/** Holds a reference to the recipient. */
 	TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> RecipientPtr;
 
-	/** Holds the name of the thread that the router is running on. */
-	ENamedThreads::Type Thread;
+	/** Holds the slot to take the latest message from, instead of Context (conflated deliveries only). */
+	TSharedPtr<FSGMessageConflationSlot, ESPMode::ThreadSafe> ConflationSlot;
+
+	/** Default constructor. */
+	FSGMessageDelivery() { }
 
-	/** Holds a pointer to the message tracer. */
-	TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe> TracerPtr;
+	/** Creates and initializes a new instance. */
+	FSGMessageDelivery(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& InContext, const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& InRecipient)
+		: Context(InContext)
+		, RecipientPtr(InRecipient)
+	{ }
+
+	/** Creates and initializes a new instance for a conflated delivery. */
+	FSGMessageDelivery(const TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe>& InConflationSlot, const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& InRecipient)
+		: RecipientPtr(InRecipient)
+		, ConflationSlot(InConflationSlot)
+	{ }
 };
 
 
-/**
- * Implements an asynchronous task for dispatching a registration notification to a listener.
- */
-class FSGBusNotificationDispatchTask
+namespace SGMessageDispatchTask
 {
-public:
-
 	/**
-	 * Creates and initializes a new instance.
+	 * Delivers a message to a recipient on the current thread, unless it expired in the meantime.
 	 *
-	 * @param InThread The name of the thread to dispatch the message on.
-	 * @param InListener The listener to notify.
-	 * @param InAddress The address we are notifying about.
-	 * @param InNotification The notification type being notified.
+	 * @param Context The context of the message to deliver.
+	 * @param Recipient The message recipient.
+	 * @param TracerPtr The message tracer to notify.
+	 * @param StatisticsPtr The message statistics to update.
 	 */
-	FSGBusNotificationDispatchTask(
-		ENamedThreads::Type InThread,
-		TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> InListener,
-		FSGMessageAddress InAddress,
-		ESGMessageBusNotification InNotification)
-		: Thread(InThread)
-		, ListenerPtr(InListener)
-		, Address(InAddress)
-		, Notification(InNotification)
-	{}
-
-public:
+	void DeliverMessage(
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient,
+		const TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe>& TracerPtr,
+		const TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe>& StatisticsPtr);
 
 	/**
-	 * Performs the actual task.
+	 * Makes a batch of deliveries on the current thread, in order.
+	 *
+	 * Deliveries to recipients that no longer exist and of messages that expired in the meantime are skipped.
 	 *
-	 * @param CurrentThread The thread that this task is executing on.
-	 * @param MyCompletionGraphEvent The completion event.
+	 * @param Deliveries The deliveries to make.
+	 * @param TracerPtr The message tracer to notify.
+	 * @param StatisticsPtr The message statistics to update.
 	 */
-	void DoTask(ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent);
+	void DeliverMessages(
+		const TArray<FSGMessageDelivery>& Deliveries,
+		const TWeakPtr<FSGMessageTracer, ESPMode::ThreadSafe>& TracerPtr,
+		const TWeakPtr<FSGMessageStatistics, ESPMode::ThreadSafe>& StatisticsPtr);
 
 	/**
-	 * Returns the name of the thread that this task should run on.
+	 * Gets the priority of the worker tasks that deliver messages of the given priority.
 	 *
-	 * @return Thread name.
+	 * @param Priority The message priority.
+	 * @return The task priority.
 	 */
-	ENamedThreads::Type GetDesiredThread()
-	{
-		return Thread;
-	}
+	UE::Tasks::ETaskPriority GetTaskPriority(ESGMessagePriority Priority);
 
-	TStatId GetStatId() const;
+	/**
+	 * Gets the extended task priority that runs tasks on the given named thread.
+	 *
+	 * @param Thread The named thread.
+	 * @param Priority The message priority (high priority messages use the thread's high priority queue).
+	 * @return The extended priority, or EExtendedTaskPriority::None if the thread can't run tasks, i.e. custom named threads.
+	 */
+	UE::Tasks::EExtendedTaskPriority GetNamedThreadTaskPriority(ENamedThreads::Type Thread, ESGMessagePriority Priority);
 
-	static ESubsequentsMode::Type GetSubsequentsMode()
+	/**
+	 * Launches a task on a named thread.
+	 *
+	 * Tasks of the same thread and priority run in launch order. Threads that can't run tasks
+	 * fall back to a task graph task, which keeps that order as well.
+	 *
+	 * @param DebugName The name of the task (for debugging purposes).
+	 * @param Thread The named thread to run the task on.
+	 * @param Priority The priority of the messages the task delivers.
+	 * @param TaskBody The callable to run.
+	 */
+	template<typename TaskBodyType>
+	void LaunchOnNamedThread(const TCHAR* DebugName, ENamedThreads::Type Thread, ESGMessagePriority Priority, TaskBodyType&& TaskBody)
 	{
-		return ESubsequentsMode::TrackSubsequents;
+		const UE::Tasks::EExtendedTaskPriority ExtendedPriority = GetNamedThreadTaskPriority(Thread, Priority);
+
+		if (ExtendedPriority != UE::Tasks::EExtendedTaskPriority::None)
+		{
+			UE::Tasks::Launch(DebugName, Forward<TaskBodyType>(TaskBody), UE::Tasks::ETaskPriority::Normal, ExtendedPriority);
+		}
+		else
+		{
+			FFunctionGraphTask::CreateAndDispatchWhenReady(Forward<TaskBodyType>(TaskBody), TStatId(), nullptr, Thread);
+		}
 	}
-
-private:
-	/** Holds the name of the thread that the router is running on. */
-	ENamedThreads::Type Thread;
-
-	/** Holds a reference to the recipient. */
-	TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> ListenerPtr;
-
-	/** Holds the address we are notifying about. */
-	FSGMessageAddress Address;
-
-	/** Holds the notification type we are notifying about. */
-	ESGMessageBusNotification Notification;
-};
+}
@@ -0,0 +1,299 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Templates/Function.h"
+#include "Templates/UniquePtr.h"
+#include "Tasks/Pipe.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include <atomic>
+
+class IFileHandle;
+
+
+/**
+ * Implements the durable queues of the message router shard that owns them.
+ *
+ * Messages sent to a durable recipient (see ISGMessageReceiver::IsDurable) while it isn't registered are
+ * appended to a segment file of the recipient's address instead of being dropped. The records use the
+ * message capture format (see FSGMessageCapture::MakeRecord), so dynamic messages are stored in the binary
+ * message encoding. When the recipient registers again, the segment is memory mapped, its messages are
+ * replayed in the order they were sent, and the segment is deleted.
+ *
+ * The router thread only serializes records. The records of a router pass are handed to a task pipe in
+ * one batch (see Flush), which writes and flushes each segment once, so a crash loses at most the records
+ * of the last pass. Segments are also loaded for a replay on the pipe, and their messages are replayed a
+ * bounded number per pass (see ProcessReplays). Messages sent to a recipient while its replay is running
+ * are held back until the replay is done, so they don't overtake the queued ones.
+ *
+ * A segment never grows beyond USGMessagingSettings::DurableQueueMaxSizeKb. A full segment is compacted,
+ * which drops its expired messages and then its oldest ones until half of the budget is free again.
+ * Segments survive restarts, so endpoints with a stable address (see FSGMessageEndpointBuilder::ThatIsDurable)
+ * also receive the messages that were queued for them by a previous session.
+ *
+ * Attachments and the payloads of typed messages are not stored, the latter are dropped.
+ *
+ * This class is not thread-safe and is owned by a message router thread.
+ */
+class SGMESSAGING_API FSGMessageDurableQueue
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InDirectory The directory that holds the segment files.
+	 * @param InShardIndex The index of the router shard that owns the queues (each shard has its own segments).
+	 */
+	FSGMessageDurableQueue(const FString& InDirectory, int32 InShardIndex);
+
+	/** Destructor. */
+	~FSGMessageDurableQueue();
+
+	FSGMessageDurableQueue(const FSGMessageDurableQueue&) = delete;
+	FSGMessageDurableQueue& operator=(const FSGMessageDurableQueue&) = delete;
+
+public:
+
+	/**
+	 * Appends a message to the durable queue of a recipient.
+	 *
+	 * The record is written by the next Flush. Messages to a recipient whose replay is running are held
+	 * back by the replay instead (see HoldBack).
+	 *
+	 * @param Recipient The address of the recipient that isn't registered.
+	 * @param Context The context of the message.
+	 * @return true if the message was queued, false if it can't be stored or isn't of a durable message type.
+	 */
+	bool Append(const FSGMessageAddress& Recipient, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/**
+	 * Writes the records that were appended since the last call.
+	 *
+	 * The records are written on the task pipe. Called once per router pass.
+	 */
+	void Flush();
+
+	/**
+	 * Holds back a message to a recipient whose replay is running.
+	 *
+	 * @param Recipient The address of the registered recipient.
+	 * @param Context The context of the message.
+	 * @return true if the message is delivered when the replay is done, false if the recipient isn't replaying.
+	 */
+	bool HoldBack(const FSGMessageAddress& Recipient, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/**
+	 * Starts replaying the queued messages of a recipient.
+	 *
+	 * The segment is loaded and deleted on the task pipe, after the records that were appended before.
+	 *
+	 * @param Recipient The address of the recipient that registered.
+	 * @see ProcessReplays
+	 */
+	void BeginReplay(const FSGMessageAddress& Recipient);
+
+	/**
+	 * Replays the messages of the loaded segments.
+	 *
+	 * @param MaxMessages The largest number of messages to replay; the rest is replayed by the next calls.
+	 * @param Callback Called with the context of each message that didn't expire, in the order they were queued.
+	 * @return The number of replayed messages.
+	 */
+	int32 ProcessReplays(int32 MaxMessages, TFunctionRef<void(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&)> Callback);
+
+	/** Whether any replay is running. */
+	bool IsReplaying() const
+	{
+		return Replays.Num() > 0;
+	}
+
+	/**
+	 * Gets the recipients that have segment files, e.g. from a previous session.
+	 *
+	 * @param OutRecipients Will hold the addresses of the recipients.
+	 */
+	void GetQueuedRecipients(TArray<FSGMessageAddress>& OutRecipients) const;
+
+public:
+
+	/** Gets the number of messages that were dropped because a segment was full or a message couldn't be stored. */
+	int64 GetNumDroppedMessages() const
+	{
+		return NumDroppedMessages.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	/** Structure for a segment that is open for appending (only used on the task pipe). */
+	struct FSegment
+	{
+		/** Holds the file handle. */
+		TUniquePtr<IFileHandle> Writer;
+
+		/** Holds the size of the segment file (in bytes). */
+		int64 Size = 0;
+	};
+
+	/** Structure for the replay of a recipient's segment. */
+	struct FReplay
+	{
+		/** Holds the records of the segment that didn't expire (written on the task pipe before bLoaded is set). */
+		TArray<uint8> Records;
+
+		/** Holds the number of records that expired while they were queued (written with Records). */
+		int32 NumExpired = 0;
+
+		/** Holds a flag indicating that the segment was loaded. */
+		std::atomic<bool> bLoaded{false};
+
+		/** Holds the offset of the next record to replay. */
+		int64 NextRecord = 0;
+
+		/** Holds the messages that were held back while the replay ran. */
+		TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> HeldBack;
+
+		/** Holds the index of the next held back message to deliver. */
+		int32 NextHeldBack = 0;
+
+		/** Holds the number of replayed messages. */
+		int32 NumReplayed = 0;
+
+		/** Holds a flag indicating that the recipient registered again, so its segment is loaded again when the replay is done. */
+		bool bReload = false;
+	};
+
+	/** Gets the name of the segment file of a recipient. */
+	FString GetSegmentFilename(const FSGMessageAddress& Recipient) const;
+
+	/** Starts loading the segment of a recipient on the task pipe. */
+	void LoadSegment(const FSGMessageAddress& Recipient, const TSharedRef<FReplay, ESPMode::ThreadSafe>& Replay);
+
+	/**
+	 * Writes a batch of records (on the task pipe).
+	 *
+	 * @param Batch The serialized records of each recipient, in the order they were appended.
+	 */
+	void WriteRecords(const TMap<FSGMessageAddress, TArray<uint8>>& Batch);
+
+	/**
+	 * Opens the segment of a recipient for appending (on the task pipe).
+	 *
+	 * @param Recipient The address of the recipient.
+	 * @return The segment, or nullptr if it can't be opened.
+	 */
+	FSegment* OpenSegment(const FSGMessageAddress& Recipient);
+
+	/** Closes the segment of a recipient if it is open (on the task pipe). */
+	void CloseSegment(const FSGMessageAddress& Recipient);
+
+	/**
+	 * Compacts the segment of a recipient so that at least the given number of bytes fit into it.
+	 *
+	 * @param Recipient The address of the recipient.
+	 * @param NumBytesNeeded The size of the record to append.
+	 */
+	void CompactSegment(const FSGMessageAddress& Recipient, int64 NumBytesNeeded);
+
+	/**
+	 * Replaces a segment file with the given records.
+	 *
+	 * @param Filename The name of the segment file.
+	 * @param RecordBytes The records of the segment.
+	 * @return true if the segment was written, false otherwise.
+	 */
+	bool WriteSegment(const FString& Filename, TArrayView<const uint8> RecordBytes);
+
+	/**
+	 * Serializes the record of a message.
+	 *
+	 * @param Recipient The address of the recipient (for logging).
+	 * @param Context The context of the message.
+	 * @param OutBytes The buffer to append the record to.
+	 * @return true if the record was appended, false if the message is dropped.
+	 */
+	bool SerializeRecord(const FSGMessageAddress& Recipient, const ISGMessageContext& Context, TArray<uint8>& OutBytes);
+
+	/** Structure for the header of each record in a segment. */
+	struct FRecordHeader
+	{
+		/** Holds the size of the capture record that follows the header (in bytes). */
+		uint32 RecordSize;
+
+		/** Holds the time at which the message was sent (UTC ticks). */
+		int64 TimeSentTicks;
+
+		/** Holds the time at which the message expires (UTC ticks). */
+		int64 ExpirationTicks;
+	};
+
+	/** Appends a record header and record to a buffer. */
+	static void WriteRecord(const FRecordHeader& Header, TArrayView<const uint8> RecordBytes, TArray<uint8>& OutBytes);
+
+	/** Reads the record header at the given position of a buffer. */
+	static FRecordHeader ReadRecordHeader(const uint8* Data);
+
+	/**
+	 * Maps a segment file and visits its records.
+	 *
+	 * @param Filename The name of the segment file.
+	 * @param Visitor Called with the header and the capture record of each complete record, in file order.
+	 * @return false if the file can't be mapped or isn't a segment file.
+	 */
+	static bool VisitRecords(const FString& Filename, TFunctionRef<void(const FRecordHeader&, TArrayView<const uint8>)> Visitor);
+
+	/**
+	 * Creates the context of a stored message.
+	 *
+	 * @param Header The header of the record.
+	 * @param RecordBytes The serialized capture record.
+	 * @param Recipient The address of the recipient.
+	 * @return The context, or nullptr if the message can't be restored.
+	 */
+	static TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> MakeContext(const FRecordHeader& Header, TArrayView<const uint8> RecordBytes, const FSGMessageAddress& Recipient);
+
+private:
+
+	/** Identifies segment files. */
+	static constexpr uint32 FileMagic = 0x514D4753;
+
+	/** Holds the current version of the segment format. */
+	static constexpr uint8 FileVersion = 1;
+
+	/** Holds the size of the segment file header (magic and version). */
+	static constexpr int64 HeaderSize = sizeof(uint32) + sizeof(uint8);
+
+	/** Holds the size of the header of each record (record size, send time and expiration). */
+	static constexpr int64 RecordHeaderSize = sizeof(uint32) + 2 * sizeof(int64);
+
+	/** Holds the directory that holds the segment files. */
+	FString Directory;
+
+	/** Holds the index of the router shard that owns the queues. */
+	int32 ShardIndex;
+
+	/** Holds the maximum size of a segment (in bytes). */
+	int64 MaxSegmentSize;
+
+	/** Holds the types of messages that are queued (empty = all types). */
+	TSet<FName> MessageTypes;
+
+	/** Holds the segments that are open for appending (only used on the task pipe). */
+	TMap<FSGMessageAddress, FSegment> Segments;
+
+	/** Holds the records that were appended since the last flush, by recipient. */
+	TMap<FSGMessageAddress, TArray<uint8>> PendingRecords;
+
+	/** Holds the running replays. */
+	TMap<FSGMessageAddress, TSharedRef<FReplay, ESPMode::ThreadSafe>> Replays;
+
+	/** Holds the address of the recipient whose messages are being replayed (its messages aren't held back). */
+	FSGMessageAddress ReplayingRecipient;
+
+	/** Holds the pipe that writes and loads the segments in order. */
+	UE::Tasks::FPipe Pipe;
+
+	/** Holds the number of dropped messages. */
+	std::atomic<int64> NumDroppedMessages;
+};
@@ -0,0 +1,249 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformTime.h"
+#include <atomic>
+
+
+/**
+ * Structure for the timing of message handlers over the profiling window.
+ */
+struct FSGMessageHandlerTiming
+{
+	/** Holds the debug name of the endpoint (or the name of the Blueprint event). */
+	FName HandlerName;
+
+	/** Holds the type (or tag) of the handled messages. */
+	FName MessageType;
+
+	/** Holds the identifier of the handler in its endpoint (0 = a Blueprint event or batch). */
+	uint32 HandlerId = 0;
+
+	/** Holds the number of handled messages. */
+	int64 NumCalls = 0;
+
+	/** Holds the time the handlers took (in milliseconds). */
+	double TotalMs = 0.0;
+
+	/** Holds the longest time the handlers took for one message (in milliseconds). */
+	double MaxMs = 0.0;
+
+	/** Gets the average time the handlers took per message (in milliseconds). */
+	double GetAverageMs() const
+	{
+		return (NumCalls > 0) ? TotalMs / (double)NumCalls : 0.0;
+	}
+};
+
+
+/**
+ * Structure for a slow handler that the watchdog reported.
+ */
+struct FSGMessageSlowHandlerEvent
+{
+	/** Holds the debug name of the endpoint (or the name of the Blueprint event). */
+	FName HandlerName;
+
+	/** Holds the type (or tag) of the handled message. */
+	FName MessageType;
+
+	/** Holds the identifier of the handler in its endpoint (0 = a Blueprint event or batch). */
+	uint32 HandlerId = 0;
+
+	/** Holds the time the handler took (in milliseconds). */
+	double Milliseconds = 0.0;
+};
+
+
+/** Delegate for slow handlers, executed on the thread that handled the message. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnSGSlowMessageHandler, const FSGMessageSlowHandlerEvent&);
+
+
+/**
+ * Implements process-wide timings of message handlers.
+ *
+ * Endpoints time each handler they call, keyed by the endpoint's debug name, the message type and the
+ * handler's identifier in the endpoint. Blueprint endpoints additionally time each Blueprint event, keyed
+ * by the event's name. Timings are kept in one-second buckets, so that reports cover the last few seconds
+ * instead of the whole session, see USGMessagingSettings::HandlerProfilingWindowSeconds.
+ *
+ * Each thread records into timings of its own, which only its own lock guards, so handling threads don't
+ * contend with each other. Reports merge the timings of all threads.
+ *
+ * Handlers that take longer than USGMessagingSettings::SlowHandlerThresholdMs are logged at most once
+ * per second each on each thread and reported through OnSlowHandler.
+ *
+ * Profiling is off unless USGMessagingSettings::bEnableHandlerProfiling is set or it is started with
+ * the SGMessaging.HandlerReport console command. While it is off, measuring costs a relaxed load.
+ *
+ * This class is thread-safe.
+ */
+class SGMESSAGING_API FSGMessageHandlerProfiler
+{
+public:
+
+	/** Number of one-second buckets kept per handler (the longest profiling window). */
+	static constexpr int32 MaxWindowSeconds = 16;
+
+	/**
+	 * Checks whether handler timings are recorded.
+	 *
+	 * @return true if profiling is enabled, false otherwise.
+	 */
+	static bool IsEnabled()
+	{
+		return bEnabled.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Starts or stops recording handler timings.
+	 *
+	 * @param bInEnabled Whether to record timings.
+	 */
+	static void SetEnabled(bool bInEnabled);
+
+	/**
+	 * Records the time that a handler of a message took.
+	 *
+	 * @param HandlerName The debug name of the endpoint (or the name of the Blueprint event).
+	 * @param MessageType The type (or tag) of the message.
+	 * @param HandlerId The identifier of the handler in its endpoint (0 = a Blueprint event or batch).
+	 * @param Cycles The time the handler took (in CPU cycles).
+	 */
+	static void Record(const FName& HandlerName, const FName& MessageType, uint32 HandlerId, uint64 Cycles);
+
+	/**
+	 * Gets the most expensive handlers over the profiling window.
+	 *
+	 * @param MaxHandlers The largest number of handlers to get.
+	 * @param OutTimings Will hold the timings, most expensive first (by total time).
+	 */
+	static void GetTopHandlers(int32 MaxHandlers, TArray<FSGMessageHandlerTiming>& OutTimings);
+
+	/** Removes all recorded timings. */
+	static void Reset();
+
+	/**
+	 * Gets the delegate that is executed when a handler is slower than the threshold.
+	 *
+	 * Bind it before profiling starts, as it is executed on the handling threads without locking.
+	 *
+	 * @return The delegate.
+	 */
+	static FOnSGSlowMessageHandler& OnSlowHandler()
+	{
+		return SlowHandlerDelegate;
+	}
+
+private:
+
+	/** Structure for the timings of a handler in one second. */
+	struct FBucket
+	{
+		/** Holds the second that the bucket counts (-1 = unused). */
+		int64 Second = -1;
+
+		/** Holds the number of handled messages. */
+		int64 NumCalls = 0;
+
+		/** Holds the time the handlers took (in CPU cycles). */
+		uint64 TotalCycles = 0;
+
+		/** Holds the longest time the handlers took (in CPU cycles). */
+		uint64 MaxCycles = 0;
+	};
+
+	/** Structure for the timings of a handler. */
+	struct FEntry
+	{
+		/** Holds the buckets, indexed by second modulo MaxWindowSeconds. */
+		FBucket Buckets[MaxWindowSeconds];
+
+		/** Holds the second in which the handler was last reported as slow. */
+		int64 LastSlowSecond = -1;
+	};
+
+	/** Type definition for the keys of the timings (handler name, message type and handler identifier). */
+	typedef TTuple<FName, FName, uint32> FEntryKey;
+
+	/** Structure for the timings that one thread recorded. */
+	struct FThreadTimings
+	{
+		/** Guards the timings against reports and resets (only contended while they run). */
+		FCriticalSection CriticalSection;
+
+		/** Holds the timings, by key. */
+		TMap<FEntryKey, FEntry> Entries;
+	};
+
+	/** Gets the timings of the calling thread, creating them on first use. */
+	static FThreadTimings& GetThreadTimings();
+
+	/** Gets the current second of the platform clock. */
+	static int64 GetCurrentSecond();
+
+private:
+
+	/** Holds a flag indicating whether timings are recorded. */
+	static std::atomic<bool> bEnabled;
+
+	/** Holds the threshold of slow handlers (in CPU cycles, 0 = no watchdog). */
+	static std::atomic<uint64> SlowHandlerCycles;
+
+	/** Holds the timings of each thread that recorded any. */
+	static TArray<TSharedRef<FThreadTimings, ESPMode::ThreadSafe>> AllThreadTimings;
+
+	/** Guards the list of thread timings. */
+	static FCriticalSection ThreadTimingsCS;
+
+	/** Holds the delegate for slow handlers. */
+	static FOnSGSlowMessageHandler SlowHandlerDelegate;
+};
+
+
+/**
+ * Implements a scope that records the time a handler of a message takes.
+ *
+ *		FSGMessageHandlerScope HandlerScope(GetDebugName(), Context->GetMessageType(), Entry.Id);
+ *
+ * The clock is only read if profiling was enabled when the scope was entered.
+ */
+class FSGMessageHandlerScope
+{
+public:
+
+	FSGMessageHandlerScope(const FName& InHandlerName, const FName& InMessageType, uint32 InHandlerId = 0)
+		: HandlerName(InHandlerName)
+		, MessageType(InMessageType)
+		, HandlerId(InHandlerId)
+		, StartCycles(FSGMessageHandlerProfiler::IsEnabled() ? FPlatformTime::Cycles64() : 0)
+	{ }
+
+	~FSGMessageHandlerScope()
+	{
+		if (StartCycles != 0)
+		{
+			FSGMessageHandlerProfiler::Record(HandlerName, MessageType, HandlerId, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+	FSGMessageHandlerScope(const FSGMessageHandlerScope&) = delete;
+	FSGMessageHandlerScope& operator=(const FSGMessageHandlerScope&) = delete;
+
+private:
+
+	/** Holds the debug name of the endpoint (or the name of the Blueprint event). */
+	const FName HandlerName;
+
+	/** Holds the type (or tag) of the message. */
+	const FName MessageType;
+
+	/** Holds the identifier of the handler in its endpoint (0 = a Blueprint event or batch). */
+	const uint32 HandlerId;
+
+	/** Holds the time the scope was entered (in CPU cycles, 0 = not profiling). */
+	const uint64 StartCycles;
+};
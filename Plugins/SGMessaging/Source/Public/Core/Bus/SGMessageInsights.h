@@ -0,0 +1,67 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Trace/Config.h"
+#include "Trace/Trace.h"
+
+class ISGMessageContext;
+
+#ifndef SGMESSAGING_INSIGHTS_ENABLED
+	#define SGMESSAGING_INSIGHTS_ENABLED (UE_TRACE_ENABLED && !UE_BUILD_SHIPPING)
+#endif
+
+#if SGMESSAGING_INSIGHTS_ENABLED
+
+/** Unreal Insights channel of message traffic (enable with -trace=SGMessaging). */
+UE_TRACE_CHANNEL_EXTERN(SGMessagingChannel, SGMESSAGING_API)
+
+/**
+ * Emits the Unreal Insights events of message traffic.
+ *
+ * Each event carries the CPU cycle at which it happened and the identity of the message context, so
+ * that a message can be followed from the sending thread to the router and to its recipients' threads.
+ * Senders and recipients are identified by the hashes of their addresses and recipient identifiers.
+ *
+ * Use the SGMESSAGING_TRACE macro, which only evaluates its arguments while the channel is enabled.
+ */
+struct SGMESSAGING_API FSGMessageInsights
+{
+	/** Emits the event of a sent message. */
+	static void OutputSentMessage(const ISGMessageContext& Context);
+
+	/** Emits the event of a routed message. */
+	static void OutputRoutedMessage(const ISGMessageContext& Context);
+
+	/** Emits the event of an intercepted message. */
+	static void OutputInterceptedMessage(const ISGMessageContext& Context, const FGuid& InterceptorId);
+
+	/** Emits the event of a message that was dispatched to a recipient. */
+	static void OutputDispatchedMessage(const ISGMessageContext& Context, const FGuid& RecipientId, ENamedThreads::Type RecipientThread, bool bAsync);
+
+	/** Emits the event of a message that a recipient handled. */
+	static void OutputHandledMessage(const ISGMessageContext& Context, const FGuid& RecipientId);
+};
+
+/**
+ * Emits an Unreal Insights message event if the SGMessaging channel is enabled.
+ *
+ *		SGMESSAGING_TRACE(DispatchedMessage, *Context, Recipient->GetRecipientId(), Recipient->GetRecipientThread(), false);
+ *
+ * @param Event The name of the event (SentMessage, RoutedMessage, InterceptedMessage, DispatchedMessage or HandledMessage).
+ */
+#define SGMESSAGING_TRACE(Event, ...) \
+	do \
+	{ \
+		if (UE_TRACE_CHANNELEXPR_IS_ENABLED(SGMessagingChannel)) \
+		{ \
+			FSGMessageInsights::Output##Event(__VA_ARGS__); \
+		} \
+	} while (0)
+
+#else
+
+#define SGMESSAGING_TRACE(Event, ...) do { } while (0)
+
+#endif
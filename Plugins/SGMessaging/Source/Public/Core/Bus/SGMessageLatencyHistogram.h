@@ -0,0 +1,200 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+
+/**
+ * Implements a lock-free latency histogram with logarithmic buckets.
+ *
+ * Latencies are counted in microseconds. Each power of two is split into eight linear buckets, so
+ * percentiles are accurate to within 12.5% of the value, from one microsecond up to about 70 minutes.
+ * Any thread may record and query concurrently; queries see a consistent enough snapshot for reporting.
+ */
+class FSGMessageLatencyHistogram
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageLatencyHistogram()
+	{
+		Reset();
+	}
+
+	FSGMessageLatencyHistogram(const FSGMessageLatencyHistogram&) = delete;
+	FSGMessageLatencyHistogram& operator=(const FSGMessageLatencyHistogram&) = delete;
+
+public:
+
+	/**
+	 * Records a latency.
+	 *
+	 * @param Seconds The latency (in seconds, negative values count as zero).
+	 */
+	void Record(double Seconds)
+	{
+		const uint64 Microseconds = (Seconds > 0.0) ? (uint64)(Seconds * 1000000.0) : 0;
+
+		Buckets[GetBucketIndex(Microseconds)].fetch_add(1, std::memory_order_relaxed);
+		Count.fetch_add(1, std::memory_order_relaxed);
+		TotalMicroseconds.fetch_add(Microseconds, std::memory_order_relaxed);
+
+		uint64 CurrentMax = MaxMicroseconds.load(std::memory_order_relaxed);
+
+		while ((Microseconds > CurrentMax) && !MaxMicroseconds.compare_exchange_weak(CurrentMax, Microseconds, std::memory_order_relaxed));
+	}
+
+	/** Resets the histogram. */
+	void Reset()
+	{
+		for (std::atomic<uint64>& Bucket : Buckets)
+		{
+			Bucket.store(0, std::memory_order_relaxed);
+		}
+
+		Count.store(0, std::memory_order_relaxed);
+		TotalMicroseconds.store(0, std::memory_order_relaxed);
+		MaxMicroseconds.store(0, std::memory_order_relaxed);
+	}
+
+public:
+
+	/** Gets the number of recorded latencies. */
+	uint64 GetCount() const
+	{
+		return Count.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the longest recorded latency (in seconds). */
+	double GetMax() const
+	{
+		return MaxMicroseconds.load(std::memory_order_relaxed) / 1000000.0;
+	}
+
+	/** Gets the average recorded latency (in seconds). */
+	double GetMean() const
+	{
+		const uint64 CurrentCount = GetCount();
+
+		return (CurrentCount > 0) ? TotalMicroseconds.load(std::memory_order_relaxed) / (CurrentCount * 1000000.0) : 0.0;
+	}
+
+	/**
+	 * Gets the latency below which the given fraction of the recorded latencies fall.
+	 *
+	 * @param Percentile The fraction (i.e. 0.99 for the 99th percentile).
+	 * @return The latency (in seconds), or zero if nothing was recorded.
+	 */
+	double GetPercentile(double Percentile) const
+	{
+		uint64 Total = 0;
+
+		for (const std::atomic<uint64>& Bucket : Buckets)
+		{
+			Total += Bucket.load(std::memory_order_relaxed);
+		}
+
+		if (Total == 0)
+		{
+			return 0.0;
+		}
+
+		const uint64 Target = FMath::Max<uint64>(1, (uint64)FMath::CeilToDouble(FMath::Clamp(Percentile, 0.0, 1.0) * Total));
+		const uint64 Max = MaxMicroseconds.load(std::memory_order_relaxed);
+		uint64 Cumulative = 0;
+
+		for (int32 BucketIndex = 0; BucketIndex < NumBuckets; ++BucketIndex)
+		{
+			Cumulative += Buckets[BucketIndex].load(std::memory_order_relaxed);
+
+			if (Cumulative >= Target)
+			{
+				return FMath::Min(GetBucketUpperBound(BucketIndex), Max) / 1000000.0;
+			}
+		}
+
+		return Max / 1000000.0;
+	}
+
+private:
+
+	/** Number of linear buckets per power of two (as a power of two). */
+	static constexpr int32 SubBucketBits = 3;
+
+	/** Number of linear buckets per power of two. */
+	static constexpr int32 SubBucketCount = 1 << SubBucketBits;
+
+	/** Largest power of two above the linear range. */
+	static constexpr int32 MaxShift = 32;
+
+	/** Total number of buckets. */
+	static constexpr int32 NumBuckets = (MaxShift + 2) * SubBucketCount;
+
+	/** Gets the index of the bucket that counts the given latency. */
+	static int32 GetBucketIndex(uint64 Microseconds)
+	{
+		if (Microseconds < SubBucketCount)
+		{
+			return (int32)Microseconds;
+		}
+
+		const int32 Shift = FMath::Min((int32)FMath::FloorLog2_64(Microseconds) - SubBucketBits, MaxShift);
+		const uint64 Top = FMath::Min<uint64>(Microseconds >> Shift, 2 * SubBucketCount - 1);
+
+		return (Shift + 1) * SubBucketCount + (int32)(Top - SubBucketCount);
+	}
+
+	/** Gets the largest latency that the given bucket counts (in microseconds). */
+	static uint64 GetBucketUpperBound(int32 BucketIndex)
+	{
+		if (BucketIndex < SubBucketCount)
+		{
+			return (uint64)BucketIndex;
+		}
+
+		const int32 Shift = BucketIndex / SubBucketCount - 1;
+		const uint64 Top = (uint64)(BucketIndex % SubBucketCount + SubBucketCount);
+
+		return ((Top + 1) << Shift) - 1;
+	}
+
+private:
+
+	/** Holds the number of latencies per bucket. */
+	std::atomic<uint64> Buckets[NumBuckets];
+
+	/** Holds the number of recorded latencies. */
+	std::atomic<uint64> Count;
+
+	/** Holds the sum of the recorded latencies (in microseconds). */
+	std::atomic<uint64> TotalMicroseconds;
+
+	/** Holds the longest recorded latency (in microseconds). */
+	std::atomic<uint64> MaxMicroseconds;
+};
+
+
+/**
+ * Structure for the latency histograms of the stages of message delivery.
+ */
+struct FSGMessageLatencyHistograms
+{
+	/** Holds the time between sending and routing messages. */
+	FSGMessageLatencyHistogram SendToRoute;
+
+	/** Holds the time between routing messages and dispatching them to a recipient. */
+	FSGMessageLatencyHistogram RouteToDispatch;
+
+	/** Holds the time between dispatching messages and the recipient handling them. */
+	FSGMessageLatencyHistogram DispatchToHandled;
+
+	/** Resets all histograms. */
+	void Reset()
+	{
+		SendToRoute.Reset();
+		RouteToDispatch.Reset();
+		DispatchToHandled.Reset();
+	}
+};
@@ -0,0 +1,102 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include <algorithm>
+#include <atomic>
+
+
+/**
+ * Implements a lock-free rolling window of message latencies.
+ *
+ * The probe keeps the latest NumSamples latencies, so its percentiles follow the current load instead
+ * of the whole session like FSGMessageLatencyHistogram. Recording is a relaxed increment and a store,
+ * which is cheap enough to leave on outside of Shipping builds. Any thread may record and query concurrently.
+ */
+class FSGMessageLatencyProbe
+{
+public:
+
+	/** Number of latencies in the rolling window. */
+	static constexpr uint32 NumSamples = 256;
+
+	/** Default constructor. */
+	FSGMessageLatencyProbe()
+	{
+		Reset();
+	}
+
+	FSGMessageLatencyProbe(const FSGMessageLatencyProbe&) = delete;
+	FSGMessageLatencyProbe& operator=(const FSGMessageLatencyProbe&) = delete;
+
+public:
+
+	/**
+	 * Records a latency, replacing the oldest one in the window.
+	 *
+	 * @param Seconds The latency (in seconds, negative values count as zero).
+	 */
+	void Record(double Seconds)
+	{
+		const uint64 SampleIndex = Count.fetch_add(1, std::memory_order_relaxed);
+
+		Samples[SampleIndex % NumSamples].store((Seconds > 0.0) ? (float)Seconds : 0.0f, std::memory_order_relaxed);
+	}
+
+	/** Resets the probe. */
+	void Reset()
+	{
+		for (std::atomic<float>& Sample : Samples)
+		{
+			Sample.store(0.0f, std::memory_order_relaxed);
+		}
+
+		Count.store(0, std::memory_order_relaxed);
+	}
+
+public:
+
+	/** Gets the total number of recorded latencies, including those that left the window. */
+	uint64 GetCount() const
+	{
+		return Count.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Gets a percentile of the latencies in the window.
+	 *
+	 * @param Percentile The percentile to get (0 to 100).
+	 * @return The latency (in seconds, or zero if nothing was recorded).
+	 */
+	double GetPercentile(double Percentile) const
+	{
+		const uint32 NumValid = (uint32)FMath::Min<uint64>(GetCount(), NumSamples);
+
+		if (NumValid == 0)
+		{
+			return 0.0;
+		}
+
+		float Window[NumSamples];
+
+		for (uint32 SampleIndex = 0; SampleIndex < NumValid; ++SampleIndex)
+		{
+			Window[SampleIndex] = Samples[SampleIndex].load(std::memory_order_relaxed);
+		}
+
+		const uint32 Rank = (uint32)FMath::Clamp(FMath::CeilToInt(Percentile / 100.0 * NumValid) - 1, 0, (int32)NumValid - 1);
+
+		std::nth_element(Window, Window + Rank, Window + NumValid);
+
+		return Window[Rank];
+	}
+
+private:
+
+	/** Holds the latencies of the window (in seconds). */
+	std::atomic<float> Samples[NumSamples];
+
+	/** Holds the number of recorded latencies. */
+	std::atomic<uint64> Count;
+};
@@ -0,0 +1,118 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/LowLevelMemTracker.h"
+#include "Stats/Stats.h"
+
+
+/**
+ * Low Level Memory Tracker tags of the messaging system.
+ *
+ * The tags are children of the SGMessaging tag, so that the memory of the messaging system can be
+ * budgeted as a whole and by category:
+ *
+ *		SGMessaging/Contexts		message contexts created by buses, bridges, transports and durable queues
+ *		SGMessaging/Payloads		FSGMessage parameters, FSGAny heap values and typed payloads outside the pool
+ *		SGMessaging/MessagePool		the chunks of the message payload pool
+ *		SGMessaging/RouterTables	the tables, command lanes, timers and delivery batches of the routers
+ *		SGMessaging/Tracer			the trace buffers and the message history of the tracers
+ *		SGMessaging/Inboxes			the queues of endpoint inboxes
+ *
+ * @see SGMessaging.MemReport
+ */
+LLM_DECLARE_TAG_API(SGMessaging, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_Contexts, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_Payloads, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_MessagePool, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_RouterTables, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_Tracer, SGMESSAGING_API);
+LLM_DECLARE_TAG_API(SGMessaging_Inboxes, SGMESSAGING_API);
+
+
+/** Stats group of the messaging system's counters (see stat SGMessaging). */
+DECLARE_STATS_GROUP(TEXT("SGMessaging"), STATGROUP_SGMessaging, STATCAT_Advanced);
+
+
+/**
+ * Structure for the memory footprint of a message bus.
+ *
+ * Sizes are the memory allocated by the containers of the bus, not including the message contexts
+ * and payloads that they refer to, which are shared with senders and recipients (see the LLM tags).
+ *
+ * @see FSGMessageBus::GetMemoryReport
+ */
+struct FSGMessageMemoryReport
+{
+	/** Holds the number of registered recipients. */
+	int32 NumRecipients = 0;
+
+	/** Holds the number of subscriptions, including topic subscriptions. */
+	int32 NumSubscriptions = 0;
+
+	/** Holds the number of message interceptors. */
+	int32 NumInterceptors = 0;
+
+	/** Holds the number of pending requests. */
+	int32 NumPendingRequests = 0;
+
+	/** Holds the size of the recipient, subscription, interceptor, group and request tables (in bytes). */
+	int64 TableBytes = 0;
+
+	/** Holds the number of retained messages. */
+	int32 NumRetainedMessages = 0;
+
+	/** Holds the number of spatial subscribers. */
+	int32 NumSpatialSubscribers = 0;
+
+	/** Holds the number of keys in the deduplication windows. */
+	int32 NumDeduplicationKeys = 0;
+
+	/** Holds the size of the retained message, spatial index and deduplication tables (in bytes). */
+	int64 IndexBytes = 0;
+
+	/** Holds the number of commands waiting to be processed. */
+	int32 NumQueuedCommands = 0;
+
+	/** Holds the size of the command lanes and pending deliveries (in bytes). */
+	int64 QueueBytes = 0;
+
+	/** Holds the number of delayed and periodic messages and request timeouts. */
+	int32 NumDelayedMessages = 0;
+
+	/** Holds the size of the timing wheels and periodic messages (in bytes). */
+	int64 DelayedBytes = 0;
+
+	/** Holds the number of messages in the tracer history. */
+	int32 NumTracedMessages = 0;
+
+	/** Holds the size of the trace buffers and the estimated size of the tracer history (in bytes). */
+	int64 TracerBytes = 0;
+
+	/** Gets the total size (in bytes). */
+	int64 GetTotalBytes() const
+	{
+		return TableBytes + IndexBytes + QueueBytes + DelayedBytes + TracerBytes;
+	}
+
+	/** Adds the memory footprint of another router or tracer. */
+	void Accumulate(const FSGMessageMemoryReport& Other)
+	{
+		NumRecipients += Other.NumRecipients;
+		NumSubscriptions += Other.NumSubscriptions;
+		NumInterceptors += Other.NumInterceptors;
+		NumPendingRequests += Other.NumPendingRequests;
+		TableBytes += Other.TableBytes;
+		NumRetainedMessages += Other.NumRetainedMessages;
+		NumSpatialSubscribers += Other.NumSpatialSubscribers;
+		NumDeduplicationKeys += Other.NumDeduplicationKeys;
+		IndexBytes += Other.IndexBytes;
+		NumQueuedCommands += Other.NumQueuedCommands;
+		QueueBytes += Other.QueueBytes;
+		NumDelayedMessages += Other.NumDelayedMessages;
+		DelayedBytes += Other.DelayedBytes;
+		NumTracedMessages += Other.NumTracedMessages;
+		TracerBytes += Other.TracerBytes;
+	}
+};
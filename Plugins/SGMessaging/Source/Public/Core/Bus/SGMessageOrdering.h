@@ -0,0 +1,46 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessageContext.h"
+
+
+/**
+ * Partitioned ordering of messages to AnyThread recipients.
+ *
+ * Senders may annotate a message with an ordering key, e.g. the name or identifier of the entity that
+ * the message is about. The router hashes the key into one of USGMessagingSettings::RouterOrderingPartitions
+ * partitions, and delivers each recipient's messages of a partition in order on a task worker, while the
+ * partitions of the recipient run in parallel. Messages with the same key are therefore handled in the
+ * order they were routed, while messages with different keys may be handled concurrently by the same recipient.
+ *
+ * Keyed messages are not ordered relative to the recipient's unkeyed messages. Recipients on named threads
+ * handle all their messages in order anyway, so the key doesn't change anything for them.
+ */
+namespace SGMessageOrdering
+{
+	/** Name of the message annotation that holds the ordering key. */
+	static const FName KeyAnnotation(TEXT("SGOrderingKey"));
+
+	/**
+	 * Gets the hash of a message's ordering key.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutHash Will hold the hash of the ordering key.
+	 * @return true if the message has an ordering key, false otherwise.
+	 */
+	inline bool GetOrderingKeyHash(const ISGMessageContext& Context, uint32& OutHash)
+	{
+		const FString* Key = Context.GetAnnotations().Find(KeyAnnotation);
+
+		if ((Key == nullptr) || Key->IsEmpty())
+		{
+			return false;
+		}
+
+		OutHash = GetTypeHash(*Key);
+
+		return true;
+	}
+}
@@ -0,0 +1,91 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Bus/SGMessageMemory.h"
+
+
+/**
+ * Structure for the allocation statistics of the message pool.
+ */
+struct FSGMessagePoolStatistics
+{
+	/** Holds the number of allocations that were served by the pool instead of the system allocator. */
+	int64 NumPooledAllocations = 0;
+
+	/** Holds the number of allocations that were too large for the pool. */
+	int64 NumUnpooledAllocations = 0;
+
+	/** Holds the number of chunks the pool requested from the system allocator. */
+	int32 NumChunks = 0;
+
+	/** Holds the total size of all chunks (in bytes). */
+	int64 ChunkBytes = 0;
+};
+
+
+/**
+ * Implements the allocator for message payloads.
+ *
+ * Blocks are carved from 64 KB chunks in a few size classes and recycled through per thread free
+ * lists, which exchange bundles of blocks with a shared free list, so that the shared list's lock is
+ * taken once per bundle rather than once per message. Chunks are never returned to the system.
+ *
+ * The pool is shared by all message buses, because messages may outlive the bus they were sent on.
+ * Memory that wasn't allocated by the pool may be passed to Free as well; it is handed to FMemory.
+ */
+class SGMESSAGING_API FSGMessagePool
+{
+public:
+
+	/**
+	 * Allocates a block of memory.
+	 *
+	 * @param Size The number of bytes to allocate.
+	 * @param Alignment The alignment of the block.
+	 * @return The allocated memory.
+	 */
+	static void* Malloc(SIZE_T Size, uint32 Alignment = DEFAULT_ALIGNMENT);
+
+	/**
+	 * Frees a block of memory.
+	 *
+	 * @param Pointer The memory to free (may be nullptr, or memory from FMemory::Malloc).
+	 */
+	static void Free(void* Pointer);
+
+	/**
+	 * Checks whether the given memory was allocated by the pool.
+	 *
+	 * @param Pointer The memory to check.
+	 * @return true if the memory belongs to the pool, false otherwise.
+	 */
+	static bool Owns(const void* Pointer);
+
+	/**
+	 * Gets the allocation statistics.
+	 *
+	 * Counts are flushed from the threads' caches in batches, so they may lag slightly behind.
+	 *
+	 * @return The statistics.
+	 */
+	static FSGMessagePoolStatistics GetStatistics();
+
+	/**
+	 * Creates an object in memory from the pool.
+	 *
+	 * @param Args The constructor arguments.
+	 * @return The new object.
+	 */
+	template<typename T, typename... ArgTypes>
+	static T* New(ArgTypes&&... Args)
+	{
+		void* Buffer = Malloc(sizeof(T), alignof(T));
+
+		// the object lives in the pool, but whatever its constructor allocates is a payload as well
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+
+		return new(Buffer) T(Forward<ArgTypes>(Args)...);
+	}
+};
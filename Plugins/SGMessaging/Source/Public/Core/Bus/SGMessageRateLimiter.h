@@ -0,0 +1,203 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Templates/Function.h"
+#include "Core/Interface/ISGMessageBusListener.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include <atomic>
+
+struct FSGMessageRateLimit;
+
+
+/**
+ * Implements a lock-free token bucket.
+ *
+ * The bucket is stored as the time at which it is full again (the generic cell rate algorithm), which
+ * behaves like a bucket that refills at the configured rate up to its burst size, but is a single atomic
+ * value, so any number of sending threads can take tokens without locking.
+ */
+class SGMESSAGING_API FSGMessageTokenBucket
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param MessagesPerSecond The refill rate.
+	 * @param InBurst The bucket size (0 = one second worth of messages).
+	 */
+	FSGMessageTokenBucket(double MessagesPerSecond, int32 InBurst);
+
+public:
+
+	/**
+	 * Takes tokens from the bucket.
+	 *
+	 * @param Count The number of tokens to take.
+	 * @param NowCycles The current time (in CPU cycles).
+	 * @return true if the bucket held enough tokens, false otherwise (no tokens are taken then).
+	 */
+	bool TryAcquire(int32 Count, uint64 NowCycles);
+
+	/**
+	 * Updates whether the bucket rejects messages.
+	 *
+	 * @param bInLimited Whether the last message was rejected.
+	 * @return true if the state changed, false otherwise.
+	 */
+	bool SetLimited(bool bInLimited)
+	{
+		return (bLimited.load(std::memory_order_relaxed) != bInLimited) && (bLimited.exchange(bInLimited, std::memory_order_relaxed) != bInLimited);
+	}
+
+	/** Gets the bucket size. */
+	int32 GetBurst() const
+	{
+		return Burst;
+	}
+
+	/** Gets the number of messages the bucket rejected so far. */
+	int64 GetNumRejected() const
+	{
+		return NumRejected.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	/** Holds the time it takes to refill a token (in CPU cycles). */
+	uint64 IntervalCycles;
+
+	/** Holds the time it takes to refill the whole bucket (in CPU cycles). */
+	uint64 ToleranceCycles;
+
+	/** Holds the time at which the bucket is full again (in CPU cycles). */
+	std::atomic<uint64> FullCycles;
+
+	/** Holds the number of messages the bucket rejected. */
+	std::atomic<int64> NumRejected;
+
+	/** Holds the bucket size. */
+	int32 Burst;
+
+	/** Holds a flag indicating whether the last message was rejected. */
+	std::atomic<bool> bLimited;
+};
+
+
+/**
+ * Implements the rate limits of a message bus.
+ *
+ * Each sender has a bucket of its own, and each limited message type has a bucket that all senders share,
+ * see USGMessagingSettings::SenderRateLimit and USGMessagingSettings::MessageTypeRateLimits. Limits are
+ * checked on the sending thread before a message context is created, so a runaway sender costs a bucket
+ * lookup per message instead of a trip through the routers.
+ *
+ * A handler is called when a sender or message type starts or stops exceeding its limit, so that notifications
+ * are bounded by the state changes rather than by the number of rejected messages.
+ *
+ * This class is thread-safe.
+ */
+class SGMESSAGING_API FSGMessageRateLimiter
+{
+public:
+
+	/** Default constructor (reads the limits from the messaging settings). */
+	FSGMessageRateLimiter();
+
+public:
+
+	/**
+	 * Checks whether any rate limits are configured.
+	 *
+	 * @return true if limits are enforced, false otherwise.
+	 */
+	bool IsEnabled() const
+	{
+		return bHasSenderLimit || (TypeBuckets.Num() > 0);
+	}
+
+	/**
+	 * Takes tokens for messages of a sender.
+	 *
+	 * The sender's own limit is checked first, so a sender that exceeds it doesn't use up the tokens
+	 * that all senders of the message type share.
+	 *
+	 * @param Sender The address of the sender.
+	 * @param MessageType The type (or tag) of the messages.
+	 * @param Count The number of messages.
+	 * @return true if the messages are within the limits, false if they must be dropped.
+	 */
+	bool TryAcquire(const FSGMessageAddress& Sender, const FName& MessageType, int32 Count = 1);
+
+	/**
+	 * Takes tokens from the bucket of a sender only.
+	 *
+	 * @param Sender The address of the sender.
+	 * @param Count The number of messages.
+	 * @return true if the messages are within the limit, false if they must be dropped.
+	 * @see TryAcquire
+	 */
+	bool TryAcquireSender(const FSGMessageAddress& Sender, int32 Count);
+
+	/**
+	 * Takes tokens from the bucket of a message type only.
+	 *
+	 * All senders share the bucket, so its notifications have no sender address.
+	 *
+	 * @param MessageType The type (or tag) of the messages.
+	 * @param Count The number of messages.
+	 * @return true if the messages are within the limit, false if they must be dropped.
+	 * @see TryAcquire
+	 */
+	bool TryAcquireType(const FName& MessageType, int32 Count);
+
+	/**
+	 * Removes the bucket of a sender that went away.
+	 *
+	 * @param Sender The address of the sender.
+	 */
+	void RemoveSender(const FSGMessageAddress& Sender);
+
+	/**
+	 * Sets the handler that is called when a sender or message type starts or stops exceeding its limit.
+	 *
+	 * The handler is called on the sending thread.
+	 *
+	 * @param InStateChangedHandler The handler.
+	 */
+	void SetStateChangedHandler(TFunction<void(const FSGMessageBackpressureEvent&)>&& InStateChangedHandler)
+	{
+		StateChangedHandler = MoveTemp(InStateChangedHandler);
+	}
+
+private:
+
+	/** Reports a state change of a bucket if there was one. */
+	void UpdateState(FSGMessageTokenBucket& Bucket, bool bLimited, const FSGMessageAddress& Sender, const FName& MessageType);
+
+private:
+
+	/** Holds the limit of each sender. */
+	double SenderMessagesPerSecond;
+
+	/** Holds the bucket size of each sender. */
+	int32 SenderBurst;
+
+	/** Holds a flag indicating whether senders are limited. */
+	bool bHasSenderLimit;
+
+	/** Holds the buckets of the senders. */
+	TMap<FSGMessageAddress, TUniquePtr<FSGMessageTokenBucket>> SenderBuckets;
+
+	/** Guards the sender buckets. */
+	mutable FRWLock SenderBucketsLock;
+
+	/** Holds the buckets of the limited message types (never changes after construction). */
+	TMap<FName, TUniquePtr<FSGMessageTokenBucket>> TypeBuckets;
+
+	/** Holds the handler for state changes. */
+	TFunction<void(const FSGMessageBackpressureEvent&)> StateChangedHandler;
+};
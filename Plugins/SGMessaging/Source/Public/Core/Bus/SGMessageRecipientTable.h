@@ -0,0 +1,215 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageReceiver.h"
+
+/**
+ * Implements the router's table of registered recipients.
+ *
+ * Each registered address is assigned a dense 32-bit handle made of a slot index and the slot's
+ * generation. Resolving a handle is an array access, and handles of unregistered addresses stop
+ * resolving when their slot is reused, so holders of handles don't need to be told about removals.
+ * Whether a recipient is local is cached when it is added. Addresses are only hashed when they are
+ * turned into handles; message addresses remain the public and network identity of recipients.
+ *
+ * This class is not thread-safe. The router owns its table.
+ */
+class FSGMessageRecipientTable
+{
+public:
+
+	/** The handle that never resolves. */
+	static constexpr uint32 InvalidHandle = 0;
+
+public:
+
+	/**
+	 * Adds or replaces the recipient of an address.
+	 *
+	 * Replacing a recipient assigns a new handle, so that handles never resolve to another recipient.
+	 *
+	 * @param Address The address of the recipient.
+	 * @param Recipient The recipient to add.
+	 * @return The handle of the recipient.
+	 */
+	uint32 Add(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
+	{
+		int32 Index = INDEX_NONE;
+
+		if (const uint32* ExistingHandle = Handles.Find(Address))
+		{
+			Index = GetIndex(*ExistingHandle);
+		}
+		else if (FreeSlots.Num() > 0)
+		{
+			Index = FreeSlots.Pop(false);
+		}
+		else
+		{
+			Index = Recipients.AddDefaulted();
+			Generations.Add(0);
+			LocalFlags.Add(false);
+
+			checkSlow((uint32)Index <= IndexMask);
+		}
+
+		Recipients[Index] = Recipient;
+		LocalFlags[Index] = Recipient->IsLocal();
+
+		// generation 0 is skipped, so that no handle equals InvalidHandle
+		Generations[Index] = (Generations[Index] + 1) & GenerationMask;
+
+		if (Generations[Index] == 0)
+		{
+			Generations[Index] = 1;
+		}
+
+		const uint32 Handle = MakeHandle(Index);
+		Handles.Add(Address, Handle);
+
+		return Handle;
+	}
+
+	/**
+	 * Removes the recipient of an address.
+	 *
+	 * @param Address The address to remove.
+	 * @return true if the address was registered, false otherwise.
+	 */
+	bool Remove(const FSGMessageAddress& Address)
+	{
+		uint32 Handle = InvalidHandle;
+
+		if (!Handles.RemoveAndCopyValue(Address, Handle))
+		{
+			return false;
+		}
+
+		const int32 Index = GetIndex(Handle);
+
+		// the generation changes when the slot is reused, which invalidates outstanding handles
+		Recipients[Index].Reset();
+		Generations[Index] = (Generations[Index] + 1) & GenerationMask;
+		FreeSlots.Add(Index);
+
+		return true;
+	}
+
+	/**
+	 * Removes all recipients at once.
+	 *
+	 * Slot generations start over, so this must only be called once no handles are resolved anymore.
+	 */
+	void Empty()
+	{
+		Handles.Empty();
+		Recipients.Empty();
+		Generations.Empty();
+		LocalFlags.Empty();
+		FreeSlots.Empty();
+	}
+
+	/**
+	 * Gets the handle of an address.
+	 *
+	 * @param Address The address to look up.
+	 * @return The handle, or InvalidHandle if the address isn't registered.
+	 */
+	uint32 FindHandle(const FSGMessageAddress& Address) const
+	{
+		return Handles.FindRef(Address);
+	}
+
+	/**
+	 * Gets the recipient of a handle.
+	 *
+	 * @param Handle The handle to resolve.
+	 * @return The recipient, or nullptr if the handle is stale or the recipient was destroyed.
+	 */
+	TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Pin(uint32 Handle) const
+	{
+		const int32 Index = GetIndex(Handle);
+
+		if (!Recipients.IsValidIndex(Index) || (MakeHandle(Index) != Handle))
+		{
+			return nullptr;
+		}
+
+		return Recipients[Index].Pin();
+	}
+
+	/**
+	 * Checks whether the recipient of a handle is local.
+	 *
+	 * @param Handle The handle of a recipient that was pinned successfully.
+	 * @return true if the recipient is local, false otherwise.
+	 * @see Pin
+	 */
+	bool IsLocal(uint32 Handle) const
+	{
+		return LocalFlags[GetIndex(Handle)];
+	}
+
+	/**
+	 * Gets the number of registered addresses.
+	 *
+	 * @return Number of addresses.
+	 */
+	int32 Num() const
+	{
+		return Handles.Num();
+	}
+
+	/**
+	 * Gets the size of the memory allocated by this table.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Handles.GetAllocatedSize() + Recipients.GetAllocatedSize() + Generations.GetAllocatedSize() + LocalFlags.GetAllocatedSize() + FreeSlots.GetAllocatedSize();
+	}
+
+private:
+
+	/** Number of bits of a handle that hold the slot index. */
+	static constexpr uint32 IndexBits = 20;
+
+	/** Mask of the slot index bits. */
+	static constexpr uint32 IndexMask = (1u << IndexBits) - 1;
+
+	/** Mask of a slot generation (the remaining bits). */
+	static constexpr uint32 GenerationMask = (1u << (32 - IndexBits)) - 1;
+
+	/** Gets the slot index of a handle. */
+	static int32 GetIndex(uint32 Handle)
+	{
+		return (int32)(Handle & IndexMask);
+	}
+
+	/** Makes the current handle of a slot. */
+	uint32 MakeHandle(int32 Index) const
+	{
+		return (Generations[Index] << IndexBits) | (uint32)Index;
+	}
+
+private:
+
+	/** Holds the handles of the registered addresses. */
+	TMap<FSGMessageAddress, uint32> Handles;
+
+	/** Holds the recipient of each slot. */
+	TArray<TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> Recipients;
+
+	/** Holds the generation of each slot (0 = never assigned). */
+	TArray<uint32> Generations;
+
+	/** Holds whether the recipient of each slot is local. */
+	TArray<bool> LocalFlags;
+
+	/** Holds the indices of unused slots. */
+	TArray<int32> FreeSlots;
+};
@@ -0,0 +1,184 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "Core/Bus/SGMessageCapture.h"
+#include <atomic>
+
+class FRunnableThread;
+class ISGMessageBus;
+
+
+/**
+ * Enumerates the speeds at which captured messages are replayed.
+ */
+enum class ESGMessageReplaySpeed : uint8
+{
+	/** Messages are sent with their captured timing. */
+	Original,
+
+	/** Messages are sent as fast as possible. */
+	Max
+};
+
+
+/**
+ * Implements the replay of a message capture into a message bus.
+ *
+ * Each captured message is sent again on behalf of its captured sender, so that router and handler
+ * changes can be benchmarked against recorded traffic. Published messages reach the bus' current
+ * subscribers. Messages that were sent to recipients only arrive if endpoints with the captured
+ * addresses are registered, or if the addresses are mapped to current endpoints (see SetAddressMap).
+ *
+ * Dynamic messages only get the parameters that FSGMessageReader::ReadMessage can decode, and
+ * messages whose payload wasn't captured are skipped.
+ *
+ *		FSGMessageReplay Replay(Bus);
+ *
+ *		if (Replay.Load(TEXT("Saved/Traffic.sgcapture")))
+ *		{
+ *			Replay.Replay(ESGMessageReplaySpeed::Max);
+ *		}
+ *
+ * @see FSGMessageCapture
+ */
+class SGMESSAGING_API FSGMessageReplay
+	: public FRunnable
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InBus The message bus to replay the messages into.
+	 */
+	explicit FSGMessageReplay(const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus);
+
+	/** Destructor. */
+	virtual ~FSGMessageReplay();
+
+public:
+
+	/**
+	 * Loads the messages to replay.
+	 *
+	 * @param Filename The name of the capture file.
+	 * @return true if the capture was loaded, false otherwise.
+	 */
+	bool Load(const FString& Filename);
+
+	/**
+	 * Maps captured sender and recipient addresses to the addresses used in the replay.
+	 *
+	 * @param InAddressMap The replay addresses by captured address (unmapped addresses are kept).
+	 */
+	void SetAddressMap(const TMap<FSGMessageAddress, FSGMessageAddress>& InAddressMap)
+	{
+		AddressMap = InAddressMap;
+	}
+
+	/**
+	 * Replays the loaded messages on the calling thread.
+	 *
+	 * @param Speed The speed at which messages are sent.
+	 * @return The number of messages that were sent.
+	 * @see Start
+	 */
+	int32 Replay(ESGMessageReplaySpeed Speed);
+
+	/**
+	 * Replays the loaded messages on a separate thread.
+	 *
+	 * @param Speed The speed at which messages are sent.
+	 * @return true if the replay was started, false if a replay is running.
+	 * @see IsReplaying, Replay
+	 */
+	bool Start(ESGMessageReplaySpeed Speed);
+
+	/** Checks whether messages are being replayed. */
+	bool IsReplaying() const
+	{
+		return bReplaying.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of loaded messages. */
+	int32 GetNumMessages() const
+	{
+		return Messages.Num();
+	}
+
+	/** Gets the number of messages that the current or last replay sent. */
+	int32 GetNumReplayedMessages() const
+	{
+		return NumReplayedMessages.load(std::memory_order_relaxed);
+	}
+
+public:
+
+	//~ FRunnable interface
+
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+
+	class FSender;
+
+	/** Gets the replay address of a captured address. */
+	const FSGMessageAddress& MapAddress(const FSGMessageAddress& Address) const
+	{
+		const FSGMessageAddress* MappedAddress = AddressMap.Find(Address);
+
+		return (MappedAddress != nullptr) ? *MappedAddress : Address;
+	}
+
+	/**
+	 * Replays the loaded messages (a replay must have been claimed via bReplaying).
+	 *
+	 * @param Speed The speed at which messages are sent.
+	 * @return The number of messages that were sent.
+	 */
+	int32 ReplayMessages(ESGMessageReplaySpeed Speed);
+
+	/**
+	 * Sends a captured message.
+	 *
+	 * @param Message The captured message.
+	 * @return true if the message was sent, false if it was skipped.
+	 */
+	bool ReplayMessage(const FSGCapturedMessage& Message);
+
+private:
+
+	/** Holds the message bus. */
+	TSharedRef<ISGMessageBus, ESPMode::ThreadSafe> Bus;
+
+	/** Holds the captured messages (ordered by the time they were sent). */
+	TArray<FSGCapturedMessage> Messages;
+
+	/** Holds the replay addresses by captured address. */
+	TMap<FSGMessageAddress, FSGMessageAddress> AddressMap;
+
+	/** Holds the senders by address. */
+	TMap<FSGMessageAddress, TSharedRef<FSender, ESPMode::ThreadSafe>> Senders;
+
+	/** Holds the message structures by path name (nullptr if the structure doesn't exist). */
+	TMap<FString, UScriptStruct*> TypeInfos;
+
+	/** Holds the speed of the threaded replay. */
+	ESGMessageReplaySpeed ThreadSpeed;
+
+	/** Holds the replay thread. */
+	FRunnableThread* Thread;
+
+	/** Holds a flag indicating that a replay is running. */
+	std::atomic<bool> bReplaying;
+
+	/** Holds a flag indicating that the replay was canceled. */
+	std::atomic<bool> bCanceled;
+
+	/** Holds the number of replayed messages. */
+	std::atomic<int32> NumReplayedMessages;
+};
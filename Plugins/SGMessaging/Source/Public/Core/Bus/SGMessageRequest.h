@@ -0,0 +1,287 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/Future.h"
+#include "Core/Common/SGMessageHandlers.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include <atomic>
+
+
+/**
+ * Enumerates the ways a request can end.
+ *
+ * @see FSGMessageReply
+ */
+enum class ESGMessageRequestResult : uint8
+{
+	/** The recipient replied. */
+	Replied,
+
+	/** No reply arrived before the request timed out. */
+	TimedOut,
+
+	/** The request was cancelled, i.e. because the message bus shut down. */
+	Cancelled,
+
+	/** The request message was dropped before it reached the recipient, i.e. by a full queue or because the recipient is unknown. */
+	Dropped
+};
+
+
+/**
+ * Structure for the outcome of a request.
+ *
+ * @see FSGMessageEndpoint::Request
+ */
+struct FSGMessageReply
+{
+	/** Holds the way the request ended. */
+	ESGMessageRequestResult Result;
+
+	/** Holds the context of the reply message (only if the recipient replied). */
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+	/** Default constructor. */
+	FSGMessageReply()
+		: Result(ESGMessageRequestResult::Cancelled)
+	{ }
+
+	/** Creates and initializes a new instance. */
+	FSGMessageReply(ESGMessageRequestResult InResult, const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& InContext = nullptr)
+		: Result(InResult)
+		, Context(InContext)
+	{ }
+
+public:
+
+	/**
+	 * Checks whether the recipient replied.
+	 *
+	 * @return true if a reply arrived, false if the request timed out or was cancelled.
+	 */
+	bool IsReplied() const
+	{
+		return (Result == ESGMessageRequestResult::Replied) && Context.IsValid();
+	}
+
+	/**
+	 * Gets the reply message.
+	 *
+	 * @param MessageType The type of the reply message.
+	 * @return The reply message, or nullptr if there was no reply or it is of another type.
+	 */
+	template<typename MessageType>
+	const MessageType* GetMessage() const
+	{
+		return IsReplied() ? SGMessageHandlers::CastMessage<MessageType>(*Context) : nullptr;
+	}
+};
+
+
+/**
+ * Implements a request that waits for its reply.
+ *
+ * Pending requests are owned by the router shard that matches their replies. Whichever of the reply,
+ * the timeout or a cancellation comes first completes the request; everything after that is ignored.
+ */
+class FSGMessagePendingRequest
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InCorrelationId The identifier that the reply refers to.
+	 * @param InTimerId The identifier of the timeout in the router's timing wheel.
+	 * @param InTimeoutTick The monotonic tick at which the request times out (0 = never).
+	 */
+	FSGMessagePendingRequest(uint64 InCorrelationId, uint64 InTimerId, uint64 InTimeoutTick)
+		: CorrelationId(InCorrelationId)
+		, TimerId(InTimerId)
+		, TimeoutTick(InTimeoutTick)
+		, bCompleted(false)
+	{ }
+
+public:
+
+	/**
+	 * Completes the request, unless it was already completed.
+	 *
+	 * @param Reply The outcome of the request.
+	 * @return true if the request was completed, false if it had already been completed.
+	 */
+	bool Complete(FSGMessageReply&& Reply)
+	{
+		bool bExpected = false;
+
+		if (!bCompleted.compare_exchange_strong(bExpected, true, std::memory_order_acq_rel))
+		{
+			return false;
+		}
+
+		Promise.SetValue(MoveTemp(Reply));
+
+		return true;
+	}
+
+	/**
+	 * Gets the identifier that the reply refers to.
+	 *
+	 * @return Correlation identifier.
+	 */
+	uint64 GetCorrelationId() const
+	{
+		return CorrelationId;
+	}
+
+	/**
+	 * Gets the future that is completed with the outcome of the request.
+	 *
+	 * May only be called once.
+	 *
+	 * @return The future.
+	 */
+	TFuture<FSGMessageReply> GetFuture()
+	{
+		return Promise.GetFuture();
+	}
+
+	/**
+	 * Gets the identifier of the timeout in the router's timing wheel.
+	 *
+	 * @return Timer identifier.
+	 */
+	uint64 GetTimerId() const
+	{
+		return TimerId;
+	}
+
+	/**
+	 * Gets the monotonic tick at which the request times out.
+	 *
+	 * @return Timeout tick (0 = never).
+	 * @see FSGMessageTimingWheel::GetMonotonicTick
+	 */
+	uint64 GetTimeoutTick() const
+	{
+		return TimeoutTick;
+	}
+
+	/**
+	 * Checks whether the request was completed.
+	 *
+	 * @return true if completed, false if still waiting for its reply.
+	 */
+	bool IsCompleted() const
+	{
+		return bCompleted.load(std::memory_order_acquire);
+	}
+
+private:
+
+	/** Holds the promise for the outcome of the request. */
+	TPromise<FSGMessageReply> Promise;
+
+	/** Holds the identifier that the reply refers to. */
+	const uint64 CorrelationId;
+
+	/** Holds the identifier of the timeout in the router's timing wheel. */
+	const uint64 TimerId;
+
+	/** Holds the monotonic tick at which the request times out (0 = never). */
+	const uint64 TimeoutTick;
+
+	/** Holds a flag indicating whether the request was completed. */
+	std::atomic<bool> bCompleted;
+};
+
+
+namespace SGMessageRequest
+{
+	/** Name of the message annotation that holds the correlation identifier of a request. */
+	static const FName CorrelationIdAnnotation(TEXT("SGCorrelationId"));
+
+	/** Name of the message annotation that holds the correlation identifier of the request a reply answers. */
+	static const FName InReplyToAnnotation(TEXT("SGInReplyTo"));
+
+	/** Number of low correlation identifier bits that hold the index of the router shard owning the request. */
+	constexpr uint64 ShardBits = 8;
+
+	/**
+	 * Gets the correlation identifier of a request message.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutCorrelationId Will hold the correlation identifier.
+	 * @return true if the message is a request, false otherwise.
+	 */
+	inline bool GetCorrelationId(const ISGMessageContext& Context, uint64& OutCorrelationId)
+	{
+		const FSGMessageAnnotations& Annotations = Context.GetAnnotations();
+
+		if (Annotations.Num() == 0)
+		{
+			return false;
+		}
+
+		const FString* CorrelationId = Annotations.Find(CorrelationIdAnnotation);
+
+		if (CorrelationId == nullptr)
+		{
+			return false;
+		}
+
+		OutCorrelationId = 0;
+		LexFromString(OutCorrelationId, **CorrelationId);
+
+		return (OutCorrelationId != 0);
+	}
+
+	/**
+	 * Gets the correlation identifier of the request that a message replies to.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutCorrelationId Will hold the correlation identifier.
+	 * @return true if the message is a reply, false otherwise.
+	 */
+	inline bool GetInReplyTo(const ISGMessageContext& Context, uint64& OutCorrelationId)
+	{
+		const FSGMessageAnnotations& Annotations = Context.GetAnnotations();
+
+		if (Annotations.Num() == 0)
+		{
+			return false;
+		}
+
+		const FString* InReplyTo = Annotations.Find(InReplyToAnnotation);
+
+		if (InReplyTo == nullptr)
+		{
+			return false;
+		}
+
+		OutCorrelationId = 0;
+		LexFromString(OutCorrelationId, **InReplyTo);
+
+		return (OutCorrelationId != 0);
+	}
+
+	/**
+	 * Creates the annotations for a reply to the given request.
+	 *
+	 * Messages that weren't sent as requests get no annotations, so replying to them is a plain send.
+	 *
+	 * @param RequestContext The context of the request message.
+	 * @return The reply annotations.
+	 */
+	inline FSGMessageAnnotations MakeReplyAnnotations(const ISGMessageContext& RequestContext)
+	{
+		if (const FString* CorrelationId = RequestContext.GetAnnotations().Find(CorrelationIdAnnotation))
+		{
+			return FSGMessageAnnotations({ { InReplyToAnnotation, *CorrelationId } });
+		}
+
+		return FSGMessageAnnotations();
+	}
+}
@@ -5,11 +5,33 @@
 #include "CoreMinimal.h"
 #include "Containers/Queue.h"
 #include "HAL/Runnable.h"
+#include "Misc/ScopeLock.h"
+#include "Misc/ScopeRWLock.h"
 #include "Misc/SingleThreadRunnable.h"
 #include "Templates/Atomic.h"
+#include "Tasks/Pipe.h"
+#include "Tasks/Task.h"
+#include "Core/Interface/ISGMessageBusListener.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageTracer.h"
 #include "Core/Bus/SGMessageTracer.h"
+#include "Core/Bus/SGMessageCapture.h"
+#include "Core/Bus/SGMessageCommandRing.h"
+#include "Core/Bus/SGMessageTimingWheel.h"
+#include "Core/Bus/SGMessageStatistics.h"
+#include "Core/Bus/SGMessageDispatchTask.h"
+#include "Core/Bus/SGMessageDeduplication.h"
+#include "Core/Bus/SGMessageDurableQueue.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessageOrdering.h"
+#include "Core/Bus/SGMessageRecipientTable.h"
+#include "Core/Bus/SGMessageRequest.h"
+#include "Core/Bus/SGMessageRouterPool.h"
+#include "Core/Bus/SGMessageSpatialIndex.h"
+#include "Core/Bus/SGMessageSubscriptionTable.h"
+#include "Core/Message/SGMessageTagBuilder.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include <atomic>
 
 class ISGMessageInterceptor;
 class ISGMessageReceiver;
@@ -25,13 +47,23 @@ class FSGMessageRouter
 	: public FRunnable
 	, private FSingleThreadRunnable
 {
-	DECLARE_DELEGATE(CommandDelegate)
-
 public:
 
 	/** Default constructor. */
 	FSGMessageRouter();
 
+	/**
+	 * Creates and initializes a new instance that reports to an existing tracer, statistics and capture.
+	 *
+	 * Used by sharded buses so that all router shards feed the same tracer, counters and capture file.
+	 *
+	 * @param InTracer The message tracer to use.
+	 * @param InStatistics The message statistics to update.
+	 * @param InCapture The message capture to feed.
+	 * @param bInNotifyRegistrations Whether listeners are notified about registrations (only one shard should).
+	 */
+	FSGMessageRouter(const TSharedRef<FSGMessageTracer, ESPMode::ThreadSafe>& InTracer, const TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe>& InStatistics, const TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe>& InCapture, bool bInNotifyRegistrations = true);
+
 	/** Destructor. */
 	~FSGMessageRouter();
 
@@ -45,7 +77,10 @@ public:
 	 */
 	FORCEINLINE void AddInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleAddInterceptor, Interceptor, MessageType));
+		FSGRouterCommand Command(ESGRouterCommand::AddInterceptor);
+		Command.Interceptor = Interceptor;
+		Command.MessageType = MessageType;
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -56,7 +91,38 @@ public:
 	 */
 	FORCEINLINE void AddRecipient(const FSGMessageAddress& Address, const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleAddRecipient, Address, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>(Recipient)));
+		FSGRouterCommand Command(ESGRouterCommand::AddRecipient);
+		Command.Address = Address;
+		Command.Receiver = Recipient;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Adds a group of recipient addresses.
+	 *
+	 * @param Group The address of the group.
+	 * @param GroupName The name of the group (for debugging purposes).
+	 */
+	FORCEINLINE void AddAddressGroup(const FSGMessageAddress& Group, const FName& GroupName)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::AddAddressGroup);
+		Command.Address = Group;
+		Command.MessageType = GroupName;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Adds recipient addresses to a group.
+	 *
+	 * @param Group The address of the group.
+	 * @param Members The addresses to add.
+	 */
+	FORCEINLINE void AddAddressGroupMembers(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::AddAddressGroupMembers);
+		Command.Address = Group;
+		Command.Addresses.Append(Members.GetData(), Members.Num());
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -66,7 +132,21 @@ public:
 	 */
 	FORCEINLINE void AddSubscription(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleAddSubscriber, Subscription));
+		FSGRouterCommand Command(ESGRouterCommand::AddSubscription);
+		Command.Subscription = Subscription;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Adds several subscriptions with a single command.
+	 *
+	 * @param Subscriptions The subscriptions to add.
+	 */
+	FORCEINLINE void AddSubscriptions(TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>&& Subscriptions)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::AddSubscriptions);
+		Command.Subscriptions = MoveTemp(Subscriptions);
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -79,6 +159,26 @@ public:
 		return Tracer;
 	}
 
+	/**
+	 * Gets the message statistics.
+	 *
+	 * @return The message statistics.
+	 */
+	FORCEINLINE TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> GetStatistics() const
+	{
+		return Statistics;
+	}
+
+	/**
+	 * Gets the message capture.
+	 *
+	 * @return The message capture.
+	 */
+	FORCEINLINE TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> GetCapture() const
+	{
+		return Capture;
+	}
+
 	/**
 	 * Removes a message interceptor.
 	 *
@@ -87,7 +187,10 @@ public:
 	 */
 	FORCEINLINE void RemoveInterceptor(const TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe>& Interceptor, const FName& MessageType)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleRemoveInterceptor, Interceptor, MessageType));
+		FSGRouterCommand Command(ESGRouterCommand::RemoveInterceptor);
+		Command.Interceptor = Interceptor;
+		Command.MessageType = MessageType;
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -97,7 +200,35 @@ public:
 	 */
 	FORCEINLINE void RemoveRecipient(const FSGMessageAddress& Address)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleRemoveRecipient, Address));
+		FSGRouterCommand Command(ESGRouterCommand::RemoveRecipient);
+		Command.Address = Address;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Removes a group of recipient addresses.
+	 *
+	 * @param Group The address of the group.
+	 */
+	FORCEINLINE void RemoveAddressGroup(const FSGMessageAddress& Group)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::RemoveAddressGroup);
+		Command.Address = Group;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Removes recipient addresses from a group.
+	 *
+	 * @param Group The address of the group.
+	 * @param Members The addresses to remove.
+	 */
+	FORCEINLINE void RemoveAddressGroupMembers(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::RemoveAddressGroupMembers);
+		Command.Address = Group;
+		Command.Addresses.Append(Members.GetData(), Members.Num());
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -108,28 +239,211 @@ public:
 	 */
 	FORCEINLINE void RemoveSubscription(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleRemoveSubscriber, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>(Subscriber), MessageType));
+		FSGRouterCommand Command(ESGRouterCommand::RemoveSubscription);
+		Command.Receiver = Subscriber;
+		Command.MessageType = MessageType;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Removes the subscriptions of a subscriber to several message types with a single command.
+	 *
+	 * @param Subscriber The subscriber to stop routing messages to.
+	 * @param MessageTypes The types of messages to unsubscribe from.
+	 */
+	FORCEINLINE void RemoveSubscriptions(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArray<FName>&& MessageTypes)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::RemoveSubscriptions);
+		Command.Receiver = Subscriber;
+		Command.MessageTypes = MoveTemp(MessageTypes);
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Allocates an identifier for a delayed message.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @return A new, non-zero delayed message identifier.
+	 * @see CancelDelayedMessage, RouteMessage
+	 */
+	FORCEINLINE uint64 AllocateDelayedMessageId()
+	{
+		return NextDelayedMessageId.fetch_add(1, std::memory_order_relaxed) + 1;
+	}
+
+	/**
+	 * Checks whether the router holds back delayed messages until they are due.
+	 *
+	 * If not, delayed messages are dispatched right away. This method is safe to call from any thread.
+	 *
+	 * @return true if delayed messaging is allowed, false otherwise.
+	 * @see USGMessagingSettings::bAllowDelayedMessaging
+	 */
+	FORCEINLINE bool IsDelayedMessagingAllowed() const
+	{
+		return bAllowDelayedMessaging;
+	}
+
+	/**
+	 * Cancels a delayed message that has not been dispatched yet.
+	 *
+	 * @param DelayedMessageId The identifier the message was routed with.
+	 * @see AllocateDelayedMessageId, RouteMessage
+	 */
+	FORCEINLINE void CancelDelayedMessage(uint64 DelayedMessageId)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::CancelDelayedMessage);
+		Command.DelayedMessageId = DelayedMessageId;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Adds a message that is published every interval until it is cancelled.
+	 *
+	 * @param Context The context of the message to publish.
+	 * @param DelayedMessageId Identifier used to cancel the message.
+	 * @param IntervalTicks The interval (in milliseconds).
+	 * @see AllocateDelayedMessageId, CancelDelayedMessage
+	 */
+	FORCEINLINE void AddPeriodicMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, uint64 DelayedMessageId, uint64 IntervalTicks)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::AddPeriodicMessage);
+		Command.Context = Context;
+		Command.DelayedMessageId = DelayedMessageId;
+		Command.IntervalTicks = IntervalTicks;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Delivers a message that was routed before to a single recipient again after a delay.
+	 *
+	 * The context is put into the timing wheel as it is, so the message doesn't get a new context,
+	 * isn't intercepted, and isn't routed or traced as a new message.
+	 *
+	 * @param Context The context of the message to deliver again.
+	 * @param Recipient The address of the recipient.
+	 * @param DelayTicks The delay (in milliseconds).
+	 * @see ISGMessageBus::Redeliver
+	 */
+	FORCEINLINE void RedeliverMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, uint64 DelayTicks)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::RedeliverMessage);
+		Command.Context = Context;
+		Command.Address = Recipient;
+		Command.IntervalTicks = DelayTicks;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Reports a backpressure event that happened outside of the router to the notification listeners.
+	 *
+	 * @param Event The backpressure event (i.e. of a rate limit).
+	 * @see AddNotificationListener
+	 */
+	FORCEINLINE void ReportBackpressure(const FSGMessageBackpressureEvent& Event)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::NotifyBackpressure);
+		Command.BackpressureEvent = Event;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Adds, moves or removes the spatial interests of subscribers with a single command.
+	 *
+	 * @param SpatialInterests The interests to update (a negative radius removes an interest).
+	 * @see FSGMessageSpatialInterest
+	 */
+	FORCEINLINE void UpdateSpatialInterests(TArray<FSGMessageSpatialInterest>&& SpatialInterests)
+	{
+		FSGRouterCommand Command(ESGRouterCommand::UpdateSpatialInterests);
+		Command.SpatialInterests = MoveTemp(SpatialInterests);
+		EnqueueCommand(MoveTemp(Command));
 	}
 
+	/**
+	 * Adds a request that waits for its reply.
+	 *
+	 * The request is pending right away, so its reply is matched even if it overtakes the timeout
+	 * command. Replies complete the request instead of being dispatched to the requester.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Request The request to add.
+	 * @see CancelPendingRequests
+	 */
+	void AddPendingRequest(const TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe>& Request);
+
+	/**
+	 * Completes the pending request of a request message that was dropped before it reached its recipient.
+	 *
+	 * Messages that aren't requests, and forwarded requests, which the original recipient may still
+	 * reply to, are ignored. This method is safe to call from any thread.
+	 *
+	 * @param Context The context of the dropped message.
+	 * @see AddPendingRequest
+	 */
+	void DropPendingRequest(const ISGMessageContext& Context);
+
+	/**
+	 * Completes all pending requests as cancelled, so nobody waits for replies that can't arrive anymore.
+	 *
+	 * Requests that are added afterwards are cancelled right away. This method must not be called
+	 * while the router is routing, since it also clears the request timeouts.
+	 *
+	 * @see AddPendingRequest
+	 */
+	void CancelPendingRequests();
+
 	/**
 	 * Routes a message to the specified recipients.
 	 *
 	 * @param Context The context of the message to route.
+	 * @param DelayedMessageId Identifier used to cancel the message if it is delayed (0 = allocate one internally).
 	 */
-	FORCEINLINE void RouteMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	FORCEINLINE void RouteMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, uint64 DelayedMessageId = 0)
 	{
 		Tracer->TraceSentMessage(Context);
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleRouteMessage, Context));
+		FSGRouterCommand Command(ESGRouterCommand::RouteMessage);
+		Command.Context = Context;
+		Command.DelayedMessageId = DelayedMessageId;
+		EnqueueCommand(MoveTemp(Command));
+	}
+
+	/**
+	 * Routes a batch of messages with a single router command.
+	 *
+	 * The messages are routed in order, one after the other, when the command is executed. The whole
+	 * batch is subject to the command queue limit as one command, so a batch is either queued or
+	 * dropped as a whole.
+	 *
+	 * @param Contexts The contexts of the messages to route (must not be empty, messages must have the same priority).
+	 * @see RouteMessage
+	 */
+	FORCEINLINE void RouteMessages(TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>&& Contexts)
+	{
+		checkSlow(Contexts.Num() > 0);
+
+		for (const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& Context : Contexts)
+		{
+			Tracer->TraceSentMessage(Context.ToSharedRef());
+		}
+
+		FSGRouterCommand Command(ESGRouterCommand::RouteMessages);
+		Command.Contexts = MoveTemp(Contexts);
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
-	 * Add a listener to the bus registration events
+	 * Add a listener to the bus registration and backpressure events
 	 * 
 	 * @param Listener The listener to as to the registration notifications
 	 */
 	FORCEINLINE void AddNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleAddListener, TWeakPtr<ISGBusListener, ESPMode::ThreadSafe>(Listener)));
+		FSGRouterCommand Command(ESGRouterCommand::AddListener);
+		Command.Listener = Listener;
+		EnqueueCommand(MoveTemp(Command));
 	}
 
 	/**
@@ -139,140 +453,954 @@ public:
 	 */
 	FORCEINLINE void RemoveNotificationListener(const TSharedRef<ISGBusListener, ESPMode::ThreadSafe>& Listener)
 	{
-		EnqueueCommand(FSimpleDelegate::CreateRaw(this, &FSGMessageRouter::HandleRemoveListener, TWeakPtr<ISGBusListener, ESPMode::ThreadSafe>(Listener)));
+		FSGRouterCommand Command(ESGRouterCommand::RemoveListener);
+		Command.Listener = Listener;
+		EnqueueCommand(MoveTemp(Command));
 	}
 
-public:
+	/**
+	 * Dispatches a message directly on the calling thread, bypassing the router thread.
+	 *
+	 * Uses the latest subscription snapshot published by the router. AnyThread recipients and recipients
+	 * that live on the calling thread receive the message synchronously, all other recipients get a
+	 * dispatch task. Messages with interceptors are never dispatched directly.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Context The context of the message to dispatch.
+	 * @return true if the message was dispatched, false if it must be routed by the router thread instead.
+	 * @see RouteMessage
+	 */
+	bool DispatchMessageDirect(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
 
-	//~ FRunnable interface
+	/**
+	 * Processes queued work within the given budget (frame mode).
+	 *
+	 * Delayed messages that are due are always dispatched. Commands that don't fit into the
+	 * budget stay queued in order and are processed first in the next call. At least one
+	 * command is processed per call, so the router always makes progress.
+	 *
+	 * Must be called from a single thread, and only if the router has no thread of its own.
+	 * Routers of pooled buses are processed by the workers of the router pool, which make sure
+	 * that only one of them processes a router at a time.
+	 *
+	 * @param BudgetEndCycles The time at which to stop processing (in CPU cycles, 0 = unlimited).
+	 * @param MaxCommands The largest number of commands to process (0 = unlimited).
+	 * @return The number of processed commands.
+	 * @see Tick, FSGMessageRouterPool
+	 */
+	int32 ProcessFrame(uint64 BudgetEndCycles, int32 MaxCommands);
 
-	virtual FSingleThreadRunnable* GetSingleThreadInterface() override;
-	virtual bool Init() override;
-	virtual uint32 Run() override;
-	virtual void Stop() override;
-	virtual void Exit() override;
+	/**
+	 * Sets the router pool that processes this router.
+	 *
+	 * @param InPool The pool, or nullptr if the router isn't pooled (anymore).
+	 * @see FSGMessageRouterPool::AddBus
+	 */
+	void SetPool(FSGMessageRouterPool* InPool)
+	{
+		Pool.store(InPool, std::memory_order_seq_cst);
+	}
 
-protected:
+	/**
+	 * Configures the router thread, which is started when the first command is queued.
+	 *
+	 * Buses that never carry a message don't pay for a thread that way.
+	 *
+	 * @param InThreadName The name of the thread.
+	 * @param InStackSize The stack size of the thread (in bytes).
+	 * @param InThreadPriority The priority of the thread.
+	 * @param InAffinityMask The affinity mask of the thread.
+	 * @see DetachThread
+	 */
+	void SetThreadSettings(const FString& InThreadName, uint32 InStackSize, EThreadPriority InThreadPriority, uint64 InAffinityMask);
 
 	/**
-	 * Calculates the time that the thread will wait for new work.
+	 * Takes the router thread, so that it can be joined, and keeps later commands from starting one.
 	 *
-	 * @return Wait time.
+	 * @return The router thread, or nullptr if it was never started.
+	 * @see SetThreadSettings
 	 */
-	FTimespan CalculateWaitTime();
+	FRunnableThread* DetachThread();
 
 	/**
-	 * Queues up a router command.
+	 * Sets the durable queues of the messages to offline durable recipients.
 	 *
-	 * @param Command The command to queue up.
-	 * @return true if the command was enqueued, false otherwise.
+	 * Must be called before the router thread is started. Recipients that have queued messages from
+	 * a previous session are known to be durable right away, so that they don't miss messages sent
+	 * before they register again.
+	 *
+	 * @param InDurableQueue The durable queues (nullptr = messages to offline recipients are dropped).
+	 * @see ISGMessageReceiver::IsDurable
 	 */
-	FORCEINLINE bool EnqueueCommand(CommandDelegate Command)
-	{
-		if (!Commands.Enqueue(Command))
-		{
-			return false;
-		}
+	void SetDurableQueue(TUniquePtr<FSGMessageDurableQueue>&& InDurableQueue);
 
-		WorkEvent->Trigger();
+	/**
+	 * Sets the longest time the router thread spins for new work before it parks.
+	 *
+	 * Must be called before the router thread is started.
+	 *
+	 * @param Microseconds The spin budget (0 = never spin).
+	 * @see WaitForWork
+	 */
+	void SetSpinWait(int32 Microseconds)
+	{
+		MaxSpinCycles = (uint64)(FMath::Max(Microseconds, 0) / (FPlatformTime::GetSecondsPerCycle64() * 1000000.0));
+		SpinCycles = MaxSpinCycles;
+	}
 
-		return true;
+	/**
+	 * Gets the longest time the router may stay idle before it must run again.
+	 *
+	 * Routers without a thread of their own use this to schedule delayed messages and timeouts.
+	 *
+	 * @return Idle time.
+	 */
+	FTimespan GetIdleWaitTime()
+	{
+		return CalculateWaitTime();
 	}
 
 	/**
-	 * Filters a collection of subscriptions using the given message context.
+	 * Tells the router thread to stop.
 	 *
-	 * @param Subscriptions The subscriptions to filter.
-	 * @param Context The message context to filter by.
-	 * @param OutRecipients Will hold the collection of recipients.
+	 * A draining router routes the commands that were queued before it exits, a discarding one drops them.
+	 *
+	 * @param bDrain Whether the queued commands are processed before the thread exits.
+	 * @see Stop
 	 */
-	void FilterSubscriptions(
-		TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& Subscriptions,
-		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
-		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+	void StopRouting(bool bDrain);
 
 	/**
-	 * Filters recipients from the given message context to gather actual recipients.
+	 * Gets the number of commands that are currently waiting to be processed.
 	 *
-	 * @param Context The message context to filter by.
-	 * @param OutRecipients Will hold the collection of recipients.
+	 * @return Command queue depth.
+	 * @see GetCommandQueueHighWaterMark
 	 */
-	void FilterRecipients(
-		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
-		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+	FORCEINLINE int32 GetCommandQueueDepth() const
+	{
+		return CommandQueueDepth.load(std::memory_order_relaxed);
+	}
 
 	/**
-	 * Dispatches a single message to its recipients.
+	 * Gets the largest number of commands that were waiting to be processed at once.
 	 *
-	 * @param Message The message to dispatch.
+	 * If this is above the command ring capacity, commands spilled into the overflow
+	 * queue and the ring should be made larger (see USGMessagingSettings).
+	 *
+	 * @return Command queue high-water mark.
+	 * @see GetCommandQueueDepth
 	 */
-	void DispatchMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Message);
+	FORCEINLINE int32 GetCommandQueueHighWaterMark() const
+	{
+		return CommandQueueHighWaterMark.load(std::memory_order_relaxed);
+	}
 
 	/**
-	 * Process all queued commands.
+	 * Gets the number of routed messages this router dropped because its command queue was full.
 	 *
-	 * @see ProcessDelayedMessages
+	 * @return Number of dropped messages.
+	 * @see GetCommandQueueDepth
 	 */
-	void ProcessCommands();
+	FORCEINLINE int64 GetNumDroppedMessages() const
+	{
+		return NumDroppedMessages.load(std::memory_order_relaxed);
+	}
 
 	/**
-	 * Processes all delayed messages.
+	 * Adds this router's activity counters to a snapshot.
 	 *
-	 * @see ProcessCommands
+	 * This method is safe to call from any thread.
+	 *
+	 * @param InOutCounters The counters to add to.
 	 */
-	void ProcessDelayedMessages();
+	void AccumulateCounters(FSGMessageRouterCounters& InOutCounters) const
+	{
+		FSGMessageRouterCounters Counters;
+		{
+			Counters.NumRoutedMessages = NumRoutedMessages.load(std::memory_order_relaxed);
+			Counters.NumCommands = NumProcessedCommands.load(std::memory_order_relaxed);
+			Counters.NumDispatchTasks = NumDispatchTasks.load(std::memory_order_relaxed);
+			Counters.BusyCycles = BusyCycles.load(std::memory_order_relaxed);
+			Counters.CommandQueueDepth = CommandQueueDepth.load(std::memory_order_relaxed);
+			Counters.NumDelayedMessages = NumDelayedMessages.load(std::memory_order_relaxed);
+		}
+
+		InOutCounters.Accumulate(Counters);
+	}
+
+	/**
+	 * Adds this router's memory footprint to a report.
+	 *
+	 * The footprint is measured by the router thread at the end of a pass, at most once per second,
+	 * so it may lag behind a little. This method is safe to call from any thread.
+	 *
+	 * @param InOutReport The report to add to.
+	 * @see FSGMessageTracer::AccumulateMemoryReport
+	 */
+	void AccumulateMemoryReport(FSGMessageMemoryReport& InOutReport) const
+	{
+		FScopeLock Lock(&MemoryReportCriticalSection);
+
+		InOutReport.Accumulate(MemoryReport);
+	}
+
+public:
+
+	//~ FRunnable interface
+
+	virtual FSingleThreadRunnable* GetSingleThreadInterface() override;
+	virtual bool Init() override;
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+	virtual void Exit() override;
 
 protected:
 
-	//~ FSingleThreadRunnable interface
+	/**
+	 * Calculates the time that the thread will wait for new work.
+	 *
+	 * @return Wait time.
+	 */
+	FTimespan CalculateWaitTime();
 
-	virtual void Tick() override;
+	/**
+	 * Waits for new work, spinning for the adaptive spin budget before parking the thread.
+	 *
+	 * @param WaitTime The longest time to wait.
+	 * @see CalculateWaitTime
+	 */
+	void WaitForWork(const FTimespan& WaitTime);
 
-private:
+	/** Enumerates the kinds of router commands. */
+	enum class ESGRouterCommand : uint8
+	{
+		None,
+		AddInterceptor,
+		AddListener,
+		AddRecipient,
+		AddSubscription,
+		CancelDelayedMessage,
+		RemoveInterceptor,
+		RemoveListener,
+		RemoveRecipient,
+		RemoveSubscription,
+		RouteMessage,
+		AddRequestTimeout,
+		AddAddressGroup,
+		AddAddressGroupMembers,
+		RemoveAddressGroup,
+		RemoveAddressGroupMembers,
+		AddSubscriptions,
+		RemoveSubscriptions,
+		AddPeriodicMessage,
+		UpdateSpatialInterests,
+		RouteMessages,
+		RedeliverMessage,
+		NotifyBackpressure
+	};
 
-	/** Structure for delayed messages. */
-	struct FSGDelayedMessage
+	/** Structure for tagged router commands. */
+	struct FSGRouterCommand
 	{
-		/** Holds the context of the delayed message. */
-		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+		/** Holds the kind of command. */
+		ESGRouterCommand Type;
 
-		/** Holds a sequence number used by the delayed message queue. */
-		int64 Sequence;
+		/** Holds the message type (AddInterceptor, RemoveInterceptor, RemoveSubscription) or the group name (AddAddressGroup). */
+		FName MessageType;
 
+		/** Holds the recipient or group address (AddRecipient, RemoveRecipient, RedeliverMessage, address group commands). */
+		FSGMessageAddress Address;
 
-		/** Default constructor. */
-		FSGDelayedMessage() { }
+		/** Holds the group members to add or remove (AddAddressGroupMembers, RemoveAddressGroupMembers). */
+		TArray<FSGMessageAddress> Addresses;
 
-		/** Creates and initializes a new instance. */
-		FSGDelayedMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& InContext, int64 InSequence)
-			: Context(InContext)
-			, Sequence(InSequence)
-		{ }
+		/** Holds the message context (RouteMessage, AddPeriodicMessage, RedeliverMessage). */
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
 
-		/** Comparison operator for heap sorting. */
-		bool operator<(const FSGDelayedMessage& Other) const
-		{
-			const FTimespan Difference = Other.Context->GetTimeSent() - Context->GetTimeSent();
+		/** Holds the message contexts, in routing order (RouteMessages). */
+		TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> Contexts;
 
-			if (Difference.IsZero())
-			{
-				return (Sequence < Other.Sequence);
-			}
+		/** Holds the interceptor (AddInterceptor, RemoveInterceptor). */
+		TSharedPtr<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor;
 
-			return (Difference > FTimespan::Zero());
-		}
-	};
+		/** Holds the subscription (AddSubscription). */
+		TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription;
 
-private:
+		/** Holds the subscriptions (AddSubscriptions). */
+		TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> Subscriptions;
 
-	/** Handles adding message interceptors. */
-	void HandleAddInterceptor(TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor, FName MessageType);
+		/** Holds the message types (RemoveSubscriptions). */
+		TArray<FName> MessageTypes;
 
-	/** Handles adding message recipients. */
-	void HandleAddRecipient(FSGMessageAddress Address, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> RecipientPtr);
+		/** Holds the spatial interests (UpdateSpatialInterests). */
+		TArray<FSGMessageSpatialInterest> SpatialInterests;
 
-	/** Handles adding of subscriptions. */
-	void HandleAddSubscriber(TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription);
+		/** Holds the backpressure event (NotifyBackpressure). */
+		FSGMessageBackpressureEvent BackpressureEvent;
+
+		/** Holds the recipient or subscriber (AddRecipient, RemoveSubscription, RemoveSubscriptions). */
+		TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Receiver;
+
+		/** Holds the registration listener (AddListener, RemoveListener). */
+		TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> Listener;
+
+		/** Holds the pending request (AddRequestTimeout). */
+		TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request;
+
+		/** Holds the delayed message identifier (CancelDelayedMessage, RouteMessage, AddPeriodicMessage). */
+		uint64 DelayedMessageId = 0;
+
+		/** Holds the interval of a periodic message (AddPeriodicMessage) or the delay of a redelivery (RedeliverMessage), in milliseconds. */
+		uint64 IntervalTicks = 0;
+
+		/** Holds the time at which the command was queued (in CPU cycles). */
+		uint64 EnqueueCycles = 0;
+
+		/** Holds the order in which the command was queued, across all lanes. */
+		uint64 Sequence = 0;
+
+		/** Default constructor. */
+		FSGRouterCommand()
+			: Type(ESGRouterCommand::None)
+		{ }
+
+		/** Creates and initializes a new instance. */
+		explicit FSGRouterCommand(ESGRouterCommand InType)
+			: Type(InType)
+		{ }
+	};
+
+	/**
+	 * Implements a router command lane.
+	 *
+	 * Commands go into the lock-free command ring. If the ring is full, or earlier
+	 * commands are still waiting in the overflow queue, the command is added to the
+	 * overflow queue instead so that per-producer ordering is preserved.
+	 */
+	class FSGCommandLane
+	{
+	public:
+
+		/** Creates and initializes a new instance. */
+		explicit FSGCommandLane(uint32 Capacity)
+			: Ring(Capacity)
+			, OverflowCount(0)
+		{ }
+
+		/** Adds a command to the lane (safe to call from any thread). */
+		bool Enqueue(FSGRouterCommand&& Command)
+		{
+			if ((OverflowCount.load(std::memory_order_acquire) > 0) || !Ring.TryEnqueue(MoveTemp(Command)))
+			{
+				LLM_SCOPE_BYTAG(SGMessaging_RouterTables);
+				OverflowCount.fetch_add(1, std::memory_order_acq_rel);
+
+				if (!Overflow.Enqueue(MoveTemp(Command)))
+				{
+					OverflowCount.fetch_sub(1, std::memory_order_acq_rel);
+
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		/** Removes the oldest command from the lane (router thread only). */
+		bool Dequeue(FSGRouterCommand& OutCommand)
+		{
+			// drain the ring first; commands only go to the overflow queue while the ring is full
+			// or the overflow queue is non-empty, so this preserves per-producer ordering
+			if (Ring.TryDequeue(OutCommand))
+			{
+				return true;
+			}
+
+			if (Overflow.Dequeue(OutCommand))
+			{
+				OverflowCount.fetch_sub(1, std::memory_order_acq_rel);
+
+				return true;
+			}
+
+			return false;
+		}
+
+		/** Gets the size of the memory allocated by the lane (safe to call from any thread). */
+		SIZE_T GetAllocatedSize() const
+		{
+			// overflow queue nodes hold a command and the link to the next node
+			return Ring.GetAllocatedSize() + (SIZE_T)FMath::Max(OverflowCount.load(std::memory_order_relaxed), 0) * (sizeof(FSGRouterCommand) + sizeof(void*));
+		}
+
+	private:
+
+		/** Holds the command ring. */
+		TSGMessageCommandRing<FSGRouterCommand> Ring;
+
+		/** Holds commands that did not fit into the command ring. */
+		TQueue<FSGRouterCommand, EQueueMode::Mpsc> Overflow;
+
+		/** Holds the number of commands in the overflow queue. */
+		std::atomic<int32> OverflowCount;
+	};
+
+	/** Number of command lanes, one per message priority. */
+	static constexpr int32 NumCommandLanes = (int32)ESGMessagePriority::Num;
+
+	/**
+	 * Gets the lane a router command is queued in.
+	 *
+	 * Routed messages use the lane of their priority. All other commands (subscriptions,
+	 * registrations and so on) use the high priority lane, so they never wait behind traffic.
+	 * Commands that change how earlier messages are routed are fences, which run only after the
+	 * commands queued before them in the other lanes.
+	 *
+	 * @param Command The command.
+	 * @return The command's lane.
+	 */
+	static ESGMessagePriority GetCommandLane(const FSGRouterCommand& Command)
+	{
+		if ((Command.Type == ESGRouterCommand::RouteMessage) || (Command.Type == ESGRouterCommand::RedeliverMessage))
+		{
+			return Command.Context->GetPriority();
+		}
+
+		return (Command.Type == ESGRouterCommand::RouteMessages) ? Command.Contexts[0]->GetPriority() : ESGMessagePriority::High;
+	}
+
+	/**
+	 * Checks whether a command must not overtake the commands that were queued before it.
+	 *
+	 * Cancelling a delayed message, unsubscribing and unregistering affect messages that may still wait
+	 * in a lower lane, i.e. a delayed message whose timer isn't armed yet.
+	 *
+	 * @param Command The command.
+	 * @return true if the command is a fence, false otherwise.
+	 * @see ExecuteFence
+	 */
+	static bool IsFenceCommand(const FSGRouterCommand& Command)
+	{
+		return (Command.Type == ESGRouterCommand::CancelDelayedMessage) || (Command.Type == ESGRouterCommand::RemoveRecipient)
+			|| (Command.Type == ESGRouterCommand::RemoveSubscription) || (Command.Type == ESGRouterCommand::RemoveSubscriptions);
+	}
+
+	/**
+	 * Checks whether a command routes messages, which makes it subject to the command queue limit.
+	 *
+	 * @param Command The command.
+	 * @return true if the command routes messages, false otherwise.
+	 */
+	static bool IsRouteCommand(const FSGRouterCommand& Command)
+	{
+		return (Command.Type == ESGRouterCommand::RouteMessage) || (Command.Type == ESGRouterCommand::RouteMessages);
+	}
+
+	/**
+	 * Queues up a router command in its priority lane.
+	 *
+	 * Routed messages are subject to the command queue limit.
+	 *
+	 * @param Command The command to queue up.
+	 * @return true if the command was enqueued, false otherwise.
+	 * @see ApplyBackpressure, GetCommandLane
+	 */
+	FORCEINLINE bool EnqueueCommand(FSGRouterCommand&& Command)
+	{
+		if ((CommandQueueLimit > 0) && IsRouteCommand(Command) && (CommandQueueDepth.load(std::memory_order_relaxed) >= CommandQueueLimit) && !ApplyBackpressure(Command))
+		{
+			return false;
+		}
+
+		const int32 LaneIndex = (int32)GetCommandLane(Command);
+
+		Command.EnqueueCycles = FPlatformTime::Cycles64();
+		Command.Sequence = NextCommandSequence.fetch_add(1, std::memory_order_relaxed);
+
+		if (!CommandLanes[LaneIndex]->Enqueue(MoveTemp(Command)))
+		{
+			return false;
+		}
+
+		// sequentially consistent together with the parked flag, see WaitForWork
+		const int32 Depth = CommandQueueDepth.fetch_add(1, std::memory_order_seq_cst) + 1;
+		int32 HighWaterMark = CommandQueueHighWaterMark.load(std::memory_order_relaxed);
+
+		while ((Depth > HighWaterMark) && !CommandQueueHighWaterMark.compare_exchange_weak(HighWaterMark, Depth, std::memory_order_relaxed));
+
+		// the thread that picks the command up may not exist yet
+		if (bThreadPending.load(std::memory_order_acquire))
+		{
+			StartThread();
+		}
+
+		NotifyWork();
+
+		return true;
+	}
+
+	/** Starts the router thread unless that already happened or it was detached. */
+	void StartThread();
+
+	/**
+	 * Wakes up whoever processes this router, if it is parked.
+	 *
+	 * @see EnqueueCommand
+	 */
+	FORCEINLINE void NotifyWork()
+	{
+		// an awake router or pool worker picks the command up by itself, so skip the kernel transition
+		if (FSGMessageRouterPool* RouterPool = Pool.load(std::memory_order_seq_cst))
+		{
+			if (RouterPool->NumParkedWorkers.load(std::memory_order_seq_cst) > 0)
+			{
+				RouterPool->WorkEvent->Trigger();
+			}
+		}
+		else if (bRouterParked.load(std::memory_order_seq_cst))
+		{
+			WorkEvent->Trigger();
+		}
+	}
+
+	/**
+	 * Applies the backpressure policy to a routed message that arrives while the command queue is full.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Command The command of the routed message.
+	 * @return true if the command should be enqueued, false if it was dropped.
+	 * @see EnqueueCommand, TrimCommands
+	 */
+	bool ApplyBackpressure(const FSGRouterCommand& Command);
+
+	/**
+	 * Drops a routed message because the command queue is full.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param Command The command of the routed message.
+	 */
+	void DropCommand(const FSGRouterCommand& Command);
+
+	/**
+	 * Drops the oldest routed messages, lowest priority first, until the command queue fits its limit.
+	 *
+	 * Other commands that are dequeued on the way are carried over in order, and run in their lane's turn.
+	 *
+	 * @param NumExcessCommands The number of commands above the limit.
+	 * @see ApplyBackpressure
+	 */
+	void TrimCommands(int32 NumExcessCommands);
+
+	/**
+	 * Updates the backpressure state and notifies listeners when it changes.
+	 *
+	 * @param PassQueueDepth The command queue depth at the beginning of the current pass.
+	 */
+	void UpdateBackpressureState(int32 PassQueueDepth);
+
+	/**
+	 * Executes a single router command.
+	 *
+	 * @param Command The command to execute.
+	 * @see ExecuteFence
+	 */
+	void ExecuteCommand(FSGRouterCommand& Command);
+
+	/**
+	 * Executes the commands of the other lanes that were queued before a fence.
+	 *
+	 * A newer command that is dequeued on the way is put back in front of the commands carried over from its lane.
+	 *
+	 * @param Sequence The sequence number of the fence.
+	 * @see DequeueCommand, IsFenceCommand
+	 */
+	void ExecuteFence(uint64 Sequence);
+
+	/**
+	 * Takes the next command out of a lane.
+	 *
+	 * @param LaneIndex The index of the lane.
+	 * @param OutCommand Will hold the command.
+	 * @return true if a command was dequeued, false if the lane is empty.
+	 */
+	bool DequeueCommand(int32 LaneIndex, FSGRouterCommand& OutCommand);
+
+	/**
+	 * Adds a recipient to the recipients of the message being dispatched, unless it was already added.
+	 *
+	 * @param Recipient The recipient to add.
+	 * @param OutRecipients The collection of recipients to add to.
+	 */
+	FORCEINLINE void CollectRecipient(const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient, TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients)
+	{
+		bool bIsAlreadyCollected = false;
+		CollectedRecipients.Add(Recipient.Get(), &bIsAlreadyCollected);
+
+		if (!bIsAlreadyCollected)
+		{
+			OutRecipients.Add(Recipient);
+		}
+	}
+
+	/**
+	 * Filters a table of subscriptions using the given message context.
+	 *
+	 * @param Subscriptions The subscriptions to filter (stale subscriptions will be removed).
+	 * @param Context The message context to filter by.
+	 * @param OutRecipients Will hold the collection of recipients.
+	 */
+	void FilterSubscriptions(
+		FSGMessageSubscriptionTable& Subscriptions,
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+
+	/**
+	 * Filters topic subscriptions that match the topic of the given message context.
+	 *
+	 * @param Context The message context to filter by.
+	 * @param OutRecipients Will hold the collection of recipients.
+	 */
+	void FilterTopicSubscriptions(
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+
+	/**
+	 * Filters the spatial subscribers of the given message type by the origin of the message.
+	 *
+	 * @param Context The message context to filter by.
+	 * @param OutRecipients Will hold the collection of recipients.
+	 * @see HandleUpdateSpatialInterests
+	 */
+	void FilterSpatialSubscriptions(
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+
+	/**
+	 * Gets the topic identifier of the given message type.
+	 *
+	 * Results are cached, so that message tags are only parsed once.
+	 *
+	 * @param MessageType The message type.
+	 * @param OutTopicID Will hold the topic identifier.
+	 * @return true if the message type is a topic message tag, false otherwise.
+	 */
+	bool GetMessageTopicID(const FName& MessageType, int32& OutTopicID);
+
+	/**
+	 * Filters recipients from the given message context to gather actual recipients.
+	 *
+	 * @param Context The message context to filter by.
+	 * @param OutRecipients Will hold the collection of recipients.
+	 * @return true if a durable recipient queued or held back the message, false otherwise.
+	 */
+	bool FilterRecipients(
+		const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context,
+		TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
+
+	/**
+	 * Dispatches a single message to its recipients.
+	 *
+	 * @param Message The message to dispatch.
+	 */
+	void DispatchMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Message);
+
+	/**
+	 * Completes the pending request that a message replies to.
+	 *
+	 * @param Context The context of the message.
+	 * @return true if the message is a reply (and was consumed), false if it must be dispatched.
+	 * @see AddPendingRequest
+	 */
+	bool CompleteRequest(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/**
+	 * Removes a pending request.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param CorrelationId The correlation identifier of the request.
+	 * @return The request, or nullptr if it is not pending (anymore).
+	 */
+	TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe> TakePendingRequest(uint64 CorrelationId);
+
+	/**
+	 * Delivers a message to a single recipient, or queues the delivery.
+	 *
+	 * @param Context The context of the message to deliver.
+	 * @param Recipient The message recipient.
+	 * @param RecipientThread The recipient's thread.
+	 * @see DispatchMessageParallel
+	 */
+	void DispatchToRecipient(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Recipient, ENamedThreads::Type RecipientThread);
+
+	/**
+	 * Fans a message out to a large number of recipients in parallel chunks.
+	 *
+	 * Recipient lookups, the deliveries to named threads and workers, and inline AnyThread deliveries
+	 * run in the chunks. The queued deliveries are then moved into their batches in recipient order,
+	 * so named thread batches and worker tasks are the same as in a serial dispatch. Conflated messages
+	 * are dispatched serially, because their deliveries share the router's conflation slots.
+	 *
+	 * @param Context The context of the message to deliver.
+	 * @param Recipients The message recipients.
+	 * @see DispatchToRecipient
+	 */
+	void DispatchMessageParallel(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& Recipients);
+
+	/**
+	 * Queues a delivery to a recipient on a named thread.
+	 *
+	 * The delivery is made when the current batch is flushed.
+	 *
+	 * @param RecipientThread The thread to deliver the message on.
+	 * @param Priority The priority of the message.
+	 * @param Delivery The delivery to make.
+	 * @see FlushDeliveries
+	 */
+	void QueueDelivery(ENamedThreads::Type RecipientThread, ESGMessagePriority Priority, FSGMessageDelivery&& Delivery);
+
+	/**
+	 * Queues a delivery to an AnyThread recipient that is made on a task worker thread.
+	 *
+	 * The delivery is made when the current batch is flushed.
+	 *
+	 * @param Recipient The message recipient.
+	 * @param Partition The ordering partition of the message (0 = unkeyed messages).
+	 * @param Priority The priority of the message.
+	 * @param Delivery The delivery to make.
+	 * @see FlushDeliveries, SGMessageOrdering
+	 */
+	void QueueWorkerDelivery(const ISGMessageReceiver* Recipient, uint32 Partition, ESGMessagePriority Priority, FSGMessageDelivery&& Delivery);
+
+	/**
+	 * Gets the conflation slot of a recipient for the conflation key of the message being dispatched.
+	 *
+	 * @param Recipient The message recipient.
+	 * @return The conflation slot.
+	 * @see DispatchToRecipient
+	 */
+	TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe> GetConflationSlot(const ISGMessageReceiver* Recipient);
+
+	/**
+	 * Launches tasks for all queued deliveries, one batch task per named thread and priority and one task per AnyThread recipient and partition.
+	 *
+	 * Each partition of an AnyThread recipient has a task pipe, so it receives the partition's messages in order, while
+	 * different recipients and partitions receive theirs in parallel. Task priorities follow the priorities of the delivered messages.
+	 * Pipes that went idle are pruned once per WorkerPipePruneIntervalSeconds rather than on every flush.
+	 *
+	 * @see QueueDelivery, QueueWorkerDelivery
+	 */
+	void FlushDeliveries();
+
+	/** Publishes a new subscription snapshot for direct dispatch if the subscription table has changed. */
+	void UpdateSubscriptionSnapshot();
+
+	/**
+	 * Process all queued commands, or as many as fit into the given budget.
+	 *
+	 * @param BudgetEndCycles The time at which to stop processing (in CPU cycles, 0 = unlimited).
+	 * @param MaxCommands The largest number of commands to process (0 = unlimited).
+	 * @return The number of processed commands.
+	 * @see ProcessDelayedMessages
+	 */
+	int32 ProcessCommands(uint64 BudgetEndCycles = 0, int32 MaxCommands = 0);
+
+	/**
+	 * Processes all delayed messages.
+	 *
+	 * @see ProcessCommands
+	 */
+	void ProcessDelayedMessages();
+
+	/**
+	 * Replays a batch of the messages queued for durable recipients that registered, and writes the
+	 * messages queued for offline ones during the pass.
+	 *
+	 * @see FSGMessageDurableQueue
+	 */
+	void ProcessDurableQueue();
+
+	/**
+	 * Removes the delayed messages that were sent to a recipient that was destroyed.
+	 *
+	 * Messages that another of their recipients can still receive are kept. Recipients that
+	 * unregister while they are alive keep their messages, which are dropped when they are due
+	 * unless the recipient registered again by then.
+	 *
+	 * @param Address The address of the recipient.
+	 * @see HandleRemoveRecipient
+	 */
+	void PurgeDelayedMessages(const FSGMessageAddress& Address);
+
+	/**
+	 * Delivers a redelivered message to its recipient, if the recipient is still registered.
+	 *
+	 * @param Context The context of the message.
+	 * @param RecipientAddress The address of the recipient.
+	 * @see HandleRedeliverMessage
+	 */
+	void RedeliverToRecipient(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& RecipientAddress);
+
+	/**
+	 * Keeps a published message as the retained message of its type (and sender).
+	 *
+	 * @param Context The context of the message, which was published with ESGMessageFlags::Retain or RetainPerSender.
+	 * @see DeliverRetainedMessages
+	 */
+	void RetainMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/**
+	 * Delivers the retained messages that match a new subscription to its subscriber.
+	 *
+	 * @param Subscription The subscription that was added.
+	 * @see HandleAddSubscriber, RetainMessage
+	 */
+	void DeliverRetainedMessages(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription);
+
+	/**
+	 * Updates the activity counters at the end of a processing pass.
+	 *
+	 * @param StartCycles The time at which the pass started (in CPU cycles).
+	 * @see AccumulateCounters
+	 */
+	void UpdateCounters(uint64 StartCycles);
+
+	/**
+	 * Measures the memory footprint of the router's tables, queues and timers.
+	 *
+	 * @see AccumulateMemoryReport
+	 */
+	void UpdateMemoryReport();
+
+protected:
+
+	//~ FSingleThreadRunnable interface
+
+	virtual void Tick() override;
+
+private:
+
+	/** Structure for immutable copies of the subscription table used by direct dispatch. */
+	struct FSGSubscriptionSnapshot
+	{
+		/** Holds the message types that have interceptors. */
+		TSet<FName> InterceptedTypes;
+
+		/** Maps message types to subscriptions. */
+		TMap<FName, FSGMessageSubscriptionTable> Subscriptions;
+
+		/** Holds the subscriptions of struct message types by type identifier, pointing into Subscriptions (nullptr = no subscribers). */
+		TArray<const FSGMessageSubscriptionTable*> TypeSubscriptions;
+
+		/** Holds the message types that have spatial subscribers (direct dispatch is not used for them). */
+		TSet<FName> SpatialTypes;
+
+		/** Holds a flag indicating whether topic subscriptions exist (direct dispatch is not used then). */
+		bool bHasTopicSubscriptions = false;
+	};
+
+	/** Structure for subscriptions to a range of topics. */
+	struct FSGTopicRangeSubscriptions
+	{
+		/** Holds the subscribed topics. */
+		FSGMessageTopicRange TopicRange;
+
+		/** Holds the subscriptions. */
+		FSGMessageSubscriptionTable Subscriptions;
+	};
+
+	/** Structure for the keys of per recipient conflation slots. */
+	struct FSGConflationSlotKey
+	{
+		/** Holds the recipient handle (never dereferenced). */
+		const ISGMessageReceiver* Recipient;
+
+		/** Holds the conflation key. */
+		FSGMessageConflationKey ConflationKey;
+
+		friend bool operator==(const FSGConflationSlotKey& X, const FSGConflationSlotKey& Y)
+		{
+			return (X.Recipient == Y.Recipient) && (X.ConflationKey == Y.ConflationKey);
+		}
+
+		friend uint32 GetTypeHash(const FSGConflationSlotKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Recipient), GetTypeHash(Key.ConflationKey));
+		}
+	};
+
+	/** Structure for the keys of per recipient worker queues. */
+	struct FSGWorkerQueueKey
+	{
+		/** Holds the recipient handle (never dereferenced). */
+		const ISGMessageReceiver* Recipient;
+
+		/** Holds the ordering partition (0 = unkeyed messages). */
+		uint32 Partition;
+
+		friend bool operator==(const FSGWorkerQueueKey& X, const FSGWorkerQueueKey& Y)
+		{
+			return (X.Recipient == Y.Recipient) && (X.Partition == Y.Partition);
+		}
+
+		friend uint32 GetTypeHash(const FSGWorkerQueueKey& Key)
+		{
+			return HashCombine(GetTypeHash(Key.Recipient), Key.Partition);
+		}
+	};
+
+	/** Structure for the task pipe of an AnyThread recipient or partition. */
+	struct FSGWorkerPipe
+	{
+		/** Holds the pipe. */
+		TUniquePtr<UE::Tasks::FPipe> Pipe;
+
+		/** Holds the task that was launched on the pipe last. */
+		UE::Tasks::FTask LastTask;
+	};
+
+	/** Structure for deliveries to the same named thread (or AnyThread recipient) gathered during one pass. */
+	struct FSGDeliveryBatch
+	{
+		/** Holds the name of the thread to deliver on. */
+		ENamedThreads::Type Thread = ENamedThreads::AnyThread;
+
+		/** Holds the priority of the batch's task. */
+		ESGMessagePriority Priority = ESGMessagePriority::Normal;
+
+		/** Holds the deliveries in dispatch order. */
+		TArray<FSGMessageDelivery> Deliveries;
+	};
+
+	/** Structure for a group of recipient addresses. */
+	struct FSGAddressGroup
+	{
+		/** Holds the name of the group (for debugging purposes). */
+		FName Name;
+
+		/** Holds the addresses of the members. */
+		TArray<FSGMessageAddress> Members;
+
+		/** Holds the recipient handles of the members, as of ResolvedGeneration. */
+		TArray<uint32> ResolvedHandles;
+
+		/** Holds the recipient generation the members were resolved in (0 = not resolved). */
+		uint32 ResolvedGeneration = 0;
+	};
+
+private:
+
+	/** Handles adding message interceptors. */
+	void HandleAddInterceptor(TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor, FName MessageType);
+
+	/** Handles adding message recipients. */
+	void HandleAddRecipient(FSGMessageAddress Address, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> RecipientPtr);
+
+	/** Handles adding of subscriptions. */
+	void HandleAddSubscriber(TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe> Subscription);
 
 	/** Handles the removal of message interceptors. */
 	void HandleRemoveInterceptor(TSharedRef<ISGMessageInterceptor, ESPMode::ThreadSafe> Interceptor, FName MessageType);
@@ -280,11 +1408,59 @@ private:
 	/** Handles the removal of message recipients. */
 	void HandleRemoveRecipient(FSGMessageAddress Address);
 
-	/** Handles the removal of subscribers. */
-	void HandleRemoveSubscriber(TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> SubscriberPtr, FName MessageType);
+	/** Handles the removal of subscribers from the given message types (NAME_All = all types). */
+	void HandleRemoveSubscriber(TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> SubscriberPtr, TArrayView<const FName> MessageTypes);
+
+	/** Finds the subscription table for a message type or topic pattern. */
+	FSGMessageSubscriptionTable* FindSubscriptionTable(FName MessageType);
+
+	/** Finds or adds the subscription table for a message type or topic pattern. */
+	FSGMessageSubscriptionTable& FindOrAddSubscriptionTable(FName MessageType);
+
+	/** Finds the subscription table for the type of a routed message, by type identifier for struct messages. */
+	FSGMessageSubscriptionTable* FindMessageSubscriptionTable(const ISGMessageContext& Context);
+
+	/** Rebuilds the subscription tables by type identifier. */
+	void UpdateTypeSubscriptions();
 
 	/** Handles the routing of messages. */
-	void HandleRouteMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context);
+	void HandleRouteMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, uint64 DelayedMessageId);
+
+	/** Handles the cancellation of delayed messages. */
+	void HandleCancelDelayedMessage(uint64 DelayedMessageId);
+
+	/** Handles the scheduling of periodic messages. */
+	void HandleAddPeriodicMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, uint64 DelayedMessageId, uint64 IntervalTicks);
+
+	/** Handles the redelivery of messages to a single recipient. */
+	void HandleRedeliverMessage(TSharedRef<ISGMessageContext, ESPMode::ThreadSafe> Context, FSGMessageAddress Recipient, uint64 DelayTicks);
+
+	/** Handles the updates of spatial interests. */
+	void HandleUpdateSpatialInterests(TArray<FSGMessageSpatialInterest>& SpatialInterests);
+
+	/** Handles the timeouts of pending requests. */
+	void HandleAddRequestTimeout(TSharedRef<FSGMessagePendingRequest, ESPMode::ThreadSafe> Request);
+
+	/** Handles the addition of address groups. */
+	void HandleAddAddressGroup(FSGMessageAddress Group, FName GroupName);
+
+	/** Handles the addition of address group members. */
+	void HandleAddAddressGroupMembers(FSGMessageAddress Group, const TArray<FSGMessageAddress>& Members);
+
+	/** Handles the removal of address groups. */
+	void HandleRemoveAddressGroup(FSGMessageAddress Group);
+
+	/** Handles the removal of address group members. */
+	void HandleRemoveAddressGroupMembers(FSGMessageAddress Group, const TArray<FSGMessageAddress>& Members);
+
+	/**
+	 * Collects the recipients of an address group, resolving its members if the registrations changed.
+	 *
+	 * @param Group The group.
+	 * @param Context The context of the message being dispatched.
+	 * @param OutRecipients Will hold the collection of recipients.
+	 */
+	void FilterGroupRecipients(FSGAddressGroup& Group, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>>& OutRecipients);
 
 	/** Handles the addition of a listener. */
 	void HandleAddListener(TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> ListenerPtr);
@@ -292,44 +1468,388 @@ private:
 	/** Handles the removal of a listener. */
 	void HandleRemoveListener(TWeakPtr<ISGBusListener, ESPMode::ThreadSafe> ListenerPtr);
 
-	/** Notify listeners about registration */
+	/** Queues a registration notification for the listeners, see FlushRegistrationNotifications. */
 	void NotifyRegistration(const FSGMessageAddress& Address, ESGMessageBusNotification Notification);
 
+	/** Notify listeners about the registrations of the current pass, with one batch per listener. */
+	void FlushRegistrationNotifications();
+
+	/** Notify listeners about backpressure */
+	void NotifyBackpressure(const FSGMessageBackpressureEvent& Event);
+
 private:
 
-	/** Maps message types to interceptors. */
+	/** Maps message types to interceptors (only holds types that have interceptors). */
 	TMap<FName, TArray<TSharedPtr<ISGMessageInterceptor, ESPMode::ThreadSafe>>> ActiveInterceptors;
 
-	/** Maps message addresses to recipients. */
-	TMap<FSGMessageAddress, TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> ActiveRecipients;
+	/** Holds the registered recipients and their handles. */
+	FSGMessageRecipientTable ActiveRecipients;
+
+	/** Holds a counter that changes whenever recipients are added, which invalidates resolved address groups. */
+	uint32 RecipientsGeneration = 1;
+
+	/** Maps group addresses to address groups. */
+	TMap<FSGMessageAddress, FSGAddressGroup> AddressGroups;
 
 	/** Maps message types to subscriptions. */
-	TMap<FName, TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>> ActiveSubscriptions;
+	TMap<FName, FSGMessageSubscriptionTable> ActiveSubscriptions;
+
+	/**
+	 * Holds the subscriptions of struct message types by type identifier, pointing into ActiveSubscriptions.
+	 *
+	 * The pointers are rebuilt when tables are added to ActiveSubscriptions (which may move them),
+	 * and when a message of a type that was registered since the last rebuild is routed.
+	 *
+	 * @see FSGMessageTypeRegistry
+	 */
+	TArray<FSGMessageSubscriptionTable*> TypeSubscriptions;
+
+	/** Maps topic identifiers to subscriptions of single topics ("TopicID:*"). */
+	TMap<int32, FSGMessageSubscriptionTable> ActiveTopicSubscriptions;
+
+	/** Holds subscriptions to topic ranges ("FirstTopicID-LastTopicID:*"). */
+	TArray<FSGTopicRangeSubscriptions> ActiveTopicRangeSubscriptions;
+
+	/**
+	 * Maps subscribers to their subscriptions, so that unsubscribing only visits the tables that hold them.
+	 *
+	 * The keys are never dereferenced. A subscriber that dies without unsubscribing leaves its entry
+	 * behind, which is dropped when another subscriber with the same address is added or removed.
+	 */
+	TMap<const ISGMessageReceiver*, TArray<TWeakPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>> SubscriptionsBySubscriber;
+
+	/** Caches the topic identifiers of routed message types (unset = not a topic message tag). */
+	TMap<FName, TOptional<int32>> MessageTopicIDs;
 
 	/** Array of active registration listeners. */
 	TArray<TWeakPtr<ISGBusListener, ESPMode::ThreadSafe>> ActiveRegistrationListeners;
 
-	/** Holds the router command queue. */
-	TQueue<CommandDelegate, EQueueMode::Mpsc> Commands;
+	/** Holds the registration notifications of the current pass, by address. */
+	TMap<FSGMessageAddress, ESGMessageBusNotification> PendingRegistrations;
+
+	/** Holds the router command lanes (indexed by ESGMessagePriority). */
+	TUniquePtr<FSGCommandLane> CommandLanes[NumCommandLanes];
+
+	/** Holds the number of commands processed from each lane before the next lower lane is served. */
+	int32 CommandLaneWeights[NumCommandLanes];
+
+	/**
+	 * Structure for the commands that were taken out of a lane ahead of their turn.
+	 *
+	 * They are older than the commands still in the lane, so the lane serves them first.
+	 */
+	struct FSGCarriedCommands
+	{
+		/** Holds the commands, oldest first. */
+		TArray<FSGRouterCommand> Commands;
+
+		/** Holds the index of the oldest command that wasn't taken back yet. */
+		int32 Head = 0;
+
+		/** Adds a command behind the carried ones. */
+		void Add(FSGRouterCommand&& Command)
+		{
+			Commands.Add(MoveTemp(Command));
+		}
+
+		/** Puts a command back in front of the carried ones. */
+		void AddFront(FSGRouterCommand&& Command)
+		{
+			if (Head > 0)
+			{
+				Commands[--Head] = MoveTemp(Command);
+			}
+			else
+			{
+				Commands.Insert(MoveTemp(Command), 0);
+			}
+		}
+
+		/** Takes the oldest carried command. */
+		bool Dequeue(FSGRouterCommand& OutCommand)
+		{
+			if (Head >= Commands.Num())
+			{
+				return false;
+			}
+
+			OutCommand = MoveTemp(Commands[Head++]);
+
+			if (Head == Commands.Num())
+			{
+				Commands.Reset();
+				Head = 0;
+			}
+
+			return true;
+		}
+	};
+
+	/** Holds the commands of each lane that were taken out ahead of their turn (router thread only). */
+	FSGCarriedCommands CarriedCommands[NumCommandLanes];
+
+	/** Holds the sequence number of the next queued command. */
+	std::atomic<uint64> NextCommandSequence{1};
+
+	/** Holds the number of queued commands. */
+	std::atomic<int32> CommandQueueDepth;
+
+	/** Holds the largest number of queued commands seen so far. */
+	std::atomic<int32> CommandQueueHighWaterMark;
+
+	/** Holds the number of queued commands at which backpressure is applied to routed messages (0 = unlimited). */
+	int32 CommandQueueLimit;
+
+	/** Holds the policy for routed messages that arrive while the command queue is full. */
+	ESGMessageBackpressurePolicy BackpressurePolicy;
+
+	/** Holds the longest time a producer waits for room with the Block policy (in seconds). */
+	double BackpressureBlockTimeout;
+
+	/** Holds the number of routed messages dropped because of backpressure. */
+	std::atomic<int64> NumDroppedMessages;
+
+	/** Holds the number of dropped messages at the end of the previous pass. */
+	int64 LastNumDroppedMessages;
+
+	/** Holds the number of routed messages. */
+	std::atomic<uint64> NumRoutedMessages;
+
+	/** Holds the number of processed commands. */
+	std::atomic<uint64> NumProcessedCommands;
+
+	/** Holds the number of launched dispatch tasks. */
+	std::atomic<uint64> NumDispatchTasks;
+
+	/** Holds the time spent processing work (in CPU cycles). */
+	std::atomic<uint64> BusyCycles;
+
+	/** Holds the number of entries in the timing wheel, updated by the router thread after each pass. */
+	std::atomic<int32> NumDelayedMessages;
+
+	/** Holds the latest memory footprint of the router. */
+	FSGMessageMemoryReport MemoryReport;
+
+	/** Guards the memory footprint. */
+	mutable FCriticalSection MemoryReportCriticalSection;
+
+	/** Holds the time at which the memory footprint was last measured (in CPU cycles). */
+	uint64 LastMemoryReportCycles;
+
+	/** Holds a flag indicating whether listeners were told that the command queue is congested. */
+	bool bBackpressureCongested;
+
+	/** Holds the identifier of the thread that processes commands (producers on it must never block). */
+	std::atomic<uint32> RouterThreadId;
+
+	/** Holds the router thread (nullptr until the first command is queued). */
+	FRunnableThread* Thread;
+
+	/** Holds a flag indicating that the router thread is configured but not started yet. */
+	std::atomic<bool> bThreadPending;
+
+	/** Guards starting and detaching the router thread. */
+	FCriticalSection ThreadCriticalSection;
+
+	/** Holds the name of the router thread. */
+	FString ThreadName;
+
+	/** Holds the stack size of the router thread (in bytes). */
+	uint32 ThreadStackSize;
+
+	/** Holds the priority of the router thread. */
+	EThreadPriority ThreadPriority;
+
+	/** Holds the affinity mask of the router thread. */
+	uint64 ThreadAffinityMask;
 
 	/** Holds the current time. */
 	FDateTime CurrentTime;
 
-	/** Holds the collection of delayed messages. */
-	TArray<FSGDelayedMessage> DelayedMessages;
+	/** Holds the timers of delayed messages. */
+	FSGMessageTimingWheel DelayedMessages;
 
-	/** Holds a sequence number for delayed messages. */
-	int64 DelayedMessagesSequence;
+	/** Holds delayed messages that expired in the current pass (scratch). */
+	TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> ExpiredDelayedMessages;
+
+	/** Holds the delayed messages purged in the current pass (scratch). */
+	TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> PurgedDelayedMessages;
+
+	/** Holds the durable queues of offline recipients. */
+	TUniquePtr<FSGMessageDurableQueue> DurableQueue;
+
+	/** Holds the largest number of queued messages that a pass replays to durable recipients. */
+	static constexpr int32 MaxReplayedMessagesPerPass = 256;
+
+	/** Holds the addresses of durable recipients, registered or not. */
+	TSet<FSGMessageAddress> DurableAddresses;
+
+	/** Holds the request timeouts that expired in the current pass (scratch). */
+	TArray<uint64> ExpiredRequestTimeouts;
+
+	/** Maps correlation identifiers to requests that wait for their reply. */
+	TMap<uint64, TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe>> PendingRequests;
+
+	/** Guards the pending requests (requests are added by the requesting threads). */
+	FCriticalSection PendingRequestsCriticalSection;
+
+	/** Whether the pending requests were cancelled, so that late requests are cancelled right away (guarded by PendingRequestsCriticalSection). */
+	bool bPendingRequestsCancelled = false;
+
+	/** Maps timer identifiers to the requests whose timeouts are in the timing wheel. */
+	TMap<uint64, TSharedPtr<FSGMessagePendingRequest, ESPMode::ThreadSafe>> RequestTimeouts;
+
+	/** Structure for messages that are published every interval. */
+	struct FSGPeriodicMessage
+	{
+		/** Holds the context of the scheduled message, which every period shares. */
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+		/** Holds the interval (in milliseconds). */
+		uint64 IntervalTicks;
+
+		/** Holds the tick at which the next period is due. */
+		uint64 DueTick;
+	};
+
+	/** Maps timer identifiers to the periodic messages whose timers are in the timing wheel. */
+	TMap<uint64, FSGPeriodicMessage> PeriodicMessages;
+
+	/** Structure for a message that is delivered to a single recipient again. */
+	struct FSGRedelivery
+	{
+		/** Holds the context of the message, which is delivered as it is. */
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+		/** Holds the address of the recipient. */
+		FSGMessageAddress Recipient;
+	};
+
+	/** Maps timer identifiers to the redeliveries whose timers are in the timing wheel. */
+	TMap<uint64, FSGRedelivery> Redeliveries;
+
+	/**
+	 * Maps message types to their retained messages.
+	 *
+	 * Each type maps senders to their latest message if it was published with ESGMessageFlags::RetainPerSender,
+	 * and the invalid address to the latest message published with ESGMessageFlags::Retain.
+	 */
+	TMap<FName, TMap<FSGMessageAddress, TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>> RetainedMessages;
+
+	/** Holds the identifiers of the recently routed messages whose duplicates are dropped. */
+	FSGMessageDeduplicationWindow DeduplicationWindow;
+
+	/** Maps message types to the spatial index of their subscribers. */
+	TMap<FName, FSGMessageSpatialIndex> SpatialIndices;
+
+	/** Holds the edge length of the spatial index cells (in world units). */
+	float SpatialCellSize;
+
+	/** Holds the recipients of the message being dispatched (scratch). */
+	TArray<TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> DispatchRecipients;
+
+	/** Holds the recipients already collected for the message being dispatched (scratch). */
+	TSet<const ISGMessageReceiver*> CollectedRecipients;
+
+	/** Holds the conflation key of the message being dispatched (scratch). */
+	FSGMessageConflationKey DispatchConflationKey;
+
+	/** Holds a flag indicating whether the message being dispatched is conflated. */
+	bool bDispatchConflated;
+
+	/** Maps recipients and conflation keys to the slots holding the latest undelivered message. */
+	TMap<FSGConflationSlotKey, TSharedRef<FSGMessageConflationSlot, ESPMode::ThreadSafe>> ConflationSlots;
+
+	/** Holds the recipient threads looked up by a parallel fan-out (scratch). */
+	TArray<ENamedThreads::Type> FanOutRecipientThreads;
+
+	/** Holds flags for recipients that were handled inside a parallel fan-out chunk (scratch). */
+	TArray<bool> FanOutHandled;
+
+	/** Holds the deliveries built by a parallel fan-out, in recipient order (scratch). */
+	TArray<FSGMessageDelivery> FanOutDeliveries;
+
+	/** Holds the number of recipients from which messages are fanned out in parallel (0 = never). */
+	int32 ParallelFanOutThreshold;
+
+	/** Holds the number of recipients per parallel fan-out chunk. */
+	int32 ParallelFanOutChunkSize;
+
+	/** Whether or not parallel fan-outs keep the serial delivery order. */
+	bool bDeterministicFanOut;
+
+	/** Holds the deliveries to named threads gathered in the current pass. */
+	TArray<FSGDeliveryBatch> PendingDeliveries;
+
+	/** Holds the deliveries to AnyThread recipients gathered in the current pass, by recipient and partition. */
+	TMap<FSGWorkerQueueKey, FSGDeliveryBatch> PendingWorkerDeliveries;
+
+	/** Holds the task pipes of AnyThread recipients and partitions whose deliveries may still be running. */
+	TMap<FSGWorkerQueueKey, FSGWorkerPipe> WorkerDeliveryPipes;
+
+	/** Holds the time at which idle worker pipes are pruned next (in CPU cycles). */
+	uint64 NextWorkerPipePruneCycles = 0;
+
+	/** Holds the time between prunes of idle worker pipes (in seconds). */
+	static constexpr double WorkerPipePruneIntervalSeconds = 1.0;
+
+	/** Holds the number of ordering partitions of keyed messages per AnyThread recipient. */
+	uint32 NumOrderingPartitions;
+
+	/** Holds the last allocated delayed message identifier. */
+	std::atomic<uint64> NextDelayedMessageId;
 
 	/** Holds a flag indicating that the thread is stopping. */
 	TAtomic<bool> Stopping;
 
+	/** Holds a flag indicating whether the thread processes the queued commands before it exits. */
+	std::atomic<bool> bDrainOnStop;
+
 	/** Holds the message tracer. */
 	TSharedRef<FSGMessageTracer, ESPMode::ThreadSafe> Tracer;
 
+	/** Holds the message statistics. */
+	TSharedRef<FSGMessageStatistics, ESPMode::ThreadSafe> Statistics;
+
+	/** Holds the capture of routed messages. */
+	TSharedRef<FSGMessageCapture, ESPMode::ThreadSafe> Capture;
+
 	/** Holds an event signaling that work is available. */
 	FEvent* WorkEvent;
 
+	/** Holds a flag indicating that the router thread is parked on the work event (producers only trigger it then). */
+	std::atomic<bool> bRouterParked;
+
+	/** Holds the router pool that processes this router (nullptr = own thread or frame mode). */
+	std::atomic<FSGMessageRouterPool*> Pool;
+
+	/** Holds the longest spin budget (in CPU cycles, 0 = never spin). */
+	uint64 MaxSpinCycles;
+
+	/** Holds the current adaptive spin budget (in CPU cycles). */
+	uint64 SpinCycles;
+
 	/** Whether or not to allow delayed messaging */
 	bool bAllowDelayedMessaging;
+
+	/** Whether or not publishers may dispatch messages directly on their own thread. */
+	bool bAllowDirectDispatch;
+
+	/** Whether or not AnyThread recipients are handled on task worker threads. */
+	bool bDispatchAnyThreadOnWorkers;
+
+	/** Whether or not listeners are notified about registrations. */
+	bool bNotifyRegistrations;
+
+	/** Holds a flag indicating that the subscription snapshot is out of date. */
+	bool SubscriptionSnapshotDirty;
+
+	/** Holds a flag indicating that the subscription tables by type identifier are out of date. */
+	bool TypeSubscriptionsDirty;
+
+	/** Holds the latest subscription snapshot (read by publishing threads). */
+	TSharedPtr<const FSGSubscriptionSnapshot, ESPMode::ThreadSafe> SubscriptionSnapshot;
+
+	/** Guards the subscription snapshot pointer. */
+	mutable FRWLock SubscriptionSnapshotLock;
 };
@@ -0,0 +1,138 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+class FEvent;
+class FRunnableThread;
+class FSGMessageRouter;
+
+
+/**
+ * Implements a shared pool of worker threads that run the routers of pooled message buses.
+ *
+ * Routers of buses in ESGMessageRouterMode::Pooled don't get threads of their own. The pool's
+ * workers process them cooperatively instead, one router at a time per worker, within a command
+ * quantum and a short time slice. Workers pick the next bus round robin, and the next router
+ * shard within it, so a busy bus or one with many shards can't starve the others.
+ *
+ * The workers are started when the first bus is added and stopped when the last one is removed.
+ *
+ * @see FSGMessageRouter::ProcessFrame
+ */
+class FSGMessageRouterPool
+{
+public:
+
+	/**
+	 * Gets the pool.
+	 *
+	 * @return The router pool.
+	 */
+	static FSGMessageRouterPool& Get();
+
+	/** Destructor. */
+	~FSGMessageRouterPool();
+
+public:
+
+	/**
+	 * Adds the routers of a message bus.
+	 *
+	 * The routers must not have threads of their own.
+	 *
+	 * @param Owner The bus that owns the routers (used as the key for RemoveBus).
+	 * @param Routers The router shards of the bus.
+	 * @see RemoveBus
+	 */
+	void AddBus(const void* Owner, TArrayView<FSGMessageRouter* const> Routers);
+
+	/**
+	 * Removes the routers of a message bus, waiting until no worker processes them anymore.
+	 *
+	 * This method must not be called from a pool worker.
+	 *
+	 * @param Owner The bus that owns the routers.
+	 * @see AddBus
+	 */
+	void RemoveBus(const void* Owner);
+
+private:
+
+	/** Structure for a router in the pool. */
+	struct FPooledRouter
+	{
+		/** Holds the router. */
+		FSGMessageRouter* Router = nullptr;
+
+		/** Holds the tick at which the router must run even without commands (delayed messages, timeouts). */
+		uint64 DueTick = 0;
+
+		/** Holds a flag indicating whether a worker processes the router. */
+		bool bClaimed = false;
+	};
+
+	/** Structure for a bus in the pool. */
+	struct FPooledBus
+	{
+		/** Holds the bus that owns the routers. */
+		const void* Owner = nullptr;
+
+		/** Holds the router shards of the bus. */
+		TArray<FPooledRouter> Routers;
+
+		/** Holds the index of the shard that is tried first next time. */
+		int32 NextRouterIndex = 0;
+	};
+
+	class FWorker;
+
+	/** Hidden constructor, use Get. */
+	FSGMessageRouterPool();
+
+	/** Claims the next router that has work, round robin by bus (must hold the critical section). */
+	FSGMessageRouter* ClaimRouter(uint64 NowTick, uint64& OutWaitTicks);
+
+	/** Releases a claimed router (must hold the critical section). */
+	void ReleaseRouter(FSGMessageRouter* Router, uint64 DueTick);
+
+	/** Checks whether any router has queued commands (must hold the critical section). */
+	bool HasQueuedCommands() const;
+
+	/** Runs a worker until it is told to stop. */
+	void RunWorker(const std::atomic<bool>& bStopping);
+
+	/** Stops and joins the given workers. */
+	static void StopWorkers(TArray<FRunnableThread*>& Threads, TArray<TUniquePtr<FWorker>>& Runnables);
+
+private:
+
+	/** Holds the pooled buses. */
+	TArray<FPooledBus> Buses;
+
+	/** Holds the index of the bus that is tried first next time. */
+	int32 NextBusIndex;
+
+	/** Holds the worker runnables. */
+	TArray<TUniquePtr<FWorker>> Workers;
+
+	/** Holds the worker threads. */
+	TArray<FRunnableThread*> WorkerThreads;
+
+	/** Holds a critical section that protects the buses and workers. */
+	FCriticalSection CriticalSection;
+
+	/** Holds a manual reset event that wakes up parked workers. */
+	FEvent* WorkEvent;
+
+	/** Holds the number of parked workers (routers only trigger the event then). */
+	std::atomic<int32> NumParkedWorkers;
+
+	/** Holds the largest number of commands a worker processes per router turn. */
+	int32 Quantum;
+
+	friend class FSGMessageRouter;
+};
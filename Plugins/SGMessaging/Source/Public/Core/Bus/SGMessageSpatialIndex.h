@@ -0,0 +1,280 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageReceiver.h"
+
+
+/**
+ * Structure for the spatial interest of a subscriber in the published messages of a type.
+ *
+ * A subscriber with a spatial interest receives the messages that are published with an origin
+ * (see SGMessageSpatial::OriginAnnotation) within its radius of its location, and the messages of
+ * the type that are published without an origin.
+ *
+ * @see ISGMessageBus::UpdateSpatialInterests
+ */
+struct FSGMessageSpatialInterest
+{
+	/** Holds the subscriber. */
+	TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber;
+
+	/** Holds the type of messages (topic patterns are not supported). */
+	FName MessageType;
+
+	/** Holds the location of the subscriber. */
+	FVector Location = FVector::ZeroVector;
+
+	/** Holds the radius of the interest (negative = remove the interest). */
+	float Radius = -1.0f;
+};
+
+
+namespace SGMessageSpatial
+{
+	/** Name of the message annotation that holds the origin of a published message. */
+	static const FName OriginAnnotation(TEXT("SGOrigin"));
+
+	/**
+	 * Formats the origin of a message for its annotation.
+	 *
+	 * @param Origin The location at which the message originates.
+	 * @return The annotation value.
+	 */
+	inline FString FormatOrigin(const FVector& Origin)
+	{
+		return FString::Printf(TEXT("%.1f,%.1f,%.1f"), Origin.X, Origin.Y, Origin.Z);
+	}
+
+	/**
+	 * Gets the origin of a message.
+	 *
+	 * @param Context The context of the message.
+	 * @param OutOrigin Will hold the origin.
+	 * @return true if the message has a valid origin, false otherwise.
+	 */
+	inline bool GetOrigin(const ISGMessageContext& Context, FVector& OutOrigin)
+	{
+		const FString* Value = Context.GetAnnotations().Find(OriginAnnotation);
+
+		if (Value == nullptr)
+		{
+			return false;
+		}
+
+		const TCHAR* Cursor = **Value;
+
+		for (int32 Axis = 0; Axis < 3; ++Axis)
+		{
+			TCHAR* End = nullptr;
+			OutOrigin[Axis] = FCString::Strtod(Cursor, &End);
+
+			if ((End == Cursor) || ((Axis < 2) && (*End != TEXT(','))))
+			{
+				return false;
+			}
+
+			Cursor = End + 1;
+		}
+
+		return true;
+	}
+}
+
+
+/**
+ * Implements the router's spatial index of the subscribers of a single message type.
+ *
+ * The index is a uniform grid of cells in the horizontal plane. Each subscriber is linked into all
+ * cells that its interest sphere overlaps, so finding the subscribers near an origin only visits the
+ * origin's cell and checks the distance of the subscribers linked there. Subscribers whose interest
+ * spans too many cells are kept in a separate list that every query checks.
+ *
+ * Updates that don't move a subscriber into other cells only touch the subscriber's entry.
+ *
+ * This class is not thread-safe and is owned by the router thread.
+ */
+class SGMESSAGING_API FSGMessageSpatialIndex
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InCellSize The edge length of the grid cells (in world units).
+	 */
+	explicit FSGMessageSpatialIndex(float InCellSize);
+
+public:
+
+	/**
+	 * Adds a subscriber, or updates its location and radius.
+	 *
+	 * @param Subscriber The subscriber.
+	 * @param Location The location of the subscriber.
+	 * @param Radius The radius of the subscriber's interest.
+	 */
+	void Update(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FVector& Location, float Radius);
+
+	/**
+	 * Removes a subscriber.
+	 *
+	 * @param Handle The subscriber's handle.
+	 * @return true if the subscriber was removed, false if it wasn't in the index.
+	 */
+	bool Remove(const ISGMessageReceiver* Handle);
+
+	/**
+	 * Removes all subscribers that no longer exist.
+	 *
+	 * @return Number of removed subscribers.
+	 */
+	int32 RemoveStaleSubscribers();
+
+	/**
+	 * Calls the given function for every live subscriber whose interest contains the origin.
+	 *
+	 * @param Origin The origin of the message.
+	 * @param Callback The function to call with the receiver handle and weak receiver pointer.
+	 * @return true if stale subscribers were found, false otherwise.
+	 * @see RemoveStaleSubscribers
+	 */
+	template<typename CallbackType>
+	bool ForEachInterestedSubscriber(const FVector& Origin, CallbackType&& Callback) const
+	{
+		bool bFoundStale = false;
+
+		auto VisitEntry = [&](const ISGMessageReceiver* Handle)
+		{
+			const FEntry& Entry = Entries.FindChecked(Handle);
+
+			if (FVector::DistSquared(Entry.Location, Origin) > Entry.RadiusSquared)
+			{
+				return;
+			}
+
+			if (!Entry.Subscriber.IsValid())
+			{
+				bFoundStale = true;
+
+				return;
+			}
+
+			Callback(Handle, Entry.Subscriber);
+		};
+
+		if (const TArray<const ISGMessageReceiver*>* Cell = Cells.Find(GetCell(Origin)))
+		{
+			for (const ISGMessageReceiver* Handle : *Cell)
+			{
+				VisitEntry(Handle);
+			}
+		}
+
+		for (const ISGMessageReceiver* Handle : LargeEntries)
+		{
+			VisitEntry(Handle);
+		}
+
+		return bFoundStale;
+	}
+
+	/**
+	 * Calls the given function for every live subscriber, e.g. for messages without an origin.
+	 *
+	 * @param Callback The function to call with the receiver handle and weak receiver pointer.
+	 * @return true if stale subscribers were found, false otherwise.
+	 * @see RemoveStaleSubscribers
+	 */
+	template<typename CallbackType>
+	bool ForEachSubscriber(CallbackType&& Callback) const
+	{
+		bool bFoundStale = false;
+
+		for (const auto& EntryPair : Entries)
+		{
+			if (EntryPair.Value.Subscriber.IsValid())
+			{
+				Callback(EntryPair.Key, EntryPair.Value.Subscriber);
+			}
+			else
+			{
+				bFoundStale = true;
+			}
+		}
+
+		return bFoundStale;
+	}
+
+	/**
+	 * Gets the number of subscribers in the index.
+	 *
+	 * @return Number of subscribers.
+	 */
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	/**
+	 * Gets the size of the memory allocated by the index.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+private:
+
+	/** Structure for a subscriber in the index. */
+	struct FEntry
+	{
+		/** Holds the subscriber. */
+		TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber;
+
+		/** Holds the location of the subscriber. */
+		FVector Location;
+
+		/** Holds the squared radius of the subscriber's interest. */
+		double RadiusSquared;
+
+		/** Holds the first cell that the interest overlaps. */
+		FIntPoint MinCell;
+
+		/** Holds the last cell that the interest overlaps. */
+		FIntPoint MaxCell;
+
+		/** Holds a flag indicating whether the interest spans too many cells to be linked into them. */
+		bool bIsLarge;
+	};
+
+	/** Gets the cell that contains a location. */
+	FIntPoint GetCell(const FVector& Location) const
+	{
+		return FIntPoint(FMath::FloorToInt32(Location.X * InvCellSize), FMath::FloorToInt32(Location.Y * InvCellSize));
+	}
+
+	/** Links a subscriber into the cells of its entry. */
+	void LinkEntry(const ISGMessageReceiver* Handle, const FEntry& Entry);
+
+	/** Unlinks a subscriber from the cells of its entry. */
+	void UnlinkEntry(const ISGMessageReceiver* Handle, const FEntry& Entry);
+
+private:
+
+	/** Holds the largest number of cells that a subscriber is linked into. */
+	static constexpr int64 MaxCellsPerEntry = 64;
+
+	/** Holds the reciprocal of the cell size. */
+	double InvCellSize;
+
+	/** Holds the subscribers, by handle (never dereferenced). */
+	TMap<const ISGMessageReceiver*, FEntry> Entries;
+
+	/** Holds the subscribers linked into each cell. */
+	TMap<FIntPoint, TArray<const ISGMessageReceiver*>> Cells;
+
+	/** Holds the subscribers whose interest spans too many cells. */
+	TArray<const ISGMessageReceiver*> LargeEntries;
+};
@@ -0,0 +1,531 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/ScopeLock.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include <atomic>
+
+
+/**
+ * Structure for the latency statistics of a router priority lane.
+ */
+struct FSGMessageLaneStatistics
+{
+	/** Holds the number of commands that were processed. */
+	int64 NumCommands = 0;
+
+	/** Holds the average time commands waited in the lane (in milliseconds). */
+	double AverageLatencyMs = 0.0;
+
+	/** Holds the longest time a command waited in the lane (in milliseconds). */
+	double MaxLatencyMs = 0.0;
+
+	/** Holds the number of commands that waited longer than the latency budget. */
+	int64 NumOverBudget = 0;
+};
+
+
+/**
+ * Structure for a snapshot of the activity counters of message routers.
+ *
+ * Totals count from the creation of the router, rates are derived from the difference of two snapshots.
+ */
+struct FSGMessageRouterCounters
+{
+	/** Holds the number of routed messages. */
+	uint64 NumRoutedMessages = 0;
+
+	/** Holds the number of processed router commands. */
+	uint64 NumCommands = 0;
+
+	/** Holds the number of dispatch tasks that were launched. */
+	uint64 NumDispatchTasks = 0;
+
+	/** Holds the time the routers spent processing work (in CPU cycles). */
+	uint64 BusyCycles = 0;
+
+	/** Holds the number of commands waiting to be processed. */
+	int32 CommandQueueDepth = 0;
+
+	/** Holds the number of delayed messages and request timeouts waiting in the timing wheels. */
+	int32 NumDelayedMessages = 0;
+
+	/** Adds the counters of another router. */
+	void Accumulate(const FSGMessageRouterCounters& Other)
+	{
+		NumRoutedMessages += Other.NumRoutedMessages;
+		NumCommands += Other.NumCommands;
+		NumDispatchTasks += Other.NumDispatchTasks;
+		BusyCycles += Other.BusyCycles;
+		CommandQueueDepth += Other.CommandQueueDepth;
+		NumDelayedMessages += Other.NumDelayedMessages;
+	}
+};
+
+
+/**
+ * Implements process-wide counters for endpoint inboxes.
+ *
+ * Endpoints don't have access to the statistics of their bus, so the inboxes of all endpoints share these counters.
+ */
+class SGMESSAGING_API FSGMessageInboxStatistics
+{
+public:
+
+	/**
+	 * Adjusts the number of messages queued in inboxes.
+	 *
+	 * @param Delta The number of queued (positive) or removed (negative) messages.
+	 */
+	static void AddQueuedMessages(int64 Delta)
+	{
+		NumQueuedMessages.fetch_add(Delta, std::memory_order_relaxed);
+	}
+
+	/** Counts a message that was dropped because an inbox was full. */
+	static void CountDroppedMessage()
+	{
+		NumDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/** Gets the number of messages queued in all inboxes. */
+	static int64 GetNumQueuedMessages()
+	{
+		return NumQueuedMessages.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of messages that all inboxes dropped. */
+	static int64 GetNumDroppedMessages()
+	{
+		return NumDroppedMessages.load(std::memory_order_relaxed);
+	}
+
+private:
+
+	/** Holds the number of messages queued in all inboxes. */
+	static std::atomic<int64> NumQueuedMessages;
+
+	/** Holds the number of messages that all inboxes dropped. */
+	static std::atomic<int64> NumDroppedMessages;
+};
+
+
+/**
+ * Structure for the compression statistics of a message type.
+ */
+struct FSGMessageCompressionStatistics
+{
+	/** Holds the number of compressed messages. */
+	int64 NumCompressed = 0;
+
+	/** Holds the number of decompressed messages. */
+	int64 NumDecompressed = 0;
+
+	/** Holds the encoded size of the compressed messages (in bytes). */
+	int64 UncompressedBytes = 0;
+
+	/** Holds the compressed size of the compressed messages (in bytes). */
+	int64 CompressedBytes = 0;
+
+	/** Holds the time spent compressing messages (in CPU cycles). */
+	uint64 CompressCycles = 0;
+
+	/** Holds the time spent decompressing messages (in CPU cycles). */
+	uint64 DecompressCycles = 0;
+
+	/** Gets the ratio of compressed to uncompressed bytes (1 = no savings). */
+	double GetRatio() const
+	{
+		return (UncompressedBytes > 0) ? (double)CompressedBytes / (double)UncompressedBytes : 1.0;
+	}
+};
+
+
+/**
+ * Implements process-wide counters for the compression of transported messages.
+ *
+ * Transport codecs don't have access to the statistics of a bus, so all codecs share these counters.
+ */
+class SGMESSAGING_API FSGMessageCompressionCounters
+{
+public:
+
+	/**
+	 * Counts a compressed message.
+	 *
+	 * @param MessageType The type of the compressed message.
+	 * @param UncompressedSize The encoded size of the message (in bytes).
+	 * @param CompressedSize The compressed size of the message (in bytes).
+	 * @param Cycles The time spent compressing (in CPU cycles).
+	 */
+	static void CountCompression(const FName& MessageType, int32 UncompressedSize, int32 CompressedSize, uint64 Cycles)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FSGMessageCompressionStatistics& TypeStatistics = Statistics.FindOrAdd(MessageType);
+
+		++TypeStatistics.NumCompressed;
+		TypeStatistics.UncompressedBytes += UncompressedSize;
+		TypeStatistics.CompressedBytes += CompressedSize;
+		TypeStatistics.CompressCycles += Cycles;
+	}
+
+	/**
+	 * Counts a decompressed message.
+	 *
+	 * @param MessageType The type of the decompressed message.
+	 * @param Cycles The time spent decompressing (in CPU cycles).
+	 */
+	static void CountDecompression(const FName& MessageType, uint64 Cycles)
+	{
+		FScopeLock Lock(&CriticalSection);
+		FSGMessageCompressionStatistics& TypeStatistics = Statistics.FindOrAdd(MessageType);
+
+		++TypeStatistics.NumDecompressed;
+		TypeStatistics.DecompressCycles += Cycles;
+	}
+
+	/**
+	 * Gets the compression statistics per message type.
+	 *
+	 * @param OutStatistics Will hold the statistics per message type.
+	 */
+	static void GetStatistics(TMap<FName, FSGMessageCompressionStatistics>& OutStatistics)
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		OutStatistics = Statistics;
+	}
+
+	/** Resets all counters. */
+	static void Reset()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		Statistics.Reset();
+	}
+
+private:
+
+	/** Guards the statistics. */
+	static FCriticalSection CriticalSection;
+
+	/** Holds the compression statistics per message type. */
+	static TMap<FName, FSGMessageCompressionStatistics> Statistics;
+};
+
+
+/**
+ * Implements thread-safe counters for message bus events.
+ *
+ * A single instance is shared by all router shards and dispatch tasks of a message bus.
+ */
+class FSGMessageStatistics
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageStatistics()
+		: TotalExpiredMessages(0)
+		, TotalDroppedMessages(0)
+		, TotalConflatedMessages(0)
+		, TotalDuplicateMessages(0)
+		, TotalRateLimitedMessages(0)
+	{
+		for (int32 LaneIndex = 0; LaneIndex < NumLanes; ++LaneIndex)
+		{
+			LaneCommands[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneLatencyCycles[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneMaxLatencyCycles[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneOverBudget[LaneIndex].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	/** Latency above which a routed command counts as over budget (in milliseconds). */
+	static constexpr double LatencyBudgetMs = 1.0;
+
+public:
+
+	/**
+	 * Counts a message that was dropped because it expired.
+	 *
+	 * @param MessageType The type of the dropped message.
+	 */
+	void CountExpiredMessage(const FName& MessageType)
+	{
+		TotalExpiredMessages.fetch_add(1, std::memory_order_relaxed);
+
+		FScopeLock Lock(&CriticalSection);
+		++ExpiredMessages.FindOrAdd(MessageType);
+	}
+
+	/**
+	 * Gets the number of expired messages of the given type.
+	 *
+	 * @param MessageType The message type.
+	 * @return Number of dropped messages.
+	 */
+	int64 GetExpiredMessageCount(const FName& MessageType) const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		return ExpiredMessages.FindRef(MessageType);
+	}
+
+	/**
+	 * Gets the number of expired messages per type.
+	 *
+	 * @param OutCounts Will hold the number of dropped messages per message type.
+	 */
+	void GetExpiredMessageCounts(TMap<FName, int64>& OutCounts) const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		OutCounts = ExpiredMessages;
+	}
+
+	/**
+	 * Gets the total number of expired messages.
+	 *
+	 * @return Number of dropped messages.
+	 */
+	int64 GetTotalExpiredMessageCount() const
+	{
+		return TotalExpiredMessages.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Counts a message that was dropped because a router command queue was full.
+	 *
+	 * @param MessageType The type of the dropped message.
+	 */
+	void CountDroppedMessage(const FName& MessageType)
+	{
+		TotalDroppedMessages.fetch_add(1, std::memory_order_relaxed);
+
+		FScopeLock Lock(&CriticalSection);
+		++DroppedMessages.FindOrAdd(MessageType);
+	}
+
+	/**
+	 * Gets the number of messages of the given type that were dropped because of backpressure.
+	 *
+	 * @param MessageType The message type.
+	 * @return Number of dropped messages.
+	 */
+	int64 GetDroppedMessageCount(const FName& MessageType) const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		return DroppedMessages.FindRef(MessageType);
+	}
+
+	/**
+	 * Gets the number of messages per type that were dropped because of backpressure.
+	 *
+	 * @param OutCounts Will hold the number of dropped messages per message type.
+	 */
+	void GetDroppedMessageCounts(TMap<FName, int64>& OutCounts) const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		OutCounts = DroppedMessages;
+	}
+
+	/**
+	 * Gets the total number of messages that were dropped because of backpressure.
+	 *
+	 * @return Number of dropped messages.
+	 */
+	int64 GetTotalDroppedMessageCount() const
+	{
+		return TotalDroppedMessages.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Counts an undelivered message that was replaced by a newer message with the same conflation key.
+	 */
+	void CountConflatedMessage()
+	{
+		TotalConflatedMessages.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Gets the total number of undelivered messages that were replaced by newer messages.
+	 *
+	 * @return Number of replaced messages.
+	 */
+	int64 GetTotalConflatedMessageCount() const
+	{
+		return TotalConflatedMessages.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Counts a message that was dropped because an identical message was routed within the deduplication window.
+	 */
+	void CountDuplicateMessage()
+	{
+		TotalDuplicateMessages.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	/**
+	 * Gets the total number of dropped duplicate messages.
+	 *
+	 * @return Number of duplicates.
+	 */
+	int64 GetTotalDuplicateMessageCount() const
+	{
+		return TotalDuplicateMessages.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Counts a message that was dropped because its sender exceeded a rate limit.
+	 *
+	 * @param MessageType The type (or tag) of the dropped message.
+	 */
+	void CountRateLimitedMessage(const FName& MessageType)
+	{
+		TotalRateLimitedMessages.fetch_add(1, std::memory_order_relaxed);
+
+		FScopeLock Lock(&CriticalSection);
+		++RateLimitedMessages.FindOrAdd(MessageType);
+	}
+
+	/**
+	 * Gets the number of messages per type that were dropped because of rate limits.
+	 *
+	 * @param OutCounts Will hold the number of dropped messages per message type.
+	 */
+	void GetRateLimitedMessageCounts(TMap<FName, int64>& OutCounts) const
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		OutCounts = RateLimitedMessages;
+	}
+
+	/**
+	 * Gets the total number of messages that were dropped because of rate limits.
+	 *
+	 * @return Number of dropped messages.
+	 */
+	int64 GetTotalRateLimitedMessageCount() const
+	{
+		return TotalRateLimitedMessages.load(std::memory_order_relaxed);
+	}
+
+	/**
+	 * Records the time a command waited in a router lane.
+	 *
+	 * @param Priority The priority lane the command was queued in.
+	 * @param LatencyCycles The time between enqueueing and execution (in CPU cycles).
+	 */
+	void RecordCommandLatency(ESGMessagePriority Priority, uint64 LatencyCycles)
+	{
+		static const uint64 BudgetCycles = (uint64)(LatencyBudgetMs / (FPlatformTime::GetSecondsPerCycle64() * 1000.0));
+
+		const int32 LaneIndex = (int32)Priority;
+
+		LaneCommands[LaneIndex].fetch_add(1, std::memory_order_relaxed);
+		LaneLatencyCycles[LaneIndex].fetch_add(LatencyCycles, std::memory_order_relaxed);
+
+		uint64 MaxLatencyCycles = LaneMaxLatencyCycles[LaneIndex].load(std::memory_order_relaxed);
+
+		while ((LatencyCycles > MaxLatencyCycles) && !LaneMaxLatencyCycles[LaneIndex].compare_exchange_weak(MaxLatencyCycles, LatencyCycles, std::memory_order_relaxed));
+
+		if (LatencyCycles > BudgetCycles)
+		{
+			LaneOverBudget[LaneIndex].fetch_add(1, std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * Gets the latency statistics of a router lane.
+	 *
+	 * @param Priority The priority lane.
+	 * @return The lane statistics.
+	 */
+	FSGMessageLaneStatistics GetLaneStatistics(ESGMessagePriority Priority) const
+	{
+		const int32 LaneIndex = (int32)Priority;
+		const double MillisecondsPerCycle = FPlatformTime::GetSecondsPerCycle64() * 1000.0;
+
+		FSGMessageLaneStatistics LaneStatistics;
+		{
+			LaneStatistics.NumCommands = LaneCommands[LaneIndex].load(std::memory_order_relaxed);
+			LaneStatistics.AverageLatencyMs = (LaneStatistics.NumCommands > 0) ? (double)LaneLatencyCycles[LaneIndex].load(std::memory_order_relaxed) * MillisecondsPerCycle / (double)LaneStatistics.NumCommands : 0.0;
+			LaneStatistics.MaxLatencyMs = (double)LaneMaxLatencyCycles[LaneIndex].load(std::memory_order_relaxed) * MillisecondsPerCycle;
+			LaneStatistics.NumOverBudget = LaneOverBudget[LaneIndex].load(std::memory_order_relaxed);
+		}
+
+		return LaneStatistics;
+	}
+
+	/** Resets all counters. */
+	void Reset()
+	{
+		FScopeLock Lock(&CriticalSection);
+
+		ExpiredMessages.Reset();
+		TotalExpiredMessages.store(0, std::memory_order_relaxed);
+		DroppedMessages.Reset();
+		TotalDroppedMessages.store(0, std::memory_order_relaxed);
+		TotalConflatedMessages.store(0, std::memory_order_relaxed);
+		TotalDuplicateMessages.store(0, std::memory_order_relaxed);
+		RateLimitedMessages.Reset();
+		TotalRateLimitedMessages.store(0, std::memory_order_relaxed);
+
+		for (int32 LaneIndex = 0; LaneIndex < NumLanes; ++LaneIndex)
+		{
+			LaneCommands[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneLatencyCycles[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneMaxLatencyCycles[LaneIndex].store(0, std::memory_order_relaxed);
+			LaneOverBudget[LaneIndex].store(0, std::memory_order_relaxed);
+		}
+	}
+
+private:
+
+	/** Number of router lanes. */
+	static constexpr int32 NumLanes = (int32)ESGMessagePriority::Num;
+
+	/** Guards the per type counters. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Maps message types to the number of expired messages. */
+	TMap<FName, int64> ExpiredMessages;
+
+	/** Holds the total number of expired messages. */
+	std::atomic<int64> TotalExpiredMessages;
+
+	/** Maps message types to the number of messages dropped because of backpressure. */
+	TMap<FName, int64> DroppedMessages;
+
+	/** Holds the total number of messages dropped because of backpressure. */
+	std::atomic<int64> TotalDroppedMessages;
+
+	/** Holds the total number of undelivered messages replaced by newer messages. */
+	std::atomic<int64> TotalConflatedMessages;
+
+	/** Holds the total number of dropped duplicate messages. */
+	std::atomic<int64> TotalDuplicateMessages;
+
+	/** Maps message types to the number of messages dropped because of rate limits. */
+	TMap<FName, int64> RateLimitedMessages;
+
+	/** Holds the total number of messages dropped because of rate limits. */
+	std::atomic<int64> TotalRateLimitedMessages;
+
+	/** Holds the number of processed commands per lane. */
+	std::atomic<int64> LaneCommands[NumLanes];
+
+	/** Holds the accumulated command latency per lane (in CPU cycles). */
+	std::atomic<uint64> LaneLatencyCycles[NumLanes];
+
+	/** Holds the largest command latency per lane (in CPU cycles). */
+	std::atomic<uint64> LaneMaxLatencyCycles[NumLanes];
+
+	/** Holds the number of commands over the latency budget per lane. */
+	std::atomic<int64> LaneOverBudget[NumLanes];
+};
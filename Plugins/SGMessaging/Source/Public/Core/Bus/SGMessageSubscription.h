@@ -4,6 +4,8 @@
 
 #include "CoreMinimal.h"
 #include "Core/Interface/ISGMessageSubscription.h"
+#include "Core/Bus/SGMessageContentFilter.h"
+#include "Core/Message/SGMessageProjection.h"
 
 class ISGMessageReceiver;
 
@@ -26,12 +28,23 @@ public:
 	 * @param InMessageType The type of messages to subscribe to.
 	 * @param InReceivingThread The thread on which to receive messages on.
 	 * @param InScopeRange The message scope range to subscribe to.
+	 * @param InConsumerGroup The consumer group to join (NAME_None = receive every message).
+	 * @param InConsumerPolicy The way the consumer group picks the member that receives a message.
+	 * @param InContentFilter The filter that messages must match (nullptr = all messages).
+	 * @param InProjection The parameters that the subscriber reads (nullptr = all parameters).
 	 */
-	FSGMessageSubscription(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& InSubscriber, const FName& InMessageType, const FSGMessageScopeRange& InScopeRange)
+	FSGMessageSubscription(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& InSubscriber, const FName& InMessageType, const FSGMessageScopeRange& InScopeRange,
+		const FName& InConsumerGroup = NAME_None, ESGMessageConsumerPolicy InConsumerPolicy = ESGMessageConsumerPolicy::RoundRobin,
+		const TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe>& InContentFilter = nullptr,
+		const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& InProjection = nullptr)
 		: Enabled(true)
 		, MessageType(InMessageType)
 		, ScopeRange(InScopeRange)
 		, Subscriber(InSubscriber)
+		, ConsumerGroup(InConsumerGroup)
+		, ConsumerPolicy(InConsumerPolicy)
+		, ContentFilter(InContentFilter)
+		, Projection(InProjection)
 	{ }
 
 public:
@@ -68,6 +81,26 @@ public:
 		return Enabled;
 	}
 
+	virtual FName GetConsumerGroup() override
+	{
+		return ConsumerGroup;
+	}
+
+	virtual ESGMessageConsumerPolicy GetConsumerPolicy() override
+	{
+		return ConsumerPolicy;
+	}
+
+	virtual const FSGMessageContentFilter* GetContentFilter() override
+	{
+		return ContentFilter.Get();
+	}
+
+	virtual TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe> GetProjection() override
+	{
+		return Projection;
+	}
+
 private:
 
 	/** Holds a flag indicating whether this subscription is enabled. */
@@ -81,4 +114,16 @@ private:
 
 	/** Holds the subscriber. */
 	TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber;
+
+	/** Holds the consumer group (NAME_None = not in a group). */
+	FName ConsumerGroup;
+
+	/** Holds the way the consumer group picks the member that receives a message. */
+	ESGMessageConsumerPolicy ConsumerPolicy;
+
+	/** Holds the filter that messages must match (nullptr = all messages). */
+	TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe> ContentFilter;
+
+	/** Holds the parameters that the subscriber reads (nullptr = all parameters). */
+	TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe> Projection;
 };
@@ -0,0 +1,391 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Algo/Sort.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Core/Interface/ISGMessageContext.h"
+#include "Core/Interface/ISGMessageReceiver.h"
+#include "Core/Interface/ISGMessageSubscription.h"
+#include "Core/Bus/SGMessageContentFilter.h"
+#include <atomic>
+
+/**
+ * Implements the router's subscription table for a single message type.
+ *
+ * The table keeps the data needed to filter subscriptions in parallel arrays, so that matching
+ * a message against all subscribers is a linear scan over contiguous memory. Scope ranges are
+ * packed into bit masks, receiver handles are cached when the subscription is added, and subscriber
+ * liveness is checked by reading the weak reference count instead of pinning every subscriber.
+ * Only subscribers that pass all filters are pinned.
+ *
+ * Recipient threads are not cached, because endpoints may change theirs at any time. They are only
+ * needed for Thread scope messages, whose subscribers are pinned to read the current thread.
+ *
+ * The enabled flag is still read from the subscription itself, because subscriptions can be
+ * enabled and disabled from any thread without the router being involved.
+ *
+ * Subscriptions in a consumer group are matched like the others, but only one member of each
+ * group is passed on per message. Content filters run last, after all cheaper filters passed.
+ *
+ * This class is not thread-safe. The router owns its tables, and copies of them are shared
+ * read-only with publishing threads for direct dispatch.
+ */
+class FSGMessageSubscriptionTable
+{
+public:
+
+	/**
+	 * Adds a subscription, unless it was already added.
+	 *
+	 * @param Subscription The subscription to add.
+	 * @return true if the subscription was added, false otherwise.
+	 */
+	bool Add(const TSharedRef<ISGMessageSubscription, ESPMode::ThreadSafe>& Subscription)
+	{
+		if (Subscriptions.Contains(Subscription))
+		{
+			return false;
+		}
+
+		const TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& SubscriberPtr = Subscription->GetSubscriber();
+		const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber = SubscriberPtr.Pin();
+
+		Subscriptions.Add(Subscription);
+		Subscribers.Add(SubscriberPtr);
+		SubscriberHandles.Add(Subscriber.Get());
+		ScopeMasks.Add(MakeScopeMask(Subscription->GetScopeRange()));
+		GroupIndices.Add(FindOrAddGroup(Subscription->GetConsumerGroup(), Subscription->GetConsumerPolicy()));
+		ContentFilters.Add(Subscription->GetContentFilter());
+
+		return true;
+	}
+
+	/**
+	 * Calls the given function for every live and enabled subscriber that matches the message.
+	 *
+	 * Of the matching members of a consumer group, only the one that the group picks is passed on.
+	 *
+	 * @param Context The context of the message.
+	 * @param Callback The function to call with the receiver handle and weak receiver pointer.
+	 * @return true if stale subscriptions were found, false otherwise.
+	 * @see RemoveStaleSubscriptions
+	 */
+	template<typename CallbackType>
+	bool ForEachMatchingSubscriber(const ISGMessageContext& Context, CallbackType&& Callback) const
+	{
+		const ESGMessageScope MessageScope = Context.GetScope();
+		const ENamedThreads::Type SenderThread = Context.GetSenderThread();
+		const uint8 MessageScopeBit = MakeScopeBit(MessageScope);
+		const bool bCheckThread = (MessageScope == ESGMessageScope::Thread);
+		bool bFoundStale = false;
+
+		TArray<int32, TInlineAllocator<16>> GroupMembers;
+
+		for (int32 Index = 0; Index < ScopeMasks.Num(); ++Index)
+		{
+			if ((ScopeMasks[Index] & MessageScopeBit) == 0)
+			{
+				continue;
+			}
+
+			if (bCheckThread)
+			{
+				const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber = Subscribers[Index].Pin();
+
+				if (!Subscriber.IsValid())
+				{
+					bFoundStale = true;
+
+					continue;
+				}
+
+				if (Subscriber->GetRecipientThread() != SenderThread)
+				{
+					continue;
+				}
+			}
+			else if (!Subscribers[Index].IsValid())
+			{
+				bFoundStale = true;
+
+				continue;
+			}
+
+			if (!Subscriptions[Index]->IsEnabled())
+			{
+				continue;
+			}
+
+			if ((ContentFilters[Index] != nullptr) && !ContentFilters[Index]->Matches(Context))
+			{
+				continue;
+			}
+
+			if (GroupIndices[Index] != INDEX_NONE)
+			{
+				GroupMembers.Add(Index);
+			}
+			else
+			{
+				Callback(SubscriberHandles[Index], Subscribers[Index]);
+			}
+		}
+
+		if (GroupMembers.Num() > 0)
+		{
+			// keep each group's members together, in table order
+			Algo::Sort(GroupMembers, [this](int32 A, int32 B) {
+				return (GroupIndices[A] != GroupIndices[B]) ? (GroupIndices[A] < GroupIndices[B]) : (A < B);
+			});
+
+			for (int32 First = 0; First < GroupMembers.Num();)
+			{
+				int32 Last = First + 1;
+
+				while ((Last < GroupMembers.Num()) && (GroupIndices[GroupMembers[Last]] == GroupIndices[GroupMembers[First]]))
+				{
+					++Last;
+				}
+
+				const int32 Index = PickGroupMember(Groups[GroupIndices[GroupMembers[First]]], MakeArrayView(GroupMembers.GetData() + First, Last - First), Context);
+				Callback(SubscriberHandles[Index], Subscribers[Index]);
+
+				First = Last;
+			}
+		}
+
+		return bFoundStale;
+	}
+
+	/**
+	 * Gets the subscriptions in this table.
+	 *
+	 * @return The subscriptions.
+	 */
+	const TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>>& GetSubscriptions() const
+	{
+		return Subscriptions;
+	}
+
+	/**
+	 * Gets the number of subscriptions in this table.
+	 *
+	 * @return Number of subscriptions.
+	 */
+	int32 Num() const
+	{
+		return Subscriptions.Num();
+	}
+
+	/**
+	 * Gets the size of the memory allocated by this table.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const
+	{
+		return Subscriptions.GetAllocatedSize() + Subscribers.GetAllocatedSize() + SubscriberHandles.GetAllocatedSize()
+			+ ScopeMasks.GetAllocatedSize() + GroupIndices.GetAllocatedSize() + ContentFilters.GetAllocatedSize() + Groups.GetAllocatedSize();
+	}
+
+	/**
+	 * Removes the subscription at the given index.
+	 *
+	 * The last subscription is moved into the freed slot.
+	 *
+	 * @param Index The index of the subscription to remove.
+	 */
+	void RemoveAtSwap(int32 Index)
+	{
+		Subscriptions.RemoveAtSwap(Index);
+		Subscribers.RemoveAtSwap(Index);
+		SubscriberHandles.RemoveAtSwap(Index);
+		ScopeMasks.RemoveAtSwap(Index);
+		GroupIndices.RemoveAtSwap(Index);
+		ContentFilters.RemoveAtSwap(Index);
+	}
+
+	/**
+	 * Removes a subscription.
+	 *
+	 * The last subscription is moved into the freed slot.
+	 *
+	 * @param Subscription The subscription to remove.
+	 * @return true if the subscription was removed, false if it isn't in this table.
+	 */
+	bool Remove(const ISGMessageSubscription* Subscription)
+	{
+		const int32 Index = Subscriptions.IndexOfByPredicate([Subscription](const TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>& Candidate) {
+			return Candidate.Get() == Subscription;
+		});
+
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		RemoveAtSwap(Index);
+
+		return true;
+	}
+
+	/**
+	 * Removes all subscriptions whose subscriber no longer exists.
+	 *
+	 * @return Number of removed subscriptions.
+	 */
+	int32 RemoveStaleSubscriptions()
+	{
+		int32 NumRemoved = 0;
+
+		for (int32 Index = Subscribers.Num() - 1; Index >= 0; --Index)
+		{
+			if (!Subscribers[Index].IsValid())
+			{
+				RemoveAtSwap(Index);
+				++NumRemoved;
+			}
+		}
+
+		return NumRemoved;
+	}
+
+private:
+
+	/** Structure for a consumer group of this table. */
+	struct FConsumerGroup
+	{
+		/** Holds the name of the group. */
+		FName Name;
+
+		/** Holds the way the group picks the member that receives a message. */
+		ESGMessageConsumerPolicy Policy;
+
+		/** Holds the rotation of the group, which is shared by copies of the table so that direct dispatch continues it. */
+		TSharedRef<std::atomic<uint32>, ESPMode::ThreadSafe> NextMember;
+	};
+
+	/**
+	 * Gets the index of a consumer group, adding the group if it doesn't exist yet.
+	 *
+	 * @param GroupName The name of the group.
+	 * @param Policy The policy of the group, if it is added.
+	 * @return The group's index, or INDEX_NONE if the name is NAME_None.
+	 */
+	int32 FindOrAddGroup(const FName& GroupName, ESGMessageConsumerPolicy Policy)
+	{
+		if (GroupName.IsNone())
+		{
+			return INDEX_NONE;
+		}
+
+		const int32 GroupIndex = Groups.IndexOfByPredicate([&GroupName](const FConsumerGroup& Group) { return Group.Name == GroupName; });
+
+		if (GroupIndex != INDEX_NONE)
+		{
+			return GroupIndex;
+		}
+
+		// groups are never removed, there are only ever a handful per message type
+		return Groups.Add({ GroupName, Policy, MakeShared<std::atomic<uint32>, ESPMode::ThreadSafe>(0) });
+	}
+
+	/**
+	 * Picks the member of a consumer group that receives a message.
+	 *
+	 * @param Group The consumer group.
+	 * @param Members The indices of the group's matching subscriptions.
+	 * @param Context The context of the message.
+	 * @return The index of the picked subscription.
+	 */
+	int32 PickGroupMember(const FConsumerGroup& Group, TArrayView<const int32> Members, const ISGMessageContext& Context) const
+	{
+		const uint32 NumMembers = (uint32)Members.Num();
+
+		if (NumMembers == 1)
+		{
+			return Members[0];
+		}
+
+		if (Group.Policy == ESGMessageConsumerPolicy::KeyHash)
+		{
+			const FString* Key = Context.GetAnnotations().Find(SGMessageConsumerGroup::KeyAnnotation);
+			const uint32 KeyHash = (Key != nullptr) ? GetTypeHash(*Key) : GetTypeHash(Context.GetSender());
+
+			return Members[KeyHash % NumMembers];
+		}
+
+		const uint32 Offset = Group.NextMember->fetch_add(1, std::memory_order_relaxed);
+
+		if (Group.Policy == ESGMessageConsumerPolicy::RoundRobin)
+		{
+			return Members[Offset % NumMembers];
+		}
+
+		// start at the rotation, so that idle members take turns
+		int32 PickedIndex = Members[Offset % NumMembers];
+		int32 PickedQueueDepth = MAX_int32;
+
+		for (uint32 MemberOffset = 0; MemberOffset < NumMembers; ++MemberOffset)
+		{
+			const int32 Index = Members[(Offset + MemberOffset) % NumMembers];
+			const TSharedPtr<ISGMessageReceiver, ESPMode::ThreadSafe> Subscriber = Subscribers[Index].Pin();
+			const int32 QueueDepth = Subscriber.IsValid() ? Subscriber->GetNumQueuedMessages() : MAX_int32;
+
+			if (QueueDepth < PickedQueueDepth)
+			{
+				PickedIndex = Index;
+				PickedQueueDepth = QueueDepth;
+			}
+		}
+
+		return PickedIndex;
+	}
+
+	/** Gets the scope mask bit for the given message scope. */
+	static uint8 MakeScopeBit(ESGMessageScope Scope)
+	{
+		return (uint8)(1 << (uint8)Scope);
+	}
+
+	/** Packs a scope range into a bit mask with one bit per message scope. */
+	static uint8 MakeScopeMask(const FSGMessageScopeRange& ScopeRange)
+	{
+		uint8 Mask = 0;
+
+		for (uint8 Scope = 0; Scope <= (uint8)ESGMessageScope::All; ++Scope)
+		{
+			if (ScopeRange.Contains((ESGMessageScope)Scope))
+			{
+				Mask |= MakeScopeBit((ESGMessageScope)Scope);
+			}
+		}
+
+		return Mask;
+	}
+
+private:
+
+	/** Holds the subscriptions. */
+	TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> Subscriptions;
+
+	/** Holds weak pointers to the subscribers. */
+	TArray<TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>> Subscribers;
+
+	/** Holds the raw subscriber handles (for deduplication only, never dereferenced). */
+	TArray<const ISGMessageReceiver*> SubscriberHandles;
+
+	/** Holds the subscribed scopes as bit masks. */
+	TArray<uint8> ScopeMasks;
+
+	/** Holds the indices of the subscriptions' consumer groups (INDEX_NONE = not in a group). */
+	TArray<int32> GroupIndices;
+
+	/** Holds the subscriptions' content filters (nullptr = no filter, owned by the subscriptions). */
+	TArray<const FSGMessageContentFilter*> ContentFilters;
+
+	/** Holds the consumer groups. */
+	TArray<FConsumerGroup> Groups;
+};
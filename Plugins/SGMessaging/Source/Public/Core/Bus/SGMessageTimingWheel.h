@@ -0,0 +1,210 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/SparseArray.h"
+#include "Templates/Function.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Interface/ISGMessageContext.h"
+
+/**
+ * Implements a hierarchical timing wheel for delayed messages.
+ *
+ * The wheel is driven by a monotonic millisecond tick. It has four levels of 64 slots each,
+ * covering roughly 4.6 hours; timers further in the future are parked in the top level and
+ * re-inserted when their slot comes around. Adding and cancelling timers is O(1), and all
+ * timers of a tick expire in bulk. Timers that expire on the same tick are returned in the
+ * order in which they were added.
+ *
+ * Besides delayed messages, the wheel holds plain timeouts without a message (i.e. for requests).
+ * Delayed messages are also indexed by recipient, so that the messages of recipients that went away
+ * can be purged in bulk instead of sitting in the wheel until they are due.
+ *
+ * This class is not thread-safe and is owned by the message router thread.
+ */
+class FSGMessageTimingWheel
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageTimingWheel();
+
+public:
+
+	/**
+	 * Adds a timer for the given message context.
+	 *
+	 * @param Id The unique identifier of the timer (used for cancellation and ordering).
+	 * @param ExpirationTick The tick at which the timer expires.
+	 * @param Context The context of the delayed message.
+	 */
+	void Add(uint64 Id, uint64 ExpirationTick, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/**
+	 * Adds a timeout, which is a timer without a message.
+	 *
+	 * @param Id The unique identifier of the timer (used for cancellation and ordering).
+	 * @param ExpirationTick The tick at which the timer expires.
+	 */
+	void AddTimeout(uint64 Id, uint64 ExpirationTick);
+
+	/**
+	 * Advances the wheel to the given tick and collects all expired timers.
+	 *
+	 * @param NowTick The current tick.
+	 * @param OutExpired Will hold the contexts of the expired timers.
+	 * @param OutExpiredTimeouts Will hold the identifiers of the expired timeouts.
+	 */
+	void Advance(uint64 NowTick, TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutExpired, TArray<uint64>& OutExpiredTimeouts);
+
+	/**
+	 * Gets the tick the wheel has advanced to.
+	 *
+	 * @return Current tick.
+	 */
+	uint64 GetCurrentTick() const
+	{
+		return CurrentTick;
+	}
+
+	/**
+	 * Gets the number of ticks until the wheel needs to be advanced again.
+	 *
+	 * The result is exact if the next timer expires within the current lowest level rotation,
+	 * otherwise it is the number of ticks until the next cascade.
+	 *
+	 * @param MaxTicks The maximum number of ticks to return.
+	 * @return Number of ticks to wait.
+	 */
+	uint64 GetTicksUntilNextAdvance(uint64 MaxTicks) const;
+
+	/**
+	 * Gets the number of pending timers.
+	 *
+	 * @return Number of timers.
+	 */
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	/**
+	 * Gets the size of the memory allocated by the wheel, not including its buckets.
+	 *
+	 * @return Allocated size (in bytes).
+	 */
+	SIZE_T GetAllocatedSize() const;
+
+	/**
+	 * Removes a pending timer.
+	 *
+	 * @param Id The identifier of the timer to remove.
+	 * @return true if the timer was removed, false if it was not found (already expired or cancelled).
+	 */
+	bool Remove(uint64 Id);
+
+	/**
+	 * Removes the pending delayed messages to a recipient that match a predicate.
+	 *
+	 * @param Recipient The address of the recipient.
+	 * @param ShouldRemove Predicate that decides whether to remove a message addressed to the recipient.
+	 * @param OutRemoved Will hold the contexts of the removed messages.
+	 * @return The number of removed messages.
+	 */
+	int32 RemoveByRecipient(const FSGMessageAddress& Recipient, TFunctionRef<bool(const ISGMessageContext&)> ShouldRemove, TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutRemoved);
+
+public:
+
+	/**
+	 * Gets the current monotonic tick (milliseconds).
+	 *
+	 * @return The current tick.
+	 * @see FSGMessageClock::Milliseconds
+	 */
+	static uint64 GetMonotonicTick()
+	{
+		return FSGMessageClock::Milliseconds();
+	}
+
+private:
+
+	/** Number of bits per level. */
+	static constexpr int32 SlotBits = 6;
+
+	/** Number of slots per level. */
+	static constexpr int32 NumSlots = 1 << SlotBits;
+
+	/** Mask for slot indices. */
+	static constexpr uint64 SlotMask = NumSlots - 1;
+
+	/** Number of levels. */
+	static constexpr int32 NumLevels = 4;
+
+	/** Structure for pending timers. */
+	struct FEntry
+	{
+		/** Holds the context of the delayed message (null for timeouts). */
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+		/** Holds the timer identifier. */
+		uint64 Id;
+
+		/** Holds the tick at which the timer expires. */
+		uint64 ExpirationTick;
+
+		/** Holds the index of the previous entry in the bucket (INDEX_NONE = head). */
+		int32 Prev;
+
+		/** Holds the index of the next entry in the bucket (INDEX_NONE = tail). */
+		int32 Next;
+
+		/** Holds the index of the bucket the entry is linked into. */
+		int32 Bucket;
+	};
+
+	/** Structure for timer buckets. */
+	struct FBucket
+	{
+		int32 Head = INDEX_NONE;
+		int32 Tail = INDEX_NONE;
+	};
+
+	/** Adds an entry for the given timer. */
+	void AddEntry(uint64 Id, uint64 ExpirationTick, const TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/** Links an entry into the bucket matching its expiration tick. */
+	void Link(int32 EntryIndex);
+
+	/** Unlinks an entry from its bucket. */
+	void Unlink(int32 EntryIndex);
+
+	/** Re-inserts all entries of the given bucket into lower levels. */
+	void Cascade(int32 Level);
+
+	/** Adds an entry to the recipient index. */
+	void IndexRecipients(int32 EntryIndex);
+
+	/** Removes an entry from the recipient index. */
+	void UnindexRecipients(int32 EntryIndex);
+
+private:
+
+	/** Holds the timer buckets (NumLevels * NumSlots). */
+	FBucket Buckets[NumLevels * NumSlots];
+
+	/** Holds the tick the wheel has advanced to. */
+	uint64 CurrentTick;
+
+	/** Holds the pending timers. */
+	TSparseArray<FEntry> Entries;
+
+	/** Maps timer identifiers to entry indices. */
+	TMap<uint64, int32> IdToEntry;
+
+	/** Maps recipient addresses to the timer identifiers of the delayed messages sent to them. */
+	TMap<FSGMessageAddress, TArray<uint64>> RecipientIndex;
+
+	/** Holds the entries expiring in the tick being processed (scratch). */
+	TArray<int32> ExpiringEntries;
+};
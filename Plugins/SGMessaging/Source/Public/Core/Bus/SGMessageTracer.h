@@ -7,8 +7,13 @@
 #include "Containers/Queue.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageTracer.h"
+#include "Core/Bus/SGMessageMemory.h"
 #include "Containers/Ticker.h"
+#include "Misc/ScopeRWLock.h"
+#include <atomic>
 
+class FRunnable;
+class FRunnableThread;
 class ISGMessageInterceptor;
 class ISGMessageReceiver;
 class ISGMessageSubscription;
@@ -16,6 +21,15 @@ class ISGMessageTracerBreakpoint;
 
 /**
  * Implements a message bus tracers.
+ *
+ * Trace points write fixed-size records into per-thread single-producer ring buffers, which a consumer
+ * thread merges into the tracer's database of endpoints, messages and types. Trace points never wait
+ * for the consumer; records that don't fit into a full buffer are dropped and counted. Registration
+ * events are rare and go through a separate queue, so that they are never dropped.
+ *
+ * Traced messages are kept in a ring buffer that is bounded by the retention limits of the messaging
+ * settings (or SetRetention). The oldest messages are evicted by the consumer. The tracer's delegates
+ * are executed on the game thread when the tracer ticks.
  */
 class FSGMessageTracer
 	: public ISGMessageTracer
@@ -124,7 +138,22 @@ public:
 	virtual int32 GetEndpoints(TArray<TSharedPtr<FSGMessageTracerEndpointInfo>>& OutEndpoints) const override;
 	virtual int32 GetMessages(TArray<TSharedPtr<FSGMessageTracerMessageInfo>>& OutMessages) const override;
 	virtual int32 GetMessageTypes(TArray<TSharedPtr<FSGMessageTracerTypeInfo>>& OutTypes) const override;
+	virtual TSharedPtr<FSGMessageTracerTypeInfo> FindMessageType(const FName& MessageType) const override;
+	virtual void ResetLatencies() override;
 	virtual bool HasMessages() const override;
+	virtual int64 GetNumTracedMessages() const override;
+	virtual int64 GetNumEvictedMessages() const override;
+	virtual FSGMessageTracerRetention GetRetention() const override;
+	virtual void SetRetention(const FSGMessageTracerRetention& InRetention) override;
+	virtual int32 GetSampleRate(const FName& MessageType = NAME_None) const override;
+	virtual void SetSampleRate(int32 SampleRate, const FName& MessageType = NAME_None) override;
+	virtual int64 GetNumDroppedTraces() const override;
+	virtual void GetCompressionStatistics(TMap<FName, FSGMessageCompressionStatistics>& OutStatistics) const override;
+	virtual FCriticalSection& GetInfoLock() const override;
+	virtual void AddBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint, TArrayView<const FName> MessageTypes = TArrayView<const FName>()) override;
+	virtual void RemoveBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint) override;
+	virtual int32 GetCapturedMessages(TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutContexts) const override;
+	virtual void ClearCapturedMessages() override;
 	virtual bool IsBreaking() const override;
 	virtual bool IsRunning() const override;
 
@@ -140,6 +169,12 @@ public:
 		return MessagesResetDelegate;
 	}
 
+	DECLARE_DERIVED_EVENT(FSGMessageTracer, ISGMessageTracer::FOnMessagesEvicted, FOnMessagesEvicted)
+	virtual FOnMessagesEvicted& OnMessagesEvicted() override
+	{
+		return MessagesEvictedDelegate;
+	}
+
 	DECLARE_DERIVED_EVENT(FSGMessageTracer, ISGMessageTracer::FOnTypeAdded, FOnTypeAdded)
 	virtual FOnTypeAdded& OnTypeAdded() override
 	{
@@ -151,17 +186,194 @@ public:
 	virtual void Stop();
 	virtual bool Tick(float DeltaTime) override;
 
+public:
+
+	/**
+	 * Adds the memory footprint of the trace buffers and the message history to a report.
+	 *
+	 * The size of the history is estimated from the traced messages (see EstimateMessageBytes).
+	 * This method is safe to call from any thread.
+	 *
+	 * @param InOutReport The report to add to.
+	 * @see FSGMessageRouter::AccumulateMemoryReport
+	 */
+	void AccumulateMemoryReport(FSGMessageMemoryReport& InOutReport) const;
+
 protected:
 
+	/** Enumerates the types of trace records. */
+	enum class ETraceRecordType : uint8
+	{
+		AddedInterceptor,
+		AddedRecipient,
+		DispatchedMessage,
+		HandledMessage,
+		InterceptedMessage,
+		RemovedInterceptor,
+		RemovedRecipient,
+		RoutedMessage,
+		SentMessage
+	};
+
+	/** Structure for a trace record, which holds the values that a trace point captured. */
+	struct FTraceRecord
+	{
+		/** Holds the type of the record. */
+		ETraceRecordType Type = ETraceRecordType::SentMessage;
+
+		/** Holds whether a message was dispatched asynchronously, or whether a recipient is remote. */
+		bool bFlag = false;
+
+		/** Holds the recipient's thread of dispatched messages. */
+		ENamedThreads::Type RecipientThread = ENamedThreads::AnyThread;
+
+		/** Holds the time of the event (in seconds). */
+		double Timestamp = 0.0;
+
+		/** Holds the trace identifier of the message (message events). */
+		uint64 TraceId = 0;
+
+		/** Holds the message context of sent messages, so that it stays alive until the record is applied. */
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+
+		/** Holds the identifier of the recipient or interceptor. */
+		FGuid Id;
+
+		/** Holds the address of registered or unregistered recipients. */
+		FSGMessageAddress Address;
+
+		/** Holds the debug name of registered recipients and interceptors. */
+		FName Name;
+	};
+
+	class FConsumer;
+	class FTraceBuffer;
+
+	/**
+	 * Writes a message trace record into the calling thread's trace buffer.
+	 *
+	 * @param Record The record to write (dropped if the buffer is full).
+	 */
+	void WriteRecord(FTraceRecord&& Record);
+
+	/**
+	 * Enqueues a registration trace record.
+	 *
+	 * @param Record The record to enqueue.
+	 */
+	void WriteRegistrationRecord(FTraceRecord&& Record);
+
+	/** Registers the tick delegate unless that already happened (tracers of idle buses don't tick). */
+	void EnsureTicking();
+
+	/** Gets the calling thread's trace buffer, creating it the first time. */
+	FTraceBuffer& GetThreadBuffer();
+
+	/** Merges the trace records of all threads into the database. */
+	void ProcessRecords();
+
+	/**
+	 * Applies a trace record to the database.
+	 *
+	 * @param Record The record to apply.
+	 * @return false if the record refers to a message that isn't known (yet), true otherwise.
+	 */
+	bool ApplyRecord(FTraceRecord& Record);
+
+	/** Executes the delegates of the changes that the consumer made since the last tick. */
+	void BroadcastNotifications();
+
 	/** Resets traced messages. */
 	void ResetMessages();
 
+	/**
+	 * Adds a message to the history.
+	 *
+	 * @param MessageInfo The message to add.
+	 */
+	void AddToHistory(const TSharedRef<FSGMessageTracerMessageInfo>& MessageInfo);
+
+	/** Evicts the oldest messages until the history is within its retention limits. */
+	void EnforceRetention();
+
+	/**
+	 * Estimates the memory that a traced message holds on to.
+	 *
+	 * @param MessageInfo The message.
+	 * @return The estimated size (in bytes).
+	 */
+	static int64 EstimateMessageBytes(const FSGMessageTracerMessageInfo& MessageInfo);
+
 	/**
 	 * Checks whether the tracer should break on the given message.
 	 *
+	 * Capture breakpoints that the message hits keep its context, but don't break.
+	 *
 	 * @param Context The context of the message to consider for breaking.
+	 * @return true if the router thread should wait until the tracer continues, false otherwise.
+	 */
+	bool ShouldBreak(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context);
+
+	/** Compiles the breakpoints into a new breakpoint table (the breakpoint lock must be held). */
+	void CompileBreakpoints();
+
+	/**
+	 * Checks whether the tracer samples the given message.
+	 *
+	 * @param Context The context of the sent message.
+	 * @return true if the message is traced, false otherwise.
 	 */
-	bool ShouldBreak(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) const;
+	bool ShouldSample(const ISGMessageContext& Context) const;
+
+private:
+
+	/** Structure for the sampling state of a message type. */
+	struct FSampler
+	{
+		/** Holds the sample rate. */
+		int32 SampleRate;
+
+		/** Holds the number of messages sampled so far. */
+		mutable std::atomic<uint64> NumMessages;
+
+		explicit FSampler(int32 InSampleRate)
+			: SampleRate(InSampleRate)
+			, NumMessages(0)
+		{ }
+	};
+
+	/** Structure for the sample rates, which are replaced as a whole when they change. */
+	struct FSamplingConfig
+	{
+		/** Holds the sampler of message types without their own sample rate. */
+		TSharedPtr<FSampler, ESPMode::ThreadSafe> DefaultSampler;
+
+		/** Holds the samplers of message types with their own sample rate. */
+		TMap<FName, TSharedPtr<FSampler, ESPMode::ThreadSafe>> TypeSamplers;
+
+		/** Whether every message is traced (so that sending doesn't touch the samplers). */
+		bool bSampleAll = true;
+	};
+
+	/** Structure for a breakpoint and the message types it applies to. */
+	struct FBreakpoint
+	{
+		/** Holds the breakpoint. */
+		TSharedPtr<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe> Breakpoint;
+
+		/** Holds the message types to check the breakpoint for (empty = all message types). */
+		TArray<FName> MessageTypes;
+	};
+
+	/** Structure for the compiled breakpoints, which are replaced as a whole when breakpoints change. */
+	struct FBreakpointTable
+	{
+		/** Holds the breakpoints by message type, including the breakpoints of all message types. */
+		TMap<FName, TArray<TSharedPtr<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>>> TypeBreakpoints;
+
+		/** Holds the breakpoints of all message types (for message types without their own breakpoints). */
+		TArray<TSharedPtr<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>> AllTypeBreakpoints;
+	};
 
 private:
 
@@ -172,7 +384,31 @@ private:
 	bool Breaking;
 
 	/** Holds the collection of breakpoints. */
-	TArray<TSharedPtr<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>> Breakpoints;
+	TArray<FBreakpoint> Breakpoints;
+
+	/** Guards the collection of breakpoints. */
+	FCriticalSection BreakpointsCriticalSection;
+
+	/** Holds the compiled breakpoints (null if there are none). */
+	TSharedPtr<const FBreakpointTable, ESPMode::ThreadSafe> BreakpointTable;
+
+	/** Guards the breakpoint table pointer. */
+	mutable FRWLock BreakpointTableLock;
+
+	/** Holds a flag indicating whether there are any breakpoints (so that routing skips the table otherwise). */
+	std::atomic<bool> bHasBreakpoints;
+
+	/** Holds the contexts of the messages that hit capture breakpoints, oldest first from CapturedMessagesHead. */
+	TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> CapturedMessages;
+
+	/** Holds the index of the oldest captured context. */
+	int32 CapturedMessagesHead;
+
+	/** Guards the captured contexts. */
+	mutable FCriticalSection CapturedMessagesCriticalSection;
+
+	/** Maximum number of captured contexts, older captures are replaced. */
+	static constexpr int32 MaxCapturedMessages = 1024;
 
 	/** Holds an event signaling that messaging routing can continue. */
 	FEvent* ContinueEvent;
@@ -183,14 +419,44 @@ private:
 	/** Holds the collection of endpoints for known recipient identifiers. */
 	TMap<FGuid, TSharedPtr<FSGMessageTracerEndpointInfo>> RecipientsToEndpointInfos;
 
-	/** Holds the collection of known messages. */
-	TMap<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>, TSharedPtr<FSGMessageTracerMessageInfo>> MessageInfos;
+	/** Holds the collection of known messages by trace identifier. */
+	TMap<uint64, TSharedPtr<FSGMessageTracerMessageInfo>> MessageInfos;
+
+	/** Holds the trace identifier of the next sampled message (identifiers are never reused). */
+	std::atomic<uint64> NextTraceId;
+
+	/** Holds the ring buffer of retained messages, oldest first from HistoryHead. */
+	TArray<TSharedPtr<FSGMessageTracerMessageInfo>> History;
+
+	/** Holds the index of the oldest message in the history. */
+	int32 HistoryHead;
+
+	/** Holds the number of messages in the history. */
+	int32 HistoryNum;
+
+	/** Holds the estimated memory of the messages in the history (in bytes). */
+	int64 HistoryBytes;
+
+	/** Holds the number of messages traced since the last reset. */
+	int64 NumTracedMessages;
+
+	/** Holds the number of messages evicted since the last reset. */
+	int64 NumEvictedMessages;
+
+	/** Holds the retention limits of the history. */
+	FSGMessageTracerRetention Retention;
+
+	/** Holds the sample rates. */
+	TSharedPtr<const FSamplingConfig, ESPMode::ThreadSafe> SamplingConfig;
+
+	/** Guards the sample rates. */
+	mutable FRWLock SamplingConfigLock;
 
 	/** Holds the collection of known message types. */
 	TMap<FName, TSharedPtr<FSGMessageTracerTypeInfo>> MessageTypes;
 
 	/** Holds a flag indicating whether a reset is pending. */
-	bool ResetPending;
+	std::atomic<bool> ResetPending;
 
 	/** Holds a flag indicating whether the tracer is running. */
 	bool Running;
@@ -198,17 +464,80 @@ private:
 	/** Handle to the registered TickDelegate. */
 	FTSTicker::FDelegateHandle TickDelegateHandle;
 
-	/** Holds the trace actions queue. */
-	TQueue<TFunction<void()>, EQueueMode::Mpsc> Traces;
+	/** Holds a flag indicating whether the TickDelegate is registered. */
+	std::atomic<bool> TickRegistered;
+
+	/** Guards the registration of the TickDelegate. */
+	FCriticalSection TickCriticalSection;
+
+	/** Holds the unique identifier of this tracer (to find its buffers in the thread-local storage). */
+	uint32 TracerId;
+
+	/** Holds the capacity of each thread's trace buffer. */
+	uint32 ThreadBufferCapacity;
+
+	/** Holds the trace buffers of all threads that traced messages. */
+	TArray<TSharedPtr<FTraceBuffer, ESPMode::ThreadSafe>> ThreadBuffers;
+
+	/** Guards the list of trace buffers. */
+	mutable FCriticalSection ThreadBuffersCriticalSection;
+
+	/** Holds the registration trace records. */
+	TQueue<FTraceRecord, EQueueMode::Mpsc> RegistrationRecords;
+
+	/** Holds the records of messages that weren't known yet when they were applied. */
+	TArray<FTraceRecord> DeferredRecords;
+
+	/** Holds the number of trace records that were dropped because a buffer was full. */
+	std::atomic<int64> NumDroppedTraces;
+
+	/** Guards the database (the info structures and the history). */
+	mutable FCriticalSection InfoCriticalSection;
+
+	/** Holds the consumer runnable (nullptr if the tracer wasn't started, or if the platform doesn't support threads). */
+	FRunnable* Consumer;
+
+	/** Holds the consumer thread. */
+	FRunnableThread* ConsumerThread;
+
+	/** Holds an event that wakes up the consumer thread. */
+	FEvent* ConsumerEvent;
+
+	/** Holds a flag indicating whether the consumer thread should exit. */
+	std::atomic<bool> ConsumerStopping;
 
 private:
 
+	/** Enumerates the changes that are broadcast on the next tick. */
+	enum class ENotification : uint8
+	{
+		MessageAdded,
+		MessagesEvicted,
+		MessagesReset,
+		TypeAdded
+	};
+
+	/** Structure for a change that is broadcast on the next tick. */
+	struct FNotification
+	{
+		ENotification Type;
+		TSharedPtr<FSGMessageTracerMessageInfo> MessageInfo;
+		TSharedPtr<FSGMessageTracerTypeInfo> TypeInfo;
+		int32 NumEvicted = 0;
+	};
+
+	/** Holds the changes that are broadcast on the next tick (guarded by InfoCriticalSection). */
+	TArray<FNotification> PendingNotifications;
+
 	/** Holds a delegate that is executed when a new message has been added to the collection of known messages. */
 	FOnMessageAdded MessagesAddedDelegate;
 
 	/** Holds a delegate that is executed when the message history has been reset. */
 	FOnMessagesReset MessagesResetDelegate;
 
+	/** Holds a delegate that is executed when messages have been evicted from the history. */
+	FOnMessagesEvicted MessagesEvictedDelegate;
+
 	/** Holds a delegate that is executed when a new type has been added to the collection of known message types. */
 	FOnTypeAdded TypeAddedDelegate;
 };
@@ -3,12 +3,128 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Async/MappedFileHandle.h"
 #include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
 #include "Core/Interface/ISGMessageAttachment.h"
 
+/**
+ * Implements a chunk reader of a file that maps the requested chunks into memory.
+ *
+ * Files that can't be memory-mapped on the platform are read through an archive instead,
+ * one chunk at a time.
+ */
+class FSGFileMessageAttachmentChunkReader
+	: public ISGMessageAttachmentChunkReader
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param Filename The full name and path of the file.
+	 */
+	explicit FSGFileMessageAttachmentChunkReader( const FString& Filename )
+		: FileSize(-1)
+	{
+		MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Filename));
+
+		if (MappedFile.IsValid())
+		{
+			FileSize = MappedFile->GetFileSize();
+		}
+		else
+		{
+			Archive.Reset(IFileManager::Get().CreateFileReader(*Filename));
+			FileSize = Archive.IsValid() ? Archive->TotalSize() : -1;
+		}
+	}
+
+	/** Checks whether the file was opened. */
+	bool IsValid() const
+	{
+		return FileSize >= 0;
+	}
+
+public:
+
+	// ISGMessageAttachmentChunkReader interface
+
+	virtual int64 GetSize() const override
+	{
+		return FileSize;
+	}
+
+	virtual bool ReadChunk(int64 Offset, int32 Size, TArrayView<const uint8>& OutChunk) override
+	{
+		if ((Offset < 0) || (Offset > FileSize) || (Size < 0))
+		{
+			return false;
+		}
+
+		const int32 ChunkSize = (int32)FMath::Min<int64>(Size, FileSize - Offset);
+
+		if (ChunkSize == 0)
+		{
+			OutChunk = TArrayView<const uint8>();
+
+			return true;
+		}
+
+		if (MappedFile.IsValid())
+		{
+			// only one region is mapped at a time, so that the address space in use stays small
+			MappedRegion.Reset();
+			MappedRegion.Reset(MappedFile->MapRegion(Offset, ChunkSize));
+
+			if (!MappedRegion.IsValid())
+			{
+				return false;
+			}
+
+			OutChunk = MakeArrayView(MappedRegion->GetMappedPtr(), ChunkSize);
+
+			return true;
+		}
+
+		ChunkBuffer.SetNumUninitialized(ChunkSize, false);
+		Archive->Seek(Offset);
+		Archive->Serialize(ChunkBuffer.GetData(), ChunkSize);
+
+		if (Archive->IsError())
+		{
+			return false;
+		}
+
+		OutChunk = ChunkBuffer;
+
+		return true;
+	}
+
+private:
+
+	/** Holds the size of the file (-1 if it can't be read). */
+	int64 FileSize;
+
+	/** Holds the memory-mapped file, if the platform supports mapping. */
+	TUniquePtr<IMappedFileHandle> MappedFile;
+
+	/** Holds the mapped region of the current chunk. */
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** Holds the file reader if the file isn't memory-mapped. */
+	TUniquePtr<FArchive> Archive;
+
+	/** Holds the current chunk if the file isn't memory-mapped. */
+	TArray<uint8> ChunkBuffer;
+};
+
+
 /**
  * Implements a message attachment whose data is held in a file.
  *
+ * Large files can be read in chunks that are memory-mapped on demand, see CreateChunkReader.
+ *
  * WARNING: Message attachments do not work yet for out of process messages.
  */
 class FSGFileMessageAttachment
@@ -55,6 +171,23 @@ public:
 		return IFileManager::Get().CreateFileReader(*Filename);
 	}
 
+	virtual TUniquePtr<ISGMessageAttachmentChunkReader> CreateChunkReader() override
+	{
+		TUniquePtr<FSGFileMessageAttachmentChunkReader> ChunkReader = MakeUnique<FSGFileMessageAttachmentChunkReader>(Filename);
+
+		if (!ChunkReader->IsValid())
+		{
+			return nullptr;
+		}
+
+		return MoveTemp(ChunkReader);
+	}
+
+	virtual int64 GetSize() override
+	{
+		return IFileManager::Get().FileSize(*Filename);
+	}
+
 private:
 
 	/** Holds a flag indicating whether the file should be deleted. */
@@ -0,0 +1,217 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Core/Bus/SGMessageRequest.h"
+#include <atomic>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+	#include <coroutine>
+	#define SGMESSAGING_WITH_COROUTINES 1
+#else
+	#define SGMESSAGING_WITH_COROUTINES 0
+#endif
+
+#if SGMESSAGING_WITH_COROUTINES
+
+#include <type_traits>
+
+
+/**
+ * Implements the return type of fire-and-forget messaging coroutines.
+ *
+ * A coroutine that returns this type runs right away until its first co_await and continues on its
+ * own afterwards, e.g.:
+ *
+ *		FSGMessageTask FMyClass::RunHandshake()
+ *		{
+ *			const FSGMessageReply Reply = co_await Endpoint->RequestAsync(TopicID, MessageID, Recipient, FTimespan::FromSeconds(1.0));
+ *
+ *			co_await Endpoint->Delay(FTimespan::FromSeconds(0.5));
+ *		}
+ *
+ * The coroutine's frame is freed when it returns. Whatever it accesses after a co_await must outlive it.
+ */
+struct FSGMessageTask
+{
+	struct promise_type
+	{
+		FSGMessageTask get_return_object() noexcept
+		{
+			return FSGMessageTask();
+		}
+
+		std::suspend_never initial_suspend() noexcept
+		{
+			return { };
+		}
+
+		std::suspend_never final_suspend() noexcept
+		{
+			return { };
+		}
+
+		void return_void() noexcept { }
+
+		void unhandled_exception() noexcept
+		{
+			checkf(false, TEXT("Unhandled exception in a messaging coroutine"));
+		}
+	};
+};
+
+
+/**
+ * Implements the state that a message endpoint shares with a coroutine awaiting it.
+ *
+ * Whichever of the completion and the coroutine's suspension comes second resumes the coroutine, so
+ * that completions that arrive before the coroutine suspends don't get lost.
+ */
+class FSGMessageAwaitState
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InRecipientThread The thread on which to resume the coroutine.
+	 * @param InWakeId The identifier of the wake-up message that completes a delay (0 = none).
+	 */
+	explicit FSGMessageAwaitState(ENamedThreads::Type InRecipientThread, uint64 InWakeId = 0)
+		: RecipientThread(InRecipientThread)
+		, WakeId(InWakeId)
+		, bSignaled(false)
+	{ }
+
+public:
+
+	/**
+	 * Completes the await, resuming the coroutine if it is suspended.
+	 *
+	 * @param InReply The outcome of the await.
+	 * @param bOnRecipientThread Whether the caller runs on the recipient thread, in which case the coroutine is resumed right away.
+	 */
+	void Complete(FSGMessageReply&& InReply, bool bOnRecipientThread)
+	{
+		Reply = MoveTemp(InReply);
+
+		if (!bSignaled.exchange(true, std::memory_order_acq_rel))
+		{
+			return;
+		}
+
+		const std::coroutine_handle<> ResumeHandle = Handle;
+
+		if (bOnRecipientThread)
+		{
+			ResumeHandle.resume();
+		}
+		else
+		{
+			FFunctionGraphTask::CreateAndDispatchWhenReady([ResumeHandle]() { ResumeHandle.resume(); }, TStatId(), nullptr, RecipientThread);
+		}
+	}
+
+	/**
+	 * Suspends the awaiting coroutine, unless the await was already completed.
+	 *
+	 * @param InHandle The awaiting coroutine.
+	 * @return true if the coroutine stays suspended, false if it continues right away.
+	 */
+	bool Suspend(std::coroutine_handle<> InHandle)
+	{
+		Handle = InHandle;
+
+		return !bSignaled.exchange(true, std::memory_order_acq_rel);
+	}
+
+	/** Gets the outcome of the await. */
+	FSGMessageReply& GetReply()
+	{
+		return Reply;
+	}
+
+	/** Gets the identifier of the wake-up message that completes a delay (0 = none). */
+	uint64 GetWakeId() const
+	{
+		return WakeId;
+	}
+
+private:
+
+	/** Holds the outcome of the await. */
+	FSGMessageReply Reply;
+
+	/** Holds the awaiting coroutine (only valid once it suspended). */
+	std::coroutine_handle<> Handle;
+
+	/** Holds the thread on which to resume the coroutine. */
+	const ENamedThreads::Type RecipientThread;
+
+	/** Holds the identifier of the wake-up message that completes a delay. */
+	const uint64 WakeId;
+
+	/** Holds a flag indicating whether the first of the completion and the suspension happened. */
+	std::atomic<bool> bSignaled;
+};
+
+
+/**
+ * Template for the awaitables of message endpoints.
+ *
+ * @param ResultType The result of the co_await expression (FSGMessageReply, a message context or void).
+ * @see FSGMessageEndpoint::RequestAsync, FSGMessageEndpoint::NextMessage, FSGMessageEndpoint::Delay
+ */
+template<typename ResultType>
+class TSGMessageAwaitable
+{
+public:
+
+	/** Creates and initializes a new instance. */
+	explicit TSGMessageAwaitable(const TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe>& InState)
+		: State(InState)
+	{ }
+
+public:
+
+	bool await_ready() const noexcept
+	{
+		return false;
+	}
+
+	bool await_suspend(std::coroutine_handle<> Handle)
+	{
+		return State->Suspend(Handle);
+	}
+
+	ResultType await_resume()
+	{
+		if constexpr (std::is_same_v<ResultType, FSGMessageReply>)
+		{
+			return MoveTemp(State->GetReply());
+		}
+		else if constexpr (!std::is_void_v<ResultType>)
+		{
+			return State->GetReply().Context;
+		}
+	}
+
+private:
+
+	/** Holds the state shared with the endpoint. */
+	TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe> State;
+};
+
+
+namespace SGMessageAwaitable
+{
+	/** Type name of the messages that an endpoint sends itself to wake up delayed coroutines. */
+	static const FName WakeMessageType(TEXT("SGMessageAwaitWake"));
+
+	/** Name of the message annotation that holds the identifier of a wake-up message. */
+	static const FName WakeIdAnnotation(TEXT("SGAwaitWakeId"));
+}
+
+#endif
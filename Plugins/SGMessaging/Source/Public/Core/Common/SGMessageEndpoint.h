@@ -13,16 +13,34 @@
 #include "Core/Interface/ISGMessageHandler.h"
 #include "Core/Interface/ISGMessageReceiver.h"
 #include "Core/Interface/ISGMessageSender.h"
+#include "Core/Interface/ISGMessageSubscription.h"
 #include "Core/Interface/ISGMessageBusListener.h"
+#include "SGMessageAwaitable.h"
 #include "SGMessageHandlers.h"
 #include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageBatch.h"
 #include "Core/Message/SGMessageBuilder.h"
 #include "Core/Message/SGMessageParameter.h"
+#include "Core/Message/SGMessageProjection.h"
 #include "Core/Message/SGMessageTagBuilder.h"
+#include "Core/Message/SGMessageTypeRegistry.h"
+#include "Core/Message/SGTypedMessage.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "Core/Bus/SGMessageClock.h"
+#include "Core/Bus/SGMessageConflation.h"
+#include "Core/Bus/SGMessageContentFilter.h"
+#include "Core/Bus/SGMessageHandlerProfiler.h"
+#include "Core/Bus/SGMessageLatencyProbe.h"
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessageRequest.h"
+#include "Core/Bus/SGMessageSpatialIndex.h"
+#include "Core/Bus/SGMessageStatistics.h"
+#include "HAL/PlatformProcess.h"
 #include "Misc/Guid.h"
 #include "Templates/SharedPointer.h"
 #include "UObject/NameTypes.h"
 #include "Misc/ScopeLock.h"
+#include <atomic>
 
 
 /**
@@ -34,21 +52,12 @@
 DECLARE_DELEGATE_TwoParams(FOnMessageEndpointError, const ISGMessageContext&, const FString&);
 
 
-/**
- * Struct to propagate message bus notifications
- */
-struct FSGMessageBusNotification
-{
-	/** Notification type. */
-	ESGMessageBusNotification NotificationType;
-
-	/** Address of the un/registered. */
-	FSGMessageAddress RegistrationAddress;
-};
-
 /** Delegate type for SGMessageBus notifications. */
 DECLARE_DELEGATE_OneParam(FOnBusNotification, const FSGMessageBusNotification&);
 
+/** Delegate type for backpressure notifications from the bus and the endpoint's inbox. */
+DECLARE_DELEGATE_OneParam(FOnSGMessageBackpressure, const FSGMessageBackpressureEvent&);
+
 /**
  * Implements a message endpoint for sending and receiving messages on a message bus.
  *
@@ -93,14 +102,45 @@ public:
 	 * @param InHandlers The collection of message handlers to register.
 	 */
 	FSGMessageEndpoint(const FName& InName, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus, const FOnBusNotification InNotificationDelegate)
-		: Address(FSGMessageAddress::NewAddress())
+		: FSGMessageEndpoint(InName, InBus, InNotificationDelegate, FSGMessageAddress::NewAddress(), false)
+	{ }
+
+	/**
+	 * Creates and initializes a new instance with the given address.
+	 *
+	 * @param InName The endpoint's name (for debugging purposes).
+	 * @param InBus The message bus to attach this endpoint to.
+	 * @param InNotificationDelegate The delegate to invoke on bus notifications.
+	 * @param InAddress The endpoint's address.
+	 * @param bInDurable Whether the router queues messages for the endpoint while it isn't registered (see ISGMessageReceiver::IsDurable).
+	 */
+	FSGMessageEndpoint(const FName& InName, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus, const FOnBusNotification InNotificationDelegate, const FSGMessageAddress& InAddress, bool bInDurable)
+		: Address(InAddress)
 		, BusPtr(InBus)
 		, Enabled(true)
+		, Active(false)
 		, NotificationDelegate(InNotificationDelegate)
 		, Id(FGuid::NewGuid())
+		, bDurable(bInDurable)
 		, InboxEnabled(false)
+		, InboxCapacity(0)
+		, InboxPolicy(ESGMessageBackpressurePolicy::DropNewest)
+		, NumInboxMessages(0)
+		, NumDroppedInboxMessages(0)
+		, NumConflatedInboxMessages(0)
+		, bInboxCongested(false)
 		, Name(InName)
+		, Handlers(new FHandlerTable())
+		, HandlerEpoch(0)
 	{
+		NumHandlerReaders[0] = 0;
+		NumHandlerReaders[1] = 0;
+
+		if (GetDefault<USGMessagingSettings>()->bEnableLatencyProbes)
+		{
+			LatencyProbe = MakeUnique<FSGMessageLatencyProbe>();
+		}
+
 		SetRecipientThread(FTaskGraphInterface::Get().GetCurrentThreadIfKnown());
 	}
 
@@ -109,10 +149,33 @@ public:
 	{	
 		auto Bus = BusPtr.Pin();
 
-		if (Bus.IsValid())
+		if (Bus.IsValid() && bRegistered)
 		{
 			Bus->Unregister(Address);
 		}
+
+		for (const FHandlerTable* RetiredTable : RetiredHandlers)
+		{
+			delete RetiredTable;
+		}
+
+		// the queued messages are released with the inbox
+		FSGMessageInboxStatistics::AddQueuedMessages(-NumInboxMessages.load(std::memory_order_relaxed));
+
+		for (const FHandlerTable* GraceTable : GraceHandlers)
+		{
+			delete GraceTable;
+		}
+
+		delete Handlers.load();
+
+#if SGMESSAGING_WITH_COROUTINES
+		// coroutines that still wait resume with a cancelled outcome
+		for (const auto& Awaiter : Awaiters)
+		{
+			Awaiter.Value->Complete(FSGMessageReply(ESGMessageRequestResult::Cancelled), false);
+		}
+#endif
 	}
 
 public:
@@ -123,11 +186,18 @@ public:
 	 * A disabled endpoint will not receive any subscribed messages until it is enabled again.
 	 * Endpoints should be created in an enabled state by default.
 	 *
+	 * The endpoint's subscriptions are removed from the router, so that dormant endpoints don't
+	 * cost anything per published message, and are restored when it is enabled. The endpoint stays
+	 * registered, so that the router keeps its delayed messages, retained messages and rate limits,
+	 * and doesn't treat messages sent to it as undeliverable.
+	 *
 	 * @see Enable, IsEnabled
 	 */
 	void Disable()
 	{
 		Enabled = false;
+
+		Suspend();
 	}
 
 	/**
@@ -141,6 +211,58 @@ public:
 	void Enable()
 	{
 		Enabled = true;
+
+		Activate();
+	}
+
+	/**
+	 * Registers this endpoint and its subscriptions with the bus, unless it already is.
+	 *
+	 * Endpoints are activated when they are built, unless they are built to activate on first use,
+	 * in which case this is called when they are enabled or send their first message.
+	 *
+	 * @see IsActive, FSGMessageEndpointBuilder::ThatActivatesOnFirstUse
+	 */
+	void Activate()
+	{
+		if (Active.load(std::memory_order_acquire) || !Enabled)
+		{
+			return;
+		}
+
+		FScopeLock Lock(&SubscriptionsCS);
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Active.load(std::memory_order_relaxed) || !Bus.IsValid())
+		{
+			return;
+		}
+
+		// suspended endpoints are still registered
+		if (!bRegistered)
+		{
+			Bus->Register(Address, AsShared());
+			bRegistered = true;
+		}
+
+		for (const auto& Subscription : Subscriptions)
+		{
+			AddBusSubscription(*Bus, Subscription.Key, Subscription.Value);
+		}
+
+		Active.store(true, std::memory_order_release);
+	}
+
+	/**
+	 * Checks whether this endpoint's subscriptions are on the bus.
+	 *
+	 * @return true if the endpoint is active, false if it is dormant or disabled.
+	 * @see Activate
+	 */
+	bool IsActive() const
+	{
+		return Active.load(std::memory_order_acquire);
 	}
 
 	/**
@@ -199,11 +321,12 @@ public:
 	/**
 	 * Defers processing of the given message by the specified time delay.
 	 *
-	 * The message is effectively delivered again to this endpoint after the
-	 * original sent time plus the time delay have elapsed.
+	 * The same message context is delivered again to this endpoint after the
+	 * time delay has elapsed, without being intercepted or routed again.
 	 *
 	 * @param Context The context of the message to defer.
 	 * @param Delay The time delay.
+	 * @see ISGMessageBus::Redeliver
 	 */
 	void Defer(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FTimespan& Delay)
 	{
@@ -211,7 +334,22 @@ public:
 
 		if (Bus.IsValid())
 		{
-			Bus->Forward(Context, TArrayBuilder<FSGMessageAddress>().Add(Address), Delay, AsShared());
+			Bus->Redeliver(Context, Address, Delay);
+		}
+	}
+
+	/**
+	 * Cancels a delayed message that was published or sent by this endpoint.
+	 *
+	 * @param Handle The handle returned when the message was published or sent.
+	 */
+	void CancelDelayedMessage(const FSGDelayedMessageHandle& Handle)
+	{
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			Bus->CancelDelayedMessage(Handle);
 		}
 	}
 
@@ -224,7 +362,7 @@ public:
 	 * @param Recipients The list of message recipients to forward the message to.
 	 * @param Delay The time delay.
 	 */
-	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay)
+	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay)
 	{
 		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
 
@@ -244,9 +382,9 @@ public:
 	 * @param Delay The delay after which to publish the message.
 	 * @param Expiration The time at which the message expires.
 	 */
-	void Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
 	{
-		Publish(Message, TypeInfo, Scope, TMap<FName, FString>(), Delay, Expiration);
+		return Publish(Message, TypeInfo, Scope, FSGMessageAnnotations::GetEmpty(), Delay, Expiration);
 	}
 
 	/**
@@ -260,14 +398,16 @@ public:
 	 * @param Delay The delay after which to publish the message.
 	 * @param Expiration The time at which the message expires.
 	 */
-	void Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const TMap<FName, FString> Annotations, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration)
 	{
 		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
 
 		if (Bus.IsValid())
 		{
-			Bus->Publish(Message, TypeInfo, Scope, Annotations, Delay, Expiration, AsShared());
+			return Bus->Publish(Message, TypeInfo, Scope, Annotations, Delay, Expiration, AsShared());
 		}
+
+		return FSGDelayedMessageHandle();
 	}
 
 	/**
@@ -281,9 +421,9 @@ public:
 	 * @param Expiration The time at which the message expires.
 	 */
 	UE_DEPRECATED(4.21, "FSGMessageEndpoint::Send with 6 params is deprecated. Please use FMessageEndpoint::Send that takes additionnal ESGMessageFlags instead!")
-	void Send(void* Message, UScriptStruct* TypeInfo, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Send(void* Message, UScriptStruct* TypeInfo, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
 	{
-		Send(Message, TypeInfo, ESGMessageFlags::None, Attachment, Recipients, Delay, Expiration);
+		return Send(Message, TypeInfo, ESGMessageFlags::None, Attachment, Recipients, Delay, Expiration);
 	}
 
 	/**
@@ -298,14 +438,16 @@ public:
 	 * @param Delay The delay after which to send the message.
 	 * @param Expiration The time at which the message expires.
 	 */
-	void Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
 	{
 		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
 
 		if (Bus.IsValid())
 		{
-			Bus->Send(Message, TypeInfo, Flags, TMap<FName, FString>(), Attachment, Recipients, Delay, Expiration, AsShared());
+			return Bus->Send(Message, TypeInfo, Flags, FSGMessageAnnotations::GetEmpty(), Attachment, Recipients, Delay, Expiration, AsShared());
 		}
+
+		return FSGDelayedMessageHandle();
 	}
 
 	/**
@@ -320,853 +462,2417 @@ public:
 	 * @param Delay The delay after which to send the message.
 	 * @param Expiration The time at which the message expires.
 	 */
-	void Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const TMap<FName, FString> Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
 	{
 		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
 
 		if (Bus.IsValid())
 		{
-			Bus->Send(Message, TypeInfo, Flags, Annotations, Attachment, Recipients, Delay, Expiration, AsShared());
+			return Bus->Send(Message, TypeInfo, Flags, Annotations, Attachment, Recipients, Delay, Expiration, AsShared());
 		}
+
+		return FSGDelayedMessageHandle();
 	}
 
 	/**
-	 * Subscribes a message handler.
+	 * Sends a request to the specified recipient and returns a future for its reply.
 	 *
-	 * @param MessageType The type name of the messages to subscribe to.
-	 * @param ScopeRange The range of message scopes to include in the subscription.
+	 * The recipient answers with Reply(). The reply completes the future on the router thread instead
+	 * of being dispatched to this endpoint's handlers, so no subscription is needed for it.
+	 *
+	 * @param Message The message to send.
+	 * @param TypeInfo The message's type information.
+	 * @param Flags The message flags.
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipient The message recipient.
+	 * @param Timeout The time after which the request times out (zero = never).
+	 * @return Future for the reply.
+	 * @see Reply
 	 */
-	void Subscribe(const FName& MessageType, const FSGMessageScopeRange& ScopeRange)
+	TFuture<FSGMessageReply> Request(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FTimespan& Timeout)
 	{
 		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
 
 		if (Bus.IsValid())
 		{
-			Bus->Subscribe(AsShared(), MessageType, ScopeRange);
+			return Bus->Request(Message, TypeInfo, Flags, Annotations, Attachment, Recipient, Timeout, AsShared());
 		}
+
+		TPromise<FSGMessageReply> CancelledPromise;
+		CancelledPromise.SetValue(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+
+		return CancelledPromise.GetFuture();
 	}
 
 	/**
-	 * Unsubscribes this endpoint from the specified message type.
+	 * Subscribes a message handler.
 	 *
-	 * @param MessageType The type of message to unsubscribe (NAME_All = all types).
-	 * @see Subscribe
+	 * @param MessageType The type name of the messages to subscribe to.
+	 * @param ScopeRange The range of message scopes to include in the subscription.
 	 */
-	void Unsubscribe(const FName& TopicPattern)
+	void Subscribe(const FName& MessageType, const FSGMessageScopeRange& ScopeRange)
 	{
-		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = GetBusIfEnabled();
+		FScopeLock Lock(&SubscriptionsCS);
 
-		if (Bus.IsValid())
+		// dormant endpoints subscribe when they are activated
+		if (auto ExistingSubscription = Subscriptions.FindByPredicate([&MessageType](const TPair<FName, FSGMessageScopeRange>& Subscription) { return Subscription.Key == MessageType; }))
 		{
-			Bus->Unsubscribe(AsShared(), TopicPattern);
+			ExistingSubscription->Value = ScopeRange;
+		}
+		else
+		{
+			Subscriptions.Emplace(MessageType, ScopeRange);
 		}
-	}
 
-public:
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Active.load(std::memory_order_relaxed) && Bus.IsValid())
+		{
+			AddBusSubscription(*Bus, MessageType, ScopeRange);
+		}
+	}
 
 	/**
-	 * Disables the inbox for unhandled messages.
+	 * Subscribes to several message types at once.
 	 *
-	 * The inbox is disabled by default.
+	 * The bus hands all subscriptions of a router shard over with a single command, which makes
+	 * this much cheaper than a Subscribe call per type for endpoints that come and go often.
 	 *
-	 * @see EnableInbox, IsInboxEmpty, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
+	 * @param MessageTypes The type names of the messages to subscribe to.
+	 * @param ScopeRange The range of message scopes to include in the subscriptions.
+	 * @see Subscribe, UnsubscribeMany
 	 */
-	void DisableInbox()
+	void SubscribeMany(TArrayView<const FName> MessageTypes, const FSGMessageScopeRange& ScopeRange)
 	{
-		InboxEnabled = false;
+		FScopeLock Lock(&SubscriptionsCS);
+
+		for (const FName& MessageType : MessageTypes)
+		{
+			if (auto ExistingSubscription = Subscriptions.FindByPredicate([&MessageType](const TPair<FName, FSGMessageScopeRange>& Subscription) { return Subscription.Key == MessageType; }))
+			{
+				ExistingSubscription->Value = ScopeRange;
+			}
+			else
+			{
+				Subscriptions.Emplace(MessageType, ScopeRange);
+			}
+		}
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Active.load(std::memory_order_relaxed) && Bus.IsValid())
+		{
+			Bus->SubscribeMany(AsShared(), MessageTypes, ScopeRange);
+		}
 	}
 
 	/**
-	 * Enables the inbox for unhandled messages.
-	 *
-	 * If enabled, the inbox will queue up all received messages. Use ProcessInbox() to synchronously
-	 * invoke the registered message handlers for all queued up messages, or ReceiveFromInbox() to
-	 * manually receive one message from the inbox at a time. The inbox is disabled by default.
+	 * Unsubscribes this endpoint from several message types at once.
 	 *
-	 * @see DisableInbox, IsInboxEmpty, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
+	 * @param MessageTypes The types of messages to unsubscribe from.
+	 * @see SubscribeMany, Unsubscribe
 	 */
-	void EnableInbox()
+	void UnsubscribeMany(TArrayView<const FName> MessageTypes)
 	{
-		InboxEnabled = true;
+		FScopeLock Lock(&SubscriptionsCS);
+
+		Subscriptions.RemoveAll([&MessageTypes](const TPair<FName, FSGMessageScopeRange>& Subscription)
+		{
+			return MessageTypes.Contains(Subscription.Key);
+		});
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Active.load(std::memory_order_relaxed) && Bus.IsValid())
+		{
+			Bus->UnsubscribeMany(AsShared(), MessageTypes);
+		}
 	}
 
 	/**
-	 * Checks whether the inbox is empty.
+	 * Unsubscribes this endpoint from the specified message type.
 	 *
-	 * @return true if the inbox is empty, false otherwise.
-	 * @see DisableInbox, EnableInbox, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
+	 * @param MessageType The type of message to unsubscribe (NAME_All = all types).
+	 * @see Subscribe
 	 */
-	bool IsInboxEmpty() const
+	void Unsubscribe(const FName& TopicPattern)
 	{
-		return Inbox.IsEmpty();
+		FScopeLock Lock(&SubscriptionsCS);
+
+		Subscriptions.RemoveAll([&TopicPattern](const TPair<FName, FSGMessageScopeRange>& Subscription)
+		{
+			return (TopicPattern == NAME_All) || (Subscription.Key == TopicPattern);
+		});
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Active.load(std::memory_order_relaxed) && Bus.IsValid())
+		{
+			Bus->Unsubscribe(AsShared(), TopicPattern);
+		}
 	}
 
 	/**
-	 * Checks whether the inbox is enabled.
+	 * Makes this endpoint a member of a consumer group for the specified message type.
 	 *
-	 * @see DisableInbox, EnableInbox, IsInboxEmpty, ProcessInbox, ReceiveFromInbox
+	 * Each published message of the type then goes to only one member of the group instead of to all
+	 * subscribers, so that endpoints on worker threads can share work. Handlers are subscribed as usual,
+	 * before or after joining. SubscribeMany doesn't join groups.
+	 *
+	 * @param MessageType The type of messages.
+	 * @param GroupName The name of the consumer group.
+	 * @param Policy The way the group picks the member that receives a message (the first member's policy wins).
+	 * @see LeaveConsumerGroup, ISGMessageBus::SubscribeToGroup
 	 */
-	bool IsInboxEnabled() const
+	void JoinConsumerGroup(const FName& MessageType, const FName& GroupName, ESGMessageConsumerPolicy Policy = ESGMessageConsumerPolicy::RoundRobin)
 	{
-		return InboxEnabled;
+		FScopeLock Lock(&SubscriptionsCS);
+
+		ConsumerGroups.Add(MessageType, TPair<FName, ESGMessageConsumerPolicy>(GroupName, Policy));
+		ReplaceBusSubscription(MessageType);
+	}
+
+	void JoinConsumerGroup(MESSAGE_TAG_PARAM_SIGNATURE, const FName& GroupName, ESGMessageConsumerPolicy Policy = ESGMessageConsumerPolicy::RoundRobin)
+	{
+		JoinConsumerGroup(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), GroupName, Policy);
 	}
 
 	/**
-	 * Calls the matching message handlers for all messages queued up in the inbox.
-	 *
-	 * Note that an incoming message will only be queued up in the endpoint's inbox if the inbox has
-	 * been enabled and no matching message handler handled it. The inbox is disabled by default and
-	 * must be enabled using the EnableInbox() method.
+	 * Removes this endpoint from the consumer group of the specified message type, so that it receives every message again.
 	 *
-	 * @see IsInboxEmpty, ReceiveFromInbox
+	 * @param MessageType The type of messages.
+	 * @see JoinConsumerGroup
 	 */
-	void ProcessInbox()
+	void LeaveConsumerGroup(const FName& MessageType)
 	{
-		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+		FScopeLock Lock(&SubscriptionsCS);
 
-		while (Inbox.Dequeue(Context))
+		if (ConsumerGroups.Remove(MessageType) > 0)
 		{
-			ProcessMessage(Context.ToSharedRef());
+			ReplaceBusSubscription(MessageType);
 		}
 	}
 
+	void LeaveConsumerGroup(MESSAGE_TAG_PARAM_SIGNATURE)
+	{
+		LeaveConsumerGroup(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE));
+	}
+
 	/**
-	 * Receives a single message from the endpoint's inbox.
+	 * Filters the published messages of the specified type by their content.
 	 *
-	 * Note that an incoming message will only be queued up in the endpoint's inbox if the inbox has
-	 * been enabled and no matching message handler handled it. The inbox is disabled by default and
-	 * must be enabled using the EnableInbox() method.
+	 * The router skips messages that don't match the filter, so they never reach the endpoint's thread
+	 * or handlers. Handlers are subscribed as usual, before or after setting the filter.
 	 *
-	 * @param OutContext Will hold the context of the received message.
-	 * @return true if a message was received, false if the inbox was empty.
-	 * @see DisableInbox, EnableInbox, IsInboxEnabled, ProcessInbox
+	 * @param MessageType The type of messages.
+	 * @param Filter The filter that messages must match (replaces the previous filter).
+	 * @see ClearContentFilter, ISGMessageBus::SubscribeFiltered
 	 */
-	bool ReceiveFromInbox(TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& OutContext)
+	void SetContentFilter(const FName& MessageType, const FSGMessageContentFilter& Filter)
 	{
-		return Inbox.Dequeue(OutContext);
-	}
+		FScopeLock Lock(&SubscriptionsCS);
 
-public:
+		if (Filter.IsEmpty())
+		{
+			ClearContentFilter(MessageType);
 
-	//~ ISGMessageReceiver interface
+			return;
+		}
 
-	virtual FName GetDebugName() const override
-	{
-		return Name;
+		ContentFilters.Add(MessageType, MakeShared<const FSGMessageContentFilter, ESPMode::ThreadSafe>(Filter));
+		ReplaceBusSubscription(MessageType);
 	}
 
-	virtual const FGuid& GetRecipientId() const override
+	void SetContentFilter(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageContentFilter& Filter)
 	{
-		return Id;
+		SetContentFilter(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Filter);
 	}
 
-	virtual ENamedThreads::Type GetRecipientThread() const override
+	/**
+	 * Removes the content filter of the specified type, so that the endpoint receives all of its messages again.
+	 *
+	 * @param MessageType The type of messages.
+	 * @see SetContentFilter
+	 */
+	void ClearContentFilter(const FName& MessageType)
 	{
-		return RecipientThread;
+		FScopeLock Lock(&SubscriptionsCS);
+
+		if (ContentFilters.Remove(MessageType) > 0)
+		{
+			ReplaceBusSubscription(MessageType);
+		}
 	}
 
-	virtual bool IsLocal() const override
+	void ClearContentFilter(MESSAGE_TAG_PARAM_SIGNATURE)
 	{
-		return true;
+		ClearContentFilter(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE));
 	}
 
-	virtual void ReceiveMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
+	/**
+	 * Declares the parameters of the dynamic messages of the specified type that the endpoint's handlers read.
+	 *
+	 * Message bridges then only transport the projected parameters to this process, as long as every
+	 * subscriber of the type in this process declared a projection. Messages published in this process
+	 * still carry all of their parameters, so handlers must not rely on the others being absent.
+	 *
+	 * @param MessageType The type of messages.
+	 * @param Projection The parameters that the handlers read (replaces the previous projection).
+	 * @see ClearProjection, FSGMessageProjection
+	 */
+	void SetProjection(const FName& MessageType, const FSGMessageProjection& Projection)
 	{
-		if (!Enabled)
+		FScopeLock Lock(&SubscriptionsCS);
+
+		if (Projection.IsEmpty())
 		{
+			ClearProjection(MessageType);
+
 			return;
 		}
 
-		if (InboxEnabled)
-		{
-			Inbox.Enqueue(Context);
-		}
-		else
-		{
-			ProcessMessage(Context);
-		}
+		Projections.Add(MessageType, MakeShared<const FSGMessageProjection, ESPMode::ThreadSafe>(Projection));
+		ReplaceBusSubscription(MessageType);
 	}
 
-	//~ ISGBusListener interface
-
-	virtual ENamedThreads::Type GetListenerThread() const override
+	void SetProjection(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageProjection& Projection)
 	{
-		return RecipientThread;
+		SetProjection(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Projection);
 	}
 
-	virtual void NotifyRegistration(const FSGMessageAddress& InAddress, ESGMessageBusNotification InNotification)
+	/**
+	 * Removes the projection of the specified type, so that the endpoint receives all parameters again.
+	 *
+	 * @param MessageType The type of messages.
+	 * @see SetProjection
+	 */
+	void ClearProjection(const FName& MessageType)
 	{
-		if (!Enabled)
+		FScopeLock Lock(&SubscriptionsCS);
+
+		if (Projections.Remove(MessageType) > 0)
 		{
-			return;
+			ReplaceBusSubscription(MessageType);
 		}
-
-		NotificationDelegate.ExecuteIfBound(FSGMessageBusNotification{ InNotification, InAddress });
 	}
 
-public:
-
-	//~ ISGMessageSender interface
-
-	virtual FSGMessageAddress GetSenderAddress() override
+	void ClearProjection(MESSAGE_TAG_PARAM_SIGNATURE)
 	{
-		return Address;
+		ClearProjection(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE));
 	}
 
-	virtual void NotifyMessageError(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FString& Error) override
+	/**
+	 * Subscribes a handler for the published messages with the given tag near this endpoint.
+	 *
+	 * The handler only receives messages once the endpoint has a spatial interest in the tag, and then
+	 * only those whose origin is within the interest's radius (and those without an origin).
+	 *
+	 * @see SetSpatialInterest, ISGMessageBus::UpdateSpatialInterests
+	 */
+	void SubscribeSpatial(MESSAGE_TAG_PARAM_SIGNATURE, const TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
 	{
-		ErrorDelegate.ExecuteIfBound(Context.Get(), Error);
+		WithLambdaMessageHandler(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), HandlerFunc);
 	}
 
-public:
-
 	/**
-	 * Creates a message of the specified template type.
-	 *
-	 * Prefer using this helper rather than explicit new. See FEngineServicePong.
+	 * Creates a spatial interest of this endpoint, e.g. to update the interests of many endpoints with one call.
 	 *
-	 * @param Args The constructor arguments to the template type
+	 * @param MessageType The type of messages.
+	 * @param Location The location of the endpoint.
+	 * @param Radius The radius of the interest (negative = remove the interest).
+	 * @return The interest.
+	 * @see SetSpatialInterest
 	 */
-	template<typename T, typename... InArgTypes>
-	static T* MakeMessage(InArgTypes&&... Args)
+	FSGMessageSpatialInterest MakeSpatialInterest(const FName& MessageType, const FVector& Location, float Radius)
 	{
-		void* Buffer = FMemory::Malloc(sizeof(T));
-
-		T* Message = new (Buffer) T(::Forward<InArgTypes>(Args)...);
+		FSGMessageSpatialInterest Interest;
+		{
+			Interest.Subscriber = AsShared();
+			Interest.MessageType = MessageType;
+			Interest.Location = Location;
+			Interest.Radius = Radius;
+		}
 
-		return Message;
+		return Interest;
 	}
 
 	/**
-	 * Immediately forwards a previously received message to the specified recipient.
+	 * Adds or moves the spatial interest of this endpoint in the published messages of the specified type.
 	 *
-	 * Messages can only be forwarded to endpoints within the same process.
+	 * Endpoints that move every frame should batch their updates, see USGMessageWorldSubsystem.
 	 *
-	 * @param Context The context of the message to forward.
-	 * @param Recipient The address of the recipient to forward the message to.
+	 * @param MessageType The type of messages.
+	 * @param Location The location of the endpoint.
+	 * @param Radius The radius of the interest.
+	 * @see ClearSpatialInterest, SubscribeSpatial
 	 */
-	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient)
+	void SetSpatialInterest(const FName& MessageType, const FVector& Location, float Radius)
 	{
-		Forward(Context, TArrayBuilder<FSGMessageAddress>().Add(Recipient), FTimespan::Zero());
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			const FSGMessageSpatialInterest Interest = MakeSpatialInterest(MessageType, Location, FMath::Max(Radius, 0.0f));
+			Bus->UpdateSpatialInterests(MakeArrayView(&Interest, 1));
+		}
 	}
 
 	/**
-	 * Forwards a previously received message to the specified recipient after a given delay.
-	 *
-	 * Messages can only be forwarded to endpoints within the same process.
+	 * Removes the spatial interest of this endpoint in the published messages of the specified type.
 	 *
-	 * @param Context The context of the message to forward.
-	 * @param Recipient The address of the recipient to forward the message to.
-	 * @param ForwardingScope The scope of the forwarded message.
-	 * @param Delay The delay after which to publish the message.
+	 * @param MessageType The type of messages.
+	 * @see SetSpatialInterest
 	 */
-	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, const FTimespan& Delay)
+	void ClearSpatialInterest(const FName& MessageType)
 	{
-		Forward(Context, TArrayBuilder<FSGMessageAddress>().Add(Recipient), Delay);
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			const FSGMessageSpatialInterest Interest = MakeSpatialInterest(MessageType, FVector::ZeroVector, -1.0f);
+			Bus->UpdateSpatialInterests(MakeArrayView(&Interest, 1));
+		}
 	}
 
+public:
+
 	/**
-	 * Immediately forwards a previously received message to the specified list of recipients.
+	 * Disables the inbox for unhandled messages.
 	 *
-	 * Messages can only be forwarded to endpoints within the same process.
+	 * The inbox is disabled by default.
 	 *
-	 * @param Context The context of the message to forward.
-	 * @param Recipients The list of message recipients to forward the message to.
-	 * @param ForwardingScope The scope of the forwarded message.
+	 * @see EnableInbox, IsInboxEmpty, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
 	 */
-	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FSGMessageAddress>& Recipients)
+	void DisableInbox()
 	{
-		Forward(Context, Recipients, FTimespan::Zero());
+		InboxEnabled = false;
 	}
 
 	/**
-	 * Immediately publishes a message to all subscribed recipients.
+	 * Enables the inbox for unhandled messages.
 	 *
-	 * @param Message The message to publish.
-	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message)
-	{
-		Publish(Message, MessageType::StaticStruct(), ESGMessageScope::Network, FTimespan::Zero(), FDateTime::MaxValue());
-	}
-
-	/**
-	 * Immediately pa message to all subscribed recipients within the specified scope.
+	 * If enabled, the inbox will queue up all received messages. Use ProcessInbox() to synchronously
+	 * invoke the registered message handlers for all queued up messages, or ReceiveFromInbox() to
+	 * manually receive one message from the inbox at a time. The inbox is disabled by default.
 	 *
-	 * @param Message The message to publish.
-	 * @param Scope The message scope.
+	 * @see DisableInbox, IsInboxEmpty, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
 	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, ESGMessageScope Scope)
+	void EnableInbox()
 	{
-		Publish(Message, MessageType::StaticStruct(), Scope, FTimespan::Zero(), FDateTime::MaxValue());
+		InboxEnabled = true;
 	}
 
 	/**
-	 * Immediately publishes a message to all subscribed recipients.
+	 * Checks whether the inbox is empty.
 	 *
-	 * @param Message The message to publish.
-	 * @param Annotations An optional message annotations header.
+	 * @return true if the inbox is empty, false otherwise.
+	 * @see DisableInbox, EnableInbox, IsInboxEnabled, ProcessInbox, ReceiveFromInbox
 	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, const TMap<FName, FString> Annotations)
+	bool IsInboxEmpty() const
 	{
-		Publish(Message, MessageType::StaticStruct(), Annotations, ESGMessageScope::Network, FTimespan::Zero(), FDateTime::MaxValue());
+		return Inbox.IsEmpty();
 	}
 
 	/**
-	 * Immediately pa message to all subscribed recipients within the specified scope.
+	 * Checks whether the inbox is enabled.
 	 *
-	 * @param Message The message to publish.
-	 * @param Annotations An optional message annotations header.
-	 * @param Scope The message scope.
+	 * @see DisableInbox, EnableInbox, IsInboxEmpty, ProcessInbox, ReceiveFromInbox
 	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, const TMap<FName, FString> Annotations, ESGMessageScope Scope)
+	bool IsInboxEnabled() const
 	{
-		Publish(Message, MessageType::StaticStruct(), Annotations, Scope, FTimespan::Zero(), FDateTime::MaxValue());
+		return InboxEnabled;
 	}
 
 	/**
-	 * Publishes a message to all subscribed recipients after a given delay.
+	 * Calls the matching message handlers for all messages queued up in the inbox.
 	 *
-	 * @param Message The message to publish.
-	 * @param Delay The delay after which to publish the message.
-	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, const FTimespan& Delay)
-	{
-		Publish(Message, MessageType::StaticStruct(), ESGMessageScope::Network, Delay, FDateTime::MaxValue());
-	}
-
-	/**
-	 * Publishes a message to all subscribed recipients within the specified scope after a given delay.
+	 * Note that an incoming message will only be queued up in the endpoint's inbox if the inbox has
+	 * been enabled and no matching message handler handled it. The inbox is disabled by default and
+	 * must be enabled using the EnableInbox() method.
 	 *
-	 * @param Message The message to publish.
-	 * @param Scope The message scope.
-	 * @param Delay The delay after which to publish the message.
+	 * @see IsInboxEmpty, ReceiveFromInbox
 	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, ESGMessageScope Scope, const FTimespan& Delay)
+	void ProcessInbox()
 	{
-		Publish(Message, MessageType::StaticStruct(), Scope, Delay, FDateTime::MaxValue());
-	}
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
 
-	/**
-	 * Publishes a message to all subscribed recipients within the specified scope.
-	 *
-	 * @param Message The message to publish.
-	 * @param Scope The message scope.
-	 * @param Fields The message content.
-	 * @param Delay The delay after which to publish the message.
-	 * @param Expiration The time at which the message expires.
-	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
-	{
-		Publish(Message, MessageType::StaticStruct(), Scope, Delay, Expiration);
+		while (DequeueInbox(Context))
+		{
+			ProcessMessage(Context.ToSharedRef());
+		}
+
+		FlushBatchHandlers();
 	}
 
 	/**
-	 * Publishes a message to all subscribed recipients within the specified scope.
+	 * Calls the matching message handlers for messages queued up in the inbox, within a budget.
 	 *
-	 * @param Message The message to publish.
-	 * @param Annotations An optional message annotations header.
-	 * @param Scope The message scope.
-	 * @param Fields The message content.
-	 * @param Delay The delay after which to publish the message.
-	 * @param Expiration The time at which the message expires.
+	 * Messages that don't fit into the budget stay in the inbox for the next call, so that a backlog
+	 * is worked off over several frames. At least one message is processed per call.
+	 *
+	 * @param MaxMessages The maximum number of messages to process (0 = unlimited).
+	 * @param MaxTime The maximum time to spend (in seconds, 0 = unlimited).
+	 * @return The number of processed messages.
+	 * @see GetNumInboxMessages, IsInboxEmpty, ReceiveFromInbox
 	 */
-	template<typename MessageType>
-	void Publish(MessageType* Message, const TMap<FName, FString> Annotations, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
+	int32 ProcessInbox(int32 MaxMessages, double MaxTime)
 	{
-		Publish(Message, MessageType::StaticStruct(), Annotations, Scope, Delay, Expiration);
-	}
+		const double EndTime = (MaxTime > 0.0) ? FPlatformTime::Seconds() + MaxTime : 0.0;
 
-	template <typename MessageType>
-	void Publish(const FName& MessageTag, MessageType* Message, CONST_PUBLISH_PARAMETER_SIGNATURE)
-	{
-		const auto Bus = GetBusIfEnabled();
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+		int32 NumProcessed = 0;
 
-		if (Bus.IsValid())
+		while (((MaxMessages <= 0) || (NumProcessed < MaxMessages)) && DequeueInbox(Context))
 		{
-			Bus->Publish(MessageTag, Message, PUBLISH_PARAMETER_FORWARD, AsShared());
-		}
-	}
+			ProcessMessage(Context.ToSharedRef());
+			++NumProcessed;
 
-	template <typename MessageType>
-	void PublishWithMessage(MESSAGE_TAG_PARAM_SIGNATURE, CONST_PUBLISH_PARAMETER_SIGNATURE, MessageType* Message)
-	{
-		Publish(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, MESSAGE_PARAMETER);
-	}
+			if ((EndTime > 0.0) && (FPlatformTime::Seconds() >= EndTime))
+			{
+				break;
+			}
+		}
 
-	template <typename ...Args>
-	void Publish(MESSAGE_TAG_PARAM_SIGNATURE, CONST_PUBLISH_PARAMETER_SIGNATURE, Args&&... Params)
-	{
-		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Params...);
+		if (NumProcessed > 0)
+		{
+			FlushBatchHandlers();
+		}
 
-		PublishWithMessage(MESSAGE_TAG_PARAM_VALUE, MESSAGE_PARAMETER, Message);
+		return NumProcessed;
 	}
 
 	/**
-	 * Immediately sends a message to the specified recipient.
+	 * Receives a single message from the endpoint's inbox.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Recipient The message recipient.
+	 * Note that an incoming message will only be queued up in the endpoint's inbox if the inbox has
+	 * been enabled and no matching message handler handled it. The inbox is disabled by default and
+	 * must be enabled using the EnableInbox() method.
+	 *
+	 * @param OutContext Will hold the context of the received message.
+	 * @return true if a message was received, false if the inbox was empty.
+	 * @see DisableInbox, EnableInbox, IsInboxEnabled, ProcessInbox
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const FSGMessageAddress& Recipient)
+	bool ReceiveFromInbox(TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& OutContext)
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, TArrayBuilder<FSGMessageAddress>().Add(Recipient), FTimespan::Zero(), FDateTime::MaxValue());
+		return DequeueInbox(OutContext);
 	}
 
 	/**
-	 * Immediately sends a message to the specified recipient.
+	 * Limits the number of messages the inbox can hold.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Annotations An optional message annotations header.
-	 * @param Recipient The message recipient.
+	 * When the inbox is full, the policy decides what happens to new messages. Messages that
+	 * are dropped are counted, and the backpressure handler is notified when the inbox becomes
+	 * congested and when it drained below half of its capacity again.
+	 *
+	 * Inboxes are filled by routers and delivery tasks, which can't wait for the consumer, so the
+	 * Block policy isn't supported here and is treated as DropNewest.
+	 *
+	 * @param Capacity The maximum number of queued messages (0 = unlimited).
+	 * @param Policy How to treat messages that arrive while the inbox is full.
+	 * @see GetNumDroppedInboxMessages, SetBackpressureHandler
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TMap<FName, FString> Annotations, const FSGMessageAddress& Recipient)
+	void SetInboxCapacity(int32 Capacity, ESGMessageBackpressurePolicy Policy = ESGMessageBackpressurePolicy::DropNewest)
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Annotations, nullptr, TArrayBuilder<FSGMessageAddress>().Add(Recipient), FTimespan::Zero(), FDateTime::MaxValue());
+		ensureMsgf(Policy != ESGMessageBackpressurePolicy::Block, TEXT("Endpoint inboxes can't block their producers, they drop new messages instead"));
+
+		InboxCapacity = FMath::Max(Capacity, 0);
+		InboxPolicy = (Policy == ESGMessageBackpressurePolicy::Block) ? ESGMessageBackpressurePolicy::DropNewest : Policy;
 	}
 
 	/**
-	 * Sends a message to the specified recipient after a given delay.
+	 * Gets the maximum number of messages the inbox can hold.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Recipient The message recipient.
-	 * @param Delay The delay after which to send the message.
+	 * @return Inbox capacity (0 = unlimited).
+	 * @see SetInboxCapacity
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Delay)
+	int32 GetInboxCapacity() const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, TArrayBuilder<FSGMessageAddress>().Add(Recipient), Delay, FDateTime::MaxValue());
+		return InboxCapacity;
 	}
 
 	/**
-	 * Sends a message with fields and expiration to the specified recipient after a given delay.
+	 * Gets the number of messages waiting in the inbox.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Recipient The message recipient.
-	 * @param Expiration The time at which the message expires.
-	 * @param Delay The delay after which to send the message.
+	 * @return Number of queued messages.
+	 * @see IsInboxEmpty
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Delay, const FDateTime& Expiration)
+	int32 GetNumInboxMessages() const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, TArrayBuilder<FSGMessageAddress>().Add(Recipient), Delay, Expiration);
+		return NumInboxMessages.load(std::memory_order_relaxed);
 	}
 
 	/**
-	 * Sends a message with fields and attachment to the specified recipient.
+	 * Gets the number of messages the inbox dropped because it was full.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipient The message recipient.
+	 * @return Number of dropped messages.
+	 * @see SetInboxCapacity
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient)
+	int64 GetNumDroppedInboxMessages() const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, TArrayBuilder<FSGMessageAddress>().Add(Recipient), FTimespan::Zero(), FDateTime::MaxValue());
+		return NumDroppedInboxMessages.load(std::memory_order_relaxed);
 	}
 
 	/**
-	 * Sends a message with fields, attachment and expiration to the specified recipient after a given delay.
+	 * Gets the number of inbox messages that were replaced by a newer message with the same conflation key.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipient The message recipient.
-	 * @param Expiration The time at which the message expires.
-	 * @param Delay The delay after which to send the message.
+	 * @return Number of replaced messages.
+	 * @see SGMessageConflation::GetConflationKey
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FDateTime& Expiration, const FTimespan& Delay)
+	int64 GetNumConflatedInboxMessages() const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, TArrayBuilder<FSGMessageAddress>().Add(Recipient), Delay, Expiration);
+		return NumConflatedInboxMessages.load(std::memory_order_relaxed);
 	}
 
 	/**
-	 * Sends a message with fields, attachment and expiration to the specified recipient after a given delay.
+	 * Gets a percentile of the latest latencies from sending a message until this endpoint handled it.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Annotations An optional message annotations header.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipient The message recipient.
-	 * @param Expiration The time at which the message expires.
-	 * @param Delay The delay after which to send the message.
+	 * The latency starts when the message was sent, or forwarded, and doesn't include the delay
+	 * of delayed messages. It includes the time a message waited in the inbox.
+	 *
+	 * @param Percentile The percentile to get (0 to 100, e.g. 50 or 99).
+	 * @return The latency (in seconds, or zero if the endpoint handled no messages or latency probes are disabled).
+	 * @see GetNumHandledLatencies, USGMessagingSettings::bEnableLatencyProbes
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TMap<FName, FString> Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FDateTime& Expiration, const FTimespan& Delay)
+	double GetHandledLatency(double Percentile) const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Annotations, Attachment, TArrayBuilder<FSGMessageAddress>().Add(Recipient), Delay, Expiration);
+		return LatencyProbe.IsValid() ? LatencyProbe->GetPercentile(Percentile) : 0.0;
 	}
 
 	/**
-	 * Immediately sends a message to the specified list of recipients.
+	 * Gets the number of handled messages whose latency was measured.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Recipients The message recipients.
+	 * @return Number of measured messages.
+	 * @see GetHandledLatency
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TArray<FSGMessageAddress>& Recipients)
+	int64 GetNumHandledLatencies() const
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, Recipients, FTimespan::Zero(), FDateTime::MaxValue());
+		return LatencyProbe.IsValid() ? (int64)LatencyProbe->GetCount() : 0;
 	}
 
 	/**
-	 * Sends a message to the specified list of recipients after a given delay after a given delay.
+	 * Sets the handler for backpressure notifications.
 	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Recipients The message recipients.
-	 * @param Delay The delay after which to send the message.
+	 * The handler receives the bus' router notifications (if this endpoint listens to bus notifications)
+	 * and the notifications of this endpoint's inbox. Inbox notifications are made on the thread that
+	 * fills or drains the inbox.
+	 *
+	 * @param InHandler The handler to set.
+	 * @see SetInboxCapacity
 	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay)
+	void SetBackpressureHandler(FOnSGMessageBackpressure InHandler)
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, Recipients, Delay, FDateTime::MaxValue());
+		BackpressureDelegate = MoveTemp(InHandler);
 	}
 
-	/**
-	 * Sends a message with fields and attachment to the specified list of recipients after a given delay.
-	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipients The message recipients.
-	 * @param Delay The delay after which to send the message.
-	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay)
+public:
+
+	//~ ISGMessageReceiver interface
+
+	virtual FName GetDebugName() const override
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, Recipients, Delay, FDateTime::MaxValue());
+		return Name;
 	}
 
-	/**
-	 * Sends a message to the specified list of recipients.
-	 *
-	 * @param MessageType The type of message to send.
-	 * @param Message The message to send.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipients The message recipients.
-	 * @param Delay The delay after which to send the message.
-	 * @param Expiration The time at which the message expires.
-	 */
-	template<typename MessageType>
-	void Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	virtual const FGuid& GetRecipientId() const override
 	{
-		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, Recipients, Delay, Expiration);
+		return Id;
 	}
 
-	/**
-	 * Sends a message to the specified list of recipients.
-	 * Allows to specify message flags
-	 *
-	 * @param Message The message to send.
-	 * @param TypeInfo The message's type information.
-	 * @param Flags The message's type information.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipients The message recipients.
-	 * @param Delay The delay after which to send the message.
+	virtual ENamedThreads::Type GetRecipientThread() const override
+	{
+		return RecipientThread;
+	}
+
+	virtual bool IsLocal() const override
+	{
+		return true;
+	}
+
+	virtual int32 GetNumQueuedMessages() const override
+	{
+		return NumInboxMessages.load(std::memory_order_relaxed);
+	}
+
+	virtual bool IsDurable() const override
+	{
+		return bDurable;
+	}
+
+	virtual void ReceiveMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
+	{
+		if (!Enabled)
+		{
+			DropRequest(*Context);
+
+			return;
+		}
+
+		if (InboxEnabled)
+		{
+			EnqueueInbox(Context);
+		}
+		else
+		{
+			ProcessMessage(Context);
+		}
+	}
+
+	virtual void FlushReceivedMessages() override
+	{
+		// batch handlers of endpoints with an inbox are flushed when the inbox is processed
+		if (Enabled && !InboxEnabled)
+		{
+			FlushBatchHandlers();
+		}
+	}
+
+	//~ ISGBusListener interface
+
+	virtual ENamedThreads::Type GetListenerThread() const override
+	{
+		return RecipientThread;
+	}
+
+	virtual void NotifyRegistration(const FSGMessageAddress& InAddress, ESGMessageBusNotification InNotification)
+	{
+		if (!Enabled)
+		{
+			return;
+		}
+
+		NotificationDelegate.ExecuteIfBound(FSGMessageBusNotification{ InNotification, InAddress });
+	}
+
+	virtual void NotifyBackpressure(const FSGMessageBackpressureEvent& Event) override
+	{
+		if (!Enabled)
+		{
+			return;
+		}
+
+		BackpressureDelegate.ExecuteIfBound(Event);
+	}
+
+public:
+
+	//~ ISGMessageSender interface
+
+	virtual FSGMessageAddress GetSenderAddress() override
+	{
+		return Address;
+	}
+
+	virtual void NotifyMessageError(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FString& Error) override
+	{
+		ErrorDelegate.ExecuteIfBound(Context.Get(), Error);
+	}
+
+public:
+
+	/**
+	 * Creates a message of the specified template type.
+	 *
+	 * Prefer using this helper rather than explicit new. See FEngineServicePong.
+	 *
+	 * @param Args The constructor arguments to the template type
+	 */
+	template<typename T, typename... InArgTypes>
+	static T* MakeMessage(InArgTypes&&... Args)
+	{
+		void* Buffer = FSGMessagePool::Malloc(sizeof(T), alignof(T));
+
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+		T* Message = new (Buffer) T(::Forward<InArgTypes>(Args)...);
+
+		return Message;
+	}
+
+	/**
+	 * Immediately forwards a previously received message to the specified recipient.
+	 *
+	 * Messages can only be forwarded to endpoints within the same process.
+	 *
+	 * @param Context The context of the message to forward.
+	 * @param Recipient The address of the recipient to forward the message to.
+	 */
+	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient)
+	{
+		Forward(Context, MakeArrayView(&Recipient, 1), FTimespan::Zero());
+	}
+
+	/**
+	 * Forwards a previously received message to the specified recipient after a given delay.
+	 *
+	 * Messages can only be forwarded to endpoints within the same process.
+	 *
+	 * @param Context The context of the message to forward.
+	 * @param Recipient The address of the recipient to forward the message to.
+	 * @param ForwardingScope The scope of the forwarded message.
+	 * @param Delay The delay after which to publish the message.
+	 */
+	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, const FTimespan& Delay)
+	{
+		Forward(Context, MakeArrayView(&Recipient, 1), Delay);
+	}
+
+	/**
+	 * Immediately forwards a previously received message to the specified list of recipients.
+	 *
+	 * Messages can only be forwarded to endpoints within the same process.
+	 *
+	 * @param Context The context of the message to forward.
+	 * @param Recipients The list of message recipients to forward the message to.
+	 * @param ForwardingScope The scope of the forwarded message.
+	 */
+	void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArrayView<const FSGMessageAddress> Recipients)
+	{
+		Forward(Context, Recipients, FTimespan::Zero());
+	}
+
+	/**
+	 * Immediately publishes a message to all subscribed recipients.
+	 *
+	 * @param Message The message to publish.
+	 */
+	template<typename MessageType>
+	void Publish(MessageType* Message)
+	{
+		Publish(Message, MessageType::StaticStruct(), ESGMessageScope::Network, FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Immediately pa message to all subscribed recipients within the specified scope.
+	 *
+	 * @param Message The message to publish.
+	 * @param Scope The message scope.
+	 */
+	template<typename MessageType>
+	void Publish(MessageType* Message, ESGMessageScope Scope)
+	{
+		Publish(Message, MessageType::StaticStruct(), Scope, FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Immediately publishes a message to all subscribed recipients.
+	 *
+	 * @param Message The message to publish.
+	 * @param Annotations An optional message annotations header.
+	 */
+	template<typename MessageType>
+	void Publish(MessageType* Message, const FSGMessageAnnotations& Annotations)
+	{
+		Publish(Message, MessageType::StaticStruct(), Annotations, ESGMessageScope::Network, FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Immediately pa message to all subscribed recipients within the specified scope.
+	 *
+	 * @param Message The message to publish.
+	 * @param Annotations An optional message annotations header.
+	 * @param Scope The message scope.
+	 */
+	template<typename MessageType>
+	void Publish(MessageType* Message, const FSGMessageAnnotations& Annotations, ESGMessageScope Scope)
+	{
+		Publish(Message, MessageType::StaticStruct(), Annotations, Scope, FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Publishes a message to all subscribed recipients after a given delay.
+	 *
+	 * @param Message The message to publish.
+	 * @param Delay The delay after which to publish the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Publish(MessageType* Message, const FTimespan& Delay)
+	{
+		return Publish(Message, MessageType::StaticStruct(), ESGMessageScope::Network, Delay, FDateTime::MaxValue());
+	}
+
+	/**
+	 * Publishes a message to all subscribed recipients within the specified scope after a given delay.
+	 *
+	 * @param Message The message to publish.
+	 * @param Scope The message scope.
+	 * @param Delay The delay after which to publish the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Publish(MessageType* Message, ESGMessageScope Scope, const FTimespan& Delay)
+	{
+		return Publish(Message, MessageType::StaticStruct(), Scope, Delay, FDateTime::MaxValue());
+	}
+
+	/**
+	 * Publishes a message to all subscribed recipients within the specified scope.
+	 *
+	 * @param Message The message to publish.
+	 * @param Scope The message scope.
+	 * @param Fields The message content.
+	 * @param Delay The delay after which to publish the message.
 	 * @param Expiration The time at which the message expires.
 	 */
 	template<typename MessageType>
-	void Send(MessageType* Message, ESGMessageFlags Flags, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Publish(MessageType* Message, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
 	{
-		Send(Message, MessageType::StaticStruct(), Flags, Attachment, Recipients, Delay, Expiration);
+		return Publish(Message, MessageType::StaticStruct(), Scope, Delay, Expiration);
 	}
 
 	/**
-	 * Sends a message to the specified list of recipients.
-	 * Allows to specify message flags
+	 * Publishes a message to all subscribed recipients within the specified scope.
 	 *
-	 * @param Message The message to send.
-	 * @param TypeInfo The message's type information.
-	 * @param Flags The message's type information.
+	 * @param Message The message to publish.
 	 * @param Annotations An optional message annotations header.
-	 * @param Attachment An optional binary data attachment.
-	 * @param Recipients The message recipients.
-	 * @param Delay The delay after which to send the message.
+	 * @param Scope The message scope.
+	 * @param Fields The message content.
+	 * @param Delay The delay after which to publish the message.
 	 * @param Expiration The time at which the message expires.
 	 */
 	template<typename MessageType>
-	void Send(MessageType* Message, ESGMessageFlags Flags, const TMap<FName, FString> Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	FSGDelayedMessageHandle Publish(MessageType* Message, const FSGMessageAnnotations& Annotations, ESGMessageScope Scope, const FTimespan& Delay, const FDateTime& Expiration)
 	{
-		Send(Message, MessageType::StaticStruct(), Flags, Annotations, Attachment, Recipients, Delay, Expiration);
+		return Publish(Message, MessageType::StaticStruct(), Annotations, Scope, Delay, Expiration);
 	}
 
 	template <typename MessageType>
-	void Send(const FName& MessageTag, MessageType* Message, const TArray<FSGMessageAddress>& Recipients,
-	          CONST_SEND_PARAMETER_SIGNATURE)
+	FSGDelayedMessageHandle Publish(const FName& MessageTag, MessageType* Message, CONST_PUBLISH_PARAMETER_SIGNATURE)
 	{
+		static_assert(TIsDerivedFrom<MessageType, ISGMessage>::Value, "Tagged messages must implement ISGMessage");
+
 		const auto Bus = GetBusIfEnabled();
 
 		if (Bus.IsValid())
 		{
-			Bus->Send(MessageTag, Message, Recipients, SEND_PARAMETER_FORWARD, AsShared());
+			return Bus->Publish(MessageTag, Message, PUBLISH_PARAMETER_FORWARD, AsShared());
 		}
-	}
 
-	template <typename MessageType>
-	void Send(const FName& MessageTag, MessageType* Message, const FSGMessageAddress& Recipient,
-	          CONST_SEND_PARAMETER_SIGNATURE)
-	{
-		Send(MessageTag, Message, TArrayBuilder<FSGMessageAddress>().Add(Recipient), MESSAGE_PARAMETER);
+		Message->Release();
+
+		return FSGDelayedMessageHandle();
 	}
 
 	template <typename MessageType>
-	void SendWithMessage(MESSAGE_TAG_PARAM_SIGNATURE, const TArray<FSGMessageAddress>& Recipients,
-	                     CONST_SEND_PARAMETER_SIGNATURE, MessageType* Message)
+	FSGDelayedMessageHandle PublishWithMessage(MESSAGE_TAG_PARAM_SIGNATURE, CONST_PUBLISH_PARAMETER_SIGNATURE, MessageType* Message)
 	{
-		Send(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, Recipients, MESSAGE_PARAMETER);
+		return Publish(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, MESSAGE_PARAMETER);
 	}
 
 	template <typename ...Args>
-	void Send(MESSAGE_TAG_PARAM_SIGNATURE, const TArray<FSGMessageAddress>& Recipients, CONST_SEND_PARAMETER_SIGNATURE,
-	          Args&&... Params)
+	FSGDelayedMessageHandle Publish(MESSAGE_TAG_PARAM_SIGNATURE, CONST_PUBLISH_PARAMETER_SIGNATURE, Args&&... Params)
 	{
-		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Params...);
+		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...);
 
-		SendWithMessage(MESSAGE_TAG_PARAM_VALUE, Recipients, MESSAGE_PARAMETER, Message);
+		return PublishWithMessage(MESSAGE_TAG_PARAM_VALUE, MESSAGE_PARAMETER, Message);
 	}
 
-	template <typename ...Args>
-	void Send(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageAddress& Recipient, CONST_SEND_PARAMETER_SIGNATURE,
-	          Args&&... Params)
+	/**
+	 * Publishes a batch of tagged messages with a single router command per router shard.
+	 *
+	 * The messages share the publish parameter, and subscribers receive them in the order they were
+	 * added to the batch. The batch is empty afterwards.
+	 *
+	 * @param Batch The messages to publish.
+	 * @see FSGMessageBatch, SendBatch
+	 */
+	void PublishBatch(FSGMessageBatch& Batch, CONST_PUBLISH_PARAMETER_SIGNATURE)
 	{
-		Send(MESSAGE_TAG_PARAM_VALUE, TArrayBuilder<FSGMessageAddress>().Add(Recipient), MESSAGE_PARAMETER, Params...);
+		if (Batch.Num() == 0)
+		{
+			return;
+		}
+
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			Bus->PublishBatch(Batch.GetEntries(), PUBLISH_PARAMETER_FORWARD, AsShared());
+			Batch.Detach();
+		}
+		else
+		{
+			Batch.Reset();
+		}
 	}
 
 	/**
-	 * Template method to subscribe the message endpoint to the specified type of messages with the default message scope.
+	 * Publishes a tagged message every interval until the returned handle is cancelled.
 	 *
-	 * The default message scope is all messages excluding loopback messages.
+	 * The message is built once and shared by all periods (the Delay and Expiration of the publish parameter are ignored).
 	 *
-	 * @param HandlerType The type of the class handling the message.
-	 * @param MessageType The type of messages to subscribe to.
-	 * @param Handler The class handling the messages.
-	 * @param HandlerFunc The class function handling the messages.
+	 * @param MessageTag The message tag.
+	 * @param Message The message to publish.
+	 * @param Interval The time between two publishes (also the delay of the first one).
+	 * @return Handle to cancel the schedule with (invalid if the message wasn't scheduled).
+	 * @see CancelDelayedMessage, ISGMessageBus::SchedulePeriodic
 	 */
-	template<class MessageType>
+	template <typename MessageType>
+	FSGDelayedMessageHandle SchedulePeriodic(const FName& MessageTag, MessageType* Message, const FTimespan& Interval, CONST_PUBLISH_PARAMETER_SIGNATURE)
+	{
+		static_assert(TIsDerivedFrom<MessageType, ISGMessage>::Value, "Tagged messages must implement ISGMessage");
+
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			return Bus->SchedulePeriodic(MessageTag, Message, MESSAGE_PARAMETER.Scope, MESSAGE_PARAMETER.Annotations, Interval, MESSAGE_PARAMETER.Flags, AsShared());
+		}
+
+		Message->Release();
+
+		return FSGDelayedMessageHandle();
+	}
+
+	template <typename ...Args>
+	FSGDelayedMessageHandle SchedulePeriodic(MESSAGE_TAG_PARAM_SIGNATURE, const FTimespan& Interval, CONST_PUBLISH_PARAMETER_SIGNATURE, Args&&... Params)
+	{
+		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...);
+
+		return SchedulePeriodic(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, Interval, MESSAGE_PARAMETER);
+	}
+
+	/**
+	 * Immediately sends a message to the specified recipient.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 */
+	template<typename MessageType>
+	void Send(MessageType* Message, const FSGMessageAddress& Recipient)
+	{
+		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, MakeArrayView(&Recipient, 1), FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Immediately sends a message to the specified recipient.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Annotations An optional message annotations header.
+	 * @param Recipient The message recipient.
+	 */
+	template<typename MessageType>
+	void Send(MessageType* Message, const FSGMessageAnnotations& Annotations, const FSGMessageAddress& Recipient)
+	{
+		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Annotations, nullptr, MakeArrayView(&Recipient, 1), FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message to the specified recipient after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Delay)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, MakeArrayView(&Recipient, 1), Delay, FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message with fields and expiration to the specified recipient after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 * @param Expiration The time at which the message expires.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Delay, const FDateTime& Expiration)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, MakeArrayView(&Recipient, 1), Delay, Expiration);
+	}
+
+	/**
+	 * Sends a message with fields and attachment to the specified recipient.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipient The message recipient.
+	 */
+	template<typename MessageType>
+	void Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient)
+	{
+		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, MakeArrayView(&Recipient, 1), FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message with fields, attachment and expiration to the specified recipient after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipient The message recipient.
+	 * @param Expiration The time at which the message expires.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FDateTime& Expiration, const FTimespan& Delay)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, MakeArrayView(&Recipient, 1), Delay, Expiration);
+	}
+
+	/**
+	 * Sends a message with fields, attachment and expiration to the specified recipient after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipient The message recipient.
+	 * @param Expiration The time at which the message expires.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FDateTime& Expiration, const FTimespan& Delay)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Annotations, Attachment, MakeArrayView(&Recipient, 1), Delay, Expiration);
+	}
+
+	/**
+	 * Immediately sends a message to the specified list of recipients.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipients The message recipients.
+	 */
+	template<typename MessageType>
+	void Send(MessageType* Message, TArrayView<const FSGMessageAddress> Recipients)
+	{
+		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, Recipients, FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message to the specified list of recipients after a given delay after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipients The message recipients.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, nullptr, Recipients, Delay, FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message with fields and attachment to the specified list of recipients after a given delay.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipients The message recipients.
+	 * @param Delay The delay after which to send the message.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, Recipients, Delay, FDateTime::MaxValue());
+	}
+
+	/**
+	 * Sends a message to the specified list of recipients.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipients The message recipients.
+	 * @param Delay The delay after which to send the message.
+	 * @param Expiration The time at which the message expires.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	{
+		return Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, Attachment, Recipients, Delay, Expiration);
+	}
+
+	/**
+	 * Sends a message to the specified list of recipients.
+	 * Allows to specify message flags
+	 *
+	 * @param Message The message to send.
+	 * @param TypeInfo The message's type information.
+	 * @param Flags The message's type information.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipients The message recipients.
+	 * @param Delay The delay after which to send the message.
+	 * @param Expiration The time at which the message expires.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, ESGMessageFlags Flags, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	{
+		return Send(Message, MessageType::StaticStruct(), Flags, Attachment, Recipients, Delay, Expiration);
+	}
+
+	/**
+	 * Sends a message to the specified list of recipients.
+	 * Allows to specify message flags
+	 *
+	 * @param Message The message to send.
+	 * @param TypeInfo The message's type information.
+	 * @param Flags The message's type information.
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Recipients The message recipients.
+	 * @param Delay The delay after which to send the message.
+	 * @param Expiration The time at which the message expires.
+	 */
+	template<typename MessageType>
+	FSGDelayedMessageHandle Send(MessageType* Message, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration)
+	{
+		return Send(Message, MessageType::StaticStruct(), Flags, Annotations, Attachment, Recipients, Delay, Expiration);
+	}
+
+	template <typename MessageType>
+	FSGDelayedMessageHandle Send(const FName& MessageTag, MessageType* Message, TArrayView<const FSGMessageAddress> Recipients,
+	          CONST_SEND_PARAMETER_SIGNATURE)
+	{
+		static_assert(TIsDerivedFrom<MessageType, ISGMessage>::Value, "Tagged messages must implement ISGMessage");
+
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			return Bus->Send(MessageTag, Message, Recipients, SEND_PARAMETER_FORWARD, AsShared());
+		}
+
+		Message->Release();
+
+		return FSGDelayedMessageHandle();
+	}
+
+	template <typename MessageType>
+	FSGDelayedMessageHandle Send(const FName& MessageTag, MessageType* Message, const FSGMessageAddress& Recipient,
+	          CONST_SEND_PARAMETER_SIGNATURE)
+	{
+		return Send(MessageTag, Message, MakeArrayView(&Recipient, 1), MESSAGE_PARAMETER);
+	}
+
+	template <typename MessageType>
+	FSGDelayedMessageHandle SendWithMessage(MESSAGE_TAG_PARAM_SIGNATURE, TArrayView<const FSGMessageAddress> Recipients,
+	                     CONST_SEND_PARAMETER_SIGNATURE, MessageType* Message)
+	{
+		return Send(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, Recipients, MESSAGE_PARAMETER);
+	}
+
+	template <typename ...Args>
+	FSGDelayedMessageHandle Send(MESSAGE_TAG_PARAM_SIGNATURE, TArrayView<const FSGMessageAddress> Recipients, CONST_SEND_PARAMETER_SIGNATURE,
+	          Args&&... Params)
+	{
+		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...);
+
+		return SendWithMessage(MESSAGE_TAG_PARAM_VALUE, Recipients, MESSAGE_PARAMETER, Message);
+	}
+
+	/**
+	 * Sends a batch of tagged messages to the specified recipients with a single router command per router shard.
+	 *
+	 * The messages share the send parameter, and recipients receive them in the order they were added
+	 * to the batch. The batch is empty afterwards.
+	 *
+	 * @param Batch The messages to send.
+	 * @param Recipients The message recipients.
+	 * @see FSGMessageBatch, PublishBatch
+	 */
+	void SendBatch(FSGMessageBatch& Batch, TArrayView<const FSGMessageAddress> Recipients, CONST_SEND_PARAMETER_SIGNATURE)
+	{
+		if (Batch.Num() == 0)
+		{
+			return;
+		}
+
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			Bus->SendBatch(Batch.GetEntries(), Recipients, SEND_PARAMETER_FORWARD, AsShared());
+			Batch.Detach();
+		}
+		else
+		{
+			Batch.Reset();
+		}
+	}
+
+	template <typename ...Args>
+	FSGDelayedMessageHandle Send(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageAddress& Recipient, CONST_SEND_PARAMETER_SIGNATURE,
+	          Args&&... Params)
+	{
+		return Send(MESSAGE_TAG_PARAM_VALUE, MakeArrayView(&Recipient, 1), MESSAGE_PARAMETER, Forward<Args>(Params)...);
+	}
+
+	/**
+	 * Sends a request to the specified recipient and returns a future for its reply.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 * @param Timeout The time after which the request times out (zero = never).
+	 * @return Future for the reply.
+	 * @see Reply
+	 */
+	template<typename MessageType>
+	TFuture<FSGMessageReply> Request(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Timeout)
+	{
+		return Request(Message, MessageType::StaticStruct(), ESGMessageFlags::None, FSGMessageAnnotations::GetEmpty(), nullptr, Recipient, Timeout);
+	}
+
+	/**
+	 * Sends a tagged request to the specified recipient and returns a future for its reply.
+	 *
+	 * The delay and expiration of the send parameter are ignored, requests are sent right away and expire when they time out.
+	 *
+	 * @param MessageTag The message tag.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 * @param Timeout The time after which the request times out (zero = never).
+	 * @return Future for the reply.
+	 * @see Reply
+	 */
+	template <typename MessageType>
+	TFuture<FSGMessageReply> Request(const FName& MessageTag, MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Timeout,
+	          CONST_SEND_PARAMETER_SIGNATURE)
+	{
+		static_assert(TIsDerivedFrom<MessageType, ISGMessage>::Value, "Tagged messages must implement ISGMessage");
+
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			return Bus->Request(MessageTag, Message, Recipient, MESSAGE_PARAMETER.Flags, MESSAGE_PARAMETER.Annotations, MESSAGE_PARAMETER.Attachment, Timeout, AsShared());
+		}
+
+		Message->Release();
+
+		TPromise<FSGMessageReply> CancelledPromise;
+		CancelledPromise.SetValue(FSGMessageReply(ESGMessageRequestResult::Cancelled));
+
+		return CancelledPromise.GetFuture();
+	}
+
+	template <typename ...Args>
+	TFuture<FSGMessageReply> Request(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageAddress& Recipient, const FTimespan& Timeout,
+	          Args&&... Params)
+	{
+		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...);
+
+		return Request(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, Recipient, Timeout, DEFAULT_SEND_PARAMETER);
+	}
+
+	/**
+	 * Replies to a request.
+	 *
+	 * The reply is sent to the request's sender and completes its future. Replying to a message
+	 * that wasn't sent as a request is the same as sending the message to its sender.
+	 *
+	 * @param MessageType The type of message to reply with.
+	 * @param RequestContext The context of the request message.
+	 * @param Message The reply message.
+	 * @see Request
+	 */
+	template<typename MessageType>
+	void Reply(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& RequestContext, MessageType* Message)
+	{
+		Send(Message, MessageType::StaticStruct(), ESGMessageFlags::None, SGMessageRequest::MakeReplyAnnotations(*RequestContext), nullptr, MakeArrayView(&RequestContext->GetSender(), 1), FTimespan::Zero(), FDateTime::MaxValue());
+	}
+
+	template <typename ...Args>
+	void Reply(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& RequestContext, MESSAGE_TAG_PARAM_SIGNATURE, Args&&... Params)
+	{
+		auto Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...);
+		const FSGMessageParameter::FSendParameter ReplyParameter(ESGMessageFlags::None, SGMessageRequest::MakeReplyAnnotations(*RequestContext));
+
+		Send(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), Message, RequestContext->GetSender(), ReplyParameter);
+	}
+
+#if SGMESSAGING_WITH_COROUTINES
+	/**
+	 * Sends a request and returns an awaitable for its reply.
+	 *
+	 * The awaiting coroutine resumes on the recipient thread with the outcome of the request.
+	 *
+	 * @param MessageType The type of message to send.
+	 * @param Message The message to send.
+	 * @param Recipient The message recipient.
+	 * @param Timeout The time after which the request times out (zero = never).
+	 * @return Awaitable for the reply.
+	 * @see Request, FSGMessageTask
+	 */
+	template<typename MessageType>
+	TSGMessageAwaitable<FSGMessageReply> RequestAsync(MessageType* Message, const FSGMessageAddress& Recipient, const FTimespan& Timeout)
+	{
+		return AwaitReply(Request(Message, Recipient, Timeout));
+	}
+
+	template <typename ...Args>
+	TSGMessageAwaitable<FSGMessageReply> RequestAsync(MESSAGE_TAG_PARAM_SIGNATURE, const FSGMessageAddress& Recipient, const FTimespan& Timeout,
+	          Args&&... Params)
+	{
+		return AwaitReply(Request(MESSAGE_TAG_PARAM_VALUE, Recipient, Timeout, Forward<Args>(Params)...));
+	}
+
+	/**
+	 * Returns an awaitable for the next message of the given type that this endpoint receives.
+	 *
+	 * Messages received from now on count, even if the coroutine awaits later. The endpoint subscribes
+	 * to the message type unless it already did, and keeps the subscription for later awaits. Handlers of
+	 * the message type are invoked before the coroutine resumes on the recipient thread.
+	 *
+	 * @param MessageType The type name of the message to wait for.
+	 * @return Awaitable for the message's context (invalid if the endpoint was destroyed first).
+	 * @see FSGMessageTask
+	 */
+	TSGMessageAwaitable<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> NextMessage(const FName& MessageType)
+	{
+		bool bSubscribed = false;
+		{
+			FScopeLock Lock(&SubscriptionsCS);
+
+			bSubscribed = Subscriptions.ContainsByPredicate([&MessageType](const TPair<FName, FSGMessageScopeRange>& Subscription) { return Subscription.Key == MessageType; });
+		}
+
+		if (!bSubscribed)
+		{
+			Subscribe(MessageType, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+		}
+
+		return TSGMessageAwaitable<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>(AddAwaiter(MessageType));
+	}
+
+	TSGMessageAwaitable<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> NextMessage(MESSAGE_TAG_PARAM_SIGNATURE)
+	{
+		return NextMessage(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE));
+	}
+
+	/**
+	 * Returns an awaitable that resumes the coroutine after the given delay.
+	 *
+	 * The endpoint sends itself a delayed wake-up message, so the delay uses the bus' timers and the
+	 * coroutine resumes on the recipient thread.
+	 *
+	 * @param Duration The time to wait.
+	 * @return Awaitable for the delay.
+	 * @see FSGMessageTask
+	 */
+	TSGMessageAwaitable<void> Delay(const FTimespan& Duration)
+	{
+		const uint64 WakeId = NextWakeId.fetch_add(1, std::memory_order_relaxed);
+		const TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe> State = AddAwaiter(SGMessageAwaitable::WakeMessageType, WakeId);
+		const auto Bus = GetBusIfEnabled();
+
+		if (Bus.IsValid())
+		{
+			const FSGMessageAnnotations Annotations({ { SGMessageAwaitable::WakeIdAnnotation, LexToString(WakeId) } });
+
+			Bus->Send(SGMessageAwaitable::WakeMessageType, FSGMessageBuilder::Builder<FSGMessage>(), MakeArrayView(&Address, 1), ESGMessageFlags::None,
+				Annotations, nullptr, Duration, FDateTime::MaxValue(), AsShared());
+		}
+		else if (RemoveAwaiter(State))
+		{
+			State->Complete(FSGMessageReply(ESGMessageRequestResult::Cancelled), false);
+		}
+
+		return TSGMessageAwaitable<void>(State);
+	}
+#endif
+
+	/**
+	 * Template method to subscribe the message endpoint to the specified type of messages with the default message scope.
+	 *
+	 * The default message scope is all messages excluding loopback messages.
+	 *
+	 * @param HandlerType The type of the class handling the message.
+	 * @param MessageType The type of messages to subscribe to.
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 */
+	template<class MessageType>
 	void Subscribe()
 	{
-		Subscribe(MessageType::StaticStruct()->GetFName(), FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+		Subscribe(TSGMessageType<MessageType>::GetName(), FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	template <typename HandlerType>
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
+	               typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithRawMessageHandler(MessageTag, Handler, HandlerFunc);
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, const TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithFunctionMessageHandler(MessageTag, HandlerFunc);
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, const TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithLambdaMessageHandler(MessageTag, HandlerFunc);
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Subscribes a handler for typed messages with the given tag (via TFunction object).
+	 *
+	 * All messages published with the tag must be of the given type.
+	 *
+	 * @param MessageType The type of the messages, i.e. a TSGTypedMessage.
+	 * @param HandlerFunc The function handling the messages.
+	 * @see TSGTypedMessage
+	 */
+	template <typename MessageType>
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, const typename TSGFunctionMessageHandler<MessageType>::FuncType HandlerFunc)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithHandler(MessageTag, MakeShareable(new TSGFunctionMessageHandler<MessageType>(HandlerFunc)));
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Subscribes a handler for typed messages with the given tag (via raw function pointer).
+	 *
+	 * All messages published with the tag must be of the given type.
+	 *
+	 * @param MessageType The type of the messages, i.e. a TSGTypedMessage.
+	 * @param HandlerType The type of the class handling the messages.
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 * @see TSGTypedMessage
+	 */
+	template <typename MessageType, typename HandlerType>
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
+	               typename TSGRawMessageHandler<MessageType, HandlerType>::FuncType HandlerFunc)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithHandler(MessageTag, MakeShareable(new TSGRawMessageHandler<MessageType, HandlerType>(Handler, HandlerFunc)));
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Subscribes a member function that is bound at compile time to messages with the given tag.
+	 *
+	 * Unlike the other overloads, the function isn't called through a handler object, so a delivery
+	 * costs a single indirect call. The message type is deduced from the function's first parameter.
+	 *
+	 *		Endpoint->Subscribe<&FMyClass::HandleFoo>(TopicID, MessageID, this);
+	 *
+	 * @param HandlerFunc The member function handling the messages.
+	 * @param Handler The object handling the messages.
+	 */
+	template <auto HandlerFunc>
+	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, typename TSGStaticMessageHandlerTraits<decltype(HandlerFunc)>::HandlerType* Handler)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithStaticHandler(MessageTag, FSGStaticMessageHandler::Bind<HandlerFunc>(Handler));
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Subscribes a handler that receives the messages with the given tag in batches.
+	 *
+	 * The messages are collected and handed to the function together after each batch of deliveries
+	 * from the bus, after the inbox was processed, or when FlushBatchHandlers is called, so that
+	 * consumers of many small messages pay for one call instead of one per message.
+	 *
+	 * @param HandlerFunc The function handling the messages.
+	 * @param MaxBatchSize The number of messages after which a batch is handled right away (0 = unlimited).
+	 * @see FlushBatchHandlers
+	 */
+	void SubscribeBatch(MESSAGE_TAG_PARAM_SIGNATURE, FSGBatchMessageHandler::FuncType HandlerFunc, int32 MaxBatchSize = 0)
+	{
+		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+
+		WithBatchHandler(MessageTag, MakeShareable(new FSGBatchMessageHandler(MoveTemp(HandlerFunc), MaxBatchSize)));
+
+		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Hands the messages collected by batch handlers to their functions.
+	 *
+	 * @see SubscribeBatch
+	 */
+	void FlushBatchHandlers()
+	{
+		const uint32 Epoch = EnterHandlers();
+
+		const FHandlerTable* CurrentHandlers = Handlers.load();
+
+		for (const auto& BatchHandler : CurrentHandlers->BatchHandlers)
+		{
+			BatchHandler->FlushMessages();
+		}
+
+		LeaveHandlers(Epoch);
+	}
+
+	/**
+	 * Template method to subscribe the message endpoint to the specified type and scope of messages.
+	 *
+	 * @param HandlerType The type of the class handling the message.
+	 * @param MessageType The type of messages to subscribe to.
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 * @param ScopeRange The range of message scopes to include in the subscription.
+	 */
+	template<class MessageType>
+	void Subscribe(const FSGMessageScopeRange& ScopeRange)
+	{
+		Subscribe(TSGMessageType<MessageType>::GetName(), ScopeRange);
+	}
+
+#if MESSAGE_TAG_WITH_TOPIC
+	/**
+	 * Subscribes a message handler to all messages of the given topic.
+	 *
+	 * The router indexes topic subscriptions by topic identifier, so this is much cheaper than
+	 * subscribing to NAME_All and filtering messages in the handler.
+	 *
+	 * @param HandlerType The type of the class handling the message.
+	 * @param TopicID The topic to subscribe to.
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 * @see SubscribeTopics, UnsubscribeTopic
+	 */
+	template <typename HandlerType>
+	void SubscribeTopic(CONST_TOPIC_ID_DEFINE, HandlerType* Handler,
+	                    typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		SubscribeTopics(TOPIC_ID, TOPIC_ID, Handler, HandlerFunc);
+	}
+
+	void SubscribeTopic(CONST_TOPIC_ID_DEFINE, const TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		SubscribeTopics(TOPIC_ID, TOPIC_ID, HandlerFunc);
+	}
+
+	void SubscribeTopic(CONST_TOPIC_ID_DEFINE, const TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		SubscribeTopics(TOPIC_ID, TOPIC_ID, HandlerFunc);
+	}
+
+	/**
+	 * Subscribes a message handler to all messages of the given range of topics.
+	 *
+	 * @param HandlerType The type of the class handling the message.
+	 * @param FirstTopicID The first topic to subscribe to.
+	 * @param LastTopicID The last topic to subscribe to (inclusive).
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 * @see SubscribeTopic, UnsubscribeTopics
+	 */
+	template <typename HandlerType>
+	void SubscribeTopics(const TOPIC_ID_TYPE FirstTopicID, const TOPIC_ID_TYPE LastTopicID, HandlerType* Handler,
+	                     typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		WithTopicHandler(FSGMessageTopicRange(FirstTopicID, LastTopicID),
+		                 MakeShareable(new TSGRawMessageHandler<FSGMessage, HandlerType>(Handler, MoveTemp(HandlerFunc))));
+
+		Subscribe(FSGMessageTagBuilder::TopicRangePattern(FirstTopicID, LastTopicID), FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	void SubscribeTopics(const TOPIC_ID_TYPE FirstTopicID, const TOPIC_ID_TYPE LastTopicID, const TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		WithTopicHandler(FSGMessageTopicRange(FirstTopicID, LastTopicID),
+		                 MakeShareable(new TSGFunctionMessageHandler<FSGMessage>(HandlerFunc)));
+
+		Subscribe(FSGMessageTagBuilder::TopicRangePattern(FirstTopicID, LastTopicID), FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	void SubscribeTopics(const TOPIC_ID_TYPE FirstTopicID, const TOPIC_ID_TYPE LastTopicID, const TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		WithTopicHandler(FSGMessageTopicRange(FirstTopicID, LastTopicID),
+		                 MakeShareable(new TSGLambdaMessageHandler<FSGMessage>(HandlerFunc)));
+
+		Subscribe(FSGMessageTagBuilder::TopicRangePattern(FirstTopicID, LastTopicID), FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+	}
+
+	/**
+	 * Unsubscribes this endpoint from all messages of the given topic.
+	 *
+	 * @param TopicID The topic to unsubscribe from.
+	 * @see SubscribeTopic
+	 */
+	void UnsubscribeTopic(CONST_TOPIC_ID_DEFINE)
+	{
+		Unsubscribe(FSGMessageTagBuilder::TopicPattern(TOPIC_ID));
+	}
+
+	/**
+	 * Unsubscribes this endpoint from all messages of the given range of topics.
+	 *
+	 * @param FirstTopicID The first topic of the subscribed range.
+	 * @param LastTopicID The last topic of the subscribed range.
+	 * @see SubscribeTopics
+	 */
+	void UnsubscribeTopics(const TOPIC_ID_TYPE FirstTopicID, const TOPIC_ID_TYPE LastTopicID)
+	{
+		Unsubscribe(FSGMessageTagBuilder::TopicRangePattern(FirstTopicID, LastTopicID));
+	}
+#endif
+
+	/**
+	 * Unsubscribes this endpoint from all message types.
+	 *
+	 * @see Subscribe
+	 */
+	void Unsubscribe()
+	{
+		Unsubscribe(NAME_All);
+	}
+
+	/**
+	 * Template method to unsubscribe the endpoint from the specified message type.
+	 *
+	 * @param MessageType The type of message to unsubscribe (NAME_All = all types).
+	 * @see Subscribe
+	 */
+	template<class MessageType>
+	void Unsubscribe()
+	{
+		Unsubscribe(TSGMessageType<MessageType>::GetName());
+	}
+
+public:
+
+	/**
+	 * Safely releases a message endpoint that is receiving messages on AnyThread.
+	 *
+	 * When an object that owns a message endpoint receiving on AnyThread is being destroyed,
+	 * it is possible that the endpoint can outlive the object for a brief period of time if
+	 * the Messaging system is dispatching messages to it. This helper function
+	 * is to block the calling thread while any messages are being dispatched, so that the
+	 * endpoint does not invoke any message handlers after the object has been destroyed.
+	 *
+	 * @param Endpoint The message endpoint to release.
+	 */
+	static void SafeRelease(TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint)
+	{
+		if (Endpoint.IsValid())
+		{
+			Endpoint->ClearHandlers();
+			Endpoint.Reset();
+		}
+	}
+
+protected:
+	/**
+	 * Adds a message handler for the given type of messages (via raw function pointers).
+	 *
+	 * It is legal to configure multiple handlers for the same message type. Each
+	 * handler will be executed when a message of the specified type is received.
+	 *
+	 * This overload is used to register raw class member functions.
+	 *
+	 * @param HandlerType The type of the object handling the messages.
+	 * @param MessageType The type of messages to handle.
+	 * @param Handler The class handling the messages.
+	 * @param HandlerFunc The class function handling the messages.
+	 * @return This instance (for method chaining).
+	 * @see WithHandler
+	 */
+	template <typename HandlerType>
+	void WithRawMessageHandler(const FName& MessageTag, HandlerType* Handler,
+	                           typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		WithHandler(
+			MessageTag,
+			MakeShareable(new TSGRawMessageHandler<FSGMessage, HandlerType>(Handler, MoveTemp(HandlerFunc))));
+	}
+
+	/**
+	 * Adds a message handler for the given type of messages (via TFunction object).
+	 *
+	 * It is legal to configure multiple handlers for the same message type. Each
+	 * handler will be executed when a message of the specified type is received.
+	 *
+	 * This overload is used to register functions that are compatible with TFunction
+	 * function objects, such as global and static functions, as well as lambdas.
+	 *
+	 * @param MessageType The type of messages to handle.
+	 * @param Function The function object handling the messages.
+	 * @return This instance (for method chaining).
+	 * @see WithHandler
+	 */
+	void WithFunctionMessageHandler(const FName& MessageTag,
+	                                TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		WithHandler(MessageTag, MakeShareable(new TSGFunctionMessageHandler<FSGMessage>(MoveTemp(HandlerFunc))));
+	}
+
+	void WithLambdaMessageHandler(const FName& MessageTag,
+	                              TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		WithHandler(MessageTag, MakeShareable(new TSGLambdaMessageHandler<FSGMessage>(MoveTemp(HandlerFunc))));
+	}
+
+	/**
+	 * Registers a message handler with the endpoint.
+	 *
+	 * It is legal to configure multiple handlers for the same message type. Each
+	 * handler will be executed when a message of the specified type is received.
+	 *
+	 * @param MessageType
+	 * @param Handler The handler to add.
+	 * @return This instance (for method chaining).
+	 * @see Handling, WithCatchall
+	 */
+	void WithHandler(const FName& MessageTag, const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& Handler)
+	{
+		FScopeLock Lock(&HandlersCS);
+
+		FHandlerTable* NewHandlers = new FHandlerTable(*Handlers.load());
+		NewHandlers->HandlerMap.FindOrAdd(MessageTag).Emplace(Handler, NextHandlerId++);
+
+		PublishHandlers(NewHandlers, false);
+	}
+
+	/**
+	 * Registers a handler that is bound at compile time with the endpoint.
+	 *
+	 * @param MessageTag The tag of the messages to handle.
+	 * @param Handler The bound handler (its object must outlive the registration).
+	 * @see WithHandler
+	 */
+	void WithStaticHandler(const FName& MessageTag, const FSGStaticMessageHandler& Handler)
+	{
+		FScopeLock Lock(&HandlersCS);
+
+		FHandlerTable* NewHandlers = new FHandlerTable(*Handlers.load());
+		NewHandlers->HandlerMap.FindOrAdd(MessageTag).Emplace(Handler, NextHandlerId++);
+
+		PublishHandlers(NewHandlers, false);
+	}
+
+	/**
+	 * Registers a batch handler with the endpoint.
+	 *
+	 * @param MessageTag The tag of the messages to handle.
+	 * @param Handler The handler to add.
+	 * @see FlushBatchHandlers, WithHandler
+	 */
+	void WithBatchHandler(const FName& MessageTag, const TSharedRef<ISGMessageBatchHandler, ESPMode::ThreadSafe>& Handler)
+	{
+		FScopeLock Lock(&HandlersCS);
+
+		FHandlerTable* NewHandlers = new FHandlerTable(*Handlers.load());
+		NewHandlers->HandlerMap.FindOrAdd(MessageTag).Emplace(Handler, NextHandlerId++);
+		NewHandlers->BatchHandlers.Add(Handler);
+
+		PublishHandlers(NewHandlers, false);
+	}
+
+	/**
+	 * Registers a message handler for all messages of a range of topics.
+	 *
+	 * @param TopicRange The topics to handle.
+	 * @param Handler The handler to add.
+	 * @see WithHandler
+	 */
+	void WithTopicHandler(const FSGMessageTopicRange& TopicRange, const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& Handler)
+	{
+		FScopeLock Lock(&HandlersCS);
+
+		FHandlerTable* NewHandlers = new FHandlerTable(*Handlers.load());
+		NewHandlers->TopicHandlers.Emplace(TopicRange, Handler, NextHandlerId++);
+
+		PublishHandlers(NewHandlers, false);
+	}
+	
+	/**
+	 * Clears all handlers in a way that guarantees it won't overlap with message processing. This preserves internal integrity
+	 * of the array and cases where our owner may be shutting down while receiving messages.
+	 *
+	 * Waits for deliveries on other threads that still use the previous handlers. When called from a
+	 * message handler, messages that are being delivered on other threads may still reach the old handlers.
+	*/
+	void ClearHandlers()
+	{
+		FScopeLock Lock(&HandlersCS);
+
+		PublishHandlers(new FHandlerTable(), true);
+	}
+
+	/**
+	 * Gets a shared pointer to the message bus if this endpoint is enabled.
+	 *
+	 * Activates the endpoint if it is dormant, since its address may receive replies.
+	 *
+	 * @return The message bus.
+	 */
+	FORCEINLINE TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> GetBusIfEnabled()
+	{
+		if (Enabled)
+		{
+			if (!Active.load(std::memory_order_acquire))
+			{
+				Activate();
+			}
+
+			return BusPtr.Pin();
+		}
+
+		return nullptr;
+	}
+
+	/**
+	 * Removes this endpoint's subscriptions from the bus, keeping them for the next activation.
+	 *
+	 * The endpoint stays registered, because unregistering is what the router does for destroyed
+	 * endpoints: it purges their delayed messages and per-sender state, and diverts messages sent to
+	 * durable addresses to disk.
+	 */
+	void Suspend()
+	{
+		FScopeLock Lock(&SubscriptionsCS);
+
+		if (!Active.load(std::memory_order_relaxed))
+		{
+			return;
+		}
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			Bus->Unsubscribe(AsShared(), NAME_All);
+		}
+
+		Active.store(false, std::memory_order_release);
+	}
+
+	/**
+	 * Adds a message to the inbox, applying the inbox backpressure policy if it is full.
+	 *
+	 * @param Context The context of the message to add.
+	 * @see DequeueInbox
+	 */
+	void EnqueueInbox(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Inboxes);
+
+		FSGMessageConflationKey ConflationKey;
+		const bool bIsConflated = SGMessageConflation::GetConflationKey(*Context, ConflationKey);
+
+		// a newer message replaces the queued one with the same key and takes no extra room
+		if (bIsConflated && ReplaceConflatedInboxMessage(ConflationKey, Context))
+		{
+			return;
+		}
+
+		if ((InboxCapacity > 0) && (NumInboxMessages.load(std::memory_order_relaxed) >= InboxCapacity))
+		{
+			if ((InboxPolicy == ESGMessageBackpressurePolicy::DropOldest) || (InboxPolicy == ESGMessageBackpressurePolicy::Coalesce))
+			{
+				TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> OldestContext;
+
+				if (DequeueInbox(OldestContext))
+				{
+					DropInboxMessage(*OldestContext);
+				}
+			}
+			else
+			{
+				DropInboxMessage(*Context);
+
+				return;
+			}
+		}
+
+		if (bIsConflated)
+		{
+			FScopeLock Lock(&InboxCS);
+
+			// another producer may have queued the same key in the meantime
+			if (ReplaceConflatedInboxMessage(ConflationKey, Context))
+			{
+				return;
+			}
+
+			// every key has exactly one queue entry, which picks up the latest message when it is dequeued
+			ConflatedInboxMessages.Add(ConflationKey, Context);
+			Inbox.Enqueue(Context);
+		}
+		else
+		{
+			Inbox.Enqueue(Context);
+		}
+
+		FSGMessageInboxStatistics::AddQueuedMessages(1);
+
+		if ((NumInboxMessages.fetch_add(1, std::memory_order_relaxed) + 1 >= InboxCapacity) && (InboxCapacity > 0))
+		{
+			UpdateInboxBackpressureState(true);
+		}
+	}
+
+	/**
+	 * Removes the oldest message from the inbox.
+	 *
+	 * @param OutContext Will hold the context of the removed message.
+	 * @return true if a message was removed, false if the inbox was empty.
+	 * @see EnqueueInbox
+	 */
+	bool DequeueInbox(TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>& OutContext)
+	{
+		// the inbox only supports a single consumer, and full inboxes may drop from producer threads
+		{
+			FScopeLock Lock(&InboxCS);
+
+			if (!Inbox.Dequeue(OutContext))
+			{
+				return false;
+			}
+
+			FSGMessageConflationKey ConflationKey;
+
+			if ((ConflatedInboxMessages.Num() > 0) && SGMessageConflation::GetConflationKey(*OutContext, ConflationKey))
+			{
+				ConflatedInboxMessages.RemoveAndCopyValue(ConflationKey, OutContext);
+			}
+		}
+
+		const int32 NumMessages = NumInboxMessages.fetch_sub(1, std::memory_order_relaxed) - 1;
+		FSGMessageInboxStatistics::AddQueuedMessages(-1);
+
+		if ((InboxCapacity > 0) && (NumMessages < InboxCapacity / 2))
+		{
+			UpdateInboxBackpressureState(false);
+		}
+
+		return true;
+	}
+
+	/**
+	 * Replaces the queued inbox message with the same conflation key.
+	 *
+	 * @param ConflationKey The conflation key of the new message.
+	 * @param Context The context of the new message.
+	 * @return true if a queued message was replaced, false if there is none with this key.
+	 */
+	bool ReplaceConflatedInboxMessage(const FSGMessageConflationKey& ConflationKey, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		FScopeLock Lock(&InboxCS);
+
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>* QueuedContext = ConflatedInboxMessages.Find(ConflationKey);
+
+		if (QueuedContext == nullptr)
+		{
+			return false;
+		}
+
+		*QueuedContext = Context;
+		NumConflatedInboxMessages.fetch_add(1, std::memory_order_relaxed);
+
+		return true;
+	}
+
+	/**
+	 * Counts a message that was dropped because the inbox was full.
+	 *
+	 * @param Context The context of the dropped message.
+	 */
+	void DropInboxMessage(const ISGMessageContext& Context)
+	{
+		NumDroppedInboxMessages.fetch_add(1, std::memory_order_relaxed);
+		FSGMessageInboxStatistics::CountDroppedMessage();
+		UpdateInboxBackpressureState(true);
+		DropRequest(Context);
+	}
+
+	/**
+	 * Completes the pending request of a dropped request message, so the requester doesn't wait for its reply.
+	 *
+	 * @param Context The context of the dropped message.
+	 */
+	void DropRequest(const ISGMessageContext& Context)
+	{
+		// most messages aren't requests, so don't pin the bus for them
+		if (!Context.GetAnnotations().Contains(SGMessageRequest::CorrelationIdAnnotation))
+		{
+			return;
+		}
+
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			Bus->DropRequest(Context);
+		}
+	}
+
+	/**
+	 * Notifies the backpressure handler if the inbox state changed.
+	 *
+	 * @param bIsCongested Whether the inbox is congested.
+	 */
+	void UpdateInboxBackpressureState(bool bIsCongested)
+	{
+		if (bInboxCongested.exchange(bIsCongested, std::memory_order_relaxed) == bIsCongested)
+		{
+			return;
+		}
+
+		FSGMessageBackpressureEvent Event;
+		{
+			Event.Source = ESGMessageBackpressureSource::Inbox;
+			Event.State = bIsCongested ? ESGMessageBackpressureState::Congested : ESGMessageBackpressureState::Relieved;
+			Event.Address = Address;
+			Event.QueueDepth = NumInboxMessages.load(std::memory_order_relaxed);
+			Event.Capacity = InboxCapacity;
+			Event.NumDroppedMessages = NumDroppedInboxMessages.load(std::memory_order_relaxed);
+		}
+
+		BackpressureDelegate.ExecuteIfBound(Event);
 	}
 
-	template <typename HandlerType>
-	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
-	               typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	/**
+	 * Forwards the given message context to matching message handlers.
+	 *
+	 * @param Context The context of the message to handle.
+	 */
+	void ProcessMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
 	{
-		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+		if (!Context->IsValid())
+		{
+			return;
+		}
 
-		WithRawMessageHandler(MessageTag, Handler, HandlerFunc);
+		const uint32 Epoch = EnterHandlers();
+		{
+			const FHandlerTable* CurrentHandlers = Handlers.load();
+			const FName MessageType = Context->GetMessageType();
 
-		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
-	}
+			// each handler is timed on its own, so the report tells apart the handlers of one endpoint
+			if (const auto MessageHandlers = CurrentHandlers->HandlerMap.Find(MessageType))
+			{
+				for (int32 HandlerIndex = 0; HandlerIndex < MessageHandlers->Num(); ++HandlerIndex)
+				{
+					const FHandlerEntry& Entry = (*MessageHandlers)[HandlerIndex];
+					FSGMessageHandlerScope HandlerScope(Name, MessageType, Entry.Id);
 
-	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, const TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
-	{
-		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+					Entry.Static.Invoke(Context);
+				}
+			}
 
-		WithFunctionMessageHandler(MessageTag, HandlerFunc);
+			const auto& TopicHandlers = CurrentHandlers->TopicHandlers;
 
-		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
-	}
+			int32 TopicID = 0;
 
-	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, const TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
-	{
-		const auto MessageTag = FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE);
+			if ((TopicHandlers.Num() > 0) && Context->GetTopicID(TopicID))
+			{
+				for (int32 HandlerIndex = 0; HandlerIndex < TopicHandlers.Num(); ++HandlerIndex)
+				{
+					const FTopicHandlerEntry& Entry = TopicHandlers[HandlerIndex];
 
-		WithLambdaMessageHandler(MessageTag, HandlerFunc);
+					if (Entry.TopicRange.Contains(TopicID))
+					{
+						FSGMessageHandlerScope HandlerScope(Name, MessageType, Entry.Id);
 
-		Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+						Entry.Handler->HandleMessage(Context);
+					}
+				}
+			}
+		}
+		LeaveHandlers(Epoch);
+
+#if SGMESSAGING_WITH_COROUTINES
+		if (NumAwaiters.load(std::memory_order_relaxed) > 0)
+		{
+			ResumeAwaiters(Context);
+		}
+#endif
+
+		if (LatencyProbe.IsValid())
+		{
+			LatencyProbe->Record(FSGMessageClock::Seconds() - FSGMessageClock::ToSeconds(Context->GetTimeSent()));
+		}
 	}
 
+#if SGMESSAGING_WITH_COROUTINES
 	/**
-	 * Template method to subscribe the message endpoint to the specified type and scope of messages.
+	 * Adds a coroutine awaiting a message.
 	 *
-	 * @param HandlerType The type of the class handling the message.
-	 * @param MessageType The type of messages to subscribe to.
-	 * @param Handler The class handling the messages.
-	 * @param HandlerFunc The class function handling the messages.
-	 * @param ScopeRange The range of message scopes to include in the subscription.
+	 * @param MessageType The type name of the message to wait for.
+	 * @param WakeId The identifier of the wake-up message to wait for (0 = any message of the type).
+	 * @return The state shared with the coroutine.
 	 */
-	template<class MessageType>
-	void Subscribe(const FSGMessageScopeRange& ScopeRange)
+	TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe> AddAwaiter(const FName& MessageType, uint64 WakeId = 0)
 	{
-		Subscribe(MessageType::StaticStruct()->GetFName(), ScopeRange);
+		TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe> State = MakeShared<FSGMessageAwaitState, ESPMode::ThreadSafe>(RecipientThread, WakeId);
+
+		FScopeLock Lock(&AwaitersCS);
+
+		Awaiters.Emplace(MessageType, State);
+		NumAwaiters.store(Awaiters.Num(), std::memory_order_relaxed);
+
+		return State;
 	}
 
 	/**
-	 * Unsubscribes this endpoint from all message types.
+	 * Removes a coroutine awaiting a message.
 	 *
-	 * @see Subscribe
+	 * @param State The state shared with the coroutine.
+	 * @return true if the coroutine was still waiting, false otherwise.
 	 */
-	void Unsubscribe()
+	bool RemoveAwaiter(const TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe>& State)
 	{
-		Unsubscribe(NAME_All);
+		FScopeLock Lock(&AwaitersCS);
+
+		const int32 NumRemoved = Awaiters.RemoveAll([&State](const TPair<FName, TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe>>& Awaiter) { return Awaiter.Value == State; });
+		NumAwaiters.store(Awaiters.Num(), std::memory_order_relaxed);
+
+		return (NumRemoved > 0);
 	}
 
 	/**
-	 * Template method to unsubscribe the endpoint from the specified message type.
+	 * Resumes the coroutines awaiting the given message.
 	 *
-	 * @param MessageType The type of message to unsubscribe (NAME_All = all types).
-	 * @see Subscribe
+	 * @param Context The context of the handled message.
 	 */
-	template<class MessageType>
-	void Unsubscribe()
+	void ResumeAwaiters(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
 	{
-		Unsubscribe(MessageType::StaticStruct()->GetFName());
-	}
+		const FName MessageType = Context->GetMessageType();
+		uint64 WakeId = 0;
 
-public:
+		if (MessageType == SGMessageAwaitable::WakeMessageType)
+		{
+			if (const FString* WakeIdString = Context->GetAnnotations().Find(SGMessageAwaitable::WakeIdAnnotation))
+			{
+				LexFromString(WakeId, **WakeIdString);
+			}
+		}
+
+		TArray<TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe>, TInlineAllocator<4>> CompletedAwaiters;
+		{
+			FScopeLock Lock(&AwaitersCS);
+
+			for (int32 AwaiterIndex = 0; AwaiterIndex < Awaiters.Num();)
+			{
+				if ((Awaiters[AwaiterIndex].Key == MessageType) && (Awaiters[AwaiterIndex].Value->GetWakeId() == WakeId))
+				{
+					CompletedAwaiters.Add(Awaiters[AwaiterIndex].Value);
+					Awaiters.RemoveAt(AwaiterIndex);
+				}
+				else
+				{
+					++AwaiterIndex;
+				}
+			}
+
+			NumAwaiters.store(Awaiters.Num(), std::memory_order_relaxed);
+		}
+
+		// resumed coroutines may await again, so they run outside the lock
+		for (const auto& State : CompletedAwaiters)
+		{
+			State->Complete(FSGMessageReply(ESGMessageRequestResult::Replied, Context), true);
+		}
+	}
 
 	/**
-	 * Safely releases a message endpoint that is receiving messages on AnyThread.
-	 *
-	 * When an object that owns a message endpoint receiving on AnyThread is being destroyed,
-	 * it is possible that the endpoint can outlive the object for a brief period of time if
-	 * the Messaging system is dispatching messages to it. This helper function
-	 * is to block the calling thread while any messages are being dispatched, so that the
-	 * endpoint does not invoke any message handlers after the object has been destroyed.
+	 * Returns an awaitable for the given request future.
 	 *
-	 * @param Endpoint The message endpoint to release.
+	 * @param Future The future for the reply.
+	 * @return The awaitable.
 	 */
-	static void SafeRelease(TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint)
+	TSGMessageAwaitable<FSGMessageReply> AwaitReply(TFuture<FSGMessageReply>&& Future)
 	{
-		if (Endpoint.IsValid())
+		TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe> State = MakeShared<FSGMessageAwaitState, ESPMode::ThreadSafe>(RecipientThread);
+
+		// replies complete their futures on a router thread
+		Future.Then([State](TFuture<FSGMessageReply> CompletedFuture)
 		{
-			Endpoint->ClearHandlers();
-			Endpoint.Reset();
-		}
+			State->Complete(FSGMessageReply(CompletedFuture.Get()), false);
+		});
+
+		return TSGMessageAwaitable<FSGMessageReply>(State);
 	}
+#endif
 
-protected:
 	/**
-	 * Adds a message handler for the given type of messages (via raw function pointers).
-	 *
-	 * It is legal to configure multiple handlers for the same message type. Each
-	 * handler will be executed when a message of the specified type is received.
-	 *
-	 * This overload is used to register raw class member functions.
+	 * Enters a read-side section of the current handler epoch, in which handler tables aren't deleted.
 	 *
-	 * @param HandlerType The type of the object handling the messages.
-	 * @param MessageType The type of messages to handle.
-	 * @param Handler The class handling the messages.
-	 * @param HandlerFunc The class function handling the messages.
-	 * @return This instance (for method chaining).
-	 * @see WithHandler
+	 * @return The entered epoch.
+	 * @see LeaveHandlers
 	 */
-	template <typename HandlerType>
-	void WithRawMessageHandler(const FName& MessageTag, HandlerType* Handler,
-	                           typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	uint32 EnterHandlers()
 	{
-		WithHandler(
-			MessageTag,
-			MakeShareable(new TSGRawMessageHandler<FSGMessage, HandlerType>(Handler, MoveTemp(HandlerFunc))));
+		uint32 Epoch = HandlerEpoch.load();
+
+		// retry if a writer flipped the epoch in between
+		for (;;)
+		{
+			NumHandlerReaders[Epoch & 1].fetch_add(1);
+
+			const uint32 CurrentEpoch = HandlerEpoch.load();
+
+			if (CurrentEpoch == Epoch)
+			{
+				break;
+			}
+
+			NumHandlerReaders[Epoch & 1].fetch_sub(1);
+			Epoch = CurrentEpoch;
+		}
+
+		++GetHandlerReadDepth();
+
+		return Epoch;
 	}
 
 	/**
-	 * Adds a message handler for the given type of messages (via TFunction object).
-	 *
-	 * It is legal to configure multiple handlers for the same message type. Each
-	 * handler will be executed when a message of the specified type is received.
-	 *
-	 * This overload is used to register functions that are compatible with TFunction
-	 * function objects, such as global and static functions, as well as lambdas.
+	 * Leaves a read-side section of the handler epoch.
 	 *
-	 * @param MessageType The type of messages to handle.
-	 * @param Function The function object handling the messages.
-	 * @return This instance (for method chaining).
-	 * @see WithHandler
+	 * @param Epoch The epoch returned by EnterHandlers.
 	 */
-	void WithFunctionMessageHandler(const FName& MessageTag,
-	                                TSGFunctionMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	void LeaveHandlers(uint32 Epoch)
 	{
-		WithHandler(MessageTag, MakeShareable(new TSGFunctionMessageHandler<FSGMessage>(MoveTemp(HandlerFunc))));
-	}
+		--GetHandlerReadDepth();
 
-	void WithLambdaMessageHandler(const FName& MessageTag,
-	                              TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
-	{
-		WithHandler(MessageTag, MakeShareable(new TSGLambdaMessageHandler<FSGMessage>(MoveTemp(HandlerFunc))));
+		NumHandlerReaders[Epoch & 1].fetch_sub(1);
 	}
 
 	/**
-	 * Registers a message handler with the endpoint.
+	 * Replaces the handler table (called with HandlersCS held).
 	 *
-	 * It is legal to configure multiple handlers for the same message type. Each
-	 * handler will be executed when a message of the specified type is received.
+	 * The previous table is retired, because deliveries may still use it. Retired tables are deleted
+	 * after a grace period, which starts by flipping the epoch and ends when all deliveries that entered
+	 * the old epoch have finished. Writers don't wait for it unless asked to, so slow handlers don't
+	 * block registration; the tables are then deleted by a later writer or the destructor.
 	 *
-	 * @param MessageType
-	 * @param Handler The handler to add.
-	 * @return This instance (for method chaining).
-	 * @see Handling, WithCatchall
+	 * @param NewHandlers The new handler table.
+	 * @param bWaitForReaders Whether to wait until no delivery uses an old table.
 	 */
-	void WithHandler(const FName& MessageTag, const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& Handler)
+	void PublishHandlers(FHandlerTable* NewHandlers, bool bWaitForReaders)
 	{
-		auto& Handlers = HandlerMap.FindOrAdd(MessageTag);
+		RetiredHandlers.Add(Handlers.exchange(NewHandlers));
 
-		Handlers.Add(Handler);
-	}
-	
-	/**
-	 * Clears all handlers in a way that guarantees it won't overlap with message processing. This preserves internal integrity
-	 * of the array and cases where our owner may be shutting down while receiving messages.
-	*/
-	void ClearHandlers()
-	{
-		FScopeLock Lock(&HandlersCS);
-		HandlerMap.Empty();
+		// a delivery on this thread would wait for itself
+		const bool bCanWait = bWaitForReaders && (GetHandlerReadDepth() == 0);
+
+		for (int32 Pass = 0; Pass < 2; ++Pass)
+		{
+			if (!bHandlerGracePending)
+			{
+				if (RetiredHandlers.Num() == 0)
+				{
+					return;
+				}
+
+				HandlerGraceEpoch = HandlerEpoch.fetch_add(1);
+				GraceHandlers = MoveTemp(RetiredHandlers);
+				bHandlerGracePending = true;
+			}
+
+			while (bCanWait && (NumHandlerReaders[HandlerGraceEpoch & 1].load() > 0))
+			{
+				FPlatformProcess::Yield();
+			}
+
+			if (NumHandlerReaders[HandlerGraceEpoch & 1].load() > 0)
+			{
+				return;
+			}
+
+			for (const FHandlerTable* GraceTable : GraceHandlers)
+			{
+				delete GraceTable;
+			}
+
+			GraceHandlers.Reset();
+			bHandlerGracePending = false;
+		}
 	}
 
 	/**
-	 * Gets a shared pointer to the message bus if this endpoint is enabled.
+	 * Adds the bus subscription of a message type, joining the type's consumer group if there is one.
 	 *
-	 * @return The message bus.
+	 * The type's content filter and projection are attached to the subscription.
+	 *
+	 * SubscriptionsCS must be held.
+	 *
+	 * @param Bus The message bus.
+	 * @param MessageType The type name of the messages to subscribe to.
+	 * @param ScopeRange The range of message scopes to include in the subscription.
 	 */
-	FORCEINLINE TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> GetBusIfEnabled() const
+	void AddBusSubscription(ISGMessageBus& Bus, const FName& MessageType, const FSGMessageScopeRange& ScopeRange)
 	{
-		if (Enabled)
+		const TPair<FName, ESGMessageConsumerPolicy>* ConsumerGroup = ConsumerGroups.Find(MessageType);
+		const TSharedRef<const FSGMessageContentFilter, ESPMode::ThreadSafe>* ContentFilter = ContentFilters.Find(MessageType);
+		const TSharedRef<const FSGMessageProjection, ESPMode::ThreadSafe>* Projection = Projections.Find(MessageType);
+
+		if ((ContentFilter != nullptr) || (Projection != nullptr))
 		{
-			return BusPtr.Pin();
-		}
+			const TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe> Filter = (ContentFilter != nullptr) ? TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe>(*ContentFilter) : nullptr;
+			const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe> Selection = (Projection != nullptr) ? TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>(*Projection) : nullptr;
 
-		return nullptr;
+			if (ConsumerGroup != nullptr)
+			{
+				Bus.SubscribeFiltered(AsShared(), MessageType, Filter, ConsumerGroup->Key, ConsumerGroup->Value, ScopeRange, Selection);
+			}
+			else
+			{
+				Bus.SubscribeFiltered(AsShared(), MessageType, Filter, NAME_None, ESGMessageConsumerPolicy::RoundRobin, ScopeRange, Selection);
+			}
+		}
+		else if (ConsumerGroup != nullptr)
+		{
+			Bus.SubscribeToGroup(AsShared(), MessageType, ConsumerGroup->Key, ConsumerGroup->Value, ScopeRange);
+		}
+		else
+		{
+			Bus.Subscribe(AsShared(), MessageType, ScopeRange);
+		}
 	}
 
 	/**
-	 * Forwards the given message context to matching message handlers.
+	 * Replaces the bus subscription of a message type after its consumer group, content filter or projection changed.
 	 *
-	 * @param Context The context of the message to handle.
+	 * SubscriptionsCS must be held.
+	 *
+	 * @param MessageType The type name of the messages.
 	 */
-	void ProcessMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	void ReplaceBusSubscription(const FName& MessageType)
 	{
-		if (!Context->IsValid())
+		const TPair<FName, FSGMessageScopeRange>* Subscription = Subscriptions.FindByPredicate([&MessageType](const TPair<FName, FSGMessageScopeRange>& Candidate) { return Candidate.Key == MessageType; });
+		TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		// both commands go to the same router shard, so the message type stays subscribed
+		if ((Subscription != nullptr) && Active.load(std::memory_order_relaxed) && Bus.IsValid())
 		{
-			return;
+			Bus->Unsubscribe(AsShared(), MessageType);
+			AddBusSubscription(*Bus, MessageType, Subscription->Value);
 		}
+	}
 
-		FScopeLock Lock(&HandlersCS);
+	/** Gets the number of message deliveries the calling thread is currently inside of. */
+	static int32& GetHandlerReadDepth()
+	{
+		static thread_local int32 HandlerReadDepth = 0;
 
-		if (const auto Handlers = HandlerMap.Find(Context->GetMessageType()))
-		{
-			for (int32 HandlerIndex = 0; HandlerIndex < Handlers->Num(); ++HandlerIndex)
-			{
-				(*Handlers)[HandlerIndex]->HandleMessage(Context);
-			}
-		}
+		return HandlerReadDepth;
 	}
 
 private:
@@ -1180,8 +2886,85 @@ private:
 	/** Hold a flag indicating whether this endpoint is active. */
 	bool Enabled;
 
-	/** Holds the registered message handlers. */
-	TMap<FName, TArray<TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe>>> HandlerMap;
+	/** Whether the endpoint is registered with the bus and its subscriptions are on the bus. */
+	std::atomic<bool> Active;
+
+	/** Whether the endpoint is registered with the bus, which it stays while it is disabled (guarded by SubscriptionsCS, except in the destructor). */
+	bool bRegistered = false;
+
+	/** Holds the endpoint's subscriptions, which are registered with the bus while it is active. */
+	TArray<TPair<FName, FSGMessageScopeRange>> Subscriptions;
+
+	/** Guards the subscriptions and the activation. */
+	FCriticalSection SubscriptionsCS;
+
+	/** Holds the consumer groups that subscriptions join, by message type (guarded by SubscriptionsCS). */
+	TMap<FName, TPair<FName, ESGMessageConsumerPolicy>> ConsumerGroups;
+
+	/** Holds the content filters of subscriptions, by message type (guarded by SubscriptionsCS). */
+	TMap<FName, TSharedRef<const FSGMessageContentFilter, ESPMode::ThreadSafe>> ContentFilters;
+
+	/** Holds the projections of subscriptions, by message type (guarded by SubscriptionsCS). */
+	TMap<FName, TSharedRef<const FSGMessageProjection, ESPMode::ThreadSafe>> Projections;
+
+	/** Structure for a registered message handler. */
+	struct FHandlerEntry
+	{
+		/** Holds the handler binding that deliveries call. */
+		FSGStaticMessageHandler Static;
+
+		/** Holds the handler object that the binding refers to (not set for static handlers). */
+		TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe> Handler;
+
+		/** Holds the identifier of the handler in this endpoint (for profiling). */
+		uint32 Id;
+
+		/** Creates an entry for a static handler. */
+		FHandlerEntry(const FSGStaticMessageHandler& InStatic, uint32 InId)
+			: Static(InStatic)
+			, Id(InId)
+		{ }
+
+		/** Creates an entry for a handler object. */
+		FHandlerEntry(const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& InHandler, uint32 InId)
+			: Static(FSGStaticMessageHandler::Bind(&InHandler.Get()))
+			, Handler(InHandler)
+			, Id(InId)
+		{ }
+	};
+
+	/** Structure for a registered topic message handler. */
+	struct FTopicHandlerEntry
+	{
+		/** Holds the topics that the handler handles. */
+		FSGMessageTopicRange TopicRange;
+
+		/** Holds the handler. */
+		TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe> Handler;
+
+		/** Holds the identifier of the handler in this endpoint (for profiling). */
+		uint32 Id;
+
+		/** Creates and initializes a new entry. */
+		FTopicHandlerEntry(const FSGMessageTopicRange& InTopicRange, const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& InHandler, uint32 InId)
+			: TopicRange(InTopicRange)
+			, Handler(InHandler)
+			, Id(InId)
+		{ }
+	};
+
+	/** Structure for an immutable snapshot of the registered handlers. */
+	struct FHandlerTable
+	{
+		/** Holds the registered message handlers, in registration order. */
+		TMap<FName, TArray<FHandlerEntry>> HandlerMap;
+
+		/** Holds the registered topic message handlers. */
+		TArray<FTopicHandlerEntry> TopicHandlers;
+
+		/** Holds the registered batch handlers, which are also in HandlerMap. */
+		TArray<TSharedPtr<ISGMessageBatchHandler, ESPMode::ThreadSafe>> BatchHandlers;
+	};
 
 	/** Holds a delegate that is invoked on disconnection events. */
 	FOnBusNotification NotificationDelegate;
@@ -1189,12 +2972,59 @@ private:
 	/** Holds the endpoint's unique identifier (for debugging purposes). */
 	const FGuid Id;
 
+	/** Holds a flag indicating whether the router queues messages for this endpoint while it isn't registered. */
+	const bool bDurable;
+
 	/** Holds the endpoint's message inbox. */
 	TQueue<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>, EQueueMode::Mpsc> Inbox;
 
 	/** Holds a flag indicating whether the inbox is enabled. */
 	bool InboxEnabled;
 
+	/** Holds the maximum number of queued inbox messages (0 = unlimited). */
+	int32 InboxCapacity;
+
+	/** Holds the policy for messages that arrive while the inbox is full. */
+	ESGMessageBackpressurePolicy InboxPolicy;
+
+	/** Holds the number of queued inbox messages. */
+	std::atomic<int32> NumInboxMessages;
+
+	/** Holds the number of messages the inbox dropped because it was full. */
+	std::atomic<int64> NumDroppedInboxMessages;
+
+	/** Holds the number of inbox messages that were replaced by newer messages with the same conflation key. */
+	std::atomic<int64> NumConflatedInboxMessages;
+
+	/** Holds a flag indicating whether the inbox is congested. */
+	std::atomic<bool> bInboxCongested;
+
+	/** Maps the conflation keys of queued inbox messages to the latest message with that key. */
+	TMap<FSGMessageConflationKey, TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>> ConflatedInboxMessages;
+
+	/** Serializes removals from the inbox (the queue only supports a single consumer) and guards conflated inbox messages. */
+	FCriticalSection InboxCS;
+
+	/** Holds a delegate that is invoked on backpressure events. */
+	FOnSGMessageBackpressure BackpressureDelegate;
+
+	/** Holds the rolling window of handled message latencies (only if latency probes are enabled). */
+	TUniquePtr<FSGMessageLatencyProbe> LatencyProbe;
+
+#if SGMESSAGING_WITH_COROUTINES
+	/** Holds the coroutines awaiting messages, by message type (guarded by AwaitersCS). */
+	TArray<TPair<FName, TSharedRef<FSGMessageAwaitState, ESPMode::ThreadSafe>>> Awaiters;
+
+	/** Holds the number of awaiting coroutines, so that deliveries only take the lock if there are any. */
+	std::atomic<int32> NumAwaiters{0};
+
+	/** Holds the identifier of the next wake-up message of a delay. */
+	std::atomic<uint64> NextWakeId{1};
+
+	/** Serializes access to the awaiting coroutines. */
+	FCriticalSection AwaitersCS;
+#endif
+
 	/** Holds the endpoint's name (for debugging purposes). */
 	const FName Name;
 
@@ -1206,6 +3036,32 @@ private:
 	/** Holds a delegate that is invoked in case of messaging errors. */
 	FOnMessageEndpointError ErrorDelegate;
 
-	/** Sigfnifies that the handler array is being accessed and other threads should wait or skip */
+	/** Serializes changes to the handlers; deliveries don't take it. */
 	FCriticalSection		HandlersCS;
+
+	/** Holds the current handler table, which deliveries read without locking. */
+	std::atomic<FHandlerTable*> Handlers;
+
+	/** Holds the handler epoch, whose parity selects the reader counter that deliveries enter. */
+	std::atomic<uint32> HandlerEpoch;
+
+	/** Holds the number of deliveries in progress per epoch parity. */
+	std::atomic<int32> NumHandlerReaders[2];
+
+	/** Holds the handler tables that were replaced but may still be in use (guarded by HandlersCS). */
+	TArray<FHandlerTable*> RetiredHandlers;
+
+	/** Holds the retired handler tables whose grace period is in progress (guarded by HandlersCS). */
+	TArray<FHandlerTable*> GraceHandlers;
+
+	/** Holds the epoch that the pending grace period waits on (guarded by HandlersCS). */
+	uint32 HandlerGraceEpoch = 0;
+
+	/** Whether a grace period is in progress (guarded by HandlersCS). */
+	bool bHandlerGracePending = false;
+
+	/** Holds the identifier of the next registered handler (guarded by HandlersCS). */
+	uint32 NextHandlerId = 1;
+
+	friend class FSGMessageEndpointMultiplexer;
 };
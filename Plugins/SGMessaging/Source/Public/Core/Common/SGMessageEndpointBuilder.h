@@ -27,7 +27,11 @@ public:
 	FSGMessageEndpointBuilder(const FName& InName)
 		: BusPtr(nullptr)
 		, Disabled(false)
+		, ActivateOnFirstUse(false)
 		, InboxEnabled(false)
+		, InboxCapacity(0)
+		, InboxPolicy(ESGMessageBackpressurePolicy::DropNewest)
+		, Durable(false)
 		, Name(InName)
 		, RecipientThread(FTaskGraphInterface::Get().GetCurrentThreadIfKnown())
 	{ }
@@ -41,7 +45,11 @@ public:
 	FSGMessageEndpointBuilder(const FName& InName, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& InBus)
 		: BusPtr(InBus)
 		, Disabled(false)
+		, ActivateOnFirstUse(false)
 		, InboxEnabled(false)
+		, InboxCapacity(0)
+		, InboxPolicy(ESGMessageBackpressurePolicy::DropNewest)
+		, Durable(false)
 		, Name(InName)
 		, RecipientThread(FTaskGraphInterface::Get().GetCurrentThreadIfKnown())
 	{ }
@@ -54,6 +62,19 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Sets the handler for backpressure notifications from the bus and the endpoint's inbox.
+	 *
+	 * @param InHandler The handler to set.
+	 * @return This instance (for method chaining).
+	 * @see WithInboxCapacity
+	 */
+	FSGMessageEndpointBuilder& BackpressureHandling(FOnSGMessageBackpressure&& InHandler)
+	{
+		OnBackpressure = MoveTemp(InHandler);
+		return *this;
+	}
+
 	/**
 	 * Configures the endpoint to receive messages on any thread.
 	 *
@@ -107,6 +128,40 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Defers registering the endpoint and its subscriptions with the bus.
+	 *
+	 * The endpoint is activated when it is enabled or sends its first message, which keeps dormant
+	 * endpoints (e.g. of pooled actors) out of the router's tables.
+	 *
+	 * @return This instance (for method chaining).
+	 * @see FSGMessageEndpoint::Activate
+	 */
+	FSGMessageEndpointBuilder& ThatActivatesOnFirstUse()
+	{
+		ActivateOnFirstUse = true;
+
+		return *this;
+	}
+
+	/**
+	 * Makes the endpoint durable.
+	 *
+	 * The endpoint gets the stable address of the given name, and messages sent to that address while
+	 * the endpoint isn't registered are queued and delivered when it registers again, e.g. after a restart.
+	 *
+	 * @param DurableName The name that the endpoint's address is derived from (must be unique).
+	 * @return This instance (for method chaining).
+	 * @see FSGMessageAddress::NamedAddress, FSGMessageDurableQueue
+	 */
+	FSGMessageEndpointBuilder& ThatIsDurable(const FString& DurableName)
+	{
+		Durable = true;
+		DurableAddress = FSGMessageAddress::NamedAddress(DurableName);
+
+		return *this;
+	}
+
 	/**
 	 * Enables the endpoint's message inbox.
 	 *
@@ -121,6 +176,23 @@ public:
 		return *this;
 	}
 
+	/**
+	 * Enables the endpoint's message inbox and limits the number of messages it can hold.
+	 *
+	 * @param Capacity The maximum number of queued messages (0 = unlimited).
+	 * @param Policy How to treat messages that arrive while the inbox is full (Block isn't supported by inboxes).
+	 * @return This instance (for method chaining).
+	 * @see BackpressureHandling, WithInbox
+	 */
+	FSGMessageEndpointBuilder& WithInboxCapacity(int32 Capacity, ESGMessageBackpressurePolicy Policy = ESGMessageBackpressurePolicy::DropNewest)
+	{
+		InboxEnabled = true;
+		InboxCapacity = Capacity;
+		InboxPolicy = Policy;
+
+		return *this;
+	}
+
 public:
 
 	/**
@@ -135,10 +207,21 @@ public:
 		
 		if (Bus.IsValid())
 		{
-			Endpoint = MakeShared<FSGMessageEndpoint, ESPMode::ThreadSafe>(Name, Bus.ToSharedRef(), OnNotification);
-			Bus->Register(Endpoint->GetAddress(), Endpoint.ToSharedRef());
+			if (Durable)
+			{
+				Endpoint = MakeShared<FSGMessageEndpoint, ESPMode::ThreadSafe>(Name, Bus.ToSharedRef(), OnNotification, DurableAddress, true);
+			}
+			else
+			{
+				Endpoint = MakeShared<FSGMessageEndpoint, ESPMode::ThreadSafe>(Name, Bus.ToSharedRef(), OnNotification);
+			}
+
+			if (OnBackpressure.IsBound())
+			{
+				Endpoint->SetBackpressureHandler(OnBackpressure);
+			}
 
-			if (OnNotification.IsBound())
+			if (OnNotification.IsBound() || OnBackpressure.IsBound())
 			{
 				Bus->AddNotificationListener(Endpoint.ToSharedRef());
 			}
@@ -151,12 +234,19 @@ public:
 			if (InboxEnabled)
 			{
 				Endpoint->EnableInbox();
+				Endpoint->SetInboxCapacity(InboxCapacity, InboxPolicy);
 				Endpoint->SetRecipientThread(ENamedThreads::AnyThread);
 			}
 			else
 			{
 				Endpoint->SetRecipientThread(RecipientThread);
 			}
+
+			// the recipient thread must be set before messages can arrive
+			if (!Disabled && !ActivateOnFirstUse)
+			{
+				Endpoint->Activate();
+			}
 		}
 
 		return Endpoint;
@@ -180,12 +270,30 @@ private:
 	/** Holds a flag indicating whether the endpoint should be disabled. */
 	bool Disabled;
 
+	/** Holds a flag indicating whether the endpoint should be activated on first use. */
+	bool ActivateOnFirstUse;
+
 	/** Holds a delegate to invoke on disconnection event. */
 	FOnBusNotification OnNotification;
 
+	/** Holds a delegate to invoke on backpressure events. */
+	FOnSGMessageBackpressure OnBackpressure;
+
 	/** Holds a flag indicating whether the inbox should be enabled. */
 	bool InboxEnabled;
 
+	/** Holds the maximum number of messages the inbox can hold (0 = unlimited). */
+	int32 InboxCapacity;
+
+	/** Holds the policy for messages that arrive while the inbox is full. */
+	ESGMessageBackpressurePolicy InboxPolicy;
+
+	/** Holds a flag indicating whether the endpoint should be durable. */
+	bool Durable;
+
+	/** Holds the stable address of a durable endpoint. */
+	FSGMessageAddress DurableAddress;
+
 	/** Holds the endpoint's name (for debugging purposes). */
 	FName Name;
 
@@ -0,0 +1,362 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Common/SGMessageEndpoint.h"
+#include "Core/Common/SGMessageHandlers.h"
+
+/**
+ * Implements lightweight subscribers that share one message endpoint.
+ *
+ * Each subscriber registers its handlers under an owner key instead of creating an endpoint of its
+ * own, so it costs no address, router registration or inbox. The shared endpoint subscribes to a
+ * message type once and dispatches received messages to the handlers of all owners. Owners that
+ * need to be the target of sent messages get an address on demand, which is registered with the bus
+ * for the shared endpoint, and directed messages are only dispatched to the owners they were sent to.
+ * Messages sent to the shared endpoint or to an address group reach all owners.
+ *
+ * The multiplexer must be created as a shared pointer, and it must be used on the thread that the
+ * shared endpoint receives messages on.
+ *
+ * @see FSGMessageEndpoint
+ */
+class FSGMessageEndpointMultiplexer
+	: public TSharedFromThis<FSGMessageEndpointMultiplexer, ESPMode::ThreadSafe>
+{
+public:
+	/**
+	 * Creates and initializes a new multiplexer.
+	 *
+	 * @param InEndpoint The endpoint to share.
+	 */
+	explicit FSGMessageEndpointMultiplexer(const TSharedRef<FSGMessageEndpoint, ESPMode::ThreadSafe>& InEndpoint)
+		: EndpointPtr(InEndpoint)
+		, BusPtr(InEndpoint->BusPtr)
+		, DispatchDepth(0)
+	{
+	}
+
+	/** Destructor. */
+	~FSGMessageEndpointMultiplexer()
+	{
+		const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (Bus.IsValid())
+		{
+			for (const auto& OwnerAddress : OwnerAddresses)
+			{
+				Bus->Unregister(OwnerAddress.Value);
+			}
+		}
+	}
+
+public:
+	/**
+	 * Subscribes an owner's handler for messages with the given tag.
+	 *
+	 * @param Owner The key of the subscriber (usually the object that owns the handler).
+	 * @param MessageTag The message tag to subscribe to.
+	 * @param Handler The handler to add.
+	 * @see RemoveOwner
+	 */
+	void Subscribe(const void* Owner, const FName& MessageTag, const TSharedRef<ISGMessageHandler, ESPMode::ThreadSafe>& Handler)
+	{
+		check(Owner != nullptr);
+
+		if (DispatchDepth > 0)
+		{
+			// the handler arrays may be iterated further up the stack
+			PendingSubscriptions.Emplace(MessageTag, FSubHandler(Owner, Handler));
+
+			return;
+		}
+
+		AddSubHandler(MessageTag, FSubHandler(Owner, Handler));
+	}
+
+	template <typename HandlerType>
+	void Subscribe(const void* Owner, MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
+	               typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
+	{
+		Subscribe(Owner, FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE),
+		          MakeShareable(new TSGRawMessageHandler<FSGMessage, HandlerType>(Handler, MoveTemp(HandlerFunc))));
+	}
+
+	void Subscribe(const void* Owner, MESSAGE_TAG_PARAM_SIGNATURE, TSGLambdaMessageHandler<FSGMessage>::FuncType HandlerFunc)
+	{
+		Subscribe(Owner, FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE),
+		          MakeShareable(new TSGLambdaMessageHandler<FSGMessage>(MoveTemp(HandlerFunc))));
+	}
+
+	/**
+	 * Removes all handlers of an owner and releases its address.
+	 *
+	 * @param Owner The key of the subscriber.
+	 * @see Subscribe
+	 */
+	void RemoveOwner(const void* Owner)
+	{
+		PendingSubscriptions.RemoveAll([Owner](const TPair<FName, FSubHandler>& Pending)
+		{
+			return Pending.Value.Owner == Owner;
+		});
+
+		TArray<FName> Tags;
+
+		if (OwnerTags.RemoveAndCopyValue(Owner, Tags))
+		{
+			for (const FName& Tag : Tags)
+			{
+				if (TArray<FSubHandler>* Handlers = SubHandlers.Find(Tag))
+				{
+					RemoveSubHandlers(Tag, *Handlers, Owner);
+				}
+			}
+		}
+
+		FSGMessageAddress Address;
+
+		if (OwnerAddresses.RemoveAndCopyValue(Owner, Address))
+		{
+			AddressOwners.Remove(Address);
+
+			const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+			if (Bus.IsValid())
+			{
+				Bus->Unregister(Address);
+			}
+		}
+	}
+
+	/**
+	 * Gets the address of an owner, registering one with the bus the first time.
+	 *
+	 * @param Owner The key of the subscriber.
+	 * @return The address, or an invalid address if the endpoint or the bus was destroyed.
+	 */
+	FSGMessageAddress GetAddress(const void* Owner)
+	{
+		check(Owner != nullptr);
+
+		if (const FSGMessageAddress* Address = OwnerAddresses.Find(Owner))
+		{
+			return *Address;
+		}
+
+		const TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> Endpoint = EndpointPtr.Pin();
+		const TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus = BusPtr.Pin();
+
+		if (!Endpoint.IsValid() || !Bus.IsValid())
+		{
+			return FSGMessageAddress();
+		}
+
+		const FSGMessageAddress Address = FSGMessageAddress::NewAddress();
+
+		Bus->Register(Address, Endpoint.ToSharedRef());
+
+		OwnerAddresses.Add(Owner, Address);
+		AddressOwners.Add(Address, Owner);
+
+		return Address;
+	}
+
+	/**
+	 * Gets the number of owners that have handlers.
+	 *
+	 * @return Number of owners.
+	 */
+	int32 GetNumOwners() const
+	{
+		return OwnerTags.Num();
+	}
+
+private:
+	/** Structure for a handler of an owner. */
+	struct FSubHandler
+	{
+		/** The key of the owner. */
+		const void* Owner;
+
+		/** The handler, or nullptr if it was removed while dispatching. */
+		TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe> Handler;
+
+		FSubHandler(const void* InOwner, const TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe>& InHandler)
+			: Owner(InOwner)
+			, Handler(InHandler)
+		{
+		}
+	};
+
+	/** Adds a handler and subscribes the shared endpoint to its tag if needed. */
+	void AddSubHandler(const FName& MessageTag, FSubHandler&& SubHandler)
+	{
+		const TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> Endpoint = EndpointPtr.Pin();
+
+		if (!Endpoint.IsValid())
+		{
+			return;
+		}
+
+		TArray<FSubHandler>& Handlers = SubHandlers.FindOrAdd(MessageTag);
+
+		if (Handlers.Num() == 0)
+		{
+			if (!DispatchedTags.Contains(MessageTag))
+			{
+				// the endpoint's handler can't be removed, so it is kept when the last owner leaves
+				TWeakPtr<FSGMessageEndpointMultiplexer, ESPMode::ThreadSafe> WeakThis = AsShared();
+
+				Endpoint->WithLambdaMessageHandler(MessageTag, [WeakThis](FSGMessage*, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+				{
+					if (const TSharedPtr<FSGMessageEndpointMultiplexer, ESPMode::ThreadSafe> This = WeakThis.Pin())
+					{
+						This->Dispatch(Context);
+					}
+				});
+
+				DispatchedTags.Add(MessageTag);
+			}
+
+			Endpoint->Subscribe(MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+		}
+
+		TArray<FName>& Tags = OwnerTags.FindOrAdd(SubHandler.Owner);
+		Tags.AddUnique(MessageTag);
+
+		Handlers.Add(MoveTemp(SubHandler));
+	}
+
+	/** Removes the handlers of an owner (or only the removed ones if nullptr) and unsubscribes the shared endpoint when none is left. */
+	void RemoveSubHandlers(const FName& MessageTag, TArray<FSubHandler>& Handlers, const void* Owner)
+	{
+		if (DispatchDepth > 0)
+		{
+			for (FSubHandler& SubHandler : Handlers)
+			{
+				if (SubHandler.Owner == Owner)
+				{
+					SubHandler.Handler.Reset();
+				}
+			}
+
+			CompactTags.AddUnique(MessageTag);
+
+			return;
+		}
+
+		// handlers removed while dispatching are dropped as well
+		Handlers.RemoveAll([Owner](const FSubHandler& SubHandler)
+		{
+			return (SubHandler.Owner == Owner) || !SubHandler.Handler.IsValid();
+		});
+
+		if (Handlers.Num() == 0)
+		{
+			SubHandlers.Remove(MessageTag);
+
+			if (const TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> Endpoint = EndpointPtr.Pin())
+			{
+				Endpoint->Unsubscribe(MessageTag);
+			}
+		}
+	}
+
+	/** Dispatches a message received by the shared endpoint to the handlers of its recipients. */
+	void Dispatch(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		const TArray<FSubHandler>* Handlers = SubHandlers.Find(Context->GetMessageType());
+
+		if (Handlers == nullptr)
+		{
+			return;
+		}
+
+		const TArrayView<const FSGMessageAddress> Recipients = Context->GetRecipients();
+
+		// published messages and messages that weren't sent to owner addresses reach all owners
+		TArray<const void*, TInlineAllocator<4>> RecipientOwners;
+
+		for (const FSGMessageAddress& Recipient : Recipients)
+		{
+			if (const void* const* Owner = AddressOwners.Find(Recipient))
+			{
+				RecipientOwners.Add(*Owner);
+			}
+		}
+
+		++DispatchDepth;
+
+		for (int32 HandlerIndex = 0; HandlerIndex < Handlers->Num(); ++HandlerIndex)
+		{
+			const FSubHandler& SubHandler = (*Handlers)[HandlerIndex];
+
+			if (SubHandler.Handler.IsValid() && ((RecipientOwners.Num() == 0) || RecipientOwners.Contains(SubHandler.Owner)))
+			{
+				// hold the handler, its owner may be removed by the handler itself
+				const TSharedPtr<ISGMessageHandler, ESPMode::ThreadSafe> Handler = SubHandler.Handler;
+
+				Handler->HandleMessage(Context);
+			}
+		}
+
+		if (--DispatchDepth == 0)
+		{
+			ApplyPendingChanges();
+		}
+	}
+
+	/** Applies the changes that were deferred while dispatching. */
+	void ApplyPendingChanges()
+	{
+		for (const FName& Tag : CompactTags)
+		{
+			if (TArray<FSubHandler>* Handlers = SubHandlers.Find(Tag))
+			{
+				RemoveSubHandlers(Tag, *Handlers, nullptr);
+			}
+		}
+
+		CompactTags.Empty();
+
+		TArray<TPair<FName, FSubHandler>> Subscriptions = MoveTemp(PendingSubscriptions);
+
+		for (TPair<FName, FSubHandler>& Subscription : Subscriptions)
+		{
+			AddSubHandler(Subscription.Key, MoveTemp(Subscription.Value));
+		}
+	}
+
+private:
+	/** Holds the shared endpoint. */
+	TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> EndpointPtr;
+
+	/** Holds the message bus. */
+	TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> BusPtr;
+
+	/** Holds the owners' handlers by message tag. */
+	TMap<FName, TArray<FSubHandler>> SubHandlers;
+
+	/** Holds the message tags of each owner. */
+	TMap<const void*, TArray<FName>> OwnerTags;
+
+	/** Holds the addresses of owners that can receive sent messages. */
+	TMap<const void*, FSGMessageAddress> OwnerAddresses;
+
+	/** Holds the owners by address. */
+	TMap<FSGMessageAddress, const void*> AddressOwners;
+
+	/** Holds the tags that the shared endpoint has a dispatching handler for. */
+	TSet<FName> DispatchedTags;
+
+	/** Holds the subscriptions that were made while dispatching. */
+	TArray<TPair<FName, FSubHandler>> PendingSubscriptions;
+
+	/** Holds the tags with handlers that were removed while dispatching. */
+	TArray<FName> CompactTags;
+
+	/** The depth of nested dispatches. */
+	int32 DispatchDepth;
+};
@@ -3,8 +3,53 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Core/Interface/ISGMessage.h"
 #include "Core/Interface/ISGMessageContext.h"
 #include "Core/Interface/ISGMessageHandler.h"
+#include "Core/Message/SGMessageTypeRegistry.h"
+#include "Misc/ScopeLock.h"
+
+
+namespace SGMessageHandlers
+{
+	/**
+	 * Gets the message of a context as the type that a handler expects.
+	 *
+	 * Any message may be published with any tag, so tagged messages (FSGMessage and TSGTypedMessage) are
+	 * checked by their name, and struct handlers never get tagged messages. Mismatches are dropped and
+	 * reported through FSGMessageTypeRegistry::ReportMismatchedMessage.
+	 *
+	 * @param MessageType The type that the handler expects.
+	 * @param Context The context of the message to handle.
+	 * @return The message, or nullptr if it is of another type.
+	 */
+	template <typename MessageType>
+	const MessageType* CastMessage(const ISGMessageContext& Context)
+	{
+		const ISGMessage* TaggedMessage = Context.GetTaggedMessage();
+
+		if constexpr (TIsDerivedFrom<MessageType, ISGMessage>::Value)
+		{
+			if ((TaggedMessage != nullptr) && (TaggedMessage->GetFName() == MessageType::StaticMessageName()))
+			{
+				return static_cast<const MessageType*>(TaggedMessage);
+			}
+
+			FSGMessageTypeRegistry::Get().ReportMismatchedMessage(Context, MessageType::StaticMessageName());
+		}
+		else
+		{
+			if ((TaggedMessage == nullptr) && (Context.GetMessage() != nullptr))
+			{
+				return static_cast<const MessageType*>(Context.GetMessage());
+			}
+
+			FSGMessageTypeRegistry::Get().ReportMismatchedMessage(Context, Context.GetMessageType());
+		}
+
+		return nullptr;
+	}
+}
 
 
 /**
@@ -97,7 +142,10 @@ public:
 	
 	virtual void HandleMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
 	{
-		(Handler->*Func)(*static_cast<const MessageType*>(Context->GetMessage()), Context);
+		if (const MessageType* Message = SGMessageHandlers::CastMessage<MessageType>(*Context))
+		{
+			(Handler->*Func)(*Message, Context);
+		}
 	}
 	
 private:
@@ -185,7 +233,10 @@ public:
 	
 	virtual void HandleMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
 	{
-		Func(*static_cast<const MessageType*>(Context->GetMessage()), Context);
+		if (const MessageType* Message = SGMessageHandlers::CastMessage<MessageType>(*Context))
+		{
+			Func(*Message, Context);
+		}
 	}
 	
 private:
@@ -228,10 +279,204 @@ public:
 
 	virtual void HandleMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
 	{
-		Func(static_cast<MessageType*>(const_cast<void*>(Context->GetMessage())), Context);
+		if (const MessageType* Message = SGMessageHandlers::CastMessage<MessageType>(*Context))
+		{
+			Func(const_cast<MessageType*>(Message), Context);
+		}
 	}
 
 private:
 	/** Holds a pointer to the actual handler function. */
 	FuncType Func;
 };
+
+/**
+ * Template for the traits of member functions that can be bound as static message handlers.
+ *
+ * @param FuncType The type of the member function pointer.
+ */
+template <typename FuncType>
+struct TSGStaticMessageHandlerTraits;
+
+template <typename InHandlerType, typename InMessageType>
+struct TSGStaticMessageHandlerTraits<void (InHandlerType::*)(const InMessageType&, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&)>
+{
+	typedef InHandlerType HandlerType;
+	typedef InMessageType MessageType;
+};
+
+/**
+ * Structure for a message handler that is bound at compile time.
+ *
+ * The member function is a template argument of the thunk, so calling the handler costs one indirect
+ * call, without virtual dispatch or shared pointers. Handlers registered as ISGMessageHandler are
+ * called through the same structure, with a thunk that forwards to HandleMessage.
+ */
+struct FSGStaticMessageHandler
+{
+	/** Type definition for the functions that call a bound handler. */
+	typedef void (*FuncType)(void*, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&);
+
+	/** Holds the object handling the messages. */
+	void* Object = nullptr;
+
+	/** Holds the function that calls the object. */
+	FuncType Func = nullptr;
+
+	/**
+	 * Calls the bound handler.
+	 *
+	 * @param Context The context of the message to handle.
+	 */
+	FORCEINLINE void Invoke(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) const
+	{
+		Func(Object, Context);
+	}
+
+	/**
+	 * Binds a member function to an object.
+	 *
+	 *		FSGStaticMessageHandler::Bind<&FMyClass::HandleFoo>(this)
+	 *
+	 * @param HandlerFunc The member function handling the messages.
+	 * @param Handler The object handling the messages.
+	 * @return The bound handler.
+	 */
+	template <auto HandlerFunc>
+	static FSGStaticMessageHandler Bind(typename TSGStaticMessageHandlerTraits<decltype(HandlerFunc)>::HandlerType* Handler)
+	{
+		check(Handler != nullptr);
+
+		return FSGStaticMessageHandler{ Handler, &CallMember<HandlerFunc> };
+	}
+
+	/**
+	 * Binds a message handler object.
+	 *
+	 * @param Handler The handler (must outlive the binding).
+	 * @return The bound handler.
+	 */
+	static FSGStaticMessageHandler Bind(ISGMessageHandler* Handler)
+	{
+		return FSGStaticMessageHandler{ Handler, &CallHandler };
+	}
+
+private:
+	template <auto HandlerFunc>
+	static void CallMember(void* Object, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		typedef TSGStaticMessageHandlerTraits<decltype(HandlerFunc)> FTraits;
+
+		if (const typename FTraits::MessageType* Message = SGMessageHandlers::CastMessage<typename FTraits::MessageType>(*Context))
+		{
+			(static_cast<typename FTraits::HandlerType*>(Object)->*HandlerFunc)(*Message, Context);
+		}
+	}
+
+	static void CallHandler(void* Object, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	{
+		static_cast<ISGMessageHandler*>(Object)->HandleMessage(Context);
+	}
+};
+
+/**
+ * Implements a handler that receives the collected messages of one tag as an array (via function objects).
+ *
+ * Messages may be collected on several threads, but the function is never called concurrently.
+ */
+class FSGBatchMessageHandler
+	: public ISGMessageBatchHandler
+{
+public:
+	/** Type definition for function objects that are compatible with this FSGBatchMessageHandler. */
+	typedef TFunction<void(TArrayView<const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>>)> FuncType;
+
+public:
+	/**
+	 * Creates and initializes a new message handler.
+	 *
+	 * @param InFunc The function handling the messages.
+	 * @param InMaxBatchSize The number of messages after which the batch is handled right away (0 = unlimited).
+	 */
+	FSGBatchMessageHandler(FuncType InFunc, int32 InMaxBatchSize = 0)
+		: Func(MoveTemp(InFunc))
+		, MaxBatchSize(FMath::Max(InMaxBatchSize, 0))
+	{
+	}
+
+	/** Virtual destructor. */
+	~FSGBatchMessageHandler()
+	{
+	}
+
+public:
+	//~ ISGMessageHandler interface
+
+	virtual void HandleMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) override
+	{
+		bool bBatchFull;
+		{
+			FScopeLock Lock(&PendingCS);
+
+			Pending.Add(Context);
+			bBatchFull = (MaxBatchSize > 0) && (Pending.Num() >= MaxBatchSize);
+		}
+
+		if (bBatchFull)
+		{
+			FlushMessages();
+		}
+	}
+
+	//~ ISGMessageBatchHandler interface
+
+	virtual void FlushMessages() override
+	{
+		// handlers may publish messages that are collected by this handler again, which go into the next batch
+		FScopeLock FlushLock(&FlushCS);
+
+		TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Batch;
+		{
+			FScopeLock Lock(&PendingCS);
+
+			if (Pending.Num() == 0)
+			{
+				return;
+			}
+
+			Batch = MoveTemp(Pending);
+			Pending = MoveTemp(Spare);
+		}
+
+		Func(Batch);
+
+		Batch.Reset();
+
+		// keep the allocation for the next batch
+		FScopeLock Lock(&PendingCS);
+
+		if (Spare.Max() == 0)
+		{
+			Spare = MoveTemp(Batch);
+		}
+	}
+
+private:
+	/** Holds a pointer to the actual handler function. */
+	FuncType Func;
+
+	/** Holds the number of messages after which the batch is handled right away (0 = unlimited). */
+	int32 MaxBatchSize;
+
+	/** Holds the messages collected since the last flush. */
+	TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Pending;
+
+	/** Holds an empty array that keeps the allocation of a handled batch. */
+	TArray<TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Spare;
+
+	/** Guards the collected messages. */
+	FCriticalSection PendingCS;
+
+	/** Serializes calls to the handler function. */
+	FCriticalSection FlushCS;
+};
@@ -1,10 +1,26 @@
 #pragma once
 
+#include "Core/Bus/SGMessagePool.h"
+
 class ISGMessage
 {
 public:
 	virtual FName GetFName() const = 0;
 
+	/**
+	 * Destroys the message and frees its memory.
+	 *
+	 * Called by the message context that owns a tagged message when the last reference to it is released.
+	 * The default implementation runs the destructor and returns the memory to the message pool, which
+	 * requires ISGMessage to be the message's first base and the message to come from the pool or FMemory.
+	 */
+	virtual void Release()
+	{
+		this->~ISGMessage();
+
+		FSGMessagePool::Free(this);
+	}
+
 public:
 	virtual ~ISGMessage()
 	{
@@ -2,9 +2,154 @@
 
 #pragma once
 
+#include "CoreMinimal.h"
+#include "Templates/UniquePtr.h"
+
 class FArchive;
 
 
+/**
+ * Interface for chunk readers of message attachments.
+ *
+ * Chunk readers give random access to an attachment's data without loading all of it into memory,
+ * so that large attachments can be streamed in chunks of any size alongside other traffic.
+ *
+ * @see FSGMessageAttachmentChunkIterator, ISGMessageAttachment
+ */
+class ISGMessageAttachmentChunkReader
+{
+public:
+
+	/**
+	 * Gets the size of the attachment's data.
+	 *
+	 * @return The size (in bytes).
+	 */
+	virtual int64 GetSize() const = 0;
+
+	/**
+	 * Reads a chunk of the attachment's data.
+	 *
+	 * The chunk may point into memory-mapped data instead of a copy, and it remains valid until
+	 * the next call or until the reader is destroyed.
+	 *
+	 * @param Offset The offset of the chunk (in bytes).
+	 * @param Size The size of the chunk (in bytes), which is clamped to the end of the data.
+	 * @param OutChunk Will hold the chunk.
+	 * @return true if the chunk was read, false if the offset is out of range or the data can't be read.
+	 */
+	virtual bool ReadChunk(int64 Offset, int32 Size, TArrayView<const uint8>& OutChunk) = 0;
+
+public:
+
+	/** Virtual destructor. */
+	virtual ~ISGMessageAttachmentChunkReader() { }
+};
+
+
+/**
+ * Iterates over the data of a message attachment in chunks of a fixed size.
+ *
+ * @see ISGMessageAttachmentChunkReader
+ */
+class FSGMessageAttachmentChunkIterator
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance, reading the first chunk.
+	 *
+	 * @param InReader The chunk reader of the attachment.
+	 * @param InChunkSize The size of the chunks (in bytes).
+	 */
+	FSGMessageAttachmentChunkIterator(ISGMessageAttachmentChunkReader& InReader, int32 InChunkSize)
+		: Reader(InReader)
+		, ChunkSize(FMath::Max(InChunkSize, 1))
+		, Offset(0)
+		, bError(false)
+	{
+		ReadChunk();
+	}
+
+public:
+
+	/** Advances to the next chunk. */
+	FSGMessageAttachmentChunkIterator& operator++()
+	{
+		Offset += Chunk.Num();
+		ReadChunk();
+
+		return *this;
+	}
+
+	/** Checks whether the iterator points to a chunk. */
+	explicit operator bool() const
+	{
+		return !bError && (Chunk.Num() > 0);
+	}
+
+	/**
+	 * Gets the current chunk, which is valid until the iterator advances.
+	 *
+	 * @return The chunk.
+	 */
+	TArrayView<const uint8> GetChunk() const
+	{
+		return Chunk;
+	}
+
+	/**
+	 * Gets the offset of the current chunk.
+	 *
+	 * @return The offset (in bytes).
+	 */
+	int64 GetOffset() const
+	{
+		return Offset;
+	}
+
+	/**
+	 * Checks whether the iteration stopped because the data couldn't be read.
+	 *
+	 * @return true on errors, false otherwise.
+	 */
+	bool IsError() const
+	{
+		return bError;
+	}
+
+private:
+
+	/** Reads the chunk at the current offset. */
+	void ReadChunk()
+	{
+		Chunk = TArrayView<const uint8>();
+
+		if (!bError && (Offset < Reader.GetSize()))
+		{
+			bError = !Reader.ReadChunk(Offset, ChunkSize, Chunk);
+		}
+	}
+
+private:
+
+	/** Holds the chunk reader. */
+	ISGMessageAttachmentChunkReader& Reader;
+
+	/** Holds the size of the chunks. */
+	int32 ChunkSize;
+
+	/** Holds the offset of the current chunk. */
+	int64 Offset;
+
+	/** Holds the current chunk. */
+	TArrayView<const uint8> Chunk;
+
+	/** Holds a flag indicating whether the data couldn't be read. */
+	bool bError;
+};
+
+
 /**
  * Interface for message attachments.
  *
@@ -33,6 +178,24 @@ public:
 	 */
 	virtual FArchive* CreateReader() = 0;
 
+	/**
+	 * Creates a chunk reader to the data.
+	 *
+	 * Unlike the archive reader, the chunk reader doesn't need to load the data into memory.
+	 *
+	 * @return A chunk reader, or nullptr if the data can't be read.
+	 * @see GetSize
+	 */
+	virtual TUniquePtr<ISGMessageAttachmentChunkReader> CreateChunkReader() = 0;
+
+	/**
+	 * Gets the size of the data.
+	 *
+	 * @return The size (in bytes), or -1 if the data can't be read.
+	 * @see CreateChunkReader
+	 */
+	virtual int64 GetSize() = 0;
+
 public:
 
 	/** Virtual destructor. */
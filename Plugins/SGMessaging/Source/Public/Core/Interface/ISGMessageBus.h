@@ -7,6 +7,8 @@
 #include "Templates/SharedPointer.h"
 
 class FName;
+class FSGMessageContentFilter;
+class FSGMessageProjection;
 class ISGMessageAttachment;
 class ISGMessageContext;
 class ISGMessageInterceptor;
@@ -18,17 +20,91 @@ class ISGBusListener;
 class UScriptStruct;
 
 enum class ESGMessageBusNotification : uint8;
+enum class ESGMessageConsumerPolicy : uint8;
 enum class ESGMessageScope : uint8;
 enum class ESGMessageFlags : uint32;
 
 struct FDateTime;
 struct FSGMessageAddress;
+struct FSGMessageBatchEntry;
+struct FSGMessageReply;
+struct FSGMessageSpatialInterest;
 struct FTimespan;
 
+template<typename ResultType> class TFuture;
+
+
+/**
+ * Enumerates policies for the messages that are queued when a message bus shuts down.
+ *
+ * @see ISGMessageBus::ShutdownAsync
+ */
+enum class ESGMessageBusShutdownPolicy : uint8
+{
+	/** Route the queued messages before the router threads exit. */
+	Drain,
+
+	/** Drop the queued messages. */
+	Discard
+};
+
 
 /** Delegate type for message bus shutdowns. */
 DECLARE_MULTICAST_DELEGATE(FOnMessageBusShutdown);
 
+/** Delegate type for changes of the message types that local subscribers receive from other processes. */
+DECLARE_MULTICAST_DELEGATE(FOnMessageBusInterestChanged);
+
+
+/**
+ * Handle to a delayed message.
+ *
+ * Returned by the Publish and Send methods. If the message was sent with a delay, and delayed
+ * messaging is allowed, the handle can be used to cancel it before it is dispatched. Otherwise
+ * the message is dispatched right away, and the handle is invalid.
+ *
+ * @see ISGMessageBus::CancelDelayedMessage, ISGMessageBus::SchedulePeriodic
+ */
+struct FSGDelayedMessageHandle
+{
+	/** Holds the handle's identifier (0 = invalid). */
+	uint64 Id = 0;
+
+	/** Default constructor. */
+	FSGDelayedMessageHandle() = default;
+
+	/** Creates and initializes a new instance. */
+	explicit FSGDelayedMessageHandle(uint64 InId)
+		: Id(InId)
+	{ }
+
+	/**
+	 * Checks whether this handle refers to a delayed message.
+	 *
+	 * @return true if the handle is valid, false otherwise.
+	 */
+	bool IsValid() const
+	{
+		return (Id != 0);
+	}
+
+	/** Invalidates this handle. */
+	void Invalidate()
+	{
+		Id = 0;
+	}
+
+	bool operator==(const FSGDelayedMessageHandle& Other) const
+	{
+		return (Id == Other.Id);
+	}
+
+	bool operator!=(const FSGDelayedMessageHandle& Other) const
+	{
+		return (Id != Other.Id);
+	}
+};
+
 
 /**
  * Interface for message buses.
@@ -113,6 +189,29 @@ class ISGMessageBus
 {
 public:
 
+	/**
+	 * Cancels a delayed message that has not been dispatched yet.
+	 *
+	 * Cancelling a message that was already dispatched, or was sent without delay, has no effect.
+	 * Cancelling a periodic message stops its schedule.
+	 *
+	 * @param Handle The handle returned when the message was published or sent.
+	 * @see Publish, Send
+	 */
+	virtual void CancelDelayedMessage(const FSGDelayedMessageHandle& Handle) = 0;
+
+	/**
+	 * Completes the pending request of a request message that a recipient dropped.
+	 *
+	 * Recipients call this when they can't queue a request, i.e. because their inbox is full, so
+	 * that the requester doesn't wait for a reply that can't arrive. The request is completed as
+	 * dropped. Messages that aren't requests are ignored.
+	 *
+	 * @param Context The context of the dropped message.
+	 * @see Request
+	 */
+	virtual void DropRequest(const ISGMessageContext& Context) = 0;
+
 	/**
 	 * Forwards a previously received message.
 	 *
@@ -124,7 +223,21 @@ public:
 	 * @param Forwarder The sender that forwards the message.
 	 * @see Publish, Send
 	 */
-	virtual void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Forwarder) = 0;
+	virtual void Forward(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Forwarder) = 0;
+
+	/**
+	 * Delivers a previously received message to a local recipient again after a delay.
+	 *
+	 * Unlike Forward, the message keeps its context and is handed to the recipient when it is due,
+	 * without being intercepted or routed again. Messages that expire in the meantime are dropped,
+	 * and so are messages whose recipient unregisters.
+	 *
+	 * @param Context The context of the message to deliver again.
+	 * @param Recipient The address of the local recipient.
+	 * @param Delay The time after which to deliver the message.
+	 * @see Forward
+	 */
+	virtual void Redeliver(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const FSGMessageAddress& Recipient, const FTimespan& Delay) = 0;
 
 	/**
 	 * Gets the message bus tracer.
@@ -155,14 +268,70 @@ public:
 	 * @param Delay The delay after which to send the message.
 	 * @param Expiration The time at which the message expires.
 	 * @param Publisher The message publisher.
-	 * @see Forward, Send
+	 * @return Handle to the delayed message (invalid if the message is not delayed or delayed messaging is disabled).
+	 * @see CancelDelayedMessage, Forward, Send
 	 */
-	virtual void Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const TMap<FName, FString>& Annotations, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
+	virtual FSGDelayedMessageHandle Publish(void* Message, UScriptStruct* TypeInfo, ESGMessageScope Scope, const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
+
+	/**
+	 * Sends a tagged message to subscribed recipients.
+	 *
+	 * @param MessageTag The message tag (used as the message type).
+	 * @param Message The message to publish (an ISGMessage, which the bus destroys via ISGMessage::Release).
+	 * @param Scope The message scope.
+	 * @param Annotations An optional message annotations header.
+	 * @param Delay The delay after which to send the message.
+	 * @param Expiration The time at which the message expires.
+	 * @param Flags The message flags (i.e. the message priority).
+	 * @param Publisher The message publisher.
+	 * @return Handle to the delayed message (invalid if the message is not delayed or delayed messaging is disabled).
+	 */
+	virtual FSGDelayedMessageHandle Publish(const FName& MessageTag, void* Message, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
+
+	/**
+	 * Sends a batch of tagged messages to subscribed recipients.
+	 *
+	 * The messages share their scope, annotations, delay, expiration and flags, and are routed in
+	 * order with a single router command per router shard. Batched messages always go through the
+	 * router thread, and can't be cancelled individually.
+	 *
+	 * @param Messages The messages to publish (the bus destroys them via ISGMessage::Release).
+	 * @param Scope The message scope.
+	 * @param Annotations An optional message annotations header.
+	 * @param Delay The delay after which to send the messages.
+	 * @param Expiration The time at which the messages expire.
+	 * @param Flags The message flags (i.e. the message priority).
+	 * @param Publisher The message publisher.
+	 * @see FSGMessageBatch, Publish, SendBatch
+	 */
+	virtual void PublishBatch(TArrayView<const FSGMessageBatchEntry> Messages, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
+
+	/**
+	 * Publishes a tagged message to subscribed recipients every interval until it is cancelled.
+	 *
+	 * The router keeps the message in its timing wheel and publishes it again each interval, without
+	 * rebuilding it. Periods are scheduled from the previous due time rather than from the time of the
+	 * previous publish, so they don't drift; periods that were missed altogether are skipped. Each period
+	 * is delivered in a context of its own that shares the message, so handlers must not modify it.
+	 *
+	 * @param MessageTag The message tag (used as the message type).
+	 * @param Message The message to publish (an ISGMessage, which the bus destroys via ISGMessage::Release once the schedule is cancelled).
+	 * @param Scope The message scope.
+	 * @param Annotations An optional message annotations header.
+	 * @param Interval The time between two publishes (also the delay of the first one).
+	 * @param Flags The message flags (i.e. the message priority).
+	 * @param Publisher The message publisher.
+	 * @return Handle to cancel the schedule with (invalid if the message wasn't scheduled).
+	 * @see CancelDelayedMessage, Publish
+	 */
+	virtual FSGDelayedMessageHandle SchedulePeriodic(const FName& MessageTag, void* Message, ESGMessageScope Scope,
+	                     const FSGMessageAnnotations& Annotations, const FTimespan& Interval,
+	                     ESGMessageFlags Flags, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
 
-	virtual void Publish(const FName& MessageTag, void* Message, ESGMessageScope Scope,
-	                     const TMap<FName, FString>& Annotations, const FTimespan& Delay, const FDateTime& Expiration,
-	                     const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Publisher) = 0;
-	
 	/**
 	 * Registers a message recipient with the message bus.
 	 *
@@ -187,20 +356,94 @@ public:
 	 * @param Delay The delay after which to send the message.
 	 * @param Expiration The time at which the message expires.
 	 * @param Sender The message sender.
-	 * @see Forward, Publish
+	 * @return Handle to the delayed message (invalid if the message is not delayed or delayed messaging is disabled).
+	 * @see CancelDelayedMessage, Forward, Publish
 	 */
-	virtual void Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const TMap<FName, FString>& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const TArray<FSGMessageAddress>& Recipients, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
+	virtual FSGDelayedMessageHandle Send(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, TArrayView<const FSGMessageAddress> Recipients, const FTimespan& Delay, const FDateTime& Expiration, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
 
-	virtual void Send(const FName& MessageTag,
+	virtual FSGDelayedMessageHandle Send(const FName& MessageTag,
 	                  void* Message,
-	                  const TArray<FSGMessageAddress>& Recipients,
+	                  TArrayView<const FSGMessageAddress> Recipients,
+	                  ESGMessageFlags Flags,
+	                  const FSGMessageAnnotations& Annotations,
+	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	                  const FTimespan& Delay,
+	                  const FDateTime& Expiration,
+	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
+
+	/**
+	 * Sends a batch of tagged messages to the specified recipients.
+	 *
+	 * The messages share their recipients, flags, annotations, attachment, delay and expiration, and
+	 * are routed in order with a single router command per router shard.
+	 *
+	 * @param Messages The messages to send (the bus destroys them via ISGMessage::Release).
+	 * @param Recipients The message recipients.
+	 * @param Flags The message flags (i.e. the message priority).
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment An optional binary data attachment.
+	 * @param Delay The delay after which to send the messages.
+	 * @param Expiration The time at which the messages expire.
+	 * @param Sender The message sender.
+	 * @see FSGMessageBatch, PublishBatch, Send
+	 */
+	virtual void SendBatch(TArrayView<const FSGMessageBatchEntry> Messages,
+	                  TArrayView<const FSGMessageAddress> Recipients,
 	                  ESGMessageFlags Flags,
-	                  const TMap<FName, FString>& Annotations,
+	                  const FSGMessageAnnotations& Annotations,
 	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
 	                  const FTimespan& Delay,
 	                  const FDateTime& Expiration,
 	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
-	
+
+	/**
+	 * Sends a request to a recipient and returns a future for its reply.
+	 *
+	 * The bus assigns a correlation identifier to the request, which the recipient's reply refers to
+	 * (see FSGMessageEndpoint::Reply). The reply is matched by the router and completes the future
+	 * instead of being dispatched through subscriptions. The future is completed on the router
+	 * thread (or the thread that pumps the bus in frame mode), so continuations should be short.
+	 * If the request message is dropped before it reaches the recipient, i.e. because the recipient
+	 * is unknown or a queue on the way is full, the future is completed as Dropped right away.
+	 *
+	 * The bus takes over ownership of the message's memory.
+	 * It must NOT be freed by the caller.
+	 *
+	 * @param Message The message to send.
+	 * @param TypeInfo The message's type information.
+	 * @param Flags The message flags.
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment The binary data to attach to the message.
+	 * @param Recipient The message recipient.
+	 * @param Timeout The time after which the request times out (zero = never); the request also expires then.
+	 * @param Sender The message sender.
+	 * @return Future for the reply.
+	 * @see Send
+	 */
+	virtual TFuture<FSGMessageReply> Request(void* Message, UScriptStruct* TypeInfo, ESGMessageFlags Flags, const FSGMessageAnnotations& Annotations, const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment, const FSGMessageAddress& Recipient, const FTimespan& Timeout, const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
+
+	/**
+	 * Sends a tagged request to a recipient and returns a future for its reply.
+	 *
+	 * @param MessageTag The message tag (used as the message type).
+	 * @param Message The message to send (an ISGMessage, which the bus destroys via ISGMessage::Release).
+	 * @param Recipient The message recipient.
+	 * @param Flags The message flags.
+	 * @param Annotations An optional message annotations header.
+	 * @param Attachment The binary data to attach to the message.
+	 * @param Timeout The time after which the request times out (zero = never); the request also expires then.
+	 * @param Sender The message sender.
+	 * @return Future for the reply.
+	 */
+	virtual TFuture<FSGMessageReply> Request(const FName& MessageTag,
+	                  void* Message,
+	                  const FSGMessageAddress& Recipient,
+	                  ESGMessageFlags Flags,
+	                  const FSGMessageAnnotations& Annotations,
+	                  const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& Attachment,
+	                  const FTimespan& Timeout,
+	                  const TSharedRef<ISGMessageSender, ESPMode::ThreadSafe>& Sender) = 0;
+
 	/**
 	 * Shuts down the message bus.
 	 *
@@ -208,6 +451,19 @@ public:
 	 */
 	virtual void Shutdown() = 0;
 
+	/**
+	 * Shuts down the message bus without waiting for its router threads.
+	 *
+	 * The bus stops accepting messages right away and notifies its shutdown delegate. The router
+	 * threads are joined in the background, which keeps the bus alive until they exited. Delayed
+	 * messages are always dropped.
+	 *
+	 * @param Policy What to do with the messages that are queued.
+	 * @return A future that completes when all router threads exited.
+	 * @see OnShutdown, Shutdown
+	 */
+	virtual TFuture<void> ShutdownAsync(ESGMessageBusShutdownPolicy Policy) = 0;
+
 	/**
 	 * Adds a subscription for published messages of the specified type.
 	 *
@@ -222,6 +478,73 @@ public:
 	 */
 	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> Subscribe(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const TRange<ESGMessageScope>& ScopeRange) = 0;
 
+	/**
+	 * Adds subscriptions for published messages of several types at once.
+	 *
+	 * This is cheaper than a Subscribe call per type, because each router shard receives all of its
+	 * subscriptions with a single command.
+	 *
+	 * @param Subscriber The subscriber wishing to receive the messages.
+	 * @param MessageTypes The types of messages to subscribe to.
+	 * @param ScopeRange The range of message scopes to include in the subscriptions.
+	 * @return The added subscriptions, in the order of the message types (nullptr entries for failed subscriptions).
+	 * @see Subscribe, UnsubscribeMany
+	 */
+	virtual TArray<TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe>> SubscribeMany(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArrayView<const FName> MessageTypes, const TRange<ESGMessageScope>& ScopeRange) = 0;
+
+	/**
+	 * Adds a subscription that joins a consumer group for published messages of the specified type.
+	 *
+	 * Each message goes to only one member of the group, picked according to the policy, which makes the group
+	 * a work queue whose members share the load. The policy of the group's first member is used for the group.
+	 * Subscribers should not also have a regular subscription for the same message type.
+	 *
+	 * @param Subscriber The subscriber wishing to receive the messages.
+	 * @param MessageType The type of messages to subscribe to.
+	 * @param GroupName The name of the consumer group.
+	 * @param Policy The way the group picks the member that receives a message.
+	 * @param ScopeRange The range of message scopes to include in the subscription.
+	 * @return The added subscription, or nullptr if the subscription failed.
+	 * @see Subscribe, Unsubscribe
+	 */
+	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> SubscribeToGroup(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const FName& GroupName, ESGMessageConsumerPolicy Policy, const TRange<ESGMessageScope>& ScopeRange) = 0;
+
+	/**
+	 * Adds a subscription whose published messages are filtered by their content on the router thread.
+	 *
+	 * Messages that don't match the filter are never queued to the subscriber. Members of a consumer
+	 * group only compete for the messages that match their filter. If the subscription has a projection,
+	 * message bridges only transport the projected parameters of dynamic messages to this process as
+	 * long as every local subscriber of the type is projected.
+	 *
+	 * @param Subscriber The subscriber wishing to receive the messages.
+	 * @param MessageType The type of messages to subscribe to.
+	 * @param Filter The filter that messages must match (nullptr = all messages).
+	 * @param GroupName The name of the consumer group to join (NAME_None = receive every matching message).
+	 * @param Policy The way the consumer group picks the member that receives a message.
+	 * @param ScopeRange The range of message scopes to include in the subscription.
+	 * @param Projection The parameters of dynamic messages that the subscriber reads (nullptr = all parameters).
+	 * @return The added subscription, or nullptr if the subscription failed.
+	 * @see FSGMessageContentFilter, FSGMessageProjection, Subscribe, SubscribeToGroup
+	 */
+	virtual TSharedPtr<ISGMessageSubscription, ESPMode::ThreadSafe> SubscribeFiltered(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType, const TSharedPtr<const FSGMessageContentFilter, ESPMode::ThreadSafe>& Filter, const FName& GroupName, ESGMessageConsumerPolicy Policy, const TRange<ESGMessageScope>& ScopeRange, const TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe>& Projection) = 0;
+
+	/**
+	 * Adds, moves or removes the spatial interests of subscribers in published messages.
+	 *
+	 * A subscriber with a spatial interest in a message type receives the published messages of the type
+	 * whose origin (see SGMessageSpatial::OriginAnnotation) is within the interest's radius, and those
+	 * without an origin. The routers index the interests spatially, so the cost of publishing a message
+	 * with an origin depends on the number of nearby subscribers rather than on all subscribers.
+	 *
+	 * Spatial interests are independent of subscriptions, a subscriber should have one or the other for
+	 * a message type. Interests are updated asynchronously, so callers should batch all updates of a frame.
+	 *
+	 * @param Interests The interests to update (a negative radius removes an interest).
+	 * @see FSGMessageSpatialInterest, Subscribe
+	 */
+	virtual void UpdateSpatialInterests(TArrayView<const FSGMessageSpatialInterest> Interests) = 0;
+
 	/**
 	 * Removes an interceptor for messages of the specified type.
 	 *
@@ -239,6 +562,48 @@ public:
 	 */
 	virtual void Unregister(const FSGMessageAddress& Address) = 0;
 
+	/**
+	 * Creates a group of recipient addresses.
+	 *
+	 * Messages that are sent to the group's address are delivered to all members of the group, so
+	 * sending to many recipients doesn't require a list of their addresses. The router resolves the
+	 * members once and reuses the resolved recipients until the members or the registrations change.
+	 * Groups can't contain other groups, and they are local to the bus, i.e. bridges don't know them.
+	 *
+	 * @param GroupName The name of the group (for debugging purposes).
+	 * @return The address of the new group.
+	 * @see AddToAddressGroup, DestroyAddressGroup, RemoveFromAddressGroup
+	 */
+	virtual FSGMessageAddress CreateAddressGroup(const FName& GroupName) = 0;
+
+	/**
+	 * Adds recipient addresses to a group.
+	 *
+	 * The addresses don't have to be registered yet.
+	 *
+	 * @param Group The address of the group.
+	 * @param Members The addresses to add.
+	 * @see CreateAddressGroup, RemoveFromAddressGroup
+	 */
+	virtual void AddToAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members) = 0;
+
+	/**
+	 * Removes recipient addresses from a group.
+	 *
+	 * @param Group The address of the group.
+	 * @param Members The addresses to remove.
+	 * @see AddToAddressGroup
+	 */
+	virtual void RemoveFromAddressGroup(const FSGMessageAddress& Group, TArrayView<const FSGMessageAddress> Members) = 0;
+
+	/**
+	 * Destroys a group of recipient addresses.
+	 *
+	 * @param Group The address of the group.
+	 * @see CreateAddressGroup
+	 */
+	virtual void DestroyAddressGroup(const FSGMessageAddress& Group) = 0;
+
 	/**
 	 * Cancels the specified message subscription.
 	 *
@@ -248,6 +613,18 @@ public:
 	 */
 	virtual void Unsubscribe(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, const FName& MessageType) = 0;
 
+	/**
+	 * Cancels the subscriptions of a subscriber to several message types at once.
+	 *
+	 * Each router shard receives all of its removals with a single command. To cancel all of a
+	 * subscriber's subscriptions, call Unsubscribe with NAME_All instead.
+	 *
+	 * @param Subscriber The subscriber wishing to stop receiving the messages.
+	 * @param MessageTypes The types of messages to unsubscribe from.
+	 * @see SubscribeMany, Unsubscribe
+	 */
+	virtual void UnsubscribeMany(const TSharedRef<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber, TArrayView<const FName> MessageTypes) = 0;
+
 	/**
 	 * Add a listener to the bus notifications
 	 * @param Listener The listener to as to the registration notifications
@@ -265,6 +642,53 @@ public:
 	 */
 	virtual const FString& GetName() const = 0;
 
+	/**
+	 * Gets the message types that local subscribers receive from other processes.
+	 *
+	 * Includes topic patterns and NAME_All if local subscribers subscribed to them with a scope range that
+	 * includes network messages. Message bridges exchange these types, so that only messages that remote
+	 * subscribers are interested in are transported. Subscriptions count until they are unsubscribed.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param OutMessageTypes Will hold the message types and topic patterns.
+	 * @see OnRemoteInterestChanged
+	 */
+	virtual void GetRemoteInterest(TArray<FName>& OutMessageTypes) const = 0;
+
+	/**
+	 * Gets the parameters of dynamic messages that local subscribers receive from other processes.
+	 *
+	 * A message type of the remote interest is only included if all of its local subscriptions have a
+	 * projection, and then maps to the union of their keys. Message bridges exchange these projections
+	 * together with the remote interest, so that only the projected parameters are transported.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param OutProjections Will hold the projections, by message type.
+	 * @see GetRemoteInterest, SubscribeFiltered
+	 */
+	virtual void GetRemoteProjections(TMap<FName, FSGMessageProjection>& OutProjections) const = 0;
+
+	/**
+	 * Checks whether this bus is pumped per frame instead of running its own router threads.
+	 *
+	 * @return true if the bus is in frame mode, false otherwise.
+	 * @see ProcessFrame
+	 */
+	virtual bool IsFrameMode() const = 0;
+
+	/**
+	 * Routes queued messages within the configured frame budget.
+	 *
+	 * Only has an effect in frame mode. Must be called once per frame from the thread that drives the bus,
+	 * usually the game thread. Work that doesn't fit into the budget is carried over to the next frame.
+	 * Buses that aren't pumped for a frame are pumped from the core ticker instead.
+	 *
+	 * @see IsFrameMode
+	 */
+	virtual void ProcessFrame() = 0;
+
 public:
 
 	/**
@@ -275,6 +699,17 @@ public:
 	 */
 	virtual FOnMessageBusShutdown& OnShutdown() = 0;
 
+	/**
+	 * Returns a delegate that is executed when the message types that local subscribers receive from other processes change.
+	 *
+	 * The delegate is also executed when the projections of these types may have changed. It is executed
+	 * on the thread that subscribed or unsubscribed.
+	 *
+	 * @return The delegate.
+	 * @see GetRemoteInterest, GetRemoteProjections
+	 */
+	virtual FOnMessageBusInterestChanged& OnRemoteInterestChanged() = 0;
+
 public:
 
 	/** Virtual destructor. */
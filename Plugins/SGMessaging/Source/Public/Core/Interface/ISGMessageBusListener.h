@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Async/TaskGraphInterfaces.h"
+#include "Core/Interface/ISGMessageContext.h"
 
 enum class ESGMessageBusNotification : uint8
 {
@@ -10,6 +11,68 @@ enum class ESGMessageBusNotification : uint8
 	Unregistered
 };
 
+/**
+ * Struct to propagate message bus notifications
+ */
+struct FSGMessageBusNotification
+{
+	/** Notification type. */
+	ESGMessageBusNotification NotificationType;
+
+	/** Address of the un/registered. */
+	FSGMessageAddress RegistrationAddress;
+};
+
+/** Enumerates the queues that report backpressure. */
+enum class ESGMessageBackpressureSource : uint8
+{
+	/** The command queue of a message router. */
+	Router = 0,
+
+	/** The inbox of a message endpoint. */
+	Inbox,
+
+	/** The rate limit of a sender or message type. */
+	RateLimit
+};
+
+/** Enumerates backpressure state changes. */
+enum class ESGMessageBackpressureState : uint8
+{
+	/** The queue reached its capacity, or messages were dropped (a sender went over a rate limit for RateLimit). */
+	Congested = 0,
+
+	/** The queue drained below half of its capacity (a limited sender got a message through again for RateLimit). */
+	Relieved
+};
+
+/**
+ * Structure for backpressure notifications.
+ */
+struct FSGMessageBackpressureEvent
+{
+	/** Holds the kind of queue that changed its state. */
+	ESGMessageBackpressureSource Source = ESGMessageBackpressureSource::Router;
+
+	/** Holds the new backpressure state. */
+	ESGMessageBackpressureState State = ESGMessageBackpressureState::Congested;
+
+	/** Holds the address of the endpoint whose inbox changed its state (Inbox), or of the limited sender (RateLimit, invalid for message type limits). */
+	FSGMessageAddress Address;
+
+	/** Holds the message type whose rate limit changed its state (RateLimit only, None = the sender's own limit). */
+	FName MessageType;
+
+	/** Holds the number of queued messages when the state changed. */
+	int32 QueueDepth = 0;
+
+	/** Holds the capacity of the queue (the burst size for RateLimit). */
+	int32 Capacity = 0;
+
+	/** Holds the total number of messages the queue has dropped so far. */
+	int64 NumDroppedMessages = 0;
+};
+
 /**
  * Interface for message bus listener.
  *
@@ -43,4 +106,29 @@ public:
 	 * @param Notification The even type, either `Registered` or `Unregistered`
 	 */
 	virtual void NotifyRegistration(const FSGMessageAddress& Address, ESGMessageBusNotification Notification) = 0;
+
+	/**
+	 * Notify the registration events of a router pass from the bus
+	 * The bus collects the registrations and unregistrations of each pass and calls this once per pass, so that
+	 * spawning many endpoints costs one call (or task) per listener instead of one per endpoint. An address that
+	 * registered and unregistered within the same pass is left out. Calls NotifyRegistration for each event by default.
+	 *
+	 * @param Notifications The registration events, in no particular order.
+	 */
+	virtual void NotifyRegistrations(TArrayView<const FSGMessageBusNotification> Notifications)
+	{
+		for (const FSGMessageBusNotification& Notification : Notifications)
+		{
+			NotifyRegistration(Notification.RegistrationAddress, Notification.NotificationType);
+		}
+	}
+
+	/**
+	 * Notify a backpressure event from the bus
+	 * This is called when a router command queue becomes congested or relieved, so producers can throttle.
+	 * Every router shard reports its own queue. Rate limits report when a sender starts and stops exceeding them.
+	 *
+	 * @param Event The backpressure event.
+	 */
+	virtual void NotifyBackpressure(const FSGMessageBackpressureEvent& Event) { }
 };
\ No newline at end of file
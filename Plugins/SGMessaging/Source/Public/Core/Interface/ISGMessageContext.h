@@ -7,13 +7,17 @@
 #include "Containers/Array.h"
 #include "Containers/Map.h"
 #include "Misc/Crc.h"
+#include "Misc/DateTime.h"
 #include "Misc/Guid.h"
 #include "Templates/SharedPointer.h"
 #include "UObject/Class.h"
 #include "UObject/NameTypes.h"
 #include "UObject/WeakObjectPtr.h"
 #include "UObject/WeakObjectPtrTemplates.h"
+#include "Core/Message/SGMessageAnnotations.h"
+#include "Core/Message/SGMessageTagBuilder.h"
 
+class ISGMessage;
 class ISGMessageAttachment;
 
 struct FDateTime;
@@ -110,7 +114,8 @@ public:
 	 */
 	friend uint32 GetTypeHash(const FSGMessageAddress& Address)
 	{
-		return FCrc::MemCrc_DEPRECATED(&Address.UniqueId, sizeof(FGuid));
+		// addresses key the router's and tracer's hot maps, so combine the words instead of running a CRC
+		return HashCombineFast(HashCombineFast(Address.UniqueId.A, Address.UniqueId.B), HashCombineFast(Address.UniqueId.C, Address.UniqueId.D));
 	}
 
 public:
@@ -128,6 +133,30 @@ public:
 		return Result;
 	}
 
+	/**
+	 * Returns the stable message address of a name.
+	 *
+	 * The same name always yields the same address, also in other processes and sessions.
+	 *
+	 * @param Name The name, e.g. of a durable endpoint.
+	 * @return The address.
+	 * @see NewAddress
+	 */
+	static FSGMessageAddress NamedAddress(const FString& Name)
+	{
+		const int32 NumBytes = Name.Len() * sizeof(TCHAR);
+
+		FSGMessageAddress Result;
+		Result.UniqueId = FGuid(
+			FCrc::MemCrc32(*Name, NumBytes, 0),
+			FCrc::MemCrc32(*Name, NumBytes, 1),
+			FCrc::MemCrc32(*Name, NumBytes, 2),
+			FCrc::MemCrc32(*Name, NumBytes, 3)
+		);
+
+		return Result;
+	}
+
 	/**
 	 * Converts a string to a message address.
 	 *
@@ -188,10 +217,43 @@ enum class ESGMessageFlags : uint32
 	None = 0,
 	/** Guarantee that this message is delivered */
 	Reliable = 1 << 0,
+	/** Route this message in the router's high priority lane */
+	HighPriority = 1 << 1,
+	/** Route this message in the router's low priority lane */
+	LowPriority = 1 << 2,
+	/** Replace older undelivered messages with the same conflation key (latest value wins) */
+	Conflate = 1 << 3,
+	/** Keep the latest published message of this type and deliver it to later subscribers (late joiners get the current state) */
+	Retain = 1 << 4,
+	/** Like Retain, but keep the latest message of each sender (implies Retain) */
+	RetainPerSender = 1 << 5,
+	/** Drop copies of this message that arrive again within the deduplication window (e.g. retries), see SGMessageDeduplication */
+	Deduplicate = 1 << 6,
 };
 ENUM_CLASS_FLAGS(ESGMessageFlags);
 
 
+/**
+ * Enumerates message priorities.
+ *
+ * Each priority has its own lane in the message router. Lanes are drained highest priority first.
+ */
+enum class ESGMessagePriority : uint8
+{
+	/** Messages that must not wait behind bulk traffic, i.e. input or combat (and all router commands other than routing). */
+	High,
+
+	/** Regular messages. */
+	Normal,
+
+	/** Bulk traffic, i.e. telemetry. */
+	Low,
+
+	/** Number of priorities (not a valid priority). */
+	Num
+};
+
+
 /** Type definition for message scope ranges. */
 typedef TRange<ESGMessageScope> FSGMessageScopeRange;
 
@@ -199,6 +261,36 @@ typedef TRange<ESGMessageScope> FSGMessageScopeRange;
 typedef TRangeBound<ESGMessageScope> FSGMessageScopeRangeBound;
 
 
+/**
+ * Structure for a hop of a forwarded message.
+ *
+ * Forwarded messages keep the hops they took before the current one, so that tools can trace their
+ * path without keeping the intermediate contexts alive.
+ *
+ * @see ISGMessageContext.GetForwardHistory
+ */
+struct FSGMessageForwardHop
+{
+	/** The address of the endpoint that forwarded the message. */
+	FSGMessageAddress Forwarder;
+
+	/** The recipients that the message was forwarded to. */
+	TArray<FSGMessageAddress, TInlineAllocator<1>> Recipients;
+
+	/** The scope that the message was forwarded with. */
+	ESGMessageScope Scope;
+
+	/** The name of the thread from which the message was forwarded. */
+	ENamedThreads::Type ForwarderThread;
+
+	/** The time at which the message was forwarded. */
+	FDateTime TimeForwarded;
+
+	/** The hop before this one, or nullptr if this was the first forward. */
+	TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> Previous;
+};
+
+
 /**
  * Interface for message contexts.
  *
@@ -213,7 +305,8 @@ typedef TRangeBound<ESGMessageScope> FSGMessageScopeRangeBound;
  * larger amounts of data that would otherwise clog up the messaging system.
  *
  * In case a message was forwarded by another endpoint, the context of the original sender can be accessed
- * using the ISGMessageContext.GetOriginalContext method.
+ * using the ISGMessageContext.GetOriginalContext method. Contexts created by the bus don't chain forwards,
+ * they all refer to the context that holds the message, and keep only a record of the previous hops.
  *
  * @see ISGMessageAttachment
  */
@@ -226,7 +319,7 @@ public:
 	 *
 	 * @return Message header collection.
 	 */
-	virtual const TMap<FName, FString>& GetAnnotations() const = 0;
+	virtual const FSGMessageAnnotations& GetAnnotations() const = 0;
 
 	/**
 	 * Gets the message attachment, if present.
@@ -250,6 +343,17 @@ public:
 	 */
 	virtual const void* GetMessage() const = 0;
 
+	/**
+	 * Gets the message if it is a tagged message.
+	 *
+	 * Tagged messages (see ISGMessage) carry their own type name, so handlers can check it before
+	 * casting, since any message may be published with any tag.
+	 *
+	 * @return The message, or nullptr if the context holds a struct message.
+	 * @see GetMessage
+	 */
+	virtual const ISGMessage* GetTaggedMessage() const = 0;
+
 	/**
 	 * Gets the message's type information.
 	 *
@@ -258,20 +362,56 @@ public:
 	 */
 	virtual const TWeakObjectPtr<UScriptStruct>& GetMessageTypeInfo() const = 0;
 
+	/**
+	 * Gets the dense identifier of the message's structure.
+	 *
+	 * @return The type identifier, or INDEX_NONE for tagged messages.
+	 * @see FSGMessageTypeRegistry, GetMessageType, GetMessageTypeInfo
+	 */
+	virtual int32 GetMessageTypeId() const = 0;
+
 	/**
 	 * Returns the original message context in case the message was forwarded.
 	 *
+	 * The context of the previous hop may be recreated from the forward history on each call, so
+	 * this is meant for tools rather than for message handlers.
+	 *
 	 * @return The original message context, or nullptr if the message wasn't forwarded.
+	 * @see GetForwardHistory, GetRootContext
 	 */
 	virtual TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> GetOriginalContext() const = 0;
 
+	/**
+	 * Gets the context that holds the message in case the message was forwarded.
+	 *
+	 * Contexts that are not implemented by the bus hold their message themselves.
+	 *
+	 * @return The context that was sent, or nullptr if the message wasn't forwarded.
+	 * @see GetOriginalContext
+	 */
+	virtual TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> GetRootContext() const
+	{
+		return nullptr;
+	}
+
+	/**
+	 * Gets the hops that the message took before it was forwarded the last time.
+	 *
+	 * @return The previous hop, or nullptr if the message was forwarded at most once.
+	 * @see GetOriginalContext
+	 */
+	virtual TSharedPtr<const FSGMessageForwardHop, ESPMode::ThreadSafe> GetForwardHistory() const
+	{
+		return nullptr;
+	}
+
 	/**
 	 * Gets the list of message recipients.
 	 *
 	 * @return Message recipients.
 	 * @see GetSender
 	 */
-	virtual const TArray<FSGMessageAddress>& GetRecipients() const = 0;
+	virtual TArrayView<const FSGMessageAddress> GetRecipients() const = 0;
 
 	/**
 	 * Gets the scope to which the message was sent.
@@ -337,13 +477,64 @@ public:
 
 public:
 
+	/**
+	 * Checks whether this message has an expiration time.
+	 *
+	 * Messages sent with FDateTime::MaxValue() never expire. A default constructed
+	 * expiration time, as used by unset Blueprint parameters, is treated the same way.
+	 *
+	 * @return true if the message can expire, false otherwise.
+	 * @see GetExpiration, IsExpired
+	 */
+	bool HasExpiration() const
+	{
+		const FDateTime& Expiration = GetExpiration();
+
+		return (Expiration.GetTicks() != 0) && (Expiration != FDateTime::MaxValue());
+	}
+
+	/**
+	 * Gets the priority of this message.
+	 *
+	 * @return The priority derived from the message flags.
+	 * @see GetFlags
+	 */
+	ESGMessagePriority GetPriority() const
+	{
+		const ESGMessageFlags MessageFlags = GetFlags();
+
+		if (EnumHasAnyFlags(MessageFlags, ESGMessageFlags::HighPriority))
+		{
+			return ESGMessagePriority::High;
+		}
+
+		if (EnumHasAnyFlags(MessageFlags, ESGMessageFlags::LowPriority))
+		{
+			return ESGMessagePriority::Low;
+		}
+
+		return ESGMessagePriority::Normal;
+	}
+
+	/**
+	 * Checks whether this message has expired.
+	 *
+	 * @param CurrentTime The current time (UTC).
+	 * @return true if the message has expired, false otherwise.
+	 * @see GetExpiration, HasExpiration
+	 */
+	bool IsExpired(const FDateTime& CurrentTime) const
+	{
+		return HasExpiration() && (GetExpiration() < CurrentTime);
+	}
+
 	/**
 	 * Checks whether this is a forwarded message.
 	 *
 	 * @return true if the message was forwarded, false otherwise.
 	 * @see GetOriginalContext, GetTimeForwarded, IsValid
 	 */
-	bool IsForwarded() const
+	virtual bool IsForwarded() const
 	{
 		return GetOriginalContext().IsValid();
 	}
@@ -359,6 +550,89 @@ public:
 		return GetMessage() != nullptr;
 	}
 
+	/**
+	 * Checks whether the message tracer samples this message.
+	 *
+	 * Contexts that don't store the sampling decision are always traced.
+	 *
+	 * @return true if the message is traced, false otherwise.
+	 * @see SetTraced
+	 */
+	virtual bool IsTraced() const
+	{
+		return true;
+	}
+
+	/**
+	 * Stores the message tracer's sampling decision.
+	 *
+	 * The tracer calls this once when the message is sent.
+	 *
+	 * @param bInTraced Whether the message is traced.
+	 * @see IsTraced
+	 */
+	virtual void SetTraced(bool bInTraced) { }
+
+	/**
+	 * Gets the identifier that the message tracer assigned to this message.
+	 *
+	 * Contexts that don't store the identifier return zero, and their messages aren't traced.
+	 *
+	 * @return The trace identifier, or zero if the message isn't traced.
+	 * @see SetTraceId
+	 */
+	virtual uint64 GetTraceId() const
+	{
+		return 0;
+	}
+
+	/**
+	 * Stores the identifier that the message tracer assigned to this message.
+	 *
+	 * The tracer calls this once when the message is sent, and keys its records by the
+	 * identifier, because the address of a released context may be reused by a new one.
+	 *
+	 * @param InTraceId The trace identifier.
+	 * @see GetTraceId
+	 */
+	virtual void SetTraceId(uint64 InTraceId) { }
+
+	/**
+	 * Gets the topic identifier of the message's tag.
+	 *
+	 * Contexts that don't store the topic parse the tag on each call.
+	 *
+	 * @param OutTopicID Will hold the topic identifier.
+	 * @return true if the message type is a topic tag ("TopicID:MessageID"), false otherwise.
+	 * @see SetTopicID
+	 */
+	virtual bool GetTopicID(int32& OutTopicID) const
+	{
+		return FSGMessageTagBuilder::TryParseTopicID(GetMessageType(), OutTopicID);
+	}
+
+	/**
+	 * Checks whether the topic identifier of the message's tag is stored in this context.
+	 *
+	 * @return true if the topic was stored, false otherwise.
+	 * @see SetTopicID
+	 */
+	virtual bool HasTopicID() const
+	{
+		return false;
+	}
+
+	/**
+	 * Stores the topic identifier of the message's tag.
+	 *
+	 * The router calls this once, before the message is first dispatched, so that handlers don't
+	 * parse the tag for every delivery.
+	 *
+	 * @param InTopicID The topic identifier, or unset if the message type isn't a topic tag.
+	 * @see GetTopicID
+	 */
+	virtual void SetTopicID(const TOptional<int32>& InTopicID) { }
+
 public:
 
 	/** Virtual destructor. */
@@ -26,3 +26,19 @@ public:
 	/** Virtual destructor. */
 	virtual ~ISGMessageHandler() { }
 };
+
+
+/**
+ * Interface for message handlers that collect messages and handle them in batches.
+ *
+ * HandleMessage only collects a message, and the collected messages are handled together when the
+ * endpoint flushes the handler, i.e. after a batch of deliveries or after processing its inbox.
+ */
+class ISGMessageBatchHandler
+	: public ISGMessageHandler
+{
+public:
+
+	/** Handles the messages that were collected since the last flush. */
+	virtual void FlushMessages() = 0;
+};
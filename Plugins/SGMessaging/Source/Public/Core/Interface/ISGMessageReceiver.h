@@ -70,6 +70,42 @@ public:
 	 */
 	virtual void ReceiveMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) = 0;
 
+	/**
+	 * Notifies the recipient that a batch of messages was delivered.
+	 *
+	 * Called on the recipient thread after the messages of one dispatch batch were received, so that
+	 * recipients can handle the messages they collected together.
+	 */
+	virtual void FlushReceivedMessages() { }
+
+	/**
+	 * Gets the number of messages that the recipient received but didn't handle yet.
+	 *
+	 * Consumer groups with the LeastLoaded policy pick the recipient with the fewest queued messages.
+	 *
+	 * @return Number of queued messages.
+	 * @see ESGMessageConsumerPolicy
+	 */
+	virtual int32 GetNumQueuedMessages() const
+	{
+		return 0;
+	}
+
+	/**
+	 * Whether the router queues messages for this recipient while it isn't registered.
+	 *
+	 * Messages that are sent to the address of an unregistered durable recipient are stored in its durable
+	 * queue, and are delivered when a recipient with the same address registers again. Durable recipients
+	 * should use a stable address (see FSGMessageAddress::NamedAddress) to receive messages across restarts.
+	 *
+	 * @return true if the recipient is durable, false otherwise.
+	 * @see FSGMessageDurableQueue
+	 */
+	virtual bool IsDurable() const
+	{
+		return false;
+	}
+
 public:
 
 	/**
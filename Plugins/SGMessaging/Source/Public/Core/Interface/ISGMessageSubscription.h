@@ -6,9 +6,41 @@
 #include "Templates/SharedPointer.h"
 #include "UObject/NameTypes.h"
 
+class FSGMessageContentFilter;
+class FSGMessageProjection;
 class ISGMessageReceiver;
 enum class ESGMessageScope : uint8;
 
+
+/**
+ * Enumerates the ways a consumer group picks the member that receives a message.
+ *
+ * @see ISGMessageBus::SubscribeToGroup
+ */
+enum class ESGMessageConsumerPolicy : uint8
+{
+	/** Members take turns. */
+	RoundRobin,
+
+	/** The member with the fewest queued inbox messages receives the message (ties take turns). */
+	LeastLoaded,
+
+	/**
+	 * Messages with the same key go to the same member while the group's membership doesn't change.
+	 *
+	 * The key is the SGConsumerGroupKey annotation, or the sender if the message has none.
+	 */
+	KeyHash
+};
+
+
+namespace SGMessageConsumerGroup
+{
+	/** Name of the message annotation that holds the key of KeyHash consumer groups. */
+	static const FName KeyAnnotation(TEXT("SGConsumerGroupKey"));
+}
+
+
 /**
  * Interface for message subscriptions.
  *
@@ -70,6 +102,52 @@ public:
 	 */
 	virtual bool IsEnabled() = 0;
 
+	/**
+	 * Gets the consumer group of the subscription.
+	 *
+	 * Each message goes to only one of the subscribers in a group, instead of to all of them.
+	 *
+	 * @return The group name, or NAME_None if the subscription isn't in a group.
+	 * @see GetConsumerPolicy
+	 */
+	virtual FName GetConsumerGroup()
+	{
+		return NAME_None;
+	}
+
+	/**
+	 * Gets the way the subscription's consumer group picks the member that receives a message.
+	 *
+	 * @return The consumer policy.
+	 * @see GetConsumerGroup
+	 */
+	virtual ESGMessageConsumerPolicy GetConsumerPolicy()
+	{
+		return ESGMessageConsumerPolicy::RoundRobin;
+	}
+
+	/**
+	 * Gets the content filter that the router applies to the subscription's messages.
+	 *
+	 * @return The filter, or nullptr if the subscription receives all messages of its type.
+	 * @see ISGMessageBus::SubscribeFiltered
+	 */
+	virtual const FSGMessageContentFilter* GetContentFilter()
+	{
+		return nullptr;
+	}
+
+	/**
+	 * Gets the parameters of dynamic messages that the subscriber reads.
+	 *
+	 * @return The projection, or nullptr if the subscriber reads all parameters.
+	 * @see ISGMessageBus::SubscribeFiltered, ISGMessageBus::GetRemoteProjections
+	 */
+	virtual TSharedPtr<const FSGMessageProjection, ESPMode::ThreadSafe> GetProjection()
+	{
+		return nullptr;
+	}
+
 public:
 
 	/** Virtual destructor. */
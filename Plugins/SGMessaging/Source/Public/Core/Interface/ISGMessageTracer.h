@@ -6,10 +6,14 @@
 #include "Containers/Array.h"
 #include "Containers/Map.h"
 #include "Delegates/Delegate.h"
+#include "HAL/CriticalSection.h"
 #include "Templates/SharedPointer.h"
 
 #include "ISGMessageContext.h"
+#include "Core/Bus/SGMessageLatencyHistogram.h"
 
+class ISGMessageTracerBreakpoint;
+struct FSGMessageCompressionStatistics;
 struct FSGMessageTracerEndpointInfo;
 struct FSGMessageTracerMessageInfo;
 struct FSGMessageTracerTypeInfo;
@@ -69,6 +73,25 @@ struct FSGMessageTracerBreakpoint
 };
 
 
+/**
+ * Structure for the retention limits of a message tracer's history.
+ *
+ * The oldest messages are evicted once any of the limits is exceeded. Evicted messages release their
+ * message context, while the aggregate counters of endpoints, interceptors and message types keep counting.
+ */
+struct FSGMessageTracerRetention
+{
+	/** Holds the maximum number of messages to keep (0 = unlimited). */
+	int32 MaxMessages = 0;
+
+	/** Holds the maximum age of the messages to keep (in seconds, 0 = unlimited). */
+	double MaxAge = 0.0;
+
+	/** Holds the maximum estimated memory of the messages to keep (in bytes, 0 = unlimited). */
+	int64 MaxBytes = 0;
+};
+
+
 /**
  * Structure for message dispatch states.
  */
@@ -121,13 +144,22 @@ struct FSGMessageTracerEndpointInfo
 	/** Holds the recipient's human readable name. */
 	FName Name;
 
-	/** Holds the list of messages received by this recipient. */
+	/** Holds the latencies of messages sent (send to route) and received (route to dispatch, dispatch to handled) by this recipient. */
+	FSGMessageLatencyHistograms Latencies;
+
+	/** Holds the total number of messages received by this recipient, including evicted ones. */
+	int64 NumReceivedMessages = 0;
+
+	/** Holds the total number of messages sent by this recipient, including evicted ones. */
+	int64 NumSentMessages = 0;
+
+	/** Holds the list of retained messages received by this recipient. */
 	TArray<TSharedPtr<FSGMessageTracerMessageInfo>> ReceivedMessages;
 
 	/** Holds a flag indicating whether this is a remote recipient. */
 	bool Remote;
 
-	/** Holds the list of messages sent by this recipient. */
+	/** Holds the list of retained messages sent by this recipient. */
 	TArray<TSharedPtr<FSGMessageTracerMessageInfo>> SentMessages;
 };
 
@@ -140,9 +172,12 @@ struct FSGMessageTracerInterceptorInfo
 	/** Holds the interceptor's human readable name. */
 	FName Name;
 
-	/** Holds the list of messages intercepted by this interceptor. */
+	/** Holds the list of retained messages intercepted by this interceptor. */
 	TArray<TSharedPtr<FSGMessageTracerMessageInfo>> InterceptedMessages;
 
+	/** Holds the total number of messages intercepted by this interceptor, including evicted ones. */
+	int64 NumInterceptedMessages = 0;
+
 	/** Holds the time at which this interceptor was registered. */
 	double TimeRegistered;
 
@@ -156,7 +191,7 @@ struct FSGMessageTracerInterceptorInfo
  */
 struct FSGMessageTracerMessageInfo
 {
-	/** Holds a pointer to the message context. */
+	/** Holds a pointer to the message context (nullptr once the message was evicted from the history). */
 	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
 
 	/** Holds the message's dispatch states per endpoint. */
@@ -184,11 +219,20 @@ struct FSGMessageTracerMessageInfo
  */
 struct FSGMessageTracerTypeInfo
 {
-	/** Holds the collection of messages of this type. */
+	/** Holds the collection of retained messages of this type. */
 	TArray<TSharedPtr<FSGMessageTracerMessageInfo>> Messages;
 
+	/** Holds the total number of messages of this type, including evicted ones. */
+	int64 NumMessages = 0;
+
+	/** Holds the delivery latencies of messages of this type. */
+	FSGMessageLatencyHistograms Latencies;
+
 	/** Holds a name of the message type. */
 	FName TypeName;
+
+	/** Holds the readable name of the message tag, if the type is a tag declared with DECLARE_MESSAGE_TAG. */
+	FString DebugName;
 };
 
 
@@ -283,6 +327,21 @@ public:
 	 */
 	virtual int32 GetMessageTypes(TArray<TSharedPtr<FSGMessageTracerTypeInfo>>& OutTypes) const = 0;
 
+	/**
+	 * Finds a known message type, i.e. to query its latency histograms.
+	 *
+	 * @param MessageType The name of the message type.
+	 * @return The message type, or nullptr if no message of this type was traced.
+	 */
+	virtual TSharedPtr<FSGMessageTracerTypeInfo> FindMessageType(const FName& MessageType) const = 0;
+
+	/**
+	 * Resets the latency histograms of all message types and endpoints.
+	 *
+	 * Must be called on the game thread.
+	 */
+	virtual void ResetLatencies() = 0;
+
 	/**
 	 * Checks whether there are any messages in the history.
 	 *
@@ -290,6 +349,132 @@ public:
 	 */
 	virtual bool HasMessages() const = 0;
 
+	/**
+	 * Gets the number of messages traced since the last reset, including evicted ones.
+	 *
+	 * @return The number of messages.
+	 * @see GetNumEvictedMessages
+	 */
+	virtual int64 GetNumTracedMessages() const = 0;
+
+	/**
+	 * Gets the number of messages evicted from the history since the last reset.
+	 *
+	 * @return The number of messages.
+	 * @see GetNumTracedMessages, SetRetention
+	 */
+	virtual int64 GetNumEvictedMessages() const = 0;
+
+	/**
+	 * Gets the retention limits of the message history.
+	 *
+	 * @return The retention limits.
+	 * @see SetRetention
+	 */
+	virtual FSGMessageTracerRetention GetRetention() const = 0;
+
+	/**
+	 * Sets the retention limits of the message history.
+	 *
+	 * The limits are applied the next time the tracer ticks.
+	 *
+	 * @param Retention The retention limits.
+	 * @see GetRetention
+	 */
+	virtual void SetRetention(const FSGMessageTracerRetention& Retention) = 0;
+
+	/**
+	 * Gets the sample rate of a message type.
+	 *
+	 * @param MessageType The message type (NAME_None for the default sample rate).
+	 * @return The tracer traces one in this many messages of the type.
+	 * @see SetSampleRate
+	 */
+	virtual int32 GetSampleRate(const FName& MessageType = NAME_None) const = 0;
+
+	/**
+	 * Sets the sample rate of a message type.
+	 *
+	 * Sampling is deterministic: the first message of a type and every Nth one after it are traced.
+	 * Message types without their own sample rate share one count for the default sample rate.
+	 * The decision is made when a message is sent and stored in its context.
+	 *
+	 * This method is safe to call from any thread.
+	 *
+	 * @param SampleRate The tracer traces one in this many messages (1 = every message; 0 removes the override of a message type).
+	 * @param MessageType The message type (NAME_None for the default sample rate of all other types).
+	 * @see GetSampleRate
+	 */
+	virtual void SetSampleRate(int32 SampleRate, const FName& MessageType = NAME_None) = 0;
+
+	/**
+	 * Gets the number of trace events that were dropped because a thread's trace buffer was full.
+	 *
+	 * @return The number of events.
+	 */
+	virtual int64 GetNumDroppedTraces() const = 0;
+
+	/**
+	 * Gets the compression statistics of messages exchanged by network transports.
+	 *
+	 * The statistics are shared by the transports of all buses, so every tracer returns the same
+	 * statistics. This method is safe to call from any thread.
+	 *
+	 * @param OutStatistics Will hold the compression statistics per message type.
+	 * @see USGMessagingSettings::TransportCompressionFormat
+	 */
+	virtual void GetCompressionStatistics(TMap<FName, FSGMessageCompressionStatistics>& OutStatistics) const = 0;
+
+	/**
+	 * Gets the lock that guards the fields of the tracer's info structures.
+	 *
+	 * The tracer updates endpoint, message and type infos on its own thread. Hold this lock while
+	 * reading their fields, including in the tracer's delegates, which are executed without the lock.
+	 * Latency histograms may be read without the lock.
+	 *
+	 * @return The lock.
+	 */
+	virtual FCriticalSection& GetInfoLock() const = 0;
+
+	/**
+	 * Adds a breakpoint.
+	 *
+	 * Breakpoints are compiled into a table by message type whenever they change, so routing a message
+	 * only checks the breakpoints of its type. Whether a breakpoint is enabled is still checked for each
+	 * message of its types. This method is safe to call from any thread.
+	 *
+	 * @param Breakpoint The breakpoint to add.
+	 * @param MessageTypes The message types to check the breakpoint for (empty = all message types).
+	 * @see RemoveBreakpoint
+	 */
+	virtual void AddBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint, TArrayView<const FName> MessageTypes = TArrayView<const FName>()) = 0;
+
+	/**
+	 * Removes a breakpoint.
+	 *
+	 * @param Breakpoint The breakpoint to remove.
+	 * @see AddBreakpoint
+	 */
+	virtual void RemoveBreakpoint(const TSharedRef<ISGMessageTracerBreakpoint, ESPMode::ThreadSafe>& Breakpoint) = 0;
+
+	/**
+	 * Gets the contexts of the messages that hit capture breakpoints.
+	 *
+	 * Only the most recent captures are kept. This method is safe to call from any thread.
+	 *
+	 * @param OutContexts Will hold the captured contexts, oldest first.
+	 * @return The number of captured contexts.
+	 * @see ClearCapturedMessages, ESGMessageTracerBreakpointAction
+	 */
+	virtual int32 GetCapturedMessages(TArray<TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe>>& OutContexts) const = 0;
+
+	/**
+	 * Removes all captured message contexts.
+	 *
+	 * @see GetCapturedMessages
+	 */
+	virtual void ClearCapturedMessages() = 0;
+
 public:
 
 	typedef TSharedRef<FSGMessageTracerMessageInfo> FSGMessageTracerMessageInfoRef;
@@ -311,6 +496,16 @@ public:
 	DECLARE_EVENT(ISGMessageTracer, FOnMessagesReset)
 	virtual FOnMessagesReset& OnMessagesReset() = 0;
 
+	/**
+	 * A delegate that is executed when the oldest messages have been evicted from the history.
+	 *
+	 * The parameter is the number of evicted messages.
+	 *
+	 * @return The delegate.
+	 */
+	DECLARE_EVENT_OneParam(ISGMessageTracer, FOnMessagesEvicted, int32)
+	virtual FOnMessagesEvicted& OnMessagesEvicted() = 0;
+
 	/**
 	 * A delegate that is executed when the collection of known messages types has changed.
 	 *
@@ -7,6 +7,19 @@
 class ISGMessageContext;
 
 
+/**
+ * Enumerates the actions of tracer breakpoints.
+ */
+enum class ESGMessageTracerBreakpointAction : uint8
+{
+	/** The router thread stops until the tracer continues. */
+	Break,
+
+	/** The tracer keeps the message's context and the router thread carries on. */
+	Capture
+};
+
+
 /**
  * Interface for message tracer breakpoints.
  *
@@ -31,6 +44,17 @@ public:
 	 */
 	virtual bool ShouldBreak(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context) const = 0;
 
+	/**
+	 * Gets what the tracer does when this breakpoint is hit.
+	 *
+	 * @return The breakpoint action.
+	 * @see ISGMessageTracer::GetCapturedMessages
+	 */
+	virtual ESGMessageTracerBreakpointAction GetAction() const
+	{
+		return ESGMessageTracerBreakpointAction::Break;
+	}
+
 protected:
 
 	/** Hidden destructor. */
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "Containers/Array.h"
+#include "Containers/ArrayView.h"
 #include "Misc/Guid.h"
 #include "Templates/SharedPointer.h"
 #include "UObject/NameTypes.h"
@@ -53,6 +54,32 @@ public:
 	 */
 	virtual bool TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients) = 0;
 
+	/**
+	 * Transports a batch of messages to the specified network nodes.
+	 *
+	 * Message bridges hand their outbound messages to transports in batches. Transports can override this
+	 * method to send a batch with less overhead; the default implementation transports the messages one by one.
+	 *
+	 * @param Contexts The contexts of the messages to transport, in order.
+	 * @param Recipients The transport nodes to send the messages to.
+	 * @return The number of messages that are being transported.
+	 * @see TransportMessage
+	 */
+	virtual int32 TransportMessages(TArrayView<const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Contexts, const TArray<FGuid>& Recipients)
+	{
+		int32 NumTransported = 0;
+
+		for (const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context : Contexts)
+		{
+			if (TransportMessage(Context, Recipients))
+			{
+				++NumTransported;
+			}
+		}
+
+		return NumTransported;
+	}
+
 protected:
 
 	/** Virtual destructor. */
@@ -6,6 +6,7 @@
 #include "Modules/ModuleManager.h"
 #include "Templates/SharedPointer.h"
 #include "Delegates/Delegate.h"
+#include "Core/Interface/ISGMessageContext.h"
 
 class ISGAuthorizeMessageRecipients;
 class ISGMessageBridge;
@@ -50,6 +51,22 @@ public:
 	 */
 	virtual TSharedPtr<ISGMessageBridge, ESPMode::ThreadSafe> CreateBridge(const FSGMessageAddress& Address, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus, const TSharedRef<ISGMessageTransport, ESPMode::ThreadSafe>& Transport) = 0;
 
+	/**
+	 * Creates a new link between two message buses in this process.
+	 *
+	 * Bus links forward the selected messages between the buses without serializing them, and are
+	 * enabled and disabled like message bridges.
+	 *
+	 * @param Address The address that the link forwards messages with.
+	 * @param FirstBus The first message bus to link.
+	 * @param SecondBus The second message bus to link.
+	 * @param MessageTypes The message types and topic patterns to forward (empty = all types).
+	 * @param ScopeRange The scopes of the published messages to forward.
+	 * @return The new bus link, or nullptr if the link couldn't be created.
+	 * @see CreateBridge
+	 */
+	virtual TSharedPtr<ISGMessageBridge, ESPMode::ThreadSafe> CreateBusLink(const FSGMessageAddress& Address, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& FirstBus, const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& SecondBus, TArrayView<const FName> MessageTypes, const FSGMessageScopeRange& ScopeRange) = 0;
+
 	/**
 	 * Creates a new message bus.
 	 *
@@ -1,36 +1,62 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Core/Bus/SGMessageMemory.h"
 #include "SGAnyType.h"
+#include "SGMessageWire.h"
 
+/**
+ * Type-erased value of a message parameter.
+ *
+ * Small trivially copyable values (numbers, enums, names, pointers, small math types) are stored
+ * inline, everything else is allocated on the heap. Inline values are copied bitwise, so that
+ * instances stay relocatable and can be held in inline arrays.
+ */
 struct FSGAny
 {
-	FSGAny(): ScriptArray(nullptr)
+	FSGAny(): HeapValue(nullptr),
+	          VTable(nullptr)
 	{
 	}
 
-	FSGAny(const FSGAny& That) : ScriptArray(That.ScriptArray),
-	                             Pointer(That.Clone()),
+	FSGAny(const FSGAny& That) : HeapValue(nullptr),
+	                             VTable(That.VTable),
 	                             AnyType(That.AnyType)
 	{
+		if (VTable != nullptr)
+		{
+			VTable->Copy(*this, That);
+		}
 	}
 
-	FSGAny(FSGAny&& That) noexcept : ScriptArray(MoveTemp(That.ScriptArray)),
-	                                 Pointer(MoveTemp(That.Pointer)),
+	FSGAny(FSGAny&& That) noexcept : HeapValue(nullptr),
+	                                 VTable(That.VTable),
 	                                 AnyType(MoveTemp(That.AnyType))
 	{
+		if (VTable != nullptr)
+		{
+			VTable->Move(*this, That);
+
+			That.VTable = nullptr;
+		}
 	}
 
-	template <typename T, class = TEnableIf<TNot<TIsSame<TDecay<T>, FSGAny>>::Value, T>>
-	explicit FSGAny(T&& Value) : ScriptArray(nullptr),
-	                             Pointer(new TDerived<typename TDecay<T>::Type>(Forward<T>(Value))),
+	template <typename T, typename = typename TEnableIf<!TIsSame<typename TDecay<T>::Type, FSGAny>::Value>::Type>
+	explicit FSGAny(T&& Value) : HeapValue(nullptr),
+	                             VTable(&TStorage<typename TDecay<T>::Type>::VTable),
 	                             AnyType(TSGAnyTraits<typename TRemoveReference<decltype(Value)>::Type>::GetType())
 	{
+		TStorage<typename TDecay<T>::Type>::Construct(*this, Forward<T>(Value));
+	}
+
+	~FSGAny()
+	{
+		Reset();
 	}
 
 	bool IsValid() const
 	{
-		return Pointer.IsValid();
+		return VTable != nullptr;
 	}
 
 	FSGAnyType GetType() const
@@ -44,78 +70,252 @@ struct FSGAny
 		return AnyType == TSGAnyTraits<T>::GetType();
 	}
 
+	/**
+	 * Checks whether the stored value is exactly of the given C++ type.
+	 *
+	 * IsA only compares the category of the type, so e.g. any TArray matches any other. Check this
+	 * before casting to a type whose layout depends on its template arguments.
+	 *
+	 * @param T The type to check.
+	 * @return true if a value of the type is stored, false otherwise.
+	 * @see TSGAnyTypeId
+	 */
+	template <class T>
+	bool Holds() const
+	{
+		return (VTable != nullptr) && (VTable->GetTypeId() == TSGAnyTypeId<typename TDecay<T>::Type>::GetId());
+	}
+
 	template <class T>
 	T& Cast() const
 	{
-		auto Derived = static_cast<TDerived<T>*>(Pointer.Get());
+		return *static_cast<T*>(VTable->Get(*this));
+	}
+
+	/**
+	 * Gets the address of the stored value.
+	 *
+	 * Inline values move with their FSGAny, so the address must not be kept.
+	 *
+	 * @return The value's address, or nullptr if no value is stored.
+	 */
+	void* GetData() const
+	{
+		return VTable != nullptr ? VTable->Get(*this) : nullptr;
+	}
+
+	/**
+	 * Writes the stored value in the binary message encoding (see FSGMessageSerializer).
+	 *
+	 * The value is written as its type followed by its length-prefixed encoding.
+	 *
+	 * @param Writer The writer to append to.
+	 * @return true if the value was written, false if there is no value or its type can't be encoded.
+	 */
+	bool Write(FSGWireWriter& Writer) const
+	{
+		if ((VTable == nullptr) || (VTable->Write == nullptr))
+		{
+			return false;
+		}
 
-		return Derived->Value;
+		VTable->Write(*this, Writer);
+
+		return true;
 	}
 
 	FSGAny& operator=(const FSGAny& Other)
 	{
-		if (Pointer == Other.Pointer)
+		if (this == &Other)
 		{
 			return *this;
 		}
 
-		Pointer = Other.Clone();
+		Reset();
+
+		VTable = Other.VTable;
 
 		AnyType = Other.AnyType;
 
+		if (VTable != nullptr)
+		{
+			VTable->Copy(*this, Other);
+		}
+
 		return *this;
 	}
 
-private:
-	struct FBase;
+	FSGAny& operator=(FSGAny&& Other) noexcept
+	{
+		if (this == &Other)
+		{
+			return *this;
+		}
+
+		Reset();
+
+		VTable = Other.VTable;
+
+		AnyType = MoveTemp(Other.AnyType);
 
-	using FBasePtr = TUniquePtr<FBase>;
+		if (VTable != nullptr)
+		{
+			VTable->Move(*this, Other);
+
+			Other.VTable = nullptr;
+		}
+
+		return *this;
+	}
 
-	struct FBase
+	void Reset()
 	{
-		virtual ~FBase()
+		if (VTable != nullptr)
 		{
+			VTable->Destroy(*this);
+
+			VTable = nullptr;
 		}
+	}
+
+private:
+	/** Size of the inline value storage (in bytes). */
+	static constexpr SIZE_T InlineSize = 24;
+
+	/** Alignment of the inline value storage (in bytes). */
+	static constexpr SIZE_T InlineAlignment = 8;
+
+	/** Function that encodes a stored value. */
+	using FWriteFunction = void (*)(const FSGAny& Any, FSGWireWriter& Writer);
+
+	/** Type-erased operations on the stored value. */
+	struct FVTable
+	{
+		void* (*Get)(const FSGAny& Any);
+
+		void (*Copy)(FSGAny& Dest, const FSGAny& Src);
+
+		void (*Move)(FSGAny& Dest, FSGAny& Src);
+
+		void (*Destroy)(FSGAny& Any);
+
+		FWriteFunction Write;
 
-		virtual FBasePtr Clone() const = 0;
+		uint64 (*GetTypeId)();
 	};
 
 	template <typename T>
-	struct TDerived final : FBase
+	static void WriteValue(const FSGAny& Any, FSGWireWriter& Writer)
+	{
+		Writer.WriteByte((uint8)TSGAnyTraits<typename TSGWireTraits<T>::ValueType>::GetType());
+		Writer.WriteSized([&Any, &Writer]()
+		{
+			TSGWireTraits<T>::Write(Writer, *static_cast<const T*>(Any.GetData()));
+		});
+	}
+
+	/** Gets the function that encodes values of the given type (or nullptr if they can't be encoded). */
+	template <typename T>
+	static constexpr FWriteFunction GetWriteFunction()
+	{
+		if constexpr (TSGWireTraits<T>::bSupported)
+		{
+			return &WriteValue<T>;
+		}
+		else
+		{
+			return nullptr;
+		}
+	}
+
+	template <typename T>
+	struct TUsesInlineStorage
+	{
+		enum
+		{
+			Value = sizeof(T) <= InlineSize && alignof(T) <= InlineAlignment &&
+			TIsTriviallyCopyConstructible<T>::Value && TIsTriviallyDestructible<T>::Value
+		};
+	};
+
+	template <typename T, bool bInline = TUsesInlineStorage<T>::Value>
+	struct TStorage
 	{
 		template <typename U>
-		explicit TDerived(U&& InValue) : Value(Forward<U>(InValue))
+		static void Construct(FSGAny& Any, U&& Value)
+		{
+			new(Any.InlineStorage) T(Forward<U>(Value));
+		}
+
+		static void* Get(const FSGAny& Any)
+		{
+			return const_cast<uint8*>(Any.InlineStorage);
+		}
+
+		static void Copy(FSGAny& Dest, const FSGAny& Src)
+		{
+			FMemory::Memcpy(Dest.InlineStorage, Src.InlineStorage, sizeof(T));
+		}
+
+		static void Move(FSGAny& Dest, FSGAny& Src)
 		{
+			FMemory::Memcpy(Dest.InlineStorage, Src.InlineStorage, sizeof(T));
 		}
 
-		virtual FBasePtr Clone() const override
+		static void Destroy(FSGAny& Any)
 		{
-			return MakeUnique<TDerived<T>>(Value);
 		}
 
-		T Value;
+		static constexpr FVTable VTable = {&Get, &Copy, &Move, &Destroy, GetWriteFunction<T>(), &TSGAnyTypeId<T>::GetId};
 	};
 
-private:
-	FBasePtr Clone() const
+	template <typename T>
+	struct TStorage<T, false>
 	{
-		return Pointer != nullptr ? Pointer->Clone() : nullptr;
-	}
+		template <typename U>
+		static void Construct(FSGAny& Any, U&& Value)
+		{
+			LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+			Any.HeapValue = new T(Forward<U>(Value));
+		}
 
-public:
-	union
-	{
-		FScriptArray* ScriptArray;
+		static void* Get(const FSGAny& Any)
+		{
+			return Any.HeapValue;
+		}
 
-		FScriptMap* ScriptMap;
+		static void Copy(FSGAny& Dest, const FSGAny& Src)
+		{
+			LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+			Dest.HeapValue = new T(*static_cast<const T*>(Src.HeapValue));
+		}
 
-		FScriptSet* ScriptSet;
+		static void Move(FSGAny& Dest, FSGAny& Src)
+		{
+			Dest.HeapValue = Src.HeapValue;
+
+			Src.HeapValue = nullptr;
+		}
+
+		static void Destroy(FSGAny& Any)
+		{
+			delete static_cast<T*>(Any.HeapValue);
+
+			Any.HeapValue = nullptr;
+		}
 
-		void* ScriptStruct;
+		static constexpr FVTable VTable = {&Get, &Copy, &Move, &Destroy, GetWriteFunction<T>(), &TSGAnyTypeId<T>::GetId};
 	};
 
 private:
-	FBasePtr Pointer;
+	union
+	{
+		alignas(InlineAlignment) uint8 InlineStorage[InlineSize];
+
+		void* HeapValue;
+	};
+
+	const FVTable* VTable;
 
 	FSGAnyType AnyType;
 };
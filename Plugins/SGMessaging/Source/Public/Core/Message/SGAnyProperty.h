@@ -2,22 +2,72 @@
 
 #include "CoreMinimal.h"
 #include "SGAny.h"
+#include "SGMessageParams.h"
 
 struct FSGAnyProperty
 {
-	FSGAnyProperty(TMap<FString, FSGAny>& InParams, const FString& InKey)
+	FSGAnyProperty(FSGMessageParams& InParams, FName InKey)
 		: Params(InParams), Key(InKey)
 	{
 	}
 
-	FSGAnyProperty(const TMap<FString, FSGAny>& InParams, const FString& InKey)
-		: Params(const_cast<TMap<FString, FSGAny>&>(InParams)), Key(InKey)
+	FSGAnyProperty(const FSGMessageParams& InParams, FName InKey)
+		: Params(const_cast<FSGMessageParams&>(InParams)), Key(InKey)
 	{
 	}
 
-	TMap<FString, FSGAny>& Params;
+	FSGMessageParams& Params;
 
-	const FString& Key;
+	FName Key;
+};
+
+/**
+ * Structure for an array parameter set from a Blueprint.
+ *
+ * The helper refers to the Blueprint's array, and the inner property tells C++ readers what its
+ * elements are, since the helper itself doesn't expose it.
+ */
+struct FSGScriptArray
+{
+	/** Holds the helper for the Blueprint's array. */
+	FScriptArrayHelper Helper;
+
+	/** Holds the property of the array's elements (nullptr = unknown). */
+	const FProperty* Inner = nullptr;
+
+	/**
+	 * Checks whether the array's elements are of the given C++ type.
+	 *
+	 * Struct elements must be of the type's structure, other elements must have its size.
+	 *
+	 * @param T The element type.
+	 * @return true if the elements can be read as T, false otherwise.
+	 */
+	template <typename T>
+	bool HoldsElementsOf() const
+	{
+		if ((Inner == nullptr) || (Inner->ElementSize != sizeof(T)))
+		{
+			return false;
+		}
+
+		if constexpr (TSGIsUStruct<T>::Value)
+		{
+			const FStructProperty* StructProperty = CastField<FStructProperty>(Inner);
+
+			return (StructProperty != nullptr) && (StructProperty->Struct == T::StaticStruct());
+		}
+		else
+		{
+			return true;
+		}
+	}
+};
+
+template <typename T>
+struct TSGAnyTraits<FSGScriptArray, T>
+{
+	static CONSTEXPR ESGAnyTypes GetType() { return ESGAnyTypes::FScriptArray; }
 };
 
 template <typename T, typename Enable = void>
@@ -32,10 +82,9 @@ struct TSGAnyProperty : FSGAnyProperty
 
 	T operator()() const
 	{
-		if (const auto Value = Params.Find(Key))
+		// the categories of IsA are too coarse for a cast, e.g. all types without traits are Empty
+		if (const auto Value = Params.Find(Key); Value != nullptr && ensure(Value->template Holds<T>()))
 		{
-			ensure(Value->template IsA<T>());
-
 			return Value->template Cast<T>();
 		}
 
@@ -226,11 +275,7 @@ struct TSGAnyProperty<TArray<T>> : FSGAnyProperty
 
 	void operator()(TArray<T>& Value) const
 	{
-		auto Any = FSGAny(Value);
-
-		Any.ScriptArray = reinterpret_cast<FScriptArray*>(&Value);
-
-		Params.Add(Key, MoveTemp(Any));
+		Params.Add(Key, FSGAny(Value));
 	}
 
 	TArray<T> operator()() const
@@ -239,23 +284,20 @@ struct TSGAnyProperty<TArray<T>> : FSGAnyProperty
 		{
 			ensure(Value->GetType() == ESGAnyTypes::TArray || Value->GetType() == ESGAnyTypes::FScriptArray);
 
-			if (Value->GetType() == ESGAnyTypes::TArray)
+			if (Value->template Holds<TArray<T>>())
 			{
 				return Value->template Cast<TArray<T>>();
 			}
 
-			if (Value->GetType() == ESGAnyTypes::FScriptArray)
+			if (Value->template Holds<FSGScriptArray>())
 			{
-				auto ScriptArrayHelper = Value->template Cast<FScriptArrayHelper>();
-
-				TArray<T> ScriptArray;
+				auto& ScriptArray = Value->template Cast<FSGScriptArray>();
 
-				for (auto i = 0; i < ScriptArrayHelper.Num(); ++i)
+				// copies trivially copyable elements as one block
+				if (ScriptArray.template HoldsElementsOf<T>())
 				{
-					ScriptArray.Add(*(ScriptArrayHelper.GetRawPtr() + i * sizeof(T)));
+					return TArray<T>(reinterpret_cast<const T*>(ScriptArray.Helper.GetRawPtr()), ScriptArray.Helper.Num());
 				}
-
-				return MoveTemp(ScriptArray);
 			}
 		}
 
@@ -270,12 +312,12 @@ struct TSGAnyProperty<FScriptArrayHelper, T> : FSGAnyProperty
 
 	void operator()(FScriptArrayHelper& Value) const
 	{
-		Params.Add(Key, FSGAny(Value));
+		Params.Add(Key, FSGAny(FSGScriptArray{ Value }));
 	}
 
 	void operator()(const FArrayProperty* ArrayProperty, const void* PropertyAddress) const
 	{
-		Params.Add(Key, FSGAny(FScriptArrayHelper(ArrayProperty, PropertyAddress)));
+		Params.Add(Key, FSGAny(FSGScriptArray{ FScriptArrayHelper(ArrayProperty, PropertyAddress), ArrayProperty->Inner }));
 	}
 
 	void operator()(const void* PropertyAddress, const FArrayProperty* ArrayProperty) const
@@ -285,14 +327,26 @@ struct TSGAnyProperty<FScriptArrayHelper, T> : FSGAnyProperty
 			ensure(Value->GetType() == ESGAnyTypes::FScriptArray|| Value->GetType() == ESGAnyTypes::TArray);
 
 			auto SrcHelper = Value->GetType() == ESGAnyTypes::FScriptArray
-				                 ? Value->template Cast<FScriptArrayHelper>()
+				                 ? Value->template Cast<FSGScriptArray>().Helper
 				                 : FScriptArrayHelper::CreateHelperFormInnerProperty(
-					                 ArrayProperty->Inner, Value->ScriptArray);
+					                 ArrayProperty->Inner, Value->GetData());
 
 			const auto Inner = ArrayProperty->Inner;
 
 			auto DestHelper = FScriptArrayHelper::CreateHelperFormInnerProperty(Inner, PropertyAddress);
 
+			if (Inner->HasAnyPropertyFlags(CPF_IsPlainOldData))
+			{
+				DestHelper.EmptyAndAddUninitializedValues(SrcHelper.Num());
+
+				if (SrcHelper.Num() > 0)
+				{
+					FMemory::Memcpy(DestHelper.GetRawPtr(), SrcHelper.GetRawPtr(), (SIZE_T)SrcHelper.Num() * Inner->ElementSize);
+				}
+
+				return;
+			}
+
 			DestHelper.Resize(SrcHelper.Num());
 
 			auto Dest = DestHelper.GetRawPtr();
@@ -318,11 +372,7 @@ struct TSGAnyProperty<TMap<K, V>> : FSGAnyProperty
 
 	void operator()(TMap<K, V>& Value) const
 	{
-		auto Any = FSGAny(Value);
-
-		Any.ScriptMap = reinterpret_cast<FScriptMap*>(&Value);
-
-		Params.Add(Key, MoveTemp(Any));
+		Params.Add(Key, FSGAny(Value));
 	}
 
 	TMap<K, V> operator()() const
@@ -342,11 +392,14 @@ struct TSGAnyProperty<TMap<K, V>> : FSGAnyProperty
 
 				auto ScriptMapHelper = Value->template Cast<FScriptMapHelper>();
 
+				ScriptMap.Reserve(ScriptMapHelper.Num());
+
 				for (auto i = 0; i < ScriptMapHelper.GetMaxIndex(); ++i)
 				{
 					if (ScriptMapHelper.IsValidIndex(i))
 					{
-						ScriptMap.Add(*ScriptMapHelper.GetKeyPtr(i), *ScriptMapHelper.GetValuePtr(i));
+						ScriptMap.Add(*reinterpret_cast<const K*>(ScriptMapHelper.GetKeyPtr(i)),
+						              *reinterpret_cast<const V*>(ScriptMapHelper.GetValuePtr(i)));
 					}
 				}
 
@@ -384,18 +437,31 @@ struct TSGAnyProperty<FScriptMapHelper, T> : FSGAnyProperty
 			auto SrcHelper = Value->GetType() == ESGAnyTypes::FScriptMap
 				                 ? Value->template Cast<FScriptMapHelper>()
 				                 : FScriptMapHelper::CreateHelperFormInnerProperties(
-					                 MapProperty->KeyProp, MapProperty->ValueProp, Value->ScriptMap);
+					                 MapProperty->KeyProp, MapProperty->ValueProp, Value->GetData());
 
 			auto DestHelper = FScriptMapHelper::CreateHelperFormInnerProperties(
 				MapProperty->KeyProp, MapProperty->ValueProp, PropertyAddress);
 
+			const auto KeyProp = MapProperty->KeyProp;
+
+			const auto ValueProp = MapProperty->ValueProp;
+
+			DestHelper.EmptyValues(SrcHelper.Num());
+
+			// the source keys are unique, so the pairs are copied without lookups and hashed once at the end
 			for (auto i = 0; i < SrcHelper.GetMaxIndex(); ++i)
 			{
 				if (SrcHelper.IsValidIndex(i))
 				{
-					DestHelper.AddPair(SrcHelper.GetKeyPtr(i), SrcHelper.GetValuePtr(i));
+					const auto DestIndex = DestHelper.AddDefaultValue_Invalid_NeedsRehash();
+
+					KeyProp->CopySingleValue(DestHelper.GetKeyPtr(DestIndex), SrcHelper.GetKeyPtr(i));
+
+					ValueProp->CopySingleValue(DestHelper.GetValuePtr(DestIndex), SrcHelper.GetValuePtr(i));
 				}
 			}
+
+			DestHelper.Rehash();
 		}
 	}
 };
@@ -407,11 +473,7 @@ struct TSGAnyProperty<TSet<T>> : FSGAnyProperty
 
 	void operator()(TSet<T>& Value) const
 	{
-		auto Any = FSGAny(Value);
-
-		Any.ScriptSet = reinterpret_cast<FScriptSet*>(&Value);
-
-		Params.Add(Key, MoveTemp(Any));
+		Params.Add(Key, FSGAny(Value));
 	}
 
 	TSet<T> operator()() const
@@ -431,11 +493,13 @@ struct TSGAnyProperty<TSet<T>> : FSGAnyProperty
 
 				auto ScriptSetHelper = Value->template Cast<FScriptSetHelper>();
 
+				ScriptSet.Reserve(ScriptSetHelper.Num());
+
 				for (auto i = 0; i < ScriptSetHelper.GetMaxIndex(); ++i)
 				{
 					if (ScriptSetHelper.IsValidIndex(i))
 					{
-						ScriptSet.Add(*ScriptSetHelper.GetElementPtr(i));
+						ScriptSet.Add(*reinterpret_cast<const T*>(ScriptSetHelper.GetElementPtr(i)));
 					}
 				}
 
@@ -471,20 +535,27 @@ struct TSGAnyProperty<FScriptSetHelper, T> : FSGAnyProperty
 			auto SrcHelper = Value->GetType() == ESGAnyTypes::FScriptSet
 				                 ? Value->template Cast<FScriptSetHelper>()
 				                 : FScriptSetHelper::CreateHelperFormElementProperty(
-					                 SetProperty->ElementProp, Value->ScriptSet);
+					                 SetProperty->ElementProp, Value->GetData());
 
 			auto DestHelper = FScriptSetHelper::CreateHelperFormElementProperty(
 				SetProperty->ElementProp, PropertyAddress);
 
+			const auto ElementProp = SetProperty->ElementProp;
+
 			DestHelper.EmptyElements(SrcHelper.Num());
 
+			// the source elements are unique, so they are copied without lookups and hashed once at the end
 			for (auto i = 0; i < SrcHelper.GetMaxIndex(); ++i)
 			{
 				if (SrcHelper.IsValidIndex(i))
 				{
-					DestHelper.AddElement(SrcHelper.GetElementPtr(i));
+					const auto DestIndex = DestHelper.AddDefaultValue_Invalid_NeedsRehash();
+
+					ElementProp->CopySingleValue(DestHelper.GetElementPtr(DestIndex), SrcHelper.GetElementPtr(i));
 				}
 			}
+
+			DestHelper.Rehash();
 		}
 	}
 };
@@ -496,11 +567,7 @@ struct TSGAnyProperty<T, typename TEnableIf<TSGIsUStruct<T>::Value>::Type> : FSG
 
 	void operator()(T& Value) const
 	{
-		auto Any = FSGAny(Value);
-
-		Any.ScriptStruct = &Value;
-
-		Params.Add(Key, MoveTemp(Any));
+		Params.Add(Key, FSGAny(Value));
 	}
 
 	T operator()() const
@@ -558,7 +625,7 @@ struct TSGAnyProperty<void*, T> : FSGAnyProperty
 			Struct->CopyScriptStruct(PropertyAddress,
 			                         Value->GetType() == ESGAnyTypes::Empty
 				                         ? Value->template Cast<void*>()
-				                         : Value->ScriptStruct);
+				                         : Value->GetData());
 		}
 	}
 };
@@ -45,7 +45,8 @@ enum class ESGAnyTypes : int32
 	FMulticastSparseDelegate,
 	Char,
 	Ansichar,
-	Class
+	Class,
+	SharedPayload
 };
 
 
@@ -364,3 +365,9 @@ struct TSGAnyTraits<ANSICHAR*, T>
 {
 	static CONSTEXPR ESGAnyTypes GetType() { return ESGAnyTypes::Ansichar; }
 };
+
+template <typename T>
+struct TSGAnyTraits<TSharedPtr<const T, ESPMode::ThreadSafe>>
+{
+	static CONSTEXPR ESGAnyTypes GetType() { return ESGAnyTypes::SharedPayload; }
+};
@@ -1,6 +1,40 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Hash/CityHash.h"
+
+/**
+ * Template for the identifier of a C++ type stored in FSGAny.
+ *
+ * The identifier hashes the compiler's signature of MakeId, which spells out the type, so it is the
+ * same in every module, unlike the address of a static. It tells apart types that share an
+ * ESGAnyTypes category, e.g. TArray<int32> and TArray<FVector>.
+ *
+ * @param T The stored type.
+ */
+template <typename T>
+struct TSGAnyTypeId
+{
+	/** Gets the identifier of the type (computed once per module). */
+	static uint64 GetId()
+	{
+		static const uint64 Id = MakeId();
+
+		return Id;
+	}
+
+private:
+	static uint64 MakeId()
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		const ANSICHAR* Signature = __FUNCSIG__;
+#else
+		const ANSICHAR* Signature = __PRETTY_FUNCTION__;
+#endif
+
+		return CityHash64(Signature, FCStringAnsi::Strlen(Signature));
+	}
+};
 
 template <typename T>
 struct TSGIsEnum
@@ -2,7 +2,11 @@
 
 #include "CoreMinimal.h"
 #include "Core/Interface/ISGMessage.h"
+#include "Core/Bus/SGMessageMemory.h"
 #include "SGAnyProperty.h"
+#include "SGMessageSchema.h"
+#include "SGMessageProjection.h"
+#include <atomic>
 
 class FSGMessage
 	: public ISGMessage
@@ -21,87 +25,326 @@ public:
 	virtual ~FSGMessage() override
 	{
 		Params.Empty();
+		Schema.Reset();
 	}
 
 public:
 	virtual FName GetFName() const override
 	{
-		return "FSGMessage";
+		return StaticMessageName();
+	}
+
+	/** Gets the name that GetFName returns for dynamic messages. */
+	static FName StaticMessageName()
+	{
+		static const FName MessageName(TEXT("FSGMessage"));
+
+		return MessageName;
+	}
+
+	//~ ISGMessage interface
+
+	/**
+	 * Releases a reference to the message, destroying it with the last one.
+	 *
+	 * A new message holds one reference, which belongs to whoever hands it to a message context.
+	 *
+	 * @see AddRef
+	 */
+	virtual void Release() override
+	{
+		if (NumReferences.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		{
+			ISGMessage::Release();
+		}
+	}
+
+	/**
+	 * Adds a reference to the message, e.g. for a Blueprint that keeps it after it was sent.
+	 *
+	 * @see Release
+	 */
+	void AddRef() const
+	{
+		NumReferences.fetch_add(1, std::memory_order_relaxed);
+	}
+
+public:
+	/** Gets the parameters of this message. */
+	const FSGMessageParams& GetParams() const
+	{
+		return Params;
 	}
 
 public:
 	template <typename T>
-	T Get(const FString& Key) const
+	T Get(const FSGMessageKey& Key) const
 	{
-		return TSGAnyProperty<T>(Params, Key)();
+		const FSGAny* Value = Params.Find(Key.Name);
+
+		if (Value != nullptr && Value->GetType() == ESGAnyTypes::SharedPayload)
+		{
+			// payloads of another type are treated like a missing parameter
+			return Value->template Holds<TSharedPtr<const T, ESPMode::ThreadSafe>>() ? *Value->template Cast<TSharedPtr<const T, ESPMode::ThreadSafe>>() : T();
+		}
+
+		return TSGAnyProperty<T>(Params, Key.Name)();
 	}
 
-	void Get(const FString& Key, const FArrayProperty* ArrayProperty, const void* PropertyAddress) const
+	/**
+	 * Gets a read-only view of a parameter without copying it.
+	 *
+	 * @param Key The parameter key.
+	 * @return The parameter value, or nullptr if the message has no such parameter of the given type.
+	 */
+	template <typename T>
+	const T* Find(const FSGMessageKey& Key) const
+	{
+		const FSGAny* Value = Params.Find(Key.Name);
+
+		if (Value == nullptr)
+		{
+			return nullptr;
+		}
+
+		if (Value->GetType() == ESGAnyTypes::SharedPayload)
+		{
+			return Value->template Holds<TSharedPtr<const T, ESPMode::ThreadSafe>>() ? Value->template Cast<TSharedPtr<const T, ESPMode::ThreadSafe>>().Get() : nullptr;
+		}
+
+		return Value->template Holds<T>() ? &Value->template Cast<T>() : nullptr;
+	}
+
+	/**
+	 * Gets a read-only view of an array parameter without copying it.
+	 *
+	 * Works for arrays set from C++, shared array payloads and arrays set from Blueprints, as long as
+	 * their elements are of the given type.
+	 *
+	 * @param Key The parameter key.
+	 * @return View of the array elements (empty if the message has no such parameter of the given element type).
+	 */
+	template <typename T>
+	TArrayView<const T> GetArrayView(const FSGMessageKey& Key) const
 	{
-		TSGAnyProperty<FScriptArrayHelper>(Params, Key)(PropertyAddress, ArrayProperty);
+		if (const TArray<T>* Array = Find<TArray<T>>(Key))
+		{
+			return MakeArrayView(*Array);
+		}
+
+		if (const FSGScriptArray* ScriptArray = Find<FSGScriptArray>(Key); ScriptArray != nullptr && ScriptArray->HoldsElementsOf<T>())
+		{
+			auto& Helper = const_cast<FScriptArrayHelper&>(ScriptArray->Helper);
+
+			return TArrayView<const T>(reinterpret_cast<const T*>(Helper.GetRawPtr()), Helper.Num());
+		}
+
+		return TArrayView<const T>();
+	}
+
+	void Get(const FSGMessageKey& Key, const FArrayProperty* ArrayProperty, const void* PropertyAddress) const
+	{
+		TSGAnyProperty<FScriptArrayHelper>(Params, Key.Name)(PropertyAddress, ArrayProperty);
 	}
 
-	void Get(const FString& Key, const FMapProperty* MapProperty, const void* PropertyAddress) const
+	void Get(const FSGMessageKey& Key, const FMapProperty* MapProperty, const void* PropertyAddress) const
 	{
-		TSGAnyProperty<FScriptMapHelper>(Params, Key)(PropertyAddress, MapProperty);
+		TSGAnyProperty<FScriptMapHelper>(Params, Key.Name)(PropertyAddress, MapProperty);
 	}
 
-	void Get(const FString& Key, const FSetProperty* SetProperty, const void* PropertyAddress) const
+	void Get(const FSGMessageKey& Key, const FSetProperty* SetProperty, const void* PropertyAddress) const
 	{
-		TSGAnyProperty<FScriptSetHelper>(Params, Key)(PropertyAddress, SetProperty);
+		TSGAnyProperty<FScriptSetHelper>(Params, Key.Name)(PropertyAddress, SetProperty);
 	}
 
-	void Get(const FString& Key, const FStructProperty* StructProperty, void* PropertyAddress) const
+	void Get(const FSGMessageKey& Key, const FStructProperty* StructProperty, void* PropertyAddress) const
 	{
-		TSGAnyProperty<void*>(Params, Key)(PropertyAddress, StructProperty);
+		TSGAnyProperty<void*>(Params, Key.Name)(PropertyAddress, StructProperty);
 	}
 
+	/**
+	 * Takes a parameter out of the message.
+	 *
+	 * The value is moved out and the parameter removed, so this is only meant for the sole consumer
+	 * of a message. Shared payloads and Blueprint containers are copied instead.
+	 *
+	 * @param Key The parameter key.
+	 * @return The parameter value (or a default value if the message has no such parameter).
+	 */
 	template <typename T>
-	void Set(const FString& Key, T&& Value)
+	T Take(const FSGMessageKey& Key)
 	{
-		TSGAnyProperty<typename TRemoveReference<decltype(Value)>::Type>(Params, Key)(Value);
+		// shared defaults are copied, because other messages still read them
+		FSGAny* Value = Params.FindLocal(Key.Name);
+
+		if (Value == nullptr || Value->GetType() == ESGAnyTypes::SharedPayload || !Value->template Holds<T>())
+		{
+			return Get<T>(Key);
+		}
+
+		T Result = MoveTemp(Value->template Cast<T>());
+
+		Params.Remove(Key.Name);
+
+		return Result;
+	}
+
+	/**
+	 * Sets a parameter.
+	 *
+	 * Lvalues are copied, rvalues are moved into the message.
+	 *
+	 * @param Key The parameter key.
+	 * @param Value The parameter value.
+	 */
+	template <typename T>
+	void Set(const FSGMessageKey& Key, T&& Value)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+
+		if constexpr (TIsLValueReferenceType<T>::Value)
+		{
+			TSGAnyProperty<typename TRemoveReference<decltype(Value)>::Type>(Params, Key.Name)(Value);
+		}
+		else
+		{
+			Params.Add(Key.Name, FSGAny(MoveTemp(Value)));
+		}
+	}
+
+	/**
+	 * Sets the shared defaults of the parameters, which parameters set on this message shadow.
+	 *
+	 * @param Defaults The defaults.
+	 * @see FSGMessagePrototype
+	 */
+	void SetDefaults(const TSharedRef<const FSGMessageParams, ESPMode::ThreadSafe>& Defaults)
+	{
+		Params.SetDefaults(Defaults);
+	}
+
+	/**
+	 * Sets an immutable, reference counted parameter.
+	 *
+	 * The payload is shared instead of copied, so every subscriber (and every forwarded context) reads
+	 * the same buffer via Find or GetArrayView. Get still returns a copy. Shared payloads can only be
+	 * read from C++.
+	 *
+	 * @param Key The parameter key.
+	 * @param Payload The shared payload.
+	 */
+	template <typename T>
+	void SetShared(const FSGMessageKey& Key, const TSharedRef<const T, ESPMode::ThreadSafe>& Payload)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+		Params.Add(Key.Name, FSGAny(TSharedPtr<const T, ESPMode::ThreadSafe>(Payload)));
+	}
+
+	/**
+	 * Copies the parameters of another message that a projection selects into this message.
+	 *
+	 * Shared payloads stay shared. The schema payload isn't copied.
+	 *
+	 * @param Source The message to copy from.
+	 * @param Projection The keys to copy.
+	 * @return The number of copied parameters.
+	 * @see FSGMessageProjection
+	 */
+	int32 CopyParams(const FSGMessage& Source, const FSGMessageProjection& Projection)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+		int32 NumCopied = 0;
+
+		for (const FName& Key : Projection.GetKeys())
+		{
+			if (const FSGAny* Value = Source.Params.Find(Key))
+			{
+				Params.Add(Key, FSGAny(*Value));
+				++NumCopied;
+			}
+		}
+
+		return NumCopied;
 	}
 
-	void Set(const FString& Key, const FEnumProperty* EnumProperty, const void* PropertyAddress)
+	void Set(const FSGMessageKey& Key, const FEnumProperty* EnumProperty, const void* PropertyAddress)
 	{
-		TSGAnyProperty<int64>(Params, Key)(EnumProperty, PropertyAddress);
+		TSGAnyProperty<int64>(Params, Key.Name)(EnumProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FArrayProperty* ArrayProperty, const void* PropertyAddress)
+	void Set(const FSGMessageKey& Key, const FArrayProperty* ArrayProperty, const void* PropertyAddress)
 	{
-		TSGAnyProperty<FScriptArrayHelper>(Params, Key)(ArrayProperty, PropertyAddress);
+		TSGAnyProperty<FScriptArrayHelper>(Params, Key.Name)(ArrayProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FMapProperty* MapProperty, const void* PropertyAddress)
+	void Set(const FSGMessageKey& Key, const FMapProperty* MapProperty, const void* PropertyAddress)
 	{
-		TSGAnyProperty<FScriptMapHelper>(Params, Key)(MapProperty, PropertyAddress);
+		TSGAnyProperty<FScriptMapHelper>(Params, Key.Name)(MapProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FSetProperty* SetProperty, const void* PropertyAddress)
+	void Set(const FSGMessageKey& Key, const FSetProperty* SetProperty, const void* PropertyAddress)
 	{
-		TSGAnyProperty<FScriptSetHelper>(Params, Key)(SetProperty, PropertyAddress);
+		TSGAnyProperty<FScriptSetHelper>(Params, Key.Name)(SetProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FStructProperty* StructProperty, const void* PropertyAddress)
+	void Set(const FSGMessageKey& Key, const FStructProperty* StructProperty, const void* PropertyAddress)
 	{
-		TSGAnyProperty<void*>(Params, Key)(StructProperty, PropertyAddress);
+		TSGAnyProperty<void*>(Params, Key.Name)(StructProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FMulticastInlineDelegateProperty* MulticastInlineDelegateProperty,
+	void Set(const FSGMessageKey& Key, const FMulticastInlineDelegateProperty* MulticastInlineDelegateProperty,
 	         const void* PropertyAddress)
 	{
-		TSGAnyProperty<FMulticastScriptDelegate*>(Params, Key)(MulticastInlineDelegateProperty, PropertyAddress);
+		TSGAnyProperty<FMulticastScriptDelegate*>(Params, Key.Name)(MulticastInlineDelegateProperty, PropertyAddress);
 	}
 
-	void Set(const FString& Key, const FMulticastSparseDelegateProperty* MulticastSparseDelegateProperty,
+	void Set(const FSGMessageKey& Key, const FMulticastSparseDelegateProperty* MulticastSparseDelegateProperty,
 	         const void* PropertyAddress)
 	{
-		TSGAnyProperty<FSparseDelegate*>(Params, Key)(MulticastSparseDelegateProperty, PropertyAddress);
+		TSGAnyProperty<FSparseDelegate*>(Params, Key.Name)(MulticastSparseDelegateProperty, PropertyAddress);
+	}
+
+	/**
+	 * Sets the schema payload, a copy of the structure the message is declared as.
+	 *
+	 * The payload is kept apart from the parameters and copied as a whole. It isn't encoded by
+	 * FSGMessageSerializer, so it only reaches recipients in the same process.
+	 *
+	 * @param Struct The structure of the payload.
+	 * @param StructAddress The structure instance to copy.
+	 * @see GetSchema
+	 */
+	void SetSchema(const UScriptStruct* Struct, const void* StructAddress)
+	{
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
+		Schema = MakeShared<const FSGMessageSchemaPayload, ESPMode::ThreadSafe>(Struct, StructAddress);
+	}
+
+	/**
+	 * Gets the schema payload.
+	 *
+	 * @return The payload, or nullptr if the message has none.
+	 * @see SetSchema
+	 */
+	const FSGMessageSchemaPayload* GetSchema() const
+	{
+		return Schema.Get();
+	}
+
+	/**
+	 * Gets a read-only view of the schema payload as the given structure.
+	 *
+	 * @return The payload, or nullptr if the message has no payload of the given structure.
+	 */
+	template <typename T>
+	const T* GetSchema() const
+	{
+		return (Schema.IsValid() && (Schema->GetStruct() == T::StaticStruct())) ? static_cast<const T*>(Schema->GetMemory()) : nullptr;
 	}
 
 private:
 	template <typename T>
-	void AddImplementation(const FString& Key, T&& Value)
+	void AddImplementation(const FSGMessageKey& Key, T&& Value)
 	{
 		Set(Key, Forward<T>(Value));
 	}
@@ -117,9 +360,15 @@ private:
 	{
 		AddImplementation(Key, Forward<ParamType>(Value));
 
-		Add(InParams...);
+		Add(Forward<Args>(InParams)...);
 	}
 
 private:
-	TMap<FString, FSGAny> Params;
+	FSGMessageParams Params;
+
+	/** Holds the schema payload (shared by all copies of the message). */
+	TSharedPtr<const FSGMessageSchemaPayload, ESPMode::ThreadSafe> Schema;
+
+	/** Holds the number of references to the message (contexts and Blueprint messages). */
+	mutable std::atomic<int32> NumReferences{1};
 };
@@ -0,0 +1,149 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Implements an immutable, reference counted set of message annotations.
+ *
+ * Copying annotations copies a pointer, and empty annotations don't allocate. The annotations are
+ * stored as a flat array sorted by key, which holds the one or two annotations that most messages
+ * carry inline. Annotations that are sent often can be interned once, so that all messages share
+ * the same block:
+ *
+ *		static const FSGMessageAnnotations ChatAnnotations = FSGMessageAnnotations::Intern({ { TEXT("Channel"), TEXT("Chat") } });
+ *
+ *		Endpoint->Send(Message, TypeInfo, ESGMessageFlags::None, ChatAnnotations, ...);
+ */
+class SGMESSAGING_API FSGMessageAnnotations
+{
+public:
+	/** Type definition for an annotation. */
+	typedef TPair<FName, FString> FEntry;
+
+	/** Creates empty annotations. */
+	FSGMessageAnnotations() { }
+
+	/**
+	 * Creates annotations from a map.
+	 *
+	 * This constructor is implicit so that maps can be passed wherever annotations are expected.
+	 *
+	 * @param InAnnotations The annotations.
+	 */
+	FSGMessageAnnotations(const TMap<FName, FString>& InAnnotations);
+
+	/**
+	 * Creates annotations from a list of annotations.
+	 *
+	 * @param InAnnotations The annotations (the last one wins if a key is repeated).
+	 */
+	FSGMessageAnnotations(std::initializer_list<TPairInitializer<const FName&, const FString&>> InAnnotations);
+
+public:
+	/**
+	 * Gets the shared block of the given annotations, adding it the first time.
+	 *
+	 * The number of interned blocks is limited, further annotations are returned as they are.
+	 *
+	 * @param Annotations The annotations to intern.
+	 * @return The interned annotations.
+	 */
+	static FSGMessageAnnotations Intern(const FSGMessageAnnotations& Annotations);
+
+	/** Gets the empty annotations. */
+	static const FSGMessageAnnotations& GetEmpty();
+
+public:
+	/** Gets the number of annotations. */
+	int32 Num() const
+	{
+		return Block.IsValid() ? Block->Entries.Num() : 0;
+	}
+
+	/** Checks whether there are no annotations. */
+	bool IsEmpty() const
+	{
+		return !Block.IsValid();
+	}
+
+	/**
+	 * Finds the value of an annotation.
+	 *
+	 * @param Key The annotation key.
+	 * @return The value, or nullptr if there is no such annotation.
+	 */
+	const FString* Find(const FName& Key) const
+	{
+		if (Block.IsValid())
+		{
+			for (const FEntry& Entry : Block->Entries)
+			{
+				if (Entry.Key == Key)
+				{
+					return &Entry.Value;
+				}
+			}
+		}
+
+		return nullptr;
+	}
+
+	bool Contains(const FName& Key) const
+	{
+		return Find(Key) != nullptr;
+	}
+
+	/**
+	 * Creates a copy of these annotations with another annotation.
+	 *
+	 * @param Key The annotation key.
+	 * @param Value The annotation value (replaces the existing value of the key).
+	 * @return The new annotations.
+	 */
+	FSGMessageAnnotations With(const FName& Key, const FString& Value) const;
+
+	/** Copies the annotations into a map. */
+	TMap<FName, FString> ToMap() const;
+
+	bool operator==(const FSGMessageAnnotations& Other) const;
+
+	bool operator!=(const FSGMessageAnnotations& Other) const
+	{
+		return !(*this == Other);
+	}
+
+public:
+	/** Iteration over the annotations, ordered by key. */
+	const FEntry* begin() const
+	{
+		return Block.IsValid() ? Block->Entries.GetData() : nullptr;
+	}
+
+	const FEntry* end() const
+	{
+		return Block.IsValid() ? Block->Entries.GetData() + Block->Entries.Num() : nullptr;
+	}
+
+private:
+	/** Structure for the shared annotations. */
+	struct FBlock
+	{
+		/** Holds the annotations, sorted by key. */
+		TArray<FEntry, TInlineAllocator<2>> Entries;
+
+		/** Holds the hash of the annotations (for interning). */
+		uint32 Hash = 0;
+	};
+
+	struct FInternTable;
+
+	/** Sorts the entries of a new block, removes repeated keys and computes its hash. */
+	static void FinishBlock(FBlock& NewBlock);
+
+	/** Gets the interned blocks. */
+	static FInternTable& GetInternTable();
+
+private:
+	/** Holds the annotations, or nullptr if there are none. */
+	TSharedPtr<const FBlock, ESPMode::ThreadSafe> Block;
+};
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessage.h"
+#include "Core/Message/SGMessage.h"
+#include "Core/Message/SGMessageBuilder.h"
+#include "Core/Message/SGMessageTagBuilder.h"
+
+/**
+ * Structure for a tagged message in a batch.
+ *
+ * @see FSGMessageBatch
+ */
+struct FSGMessageBatchEntry
+{
+	/** The message tag (used as the message type). */
+	FName MessageTag;
+
+	/** The message, which is destroyed via ISGMessage::Release. */
+	ISGMessage* Message = nullptr;
+};
+
+/**
+ * Implements a batch of tagged messages that are published or sent together.
+ *
+ * A batch is handed to the bus with a single call, which routes all of its messages with a single
+ * router command per router, so producers of many messages pay for one queue insertion and one
+ * router wake-up instead of one per message. Messages are routed in the order they were added.
+ *
+ *		FSGMessageBatch Batch(Hits.Num());
+ *
+ *		for (const FHit& Hit : Hits)
+ *		{
+ *			Batch.Add(Topic_Gameplay, Gameplay_Damage, Hit.Target, Hit.Amount);
+ *		}
+ *
+ *		Endpoint->PublishBatch(Batch, DEFAULT_PUBLISH_PARAMETER);
+ *
+ * The batch owns its messages until it is published or sent, and releases the messages that were
+ * never handed to a bus when it is reset or destroyed.
+ *
+ * @see FSGMessageEndpoint::PublishBatch, FSGMessageEndpoint::SendBatch
+ */
+class FSGMessageBatch
+	: public FNoncopyable
+{
+public:
+
+	/** Default constructor. */
+	FSGMessageBatch() = default;
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param ExpectedNum The number of messages to reserve memory for.
+	 */
+	explicit FSGMessageBatch(int32 ExpectedNum)
+	{
+		Entries.Reserve(ExpectedNum);
+	}
+
+	/** Destructor. */
+	~FSGMessageBatch()
+	{
+		Reset();
+	}
+
+public:
+
+	/**
+	 * Adds a message to the batch.
+	 *
+	 * @param MessageTag The message tag.
+	 * @param Message The message (the batch takes over ownership).
+	 */
+	template<typename MessageType>
+	void AddMessage(const FName& MessageTag, MessageType* Message)
+	{
+		static_assert(TIsDerivedFrom<MessageType, ISGMessage>::Value, "Tagged messages must implement ISGMessage");
+
+		FSGMessageBatchEntry& Entry = Entries.AddDefaulted_GetRef();
+		{
+			Entry.MessageTag = MessageTag;
+			Entry.Message = Message;
+		}
+	}
+
+	/**
+	 * Builds a message from its parameters and adds it to the batch.
+	 *
+	 * @param Params The message parameters.
+	 */
+	template<typename... Args>
+	void Add(MESSAGE_TAG_PARAM_SIGNATURE, Args&&... Params)
+	{
+		AddMessage(FSGMessageTagBuilder::Builder(MESSAGE_TAG_PARAM_VALUE), FSGMessageBuilder::Builder<FSGMessage>(Forward<Args>(Params)...));
+	}
+
+	/**
+	 * Gets the messages in the batch.
+	 *
+	 * @return The messages, in the order they were added.
+	 */
+	TArrayView<const FSGMessageBatchEntry> GetEntries() const
+	{
+		return Entries;
+	}
+
+	/**
+	 * Gets the number of messages in the batch.
+	 *
+	 * @return Number of messages.
+	 */
+	int32 Num() const
+	{
+		return Entries.Num();
+	}
+
+	/** Gives up the ownership of the messages, after they were handed to a bus. */
+	void Detach()
+	{
+		Entries.Reset();
+	}
+
+	/** Releases the messages and empties the batch, so that it can be reused. */
+	void Reset()
+	{
+		for (const FSGMessageBatchEntry& Entry : Entries)
+		{
+			Entry.Message->Release();
+		}
+
+		Entries.Reset();
+	}
+
+private:
+
+	/** Holds the messages. */
+	TArray<FSGMessageBatchEntry> Entries;
+};
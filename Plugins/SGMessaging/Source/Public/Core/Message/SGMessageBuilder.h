@@ -1,13 +1,17 @@
 #pragma once
 
+#include "Core/Bus/SGMessageMemory.h"
+#include "Core/Bus/SGMessagePool.h"
+
 class FSGMessageBuilder
 {
 public:
 	template <typename MessageType, typename ...Args>
 	static MessageType* Builder(Args&&... InParams)
 	{
-		auto Buffer = FMemory::Malloc(sizeof(MessageType));
+		auto Buffer = FSGMessagePool::Malloc(sizeof(MessageType), alignof(MessageType));
 
+		LLM_SCOPE_BYTAG(SGMessaging_Payloads);
 		auto Message = new(Buffer) MessageType(Forward<Args>(InParams)...);
 
 		return Message;
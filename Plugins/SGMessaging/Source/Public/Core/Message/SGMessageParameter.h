@@ -1,7 +1,6 @@
 #pragma once
 
 #include "CoreMinimal.h"
-#include "Containers/MapBuilder.h"
 #include "Core/Interface/ISGMessageContext.h"
 
 struct FSGMessageParameter
@@ -9,7 +8,7 @@ struct FSGMessageParameter
 	struct FSGSendParameter
 	{
 		FSGSendParameter(const ESGMessageFlags InFlags = ESGMessageFlags::None,
-		                 const TMap<FName, FString>& InAnnotations = TMapBuilder<FName, FString>(),
+		                 const FSGMessageAnnotations& InAnnotations = FSGMessageAnnotations(),
 		                 const TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe>& InAttachment = nullptr,
 		                 const FTimespan& InDelay = FTimespan::Zero(),
 		                 const FDateTime& InExpiration = FDateTime::MaxValue()):
@@ -23,7 +22,7 @@ struct FSGMessageParameter
 
 		ESGMessageFlags Flags;
 
-		TMap<FName, FString> Annotations;
+		FSGMessageAnnotations Annotations;
 
 		TSharedPtr<ISGMessageAttachment, ESPMode::ThreadSafe> Attachment;
 
@@ -36,23 +35,27 @@ struct FSGMessageParameter
 	{
 		FSGPublishParameter(
 			const ESGMessageScope InScope = ESGMessageScope::Network,
-			const TMap<FName, FString>& InAnnotations = TMapBuilder<FName, FString>(),
+			const FSGMessageAnnotations& InAnnotations = FSGMessageAnnotations(),
 			const FTimespan& InDelay = FTimespan::Zero(),
-			const FDateTime& InExpiration = FDateTime::MaxValue()):
+			const FDateTime& InExpiration = FDateTime::MaxValue(),
+			const ESGMessageFlags InFlags = ESGMessageFlags::None):
 			Scope(InScope),
 			Annotations(InAnnotations),
 			Delay(InDelay),
-			Expiration(InExpiration)
+			Expiration(InExpiration),
+			Flags(InFlags)
 		{
 		}
 
 		ESGMessageScope Scope;
 
-		TMap<FName, FString> Annotations;
+		FSGMessageAnnotations Annotations;
 
 		FTimespan Delay;
 
 		FDateTime Expiration;
+
+		ESGMessageFlags Flags;
 	};
 
 	typedef FSGSendParameter FSendParameter;
@@ -96,7 +99,7 @@ struct FSGMessageParameter
 #define CONST_SEND_PARAMETER_SIGNATURE const FSGMessageParameter::FSendParameter& MESSAGE_PARAMETER
 #define SEND_PARAMETER_FORWARD MESSAGE_PARAMETER.Flags, MESSAGE_PARAMETER.Annotations, MESSAGE_PARAMETER.Attachment, MESSAGE_PARAMETER.Delay, MESSAGE_PARAMETER.Expiration
 #define CONST_PUBLISH_PARAMETER_SIGNATURE const FSGMessageParameter::FPublishParameter& MESSAGE_PARAMETER
-#define PUBLISH_PARAMETER_FORWARD MESSAGE_PARAMETER.Scope, MESSAGE_PARAMETER.Annotations, MESSAGE_PARAMETER.Delay, MESSAGE_PARAMETER.Expiration
+#define PUBLISH_PARAMETER_FORWARD MESSAGE_PARAMETER.Scope, MESSAGE_PARAMETER.Annotations, MESSAGE_PARAMETER.Delay, MESSAGE_PARAMETER.Expiration, MESSAGE_PARAMETER.Flags
 #define DEFAULT_SEND_PARAMETER FSGMessageParameter::GetDefaultSendParameter()
 #define DEFAULT_PUBLISH_PARAMETER FSGMessageParameter::GetDefaultPublishParameter()
 #define DELAY_SEND_PARAMETER(InDelay) FSGMessageParameter::GetDelaySendParameter(InDelay)
@@ -0,0 +1,255 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGAny.h"
+
+/**
+ * Key of a message parameter.
+ *
+ * Parameters are keyed by name, so lookups compare name indices instead of hashing strings. Keys
+ * can still be given as strings, but that converts them to names on every call; hot paths should
+ * pass a cached key instead, e.g. one created by MESSAGE_KEY.
+ */
+struct FSGMessageKey
+{
+	FSGMessageKey(FName InName)
+		: Name(InName)
+	{
+	}
+
+	FSGMessageKey(const FString& InName)
+		: Name(*InName)
+	{
+	}
+
+	FSGMessageKey(const TCHAR* InName)
+		: Name(InName)
+	{
+	}
+
+	FSGMessageKey(const ANSICHAR* InName)
+		: Name(InName)
+	{
+	}
+
+	bool operator==(const FSGMessageKey& Other) const
+	{
+		return Name == Other.Name;
+	}
+
+	bool operator!=(const FSGMessageKey& Other) const
+	{
+		return Name != Other.Name;
+	}
+
+	/** Gets the hash of a key, which is derived from the name's index without hashing its string. */
+	friend uint32 GetTypeHash(const FSGMessageKey& Key)
+	{
+		return GetTypeHash(Key.Name);
+	}
+
+	FName Name;
+};
+
+/**
+ * Gets the message key for a string literal, which is converted to a name only the first time.
+ *
+ *		const FString Value = Message.Get<FString>(MESSAGE_KEY("Val"));
+ */
+#define MESSAGE_KEY(InName) ([]() -> const FSGMessageKey& { static const FSGMessageKey Key(TEXT(InName)); return Key; }())
+
+/**
+ * Flat storage for the parameters of a message.
+ *
+ * Messages rarely have more than a handful of parameters, so they are kept in an inline array and
+ * looked up by linear search, which avoids the allocations and hashing of a map.
+ *
+ * Parameters may have immutable, shared defaults (see FSGMessagePrototype). Parameters that are
+ * added shadow the defaults of the same key, and the defaults are only copied if one of them is
+ * removed, so a message made from a prototype only stores the values that differ.
+ */
+class FSGMessageParams
+{
+public:
+	void Add(FName Key, FSGAny&& Value)
+	{
+		if (FSGAny* Existing = FindLocal(Key))
+		{
+			*Existing = MoveTemp(Value);
+		}
+		else
+		{
+			Params.Emplace(Key, MoveTemp(Value));
+		}
+	}
+
+	/**
+	 * Finds a parameter.
+	 *
+	 * Shared defaults are found as well, so values must not be changed through the result (see FindLocal).
+	 *
+	 * @param Key The parameter key.
+	 * @return The value, or nullptr if there is no such parameter.
+	 */
+	FSGAny* Find(FName Key)
+	{
+		return const_cast<FSGAny*>(static_cast<const FSGMessageParams*>(this)->Find(Key));
+	}
+
+	const FSGAny* Find(FName Key) const
+	{
+		const int32 Index = IndexOf(Key);
+
+		if (Index != INDEX_NONE)
+		{
+			return &Params[Index].Value;
+		}
+
+		return Defaults.IsValid() ? Defaults->Find(Key) : nullptr;
+	}
+
+	/**
+	 * Finds a parameter that isn't a shared default, so that its value may be changed or moved out.
+	 *
+	 * @param Key The parameter key.
+	 * @return The value, or nullptr if there is no such parameter or it is a shared default.
+	 */
+	FSGAny* FindLocal(FName Key)
+	{
+		const int32 Index = IndexOf(Key);
+
+		return Index != INDEX_NONE ? &Params[Index].Value : nullptr;
+	}
+
+	bool Remove(FName Key)
+	{
+		// removing a default would only uncover it, so the defaults are copied first
+		if (Defaults.IsValid() && Defaults->Contains(Key))
+		{
+			MaterializeDefaults();
+		}
+
+		const int32 Index = IndexOf(Key);
+
+		if (Index == INDEX_NONE)
+		{
+			return false;
+		}
+
+		Params.RemoveAtSwap(Index);
+
+		return true;
+	}
+
+	bool Contains(FName Key) const
+	{
+		return (IndexOf(Key) != INDEX_NONE) || (Defaults.IsValid() && Defaults->Contains(Key));
+	}
+
+	int32 Num() const
+	{
+		int32 Count = Params.Num();
+
+		if (Defaults.IsValid())
+		{
+			for (const FParam& Param : Defaults->Params)
+			{
+				Count += (IndexOf(Param.Key) == INDEX_NONE) ? 1 : 0;
+			}
+		}
+
+		return Count;
+	}
+
+	void Empty()
+	{
+		Params.Empty();
+		Defaults.Reset();
+	}
+
+	/**
+	 * Calls a function for each parameter.
+	 *
+	 * @param Function The function to call with the key and value of each parameter.
+	 */
+	template <typename FunctionType>
+	void ForEach(FunctionType&& Function) const
+	{
+		for (const FParam& Param : Params)
+		{
+			Function(Param.Key, Param.Value);
+		}
+
+		if (Defaults.IsValid())
+		{
+			for (const FParam& Param : Defaults->Params)
+			{
+				if (IndexOf(Param.Key) == INDEX_NONE)
+				{
+					Function(Param.Key, Param.Value);
+				}
+			}
+		}
+	}
+
+	/**
+	 * Sets the shared defaults, which replace the previous ones.
+	 *
+	 * @param InDefaults The defaults (must not have defaults themselves).
+	 */
+	void SetDefaults(const TSharedRef<const FSGMessageParams, ESPMode::ThreadSafe>& InDefaults)
+	{
+		checkSlow(!InDefaults->Defaults.IsValid());
+
+		Defaults = InDefaults;
+	}
+
+private:
+	/** Copies the shared defaults that aren't shadowed into the parameters, and drops the defaults. */
+	void MaterializeDefaults()
+	{
+		const TSharedPtr<const FSGMessageParams, ESPMode::ThreadSafe> OldDefaults = MoveTemp(Defaults);
+
+		for (const FParam& Param : OldDefaults->Params)
+		{
+			if (IndexOf(Param.Key) == INDEX_NONE)
+			{
+				Params.Emplace(Param.Key, FSGAny(Param.Value));
+			}
+		}
+	}
+
+private:
+	int32 IndexOf(FName Key) const
+	{
+		for (int32 Index = 0; Index < Params.Num(); ++Index)
+		{
+			if (Params[Index].Key == Key)
+			{
+				return Index;
+			}
+		}
+
+		return INDEX_NONE;
+	}
+
+private:
+	struct FParam
+	{
+		FParam(FName InKey, FSGAny&& InValue)
+			: Key(InKey), Value(MoveTemp(InValue))
+		{
+		}
+
+		FName Key;
+
+		FSGAny Value;
+	};
+
+	static constexpr int32 NumInlineParams = 8;
+
+	TArray<FParam, TInlineAllocator<NumInlineParams>> Params;
+
+	/** Holds the shared defaults (nullptr = none). */
+	TSharedPtr<const FSGMessageParams, ESPMode::ThreadSafe> Defaults;
+};
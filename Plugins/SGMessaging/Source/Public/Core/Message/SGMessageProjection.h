@@ -0,0 +1,117 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGMessageParams.h"
+
+/**
+ * Implements the set of dynamic message parameters that a subscription reads (its projection).
+ *
+ * Subscribers that only read a few keys of large dynamic messages (see FSGMessage) declare them, so
+ * that message bridges only serialize the union of the keys that the subscribers of a remote node
+ * read, and that Blueprint deliveries only copy the declared keys:
+ *
+ *		FSGMessageProjection Projection;
+ *		Projection.Select(TEXT("Health")).Select(TEXT("Position"));
+ *
+ *		Endpoint->SetProjection(MessageTag, Projection);
+ *
+ * Recipients on other nodes only find the declared keys in the messages they receive, so every handler
+ * of the endpoint's message type must read nothing else. Typed messages are never projected.
+ *
+ * @see FSGMessageEndpoint::SetProjection, ISGMessageBus::GetRemoteProjections
+ */
+class FSGMessageProjection
+{
+public:
+
+	/** Default constructor (selects no keys). */
+	FSGMessageProjection() = default;
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InKeys The keys to select.
+	 */
+	explicit FSGMessageProjection(TArrayView<const FName> InKeys)
+	{
+		for (const FName& Key : InKeys)
+		{
+			Select(Key);
+		}
+	}
+
+public:
+
+	/**
+	 * Adds a key to the projection.
+	 *
+	 * @param Key The parameter key.
+	 * @return This instance (for method chaining).
+	 */
+	FSGMessageProjection& Select(const FSGMessageKey& Key)
+	{
+		if (!Key.Name.IsNone())
+		{
+			Keys.AddUnique(Key.Name);
+		}
+
+		return *this;
+	}
+
+	/**
+	 * Adds the keys of another projection to this projection.
+	 *
+	 * @param Other The projection to add.
+	 */
+	void Append(const FSGMessageProjection& Other)
+	{
+		for (const FName& Key : Other.Keys)
+		{
+			Keys.AddUnique(Key);
+		}
+	}
+
+	/** Removes all keys from the projection. */
+	void Reset()
+	{
+		Keys.Reset();
+	}
+
+	/**
+	 * Checks whether the projection selects a key.
+	 *
+	 * Projections hold a handful of keys, so a linear search beats hashing.
+	 *
+	 * @param Key The parameter key.
+	 * @return true if the key is selected, false otherwise.
+	 */
+	bool Contains(FName Key) const
+	{
+		return Keys.Contains(Key);
+	}
+
+	/**
+	 * Gets the selected keys.
+	 *
+	 * @return The keys.
+	 */
+	TArrayView<const FName> GetKeys() const
+	{
+		return Keys;
+	}
+
+	/**
+	 * Checks whether the projection selects no keys.
+	 *
+	 * @return true if it is empty, false otherwise.
+	 */
+	bool IsEmpty() const
+	{
+		return (Keys.Num() == 0);
+	}
+
+private:
+
+	/** Holds the selected keys. */
+	TArray<FName, TInlineAllocator<4>> Keys;
+};
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGMessage.h"
+#include "SGMessageBuilder.h"
+
+/**
+ * Implements a prototype for dynamic messages that are published over and over with the same keys.
+ *
+ * The prototype holds the default parameters once. Messages made from it share them and only store
+ * the parameters that are set on the message itself, so publishing a prototype with a few changed
+ * values allocates nothing but the message (from the message pool) and non-inline changed values.
+ *
+ *		static const FSGMessagePrototype HealthPrototype(TEXT("Health"), 100.0f, TEXT("Armor"), 0.0f);
+ *
+ *		Endpoint->PublishWithMessage(TopicID, MessageID, Parameter, HealthPrototype.With(MESSAGE_KEY("Health"), Health));
+ *
+ * Prototypes are safe to share between threads, but changing one is not. Messages that were made
+ * before a change keep the old defaults.
+ */
+class FSGMessagePrototype
+{
+public:
+	/** Creates an empty prototype. */
+	FSGMessagePrototype()
+		: Defaults(MakeShared<FSGMessageParams, ESPMode::ThreadSafe>())
+	{
+	}
+
+	/**
+	 * Creates and initializes a new prototype.
+	 *
+	 * @param InDefaults The default parameters, as alternating keys and values.
+	 */
+	template <typename... ArgTypes, typename = typename TEnableIf<(sizeof...(ArgTypes) >= 2)>::Type>
+	explicit FSGMessagePrototype(ArgTypes&&... InDefaults)
+	{
+		const FSGMessage Message(Forward<ArgTypes>(InDefaults)...);
+
+		Defaults = MakeShared<FSGMessageParams, ESPMode::ThreadSafe>(Message.GetParams());
+	}
+
+public:
+	/**
+	 * Sets a default parameter.
+	 *
+	 * Messages that were already made keep sharing the previous defaults, which are copied on write.
+	 *
+	 * @param Key The parameter key.
+	 * @param Value The default value.
+	 */
+	template <typename T>
+	void Set(const FSGMessageKey& Key, T&& Value)
+	{
+		if (!Defaults.IsUnique())
+		{
+			Defaults = MakeShared<FSGMessageParams, ESPMode::ThreadSafe>(*Defaults);
+		}
+
+		if constexpr (TIsLValueReferenceType<T>::Value)
+		{
+			TSGAnyProperty<typename TRemoveReference<decltype(Value)>::Type>(*Defaults, Key.Name)(Value);
+		}
+		else
+		{
+			Defaults->Add(Key.Name, FSGAny(MoveTemp(Value)));
+		}
+	}
+
+	/**
+	 * Makes a message from the prototype.
+	 *
+	 * @param InParams The parameters that differ from the defaults, as alternating keys and values.
+	 * @return The message, which is handed to a publish or send call like a built message.
+	 */
+	template <typename... ArgTypes>
+	FSGMessage* With(ArgTypes&&... InParams) const
+	{
+		FSGMessage* Message = FSGMessageBuilder::Builder<FSGMessage>(Forward<ArgTypes>(InParams)...);
+
+		Message->SetDefaults(Defaults);
+
+		return Message;
+	}
+
+	/** Gets the default parameters. */
+	const FSGMessageParams& GetDefaults() const
+	{
+		return *Defaults;
+	}
+
+private:
+	/** Holds the default parameters, shared with the messages made from the prototype. */
+	TSharedRef<FSGMessageParams, ESPMode::ThreadSafe> Defaults;
+};
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/Class.h"
+
+/**
+ * Implements the schema payload of a dynamic message.
+ *
+ * The payload is a copy of a structure instance, so that a message declared as a structure is copied
+ * in and out as a whole, without a parameter per property. Blueprints make and break the structure
+ * with the usual struct nodes, which the Blueprint compiler turns into direct member accesses.
+ *
+ * Payloads are immutable once created and shared by all copies of a message.
+ */
+class FSGMessageSchemaPayload
+{
+public:
+	/**
+	 * Creates and initializes a new payload.
+	 *
+	 * @param InStruct The structure of the payload.
+	 * @param Source The structure instance to copy.
+	 */
+	FSGMessageSchemaPayload(const UScriptStruct* InStruct, const void* Source)
+		: Struct(InStruct)
+		, Memory(FMemory::Malloc(FMath::Max(InStruct->GetStructureSize(), 1), InStruct->GetMinAlignment()))
+	{
+		Struct->InitializeStruct(Memory);
+		Struct->CopyScriptStruct(Memory, Source);
+	}
+
+	FSGMessageSchemaPayload(const FSGMessageSchemaPayload&) = delete;
+	FSGMessageSchemaPayload& operator=(const FSGMessageSchemaPayload&) = delete;
+
+	~FSGMessageSchemaPayload()
+	{
+		Struct->DestroyStruct(Memory);
+		FMemory::Free(Memory);
+	}
+
+public:
+	/** Gets the structure of the payload. */
+	const UScriptStruct* GetStruct() const
+	{
+		return Struct;
+	}
+
+	/** Gets the structure instance. */
+	const void* GetMemory() const
+	{
+		return Memory;
+	}
+
+	/**
+	 * Copies the payload into a structure instance.
+	 *
+	 * @param InStruct The structure of the destination, which must be the payload's structure.
+	 * @param Dest The structure instance to copy into.
+	 * @return true if the payload was copied, false if the structures differ.
+	 */
+	bool CopyTo(const UScriptStruct* InStruct, void* Dest) const
+	{
+		if (InStruct != Struct)
+		{
+			return false;
+		}
+
+		Struct->CopyScriptStruct(Dest, Memory);
+
+		return true;
+	}
+
+private:
+	/** Holds the structure of the payload. */
+	const UScriptStruct* Struct;
+
+	/** Holds the structure instance. */
+	void* Memory;
+};
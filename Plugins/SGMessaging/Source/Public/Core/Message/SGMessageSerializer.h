@@ -0,0 +1,238 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGMessage.h"
+#include "SGMessageWire.h"
+
+/**
+ * Enumerates the versions of the binary message encoding.
+ */
+enum class ESGMessageWireVersion : uint8
+{
+	Initial = 1,
+
+	// -----<new versions can be added above this line>-----
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1
+};
+
+/**
+ * Table of the parameter keys that were sent on a message stream.
+ *
+ * A key is written as a string the first time it is used and as its index in the table afterwards.
+ * The sender and the receiver of a stream each keep a table, which stay in sync as long as messages
+ * are read in the order they were written.
+ */
+class SGMESSAGING_API FSGMessageKeyTable
+{
+public:
+	/** Maximum number of interned keys, further keys are always written as strings. */
+	static constexpr int32 MaxKeys = 4096;
+
+	/**
+	 * Finds the index of a key.
+	 *
+	 * @param Key The key to find.
+	 * @return The index, or INDEX_NONE if the key isn't interned.
+	 */
+	int32 Find(FName Key) const
+	{
+		const int32* Index = Indices.Find(Key);
+
+		return Index != nullptr ? *Index : INDEX_NONE;
+	}
+
+	/**
+	 * Gets the key with the given index.
+	 *
+	 * @param Index The index of the key.
+	 * @param OutKey Will hold the key.
+	 * @return true if the index is valid, false otherwise.
+	 */
+	bool Get(int32 Index, FName& OutKey) const
+	{
+		if (!Keys.IsValidIndex(Index))
+		{
+			return false;
+		}
+
+		OutKey = Keys[Index];
+
+		return true;
+	}
+
+	/** Interns a key, unless the table is full. */
+	void Add(FName Key)
+	{
+		if ((Keys.Num() < MaxKeys) && !Indices.Contains(Key))
+		{
+			Indices.Add(Key, Keys.Add(Key));
+		}
+	}
+
+	/** Removes all keys, e.g. when the stream is reset. */
+	void Empty()
+	{
+		Keys.Empty();
+		Indices.Empty();
+	}
+
+private:
+	/** Holds the interned keys in the order they were added. */
+	TArray<FName> Keys;
+
+	/** Holds the keys' indices. */
+	TMap<FName, int32> Indices;
+};
+
+/**
+ * Implements the binary encoding of dynamic messages.
+ *
+ * A message is encoded as the version followed by its parameters, each written as its key, its type
+ * and its length-prefixed value. Numbers are variable-length, arrays of numbers and math types are
+ * written as one raw block, and structures use the binary struct serializer. Parameters that can't
+ * be encoded (objects, delegates and Blueprint container views) are skipped.
+ *
+ * The encoding relies on little-endian byte order for floating point values and math types.
+ *
+ * @see FSGMessageReader
+ */
+class SGMESSAGING_API FSGMessageSerializer
+{
+public:
+	/**
+	 * Encodes a message.
+	 *
+	 * @param Message The message to encode.
+	 * @param OutBytes The array to append the encoded message to.
+	 * @param KeyTable The key table of the message stream (optional).
+	 * @return true if all parameters were encoded, false if some were skipped.
+	 */
+	static bool Serialize(const FSGMessage& Message, TArray<uint8>& OutBytes, FSGMessageKeyTable* KeyTable = nullptr);
+};
+
+/**
+ * Implements a reader for encoded messages.
+ *
+ * The reader indexes the parameters when it is created, but leaves them encoded until they are
+ * requested, and it refers to the encoded bytes instead of copying them, so the bytes must stay
+ * valid while the reader is used.
+ *
+ *		FSGMessageReader Reader(Bytes);
+ *
+ *		float Health;
+ *
+ *		if (Reader.Get<float>(TEXT("Health"), Health))
+ *		{
+ *		}
+ *
+ * @see FSGMessageSerializer
+ */
+class SGMESSAGING_API FSGMessageReader
+{
+public:
+	/**
+	 * Creates and initializes a new reader.
+	 *
+	 * @param InBytes The encoded message.
+	 * @param KeyTable The key table of the message stream (optional, must match the writer's).
+	 */
+	explicit FSGMessageReader(TArrayView<const uint8> InBytes, FSGMessageKeyTable* KeyTable = nullptr);
+
+public:
+	/**
+	 * Checks whether the message was read successfully.
+	 *
+	 * @return true if the message is valid, false if it is malformed or of an unknown version.
+	 */
+	bool IsValid() const
+	{
+		return bValid;
+	}
+
+	/** Gets the number of parameters. */
+	int32 Num() const
+	{
+		return Fields.Num();
+	}
+
+	bool Contains(const FSGMessageKey& Key) const
+	{
+		return FindField(Key.Name) != nullptr;
+	}
+
+	/**
+	 * Gets the type of a parameter.
+	 *
+	 * @param Key The parameter key.
+	 * @return The type, or ESGAnyTypes::Empty if there is no such parameter.
+	 */
+	ESGAnyTypes GetType(const FSGMessageKey& Key) const
+	{
+		const FField* Field = FindField(Key.Name);
+
+		return Field != nullptr ? Field->Type : ESGAnyTypes::Empty;
+	}
+
+	/**
+	 * Decodes a parameter.
+	 *
+	 * @param Key The parameter key.
+	 * @param OutValue Will hold the value.
+	 * @return true if the parameter exists, has the given type and was decoded, false otherwise.
+	 */
+	template <typename T>
+	bool Get(const FSGMessageKey& Key, T& OutValue) const
+	{
+		const FField* Field = FindField(Key.Name);
+
+		if ((Field == nullptr) || (Field->Type != TSGAnyTraits<T>::GetType()))
+		{
+			return false;
+		}
+
+		FSGWireReader Reader(Field->Value);
+
+		return TSGWireTraits<T>::Read(Reader, OutValue) && Reader.IsAtEnd();
+	}
+
+	template <typename T>
+	T Get(const FSGMessageKey& Key) const
+	{
+		T Value{};
+
+		Get(Key, Value);
+
+		return Value;
+	}
+
+	/**
+	 * Decodes the parameters into a dynamic message.
+	 *
+	 * Only numbers, booleans, names, strings and texts are decoded, since the encoding doesn't record
+	 * the element types of containers or the types of enumerations and structures.
+	 *
+	 * @param OutMessage The message to add the parameters to.
+	 * @return The number of parameters that couldn't be decoded.
+	 */
+	int32 ReadMessage(FSGMessage& OutMessage) const;
+
+private:
+	struct FField
+	{
+		FName Key;
+
+		ESGAnyTypes Type;
+
+		TArrayView<const uint8> Value;
+	};
+
+	const FField* FindField(FName Key) const;
+
+private:
+	/** Holds the index of the parameters. */
+	TArray<FField, TInlineAllocator<8>> Fields;
+
+	/** Whether the message was read successfully. */
+	bool bValid;
+};
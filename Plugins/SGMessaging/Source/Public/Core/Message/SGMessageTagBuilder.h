@@ -19,15 +19,158 @@
 #include "Kismet/KismetStringLibrary.h"
 #endif
 
-class FSGMessageTagBuilder
+/**
+ * Inclusive range of topic identifiers matched by a topic subscription.
+ */
+struct FSGMessageTopicRange
 {
-public:
-	static FName Builder(MESSAGE_TAG_PARAM_SIGNATURE)
+	int32 First = 0;
+	int32 Last = -1;
+
+	FSGMessageTopicRange() = default;
+
+	FSGMessageTopicRange(int32 InFirst, int32 InLast)
+		: First(InFirst)
+		, Last(InLast)
+	{ }
+
+	bool Contains(int32 TopicID) const
+	{
+		return (TopicID >= First) && (TopicID <= Last);
+	}
+
+	bool IsSingleTopic() const
 	{
+		return First == Last;
+	}
+
+	bool operator==(const FSGMessageTopicRange& Other) const
+	{
+		return (First == Other.First) && (Last == Other.Last);
+	}
+};
+
+/**
+ * Builds and parses message tags ("TopicID:MessageID").
+ *
+ * Tags are routed by name, but each thread caches the names of the tags it used by their packed
+ * 64-bit value, so that building a tag on the hot path is a map probe instead of string formatting
+ * and a lookup in the global name table, and getting the topic of a tag needs no string parsing.
+ */
+class SGMESSAGING_API FSGMessageTagBuilder
+{
+public:
 #if MESSAGE_TAG_WITH_TOPIC
-		return FName(
-			UKismetStringLibrary::Conv_IntToString(TOPIC_ID) + ":" + UKismetStringLibrary::Conv_IntToString(
-				MESSAGE_ID));
+	/** Packs a topic and a message identifier into one 64-bit value. */
+	static constexpr uint64 Pack(MESSAGE_TAG_PARAM_SIGNATURE)
+	{
+		return ((uint64)(uint32)TOPIC_ID << 32) | (uint32)MESSAGE_ID;
+	}
+
+	/** Gets the topic identifier of a packed tag. */
+	static constexpr int32 GetTopicID(const uint64 PackedTag)
+	{
+		return (int32)(uint32)(PackedTag >> 32);
+	}
+
+	/** Gets the message identifier of a packed tag. */
+	static constexpr int32 GetMessageID(const uint64 PackedTag)
+	{
+		return (int32)(uint32)PackedTag;
+	}
+
+	/** Gets the name of the message tag for a topic and a message identifier. */
+	static FName Builder(MESSAGE_TAG_PARAM_SIGNATURE);
 #endif
+
+	/** Builds a pattern that matches every message of the given topic ("TopicID:*"). */
+	static FName TopicPattern(int32 TopicID)
+	{
+		return FName(FString::Printf(TEXT("%d:*"), TopicID));
+	}
+
+	/** Builds a pattern that matches every message of the given topics ("FirstTopicID-LastTopicID:*"). */
+	static FName TopicRangePattern(int32 FirstTopicID, int32 LastTopicID)
+	{
+		if (FirstTopicID == LastTopicID)
+		{
+			return TopicPattern(FirstTopicID);
+		}
+
+		return FName(FString::Printf(TEXT("%d-%d:*"), FirstTopicID, LastTopicID));
+	}
+
+	/** Parses a topic pattern built by TopicPattern or TopicRangePattern. */
+	static bool TryParseTopicPattern(const FName& Pattern, FSGMessageTopicRange& OutRange)
+	{
+		const FString PatternString = Pattern.ToString();
+
+		if (!PatternString.EndsWith(TEXT(":*"), ESearchCase::CaseSensitive))
+		{
+			return false;
+		}
+
+		const FString TopicString = PatternString.LeftChop(2);
+		FString FirstString;
+		FString LastString;
+
+		if (!TopicString.Split(TEXT("-"), &FirstString, &LastString, ESearchCase::CaseSensitive) || FirstString.IsEmpty())
+		{
+			FirstString = TopicString;
+			LastString = TopicString;
+		}
+
+		if (!IsInteger(FirstString) || !IsInteger(LastString))
+		{
+			return false;
+		}
+
+		OutRange = FSGMessageTopicRange(FCString::Atoi(*FirstString), FCString::Atoi(*LastString));
+
+		return OutRange.First <= OutRange.Last;
+	}
+
+	/** Gets the topic identifier of a message tag built by Builder ("TopicID:MessageID"). */
+	static bool TryParseTopicID(const FName& MessageTag, int32& OutTopicID);
+
+private:
+	static bool ParseTopicID(const FName& MessageTag, int32& OutTopicID)
+	{
+		const FString TagString = MessageTag.ToString();
+		int32 SeparatorIndex = INDEX_NONE;
+
+		if (!TagString.FindChar(TEXT(':'), SeparatorIndex))
+		{
+			return false;
+		}
+
+		const FString TopicString = TagString.Left(SeparatorIndex);
+
+		if (!IsInteger(TopicString))
+		{
+			return false;
+		}
+
+		OutTopicID = FCString::Atoi(*TopicString);
+
+		return true;
+	}
+
+	static bool IsInteger(const FString& String)
+	{
+		if (String.IsEmpty())
+		{
+			return false;
+		}
+
+		for (int32 Index = (String[0] == TEXT('-')) ? 1 : 0; Index < String.Len(); ++Index)
+		{
+			if (!FChar::IsDigit(String[Index]))
+			{
+				return false;
+			}
+		}
+
+		return String != TEXT("-");
 	}
 };
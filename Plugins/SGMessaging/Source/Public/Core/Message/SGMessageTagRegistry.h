@@ -0,0 +1,129 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGMessageTagBuilder.h"
+#include "Misc/ScopeLock.h"
+
+/**
+ * Structure for a message tag declared with DECLARE_MESSAGE_TAG.
+ */
+struct FSGRegisteredMessageTag
+{
+	/** The topic identifier. */
+	int32 TopicID = 0;
+
+	/** The message identifier. */
+	int32 MessageID = 0;
+
+	/** The dense index of the tag in the registry. */
+	int32 Index = INDEX_NONE;
+
+	/** The readable name of the tag (its declaration name). */
+	const TCHAR* DebugName = nullptr;
+
+	/** The name of the tag's payload type. */
+	const TCHAR* PayloadTypeName = nullptr;
+};
+
+/**
+ * Implements the registry of declared message tags.
+ *
+ * Tags are registered during static initialization and get a dense index in registration order. Two
+ * declarations of the same topic and message identifier with different names are reported as
+ * collisions when the messaging module starts (or right away for modules loaded later).
+ */
+class SGMESSAGING_API FSGMessageTagRegistry
+{
+public:
+	/** Gets the registry. */
+	static FSGMessageTagRegistry& Get();
+
+	/**
+	 * Registers a message tag.
+	 *
+	 * @param TopicID The topic identifier.
+	 * @param MessageID The message identifier.
+	 * @param DebugName The readable name of the tag (must be a literal).
+	 * @param PayloadTypeName The name of the payload type (must be a literal).
+	 * @return The dense index of the tag.
+	 */
+	int32 Register(int32 TopicID, int32 MessageID, const TCHAR* DebugName, const TCHAR* PayloadTypeName);
+
+	/**
+	 * Finds a registered tag.
+	 *
+	 * @param TopicID The topic identifier.
+	 * @param MessageID The message identifier.
+	 * @param OutTag Will hold the tag.
+	 * @return true if the tag was registered, false otherwise.
+	 */
+	bool Find(int32 TopicID, int32 MessageID, FSGRegisteredMessageTag& OutTag) const;
+
+	/**
+	 * Finds a registered tag by the name built by FSGMessageTagBuilder.
+	 *
+	 * @param MessageTag The name of the message tag.
+	 * @param OutTag Will hold the tag.
+	 * @return true if the tag was registered, false otherwise.
+	 */
+	bool Find(const FName& MessageTag, FSGRegisteredMessageTag& OutTag) const;
+
+	/**
+	 * Gets all registered tags.
+	 *
+	 * @return The tags, ordered by index.
+	 */
+	TArray<FSGRegisteredMessageTag> GetTags() const;
+
+	/** Reports the collisions of tags registered so far, and reports later collisions immediately. */
+	void Initialize();
+
+private:
+	/** Reports a collision between two registrations. */
+	static void ReportCollision(const FSGRegisteredMessageTag& Existing, const TCHAR* DebugName);
+
+private:
+	/** Guards the registry, since modules may be loaded on any thread. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Holds the registered tags by index. */
+	TArray<FSGRegisteredMessageTag> Tags;
+
+	/** Holds the tag indices by packed tag. */
+	TMap<uint64, int32> Indices;
+
+	/** Holds the collisions found before the registry was initialized (indices of the existing tags and the names of the colliding ones). */
+	TArray<TPair<int32, const TCHAR*>> PendingCollisions;
+
+	/** Whether the registry was initialized. */
+	bool bInitialized = false;
+};
+
+/**
+ * Declares a message tag.
+ *
+ * Declares a structure that holds the tag's identifiers and payload type, and registers the tag at
+ * startup so that collisions are detected and tools can show its name.
+ *
+ *		DECLARE_MESSAGE_TAG(FHealthChangedTag, Topic_Gameplay, Gameplay_HealthChanged, FSGMessage)
+ *
+ *		Endpoint->PublishWithMessage(FHealthChangedTag::TopicID, FHealthChangedTag::MessageID, Parameter, ...);
+ *
+ * @param Name The name of the tag structure.
+ * @param InTopicID The topic identifier.
+ * @param InMessageID The message identifier.
+ * @param PayloadType The type of the message payload.
+ */
+#define DECLARE_MESSAGE_TAG(Name, InTopicID, InMessageID, PayloadType) \
+	struct Name \
+	{ \
+		static constexpr TOPIC_ID_TYPE TopicID = InTopicID; \
+		static constexpr MESSAGE_ID_TYPE MessageID = InMessageID; \
+		using FPayload = PayloadType; \
+		static int32 GetIndex() \
+		{ \
+			static const int32 Index = FSGMessageTagRegistry::Get().Register(TopicID, MessageID, TEXT(#Name), TEXT(#PayloadType)); \
+			return Index; \
+		} \
+	}; \
+	inline const int32 Name##_RegisteredIndex = Name::GetIndex();
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Misc/ScopeLock.h"
+#include "UObject/Class.h"
+#include <atomic>
+
+class ISGMessageContext;
+
+/**
+ * Structure for a message structure registered with FSGMessageTypeRegistry.
+ */
+struct FSGRegisteredMessageType
+{
+	/** The message structure (types are registered for the lifetime of the module that declares them). */
+	UScriptStruct* Struct = nullptr;
+
+	/** The name of the structure, which is the routing key of its messages. */
+	FName Name;
+
+	/** The dense identifier of the type in the registry. */
+	int32 Id = INDEX_NONE;
+};
+
+/**
+ * Implements the registry of message structures.
+ *
+ * Structures get a dense identifier when they are first used as a message type, either through
+ * TSGMessageType or when a message of the structure is sent. The message router uses the
+ * identifiers to index its subscription tables, so struct messages are routed without hashing
+ * their names.
+ *
+ * Identifiers are only valid for the lifetime of the process and are never sent over the network.
+ */
+class SGMESSAGING_API FSGMessageTypeRegistry
+{
+public:
+	/** Gets the registry. */
+	static FSGMessageTypeRegistry& Get();
+
+	/**
+	 * Registers a message structure, unless it was registered already.
+	 *
+	 * @param Struct The message structure.
+	 * @return The registered type.
+	 */
+	FSGRegisteredMessageType Register(UScriptStruct* Struct);
+
+	/**
+	 * Gets the identifier of a message structure, registering it if needed.
+	 *
+	 * Lookups are served from a per-thread cache, so the registry lock is only taken the first
+	 * time that a thread sees a structure.
+	 *
+	 * @param Struct The message structure.
+	 * @return The dense identifier, or INDEX_NONE if Struct is nullptr.
+	 */
+	int32 GetTypeId(UScriptStruct* Struct);
+
+	/**
+	 * Gets the names of all registered types.
+	 *
+	 * Structures of the same name in different packages have their own identifiers, but share the
+	 * routing key of their name.
+	 *
+	 * @param OutNames Will hold the names, indexed by type identifier.
+	 */
+	void GetTypeNames(TArray<FName>& OutNames) const;
+
+	/**
+	 * Reports a message that a handler dropped, because it isn't of the type the handler expects.
+	 *
+	 * Each pair of message tag and expected type is logged once, so a publisher that keeps using the
+	 * wrong type doesn't flood the log.
+	 *
+	 * @param Context The context of the dropped message.
+	 * @param ExpectedType The name of the type the handler expects.
+	 */
+	void ReportMismatchedMessage(const ISGMessageContext& Context, const FName& ExpectedType);
+
+	/**
+	 * Gets the number of registered types.
+	 *
+	 * Identifiers are assigned in registration order, so all identifiers are less than this number.
+	 *
+	 * @return Number of types.
+	 */
+	int32 Num() const
+	{
+		return NumTypes.load(std::memory_order_acquire);
+	}
+
+private:
+	/** Guards the registry, since messages are sent from any thread. */
+	mutable FCriticalSection CriticalSection;
+
+	/** Holds the registered types by identifier. */
+	TArray<FSGRegisteredMessageType> Types;
+
+	/** Holds the type identifiers by structure. */
+	TMap<const UScriptStruct*, int32> StructIds;
+
+	/** Holds the number of registered types. */
+	std::atomic<int32> NumTypes{0};
+
+	/** Holds the message tags and expected types of the mismatches that were logged. */
+	TSet<TPair<FName, FName>> ReportedMismatches;
+};
+
+/**
+ * Template for the registration of a message structure.
+ *
+ * The structure is registered the first time that any of the functions is called, and the result
+ * is kept in a function static, so later calls neither hash the name nor resolve the structure.
+ *
+ *		Endpoint->Subscribe(TSGMessageType<FMyMessage>::GetName(), ScopeRange);
+ *
+ * @param MessageType The type of the message structure.
+ */
+template<typename MessageType>
+struct TSGMessageType
+{
+	/** Gets the dense identifier of the structure. */
+	static int32 GetId()
+	{
+		return GetRegistered().Id;
+	}
+
+	/** Gets the name of the structure, which is the routing key of its messages. */
+	static FName GetName()
+	{
+		return GetRegistered().Name;
+	}
+
+	/** Gets the structure. */
+	static UScriptStruct* GetStruct()
+	{
+		return GetRegistered().Struct;
+	}
+
+private:
+	static const FSGRegisteredMessageType& GetRegistered()
+	{
+		static const FSGRegisteredMessageType Registered = FSGMessageTypeRegistry::Get().Register(MessageType::StaticStruct());
+		return Registered;
+	}
+};
@@ -0,0 +1,712 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "SGAnyType.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+
+/**
+ * Appends values in the binary message encoding (see FSGMessageSerializer).
+ *
+ * Integers are written as variable-length quantities (7 bits per byte, signed values zigzag encoded),
+ * floating point values and math types as their little-endian bytes, and strings as UTF-8 with a
+ * length prefix.
+ */
+class FSGWireWriter
+{
+public:
+	explicit FSGWireWriter(TArray<uint8>& InBytes)
+		: Bytes(InBytes)
+	{
+	}
+
+	void WriteByte(uint8 Value)
+	{
+		Bytes.Add(Value);
+	}
+
+	void WriteVarint(uint64 Value)
+	{
+		while (Value >= 0x80)
+		{
+			Bytes.Add((uint8)(Value | 0x80));
+			Value >>= 7;
+		}
+
+		Bytes.Add((uint8)Value);
+	}
+
+	void WriteSignedVarint(int64 Value)
+	{
+		WriteVarint(((uint64)Value << 1) ^ (uint64)(Value >> 63));
+	}
+
+	void WriteBytes(const void* Data, int64 Num)
+	{
+		Bytes.Append((const uint8*)Data, Num);
+	}
+
+	void WriteString(const FString& Value)
+	{
+		const FTCHARToUTF8 Utf8(*Value, Value.Len());
+
+		WriteVarint(Utf8.Length());
+		WriteBytes(Utf8.Get(), Utf8.Length());
+	}
+
+	/**
+	 * Writes a value with a length prefix, so that readers can skip it without decoding it.
+	 *
+	 * @param Write The function that writes the value.
+	 */
+	template <typename FunctionType>
+	void WriteSized(FunctionType&& Write)
+	{
+		const int32 SizeOffset = Bytes.Num();
+
+		// most values are short, so reserve one byte for the size and make room for more afterwards
+		Bytes.Add(0);
+		Write();
+
+		uint64 Size = Bytes.Num() - SizeOffset - 1;
+		uint8 SizeBytes[10];
+		int32 NumSizeBytes = 0;
+
+		do
+		{
+			SizeBytes[NumSizeBytes++] = (uint8)(Size | 0x80);
+			Size >>= 7;
+		}
+		while (Size > 0);
+
+		SizeBytes[NumSizeBytes - 1] &= 0x7F;
+
+		if (NumSizeBytes > 1)
+		{
+			Bytes.InsertUninitialized(SizeOffset + 1, NumSizeBytes - 1);
+		}
+
+		FMemory::Memcpy(Bytes.GetData() + SizeOffset, SizeBytes, NumSizeBytes);
+	}
+
+	TArray<uint8>& GetBytes()
+	{
+		return Bytes;
+	}
+
+private:
+	TArray<uint8>& Bytes;
+};
+
+/**
+ * Reads values in the binary message encoding from a range of bytes without copying them.
+ *
+ * Reading past the end of the range sets an error flag, after which all reads fail.
+ */
+class FSGWireReader
+{
+public:
+	explicit FSGWireReader(TArrayView<const uint8> InBytes)
+		: Bytes(InBytes)
+	{
+	}
+
+	bool ReadByte(uint8& OutValue)
+	{
+		if (!Ensure(1))
+		{
+			return false;
+		}
+
+		OutValue = Bytes[Offset++];
+
+		return true;
+	}
+
+	bool ReadVarint(uint64& OutValue)
+	{
+		OutValue = 0;
+
+		for (uint32 Shift = 0; Shift < 64; Shift += 7)
+		{
+			uint8 Byte;
+
+			if (!ReadByte(Byte))
+			{
+				return false;
+			}
+
+			OutValue |= (uint64)(Byte & 0x7F) << Shift;
+
+			if ((Byte & 0x80) == 0)
+			{
+				return true;
+			}
+		}
+
+		bError = true;
+
+		return false;
+	}
+
+	bool ReadSignedVarint(int64& OutValue)
+	{
+		uint64 Value;
+
+		if (!ReadVarint(Value))
+		{
+			return false;
+		}
+
+		OutValue = (int64)(Value >> 1) ^ -(int64)(Value & 1);
+
+		return true;
+	}
+
+	/** Reads a count or size and checks that it is plausible for the remaining bytes. */
+	bool ReadCount(int32& OutCount, int64 MinBytesPerItem = 1)
+	{
+		uint64 Count;
+
+		if (!ReadVarint(Count) || (Count > MAX_int32) || (Count * FMath::Max<int64>(MinBytesPerItem, 0) > (uint64)(Bytes.Num() - Offset)))
+		{
+			bError = true;
+
+			return false;
+		}
+
+		OutCount = (int32)Count;
+
+		return true;
+	}
+
+	/**
+	 * Gets a view of the next bytes and skips them.
+	 *
+	 * @param Num The number of bytes.
+	 * @return The bytes, or nullptr if the range is too short.
+	 */
+	const uint8* ReadBytes(int64 Num)
+	{
+		if (!Ensure(Num))
+		{
+			return nullptr;
+		}
+
+		const uint8* Data = Bytes.GetData() + Offset;
+
+		Offset += Num;
+
+		return Data;
+	}
+
+	bool ReadString(FString& OutValue)
+	{
+		int32 Length;
+
+		if (!ReadCount(Length))
+		{
+			return false;
+		}
+
+		const FUTF8ToTCHAR Converted((const ANSICHAR*)ReadBytes(Length), Length);
+
+		OutValue = FString(Converted.Length(), Converted.Get());
+
+		return true;
+	}
+
+	/** Reads a length-prefixed value (see FSGWireWriter::WriteSized) and returns a view of its bytes. */
+	bool ReadSized(TArrayView<const uint8>& OutBytes)
+	{
+		int32 Size;
+
+		if (!ReadCount(Size))
+		{
+			return false;
+		}
+
+		OutBytes = Bytes.Slice(Offset, Size);
+		Offset += Size;
+
+		return true;
+	}
+
+	int32 Tell() const
+	{
+		return Offset;
+	}
+
+	bool IsAtEnd() const
+	{
+		return Offset == Bytes.Num();
+	}
+
+	bool HasError() const
+	{
+		return bError;
+	}
+
+private:
+	bool Ensure(int64 Num)
+	{
+		bError |= (Num < 0) || (Num > Bytes.Num() - Offset);
+
+		return !bError;
+	}
+
+private:
+	TArrayView<const uint8> Bytes;
+
+	int32 Offset = 0;
+
+	bool bError = false;
+};
+
+
+/* Wire traits
+ *****************************************************************************/
+
+/**
+ * Checks whether values of a type are written as plain bytes (or a single number), so that arrays
+ * of them can be written as one raw block.
+ */
+template <typename T>
+struct TSGWireIsRawValue
+{
+	enum
+	{
+		Value = TIsArithmetic<T>::Value || TIsEnum<T>::Value ||
+		TIsSame<T, FVector>::Value || TIsSame<T, FVector2D>::Value || TIsSame<T, FVector4>::Value ||
+		TIsSame<T, FRotator>::Value || TIsSame<T, FQuat>::Value || TIsSame<T, FLinearColor>::Value ||
+		TIsSame<T, FColor>::Value || TIsSame<T, FIntPoint>::Value || TIsSame<T, FIntVector>::Value
+	};
+};
+
+/**
+ * Stub for wire traits.
+ *
+ * Types that can be encoded specialize this template with static Write and Read functions. Types
+ * without a specialization (objects, delegates, Blueprint container views) are not encoded.
+ *
+ * @param T The type of the value.
+ */
+template <typename T, typename Enable = void>
+struct TSGWireTraits
+{
+	static constexpr bool bSupported = false;
+};
+
+template <typename T>
+struct TSGWireTraits<T, typename TEnableIf<TSGWireIsRawValue<T>::Value>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = T;
+
+	static void Write(FSGWireWriter& Writer, const T& Value)
+	{
+		if constexpr (TIsSame<T, bool>::Value)
+		{
+			Writer.WriteByte(Value ? 1 : 0);
+		}
+		else if constexpr (TIsEnum<T>::Value)
+		{
+			Writer.WriteSignedVarint((int64)Value);
+		}
+		else if constexpr (TIsIntegral<T>::Value)
+		{
+			if constexpr (TIsSigned<T>::Value)
+			{
+				Writer.WriteSignedVarint(Value);
+			}
+			else
+			{
+				Writer.WriteVarint(Value);
+			}
+		}
+		else
+		{
+			Writer.WriteBytes(&Value, sizeof(T));
+		}
+	}
+
+	static bool Read(FSGWireReader& Reader, T& OutValue)
+	{
+		if constexpr (TIsSame<T, bool>::Value)
+		{
+			uint8 Value;
+
+			if (!Reader.ReadByte(Value))
+			{
+				return false;
+			}
+
+			OutValue = (Value != 0);
+
+			return true;
+		}
+		else if constexpr (TIsEnum<T>::Value)
+		{
+			int64 Value;
+
+			if (!Reader.ReadSignedVarint(Value))
+			{
+				return false;
+			}
+
+			OutValue = (T)Value;
+
+			return true;
+		}
+		else if constexpr (TIsIntegral<T>::Value)
+		{
+			if constexpr (TIsSigned<T>::Value)
+			{
+				int64 Value;
+
+				if (!Reader.ReadSignedVarint(Value))
+				{
+					return false;
+				}
+
+				OutValue = (T)Value;
+			}
+			else
+			{
+				uint64 Value;
+
+				if (!Reader.ReadVarint(Value))
+				{
+					return false;
+				}
+
+				OutValue = (T)Value;
+			}
+
+			return true;
+		}
+		else
+		{
+			const uint8* Data = Reader.ReadBytes(sizeof(T));
+
+			if (Data == nullptr)
+			{
+				return false;
+			}
+
+			FMemory::Memcpy(&OutValue, Data, sizeof(T));
+
+			return true;
+		}
+	}
+};
+
+template <typename T>
+struct TSGWireTraits<TEnumAsByte<T>>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = TEnumAsByte<T>;
+
+	static void Write(FSGWireWriter& Writer, const TEnumAsByte<T>& Value)
+	{
+		Writer.WriteByte(Value.GetIntValue());
+	}
+
+	static bool Read(FSGWireReader& Reader, TEnumAsByte<T>& OutValue)
+	{
+		uint8 Value;
+
+		if (!Reader.ReadByte(Value))
+		{
+			return false;
+		}
+
+		OutValue = (T)Value;
+
+		return true;
+	}
+};
+
+template <>
+struct TSGWireTraits<FString>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = FString;
+
+	static void Write(FSGWireWriter& Writer, const FString& Value)
+	{
+		Writer.WriteString(Value);
+	}
+
+	static bool Read(FSGWireReader& Reader, FString& OutValue)
+	{
+		return Reader.ReadString(OutValue);
+	}
+};
+
+template <>
+struct TSGWireTraits<FName>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = FName;
+
+	static void Write(FSGWireWriter& Writer, const FName& Value)
+	{
+		Writer.WriteString(Value.ToString());
+	}
+
+	static bool Read(FSGWireReader& Reader, FName& OutValue)
+	{
+		FString Value;
+
+		if (!Reader.ReadString(Value))
+		{
+			return false;
+		}
+
+		OutValue = FName(*Value);
+
+		return true;
+	}
+};
+
+/** Texts are written as their display strings, so receivers get culture invariant texts. */
+template <>
+struct TSGWireTraits<FText>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = FText;
+
+	static void Write(FSGWireWriter& Writer, const FText& Value)
+	{
+		Writer.WriteString(Value.ToString());
+	}
+
+	static bool Read(FSGWireReader& Reader, FText& OutValue)
+	{
+		FString Value;
+
+		if (!Reader.ReadString(Value))
+		{
+			return false;
+		}
+
+		OutValue = FText::FromString(MoveTemp(Value));
+
+		return true;
+	}
+};
+
+/** Arrays of raw values are written as one block: count, element size, then the elements' bytes. */
+template <typename T>
+struct TSGWireTraits<TArray<T>, typename TEnableIf<TSGWireTraits<T>::bSupported>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = TArray<T>;
+
+	static void Write(FSGWireWriter& Writer, const TArray<T>& Value)
+	{
+		Writer.WriteVarint(Value.Num());
+
+		if constexpr (TSGWireIsRawValue<T>::Value)
+		{
+			Writer.WriteVarint(sizeof(T));
+			Writer.WriteBytes(Value.GetData(), (int64)Value.Num() * sizeof(T));
+		}
+		else
+		{
+			for (const T& Element : Value)
+			{
+				TSGWireTraits<T>::Write(Writer, Element);
+			}
+		}
+	}
+
+	static bool Read(FSGWireReader& Reader, TArray<T>& OutValue)
+	{
+		int32 Num;
+
+		if constexpr (TSGWireIsRawValue<T>::Value)
+		{
+			uint64 ElementSize;
+
+			if (!Reader.ReadCount(Num, sizeof(T)) || !Reader.ReadVarint(ElementSize) || (ElementSize != sizeof(T)))
+			{
+				return false;
+			}
+
+			const uint8* Data = Reader.ReadBytes((int64)Num * sizeof(T));
+
+			if (Data == nullptr)
+			{
+				return false;
+			}
+
+			OutValue.SetNumUninitialized(Num);
+			FMemory::Memcpy(OutValue.GetData(), Data, (int64)Num * sizeof(T));
+
+			return true;
+		}
+		else
+		{
+			if (!Reader.ReadCount(Num))
+			{
+				return false;
+			}
+
+			OutValue.Reset(Num);
+
+			for (int32 Index = 0; Index < Num; ++Index)
+			{
+				if (!TSGWireTraits<T>::Read(Reader, OutValue.AddDefaulted_GetRef()))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+	}
+};
+
+template <typename T>
+struct TSGWireTraits<TSet<T>, typename TEnableIf<TSGWireTraits<T>::bSupported>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = TSet<T>;
+
+	static void Write(FSGWireWriter& Writer, const TSet<T>& Value)
+	{
+		Writer.WriteVarint(Value.Num());
+
+		for (const T& Element : Value)
+		{
+			TSGWireTraits<T>::Write(Writer, Element);
+		}
+	}
+
+	static bool Read(FSGWireReader& Reader, TSet<T>& OutValue)
+	{
+		int32 Num;
+
+		if (!Reader.ReadCount(Num))
+		{
+			return false;
+		}
+
+		OutValue.Empty(Num);
+
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			T Element;
+
+			if (!TSGWireTraits<T>::Read(Reader, Element))
+			{
+				return false;
+			}
+
+			OutValue.Add(MoveTemp(Element));
+		}
+
+		return true;
+	}
+};
+
+template <typename K, typename V>
+struct TSGWireTraits<TMap<K, V>, typename TEnableIf<TSGWireTraits<K>::bSupported && TSGWireTraits<V>::bSupported>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = TMap<K, V>;
+
+	static void Write(FSGWireWriter& Writer, const TMap<K, V>& Value)
+	{
+		Writer.WriteVarint(Value.Num());
+
+		for (const auto& Pair : Value)
+		{
+			TSGWireTraits<K>::Write(Writer, Pair.Key);
+			TSGWireTraits<V>::Write(Writer, Pair.Value);
+		}
+	}
+
+	static bool Read(FSGWireReader& Reader, TMap<K, V>& OutValue)
+	{
+		int32 Num;
+
+		if (!Reader.ReadCount(Num))
+		{
+			return false;
+		}
+
+		OutValue.Empty(Num);
+
+		for (int32 Index = 0; Index < Num; ++Index)
+		{
+			K Key;
+
+			if (!TSGWireTraits<K>::Read(Reader, Key) || !TSGWireTraits<V>::Read(Reader, OutValue.Add(MoveTemp(Key))))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+};
+
+/** Structures are written with the standard binary struct serializer, prefixed with their size. */
+template <typename T>
+struct TSGWireTraits<T, typename TEnableIf<TSGIsUStruct<T>::Value && !TSGIsUObject<T>::Value && !TSGWireIsRawValue<T>::Value>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = T;
+
+	static void Write(FSGWireWriter& Writer, const T& Value)
+	{
+		Writer.WriteSized([&Writer, &Value]()
+		{
+			FMemoryWriter Archive(Writer.GetBytes(), false, true);
+
+			T::StaticStruct()->SerializeBin(Archive, const_cast<T*>(&Value));
+		});
+	}
+
+	static bool Read(FSGWireReader& Reader, T& OutValue)
+	{
+		TArrayView<const uint8> StructBytes;
+
+		if (!Reader.ReadSized(StructBytes))
+		{
+			return false;
+		}
+
+		FMemoryReaderView Archive(StructBytes);
+
+		T::StaticStruct()->SerializeBin(Archive, &OutValue);
+
+		return !Archive.IsError();
+	}
+};
+
+/** Shared payloads are written as their value, so receivers read them as plain values. */
+template <typename T>
+struct TSGWireTraits<TSharedPtr<const T, ESPMode::ThreadSafe>, typename TEnableIf<TSGWireTraits<T>::bSupported>::Type>
+{
+	static constexpr bool bSupported = true;
+
+	using ValueType = T;
+
+	static void Write(FSGWireWriter& Writer, const TSharedPtr<const T, ESPMode::ThreadSafe>& Value)
+	{
+		TSGWireTraits<T>::Write(Writer, Value.IsValid() ? *Value : T());
+	}
+};
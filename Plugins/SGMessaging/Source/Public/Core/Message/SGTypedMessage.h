@@ -0,0 +1,176 @@
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessage.h"
+#include "SGAnyTypeTemplate.h"
+
+namespace SGTypedMessage
+{
+	/**
+	 * Computes the key of a typed message field at compile time (32-bit FNV-1a hash of its name).
+	 *
+	 * @param Name The name of the field.
+	 * @return The field key.
+	 */
+	template <typename CharType>
+	constexpr uint32 Key(const CharType* Name)
+	{
+		uint32 Hash = 2166136261u;
+
+		for (; *Name != 0; ++Name)
+		{
+			Hash = (Hash ^ (uint32)*Name) * 16777619u;
+		}
+
+		return Hash;
+	}
+
+	/** Gets the index of the field with the given key (or the number of fields if there is none). */
+	template <uint32 FieldKey, typename... FieldTypes>
+	struct TFieldIndex
+	{
+		static constexpr int32 Value = 0;
+	};
+
+	template <uint32 FieldKey, typename FieldType, typename... FieldTypes>
+	struct TFieldIndex<FieldKey, FieldType, FieldTypes...>
+	{
+		static constexpr int32 Value = (FieldType::Key == FieldKey) ? 0 : 1 + TFieldIndex<FieldKey, FieldTypes...>::Value;
+	};
+
+	/** Checks that no two fields share a key. */
+	template <typename... FieldTypes>
+	struct TAreKeysUnique
+	{
+		static constexpr bool Value = true;
+	};
+
+	template <typename FieldType, typename... FieldTypes>
+	struct TAreKeysUnique<FieldType, FieldTypes...>
+	{
+		static constexpr bool Value = (TFieldIndex<FieldType::Key, FieldTypes...>::Value == sizeof...(FieldTypes)) && TAreKeysUnique<FieldTypes...>::Value;
+	};
+
+}
+
+/**
+ * Declares a field of a typed message.
+ *
+ * @param InKey The key of the field (see SGTypedMessage::Key).
+ * @param InType The type of the field's value.
+ */
+template <uint32 InKey, typename InType>
+struct TSGMessageField
+{
+	static constexpr uint32 Key = InKey;
+
+	using Type = InType;
+};
+
+/**
+ * Template for messages whose fields are declared at compile time.
+ *
+ * Fields are stored in a fixed layout and accessed by their compile-time key, so reading and writing
+ * them needs no parameter lookup, no type-erased values and no runtime type checks. Typed messages
+ * are published with the same message tags as FSGMessage, but subscribers must name the typed
+ * message in their Subscribe call. Each field list has a message name of its own, which handlers check
+ * before they cast, so other messages published with the same tag are dropped instead of misread.
+ * The dynamic FSGMessage remains the message type for Blueprints.
+ *
+ *		using FSGHealthChangedMessage = TSGTypedMessage<
+ *			TSGMessageField<SGTypedMessage::Key("Health"), float>,
+ *			TSGMessageField<SGTypedMessage::Key("Instigator"), TWeakObjectPtr<AActor>>>;
+ *
+ *		Endpoint->PublishWithMessage(TopicID, MessageID, Parameter, FSGMessageBuilder::Builder<FSGHealthChangedMessage>(Health, Instigator));
+ *
+ *		Endpoint->Subscribe<FSGHealthChangedMessage>(TopicID, MessageID, [](const FSGHealthChangedMessage& Message, const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+ *		{
+ *			const float Health = Message.Get<SGTypedMessage::Key("Health")>();
+ *		});
+ *
+ * @param FieldTypes The fields of the message (see TSGMessageField).
+ */
+template <typename... FieldTypes>
+class TSGTypedMessage
+	: public ISGMessage
+{
+	static_assert(SGTypedMessage::TAreKeysUnique<FieldTypes...>::Value, "Typed message fields must have unique keys");
+
+public:
+	/** Number of fields in this message. */
+	static constexpr int32 NumFields = sizeof...(FieldTypes);
+
+	TSGTypedMessage() = default;
+
+	/**
+	 * Creates and initializes a new message.
+	 *
+	 * @param InValues The values of all fields, in declaration order.
+	 */
+	template <typename... ArgTypes, typename = typename TEnableIf<(sizeof...(ArgTypes) == sizeof...(FieldTypes)) && (sizeof...(ArgTypes) > 0)>::Type>
+	explicit TSGTypedMessage(ArgTypes&&... InValues)
+		: Values(Forward<ArgTypes>(InValues)...)
+	{
+	}
+
+public:
+	virtual FName GetFName() const override
+	{
+		return StaticMessageName();
+	}
+
+	/** Gets the name that GetFName returns for messages with this field list. */
+	static FName StaticMessageName()
+	{
+		// the type identifier spells out the keys and value types of all fields, and is the same in every module
+		static const FName MessageName(*FString::Printf(TEXT("TSGTypedMessage_%016llx"), TSGAnyTypeId<TSGTypedMessage>::GetId()));
+
+		return MessageName;
+	}
+
+public:
+	/**
+	 * Gets the value of a field.
+	 *
+	 * @param FieldKey The key of the field.
+	 * @return The field value.
+	 */
+	template <uint32 FieldKey>
+	auto& Get()
+	{
+		return Values.template Get<GetFieldIndex<FieldKey>()>();
+	}
+
+	template <uint32 FieldKey>
+	const auto& Get() const
+	{
+		return Values.template Get<GetFieldIndex<FieldKey>()>();
+	}
+
+	/**
+	 * Sets the value of a field.
+	 *
+	 * @param FieldKey The key of the field.
+	 * @param Value The new field value.
+	 */
+	template <uint32 FieldKey, typename T>
+	void Set(T&& Value)
+	{
+		Get<FieldKey>() = Forward<T>(Value);
+	}
+
+private:
+	template <uint32 FieldKey>
+	static constexpr int32 GetFieldIndex()
+	{
+		constexpr int32 FieldIndex = SGTypedMessage::TFieldIndex<FieldKey, FieldTypes...>::Value;
+
+		static_assert(FieldIndex < NumFields, "Typed message has no field with this key");
+
+		return FieldIndex;
+	}
+
+private:
+	/** Holds the field values. */
+	TTuple<typename FieldTypes::Type...> Values;
+};
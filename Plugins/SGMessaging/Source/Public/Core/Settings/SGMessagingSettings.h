@@ -6,6 +6,105 @@
 #include "UObject/NoExportTypes.h"
 #include "SGMessagingSettings.generated.h"
 
+/**
+ * Enumerates the ways a full message queue treats new messages.
+ */
+UENUM()
+enum class ESGMessageBackpressurePolicy : uint8
+{
+	/** The producer waits for room, up to the configured timeout, then the new message is dropped (router command queues only, the router thread itself drops right away). */
+	Block,
+
+	/** The new message is dropped. */
+	DropNewest,
+
+	/** The oldest queued messages are dropped to make room. */
+	DropOldest,
+
+	/** Like DropOldest; conflated messages replace their queued copy anyway and never take extra room. */
+	Coalesce
+};
+
+/**
+ * Enumerates the ways message routers are driven.
+ */
+UENUM()
+enum class ESGMessageRouterMode : uint8
+{
+	/** Each router shard runs on its own thread. */
+	Threaded,
+
+	/** Router shards are pumped once per frame, within the frame budget, by the world subsystem that owns the bus or else by the core ticker. */
+	Frame,
+
+	/** Router shards run as cooperative tasks on the router pool that is shared by all pooled buses. */
+	Pooled
+};
+
+/**
+ * Enumerates the priorities of message router threads.
+ */
+UENUM()
+enum class ESGMessageRouterThreadPriority : uint8
+{
+	Lowest,
+	BelowNormal,
+	Normal,
+	AboveNormal,
+	Highest,
+	TimeCritical
+};
+
+/**
+ * Holds the thread settings of the message buses whose names match a pattern.
+ */
+USTRUCT()
+struct FSGMessageRouterThreadSettings
+{
+	GENERATED_BODY()
+
+	/** The names of the buses these settings apply to, with * and ? wildcards (world subsystem buses are named after their world). */
+	UPROPERTY(Config, EditAnywhere)
+	FString BusNamePattern = TEXT("*");
+
+	/** The priority of the router threads. */
+	UPROPERTY(Config, EditAnywhere)
+	ESGMessageRouterThreadPriority ThreadPriority = ESGMessageRouterThreadPriority::Normal;
+
+	/**
+	 * Logical core to pin the first router thread to (-1 = RouterThreadCore).
+	 *
+	 * Additional router shards are pinned to the following cores.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "-1"))
+	int32 ThreadCore = -1;
+
+	/** Stack size of the router threads (in kilobytes). */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "32"))
+	int32 StackSizeKb = 128;
+
+	/** Longest time the router threads spin for new work before they park (in microseconds, -1 = RouterSpinWaitMicroseconds). */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "-1", ClampMax = "10000"))
+	int32 SpinWaitMicroseconds = -1;
+};
+
+/**
+ * Holds a token bucket rate limit for published and sent messages.
+ */
+USTRUCT()
+struct FSGMessageRateLimit
+{
+	GENERATED_BODY()
+
+	/** The sustained number of messages per second (0 = unlimited). */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	float MessagesPerSecond = 0.0f;
+
+	/** The number of messages that may be sent at once after a quiet period (0 = one second worth of messages). */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 Burst = 0;
+};
+
 /**
  * 
  */
@@ -17,4 +116,447 @@ class SGMESSAGING_API USGMessagingSettings : public UObject
 public:
 	UPROPERTY(Config, EditAnywhere)
 	bool bAllowDelayedMessaging = false;
+
+	/**
+	 * Number of router shards (and router threads) each message bus creates.
+	 *
+	 * Message types are hashed to a shard, so messages of the same type from the same sender keep their order.
+	 * A value of 1 keeps the classic single router behavior.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1", ClampMax = "16"))
+	int32 RouterShardCount = 1;
+
+	/**
+	 * Number of commands each message router priority lane can queue without allocating.
+	 *
+	 * Commands beyond this limit spill into a slower, allocating overflow queue.
+	 * Rounded up to the next power of two.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "64"))
+	int32 RouterCommandRingCapacity = 8192;
+
+	/**
+	 * Whether Thread and Process scoped publishes without delay are dispatched directly on the publishing thread.
+	 *
+	 * Recipients on the publishing thread and AnyThread recipients receive such messages synchronously,
+	 * cross-thread recipients get a dispatch task without a hop through the router thread.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bAllowDirectDispatch = false;
+
+	/**
+	 * Whether messages to AnyThread recipients are handled on task worker threads instead of the router thread.
+	 *
+	 * Each recipient still receives its messages in order, but slow AnyThread handlers no longer stall routing.
+	 * Messages with an ordering key are handled on workers regardless of this setting.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bDispatchAnyThreadOnWorkers = true;
+
+	/**
+	 * Number of ordering partitions per AnyThread recipient.
+	 *
+	 * Messages with the same ordering key are handled in order, while the partitions of a recipient are handled
+	 * in parallel on task workers, so AnyThread handlers of keyed messages must be thread-safe.
+	 *
+	 * @see SGMessageOrdering
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 RouterOrderingPartitions = 16;
+
+	/**
+	 * Number of recipients from which a message is fanned out in parallel chunks (0 = never).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 ParallelFanOutThreshold = 1024;
+
+	/**
+	 * Number of recipients per parallel fan-out chunk.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "16"))
+	int32 ParallelFanOutChunkSize = 128;
+
+	/**
+	 * Whether parallel fan-out keeps the serial delivery order.
+	 *
+	 * If set, only the recipient lookups and the deliveries to named threads and workers are built in
+	 * parallel, and AnyThread recipients that are handled on the router thread receive the message one
+	 * after the other in subscription order.
+	 * Otherwise those recipients are handled concurrently from the fan-out chunks.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bDeterministicFanOut = false;
+
+	/**
+	 * Message types whose messages are conflated ("latest value wins"), in addition to messages sent with ESGMessageFlags::Conflate.
+	 *
+	 * A newer undelivered message replaces an older one with the same type and sender (or the same "SGConflationKey"
+	 * annotation) in router deliveries and endpoint inboxes, so queues hold at most one message per key.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TSet<FName> ConflatedMessageTypes;
+
+	/**
+	 * Message types whose duplicates are dropped, in addition to messages sent with ESGMessageFlags::Deduplicate.
+	 *
+	 * Messages are duplicates if they have the same type and "SGMessageId" annotation. The bus assigns an identifier
+	 * to messages sent with the flag, other messages must carry the annotation themselves.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TSet<FName> DeduplicatedMessageTypes;
+
+	/**
+	 * Time for which the routers remember the identifiers of routed messages (in milliseconds).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 DeduplicationWindowMs = 10000;
+
+	/**
+	 * Largest number of message identifiers that each router remembers, the oldest ones are forgotten first.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "16"))
+	int32 DeduplicationMaxEntries = 65536;
+
+	/**
+	 * Number of high priority commands the router processes before it serves the normal priority lane once.
+	 *
+	 * Higher values favor critical traffic, lower values protect normal traffic from starvation.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 RouterHighPriorityLaneWeight = 16;
+
+	/**
+	 * Number of normal priority commands the router processes before it serves the low priority lane once.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 RouterNormalPriorityLaneWeight = 4;
+
+	/**
+	 * Number of routed messages each message router may queue before backpressure is applied (0 = unlimited).
+	 *
+	 * The limit applies per router shard. Subscription and registration commands are never limited.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 RouterCommandQueueLimit = 0;
+
+	/**
+	 * How message routers treat routed messages once the command queue limit is reached.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	ESGMessageBackpressurePolicy RouterBackpressurePolicy = ESGMessageBackpressurePolicy::DropOldest;
+
+	/**
+	 * Longest time a producer waits for room in a full router command queue with the Block policy (in milliseconds).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 BackpressureBlockTimeoutMs = 10;
+
+	/**
+	 * Rate limit of each sender on a message bus.
+	 *
+	 * Published and sent messages over the limit are dropped on the sending thread before they are routed.
+	 * Forwarded and deferred messages don't count.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	FSGMessageRateLimit SenderRateLimit;
+
+	/**
+	 * Rate limits of message types (or tags), which all senders on a message bus share.
+	 *
+	 * Topic patterns are not supported.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TMap<FName, FSGMessageRateLimit> MessageTypeRateLimits;
+
+	/**
+	 * Longest time a message router thread spins for new work before it parks (in microseconds, 0 = never spin).
+	 *
+	 * The spin budget adapts between a sixteenth of this value and this value: it grows while work keeps arriving
+	 * during the spin and shrinks while it doesn't, so bursty traffic is picked up without a wake-up and idle
+	 * routers don't burn a core.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0", ClampMax = "10000"))
+	int32 RouterSpinWaitMicroseconds = 50;
+
+	/**
+	 * Logical core to pin the first message router thread to (-1 = don't pin).
+	 *
+	 * Additional router shards are pinned to the following cores.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "-1"))
+	int32 RouterThreadCore = -1;
+
+	/**
+	 * Router thread settings of individual message buses, by bus name pattern.
+	 *
+	 * The first entry whose pattern matches a bus applies, other buses use normal priority threads with
+	 * the settings above. Only threaded router modes create router threads.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TArray<FSGMessageRouterThreadSettings> RouterThreadSettings;
+
+	/**
+	 * How the message routers of a bus are driven, unless BusRouterModes overrides it.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	ESGMessageRouterMode RouterMode = ESGMessageRouterMode::Threaded;
+
+	/**
+	 * Router modes of individual message buses, by bus name (world subsystem buses are named after their world).
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TMap<FString, ESGMessageRouterMode> BusRouterModes;
+
+	/**
+	 * Longest time a frame mode bus spends routing per frame (in milliseconds, 0 = unlimited).
+	 *
+	 * Commands that don't fit into the budget are carried over to the next frame in order.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	float FrameModeTimeBudgetMs = 2.0f;
+
+	/**
+	 * Largest number of router commands a frame mode bus processes per frame (0 = unlimited).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 FrameModeCommandBudget = 0;
+
+	/**
+	 * Number of worker threads that run the routers of all pooled buses.
+	 *
+	 * The workers are started with the first pooled bus, so changes apply once all pooled buses were shut down.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1", ClampMax = "16"))
+	int32 RouterPoolSize = 2;
+
+	/**
+	 * Largest number of router commands a pool worker processes per router before it moves on to the next.
+	 *
+	 * Smaller values share the workers more fairly between buses, larger ones add less scheduling overhead.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 RouterPoolQuantum = 256;
+
+	/**
+	 * Largest number of messages a message tracer keeps in its history (0 = unlimited).
+	 *
+	 * Older messages are evicted, but still count towards the tracer's aggregate counters.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 TracerMaxMessages = 10000;
+
+	/**
+	 * Longest time a message tracer keeps messages in its history (in seconds, 0 = unlimited).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	float TracerMaxMessageAge = 0.0f;
+
+	/**
+	 * Largest estimated memory of the messages a message tracer keeps in its history (in megabytes, 0 = unlimited).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	int32 TracerMaxMessageMegabytes = 64;
+
+	/**
+	 * A running message tracer traces one in this many messages (1 = every message).
+	 *
+	 * The decision is made once when a message is sent, the trace points of other messages only check a flag.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 TracerSampleRate = 1;
+
+	/**
+	 * Sample rates of individual message types, overriding TracerSampleRate.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TMap<FName, int32> TracerMessageTypeSampleRates;
+
+	/**
+	 * Number of trace events each thread can buffer per message tracer before further events are dropped.
+	 *
+	 * The tracer's consumer thread empties the buffers every few milliseconds. Rounded up to the next power of two.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "64"))
+	int32 TracerThreadBufferCapacity = 4096;
+
+	/**
+	 * Whether message endpoints measure the latency from sending a message until their handlers handled it.
+	 *
+	 * Each endpoint keeps a rolling window of its latest latencies, see FSGMessageEndpoint::GetHandledLatency.
+	 * Endpoints pick up changes when they are created.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bEnableLatencyProbes = !UE_BUILD_SHIPPING;
+
+	/**
+	 * Whether the time that message handlers take is measured per endpoint, message type and handler.
+	 *
+	 * Blueprint events are also measured on their own. Each handler call reads the clock twice and updates
+	 * the timings of the handling thread, so it is meant for profiling sessions, see FSGMessageHandlerProfiler and the SGMessaging.HandlerReport
+	 * console command, which can also start and stop it at runtime.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	bool bEnableHandlerProfiling = false;
+
+	/**
+	 * Time after which a message handler is reported as slow (in milliseconds, 0 = never).
+	 *
+	 * Slow handlers are logged at most once per second each on each thread and reported through
+	 * FSGMessageHandlerProfiler::OnSlowHandler. Only applies while handler profiling is enabled.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0.0"))
+	float SlowHandlerThresholdMs = 4.0f;
+
+	/**
+	 * Time over which the SGMessaging.HandlerReport console command sums up the handler timings (in seconds).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1", ClampMax = "16"))
+	int32 HandlerProfilingWindowSeconds = 5;
+
+	/**
+	 * Number of routed messages a message capture can queue for its writer thread before further messages are dropped from the capture.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 CaptureMaxPendingMessages = 65536;
+
+	/**
+	 * Largest size of the durable queue segment of an offline recipient (in kilobytes).
+	 *
+	 * A full segment drops its expired and then its oldest messages, see FSGMessageDurableQueue.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 DurableQueueMaxSizeKb = 1024;
+
+	/**
+	 * Types of messages that are queued for durable recipients while they are offline (empty = all types).
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TArray<FName> DurableMessageTypes;
+
+	/**
+	 * Directory that holds the durable queue segments (empty = Saved/SGMessaging/Durable in the project directory).
+	 *
+	 * Each message bus uses a subdirectory named after the bus.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	FString DurableQueueDirectory;
+
+	/**
+	 * Edge length of the grid cells of the spatial subscription indices (in world units).
+	 *
+	 * Cells should be about as large as typical interest radii, see FSGMessageSpatialIndex.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "100"))
+	float SpatialCellSize = 5000.0f;
+
+	/**
+	 * Distance that an actor with spatial subscriptions must move before its interests are updated (in world units).
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	float SpatialUpdateDistance = 100.0f;
+
+	/**
+	 * Largest number of outbound messages that a message bridge hands to its transport in one batch.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 BridgeMaxBatchSize = 64;
+
+	/**
+	 * Longest time that a message bridge waits for more outbound messages before it hands a partial batch to its transport (in milliseconds).
+	 *
+	 * Zero sends whatever is queued as soon as the bridge's sender thread wakes up.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "0"))
+	float BridgeFlushIntervalMs = 0.0f;
+
+	/**
+	 * The compression format of messages exchanged by network transports, e.g. LZ4, Oodle or Zlib.
+	 *
+	 * None sends all messages uncompressed. Receivers decompress messages regardless of their own setting.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	FName TransportCompressionFormat = NAME_None;
+
+	/** Encoded size at which messages exchanged by network transports are compressed (in bytes). */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "64"))
+	int32 TransportCompressionThreshold = 1024;
+
+	/** The types of messages that network transports compress (empty = all types). */
+	UPROPERTY(Config, EditAnywhere)
+	TArray<FName> TransportCompressedMessageTypes;
+
+	/**
+	 * The types of messages that network transports delta-encode.
+	 *
+	 * The payload of such a message is sent as the bytes that changed since the last message of the same type
+	 * and sender. Receivers drop deltas whose previous message they didn't receive until the next keyframe.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TArray<FName> TransportDeltaMessageTypes;
+
+	/** The number of delta-encoded messages of a stream that are sent between two keyframes. */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 TransportDeltaKeyframeInterval = 30;
+
+	/**
+	 * The largest number of recipients or annotations of a message that a network transport receives.
+	 *
+	 * Received messages with more, or with counts or string lengths that exceed their encoded size, are dropped.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "1"))
+	int32 TransportMaxReceivedCount = 1024;
+
+	/**
+	 * Message buses that are bridged to other processes through the UDP transport, by bus name, mapped to the
+	 * <ipv4:port> endpoint their transport binds to.
+	 *
+	 * Every bridged bus needs its own port.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TMap<FString, FString> UdpTransportBuses;
+
+	/**
+	 * The <ipv4:port> endpoints of remote UDP transports that the local transports say hello to.
+	 *
+	 * Remote transports that say hello first are discovered as well, so only one side needs to list the other.
+	 */
+	UPROPERTY(Config, EditAnywhere)
+	TArray<FString> UdpStaticEndpoints;
+
+	/**
+	 * Largest size of the datagrams a UDP transport sends and receives (in bytes).
+	 *
+	 * Must be the same in all processes. The default fills an Ethernet frame without IP fragmentation.
+	 */
+	UPROPERTY(Config, EditAnywhere, meta = (ClampMin = "512", ClampMax = "65507"))
+	int32 UdpMaxDatagramSize = 1472;
+
+public:
+
+	/**
+	 * Gets the router mode of the given message bus.
+	 *
+	 * @param BusName The name of the message bus.
+	 * @return The router mode.
+	 */
+	ESGMessageRouterMode GetRouterMode(const FString& BusName) const
+	{
+		const ESGMessageRouterMode* BusRouterMode = BusRouterModes.Find(BusName);
+
+		return (BusRouterMode != nullptr) ? *BusRouterMode : RouterMode;
+	}
+
+	/**
+	 * Gets the router thread settings of the given message bus.
+	 *
+	 * @param BusName The name of the message bus.
+	 * @return The first thread settings whose pattern matches, or nullptr if none does.
+	 */
+	const FSGMessageRouterThreadSettings* FindRouterThreadSettings(const FString& BusName) const
+	{
+		return RouterThreadSettings.FindByPredicate([&BusName](const FSGMessageRouterThreadSettings& ThreadSettings)
+		{
+			return BusName.MatchesWildcard(ThreadSettings.BusNamePattern);
+		});
+	}
 };
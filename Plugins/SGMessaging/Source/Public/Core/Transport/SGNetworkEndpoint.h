@@ -0,0 +1,72 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+/**
+ * Structure for an IPv4 network endpoint.
+ */
+struct FSGNetworkEndpoint
+{
+	/** Holds the IPv4 address (in host byte order). */
+	uint32 Address = 0;
+
+	/** Holds the port number (0 = any port). */
+	uint16 Port = 0;
+
+public:
+
+	/** Default constructor. */
+	FSGNetworkEndpoint() = default;
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InAddress The IPv4 address (in host byte order).
+	 * @param InPort The port number.
+	 */
+	FSGNetworkEndpoint(uint32 InAddress, uint16 InPort)
+		: Address(InAddress)
+		, Port(InPort)
+	{ }
+
+public:
+
+	bool operator==(const FSGNetworkEndpoint& Other) const
+	{
+		return (Address == Other.Address) && (Port == Other.Port);
+	}
+
+	bool operator!=(const FSGNetworkEndpoint& Other) const
+	{
+		return !(*this == Other);
+	}
+
+	friend uint32 GetTypeHash(const FSGNetworkEndpoint& Endpoint)
+	{
+		return HashCombine(::GetTypeHash(Endpoint.Address), ::GetTypeHash(Endpoint.Port));
+	}
+
+public:
+
+	/**
+	 * Converts this endpoint to a string.
+	 *
+	 * @return The string in the form <ipv4:port>.
+	 */
+	FString ToString() const
+	{
+		return FString::Printf(TEXT("%u.%u.%u.%u:%u"), (Address >> 24) & 0xff, (Address >> 16) & 0xff, (Address >> 8) & 0xff, Address & 0xff, Port);
+	}
+
+	/**
+	 * Parses an endpoint from a string.
+	 *
+	 * @param String The string in the form <ipv4:port>.
+	 * @param OutEndpoint Will hold the parsed endpoint.
+	 * @return true if the string was parsed, false if it isn't a valid endpoint.
+	 */
+	static SGMESSAGING_API bool Parse(const FString& String, FSGNetworkEndpoint& OutEndpoint);
+};
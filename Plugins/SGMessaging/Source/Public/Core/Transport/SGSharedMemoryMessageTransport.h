@@ -0,0 +1,191 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "HAL/PlatformMemory.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/Guid.h"
+#include "Core/Interface/ISGMessageTransport.h"
+#include "Core/Transport/SGTransportCodec.h"
+#include <atomic>
+
+class FRunnableThread;
+
+
+/**
+ * Implements a message transport that exchanges messages with other processes on the same host through shared memory.
+ *
+ * Transports on the same channel register in a shared directory and send heartbeats through it. Each
+ * transport owns an inbox with one single-producer single-consumer ring per peer, so there is one
+ * ring per direction per pair of transports. A sender encodes a message once and copies it into the
+ * rings of its recipients, and the receiver thread decodes the message in place. A receiver that
+ * runs out of messages sleeps on an interprocess semaphore, which senders only signal if it sleeps.
+ *
+ * Peers that leave the directory or whose heartbeats stop for two seconds are forgotten. Messages
+ * that don't fit into a full ring are dropped. Up to 16 transports can share a channel.
+ *
+ * Messages are encoded by FSGTransportCodec, so the same payload limits as for message captures apply.
+ *
+ * @see FSGMessageBridge
+ */
+class SGMESSAGING_API FSGSharedMemoryMessageTransport
+	: public ISGMessageTransport
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InChannelName The name of the channel shared by the transports that exchange messages.
+	 */
+	explicit FSGSharedMemoryMessageTransport(const FString& InChannelName = TEXT("SGMessaging"));
+
+	/** Virtual destructor. */
+	virtual ~FSGSharedMemoryMessageTransport();
+
+public:
+
+	/** Gets the number of messages that were written to rings. */
+	int64 GetNumSentMessages() const
+	{
+		return NumSentMessages.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of messages that were dropped because a ring was full. */
+	int64 GetNumDroppedMessages() const
+	{
+		return NumDroppedMessages.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of messages that were received. */
+	int64 GetNumReceivedMessages() const
+	{
+		return NumReceivedMessages.load(std::memory_order_relaxed);
+	}
+
+public:
+
+	//~ ISGMessageTransport interface
+
+	virtual FName GetDebugName() const override;
+	virtual bool StartTransport(ISGMessageTransportHandler& Handler) override;
+	virtual void StopTransport() override;
+	virtual bool TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients) override;
+
+private:
+
+	class FReceiver;
+	struct FPeer;
+
+	/** Structure for a peer seen in the directory (receiver thread only). */
+	struct FObservedNode
+	{
+		/** Holds the peer's inbox. */
+		TSharedPtr<FPeer, ESPMode::ThreadSafe> Peer;
+
+		/** Holds the peer's last seen heartbeat. */
+		uint64 Heartbeat = 0;
+
+		/** Holds the time at which the heartbeat last changed (in seconds). */
+		double LastChangeTime = 0.0;
+	};
+
+private:
+
+	/** Runs the receiver thread. */
+	void ReceiveMessages();
+
+	/** Reads the messages in the inbox rings, returning whether any were read. */
+	bool ReadRings();
+
+	/** Sends a heartbeat, and discovers and forgets peers. */
+	void UpdateDirectory(double Now);
+
+	/** Forgets a peer and releases its rings. */
+	void ForgetNode(const FGuid& PeerId);
+
+	/** Maps the directory and registers this transport in it. */
+	bool OpenDirectory();
+
+	/** Unregisters this transport and unmaps the directory. */
+	void CloseDirectory();
+
+	/** Claims a free directory slot for this transport. */
+	bool ClaimDirectorySlot();
+
+	/** Maps the inbox of a peer and claims a ring in it. */
+	TSharedPtr<FPeer, ESPMode::ThreadSafe> OpenPeer(const FGuid& PeerId);
+
+	/** Releases the ring in a peer's inbox and unmaps the inbox. */
+	void ClosePeer(FPeer& Peer);
+
+	/** Writes a message to the ring in a peer's inbox. */
+	bool WriteMessage(FPeer& Peer, TArrayView<const uint8> Message);
+
+	/** Releases the inbox, its semaphore and the directory. */
+	void CloseRegions();
+
+	/** Gets the name of a transport's inbox. */
+	FString GetInboxName(const FGuid& Id) const;
+
+	/** Gets the name of a transport's semaphore. */
+	FString GetWakeName(const FGuid& Id) const;
+
+private:
+
+	/** Holds the name of the channel. */
+	FString ChannelName;
+
+	/** Holds the identifier of this transport node. */
+	FGuid NodeId;
+
+	/** Holds the handler of received messages and node events (only valid while the transport runs). */
+	ISGMessageTransportHandler* Handler;
+
+	/** Holds a flag indicating that the receiver thread is stopping. */
+	std::atomic<bool> bStopping;
+
+	/** Holds the receiver thread. */
+	FRunnableThread* ReceiverThread;
+
+	/** Holds the runnable of the receiver thread. */
+	TUniquePtr<FReceiver> Receiver;
+
+	/** Holds the mapped directory (receiver thread only while the transport runs). */
+	FPlatformMemory::FSharedMemoryRegion* DirectoryRegion;
+
+	/** Holds the identifier of the mapped directory, which changes if the directory is recreated. */
+	uint64 DirectoryId;
+
+	/** Holds the index of this transport's directory slot. */
+	int32 DirectorySlotIndex;
+
+	/** Holds this transport's inbox. */
+	FPlatformMemory::FSharedMemoryRegion* InboxRegion;
+
+	/** Holds the semaphore that senders signal when the receiver thread sleeps. */
+	FPlatformProcess::FSemaphore* WakeSemaphore;
+
+	/** Holds the inboxes of the discovered peers, by node identifier. */
+	TMap<FGuid, TSharedRef<FPeer, ESPMode::ThreadSafe>> Peers;
+
+	/** Guards the peers. */
+	FCriticalSection PeersCriticalSection;
+
+	/** Holds the peers seen in the directory, by node identifier (receiver thread only). */
+	TMap<FGuid, FObservedNode> ObservedNodes;
+
+	/** Holds the codec of sent and received messages (decoding on the receiver thread only). */
+	FSGTransportCodec Codec;
+
+	/** Holds the number of messages written to rings. */
+	std::atomic<int64> NumSentMessages;
+
+	/** Holds the number of messages dropped because a ring was full. */
+	std::atomic<int64> NumDroppedMessages;
+
+	/** Holds the number of received messages. */
+	std::atomic<int64> NumReceivedMessages;
+};
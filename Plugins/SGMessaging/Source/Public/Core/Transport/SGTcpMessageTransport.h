@@ -0,0 +1,260 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Guid.h"
+#include "Core/Interface/ISGMessageTransport.h"
+#include "Core/Transport/SGNetworkEndpoint.h"
+#include "Core/Transport/SGTransportCodec.h"
+#include <atomic>
+
+class FRunnableThread;
+class FSocket;
+
+
+/**
+ * Enumerates the versions of the TCP transport protocol.
+ */
+enum class ESGTcpTransportVersion : uint8
+{
+	Initial = 1,
+
+	/** Encoded messages start with their encoding and may be compressed. */
+	CompressedMessages = 2,
+
+	/** Message payloads start with their encoding and may be delta-encoded. */
+	DeltaPayloads = 3,
+
+	// -----<new versions can be added above this line>-----
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1
+};
+
+
+/**
+ * Implements a message transport that exchanges messages with other processes over TCP.
+ *
+ * The transport accepts connections on its listen endpoint and connects to its connect endpoints,
+ * retrying failed connections every two seconds. Each connection carries length-prefixed frames and
+ * starts with a hello frame that identifies the transport node; there is one connection per node,
+ * and if two nodes connect to each other, the connection initiated by the node with the lower
+ * identifier is kept. Losing a connection forgets its node.
+ *
+ * Sent messages are appended to the write queue of each recipient's connection, which consists of
+ * pooled chunks. A sender thread flushes a queue once it holds the flush threshold or its oldest
+ * frame has waited for the flush interval, handing the socket whole chunks rather than single
+ * messages. Each connection has a receiver thread that decodes its frames.
+ *
+ * Messages are encoded by FSGTransportCodec, so the same payload limits as for message captures apply.
+ * Delivery is reliable and ordered per node while the connection holds.
+ *
+ * @see FSGMessageBridge
+ */
+class SGMESSAGING_API FSGTcpMessageTransport
+	: public ISGMessageTransport
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InListenEndpoint The endpoint to accept connections on (port 0 = don't accept connections).
+	 * @param InConnectEndpoints The endpoints of the remote transports to connect to.
+	 * @param InFlushInterval The longest time that queued frames wait before they are sent (in seconds).
+	 * @param InFlushThreshold The number of queued bytes at which a write queue is sent right away.
+	 */
+	FSGTcpMessageTransport(const FSGNetworkEndpoint& InListenEndpoint, const TArray<FSGNetworkEndpoint>& InConnectEndpoints, double InFlushInterval = 0.001, int32 InFlushThreshold = 16 * 1024);
+
+	/** Virtual destructor. */
+	virtual ~FSGTcpMessageTransport();
+
+public:
+
+	/**
+	 * Adds an endpoint of a remote transport to connect to.
+	 *
+	 * @param Endpoint The endpoint to add.
+	 * @see RemoveConnectEndpoint
+	 */
+	void AddConnectEndpoint(const FSGNetworkEndpoint& Endpoint);
+
+	/**
+	 * Removes an endpoint of a remote transport.
+	 *
+	 * An established connection to that endpoint stays open until it is lost.
+	 *
+	 * @param Endpoint The endpoint to remove.
+	 * @see AddConnectEndpoint
+	 */
+	void RemoveConnectEndpoint(const FSGNetworkEndpoint& Endpoint);
+
+	/** Gets the number of frames that were queued for sending. */
+	int64 GetNumSentFrames() const
+	{
+		return NumSentFrames.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of socket writes that sent the queued frames. */
+	int64 GetNumSocketWrites() const
+	{
+		return NumSocketWrites.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of frames that were received. */
+	int64 GetNumReceivedFrames() const
+	{
+		return NumReceivedFrames.load(std::memory_order_relaxed);
+	}
+
+public:
+
+	//~ ISGMessageTransport interface
+
+	virtual FName GetDebugName() const override;
+	virtual bool StartTransport(ISGMessageTransportHandler& Handler) override;
+	virtual void StopTransport() override;
+	virtual bool TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients) override;
+
+private:
+
+	class FConnection;
+	class FReceiver;
+	class FSender;
+
+	/** Enumerates the types of frames. */
+	enum class EFrame : uint8
+	{
+		/** Identifies the sending node, sent first on each connection. */
+		Hello,
+
+		/** A message. */
+		Message
+	};
+
+	/** Structure for an endpoint to connect to. */
+	struct FConnectEndpoint
+	{
+		/** Holds the endpoint. */
+		FSGNetworkEndpoint Endpoint;
+
+		/** Holds the connection to the endpoint, if any. */
+		TSharedPtr<FConnection, ESPMode::ThreadSafe> Connection;
+
+		/** Holds the node last seen at the endpoint. */
+		FGuid NodeId;
+
+		/** Holds the time of the next connection attempt (in seconds). */
+		double NextAttemptTime = 0.0;
+	};
+
+private:
+
+	/** Runs the sender thread. */
+	void SendFrames();
+
+	/** Runs the receiver thread of a connection. */
+	void ReceiveFrames(FConnection& Connection);
+
+	/** Processes a received frame, returning false if the connection must close. */
+	bool ProcessFrame(FConnection& Connection, TArrayView<const uint8> Frame);
+
+	/** Registers the node of a connection that said hello, returning false if the connection must close. */
+	bool RegisterNode(FConnection& Connection, const FGuid& RemoteId);
+
+	/** Accepts pending connections. */
+	void AcceptConnections();
+
+	/** Starts connection attempts and checks the pending ones. */
+	void UpdateConnectEndpoints(double Now);
+
+	/** Starts the receiver thread of an established connection and says hello. */
+	bool OpenConnection(const TSharedRef<FConnection, ESPMode::ThreadSafe>& Connection);
+
+	/** Sends the write queues that are due, returning the time at which the next one is due. */
+	double FlushConnections(double Now, bool bForce);
+
+	/** Sends the queued chunks of a connection, returning false if the connection failed. */
+	bool FlushConnection(FConnection& Connection);
+
+	/** Destroys closed connections and forgets their nodes. */
+	void ReapConnections();
+
+	/** Appends a frame to the write queue of a connection. */
+	void QueueFrame(FConnection& Connection, EFrame Frame, TArrayView<const uint8> Body);
+
+	/** Gets a recycled or new chunk of a write queue. */
+	TArray<uint8> AllocateChunk();
+
+	/** Recycles a sent chunk of a write queue. */
+	void ReleaseChunk(TArray<uint8>&& Chunk);
+
+	/** Creates a socket of the socket subsystem. */
+	FSocket* CreateSocket(const TCHAR* Description) const;
+
+	/** Destroys a socket of the socket subsystem. */
+	static void DestroySocket(FSocket*& Socket);
+
+private:
+
+	/** Holds the endpoint that the listener socket is bound to. */
+	FSGNetworkEndpoint ListenEndpoint;
+
+	/** Holds the longest time that queued frames wait before they are sent (in seconds). */
+	double FlushInterval;
+
+	/** Holds the number of queued bytes at which a write queue is sent right away. */
+	int32 FlushThreshold;
+
+	/** Holds the identifier of this transport node. */
+	FGuid NodeId;
+
+	/** Holds the socket that accepts connections (sender thread only). */
+	FSocket* ListenerSocket;
+
+	/** Holds the handler of received messages and node events (only valid while the transport runs). */
+	ISGMessageTransportHandler* Handler;
+
+	/** Holds a flag indicating that the sender thread is stopping. */
+	std::atomic<bool> bStopping;
+
+	/** Holds the sender thread. */
+	FRunnableThread* SenderThread;
+
+	/** Holds the runnable of the sender thread. */
+	TUniquePtr<FSender> Sender;
+
+	/** Holds an event that wakes up the sender thread when frames are queued. */
+	FEvent* SendEvent;
+
+	/** Holds the open and pending connections (sender thread only). */
+	TArray<TSharedRef<FConnection, ESPMode::ThreadSafe>> Connections;
+
+	/** Holds the endpoints to connect to (guarded by NodesCriticalSection, connections are sender thread only). */
+	TArray<FConnectEndpoint> ConnectEndpoints;
+
+	/** Holds the connections of the nodes that said hello, by node identifier. */
+	TMap<FGuid, TSharedRef<FConnection, ESPMode::ThreadSafe>> Nodes;
+
+	/** Guards the nodes and the connect endpoints. */
+	mutable FCriticalSection NodesCriticalSection;
+
+	/** Holds the codec that encodes sent messages. */
+	FSGTransportCodec Codec;
+
+	/** Holds write queue chunks that can be reused. */
+	TArray<TArray<uint8>> FreeChunks;
+
+	/** Guards the reusable chunks. */
+	FCriticalSection FreeChunksCriticalSection;
+
+	/** Holds the number of frames that were queued for sending. */
+	std::atomic<int64> NumSentFrames;
+
+	/** Holds the number of socket writes. */
+	std::atomic<int64> NumSocketWrites;
+
+	/** Holds the number of received frames. */
+	std::atomic<int64> NumReceivedFrames;
+};
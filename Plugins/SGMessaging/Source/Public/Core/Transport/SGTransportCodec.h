@@ -0,0 +1,155 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include "UObject/WeakObjectPtrTemplates.h"
+#include "Core/Interface/ISGMessageContext.h"
+
+class FSGWireWriter;
+class UScriptStruct;
+struct FSGCapturedMessage;
+
+
+/**
+ * Implements the encoding of messages exchanged by network transports.
+ *
+ * Messages are encoded like message captures, so the same payload limits apply (see FSGMessageCapture).
+ * Decoded messages get contexts whose payloads come from the message pool.
+ *
+ * If a compression format is configured, encoded messages of at least the configured size are compressed
+ * with FCompression, unless that doesn't make them smaller. Encoded messages start with their encoding
+ * and the compression format, so receivers decompress messages regardless of their own settings. The
+ * compression ratio and time per message type are counted in FSGMessageCompressionCounters.
+ *
+ * Messages of the configured delta types are encoded as streams by message type and sender. Each stream
+ * starts with a keyframe that holds the full payload, followed by deltas that hold the payload bytes that
+ * changed since the previous message of the stream, and another keyframe after the configured number of
+ * deltas. Deltas name the sequence number of their base, so receivers that missed a message of a stream
+ * drop its deltas until the next keyframe.
+ *
+ * Encoding may be called from any thread. Decoding caches the structures of struct messages and the
+ * bases of delta streams, so each codec must only decode on one thread at a time.
+ *
+ * @see USGMessagingSettings::TransportCompressionFormat, USGMessagingSettings::TransportDeltaMessageTypes
+ */
+class SGMESSAGING_API FSGTransportCodec
+{
+public:
+
+	/** Creates and initializes a new instance from the messaging settings. */
+	FSGTransportCodec();
+
+public:
+
+	/**
+	 * Encodes a message.
+	 *
+	 * @param Context The context of the message to encode.
+	 * @param OutMessage Will hold the encoded message.
+	 * @return true if the message was encoded, false if its payload can't be encoded.
+	 * @see DecodeMessage
+	 */
+	bool EncodeMessage(const ISGMessageContext& Context, TArray<uint8>& OutMessage) const;
+
+	/**
+	 * Decodes a received message.
+	 *
+	 * @param Message The encoded message.
+	 * @return The message's context, or nullptr if the message is malformed, exceeds the receive limits or its structure doesn't exist.
+	 * @see EncodeMessage
+	 */
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> DecodeMessage(TArrayView<const uint8> Message);
+
+private:
+
+	/** Enumerates the encodings of transported messages. */
+	enum class EEncoding : uint8
+	{
+		/** The message record follows. */
+		Plain,
+
+		/** The compression format and the record's size follow, then the compressed record. */
+		Compressed
+	};
+
+	/** Enumerates the encodings of message payloads. */
+	enum class EPayloadEncoding : uint8
+	{
+		/** The full payload of a message that isn't delta-encoded. */
+		Full,
+
+		/** The full payload of a delta stream, preceded by its sequence number. */
+		Keyframe,
+
+		/** The changes to the base payload, preceded by the sequence numbers of the message and its base. */
+		Delta
+	};
+
+	/** Structure for the state of a delta stream. */
+	struct FDeltaStream
+	{
+		/** Holds the payload of the stream's last message. */
+		TArray<uint8> Payload;
+
+		/** Holds the sequence number of the stream's last message. */
+		uint32 Sequence = 0;
+
+		/** Holds the number of deltas since the last keyframe (encoding only). */
+		int32 NumDeltas = 0;
+	};
+
+	/** Type of the keys of delta streams (message type and sender). */
+	typedef TPair<FName, FSGMessageAddress> FDeltaStreamKey;
+
+	/** Writes the payload encoding of a message, replacing its payload with a delta if that is smaller. */
+	void EncodePayload(FSGCapturedMessage& Record, FSGWireWriter& Writer) const;
+
+	/** Restores the payload of a decoded message from its delta stream. */
+	bool DecodePayload(EPayloadEncoding PayloadEncoding, uint64 Sequence, uint64 BaseSequence, FSGCapturedMessage& Record);
+
+	/** Compresses an encoded message in place if that makes it smaller. */
+	void CompressMessage(const FName& MessageType, TArray<uint8>& Message) const;
+
+	/** Resolves the structure of a struct message. */
+	UScriptStruct* FindTypeInfo(const FSGCapturedMessage& Message);
+
+private:
+
+	/** Holds the compression format (NAME_None = no compression). */
+	FName CompressionFormat;
+
+	/** Holds the wire identifier of the compression format. */
+	uint8 CompressionFormatId;
+
+	/** Holds the encoded size at which messages are compressed. */
+	int32 CompressionThreshold;
+
+	/** Holds the types of messages to compress (empty = all types). */
+	TSet<FName> CompressedMessageTypes;
+
+	/** Holds the types of messages to delta-encode. */
+	TSet<FName> DeltaMessageTypes;
+
+	/** Holds the number of deltas between two keyframes. */
+	int32 DeltaKeyframeInterval;
+
+	/** Holds the largest number of recipients or annotations of a decoded message. */
+	int32 MaxReceivedCount;
+
+	/** Holds the encoded delta streams. */
+	mutable TMap<FDeltaStreamKey, FDeltaStream> EncodedStreams;
+
+	/** Guards the encoded delta streams. */
+	mutable FCriticalSection EncodedStreamsCriticalSection;
+
+	/** Holds the decoded delta streams (decoding thread only). */
+	TMap<FDeltaStreamKey, FDeltaStream> DecodedStreams;
+
+	/** Holds the buffer of decompressed messages (decoding thread only). */
+	TArray<uint8> DecompressionBuffer;
+
+	/** Holds the structures of decoded struct messages, by path name. */
+	TMap<FString, TWeakObjectPtr<UScriptStruct>> TypeInfos;
+};
@@ -0,0 +1,452 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "HAL/CriticalSection.h"
+#include "Misc/Guid.h"
+#include "Core/Bus/SGMessageTimingWheel.h"
+#include "Core/Interface/ISGMessageTransport.h"
+#include "Core/Transport/SGTransportCodec.h"
+#include "Core/Transport/SGUdpSocket.h"
+#include <atomic>
+
+class FRunnableThread;
+
+
+/**
+ * Enumerates the versions of the UDP transport protocol.
+ */
+enum class ESGUdpTransportVersion : uint8
+{
+	Initial = 1,
+
+	/** Encoded messages start with their encoding and may be compressed. */
+	CompressedMessages = 2,
+
+	/** Message payloads start with their encoding and may be delta-encoded. */
+	DeltaPayloads = 3,
+
+	/** Reliable messages carry sequence numbers and are acknowledged. */
+	ReliableDelivery = 4,
+
+	// -----<new versions can be added above this line>-----
+	LatestPlusOne,
+	Latest = LatestPlusOne - 1
+};
+
+
+/**
+ * Implements a message transport that exchanges messages with other processes over UDP.
+ *
+ * Each datagram starts with a header that identifies the sending transport node, followed by
+ * segments. Messages sent to the same node are coalesced into datagrams of up to the configured
+ * datagram size, and messages that don't fit into one datagram are split into fragments.
+ *
+ * A sender thread drains the outbound queue, packs the datagrams and hands them to the socket in
+ * batches; a receiver thread receives datagrams in batches and decodes their messages into contexts
+ * whose payloads come from the message pool. Transports say hello to their static endpoints and to
+ * all known nodes once per second, and forget nodes they haven't heard from for five seconds.
+ *
+ * Messages are encoded by FSGTransportCodec, so the same payload limits as for message captures apply.
+ * Delivery is unreliable and unordered across datagrams, except for messages with ESGMessageFlags::Reliable.
+ *
+ * Reliable messages carry a sequence number per recipient node. Receivers deliver them in order, suppress
+ * duplicates and acknowledge them with the next expected sequence number and a bitmap of the messages they
+ * received out of order; acknowledgements travel in the datagrams of the sender thread. Up to a window of
+ * reliable messages per node are unacknowledged at any time, further ones wait in a backlog. Unacknowledged
+ * messages are retransmitted by timers on a timing wheel, with a timeout derived from the measured round
+ * trip time, until they are acknowledged or the node is forgotten.
+ *
+ * @see FSGMessageBridge, FSGUdpSocket
+ */
+class SGMESSAGING_API FSGUdpMessageTransport
+	: public ISGMessageTransport
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InUnicastEndpoint The endpoint to bind the transport's socket to.
+	 * @param InStaticEndpoints The endpoints of the remote transports to say hello to.
+	 * @param InMaxDatagramSize The largest size of the datagrams to send (in bytes).
+	 */
+	FSGUdpMessageTransport(const FSGNetworkEndpoint& InUnicastEndpoint, const TArray<FSGNetworkEndpoint>& InStaticEndpoints, int32 InMaxDatagramSize);
+
+	/** Virtual destructor. */
+	virtual ~FSGUdpMessageTransport();
+
+public:
+
+	/**
+	 * Adds an endpoint of a remote transport to say hello to.
+	 *
+	 * @param Endpoint The endpoint to add.
+	 * @see RemoveStaticEndpoint
+	 */
+	void AddStaticEndpoint(const FSGNetworkEndpoint& Endpoint);
+
+	/**
+	 * Removes an endpoint of a remote transport.
+	 *
+	 * Nodes at that endpoint are forgotten once they time out, unless they say hello themselves.
+	 *
+	 * @param Endpoint The endpoint to remove.
+	 * @see AddStaticEndpoint
+	 */
+	void RemoveStaticEndpoint(const FSGNetworkEndpoint& Endpoint);
+
+	/** Gets the number of datagrams that were sent. */
+	int64 GetNumSentDatagrams() const
+	{
+		return NumSentDatagrams.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of datagrams that were received. */
+	int64 GetNumReceivedDatagrams() const
+	{
+		return NumReceivedDatagrams.load(std::memory_order_relaxed);
+	}
+
+	/** Gets the number of reliable messages that were retransmitted. */
+	int64 GetNumRetransmittedMessages() const
+	{
+		return NumRetransmittedMessages.load(std::memory_order_relaxed);
+	}
+
+public:
+
+	//~ ISGMessageTransport interface
+
+	virtual FName GetDebugName() const override;
+	virtual bool StartTransport(ISGMessageTransportHandler& Handler) override;
+	virtual void StopTransport() override;
+	virtual bool TransportMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients) override;
+	virtual int32 TransportMessages(TArrayView<const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>> Contexts, const TArray<FGuid>& Recipients) override;
+
+private:
+
+	class FReceiver;
+	class FSender;
+
+	/** Enumerates the types of datagram segments. */
+	enum class ESegment : uint8
+	{
+		/** The sending node is alive. */
+		Hello,
+
+		/** The sending node is shutting down. */
+		Bye,
+
+		/** A complete message. */
+		Message,
+
+		/** A fragment of a message that doesn't fit into one datagram. */
+		Fragment,
+
+		/** A complete reliable message, preceded by its sequence number. */
+		ReliableMessage,
+
+		/** A fragment of a reliable message, preceded by the message's sequence number. */
+		ReliableFragment,
+
+		/** An acknowledgement of reliable messages. */
+		Ack
+	};
+
+	/** Structure for a message waiting to be sent. */
+	struct FOutboundMessage
+	{
+		/** Holds the encoded message. */
+		TArray<uint8> Message;
+
+		/** Holds the recipient nodes (empty = all known nodes). */
+		TArray<FGuid> Recipients;
+
+		/** Holds a flag indicating whether the message must be delivered. */
+		bool bReliable = false;
+	};
+
+	/** Structure for an acknowledgement of reliable messages. */
+	struct FAck
+	{
+		/** Holds the node that sent or receives the acknowledgement. */
+		FGuid NodeId;
+
+		/** Holds the sequence number of the next message to deliver (all earlier ones were received). */
+		uint32 NextSequence = 0;
+
+		/** Holds the messages after the next one that were received, one bit per sequence number. */
+		uint64 ReceivedMask = 0;
+	};
+
+	/** Structure for a reliable message that wasn't acknowledged yet. */
+	struct FUnackedMessage
+	{
+		/** Holds the encoded message, which is shared by all recipient nodes. */
+		TSharedPtr<const TArray<uint8>> Message;
+
+		/** Holds the identifier of the message's fragments. */
+		uint32 MessageId = 0;
+
+		/** Holds the time at which the message was first sent (in seconds). */
+		double SentTime = 0.0;
+
+		/** Holds a flag indicating whether the message was retransmitted (its round trip time is ambiguous then). */
+		bool bRetransmitted = false;
+
+		/** Holds the identifier of the message's retransmit timer. */
+		uint64 TimerId = 0;
+	};
+
+	/** Structure for the sending state of reliable messages to a node (sender thread only). */
+	struct FReliableSender
+	{
+		/** Holds the sequence number of the next sent message. */
+		uint32 NextSequence = 0;
+
+		/** Holds the sequence number up to which all messages were acknowledged. */
+		uint32 AckedSequence = 0;
+
+		/** Holds the unacknowledged messages, by sequence number. */
+		TMap<uint32, FUnackedMessage> Unacked;
+
+		/** Holds the messages waiting for the window to open. */
+		TArray<FUnackedMessage> Backlog;
+
+		/** Holds the smoothed round trip time (in seconds, 0 = not measured yet). */
+		double SmoothedRtt = 0.0;
+
+		/** Holds the round trip time variation (in seconds). */
+		double RttVariation = 0.0;
+
+		/** Holds the retransmit timeout (in seconds). */
+		double RetransmitTimeout = 0.2;
+	};
+
+	/** Structure for the receiving state of reliable messages from a node (receiver thread only). */
+	struct FReliableReceiver
+	{
+		/** Holds the sequence number of the next message to deliver. */
+		uint32 NextSequence = 0;
+
+		/** Holds the messages that were received out of order, by sequence number. */
+		TMap<uint32, TArray<uint8>> OutOfOrder;
+
+		/** Holds a flag indicating whether the node must be sent an acknowledgement. */
+		bool bAckPending = false;
+	};
+
+	/** Structure for a known remote node. */
+	struct FNode
+	{
+		/** Holds the node's endpoint. */
+		FSGNetworkEndpoint Endpoint;
+
+		/** Holds the time at which a datagram was last received from the node (in seconds). */
+		double LastSeen = 0.0;
+	};
+
+	/** Structure for a message whose fragments are being received. */
+	struct FReassembly
+	{
+		/** Holds the fragments (empty until received). */
+		TArray<TArray<uint8>> Fragments;
+
+		/** Holds the number of received fragments. */
+		int32 NumReceived = 0;
+
+		/** Holds the time at which the last fragment was received (in seconds). */
+		double LastReceived = 0.0;
+
+		/** Holds the sequence number of a reliable message (unset for unreliable messages). */
+		TOptional<uint32> Sequence;
+	};
+
+	/** Structure for a datagram that is being packed. */
+	struct FPackedDatagram
+	{
+		/** Holds the endpoint to send the datagram to. */
+		FSGNetworkEndpoint Recipient;
+
+		/** Holds the datagram's bytes. */
+		TArray<uint8> Data;
+	};
+
+private:
+
+	/** Encodes a message and queues it for the sender thread. */
+	bool EnqueueMessage(const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context, const TArray<FGuid>& Recipients);
+
+	/** Runs the receiver thread. */
+	void ReceiveDatagrams();
+
+	/** Runs the sender thread. */
+	void SendDatagrams();
+
+	/** Processes a received datagram. */
+	void ProcessDatagram(const FSGUdpInboundDatagram& Datagram, double Now);
+
+	/** Decodes a received message and passes it to the transport handler. */
+	void ReceiveMessage(TArrayView<const uint8> Message, const FGuid& NodeId);
+
+	/** Adds a received fragment to its message, receiving the message once it is complete. */
+	void ReceiveFragment(TArrayView<const uint8> Body, const FGuid& NodeId, bool bReliable, double Now);
+
+	/** Delivers a received reliable message in order, or buffers it until the messages before it arrived. */
+	void ReceiveReliableMessage(TArrayView<const uint8> Message, const FGuid& NodeId, uint32 Sequence);
+
+	/** Queues acknowledgements for the nodes that sent reliable messages since the last ones. */
+	void QueueAcks();
+
+	/** Applies the acknowledgements that remote nodes sent. */
+	void ProcessReceivedAcks();
+
+	/** Packs the queued acknowledgements into the datagrams for their nodes. */
+	void PackOutgoingAcks();
+
+	/** Retransmits the reliable messages whose timers expired. */
+	void RetransmitMessages();
+
+	/** Sends a reliable message to a node, or adds it to the node's backlog if its window is full. */
+	void SendReliableMessage(const FGuid& RecipientId, const FSGNetworkEndpoint& Endpoint, FUnackedMessage&& Unacked);
+
+	/** Sends a reliable message to a node and starts its retransmit timer. */
+	void TransmitReliableMessage(const FGuid& RecipientId, const FSGNetworkEndpoint& Endpoint, FReliableSender& ReliableSender, FUnackedMessage&& Unacked);
+
+	/** Removes an acknowledged message and updates the round trip time. */
+	void AcknowledgeMessage(FReliableSender& ReliableSender, uint32 Sequence, double Now);
+
+	/** Gets the endpoint of a known node. */
+	bool FindNodeEndpoint(const FGuid& RemoteNodeId, FSGNetworkEndpoint& OutEndpoint) const;
+
+	/** Forgets nodes and message fragments that timed out. */
+	void ForgetStaleNodes(double Now);
+
+	/** Packs the queued messages into datagrams and sends them. */
+	void SendPendingMessages();
+
+	/** Sends a segment without payload to the given endpoints. */
+	void SendControlSegment(ESegment Segment, TArrayView<const FSGNetworkEndpoint> Endpoints);
+
+	/** Appends a message to the datagram that is being packed for an endpoint, or fragments it. */
+	void PackMessage(const FSGNetworkEndpoint& Endpoint, TArrayView<const uint8> Message, uint32 MessageId, TOptional<uint32> Sequence = TOptional<uint32>());
+
+	/** Gets the datagram being packed for an endpoint, with room for a segment of the given size. */
+	TArray<uint8>& GetPackedDatagram(const FSGNetworkEndpoint& Endpoint, int32 SegmentSize);
+
+	/** Moves a packed datagram to the send batch, sending the batch if it is full. */
+	void FinishDatagram(FPackedDatagram& Datagram);
+
+	/** Sends the batch of finished datagrams. */
+	void FlushDatagrams();
+
+	/** Starts a new datagram with the transport header. */
+	void BeginDatagram(TArray<uint8>& OutData) const;
+
+	/** Gets a recycled or new datagram buffer. */
+	TArray<uint8> AllocateDatagramBuffer();
+
+private:
+
+	/** Identifies datagrams of this transport. */
+	static constexpr uint32 DatagramMagic = 0x54554753;
+
+	/** Holds the endpoint that the socket is bound to. */
+	FSGNetworkEndpoint UnicastEndpoint;
+
+	/** Holds the largest size of sent datagrams. */
+	int32 MaxDatagramSize;
+
+	/** Holds the identifier of this transport node. */
+	FGuid NodeId;
+
+	/** Holds the transport's socket. */
+	FSGUdpSocket Socket;
+
+	/** Holds the handler of received messages and node events (only valid while the transport runs). */
+	ISGMessageTransportHandler* Handler;
+
+	/** Holds a flag indicating that the threads are stopping. */
+	std::atomic<bool> bStopping;
+
+	/** Holds the receiver thread. */
+	FRunnableThread* ReceiverThread;
+
+	/** Holds the sender thread. */
+	FRunnableThread* SenderThread;
+
+	/** Holds the runnable of the receiver thread. */
+	TUniquePtr<FReceiver> Receiver;
+
+	/** Holds the runnable of the sender thread. */
+	TUniquePtr<FSender> Sender;
+
+	/** Holds an event that wakes up the sender thread when messages are queued. */
+	FEvent* SendEvent;
+
+	/** Holds the messages waiting to be sent. */
+	TQueue<FOutboundMessage, EQueueMode::Mpsc> OutboundMessages;
+
+	/** Holds the known remote nodes. */
+	TMap<FGuid, FNode> Nodes;
+
+	/** Holds the endpoints of the remote transports to say hello to. */
+	TArray<FSGNetworkEndpoint> StaticEndpoints;
+
+	/** Guards the nodes and the static endpoints. */
+	mutable FCriticalSection NodesCriticalSection;
+
+	/** Holds the messages whose fragments are being received, by sending node and message identifier (receiver thread only). */
+	TMap<TPair<FGuid, uint32>, FReassembly> Reassemblies;
+
+	/** Holds the codec of sent and received messages (decoding on the receiver thread only). */
+	FSGTransportCodec Codec;
+
+	/** Holds the datagrams being packed, by recipient endpoint (sender thread only). */
+	TMap<FSGNetworkEndpoint, FPackedDatagram> PackedDatagrams;
+
+	/** Holds the finished datagrams waiting to be sent (sender thread only). */
+	TArray<FPackedDatagram> FinishedDatagrams;
+
+	/** Holds datagram buffers that can be reused (sender thread only). */
+	TArray<TArray<uint8>> FreeDatagramBuffers;
+
+	/** Holds the identifier of the next sent message (sender thread only). */
+	uint32 NextMessageId;
+
+	/** Holds the number of sent datagrams. */
+	std::atomic<int64> NumSentDatagrams;
+
+	/** Holds the number of received datagrams. */
+	std::atomic<int64> NumReceivedDatagrams;
+
+	/** Holds the receiving states of reliable messages, by sending node (receiver thread only). */
+	TMap<FGuid, FReliableReceiver> ReliableReceivers;
+
+	/** Holds the sending states of reliable messages, by recipient node (sender thread only). */
+	TMap<FGuid, FReliableSender> ReliableSenders;
+
+	/** Holds the retransmit timers of unacknowledged messages (sender thread only). */
+	FSGMessageTimingWheel RetransmitTimers;
+
+	/** Holds the recipient node and sequence number of each retransmit timer (sender thread only). */
+	TMap<uint64, TPair<FGuid, uint32>> RetransmitTargets;
+
+	/** Holds the identifier of the last retransmit timer (sender thread only). */
+	uint64 LastTimerId;
+
+	/** Holds the acknowledgements that remote nodes sent, for the sender thread. */
+	TQueue<FAck, EQueueMode::Spsc> ReceivedAcks;
+
+	/** Holds the acknowledgements to send to remote nodes, for the sender thread. */
+	TQueue<FAck, EQueueMode::Spsc> OutgoingAcks;
+
+	/** Holds the nodes that were forgotten, for the sender thread to drop their sending states. */
+	TQueue<FGuid, EQueueMode::Spsc> ForgottenNodes;
+
+	/** Holds the number of retransmitted reliable messages. */
+	std::atomic<int64> NumRetransmittedMessages;
+};
@@ -0,0 +1,99 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGNetworkMessagingExtension.h"
+#include "Core/Transport/SGUdpSocket.h"
+
+class FSGUdpMessageTransport;
+class ISGMessageBridge;
+class ISGMessageBus;
+class ISGMessagingModule;
+
+
+/**
+ * Implements the network messaging extension of the UDP transport.
+ *
+ * While its services run, the extension bridges the message buses listed in
+ * USGMessagingSettings::UdpTransportBuses through UDP transports, including buses that are
+ * created later. Endpoints added or removed at runtime apply to all running transports.
+ *
+ * @see FSGUdpMessageTransport
+ */
+class FSGUdpMessagingExtension
+	: public ISGNetworkMessagingExtension
+{
+public:
+
+	/**
+	 * Creates and initializes a new instance.
+	 *
+	 * @param InMessagingModule The messaging module whose buses are bridged.
+	 */
+	explicit FSGUdpMessagingExtension(ISGMessagingModule& InMessagingModule);
+
+	/** Virtual destructor. */
+	virtual ~FSGUdpMessagingExtension();
+
+public:
+
+	//~ ISGNetworkMessagingExtension interface
+
+	virtual FName GetName() const override;
+	virtual bool IsSupportEnabled() const override;
+	virtual void RestartServices() override;
+	virtual void ShutdownServices() override;
+	virtual void AddEndpoint(const FString& InEndpoint) override;
+	virtual void RemoveEndpoint(const FString& InEndpoint) override;
+
+private:
+
+	/** Bridges a message bus if it is configured for the UDP transport. */
+	void BridgeBus(const TSharedRef<ISGMessageBus, ESPMode::ThreadSafe>& Bus);
+
+	/** Destroys all bridges and their transports. */
+	void DestroyBridges();
+
+	/** Gets the static endpoints of the running configuration. */
+	TArray<FSGNetworkEndpoint> GetStaticEndpoints() const;
+
+	/** Callback for message bus startups. */
+	void HandleMessageBusStartup(TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> WeakBus);
+
+	/** Callback for message bus shutdowns. */
+	void HandleMessageBusShutdown(TWeakPtr<ISGMessageBus, ESPMode::ThreadSafe> WeakBus);
+
+private:
+
+	/** Structure for a bridged message bus. */
+	struct FBridgedBus
+	{
+		/** Holds the bus's bridge. */
+		TSharedPtr<ISGMessageBridge, ESPMode::ThreadSafe> Bridge;
+
+		/** Holds the bridge's transport. */
+		TSharedPtr<FSGUdpMessageTransport, ESPMode::ThreadSafe> Transport;
+	};
+
+	/** Holds the messaging module. */
+	ISGMessagingModule& MessagingModule;
+
+	/** Holds the bridged buses, by bus name. */
+	TMap<FString, FBridgedBus> BridgedBuses;
+
+	/** Holds the endpoints that were added to the running configuration. */
+	TArray<FSGNetworkEndpoint> AddedEndpoints;
+
+	/** Holds the configured endpoints that were removed from the running configuration. */
+	TArray<FSGNetworkEndpoint> RemovedEndpoints;
+
+	/** Holds a flag indicating whether the services are running. */
+	bool bRunning;
+
+	/** Holds the handle of the bus startup callback. */
+	FDelegateHandle MessageBusStartupHandle;
+
+	/** Holds the handle of the bus shutdown callback. */
+	FDelegateHandle MessageBusShutdownHandle;
+};
@@ -0,0 +1,117 @@
+// Copyright Epic Games, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Transport/SGNetworkEndpoint.h"
+
+class FSocket;
+
+
+/**
+ * Structure for a datagram to be sent.
+ */
+struct FSGUdpOutboundDatagram
+{
+	/** Holds the endpoint to send the datagram to. */
+	FSGNetworkEndpoint Recipient;
+
+	/** Holds the datagram's bytes. */
+	TArrayView<const uint8> Data;
+};
+
+
+/**
+ * Structure for a received datagram.
+ */
+struct FSGUdpInboundDatagram
+{
+	/** Holds the receive buffer, whose size limits the size of the datagram. */
+	TArray<uint8> Data;
+
+	/** Holds the number of received bytes. */
+	int32 Size = 0;
+
+	/** Holds the endpoint that sent the datagram. */
+	FSGNetworkEndpoint Sender;
+};
+
+
+/**
+ * Implements a UDP socket that sends and receives datagrams in batches.
+ *
+ * On Linux, batches are handed to the kernel with single sendmmsg and recvmmsg calls. On other
+ * platforms, the socket subsystem's sockets are used and each datagram takes a separate call.
+ * The socket is non-blocking, and a thread may send while another thread receives.
+ */
+class SGMESSAGING_API FSGUdpSocket
+{
+public:
+
+	/** The largest number of datagrams passed to the system in one call. */
+	static constexpr int32 MaxBatchSize = 64;
+
+public:
+
+	/** Default constructor. */
+	FSGUdpSocket();
+
+	/** Destructor. */
+	~FSGUdpSocket();
+
+	FSGUdpSocket(const FSGUdpSocket&) = delete;
+	FSGUdpSocket& operator=(const FSGUdpSocket&) = delete;
+
+public:
+
+	/**
+	 * Opens the socket.
+	 *
+	 * @param Endpoint The endpoint to bind the socket to.
+	 * @param BufferSize The size of the system's send and receive buffers (in bytes).
+	 * @return true if the socket was opened, false otherwise.
+	 * @see Close
+	 */
+	bool Open(const FSGNetworkEndpoint& Endpoint, int32 BufferSize);
+
+	/**
+	 * Closes the socket.
+	 *
+	 * @see Open
+	 */
+	void Close();
+
+	/**
+	 * Checks whether the socket is open.
+	 *
+	 * @return true if the socket is open, false otherwise.
+	 */
+	bool IsOpen() const;
+
+	/**
+	 * Sends a batch of datagrams.
+	 *
+	 * Datagrams that the system doesn't accept are dropped.
+	 *
+	 * @param Datagrams The datagrams to send.
+	 * @return The number of datagrams that were sent.
+	 */
+	int32 SendBatch(TArrayView<const FSGUdpOutboundDatagram> Datagrams);
+
+	/**
+	 * Receives a batch of datagrams, waiting for the first one if none is pending.
+	 *
+	 * @param Datagrams The datagrams to fill, with receive buffers of the largest expected datagram size.
+	 * @param WaitTime The longest time to wait for a datagram.
+	 * @return The number of received datagrams.
+	 */
+	int32 ReceiveBatch(TArrayView<FSGUdpInboundDatagram> Datagrams, const FTimespan& WaitTime);
+
+private:
+
+	/** Holds the native socket descriptor if batched system calls are used (-1 otherwise). */
+	int32 NativeSocket;
+
+	/** Holds the socket subsystem's socket if batched system calls aren't available. */
+	FSocket* Socket;
+};
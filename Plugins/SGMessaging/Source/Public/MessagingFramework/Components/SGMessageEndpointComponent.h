@@ -8,6 +8,21 @@
 #include "Core/Common/SGMessageEndpoint.h"
 #include "SGMessageEndpointComponent.generated.h"
 
+/**
+ * Enumerates the ways a component can get its message endpoint.
+ */
+UENUM(BlueprintType)
+enum class ESGMessageEndpointSharing : uint8
+{
+	/** The component creates an endpoint of its own. */
+	None,
+
+	/** The component subscribes as a lightweight subscriber of the endpoint shared by the world. */
+	World,
+
+	/** The component subscribes as a lightweight subscriber of the endpoint shared by its owner's class. */
+	Class
+};
 
 UCLASS(ClassGroup=(Custom), meta=(BlueprintSpawnableComponent))
 class SGMESSAGING_API USGMessageEndpointComponent : public UActorComponent
@@ -22,6 +37,9 @@ protected:
 	// Called when the game starts
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or the component is destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 public:
 	// Called every frame
 	virtual void TickComponent(float DeltaTime, ELevelTick TickType,
@@ -35,16 +53,51 @@ public:
 	void Subscribe(MESSAGE_TAG_PARAM_SIGNATURE, HandlerType* Handler,
 	               typename TSGRawMessageHandler<FSGMessage, HandlerType>::FuncType HandlerFunc)
 	{
-		if (MessageEndpoint != nullptr)
+		if (MessageEndpoint == nullptr)
+		{
+			return;
+		}
+
+		if (bSharesEndpoint)
+		{
+			MessageEndpoint->Subscribe(this, MESSAGE_TAG_PARAM_VALUE, Handler, HandlerFunc);
+		}
+		else
 		{
 			MessageEndpoint->Subscribe(MESSAGE_TAG_PARAM_VALUE, Handler, HandlerFunc);
 		}
 	}
 
+	/**
+	 * Subscribes an event for the published messages within a radius of the owner.
+	 *
+	 * Messages published with an origin (see PublishAt) are only routed to the components near it, so
+	 * their cost doesn't grow with the number of components in the world. Messages published without an
+	 * origin reach all components that subscribed nearby. The interest follows the owner as it moves.
+	 *
+	 * Components that share an endpoint subscribe to all messages instead.
+	 *
+	 * @param Radius The radius around the owner (in world units).
+	 * @see PublishAt, USGMessageWorldSubsystem::RegisterSpatialInterest
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SubscribeNearby(const int32 InTopicID, const int32 InMessageID, const FSGBlueprintMessageDelegate& InDelegate,
+	                     float Radius);
+
 	UFUNCTION(BlueprintCallable)
 	void Publish(const int32 InTopicID, const int32 InMessageID, const FSGBlueprintPublishParameter InParameter,
 	             const FSGBlueprintMessage InMessage);
 
+	/**
+	 * Publishes a message that originates at the given location, for the components that subscribed nearby.
+	 *
+	 * @param Origin The location at which the message originates.
+	 * @see SubscribeNearby
+	 */
+	UFUNCTION(BlueprintCallable)
+	void PublishAt(const int32 InTopicID, const int32 InMessageID, const FSGBlueprintPublishParameter InParameter,
+	               const FSGBlueprintMessage InMessage, const FVector Origin);
+
 	template <typename ...Args>
 	void Publish(MESSAGE_TAG_PARAM_SIGNATURE, CONST_PUBLISH_PARAMETER_SIGNATURE, Args&&... Params)
 	{
@@ -96,7 +149,45 @@ public:
 	UFUNCTION(BlueprintCallable)
 	FSGBlueprintMessageAddress GetAddress() const;
 
+	/** Gets the component's endpoint, which may be shared with other components. */
+	USGBlueprintMessageEndpoint* GetMessageEndpoint() const
+	{
+		return MessageEndpoint;
+	}
+
+public:
+	/**
+	 * How the component gets its endpoint.
+	 *
+	 * Components that share an endpoint cost no endpoint of their own and only get an address when
+	 * GetAddress is called. Their messages are sent from the shared endpoint's address.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Messaging")
+	ESGMessageEndpointSharing EndpointSharing = ESGMessageEndpointSharing::None;
+
+	/**
+	 * Whether the component's own endpoint is registered with the bus only when it is enabled or sends its first message.
+	 *
+	 * Useful for pooled actors, which can enable the endpoint when they are taken from the pool.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "Messaging")
+	bool bActivateEndpointOnFirstUse = false;
+
+	/**
+	 * Enables or disables the component's endpoint; disabled endpoints are removed from the bus.
+	 *
+	 * Components that share an endpoint can't disable it.
+	 */
+	UFUNCTION(BlueprintCallable)
+	void SetEndpointEnabled(bool bEnabled);
+
 private:
 	UPROPERTY()
 	USGBlueprintMessageEndpoint* MessageEndpoint;
+
+	/** Whether MessageEndpoint is shared with other components. */
+	bool bSharesEndpoint = false;
+
+	/** Whether the component registered spatial interests with the world subsystem. */
+	bool bHasSpatialInterests = false;
 };
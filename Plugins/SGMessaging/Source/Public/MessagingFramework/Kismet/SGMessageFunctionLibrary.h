@@ -73,10 +73,117 @@ public:
 		P_NATIVE_END;
 	}
 
+	/** Copies all properties of a structure into the message, keyed by their names. */
+	UFUNCTION(BlueprintCallable, CustomThunk,
+		meta = (CustomStructureParam = "Struct", AutoCreateRefTerm = "Struct"))
+	static FSGBlueprintMessage SetStruct(const FSGBlueprintMessage& Message, const int32& Struct);
+	DECLARE_FUNCTION(execSetStruct)
+	{
+		P_GET_STRUCT(FSGBlueprintMessage, Message);
+
+		Stack.StepCompiledIn<FStructProperty>(nullptr);
+
+		FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+
+		const void* StructAddress = Stack.MostRecentPropertyAddress;
+
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+			*static_cast<FSGBlueprintMessage*>(RESULT_PARAM) = ExecSetStruct(Message, StructProperty, StructAddress);
+		P_NATIVE_END;
+	}
+
+	/**
+	 * Copies the message parameters named like the properties of a structure into the structure.
+	 *
+	 * Messages delivered to a projected subscription only copy the parameters of the projection.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk,
+		meta = (CustomStructureParam = "Struct"))
+	static FSGBlueprintMessage GetStruct(const FSGBlueprintMessage& Message, int32 Struct);
+	DECLARE_FUNCTION(execGetStruct)
+	{
+		P_GET_STRUCT(FSGBlueprintMessage, Message);
+
+		Stack.StepCompiledIn<FStructProperty>(nullptr);
+
+		FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+
+		void* StructAddress = Stack.MostRecentPropertyAddress;
+
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+			*static_cast<FSGBlueprintMessage*>(RESULT_PARAM) = ExecGetStruct(Message, StructProperty, StructAddress);
+		P_NATIVE_END;
+	}
+
+	/**
+	 * Creates a message declared as a structure (its schema).
+	 *
+	 * The structure is copied into the message as a whole, so Blueprints fill it in with the usual Make
+	 * struct node, whose members are compiled to direct accesses, instead of setting one parameter per
+	 * field by name.
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk,
+		meta = (DisplayName = "Make SG Message", CustomStructureParam = "Schema", AutoCreateRefTerm = "Schema"))
+	static FSGBlueprintMessage MakeSchemaMessage(const int32& Schema);
+	DECLARE_FUNCTION(execMakeSchemaMessage)
+	{
+		Stack.StepCompiledIn<FStructProperty>(nullptr);
+
+		FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+
+		const void* StructAddress = Stack.MostRecentPropertyAddress;
+
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+			*static_cast<FSGBlueprintMessage*>(RESULT_PARAM) = ExecMakeSchemaMessage(StructProperty, StructAddress);
+		P_NATIVE_END;
+	}
+
+	/**
+	 * Copies the structure a message was made from into a structure of the same type.
+	 *
+	 * @return true if the message was made from this structure, false otherwise (the structure keeps its values).
+	 */
+	UFUNCTION(BlueprintCallable, CustomThunk,
+		meta = (DisplayName = "Break SG Message", CustomStructureParam = "Schema"))
+	static bool BreakSchemaMessage(const FSGBlueprintMessage& Message, int32 Schema);
+	DECLARE_FUNCTION(execBreakSchemaMessage)
+	{
+		P_GET_STRUCT(FSGBlueprintMessage, Message);
+
+		Stack.StepCompiledIn<FStructProperty>(nullptr);
+
+		FStructProperty* StructProperty = CastField<FStructProperty>(Stack.MostRecentProperty);
+
+		void* StructAddress = Stack.MostRecentPropertyAddress;
+
+		P_FINISH;
+
+		P_NATIVE_BEGIN;
+			*static_cast<bool*>(RESULT_PARAM) = ExecBreakSchemaMessage(Message, StructProperty, StructAddress);
+		P_NATIVE_END;
+	}
+
 public:
 	static FSGBlueprintMessage ExecSet(const FSGBlueprintMessage& Message, const FName& Key, FProperty* InProperty,
 	                                   const void* PropertyAddress);
 
 	static FSGBlueprintMessage ExecGet(const FSGBlueprintMessage& Message, const FName& Key, FProperty* InProperty,
 	                                   void* PropertyAddress);
+
+	static FSGBlueprintMessage ExecSetStruct(const FSGBlueprintMessage& Message, const FStructProperty* StructProperty,
+	                                         const void* StructAddress);
+
+	static FSGBlueprintMessage ExecGetStruct(const FSGBlueprintMessage& Message, const FStructProperty* StructProperty,
+	                                         void* StructAddress);
+
+	static FSGBlueprintMessage ExecMakeSchemaMessage(const FStructProperty* StructProperty, const void* StructAddress);
+
+	static bool ExecBreakSchemaMessage(const FSGBlueprintMessage& Message, const FStructProperty* StructProperty,
+	                                   void* StructAddress);
 };
@@ -5,14 +5,23 @@
 #include "CoreMinimal.h"
 #include "Blueprint/Bus/SGBlueprintMessageBus.h"
 #include "Blueprint/Common/SGBlueprintMessageEndpoint.h"
+#include "Core/Common/SGMessageEndpoint.h"
 #include "Subsystems/WorldSubsystem.h"
 #include "SGMessageWorldSubsystem.generated.h"
 
+class USGMessageEndpointComponent;
+
 /**
- * 
+ * Owns the default message bus of a world, and pumps it from the world tick if it runs in frame mode.
+ *
+ * Endpoints with an inbox can be registered to have their inboxes processed from the world tick as
+ * well, each within its own per-frame budget and in the order of their priorities.
+ *
+ * The spatial interests of endpoint components follow their owners, and are sent to the bus in one
+ * batch per frame for all components that moved.
  */
 UCLASS()
-class SGMESSAGING_API USGMessageWorldSubsystem : public UWorldSubsystem
+class SGMESSAGING_API USGMessageWorldSubsystem : public UTickableWorldSubsystem
 {
 	GENERATED_BODY()
 
@@ -21,6 +30,10 @@ public:
 
 	virtual void Deinitialize() override;
 
+	virtual void Tick(float DeltaTime) override;
+
+	virtual TStatId GetStatId() const override;
+
 public:
 	UFUNCTION(BlueprintCallable)
 	USGBlueprintMessageBus* GetDefaultBus() const;
@@ -28,10 +41,132 @@ public:
 	UFUNCTION(BlueprintCallable)
 	USGBlueprintMessageEndpoint* GetDefaultMessageEndpoint() const;
 
+	/**
+	 * Gets an endpoint that lightweight subscribers share, creating it the first time.
+	 *
+	 * @param Class The class whose instances share the endpoint (nullptr = the endpoint shared by the world).
+	 * @return The shared endpoint.
+	 * @see USGBlueprintMessageEndpoint::Subscribe
+	 */
+	USGBlueprintMessageEndpoint* GetSharedMessageEndpoint(UClass* Class = nullptr);
+
+public:
+	/**
+	 * Processes an endpoint's inbox from the world tick.
+	 *
+	 * Messages that exceed the budget are processed in the next frames. The inbox is unregistered
+	 * automatically when the endpoint is destroyed.
+	 *
+	 * @param Endpoint The endpoint (its inbox must be enabled).
+	 * @param Priority Inboxes with higher priorities are processed first.
+	 * @param MaxMessagesPerFrame The maximum number of messages to process per frame (0 = unlimited).
+	 * @param MaxTimePerFrameMs The maximum time to spend per frame (in milliseconds, 0 = unlimited).
+	 * @see UnregisterInbox, SetInboxFrameBudget
+	 */
+	void RegisterInbox(const TSharedRef<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint, int32 Priority = 0,
+	                   int32 MaxMessagesPerFrame = 0, float MaxTimePerFrameMs = 0.0f);
+
+	/**
+	 * Stops processing an endpoint's inbox from the world tick.
+	 *
+	 * @param Endpoint The endpoint.
+	 * @see RegisterInbox
+	 */
+	void UnregisterInbox(const TSharedRef<FSGMessageEndpoint, ESPMode::ThreadSafe>& Endpoint);
+
+	/**
+	 * Limits the time all registered inboxes may take per frame together.
+	 *
+	 * Inboxes that don't get to run in a frame because of this budget run first in the next frame.
+	 *
+	 * @param MaxTimeMs The maximum time (in milliseconds, 0 = unlimited).
+	 */
+	void SetInboxFrameBudget(float MaxTimeMs);
+
+	/** Gets the number of messages waiting in all registered inboxes. */
+	int32 GetNumQueuedInboxMessages() const;
+
+public:
+	/**
+	 * Adds a spatial interest of a component's endpoint that follows the component's owner.
+	 *
+	 * @param Component The component (it must have an endpoint of its own).
+	 * @param MessageType The type of messages.
+	 * @param Radius The radius of the interest around the owner.
+	 * @see UnregisterSpatialInterests, ISGMessageBus::UpdateSpatialInterests
+	 */
+	void RegisterSpatialInterest(USGMessageEndpointComponent* Component, const FName& MessageType, float Radius);
+
+	/**
+	 * Removes all spatial interests of a component's endpoint.
+	 *
+	 * @param Component The component.
+	 * @see RegisterSpatialInterest
+	 */
+	void UnregisterSpatialInterests(const USGMessageEndpointComponent* Component);
+
+private:
+	/** Processes the registered inboxes within their budgets. */
+	void ProcessInboxes();
+
+	/** Sends the spatial interests of the components that moved to the bus. */
+	void UpdateSpatialInterests();
+
+private:
+	/** Structure for an inbox that is processed from the world tick. */
+	struct FTickedInbox
+	{
+		TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> Endpoint;
+
+		int32 Priority = 0;
+
+		int32 MaxMessagesPerFrame = 0;
+
+		double MaxTimePerFrame = 0.0;
+
+		/** The last frame in which the inbox was processed, so that inboxes skipped by the frame budget go first. */
+		uint64 LastProcessedFrame = 0;
+	};
+
+	/** Holds the registered inboxes, sorted by priority. */
+	TArray<FTickedInbox> TickedInboxes;
+
+	/** Holds the time all inboxes may take per frame together (in seconds, 0 = unlimited). */
+	double InboxFrameBudget = 0.0;
+
+	/** Structure for the spatial interests of a component's endpoint. */
+	struct FSpatialSubscriber
+	{
+		TWeakObjectPtr<USGMessageEndpointComponent> Component;
+
+		TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> Endpoint;
+
+		/** The message types and radii of the interests. */
+		TArray<TPair<FName, float>> Interests;
+
+		/** The owner's location when the interests were last sent. */
+		FVector LastLocation = FVector::ZeroVector;
+
+		/** Whether the interests must be sent even if the owner didn't move. */
+		bool bDirty = true;
+	};
+
+	/** Holds the components that have spatial interests. */
+	TArray<FSpatialSubscriber> SpatialSubscribers;
+
+	/** Holds the interest updates to send in the next frame (scratch between frames). */
+	TArray<FSGMessageSpatialInterest> PendingSpatialInterests;
+
 private:
 	UPROPERTY()
 	USGBlueprintMessageBus* DefaultBus;
 
 	UPROPERTY()
 	USGBlueprintMessageEndpoint* DefaultMessageEndpoint;
+
+	UPROPERTY()
+	USGBlueprintMessageEndpoint* SharedMessageEndpoint;
+
+	UPROPERTY()
+	TMap<UClass*, USGBlueprintMessageEndpoint*> ClassMessageEndpoints;
 };
@@ -0,0 +1,163 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include <atomic>
+
+/**
+ * Counts the allocations that the current thread makes through GMalloc between Begin and End.
+ *
+ * The counter installs itself in front of GMalloc and forwards everything to it, so it only adds a
+ * branch to allocations of other threads. It is never destroyed, because other threads may still be
+ * inside one of its functions after End.
+ */
+class FSGTestAllocationCounter final : public FMalloc
+{
+public:
+	static FSGTestAllocationCounter& Get()
+	{
+		static FSGTestAllocationCounter* Counter = new FSGTestAllocationCounter();
+
+		return *Counter;
+	}
+
+public:
+	void Begin()
+	{
+		NumAllocations = 0;
+
+		NumBytes = 0;
+
+		ThreadId = FPlatformTLS::GetCurrentThreadId();
+
+		Inner = GMalloc;
+
+		GMalloc = this;
+
+		bCounting.store(true);
+	}
+
+	void End()
+	{
+		bCounting.store(false);
+
+		GMalloc = Inner;
+	}
+
+	int64 GetNumAllocations() const
+	{
+		return NumAllocations;
+	}
+
+	int64 GetNumBytes() const
+	{
+		return NumBytes;
+	}
+
+public:
+	//~ FMalloc interface
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation(Count);
+
+		return Inner->Malloc(Count, Alignment);
+	}
+
+	virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation(Count);
+
+		return Inner->TryMalloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation(Count);
+
+		return Inner->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation(Count);
+
+		return Inner->TryRealloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		Inner->Free(Original);
+	}
+
+	virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override
+	{
+		return Inner->QuantizeSize(Count, Alignment);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return Inner->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual void Trim(bool bTrimThreadCaches) override
+	{
+		Inner->Trim(bTrimThreadCaches);
+	}
+
+	virtual void SetupTLSCachesOnCurrentThread() override
+	{
+		Inner->SetupTLSCachesOnCurrentThread();
+	}
+
+	virtual void ClearAndDisableTLSCachesOnCurrentThread() override
+	{
+		Inner->ClearAndDisableTLSCachesOnCurrentThread();
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return Inner->IsInternallyThreadSafe();
+	}
+
+	virtual bool ValidateHeap() override
+	{
+		return Inner->ValidateHeap();
+	}
+
+	virtual const TCHAR* GetDescriptiveName() override
+	{
+		return Inner->GetDescriptiveName();
+	}
+
+private:
+	FSGTestAllocationCounter()
+		: Inner(GMalloc)
+	{
+	}
+
+	void CountAllocation(const SIZE_T Size)
+	{
+		// reallocations that shrink or free are counted too, they are just as unwanted on a hot path
+		if (bCounting.load(std::memory_order_relaxed) && (FPlatformTLS::GetCurrentThreadId() == ThreadId))
+		{
+			++NumAllocations;
+
+			NumBytes += Size;
+		}
+	}
+
+private:
+	FMalloc* Inner;
+
+	std::atomic<bool> bCounting{false};
+
+	uint32 ThreadId = 0;
+
+	int64 NumAllocations = 0;
+
+	int64 NumBytes = 0;
+};
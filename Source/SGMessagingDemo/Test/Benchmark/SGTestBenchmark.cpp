@@ -0,0 +1,1275 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SGTestBenchmark.h"
+#include "SGTestAllocationCounter.h"
+#include "Blueprint/Common/SGBlueprintMessageEndpoint.h"
+#include "Blueprint/Common/SGBlueprintMessageEndpointBuilder.h"
+#include "Blueprint/Message/SGBlueprintMessage.h"
+#include "Core/Common/SGMessageEndpoint.h"
+#include "Core/Common/SGMessageEndpointBuilder.h"
+#include "Core/Bus/SGMessageContext.h"
+#include "Core/Bus/SGMessageSubscription.h"
+#include "Core/Bus/SGMessageSubscriptionTable.h"
+#include "Core/Interface/ISGMessagingModule.h"
+#include "Core/Message/SGMessagePrototype.h"
+#include "Core/Message/SGMessageSerializer.h"
+#include "Core/Settings/SGMessagingSettings.h"
+#include "Core/Transport/SGTransportCodec.h"
+#include "HAL/PlatformMisc.h"
+#include "HAL/PlatformProcess.h"
+#include "JsonObjectConverter.h"
+#include "MessagingFramework/Kismet/SGMessageFunctionLibrary.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Misc/ScopeLock.h"
+#include "Serialization/MemoryReader.h"
+#include "Serialization/MemoryWriter.h"
+#include "Subsystems/SubsystemBlueprintLibrary.h"
+#include "SGMessagingDemo/Test/SGMessagingType.h"
+#include "SGMessagingDemo/Test/Subsystem/SGMessagingTestSubsystem.h"
+#include <atomic>
+
+namespace SGTestBenchmark
+{
+	typedef TSharedRef<std::atomic<int32>, ESPMode::ThreadSafe> FCounter;
+
+	/** Samples that are taken on router threads. */
+	struct FSamples
+	{
+		FCriticalSection CriticalSection;
+
+		TArray<double> Samples;
+	};
+
+	/** A context that is captured on a router thread. */
+	struct FCapture
+	{
+		FCriticalSection CriticalSection;
+
+		TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+	};
+
+	FCounter MakeCounter()
+	{
+		return MakeShared<std::atomic<int32>, ESPMode::ThreadSafe>(0);
+	}
+
+	/** Waits until the counter reaches the target, returning false on timeout. */
+	bool WaitFor(const FCounter& Counter, const int32 Target, const double Timeout)
+	{
+		const double EndTime = FPlatformTime::Seconds() + Timeout;
+
+		while (Counter->load() < Target)
+		{
+			if (FPlatformTime::Seconds() > EndTime)
+			{
+				return false;
+			}
+
+			FPlatformProcess::YieldThread();
+		}
+
+		return true;
+	}
+
+	double ToMicroseconds(const int64 Cycles)
+	{
+		return (double)Cycles * FPlatformTime::GetSecondsPerCycle64() * 1000000.0;
+	}
+}
+
+// Sets default values
+ASGTestBenchmark::ASGTestBenchmark()
+{
+	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+// Called when the game starts or when spawned
+void ASGTestBenchmark::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (const auto MessagingTestSubsystem = Cast<USGMessagingTestSubsystem>(
+		USubsystemBlueprintLibrary::GetGameInstanceSubsystem(GetWorld(), USGMessagingTestSubsystem::StaticClass())))
+	{
+		MessagingTestSubsystem->TestBenchmarkDelegate.AddDynamic(this, &ASGTestBenchmark::OnDelegateBroadcast);
+	}
+}
+
+// Called every frame
+void ASGTestBenchmark::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+}
+
+void ASGTestBenchmark::OnDelegateBroadcast()
+{
+	Results.Reset();
+
+	bFailed = false;
+
+	// a private bus keeps the game's own traffic out of the numbers
+	Bus = ISGMessagingModule::Get().CreateBus(TEXT("SGMessagingBenchmark"));
+
+	if (!Bus.IsValid())
+	{
+		return;
+	}
+
+	for (const int32 NumSubscribers : SubscriberCounts)
+	{
+		BenchmarkPublishSubscribe(NumSubscribers);
+	}
+
+	BenchmarkRequestReply();
+
+	BenchmarkForwardChain(1);
+
+	BenchmarkForwardChain(4);
+
+	BenchmarkDelay();
+
+	BenchmarkBlueprintParameter();
+
+	BenchmarkContainerCopy(10000);
+
+	BenchmarkBridgeLoopback();
+
+	BenchmarkSerializers();
+
+	BenchmarkAllocations();
+
+	CheckAllocationBudgets();
+
+	BenchmarkSubscriptionChurn(1000);
+
+	for (const int32 NumSubscribers : SubscriberCounts)
+	{
+		BenchmarkSubscriptionScan(NumSubscribers, ESGMessageScope::Process);
+
+		BenchmarkSubscriptionScan(NumSubscribers, ESGMessageScope::Thread);
+	}
+
+	BenchmarkTeardown(1000, 50);
+
+	Bus->Shutdown();
+
+	Bus.Reset();
+
+	WriteResults();
+
+	if (bFailed)
+	{
+		UE_LOG(LogTemp, Error, TEXT("ASGTestBenchmark failed, allocation budgets were exceeded or not measured"));
+
+		// CI runs are unattended, so the exit code is what fails the job
+		if (FApp::IsUnattended())
+		{
+			FPlatformMisc::RequestExitWithStatus(false, 1);
+		}
+	}
+}
+
+TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> ASGTestBenchmark::BuildEndpoint(const FName& Name) const
+{
+	// handlers run on the router threads, so that the game thread can wait for them
+	return FSGMessageEndpointBuilder(Name, Bus.ToSharedRef()).ReceivingOnAnyThread().Build();
+}
+
+void ASGTestBenchmark::BenchmarkPublishSubscribe(const int32 NumSubscribers)
+{
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	TArray<TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>> Subscribers;
+
+	for (int32 Index = 0; Index < NumSubscribers; ++Index)
+	{
+		const auto Subscriber = BuildEndpoint(*FString::Printf(TEXT("BenchmarkSubscriber%d"), Index));
+
+		if (!Subscriber.IsValid())
+		{
+			return;
+		}
+
+		Subscriber->Subscribe(Topic_Benchmark, TopicBenchmark_Publish,
+		                      [NumReceived](const FSGMessage& Message,
+		                                    const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+		                      {
+			                      NumReceived->fetch_add(1, std::memory_order_relaxed);
+		                      });
+
+		Subscribers.Add(Subscriber);
+	}
+
+	const auto Publisher = BuildEndpoint(TEXT("BenchmarkPublisher"));
+
+	if (!Publisher.IsValid())
+	{
+		return;
+	}
+
+	// the first message also waits for the subscriptions to reach the routers
+	Publisher->Publish(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER, MESSAGE_KEY("Val"), 0);
+
+	if (!SGTestBenchmark::WaitFor(NumReceived, NumSubscribers, Timeout))
+	{
+		return;
+	}
+
+	NumReceived->store(0);
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Publisher->Publish(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER, MESSAGE_KEY("Val"),
+		                   Index);
+	}
+
+	const bool bCompleted = SGTestBenchmark::WaitFor(NumReceived, NumMessages * NumSubscribers, Timeout);
+
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	if (bCompleted)
+	{
+		TArray<double> Samples;
+
+		AddResult(TEXT("PublishSubscribe"), NumSubscribers, NumMessages, Seconds, Samples);
+	}
+}
+
+void ASGTestBenchmark::BenchmarkRequestReply()
+{
+	const auto NumReplies = SGTestBenchmark::MakeCounter();
+
+	const auto Responder = BuildEndpoint(TEXT("BenchmarkResponder"));
+
+	const auto Requester = BuildEndpoint(TEXT("BenchmarkRequester"));
+
+	if (!Responder.IsValid() || !Requester.IsValid())
+	{
+		return;
+	}
+
+	TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> WeakResponder = Responder;
+
+	Responder->Subscribe(Topic_Benchmark, TopicBenchmark_Request,
+	                     [WeakResponder](const FSGMessage& Message,
+	                                     const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                     {
+		                     if (const auto Endpoint = WeakResponder.Pin())
+		                     {
+			                     Endpoint->Send(Topic_Benchmark, TopicBenchmark_Reply, Context->GetSender(),
+			                                    DEFAULT_SEND_PARAMETER, MESSAGE_KEY("Val"),
+			                                    Message.Get<int32>(MESSAGE_KEY("Val")));
+		                     }
+	                     });
+
+	Requester->Subscribe(Topic_Benchmark, TopicBenchmark_Reply,
+	                     [NumReplies](const FSGMessage& Message,
+	                                  const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                     {
+		                     NumReplies->fetch_add(1, std::memory_order_relaxed);
+	                     });
+
+	TArray<double> Samples;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// one extra round trip warms up the subscriptions
+	for (int32 Index = 0; Index <= NumRoundTrips; ++Index)
+	{
+		const uint64 SendCycles = FPlatformTime::Cycles64();
+
+		Requester->Send(Topic_Benchmark, TopicBenchmark_Request, Responder->GetAddress(), DEFAULT_SEND_PARAMETER,
+		                MESSAGE_KEY("Val"), Index);
+
+		if (!SGTestBenchmark::WaitFor(NumReplies, Index + 1, Timeout))
+		{
+			return;
+		}
+
+		if (Index > 0)
+		{
+			Samples.Add(SGTestBenchmark::ToMicroseconds(FPlatformTime::Cycles64() - SendCycles));
+		}
+	}
+
+	AddResult(TEXT("RequestReply"), 0, NumRoundTrips, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles),
+	          Samples);
+}
+
+void ASGTestBenchmark::BenchmarkForwardChain(const int32 NumForwarders)
+{
+	const auto NumReplies = SGTestBenchmark::MakeCounter();
+
+	TArray<TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>> Forwarders;
+
+	for (int32 Index = 0; Index < NumForwarders; ++Index)
+	{
+		Forwarders.Add(BuildEndpoint(*FString::Printf(TEXT("BenchmarkForwarder%d"), Index)));
+	}
+
+	const auto Responder = BuildEndpoint(TEXT("BenchmarkResponder"));
+
+	const auto Requester = BuildEndpoint(TEXT("BenchmarkRequester"));
+
+	if (!Responder.IsValid() || !Requester.IsValid() || Forwarders.Contains(nullptr))
+	{
+		return;
+	}
+
+	for (int32 Index = 0; Index < NumForwarders; ++Index)
+	{
+		TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> WeakForwarder = Forwarders[Index];
+
+		const FSGMessageAddress NextAddress = Index + 1 < NumForwarders
+			                                      ? Forwarders[Index + 1]->GetAddress()
+			                                      : Responder->GetAddress();
+
+		Forwarders[Index]->Subscribe(Topic_Benchmark, TopicBenchmark_Request,
+		                             [WeakForwarder, NextAddress](const FSGMessage& Message,
+		                                                          const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>&
+		                                                          Context)
+		                             {
+			                             if (const auto Endpoint = WeakForwarder.Pin())
+			                             {
+				                             Endpoint->Forward(Context, NextAddress);
+			                             }
+		                             });
+	}
+
+	TWeakPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> WeakResponder = Responder;
+
+	Responder->Subscribe(Topic_Benchmark, TopicBenchmark_Request,
+	                     [WeakResponder](const FSGMessage& Message,
+	                                     const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                     {
+		                     if (const auto Endpoint = WeakResponder.Pin())
+		                     {
+			                     // forwarded contexts name the last forwarder as their sender
+			                     const auto RootContext = Context->GetRootContext();
+
+			                     Endpoint->Send(Topic_Benchmark, TopicBenchmark_Reply,
+			                                    RootContext.IsValid() ? RootContext->GetSender() : Context->GetSender(),
+			                                    DEFAULT_SEND_PARAMETER, MESSAGE_KEY("Val"),
+			                                    Message.Get<int32>(MESSAGE_KEY("Val")));
+		                     }
+	                     });
+
+	Requester->Subscribe(Topic_Benchmark, TopicBenchmark_Reply,
+	                     [NumReplies](const FSGMessage& Message,
+	                                  const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                     {
+		                     NumReplies->fetch_add(1, std::memory_order_relaxed);
+	                     });
+
+	TArray<double> Samples;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index <= NumRoundTrips; ++Index)
+	{
+		const uint64 SendCycles = FPlatformTime::Cycles64();
+
+		Requester->Send(Topic_Benchmark, TopicBenchmark_Request, Forwarders[0]->GetAddress(), DEFAULT_SEND_PARAMETER,
+		                MESSAGE_KEY("Val"), Index);
+
+		if (!SGTestBenchmark::WaitFor(NumReplies, Index + 1, Timeout))
+		{
+			return;
+		}
+
+		if (Index > 0)
+		{
+			Samples.Add(SGTestBenchmark::ToMicroseconds(FPlatformTime::Cycles64() - SendCycles));
+		}
+	}
+
+	AddResult(TEXT("ForwardChain"), NumForwarders, NumRoundTrips,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+}
+
+void ASGTestBenchmark::BenchmarkDelay()
+{
+	constexpr int32 NumDelayed = 100;
+
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	const auto Lateness = MakeShared<SGTestBenchmark::FSamples, ESPMode::ThreadSafe>();
+
+	const auto Subscriber = BuildEndpoint(TEXT("BenchmarkSubscriber"));
+
+	const auto Publisher = BuildEndpoint(TEXT("BenchmarkPublisher"));
+
+	if (!Subscriber.IsValid() || !Publisher.IsValid())
+	{
+		return;
+	}
+
+	Subscriber->Subscribe(Topic_Benchmark, TopicBenchmark_Delay,
+	                      [NumReceived, Lateness](const FSGMessage& Message,
+	                                              const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                      {
+		                      const int64 DueCycles = Message.Get<int64>(MESSAGE_KEY("DueCycles"));
+		                      {
+			                      FScopeLock Lock(&Lateness->CriticalSection);
+
+			                      Lateness->Samples.Add(
+				                      SGTestBenchmark::ToMicroseconds((int64)FPlatformTime::Cycles64() - DueCycles));
+		                      }
+
+		                      NumReceived->fetch_add(1, std::memory_order_relaxed);
+	                      });
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// delays from 10 to 100 milliseconds, so that the messages land in different timer slots
+	for (int32 Index = 0; Index < NumDelayed; ++Index)
+	{
+		const FTimespan Delay = FTimespan::FromMilliseconds(10.0 * (1 + Index % 10));
+
+		const int64 DueCycles = (int64)FPlatformTime::Cycles64() +
+			(int64)(Delay.GetTotalSeconds() / FPlatformTime::GetSecondsPerCycle64());
+
+		Publisher->Publish(Topic_Benchmark, TopicBenchmark_Delay, DELAY_PUBLISH_PARAMETER(Delay),
+		                   MESSAGE_KEY("DueCycles"), DueCycles);
+	}
+
+	if (!SGTestBenchmark::WaitFor(NumReceived, NumDelayed, Timeout))
+	{
+		return;
+	}
+
+	TArray<double> Samples;
+	{
+		FScopeLock Lock(&Lateness->CriticalSection);
+
+		Samples = MoveTemp(Lateness->Samples);
+	}
+
+	AddResult(TEXT("DelayLateness"), 0, NumDelayed, FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles),
+	          Samples);
+}
+
+void ASGTestBenchmark::BenchmarkBlueprintParameter()
+{
+	FSGTestBenchmarkPayload Payload;
+
+	const FName Key(TEXT("Val"));
+
+	FProperty* Property = FSGTestBenchmarkPayload::StaticStruct()->FindPropertyByName(
+		GET_MEMBER_NAME_CHECKED(FSGTestBenchmarkPayload, Val));
+
+	if (Property == nullptr)
+	{
+		return;
+	}
+
+	const FSGBlueprintMessage Message = USGMessageFunctionLibrary::BuildBlueprintMessage();
+
+	TArray<double> Samples;
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Payload.Val = Index;
+
+		USGMessageFunctionLibrary::ExecSet(Message, Key, Property, &Payload.Val);
+	}
+
+	AddResult(TEXT("BlueprintExecSet"), 0, NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+
+	StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		USGMessageFunctionLibrary::ExecGet(Message, Key, Property, &Payload.Val);
+	}
+
+	AddResult(TEXT("BlueprintExecGet"), 0, NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+}
+
+void ASGTestBenchmark::BenchmarkContainerCopy(const int32 NumElements)
+{
+	FSGTestBenchmarkContainers Source;
+
+	for (int32 Index = 0; Index < NumElements; ++Index)
+	{
+		Source.Array.Add(Index);
+
+		Source.Map.Add(Index, Index * 2);
+
+		Source.Set.Add(Index);
+	}
+
+	const FName ArrayName = GET_MEMBER_NAME_CHECKED(FSGTestBenchmarkContainers, Array);
+
+	const FName MapName = GET_MEMBER_NAME_CHECKED(FSGTestBenchmarkContainers, Map);
+
+	const FName SetName = GET_MEMBER_NAME_CHECKED(FSGTestBenchmarkContainers, Set);
+
+	// each pass copies the whole container into the message and back out into Blueprint memory
+	for (const FName& Name : {ArrayName, MapName, SetName})
+	{
+		FProperty* Property = FSGTestBenchmarkContainers::StaticStruct()->FindPropertyByName(Name);
+
+		if (Property == nullptr)
+		{
+			continue;
+		}
+
+		const FSGBlueprintMessage Message = USGMessageFunctionLibrary::BuildBlueprintMessage();
+
+		FSGTestBenchmarkContainers Destination;
+
+		TArray<double> Samples;
+
+		const uint64 StartCycles = FPlatformTime::Cycles64();
+
+		for (int32 Index = 0; Index < NumRoundTrips; ++Index)
+		{
+			USGMessageFunctionLibrary::ExecSet(Message, Name, Property, Property->ContainerPtrToValuePtr<void>(&Source));
+
+			USGMessageFunctionLibrary::ExecGet(Message, Name, Property,
+			                                   Property->ContainerPtrToValuePtr<void>(&Destination));
+		}
+
+		const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+		const int32 NumCopied = (Name == ArrayName)
+			                        ? Destination.Array.Num()
+			                        : (Name == MapName)
+			                        ? Destination.Map.Num()
+			                        : Destination.Set.Num();
+
+		if (NumCopied != NumElements)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("ASGTestBenchmark ContainerCopy%s: %d of %d elements copied"),
+			       *Name.ToString(), NumCopied, NumElements);
+
+			continue;
+		}
+
+		AddResult(FString::Printf(TEXT("ContainerCopy%s"), *Name.ToString()), NumElements, NumRoundTrips, Seconds,
+		          Samples);
+	}
+}
+
+void ASGTestBenchmark::BenchmarkBridgeLoopback()
+{
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	const auto Capture = MakeShared<SGTestBenchmark::FCapture, ESPMode::ThreadSafe>();
+
+	const auto Subscriber = BuildEndpoint(TEXT("BenchmarkSubscriber"));
+
+	const auto Publisher = BuildEndpoint(TEXT("BenchmarkPublisher"));
+
+	if (!Subscriber.IsValid() || !Publisher.IsValid())
+	{
+		return;
+	}
+
+	Subscriber->Subscribe(Topic_Benchmark, TopicBenchmark_Publish,
+	                      [NumReceived, Capture](const FSGMessage& Message,
+	                                             const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                      {
+		                      {
+			                      FScopeLock Lock(&Capture->CriticalSection);
+
+			                      Capture->Context = Context;
+		                      }
+
+		                      NumReceived->fetch_add(1);
+	                      });
+
+	Publisher->Publish(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER, MESSAGE_KEY("Val"), 0,
+	                   MESSAGE_KEY("Text"), FString(TEXT("Bridge loopback")));
+
+	if (!SGTestBenchmark::WaitFor(NumReceived, 1, Timeout))
+	{
+		return;
+	}
+
+	TSharedPtr<ISGMessageContext, ESPMode::ThreadSafe> Context;
+	{
+		FScopeLock Lock(&Capture->CriticalSection);
+
+		Context = Capture->Context;
+	}
+
+	// encoding and decoding is the work a bridge adds on each side of a transport
+	FSGTransportCodec Codec;
+
+	TArray<uint8> Encoded;
+
+	TArray<double> Samples;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Encoded.Reset();
+
+		if (!Codec.EncodeMessage(*Context, Encoded) || !Codec.DecodeMessage(Encoded).IsValid())
+		{
+			return;
+		}
+	}
+
+	AddResult(TEXT("BridgeLoopback"), Encoded.Num(), NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+}
+
+void ASGTestBenchmark::BenchmarkSerializers()
+{
+	// the same fields go through each serializer, every pass encodes and decodes them all
+	FSGTestBenchmarkRecord Record;
+
+	Record.Id = 42;
+
+	Record.Health = 87.5f;
+
+	Record.Name = TEXT("Benchmark record");
+
+	for (int32 Index = 0; Index < 64; ++Index)
+	{
+		Record.Values.Add(Index * 31);
+	}
+
+	FSGMessage* Message = FSGMessagePool::New<FSGMessage>();
+
+	Message->Set(MESSAGE_KEY("Id"), Record.Id);
+
+	Message->Set(MESSAGE_KEY("Health"), Record.Health);
+
+	Message->Set(MESSAGE_KEY("Name"), Record.Name);
+
+	Message->Set(MESSAGE_KEY("Values"), Record.Values);
+
+	TArray<uint8> Encoded;
+
+	TArray<double> Samples;
+
+	uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Encoded.Reset();
+
+		FSGMessageSerializer::Serialize(*Message, Encoded);
+
+		const FSGMessageReader Reader(Encoded);
+
+		TArray<int32> Values;
+
+		if (!Reader.IsValid() || (Reader.Get<int32>(MESSAGE_KEY("Id")) != Record.Id) ||
+			(Reader.Get<float>(MESSAGE_KEY("Health")) != Record.Health) ||
+			(Reader.Get<FString>(MESSAGE_KEY("Name")) != Record.Name) ||
+			!Reader.Get(MESSAGE_KEY("Values"), Values) || (Values.Num() != Record.Values.Num()))
+		{
+			Message->Release();
+
+			return;
+		}
+	}
+
+	AddResult(TEXT("SerializeWire"), Encoded.Num(), NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+
+	Message->Release();
+
+	UScriptStruct* RecordStruct = FSGTestBenchmarkRecord::StaticStruct();
+
+	StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Encoded.Reset();
+
+		FMemoryWriter Writer(Encoded);
+
+		RecordStruct->SerializeBin(Writer, &Record);
+
+		FSGTestBenchmarkRecord Decoded;
+
+		FMemoryReader Reader(Encoded);
+
+		RecordStruct->SerializeBin(Reader, &Decoded);
+
+		if (Reader.IsError() || (Decoded.Id != Record.Id) || (Decoded.Values.Num() != Record.Values.Num()))
+		{
+			return;
+		}
+	}
+
+	AddResult(TEXT("SerializeStruct"), Encoded.Num(), NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+
+	FString Json;
+
+	StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Json.Reset();
+
+		FSGTestBenchmarkRecord Decoded;
+
+		if (!FJsonObjectConverter::UStructToJsonObjectString(Record, Json) ||
+			!FJsonObjectConverter::JsonObjectStringToUStruct(Json, &Decoded) ||
+			(Decoded.Id != Record.Id) || (Decoded.Values.Num() != Record.Values.Num()))
+		{
+			return;
+		}
+	}
+
+	// the variant is the encoded size, of the UTF-8 text for JSON
+	AddResult(TEXT("SerializeJson"), FTCHARToUTF8(*Json).Length(), NumMessages,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+}
+
+void ASGTestBenchmark::BenchmarkAllocations()
+{
+	constexpr int32 NumAllocationMessages = 100;
+
+	// in frame mode the whole path from publishing to handling runs on this thread, where the allocations are counted
+	const FString BusName(TEXT("SGMessagingBenchmarkAllocations"));
+
+	GetMutableDefault<USGMessagingSettings>()->BusRouterModes.Add(BusName, ESGMessageRouterMode::Frame);
+
+	const auto AllocationBus = ISGMessagingModule::Get().CreateBus(BusName);
+
+	if (!AllocationBus.IsValid() || !AllocationBus->IsFrameMode())
+	{
+		return;
+	}
+
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	const auto Subscriber = FSGMessageEndpointBuilder(TEXT("BenchmarkSubscriber"), AllocationBus.ToSharedRef())
+	                        .ReceivingOnAnyThread().Build();
+
+	const auto Publisher = FSGMessageEndpointBuilder(TEXT("BenchmarkPublisher"), AllocationBus.ToSharedRef())
+	                       .ReceivingOnAnyThread().Build();
+
+	const auto BlueprintPublisher = USGBlueprintMessageEndpoint::Builder(this, TEXT("BenchmarkBlueprintPublisher"),
+	                                                                     AllocationBus.ToSharedRef()).Build();
+
+	if (!Subscriber.IsValid() || !Publisher.IsValid() || BlueprintPublisher == nullptr)
+	{
+		AllocationBus->Shutdown();
+
+		return;
+	}
+
+	Subscriber->Subscribe(Topic_Benchmark, TopicBenchmark_Publish,
+	                      [NumReceived](const FSGMessage& Message,
+	                                    const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+	                      {
+		                      NumReceived->fetch_add(1, std::memory_order_relaxed);
+	                      });
+
+	const auto ProcessFrames = [&AllocationBus, &NumReceived](const int32 Target)
+	{
+		for (int32 Frame = 0; (Frame < 1000) && (NumReceived->load() < Target); ++Frame)
+		{
+			AllocationBus->ProcessFrame();
+		}
+
+		return NumReceived->load() >= Target;
+	};
+
+	const auto Measure = [this, &ProcessFrames, &NumReceived](const FString& Name, TFunctionRef<void(int32)> PublishOne)
+	{
+		// the first message warms up the subscription, the pools and the message keys
+		NumReceived->store(0);
+
+		PublishOne(0);
+
+		if (!ProcessFrames(1))
+		{
+			return;
+		}
+
+		NumReceived->store(0);
+
+		FSGTestAllocationCounter& Counter = FSGTestAllocationCounter::Get();
+
+		Counter.Begin();
+
+		for (int32 Index = 0; Index < NumAllocationMessages; ++Index)
+		{
+			PublishOne(Index);
+		}
+
+		const bool bDelivered = ProcessFrames(NumAllocationMessages);
+
+		Counter.End();
+
+		if (bDelivered)
+		{
+			AddAllocationResult(Name, NumAllocationMessages, Counter.GetNumAllocations(), Counter.GetNumBytes());
+		}
+	};
+
+	Measure(TEXT("AllocationsPublish"), [&Publisher](const int32 Index)
+	{
+		Publisher->Publish(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER, MESSAGE_KEY("Val"),
+		                   Index);
+	});
+
+	Measure(TEXT("AllocationsSend"), [&Publisher, &Subscriber](const int32 Index)
+	{
+		Publisher->Send(Topic_Benchmark, TopicBenchmark_Publish, Subscriber->GetAddress(), DEFAULT_SEND_PARAMETER,
+		                MESSAGE_KEY("Val"), Index);
+	});
+
+	const FSGMessagePrototype Prototype(MESSAGE_KEY("Val"), 0, MESSAGE_KEY("Text"), FString(TEXT("Prototype")));
+
+	Measure(TEXT("AllocationsPrototype"), [&Publisher, &Prototype](const int32 Index)
+	{
+		Publisher->PublishWithMessage(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER,
+		                              Prototype.With(MESSAGE_KEY("Val"), Index));
+	});
+
+	Measure(TEXT("AllocationsSchema"), [&Publisher](const int32 Index)
+	{
+		FSGTestBenchmarkPayload Payload;
+
+		Payload.Val = Index;
+
+		FSGMessage* Message = FSGMessagePool::New<FSGMessage>();
+
+		Message->SetSchema(FSGTestBenchmarkPayload::StaticStruct(), &Payload);
+
+		Publisher->PublishWithMessage(Topic_Benchmark, TopicBenchmark_Publish, DEFAULT_PUBLISH_PARAMETER, Message);
+	});
+
+	FProperty* Property = FSGTestBenchmarkPayload::StaticStruct()->FindPropertyByName(
+		GET_MEMBER_NAME_CHECKED(FSGTestBenchmarkPayload, Val));
+
+	FSGBlueprintPublishParameter BlueprintParameter;
+
+	BlueprintParameter.Scope = ESGBlueprintMessageScope::Network;
+
+	BlueprintParameter.Flags = ESGBlueprintMessageFlags::None;
+
+	BlueprintParameter.Delay = FTimespan::Zero();
+
+	BlueprintParameter.Expiration = FDateTime::MaxValue();
+
+	if (Property != nullptr)
+	{
+		Measure(TEXT("AllocationsBlueprint"), [&BlueprintPublisher, &BlueprintParameter, Property](const int32 Index)
+		{
+			FSGTestBenchmarkPayload Payload;
+
+			Payload.Val = Index;
+
+			BlueprintPublisher->Publish(Topic_Benchmark, TopicBenchmark_Publish, BlueprintParameter,
+			                            USGMessageFunctionLibrary::ExecSet(
+				                            USGMessageFunctionLibrary::BuildBlueprintMessage(), TEXT("Val"),
+				                            Property, &Payload.Val));
+		});
+	}
+
+	// only the send itself is counted: the recipient is passed as a view and stored inline in the context,
+	// so the context is the one allocation per message that the budget allows
+	const FName MessageTag = FSGMessageTagBuilder::Builder(Topic_Benchmark, TopicBenchmark_Publish);
+
+	const FSGMessageAddress Recipient = Subscriber->GetAddress();
+
+	int64 NumSendAllocations = 0;
+
+	int64 NumSendBytes = 0;
+
+	bool bSent = true;
+
+	NumReceived->store(0);
+
+	for (int32 Index = 0; Index <= NumAllocationMessages; ++Index)
+	{
+		// the message comes from the pool, which the first send warms up
+		FSGMessage* Message = FSGMessagePool::New<FSGMessage>();
+
+		FSGTestAllocationCounter& Counter = FSGTestAllocationCounter::Get();
+
+		Counter.Begin();
+
+		Publisher->Send(MessageTag, Message, Recipient, DEFAULT_SEND_PARAMETER);
+
+		Counter.End();
+
+		if (Index > 0)
+		{
+			NumSendAllocations += Counter.GetNumAllocations();
+
+			NumSendBytes += Counter.GetNumBytes();
+		}
+
+		if (!ProcessFrames(Index + 1))
+		{
+			bSent = false;
+
+			break;
+		}
+	}
+
+	if (bSent)
+	{
+		AddAllocationResult(TEXT("AllocationsSendOneRecipient"), NumAllocationMessages, NumSendAllocations, NumSendBytes);
+	}
+
+	AllocationBus->Shutdown();
+}
+
+void ASGTestBenchmark::BenchmarkSubscriptionChurn(const int32 NumChurningEndpoints)
+{
+	constexpr int32 NumChurnTypes = 8;
+
+	constexpr int32 NumChurnRounds = 10;
+
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	const auto Publisher = BuildEndpoint(TEXT("BenchmarkPublisher"));
+
+	const auto Subscriber = BuildEndpoint(TEXT("BenchmarkSubscriber"));
+
+	if (!Publisher.IsValid() || !Subscriber.IsValid())
+	{
+		return;
+	}
+
+	TArray<FName> ChurnTypes;
+
+	for (int32 Index = 0; Index < NumChurnTypes; ++Index)
+	{
+		ChurnTypes.Add(FSGMessageTagBuilder::Builder(Topic_Benchmark, TopicBenchmark_Churn + Index));
+
+		Subscriber->Subscribe(Topic_Benchmark, TopicBenchmark_Churn + Index,
+		                      [NumReceived](const FSGMessage& Message,
+		                                    const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+		                      {
+			                      NumReceived->fetch_add(1, std::memory_order_relaxed);
+		                      });
+	}
+
+	TArray<TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>> ChurningEndpoints;
+
+	for (int32 Index = 0; Index < NumChurningEndpoints; ++Index)
+	{
+		const auto Endpoint = BuildEndpoint(*FString::Printf(TEXT("BenchmarkChurner%d"), Index));
+
+		if (!Endpoint.IsValid())
+		{
+			return;
+		}
+
+		ChurningEndpoints.Add(Endpoint);
+	}
+
+	int32 NumPublished = 0;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	// traffic keeps flowing on the churned types while subscribers come and go
+	for (int32 Round = 0; Round < NumChurnRounds; ++Round)
+	{
+		for (const auto& Endpoint : ChurningEndpoints)
+		{
+			Endpoint->SubscribeMany(ChurnTypes, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+		}
+
+		for (int32 Index = 0; Index < NumChurnTypes; ++Index)
+		{
+			Publisher->Publish(Topic_Benchmark, TopicBenchmark_Churn + Index, DEFAULT_PUBLISH_PARAMETER,
+			                   MESSAGE_KEY("Val"), Round);
+
+			++NumPublished;
+		}
+
+		for (const auto& Endpoint : ChurningEndpoints)
+		{
+			Endpoint->UnsubscribeMany(ChurnTypes);
+		}
+	}
+
+	// routers handle commands in order, so the last messages also mark the end of the churn on every shard
+	if (!SGTestBenchmark::WaitFor(NumReceived, NumPublished, Timeout))
+	{
+		return;
+	}
+
+	TArray<double> Samples;
+
+	AddResult(TEXT("SubscriptionChurn"), NumChurningEndpoints, NumChurnRounds * NumChurningEndpoints * NumChurnTypes * 2,
+	          FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles), Samples);
+}
+
+void ASGTestBenchmark::BenchmarkSubscriptionScan(const int32 NumSubscribers, const ESGMessageScope Scope)
+{
+	// the table is scanned directly, so the numbers are the filtering cost per subscriber without the routers
+	const FName MessageTag = FSGMessageTagBuilder::Builder(Topic_Benchmark, TopicBenchmark_Publish);
+
+	FSGMessageSubscriptionTable Table;
+
+	TArray<TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>> Subscribers;
+
+	for (int32 Index = 0; Index < NumSubscribers; ++Index)
+	{
+		const auto Subscriber = BuildEndpoint(*FString::Printf(TEXT("BenchmarkScanSubscriber%d"), Index));
+
+		if (!Subscriber.IsValid())
+		{
+			return;
+		}
+
+		Table.Add(MakeShared<FSGMessageSubscription, ESPMode::ThreadSafe>(
+			Subscriber.ToSharedRef(), MessageTag, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread)));
+
+		Subscribers.Add(Subscriber);
+	}
+
+	const FSGMessageContext Context(MessageTag, nullptr, FSGMessageAnnotations::GetEmpty(), nullptr, FSGMessageAddress(),
+	                                TArrayView<const FSGMessageAddress>(), Scope, ESGMessageFlags::None,
+	                                FDateTime::UtcNow(), FDateTime::MaxValue(), ENamedThreads::AnyThread);
+
+	int32 NumMatched = 0;
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	for (int32 Index = 0; Index < NumMessages; ++Index)
+	{
+		Table.ForEachMatchingSubscriber(Context, [&NumMatched](const ISGMessageReceiver* Handle,
+		                                                       const TWeakPtr<ISGMessageReceiver, ESPMode::ThreadSafe>& Subscriber)
+		{
+			++NumMatched;
+		});
+	}
+
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	if (NumMatched != NumMessages * NumSubscribers)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("ASGTestBenchmark SubscriptionScan: %d of %d subscribers matched"),
+		       NumMatched, NumMessages * NumSubscribers);
+	}
+
+	// without samples, the mean is the time per scanned subscriber
+	TArray<double> Samples;
+
+	AddResult((Scope == ESGMessageScope::Thread) ? TEXT("SubscriptionScanThread") : TEXT("SubscriptionScan"),
+	          NumSubscribers, NumMessages * NumSubscribers, Seconds, Samples);
+}
+
+void ASGTestBenchmark::BenchmarkTeardown(const int32 NumEndpoints, const int32 NumTypes)
+{
+	// the bus is shut down by the run, so it can't be the shared one
+	const auto TeardownBus = ISGMessagingModule::Get().CreateBus(TEXT("SGMessagingBenchmarkTeardown"));
+
+	if (!TeardownBus.IsValid())
+	{
+		return;
+	}
+
+	const auto NumReceived = SGTestBenchmark::MakeCounter();
+
+	const auto Publisher = FSGMessageEndpointBuilder(TEXT("BenchmarkPublisher"), TeardownBus.ToSharedRef())
+	                       .ReceivingOnAnyThread().Build();
+
+	const auto Probe = FSGMessageEndpointBuilder(TEXT("BenchmarkProbe"), TeardownBus.ToSharedRef())
+	                   .ReceivingOnAnyThread().Build();
+
+	if (!Publisher.IsValid() || !Probe.IsValid())
+	{
+		TeardownBus->Shutdown();
+
+		return;
+	}
+
+	TArray<FName> TeardownTypes;
+
+	for (int32 Index = 0; Index < NumTypes; ++Index)
+	{
+		TeardownTypes.Add(FSGMessageTagBuilder::Builder(Topic_Benchmark, TopicBenchmark_Churn + Index));
+	}
+
+	TArray<TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe>> Endpoints;
+
+	for (int32 Index = 0; Index < NumEndpoints; ++Index)
+	{
+		const auto Endpoint = FSGMessageEndpointBuilder(*FString::Printf(TEXT("BenchmarkTeardown%d"), Index),
+		                                                TeardownBus.ToSharedRef()).ReceivingOnAnyThread().Build();
+
+		if (!Endpoint.IsValid())
+		{
+			TeardownBus->Shutdown();
+
+			return;
+		}
+
+		Endpoint->SubscribeMany(TeardownTypes, FSGMessageScopeRange::AtLeast(ESGMessageScope::Thread));
+
+		Endpoints.Add(Endpoint);
+	}
+
+	// the probe subscribes last, so its messages mark that every shard applied the subscriptions before it
+	for (int32 Index = 0; Index < NumTypes; ++Index)
+	{
+		Probe->Subscribe(Topic_Benchmark, TopicBenchmark_Churn + Index,
+		                 [NumReceived](const FSGMessage& Message,
+		                               const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+		                 {
+			                 NumReceived->fetch_add(1, std::memory_order_relaxed);
+		                 });
+
+		Publisher->Publish(Topic_Benchmark, TopicBenchmark_Churn + Index, DEFAULT_PUBLISH_PARAMETER,
+		                   MESSAGE_KEY("Val"), Index);
+	}
+
+	if (!SGTestBenchmark::WaitFor(NumReceived, NumTypes, Timeout))
+	{
+		TeardownBus->Shutdown();
+
+		return;
+	}
+
+	const uint64 StartCycles = FPlatformTime::Cycles64();
+
+	TeardownBus->Shutdown();
+
+	const double Seconds = FPlatformTime::ToSeconds64(FPlatformTime::Cycles64() - StartCycles);
+
+	// without samples, the mean is the teardown time per subscription
+	TArray<double> Samples;
+
+	AddResult(TEXT("Teardown"), NumEndpoints * NumTypes, NumEndpoints * NumTypes, Seconds, Samples);
+}
+
+void ASGTestBenchmark::AddAllocationResult(const FString& Name, const int32 Count, const int64 NumAllocations,
+                                           const int64 NumBytes)
+{
+	FSGTestBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+
+	Result.Name = Name;
+
+	Result.Count = Count;
+
+	Result.Allocations = (double)NumAllocations / Count;
+
+	Result.Bytes = (double)NumBytes / Count;
+
+	if (const int32* Budget = AllocationBudgets.Find(Name))
+	{
+		Result.bOverBudget = Result.Allocations > *Budget;
+	}
+
+	if (Result.bOverBudget)
+	{
+		bFailed = true;
+
+		UE_LOG(LogTemp, Error, TEXT("ASGTestBenchmark %s: %.2f allocations per message exceed the budget of %d"),
+		       *Result.Name, Result.Allocations, AllocationBudgets[Name]);
+	}
+	else
+	{
+		UE_LOG(LogTemp, Log, TEXT("ASGTestBenchmark %s: %.2f allocations, %.1f bytes per message"),
+		       *Result.Name, Result.Allocations, Result.Bytes);
+	}
+}
+
+void ASGTestBenchmark::CheckAllocationBudgets()
+{
+	// a run that didn't deliver its messages has no result, which must not pass as being within budget
+	for (const TPair<FString, int32>& Budget : AllocationBudgets)
+	{
+		if (!Results.ContainsByPredicate([&Budget](const FSGTestBenchmarkResult& Result) { return Result.Name == Budget.Key; }))
+		{
+			bFailed = true;
+
+			UE_LOG(LogTemp, Error, TEXT("ASGTestBenchmark %s: no result for the budget of %d allocations per message"),
+			       *Budget.Key, Budget.Value);
+		}
+	}
+}
+
+void ASGTestBenchmark::AddResult(const FString& Name, const int32 Variant, const int32 Count, const double Seconds,
+                                 TArray<double>& Samples)
+{
+	FSGTestBenchmarkResult& Result = Results.AddDefaulted_GetRef();
+
+	Result.Name = Name;
+
+	Result.Variant = Variant;
+
+	Result.Count = Count;
+
+	Result.Seconds = Seconds;
+
+	if (Samples.Num() > 0)
+	{
+		Samples.Sort();
+
+		double Sum = 0.0;
+
+		for (const double Sample : Samples)
+		{
+			Sum += Sample;
+		}
+
+		Result.MeanMicroseconds = Sum / Samples.Num();
+
+		Result.P50Microseconds = Samples[Samples.Num() / 2];
+
+		Result.P99Microseconds = Samples[FMath::Min(Samples.Num() - 1, Samples.Num() * 99 / 100)];
+	}
+	else if (Count > 0)
+	{
+		Result.MeanMicroseconds = Seconds * 1000000.0 / Count;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("ASGTestBenchmark %s(%d): %d in %.3fs, mean %.3fus, p50 %.3fus, p99 %.3fus"),
+	       *Result.Name, Result.Variant, Result.Count, Result.Seconds, Result.MeanMicroseconds,
+	       Result.P50Microseconds, Result.P99Microseconds);
+}
+
+void ASGTestBenchmark::WriteResults() const
+{
+	const FString BaseName = FPaths::ProjectSavedDir() / TEXT("SGMessaging") / FString::Printf(
+		TEXT("Benchmark-%s"), *FDateTime::Now().ToString());
+
+	FString Json = FString::Printf(TEXT("{\n\t\"passed\": %s,\n\t\"results\": [\n"), bFailed ? TEXT("false") : TEXT("true"));
+
+	FString Csv = TEXT("name,variant,count,seconds,mean_us,p50_us,p99_us,allocations,bytes,over_budget\n");
+
+	for (int32 Index = 0; Index < Results.Num(); ++Index)
+	{
+		const FSGTestBenchmarkResult& Result = Results[Index];
+
+		Json += FString::Printf(
+			TEXT("\t\t{\"name\": \"%s\", \"variant\": %d, \"count\": %d, \"seconds\": %f, \"mean_us\": %f, \"p50_us\": %f, \"p99_us\": %f, \"allocations\": %f, \"bytes\": %f, \"over_budget\": %s}%s\n"),
+			*Result.Name, Result.Variant, Result.Count, Result.Seconds, Result.MeanMicroseconds,
+			Result.P50Microseconds, Result.P99Microseconds, Result.Allocations, Result.Bytes,
+			Result.bOverBudget ? TEXT("true") : TEXT("false"), Index + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+
+		Csv += FString::Printf(TEXT("%s,%d,%d,%f,%f,%f,%f,%f,%f,%d\n"), *Result.Name, Result.Variant, Result.Count,
+		                       Result.Seconds, Result.MeanMicroseconds, Result.P50Microseconds,
+		                       Result.P99Microseconds, Result.Allocations, Result.Bytes, Result.bOverBudget ? 1 : 0);
+	}
+
+	Json += TEXT("\t]\n}\n");
+
+	FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+
+	FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+
+	UE_LOG(LogTemp, Log, TEXT("ASGTestBenchmark results written to %s.json/.csv"), *BaseName);
+}
@@ -0,0 +1,167 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Core/Interface/ISGMessageBus.h"
+#include "GameFramework/Actor.h"
+#include "SGTestBenchmark.generated.h"
+
+class FSGMessageEndpoint;
+
+USTRUCT()
+struct FSGTestBenchmarkPayload
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Val = 0;
+};
+
+USTRUCT()
+struct FSGTestBenchmarkRecord
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Id = 0;
+
+	UPROPERTY()
+	float Health = 0.0f;
+
+	UPROPERTY()
+	FString Name;
+
+	UPROPERTY()
+	TArray<int32> Values;
+};
+
+USTRUCT()
+struct FSGTestBenchmarkContainers
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<int32> Array;
+
+	UPROPERTY()
+	TMap<int32, int32> Map;
+
+	UPROPERTY()
+	TSet<int32> Set;
+};
+
+struct FSGTestBenchmarkResult
+{
+	FString Name;
+
+	int32 Variant = 0;
+
+	int32 Count = 0;
+
+	double Seconds = 0.0;
+
+	double MeanMicroseconds = 0.0;
+
+	double P50Microseconds = 0.0;
+
+	double P99Microseconds = 0.0;
+
+	double Allocations = 0.0;
+
+	double Bytes = 0.0;
+
+	bool bOverBudget = false;
+};
+
+/**
+ * Measures the messaging hot paths on a private bus and writes the results to Saved/SGMessaging as JSON and CSV.
+ *
+ * Allocation counts per message are checked against AllocationBudgets, which are checked in to Config/DefaultGame.ini.
+ * A run that exceeds a budget, or that has no result for one, fails: the results are marked as failed, and an unattended
+ * session exits with a non-zero code.
+ */
+UCLASS(Config = Game)
+class SGMESSAGINGDEMO_API ASGTestBenchmark : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASGTestBenchmark();
+
+protected:
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+public:
+	// Called every frame
+	virtual void Tick(float DeltaTime) override;
+
+private:
+	UFUNCTION()
+	void OnDelegateBroadcast();
+
+private:
+	TSharedPtr<FSGMessageEndpoint, ESPMode::ThreadSafe> BuildEndpoint(const FName& Name) const;
+
+	void BenchmarkPublishSubscribe(int32 NumSubscribers);
+
+	void BenchmarkRequestReply();
+
+	void BenchmarkForwardChain(int32 NumForwarders);
+
+	void BenchmarkDelay();
+
+	void BenchmarkBlueprintParameter();
+
+	void BenchmarkContainerCopy(int32 NumElements);
+
+	void BenchmarkBridgeLoopback();
+
+	void BenchmarkSerializers();
+
+	void BenchmarkAllocations();
+
+	void BenchmarkSubscriptionChurn(int32 NumChurningEndpoints);
+
+	void BenchmarkSubscriptionScan(int32 NumSubscribers, ESGMessageScope Scope);
+
+	void BenchmarkTeardown(int32 NumEndpoints, int32 NumTypes);
+
+	void AddAllocationResult(const FString& Name, int32 Count, int64 NumAllocations, int64 NumBytes);
+
+	void CheckAllocationBudgets();
+
+	void AddResult(const FString& Name, int32 Variant, int32 Count, double Seconds, TArray<double>& Samples);
+
+	void WriteResults() const;
+
+private:
+	/** Number of messages per publish/subscribe run. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 NumMessages = 10000;
+
+	/** Number of round trips per request/reply and forward chain run. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	int32 NumRoundTrips = 1000;
+
+	/** Subscriber counts of the publish/subscribe runs. */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	TArray<int32> SubscriberCounts = {1, 4, 16, 64};
+
+	/** Longest time a run waits for its messages (in seconds). */
+	UPROPERTY(EditAnywhere, Category = "Benchmark")
+	float Timeout = 10.0f;
+
+	/** Largest number of allocations per message for each allocation run (by result name, e.g. AllocationsPublish). */
+	UPROPERTY(Config, EditAnywhere, Category = "Benchmark")
+	TMap<FString, int32> AllocationBudgets;
+
+	TSharedPtr<ISGMessageBus, ESPMode::ThreadSafe> Bus;
+
+	TArray<FSGTestBenchmarkResult> Results;
+
+	/** Whether the last run exceeded or missed an allocation budget. */
+	bool bFailed = false;
+};
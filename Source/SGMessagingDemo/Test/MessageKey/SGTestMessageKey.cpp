@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "SGTestMessageKey.h"
+#include "MessagingFramework/Kismet/SGMessageFunctionLibrary.h"
+#include "Subsystems/SubsystemBlueprintLibrary.h"
+#include "Kismet/KismetSystemLibrary.h"
+#include "SGMessagingDemo/Test/SGMessagingType.h"
+#include "SGMessagingDemo/Test/Parameter/SGTestParameterMacro.h"
+#include "SGMessagingDemo/Test/Subsystem/SGMessagingTestSubsystem.h"
+
+// Sets default values
+ASGTestMessageKey::ASGTestMessageKey()
+{
+	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
+	PrimaryActorTick.bCanEverTick = true;
+}
+
+// Called when the game starts or when spawned
+void ASGTestMessageKey::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (const auto MessagingTestSubsystem = Cast<USGMessagingTestSubsystem>(
+		USubsystemBlueprintLibrary::GetGameInstanceSubsystem(GetWorld(), USGMessagingTestSubsystem::StaticClass())))
+	{
+		MessagingTestSubsystem->TestMessageKeyDelegate.AddDynamic(this, &ASGTestMessageKey::OnDelegateBroadcast);
+	}
+
+	if (const auto MessageEndpoint = USGMessageFunctionLibrary::GetDefaultMessageEndpoint(this))
+	{
+		MessageEndpoint->Subscribe(Topic_MessageKey, TopicMessageKey_Publish, this, &ASGTestMessageKey::OnPublish);
+	}
+}
+
+// Called every frame
+void ASGTestMessageKey::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+}
+
+void ASGTestMessageKey::OnDelegateBroadcast()
+{
+	// one parameter is keyed by a cached key and one by a string, each is read back with the other kind
+	if (const auto MessageEndpoint = USGMessageFunctionLibrary::GetDefaultMessageEndpoint(this))
+	{
+		MessageEndpoint->Publish(Topic_MessageKey, TopicMessageKey_Publish, DEFAULT_PUBLISH_PARAMETER,
+		                         MESSAGE_KEY("Val"), FString("MessageKey Publish"),
+		                         "Count", 1);
+	}
+}
+
+void ASGTestMessageKey::OnPublish(const FSGMessage& Message,
+                                  const TSharedRef<ISGMessageContext, ESPMode::ThreadSafe>& Context)
+{
+	UE_LOG(LogTemp, Log, TEXT("ASGTestMessageKey::OnPublish IsDedicatedServer:%s Name:%s => %s"),
+	       *UKismetStringLibrary::Conv_BoolToString(UKismetSystemLibrary::IsDedicatedServer(GetWorld())), *GetName(),
+	       *Message.Get<FString>(MESSAGE_KEY("Val")));
+
+	LOG_VALIDATE_CASE(TEXT("MessageKeyGet"),
+	                  *UKismetStringLibrary::Conv_BoolToString(Message.Get<FString>("Val") == FString("MessageKey Publish")))
+
+	LOG_VALIDATE_CASE(TEXT("MessageKeyStringGet"),
+	                  *UKismetStringLibrary::Conv_BoolToString(Message.Get<int32>(MESSAGE_KEY("Count")) == 1))
+
+	LOG_VALIDATE_CASE(TEXT("MessageKeyEqual"),
+	                  *UKismetStringLibrary::Conv_BoolToString(
+		                  MESSAGE_KEY("Val") == FSGMessageKey(FName(TEXT("Val"))) &&
+		                  GetTypeHash(MESSAGE_KEY("Val")) == GetTypeHash(FSGMessageKey(FName(TEXT("Val"))))))
+
+	// a call site creates its key once, so every pass returns the same key
+	const FSGMessageKey* CachedKeys[2];
+
+	for (int32 Index = 0; Index < 2; ++Index)
+	{
+		CachedKeys[Index] = &MESSAGE_KEY("Val");
+	}
+
+	LOG_VALIDATE_CASE(TEXT("MessageKeyCached"), *UKismetStringLibrary::Conv_BoolToString(CachedKeys[0] == CachedKeys[1]))
+}
@@ -20,7 +20,9 @@ enum ETopicID
 	Topic_BlueprintDelayPublishSubscribe,
 	Topic_BlueprintDelayRequestReply,
 	Topic_BlueprintDelayForwardReply,
-	Topic_Parameter
+	Topic_Parameter,
+	Topic_Benchmark,
+	Topic_MessageKey
 };
 
 UENUM(BlueprintType)
@@ -111,3 +113,19 @@ enum ETopicParameter_MessageID
 	TopicParameter_BP2Cpp_Publish,
 	TopicParameter_BP2BP_Publish,
 };
+
+UENUM(BlueprintType)
+enum ETopicBenchmark_MessageID
+{
+	TopicBenchmark_Publish,
+	TopicBenchmark_Request,
+	TopicBenchmark_Reply,
+	TopicBenchmark_Delay,
+	TopicBenchmark_Churn
+};
+
+UENUM(BlueprintType)
+enum ETopicMessageKey_MessageID
+{
+	TopicMessageKey_Publish
+};
@@ -2,6 +2,9 @@
 
 
 #include "SGMessagingTestSubsystem.h"
+#include "Engine/World.h"
+#include "SGMessagingDemo/Test/Benchmark/SGTestBenchmark.h"
+#include "SGMessagingDemo/Test/MessageKey/SGTestMessageKey.h"
 
 void USGMessagingTestSubsystem::Initialize(FSubsystemCollectionBase& Collection)
 {
@@ -139,3 +142,37 @@ void USGMessagingTestSubsystem::TestBP2BPParameter()
 		TestBP2BPParameterDelegate.Broadcast();
 	}
 }
+
+void USGMessagingTestSubsystem::TestBenchmark()
+{
+	// no level places the benchmark, so it is spawned into the current world, where it binds in BeginPlay
+	if (!TestBenchmarkDelegate.IsBound())
+	{
+		if (UWorld* World = GetWorld())
+		{
+			World->SpawnActor<ASGTestBenchmark>();
+		}
+	}
+
+	if (TestBenchmarkDelegate.IsBound())
+	{
+		TestBenchmarkDelegate.Broadcast();
+	}
+}
+
+void USGMessagingTestSubsystem::TestMessageKey()
+{
+	// no level places the message key case, so it is spawned like the benchmark
+	if (!TestMessageKeyDelegate.IsBound())
+	{
+		if (UWorld* World = GetWorld())
+		{
+			World->SpawnActor<ASGTestMessageKey>();
+		}
+	}
+
+	if (TestMessageKeyDelegate.IsBound())
+	{
+		TestMessageKeyDelegate.Broadcast();
+	}
+}
@@ -39,6 +39,10 @@ DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTestBP2CppParameter);
 
 DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTestBP2BPParameter);
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTestBenchmark);
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE(FTestMessageKey);
+
 /**
  * 
  */
@@ -99,6 +103,12 @@ public:
 	UFUNCTION(BlueprintCallable)
 	void TestBP2BPParameter();
 
+	UFUNCTION(BlueprintCallable)
+	void TestBenchmark();
+
+	UFUNCTION(BlueprintCallable)
+	void TestMessageKey();
+
 public:
 	UPROPERTY(BlueprintAssignable)
 	FTestPublishSubscribe TestPublishSubscribeDelegate;
@@ -148,6 +158,12 @@ public:
 	UPROPERTY(BlueprintAssignable)
 	FTestCpp2CppParameter TestBP2BPParameterDelegate;
 
+	UPROPERTY(BlueprintAssignable)
+	FTestBenchmark TestBenchmarkDelegate;
+
+	UPROPERTY(BlueprintAssignable)
+	FTestMessageKey TestMessageKeyDelegate;
+
 public:
 	UPROPERTY(BlueprintReadOnly)
 	USGTestParameterCase* Case;